@@ -2,7 +2,10 @@
 
     \author Brent Carrara
  */
+#include <sys/system_properties.h>
+
 #include "android/android_cahal.h"
+#include "cahal_probe.h"
 
 /*! \var    g_engine_object
  *  \brief  Global member used to access the OpenSLES APIs. Used to gain access
@@ -15,11 +18,23 @@ SLObjectItf g_engine_object     = NULL;
  */
 SLEngineItf g_engine_interface  = NULL;
 
-/*! \var    NUM_CHANNELS_TO_TEST
-    \brief  The number of channels to test for support is in the range [ 1,
-            NUM_CHANNELS_TO_TEST ]
+/*! \var    g_probe_cache
+ *  \brief  The probe cache shared by every device query. It is loaded from
+ *          g_probe_cache_path, if set, by the first query and kept until
+ *          terminate so that later queries only probe new devices.
+ */
+cahal_probe_cache* g_probe_cache = NULL;
+
+/*! \def    NUM_OPENSLES_SUPPORTED_CHANNEL_COUNTS
+    \brief  The length of the opensles_supported_channel_counts array.
+ */
+#define NUM_OPENSLES_SUPPORTED_CHANNEL_COUNTS       9
+
+/*! \def    OPENSLES_MAXIMUM_NUMBER_OF_CHANNELS
+    \brief  OpenSL ES channel masks are 32 bits wide, so at most 32 channels
+            can be described.
  */
-#define NUM_CHANNELS_TO_TEST                        2
+#define OPENSLES_MAXIMUM_NUMBER_OF_CHANNELS         32
 
 /*! \def    NUM_OPENSLES_SUPPORTED_BITS_PER_SAMPLE
     \brief  The length of the supported_bits_per_sample array.
@@ -53,6 +68,12 @@ SLEngineItf g_engine_interface  = NULL;
  */
 #define DEFAULT_OUTPUT_DEVICE_NAME                  "DefaultOutput"
 
+/*! \def    NUM_PROBE_WORKERS
+ *  \brief  The number of threads testing configurations concurrently. Each
+ *          worker holds at most one OpenSL ES player or recorder at a time.
+ */
+#define NUM_PROBE_WORKERS                           4
+
 /*! \var    opensles_supported_bits_per_sample
  *  \brief  List of possible supported bit depths (bits per sample). These are
  *          defined in the OpenSLES.h file.
@@ -69,6 +90,26 @@ static UINT32 opensles_supported_bits_per_sample  [
   SL_PCMSAMPLEFORMAT_FIXED_32
 };
 
+/*! \var    opensles_supported_channel_counts
+ *  \brief  List of channel counts to test: mono, stereo, the surround
+ *          layouts and the common sizes of microphone arrays. Streams of more
+ *          than two channels require the indexed channel masks of Android M.
+ */
+static UINT32 opensles_supported_channel_counts [
+                                           NUM_OPENSLES_SUPPORTED_CHANNEL_COUNTS
+                                                ] =
+{
+  1,
+  2,
+  4,
+  6,
+  8,
+  12,
+  16,
+  24,
+  32
+};
+
 /*! \var    opensles_supported_sample_rates
  *  \brief  List of possible supported sample rates (samples per second). These
  *          are defined in the OpenSLES.h.
@@ -127,35 +168,89 @@ static CHAR* input_configuration_strings[ 5 ] =
     "MicVoiceCommunication"
 };
 
-/*! \fn     cpc_error_code android_add_format_description  (
-              UINT32                            in_bits_per_sample,
-              UINT32                            in_num_channels,
-              UINT32                            in_sample_rate,
-              UINT32                            in_num_supported_formats,
-              cahal_device_stream*              io_device_stream
+/*! \fn     CPC_BOOL android_probe_output_configuration (
+              UINT32  in_configuration,
+              UINT32  in_num_channels,
+              FLOAT64 in_sample_rate,
+              UINT32  in_bits_per_sample,
+              void*   in_user_data
             )
-    \brief  Adds the supported format to the cahal struct.
-
-    \param  in_bits_per_sample  The bit depth (number of bits per sample) of
-                                the supported format.
-    \param  in_num_channels The number of channels supported.
-    \param  in_sample_rate  The sample rate supported.
-    \param  in_num_supported_formats  The number of supported formats stored in
-                                      io_device_stream when this function is
-                                      called.
-    \param  io_device_stream  The device stream to add the suported format to.
-    \return NO_ERROR if the structures have been configured, an error code
-            otherwise.
+    \brief  cahal_probe_callback that tests an output configuration.
+
+    \param  in_configuration  Unused.
+    \param  in_num_channels The number of channels to test.
+    \param  in_sample_rate  The sample rate (in Hz) to test.
+    \param  in_bits_per_sample  The bit depth to test.
+    \param  in_user_data  Unused.
+    \return True iff the configuration is supported.
  */
-cpc_error_code
-android_add_format_description  (
-    UINT32                            in_bits_per_sample,
-    UINT32                            in_num_channels,
-    UINT32                            in_sample_rate,
-    UINT32                            in_num_supported_formats,
-    cahal_device_stream*              io_device_stream
+static
+CPC_BOOL
+android_probe_output_configuration (
+    UINT32  in_configuration,
+    UINT32  in_num_channels,
+    FLOAT64 in_sample_rate,
+    UINT32  in_bits_per_sample,
+    void*   in_user_data
+                                    );
+
+/*! \fn     CPC_BOOL android_probe_input_configuration (
+              UINT32  in_configuration,
+              UINT32  in_num_channels,
+              FLOAT64 in_sample_rate,
+              UINT32  in_bits_per_sample,
+              void*   in_user_data
+            )
+    \brief  cahal_probe_callback that tests an input configuration.
+
+    \param  in_configuration  The recording preset to test.
+    \param  in_num_channels The number of channels to test.
+    \param  in_sample_rate  The sample rate (in Hz) to test.
+    \param  in_bits_per_sample  The bit depth to test.
+    \param  in_user_data  Unused.
+    \return True iff the configuration is supported.
+ */
+static
+CPC_BOOL
+android_probe_input_configuration (
+    UINT32  in_configuration,
+    UINT32  in_num_channels,
+    FLOAT64 in_sample_rate,
+    UINT32  in_bits_per_sample,
+    void*   in_user_data
                                   );
 
+/*! \fn     cahal_prober* android_create_prober (
+              cahal_probe_callback in_callback
+            )
+    \brief  Creates a prober that tests every combination of channel count,
+            sample rate and bit depth supported by OpenSLES.
+
+    \param  in_callback The callback used to test a configuration.
+    \return The prober or NULL on error.
+ */
+static
+cahal_prober*
+android_create_prober (
+    cahal_probe_callback in_callback
+                      );
+
+/*! \fn     UINT64 android_get_fingerprint (
+              CHAR* in_device_name
+            )
+    \brief  Returns the probe cache fingerprint of a device. The fingerprint
+            covers the handset model and the OS build so that cached formats
+            are discarded after an OS update.
+
+    \param  in_device_name  The name of the device.
+    \return The fingerprint.
+ */
+static
+UINT64
+android_get_fingerprint (
+    CHAR* in_device_name
+                        );
+
 /*! \fn     cpc_error_code android_init_output_device_struct (
               cahal_device**        out_device,
               cahal_device_stream** out_stream
@@ -190,7 +285,22 @@ cahal_terminate( void )
           );
       break;
     case CAHAL_STATE_INITIALIZED:
-      android_terminate();
+      if  (
+          CAHAL_ATOMIC_COMPARE_AND_SWAP  (
+              &g_cahal_state,
+              CAHAL_STATE_INITIALIZED,
+              CAHAL_STATE_TERMINATED
+              )
+          )
+      {
+        //  Queued starts and stops run before the streams are stopped
+        cahal_async_terminate();
+
+        cahal_stop_recording();
+        cahal_stop_playback();
+
+        android_terminate();
+      }
       break;
   }
 }
@@ -207,6 +317,10 @@ android_terminate( void )
 
     cahal_free_device_list();
 
+    cahal_probe_cache_free( g_probe_cache );
+
+    g_probe_cache = NULL;
+
     g_cahal_state = CAHAL_STATE_TERMINATED;
 
     CPC_LOG_STRING( CPC_LOG_LEVEL_INFO, "CAHAL has terminated" );
@@ -223,10 +337,13 @@ android_terminate( void )
 void
 cahal_initialize( void )
 {
+  UINT32 stage = cahal_profile_begin( "cahal_initialize" );
+
   if( CAHAL_STATE_NOT_INITIALIZED == g_cahal_state )
   {
     SLresult result;
     SLEngineOption engine_option;
+    UINT32 step = cahal_profile_begin( "slCreateEngine" );
 
     memset( &engine_option, 0, sizeof( SLEngineOption ) );
 
@@ -242,22 +359,32 @@ cahal_initialize( void )
         NULL
                             );
 
+    cahal_profile_end( step );
+
     if( SL_RESULT_SUCCESS == result )
     {
-      result = ( *g_engine_object )->Realize  (
+      //  Realizing the engine starts OpenSL's threads and is usually the
+      //  bulk of the time taken to initialize.
+      step    = cahal_profile_begin( "SLObjectItf::Realize" );
+      result  = ( *g_engine_object )->Realize  (
           g_engine_object,
           SL_BOOLEAN_FALSE
           );
 
+      cahal_profile_end( step );
+
       if( SL_RESULT_SUCCESS == result )
       {
-        result =
+        step    = cahal_profile_begin( "SLObjectItf::GetInterface" );
+        result  =
             ( *g_engine_object )->GetInterface  (
                 g_engine_object,
                 SL_IID_ENGINE,
                 &g_engine_interface
                                         );
 
+        cahal_profile_end( step );
+
         if( SL_RESULT_SUCCESS != result )
         {
           CPC_ERROR( "Error attempting to initialize interface: %d.", result );
@@ -283,6 +410,8 @@ cahal_initialize( void )
   {
     CPC_LOG_STRING( CPC_LOG_LEVEL_WARN, "CAHAL is already intialized" );
   }
+
+  cahal_profile_end( stage );
 }
 
 cpc_error_code
@@ -700,7 +829,12 @@ android_set_audio_format_struct (
 
   if( NULL != out_audio_format )
   {
-    UINT32 container_size = in_num_channels * in_bits_per_sample;
+    cahal_channel_layout channel_layout;
+
+    //  The container holds a single sample, e.g. 20-bit samples are stored in
+    //  32 bits, regardless of the number of channels
+
+    UINT32 container_size = in_bits_per_sample;
 
     if( 8 >= container_size )
       container_size = 8;
@@ -711,12 +845,42 @@ android_set_audio_format_struct (
     else if( 64 >= container_size )
       container_size = 64;
 
-    UINT32 channel_mask = 0;
+    if  (
+        OPENSLES_MAXIMUM_NUMBER_OF_CHANNELS < in_num_channels
+        || ! cahal_get_default_channel_layout (
+            in_num_channels,
+            &channel_layout
+            )
+        )
+    {
+      CPC_ERROR( "Unsupported number of channels: %d.", in_num_channels );
+
+      return( CPC_ERROR_CODE_API_ERROR );
+    }
+
+    //  Mono and stereo keep the positional masks used by every Android
+    //  version. SL_SPEAKER_* share the bit order of the CAHAL speaker
+    //  positions, so wider speaker layouts are passed unchanged while
+    //  discrete layouts (e.g. mic arrays) use indexed masks.
 
-    for( UINT32 i = 0; i < in_num_channels; i++ )
+    UINT32 channel_mask = ( UINT32 ) channel_layout.channel_mask;
+
+    if( 2 >= in_num_channels )
+    {
+      channel_mask = ( 1 == in_num_channels ) ? 0x1 : 0x3;
+    }
+    else if( CAHAL_CHANNEL_LAYOUT_DISCRETE == channel_layout.layout_type )
     {
-      channel_mask <<= 1;
-      channel_mask |= 0x00000001;
+#ifdef SL_ANDROID_MAKE_INDEXED_CHANNEL_MASK
+      channel_mask = SL_ANDROID_MAKE_INDEXED_CHANNEL_MASK( channel_mask );
+#else
+      CPC_ERROR (
+          "Indexed channel masks are unavailable, cannot use %d channels.",
+          in_num_channels
+          );
+
+      return( CPC_ERROR_CODE_API_ERROR );
+#endif
     }
 
     CPC_LOG (
@@ -807,59 +971,106 @@ android_init_and_test_input_configuration (
 }
 
 cahal_device**
-cahal_get_device_list( void )
+cahal_query_device_list (
+    cahal_device_list_callback  in_callback,
+    void*                       in_user_data
+                         )
 {
-  UINT32 num_devices          = 0;
-  cahal_device** device_list  = NULL;
+  UINT32 num_devices                = 0;
+  cahal_device** device_list        = NULL;
+  cahal_probe_scheduler* scheduler  = NULL;
+  cahal_prober* output_prober       =
+      android_create_prober( &android_probe_output_configuration );
+  cahal_prober* input_prober        =
+      android_create_prober( &android_probe_input_configuration );
+  cahal_device* device              = NULL;
+  UINT32 stage                      = CAHAL_PROFILE_NO_STAGE;
+
+  //  Devices that were probed before, including by an earlier query, are
+  //  served from the cache so that only new devices are probed.
+  if( NULL == g_probe_cache )
+  {
+    stage = cahal_profile_begin( "cahal_probe_cache_load" );
+
+    g_probe_cache =
+        NULL != g_probe_cache_path
+        ? cahal_probe_cache_load( g_probe_cache_path )
+        : cahal_probe_cache_create();
 
-  if( CAHAL_STATE_INITIALIZED == g_cahal_state )
+    cahal_profile_end( stage );
+  }
+
+  stage     = cahal_profile_begin( "android_probe_devices" );
+  scheduler =
+      cahal_probe_scheduler_create  (
+          NUM_PROBE_WORKERS,
+          g_probe_cache,
+          NULL,
+          NULL
+                                    );
+
+  //  The output device is queued first so that it is published first.
+  cpc_error_code result =
+      android_set_output_device( scheduler, output_prober );
+
+  if( CPC_ERROR_CODE_NO_ERROR == result )
   {
-    if( NULL != g_device_list )
-    {
-      CPC_LOG (
-          CPC_LOG_LEVEL_DEBUG,
-          "Returning existing device list: 0x%x.",
-          g_device_list
-          );
+    result = android_set_input_devices( scheduler, input_prober );
 
-      device_list = g_device_list;
-    }
-    else
+    if( CPC_ERROR_CODE_NO_ERROR != result )
     {
-      cpc_error_code result =
-          android_set_input_devices( &device_list, &num_devices );
-
-      if( CPC_ERROR_CODE_NO_ERROR == result )
-      {
-        result = android_set_output_device( &device_list, &num_devices );
+      CPC_ERROR( "Could not generate list of input devices: %d.", result );
+    }
+  }
+  else
+  {
+    CPC_ERROR( "Could not generate list of output devices: %d.", result );
+  }
 
-        if( CPC_ERROR_CODE_NO_ERROR == result )
-        {
-          g_device_list = device_list;
+  cahal_probe_scheduler_finish( scheduler );
 
-          CPC_LOG (
-              CPC_LOG_LEVEL_DEBUG,
-              "Generated device list: 0x%x.",
-              g_device_list
-              );
-        }
-        else
-        {
-          CPC_ERROR( "Could not generate list of output devices: %d.", result );
-        }
-      }
-      else
+  while( NULL != ( device = cahal_probe_scheduler_next( scheduler ) ) )
+  {
+    if  (
+        CPC_ERROR_CODE_NO_ERROR
+        == android_add_device_to_list  (
+            device,
+            &device_list,
+            &num_devices
+            )
+        )
+    {
+      if( NULL != in_callback )
       {
-        CPC_ERROR( "Could not generate list of input devices: %d.", result );
+        in_callback( device, in_user_data );
       }
     }
+    else
+    {
+      cahal_free_device( device );
+    }
   }
-  else
+
+  cahal_probe_scheduler_free( scheduler );
+  cahal_prober_free( input_prober );
+  cahal_prober_free( output_prober );
+
+  cahal_profile_end( stage );
+
+  if  (
+      NULL != g_probe_cache
+      && NULL != g_probe_cache_path
+      && g_probe_cache->modified
+      )
   {
-    CPC_ERROR( "CAHAL has not been initialized: %d.", g_cahal_state );
+    stage = cahal_profile_begin( "cahal_probe_cache_save" );
+
+    cahal_probe_cache_save( g_probe_cache, g_probe_cache_path );
+
+    cahal_profile_end( stage );
   }
 
-  return( g_device_list );
+  return( device_list );
 }
 
 cpc_error_code
@@ -1038,78 +1249,24 @@ android_init_input_device_struct  (
   return( result );
 }
 
-cpc_error_code
-android_add_format_description  (
-    UINT32                            in_bits_per_sample,
-    UINT32                            in_num_channels,
-    UINT32                            in_sample_rate,
-    UINT32                            in_num_supported_formats,
-    cahal_device_stream*              io_device_stream
-                                  )
-{
-  cahal_audio_format_description* description;
-
-  cpc_error_code result =
-      cpc_safe_malloc (
-          ( void** ) &description,
-          sizeof( cahal_audio_format_description )
-                      );
-
-  if( CPC_ERROR_CODE_NO_ERROR == result )
-  {
-    description->bit_depth          = in_bits_per_sample;
-    description->format_id          =
-  android_convert_android_audio_format_id_to_cahal_audio_format_id  (
-          SL_DATAFORMAT_PCM
-          );
-    description->number_of_channels = in_num_channels;
-
-    description->sample_rate_range.minimum_rate =
-        ( in_sample_rate / 1000.0 );
-    description->sample_rate_range.maximum_rate =
-        ( in_sample_rate / 1000.0 );
-
-    result =
-        cpc_safe_realloc  (
-            ( void** ) &( io_device_stream->supported_formats ),
-            in_num_supported_formats
-              * sizeof( cahal_audio_format_description* ),
-            ( in_num_supported_formats + 2 )
-              * sizeof( cahal_audio_format_description* )
-                          );
-
-    if( CPC_ERROR_CODE_NO_ERROR == result )
-    {
-      io_device_stream->supported_formats[ in_num_supported_formats ] =
-          description;
-    }
-    else
-    {
-      cpc_safe_free( ( void** ) &description );
-
-      CPC_ERROR( "Could not realloc supported formats: %d.", result );
-    }
-  }
-  else
-  {
-    CPC_ERROR( "Could not malloc description:%d.", result );
-  }
-
-  return( result );
-}
-
 cpc_error_code
 android_set_output_device (
-    cahal_device*** io_device_list,
-    UINT32*         io_num_devices
+    cahal_probe_scheduler*  io_scheduler,
+    cahal_prober*           in_prober
                           )
 {
   cpc_error_code result = CPC_ERROR_CODE_NO_ERROR;
 
-  UINT32 num_supported_formats  = 0;
   cahal_device* device          = NULL;
   cahal_device_stream* stream   = NULL;
 
+  if( NULL == io_scheduler || NULL == in_prober )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null scheduler or prober." );
+
+    return( CPC_ERROR_CODE_NULL_POINTER );
+  }
+
   result =
       android_init_output_device_struct  (
           &device,
@@ -1118,60 +1275,22 @@ android_set_output_device (
 
   if( CPC_ERROR_CODE_NO_ERROR == result )
   {
-    for (
-          UINT32 num_channels = 0;
-          num_channels < NUM_CHANNELS_TO_TEST;
-          num_channels++
+    if  (
+        ! cahal_probe_scheduler_add (
+            io_scheduler,
+            device,
+            stream,
+            in_prober,
+            0,
+            device->device_name,
+            android_get_fingerprint( device->device_name )
+            )
         )
     {
-      for (
-          UINT32 rate_index = 0;
-          rate_index < NUM_OPENSLES_SUPPORTED_SAMPLE_RATES;
-          rate_index++
-          )
-      {
-        for (
-            UINT32 bits_index = 0;
-            bits_index < NUM_OPENSLES_SUPPORTED_BITS_PER_SAMPLE;
-            bits_index++
-            )
-        {
-          if  (
-            android_init_and_test_output_configuration (
-                num_channels,
-                opensles_supported_sample_rates[ rate_index ],
-                opensles_supported_bits_per_sample[ bits_index ]
-                                                )
-              )
-          {
-            CPC_LOG (
-                CPC_LOG_LEVEL_DEBUG,
-                "Supported nc=%d, sr=%d, bps=%d",
-                num_channels,
-                opensles_supported_sample_rates[ rate_index ],
-                opensles_supported_bits_per_sample[ bits_index ]
-                );
+      CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not queue output device." );
 
-            result =
-                android_add_format_description (
-                    opensles_supported_bits_per_sample[ bits_index ],
-                    num_channels,
-                    opensles_supported_sample_rates[ rate_index ],
-                    num_supported_formats,
-                    stream
-                    );
-
-            if( CPC_ERROR_CODE_NO_ERROR == result )
-            {
-              num_supported_formats++;
-            }
-            else
-            {
-              CPC_ERROR( "Could not initialize description: %d.", result );
-            }
-          }
-        }
-      }
+      cahal_free_device_stream( stream );
+      cahal_free_device( device );
     }
   }
   else
@@ -1179,53 +1298,30 @@ android_set_output_device (
     CPC_ERROR( "Could not malloc device and stream: %d.", result );
   }
 
-  if( 0 < num_supported_formats )
-  {
-    result =
-        cpc_safe_malloc (
-            ( void** ) &( device->device_streams ),
-            2 * sizeof( cahal_device_stream* )
-    );
-
-    if( CPC_ERROR_CODE_NO_ERROR == result )
-    {
-      device->device_streams[ 0 ] = stream;
-
-      android_add_device_to_list  (
-          device,
-          io_device_list,
-          io_num_devices
-          );
-    }
-    else
-    {
-      CPC_ERROR( "Could not malloc device streams: %d.", result );
-    }
-  }
-  else
-  {
-    cpc_safe_free( ( void** ) &stream );
-    cpc_safe_free( ( void** ) &device );
-  }
-
   return( result );
 }
 
 cpc_error_code
 android_set_input_devices (
-    cahal_device*** io_device_list,
-    UINT32*         io_num_devices
+    cahal_probe_scheduler*  io_scheduler,
+    cahal_prober*           in_prober
                           )
 {
   cpc_error_code result = CPC_ERROR_CODE_NO_ERROR;
 
+  if( NULL == io_scheduler || NULL == in_prober )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null scheduler or prober." );
+
+    return( CPC_ERROR_CODE_NULL_POINTER );
+  }
+
   for (
       UINT32 configuration_index = 0;
       configuration_index < NUM_OPENSLES_SUPPORTED_INPUT_CONFIGURATIONS;
       configuration_index++
       )
   {
-    UINT32 num_supported_formats  = 0;
     cahal_device* device          = NULL;
     cahal_device_stream* stream   = NULL;
 
@@ -1238,97 +1334,28 @@ android_set_input_devices (
 
     if( CPC_ERROR_CODE_NO_ERROR == result )
     {
-      for (
-            UINT32 num_channels = 0;
-            num_channels < NUM_CHANNELS_TO_TEST;
-            num_channels++
+      if  (
+          ! cahal_probe_scheduler_add (
+              io_scheduler,
+              device,
+              stream,
+              in_prober,
+              opensles_supported_input_configurations[ configuration_index ],
+              device->device_name,
+              android_get_fingerprint( device->device_name )
+              )
           )
       {
-        for (
-            UINT32 rate_index = 0;
-            rate_index < NUM_OPENSLES_SUPPORTED_SAMPLE_RATES;
-            rate_index++
-            )
-        {
-          for (
-              UINT32 bits_index = 0;
-              bits_index < NUM_OPENSLES_SUPPORTED_BITS_PER_SAMPLE;
-              bits_index++
-              )
-          {
-            if  (
-              android_init_and_test_input_configuration (
-                  num_channels,
-                  opensles_supported_sample_rates[ rate_index ],
-                  opensles_supported_bits_per_sample[ bits_index ],
-                  opensles_supported_input_configurations[ configuration_index ]
-                                                  )
-                )
-            {
-              CPC_LOG (
-                  CPC_LOG_LEVEL_DEBUG,
-                  "Supported nc=%d, sr=%d, bps=%d, c=%d",
-                  num_channels,
-                  opensles_supported_sample_rates[ rate_index ],
-                  opensles_supported_bits_per_sample[ bits_index ],
-                  opensles_supported_input_configurations[ configuration_index ]
-                  );
-
-              result =
-                  android_add_format_description (
-                      opensles_supported_bits_per_sample[ bits_index ],
-                      num_channels,
-                      opensles_supported_sample_rates[ rate_index ],
-                      num_supported_formats,
-                      stream
-                      );
+        CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not queue input device." );
 
-              if( CPC_ERROR_CODE_NO_ERROR == result )
-              {
-                num_supported_formats++;
-              }
-              else
-              {
-                CPC_ERROR( "Could not initialize description: %d.", result );
-              }
-            }
-          }
-        }
+        cahal_free_device_stream( stream );
+        cahal_free_device( device );
       }
     }
     else
     {
       CPC_ERROR( "Could not malloc device and stream: %d.", result );
     }
-
-    if( 0 < num_supported_formats )
-    {
-      result =
-          cpc_safe_malloc (
-              ( void** ) &( device->device_streams ),
-              2 * sizeof( cahal_device_stream* )
-      );
-
-      if( CPC_ERROR_CODE_NO_ERROR == result )
-      {
-        device->device_streams[ 0 ] = stream;
-
-        android_add_device_to_list  (
-            device,
-            io_device_list,
-            io_num_devices
-            );
-      }
-      else
-      {
-        CPC_ERROR( "Could not realloc device list: %d.", result );
-      }
-    }
-    else
-    {
-      cpc_safe_free( ( void** ) &stream );
-      cpc_safe_free( ( void** ) &device );
-    }
   }
 
   return( result );
@@ -1383,3 +1410,142 @@ cahal_sleep (
 
   nanosleep( &sleep_info, NULL );
 }
+
+UINT64
+cahal_get_time( void )
+{
+  struct timespec time_info;
+
+  memset( &time_info, 0x0, sizeof( struct timespec ) );
+
+  clock_gettime( CLOCK_MONOTONIC, &time_info );
+
+  return  (
+           ( UINT64 ) time_info.tv_sec * 1000000000ULL
+           + ( UINT64 ) time_info.tv_nsec
+           );
+}
+
+static
+CPC_BOOL
+android_probe_output_configuration (
+    UINT32  in_configuration,
+    UINT32  in_num_channels,
+    FLOAT64 in_sample_rate,
+    UINT32  in_bits_per_sample,
+    void*   in_user_data
+                                    )
+{
+  //  OpenSLES sample rates are in milliHertz.
+  return  (
+      android_init_and_test_output_configuration (
+          in_num_channels,
+          ( UINT32 ) ( in_sample_rate * 1000.0 ),
+          in_bits_per_sample
+          )
+          );
+}
+
+static
+CPC_BOOL
+android_probe_input_configuration (
+    UINT32  in_configuration,
+    UINT32  in_num_channels,
+    FLOAT64 in_sample_rate,
+    UINT32  in_bits_per_sample,
+    void*   in_user_data
+                                  )
+{
+  return  (
+      android_init_and_test_input_configuration (
+          in_num_channels,
+          ( UINT32 ) ( in_sample_rate * 1000.0 ),
+          in_bits_per_sample,
+          in_configuration
+          )
+          );
+}
+
+static
+cahal_prober*
+android_create_prober (
+    cahal_probe_callback in_callback
+                      )
+{
+  cahal_prober* prober =
+      cahal_prober_create (
+          in_callback,
+          NULL,
+  android_convert_android_audio_format_id_to_cahal_audio_format_id  (
+          SL_DATAFORMAT_PCM
+          )
+          );
+
+  if( NULL != prober )
+  {
+    for (
+          UINT32 channels_index = 0;
+          channels_index < NUM_OPENSLES_SUPPORTED_CHANNEL_COUNTS;
+          channels_index++
+        )
+    {
+      cahal_prober_add_channels (
+          prober,
+          opensles_supported_channel_counts[ channels_index ]
+          );
+    }
+
+    for (
+        UINT32 rate_index = 0;
+        rate_index < NUM_OPENSLES_SUPPORTED_SAMPLE_RATES;
+        rate_index++
+        )
+    {
+      cahal_prober_add_sample_rate  (
+          prober,
+          opensles_supported_sample_rates[ rate_index ] / 1000.0
+          );
+    }
+
+    for (
+        UINT32 bits_index = 0;
+        bits_index < NUM_OPENSLES_SUPPORTED_BITS_PER_SAMPLE;
+        bits_index++
+        )
+    {
+      cahal_prober_add_bit_depth  (
+          prober,
+          opensles_supported_bits_per_sample[ bits_index ]
+          );
+    }
+  }
+
+  return( prober );
+}
+
+static
+UINT64
+android_get_fingerprint (
+    CHAR* in_device_name
+                        )
+{
+  CHAR model[ PROP_VALUE_MAX ];
+  CHAR build[ PROP_VALUE_MAX ];
+
+  memset( model, 0, sizeof( model ) );
+  memset( build, 0, sizeof( build ) );
+
+  __system_property_get( "ro.product.model", model );
+  __system_property_get( "ro.build.fingerprint", build );
+
+  //  Android devices are presets rather than physical devices, so the name
+  //  doubles as the UID.
+  return  (
+      cahal_probe_cache_fingerprint (
+          in_device_name,
+          in_device_name,
+          model,
+          build
+          )
+          );
+}
@@ -38,6 +38,127 @@ android_free_callback_buffers (
     android_callback_info*  io_callback_info
                               );
 
+/*! \fn     void android_drain_buffer_queue  (
+              SLAndroidSimpleBufferQueueItf in_buffer_interface
+            )
+    \brief  Waits until the buffers enqueued on in_buffer_interface have been
+            played, for at most CAHAL_DRAIN_TIMEOUT. The playback must be
+            stopping, so that no more buffers are enqueued.
+
+    \param  in_buffer_interface The buffer queue of the playback.
+ */
+void
+android_drain_buffer_queue  (
+    SLAndroidSimpleBufferQueueItf in_buffer_interface
+                            );
+
+/*! \fn     CPC_BOOL android_stop_playback (
+              CPC_BOOL in_drain
+            )
+    \brief  Stops the playback, after draining its buffer queue if in_drain is
+            set. Shared by cahal_stop_playback and cahal_drain_playback.
+
+    \param  in_drain  True to play the enqueued buffers before stopping.
+    \return True iff playback has been stopped.
+ */
+CPC_BOOL
+android_stop_playback (
+    CPC_BOOL in_drain
+                      );
+
+/*! \fn     CPC_BOOL android_start_playback  (
+              cahal_device*            in_device,
+              cahal_audio_format_id    in_format_id,
+              UINT32                   in_number_of_channels,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              FLOAT32                  in_volume,
+              cahal_playback_callback  in_playback,
+              void*                    in_callback_user_data,
+              cahal_audio_format_flag  in_format_flags,
+              CPC_BOOL                 in_is_prepared
+            )
+    \brief  Sets up the playback and starts playing, or leaves the player
+            paused if in_is_prepared is set. Shared by cahal_start_playback and
+            cahal_prepare_playback, whose parameters are documented there.
+
+    \param  in_is_prepared  True to leave the player paused.
+    \return True iff the playback was started (or prepared).
+ */
+CPC_BOOL
+android_start_playback  (
+    cahal_device*            in_device,
+    cahal_audio_format_id    in_format_id,
+    UINT32                   in_number_of_channels,
+    FLOAT64                  in_sample_rate,
+    UINT32                   in_bit_depth,
+    FLOAT32                  in_volume,
+    cahal_playback_callback  in_playback,
+    void*                    in_callback_user_data,
+    cahal_audio_format_flag  in_format_flags,
+    CPC_BOOL                 in_is_prepared
+                        );
+
+/*! \fn     CPC_BOOL android_start_recording (
+              cahal_device*            in_device,
+              cahal_audio_format_id    in_format_id,
+              UINT32                   in_number_of_channels,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              cahal_recorder_callback  in_recorder,
+              void*                    in_callback_user_data,
+              cahal_audio_format_flag  in_format_flags,
+              CPC_BOOL                 in_is_prepared
+            )
+    \brief  Sets up the recording and starts recording, or leaves the
+            recorder paused if in_is_prepared is set. Shared by
+            cahal_start_recording and cahal_prepare_recording, whose
+            parameters are documented there.
+
+    \param  in_is_prepared  True to leave the recorder paused.
+    \return True iff the recording was started (or prepared).
+ */
+CPC_BOOL
+android_start_recording (
+    cahal_device*            in_device,
+    cahal_audio_format_id    in_format_id,
+    UINT32                   in_number_of_channels,
+    FLOAT64                  in_sample_rate,
+    UINT32                   in_bit_depth,
+    cahal_recorder_callback  in_recorder,
+    void*                    in_callback_user_data,
+    cahal_audio_format_flag  in_format_flags,
+    CPC_BOOL                 in_is_prepared
+                        );
+
+/*! \fn     CPC_BOOL android_set_play_state  (
+              SLuint32 in_play_state
+            )
+    \brief  Moves the player of the playback to in_play_state, keeping its
+            buffer queue. Used to pause and resume the playback.
+
+    \param  in_play_state SL_PLAYSTATE_PAUSED or SL_PLAYSTATE_PLAYING.
+    \return True iff the player is now in in_play_state.
+ */
+CPC_BOOL
+android_set_play_state  (
+    SLuint32 in_play_state
+                        );
+
+/*! \fn     CPC_BOOL android_set_record_state  (
+              SLuint32 in_record_state
+            )
+    \brief  Moves the recorder of the recording to in_record_state, keeping
+            its buffer queue. Used to pause and resume the recording.
+
+    \param  in_record_state SL_RECORDSTATE_PAUSED or SL_RECORDSTATE_RECORDING.
+    \return True iff the recorder is now in in_record_state.
+ */
+CPC_BOOL
+android_set_record_state  (
+    SLuint32 in_record_state
+                          );
+
 CPC_BOOL
 cahal_start_playback  (
                        cahal_device*            in_device,
@@ -50,6 +171,65 @@ cahal_start_playback  (
                        void*                    in_callback_user_data,
                        cahal_audio_format_flag  in_format_flags
                        )
+{
+  return  (
+      android_start_playback  (
+          in_device,
+          in_format_id,
+          in_number_of_channels,
+          in_sample_rate,
+          in_bit_depth,
+          in_volume,
+          in_playback,
+          in_callback_user_data,
+          in_format_flags,
+          CPC_FALSE
+          )
+      );
+}
+
+CPC_BOOL
+cahal_prepare_playback  (
+                         cahal_device*            in_device,
+                         cahal_audio_format_id    in_format_id,
+                         UINT32                   in_number_of_channels,
+                         FLOAT64                  in_sample_rate,
+                         UINT32                   in_bit_depth,
+                         FLOAT32                  in_volume,
+                         cahal_playback_callback  in_playback,
+                         void*                    in_callback_user_data,
+                         cahal_audio_format_flag  in_format_flags
+                         )
+{
+  return  (
+      android_start_playback  (
+          in_device,
+          in_format_id,
+          in_number_of_channels,
+          in_sample_rate,
+          in_bit_depth,
+          in_volume,
+          in_playback,
+          in_callback_user_data,
+          in_format_flags,
+          CPC_TRUE
+          )
+      );
+}
+
+CPC_BOOL
+android_start_playback  (
+    cahal_device*            in_device,
+    cahal_audio_format_id    in_format_id,
+    UINT32                   in_number_of_channels,
+    FLOAT64                  in_sample_rate,
+    UINT32                   in_bit_depth,
+    FLOAT32                  in_volume,
+    cahal_playback_callback  in_playback,
+    void*                    in_callback_user_data,
+    cahal_audio_format_flag  in_format_flags,
+    CPC_BOOL                 in_is_prepared
+                        )
 {
   CPC_BOOL return_value = CPC_FALSE;
 
@@ -59,13 +239,32 @@ cahal_start_playback  (
   SLObjectItf                   playback_object     = NULL;
   SLPlayItf                     playback_interface  = NULL;
   SLAndroidSimpleBufferQueueItf buffer_interface    = NULL;
+  cahal_channel_layout          channel_layout;
 
   CPC_LOG_STRING( CPC_LOG_LEVEL_TRACE, "In start playback!" );
 
+  if( ! cahal_stream_state_begin_start( &g_cahal_playback_state ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Playback has already started." );
+
+    return( CPC_FALSE );
+  }
+
   if( 0.0 > in_volume || 1.0 < in_volume )
   {
     CPC_ERROR( "Volume (%.02f) must be in the range [ 0, 1 ].", in_volume );
   }
+  else if  (
+       ! cahal_get_stream_channel_layout  (
+                                           in_device,
+                                           CAHAL_DEVICE_OUTPUT_STREAM,
+                                           in_number_of_channels,
+                                           &channel_layout
+                                           )
+       )
+  {
+    CPC_ERROR( "Cannot play back %d channels.", in_number_of_channels );
+  }
   else if  (
        cahal_test_device_direction_support  (
                                              in_device,
@@ -124,6 +323,14 @@ cahal_start_playback  (
           {
             CPC_LOG_STRING( CPC_LOG_LEVEL_TRACE, "Registered callback" );
 
+            g_playback_callback_info->format_id           = in_format_id;
+            g_playback_callback_info->number_of_channels  =
+                in_number_of_channels;
+            g_playback_callback_info->channel_layout      = channel_layout;
+            g_playback_callback_info->sample_rate         = in_sample_rate;
+            g_playback_callback_info->bit_depth           = in_bit_depth;
+            g_playback_callback_info->format_flags        = in_format_flags;
+
             result =
                 android_enqueue_playback_buffers  (
                     audio_format,
@@ -135,10 +342,11 @@ cahal_start_playback  (
             {
               CPC_LOG_STRING( CPC_LOG_LEVEL_TRACE, "Enqueued buffers." );
 
+              //  A paused player is realized and prefetches its buffers
               SLresult opensl_result =
               ( *playback_interface )->SetPlayState (
                   playback_interface,
-                  SL_PLAYSTATE_PLAYING
+                  in_is_prepared ? SL_PLAYSTATE_PAUSED : SL_PLAYSTATE_PLAYING
                   );
 
               if( SL_RESULT_SUCCESS == opensl_result )
@@ -193,6 +401,22 @@ cahal_start_playback  (
     }
   }
 
+  //  A failed start is released by cahal_stop_playback, as before
+  if( in_is_prepared )
+  {
+    cahal_stream_state_end_prepare  (
+        &g_cahal_playback_state,
+        NULL != g_playback_callback_info
+        );
+  }
+  else
+  {
+    cahal_stream_state_end_start  (
+        &g_cahal_playback_state,
+        NULL != g_playback_callback_info
+        );
+  }
+
   return( return_value );
 }
 
@@ -273,14 +497,171 @@ android_free_callback_buffers (
 }
 
 CPC_BOOL
-cahal_stop_recording( void )
+cahal_pause_recording( void )
+{
+  CPC_BOOL result = CPC_FALSE;
+
+  if( cahal_stream_state_begin_pause( &g_cahal_recording_state ) )
+  {
+    result = android_set_record_state( SL_RECORDSTATE_PAUSED );
+
+    cahal_stream_state_end_pause( &g_cahal_recording_state, result );
+  }
+
+  return( result );
+}
+
+CPC_BOOL
+cahal_resume_recording( void )
 {
   CPC_BOOL result = CPC_FALSE;
 
+  if( cahal_stream_state_begin_resume( &g_cahal_recording_state ) )
+  {
+    result = android_set_record_state( SL_RECORDSTATE_RECORDING );
+
+    cahal_stream_state_end_resume( &g_cahal_recording_state, result );
+  }
+
+  return( result );
+}
+
+CPC_BOOL
+cahal_pause_playback( void )
+{
+  CPC_BOOL result = CPC_FALSE;
+
+  if( cahal_stream_state_begin_pause( &g_cahal_playback_state ) )
+  {
+    result = android_set_play_state( SL_PLAYSTATE_PAUSED );
+
+    cahal_stream_state_end_pause( &g_cahal_playback_state, result );
+  }
+
+  return( result );
+}
+
+CPC_BOOL
+cahal_resume_playback( void )
+{
+  CPC_BOOL result = CPC_FALSE;
+
+  if( cahal_stream_state_begin_resume( &g_cahal_playback_state ) )
+  {
+    result = android_set_play_state( SL_PLAYSTATE_PLAYING );
+
+    cahal_stream_state_end_resume( &g_cahal_playback_state, result );
+  }
+
+  return( result );
+}
+
+CPC_BOOL
+cahal_start_aggregate_member  (
+    cahal_aggregate_member* io_member,
+    UINT64                  in_start_time
+                              )
+{
+  //  OpenSL ES exposes a single audio recorder
+  CPC_LOG_STRING  (
+      CPC_LOG_LEVEL_ERROR,
+      "Aggregate recordings are not supported on Android."
+                  );
+
+  return( CPC_FALSE );
+}
+
+void
+cahal_stop_aggregate_member (
+    cahal_aggregate_member* io_member
+                            )
+{
+}
+
+CPC_BOOL
+android_set_play_state  (
+    SLuint32 in_play_state
+                        )
+{
+  CPC_BOOL return_value = CPC_FALSE;
+
+  if  (
+      NULL != g_playback_callback_info
+      && NULL != g_playback_callback_info->platform_data
+      )
+  {
+    android_callback_info* callback_info =
+        ( android_callback_info* ) g_playback_callback_info->platform_data;
+    android_playback_context* context =
+        ( android_playback_context* ) callback_info->context;
+
+    if( NULL != context )
+    {
+      SLresult opensl_result =
+          ( *( context->playback_interface ) )->SetPlayState (
+              context->playback_interface,
+              in_play_state
+              );
+
+      if( SL_RESULT_SUCCESS == opensl_result )
+      {
+        return_value = CPC_TRUE;
+      }
+      else
+      {
+        CPC_ERROR( "Could not set play state: %d.", opensl_result );
+      }
+    }
+  }
+
+  return( return_value );
+}
+
+CPC_BOOL
+android_set_record_state  (
+    SLuint32 in_record_state
+                          )
+{
+  CPC_BOOL return_value = CPC_FALSE;
+
   if  (
-        CAHAL_STATE_INITIALIZED == g_cahal_state
-        && NULL != g_recorder_callback_info
+      NULL != g_recorder_callback_info
+      && NULL != g_recorder_callback_info->platform_data
       )
+  {
+    android_callback_info* callback_info =
+        ( android_callback_info* ) g_recorder_callback_info->platform_data;
+    android_recorder_context* context =
+        ( android_recorder_context* ) callback_info->context;
+
+    if( NULL != context )
+    {
+      SLresult opensl_result =
+          ( *( context->recorder_interface ) )->SetRecordState (
+              context->recorder_interface,
+              in_record_state
+              );
+
+      if( SL_RESULT_SUCCESS == opensl_result )
+      {
+        return_value = CPC_TRUE;
+      }
+      else
+      {
+        CPC_ERROR( "Could not set record state: %d.", opensl_result );
+      }
+    }
+  }
+
+  return( return_value );
+}
+
+CPC_BOOL
+cahal_stop_recording( void )
+{
+  CPC_BOOL result = CPC_FALSE;
+
+  if( cahal_stream_state_begin_stop( &g_cahal_recording_state, NULL ) )
   {
     android_callback_info* callback_info =
         ( android_callback_info* ) g_recorder_callback_info->platform_data;
@@ -364,13 +745,21 @@ cahal_stop_recording( void )
       CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Callback info is null." );
     }
 
+    cahal_stream_state_wait_for_callbacks( &g_cahal_recording_state );
+
+    cahal_detach_recording_dispatcher( g_recorder_callback_info );
+
+    cahal_detach_recording_coalescer( g_recorder_callback_info );
+
     cpc_safe_free( ( void** ) &( g_recorder_callback_info ) );
 
+    cahal_stream_state_end_stop( &g_cahal_recording_state );
+
     result = CPC_TRUE;
   }
   else
   {
-    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Recorder info is null." );
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Recording is not running." );
   }
 
   return( result );
@@ -379,12 +768,57 @@ cahal_stop_recording( void )
 CPC_BOOL
 cahal_stop_playback( void )
 {
-  CPC_BOOL result = CPC_FALSE;
+  return( android_stop_playback( CPC_FALSE ) );
+}
 
-  if  (
-        CAHAL_STATE_INITIALIZED == g_cahal_state
-        && NULL != g_playback_callback_info
+CPC_BOOL
+cahal_drain_playback( void )
+{
+  return( android_stop_playback( CPC_TRUE ) );
+}
+
+void
+android_drain_buffer_queue  (
+    SLAndroidSimpleBufferQueueItf in_buffer_interface
+                            )
+{
+  SLAndroidSimpleBufferQueueState state;
+
+  for (
+      UINT32 waited = 0;
+      waited < CAHAL_DRAIN_TIMEOUT;
+      waited += CAHAL_DRAIN_POLL_INTERVAL
       )
+  {
+    SLresult opensl_result =
+        ( *in_buffer_interface )->GetState( in_buffer_interface, &state );
+
+    if( SL_RESULT_SUCCESS != opensl_result )
+    {
+      CPC_ERROR( "Could not read buffer queue state: %d.", opensl_result );
+
+      break;
+    }
+    else if( 0 == state.count )
+    {
+      CPC_LOG_STRING( CPC_LOG_LEVEL_TRACE, "Drained buffer queue" );
+
+      break;
+    }
+
+    cahal_sleep( CAHAL_DRAIN_POLL_INTERVAL );
+  }
+}
+
+CPC_BOOL
+android_stop_playback (
+    CPC_BOOL in_drain
+                      )
+{
+  CPC_BOOL result = CPC_FALSE;
+  UINT32 state    = CAHAL_STREAM_STATE_IDLE;
+
+  if( cahal_stream_state_begin_stop( &g_cahal_playback_state, &state ) )
   {
     android_callback_info* callback_info =
         ( android_callback_info* ) g_playback_callback_info->platform_data;
@@ -404,6 +838,13 @@ cahal_stop_playback( void )
             context
             );
 
+        //  The playback is stopping, so no buffer is enqueued again. A paused
+        //  player does not play, so it is not drained.
+        if( in_drain && CAHAL_STREAM_STATE_RUNNING == state )
+        {
+          android_drain_buffer_queue( context->buffer_interface );
+        }
+
         SLresult opensl_result =
             ( *( context->playback_interface ) )->SetPlayState (
                 context->playback_interface,
@@ -470,11 +911,19 @@ cahal_stop_playback( void )
       CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Callback info is null." );
     }
 
+    cahal_stream_state_wait_for_callbacks( &g_cahal_playback_state );
+
+    cahal_detach_playback_dispatcher( g_playback_callback_info );
+
+    cahal_detach_playback_schedule( g_playback_callback_info );
+
     cpc_safe_free( ( void** ) &( g_playback_callback_info ) );
+
+    cahal_stream_state_end_stop( &g_cahal_playback_state );
   }
   else
   {
-    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Playback info is null." );
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Playback is not running." );
   }
 
   return( result );
@@ -1154,7 +1603,30 @@ android_enqueue_playback_buffers  (
 
         callback_info->buffer_size = buffer_size;
 
-        for( UINT32 i = 0;i < CAHAL_QUEUE_NUMBER_OF_QUEUES; i++ )
+        if( ! cahal_attach_playback_schedule( out_playback_callback_info ) )
+        {
+          CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not schedule playback." );
+
+          result = CPC_ERROR_CODE_API_ERROR;
+        }
+        else if  (
+              ! cahal_attach_playback_dispatcher  (
+                  out_playback_callback_info,
+                  buffer_size
+                  )
+            )
+        {
+          CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not start dispatcher." );
+
+          result = CPC_ERROR_CODE_API_ERROR;
+        }
+
+        for  (
+              UINT32 i = 0;
+              CPC_ERROR_CODE_NO_ERROR == result
+              && i < CAHAL_QUEUE_NUMBER_OF_QUEUES;
+              i++
+              )
         {
           result = cpc_safe_malloc( ( void** ) &buffer, buffer_size );
 
@@ -1250,7 +1722,35 @@ android_enqueue_record_buffers  (
 
         callback_info->buffer_size = buffer_size;
 
-        for( UINT32 i = 0;i < CAHAL_QUEUE_NUMBER_OF_QUEUES; i++ )
+        if  (
+              ! cahal_attach_recording_coalescer  (
+                  out_recorder_callback_info,
+                  buffer_size
+                  )
+            )
+        {
+          CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not start coalescer." );
+
+          result = CPC_ERROR_CODE_API_ERROR;
+        }
+        else if  (
+              ! cahal_attach_recording_dispatcher  (
+                  out_recorder_callback_info,
+                  buffer_size
+                  )
+            )
+        {
+          CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not start dispatcher." );
+
+          result = CPC_ERROR_CODE_API_ERROR;
+        }
+
+        for  (
+              UINT32 i = 0;
+              CPC_ERROR_CODE_NO_ERROR == result
+              && i < CAHAL_QUEUE_NUMBER_OF_QUEUES;
+              i++
+              )
         {
           result = cpc_safe_malloc( ( void** ) &buffer, buffer_size );
 
@@ -1443,16 +1943,71 @@ android_save_recording_context  (
 }
 
 CPC_BOOL
-cahal_start_recording (
-                       cahal_device*            in_device,
-                       cahal_audio_format_id    in_format_id,
-                       UINT32                   in_number_of_channels,
-                       FLOAT64                  in_sample_rate,
-                       UINT32                   in_bit_depth,
-                       cahal_recorder_callback  in_recorder,
-                       void*                    in_callback_user_data,
-                       cahal_audio_format_flag  in_format_flags
-                       )
+cahal_start_recording  (
+                        cahal_device*            in_device,
+                        cahal_audio_format_id    in_format_id,
+                        UINT32                   in_number_of_channels,
+                        FLOAT64                  in_sample_rate,
+                        UINT32                   in_bit_depth,
+                        cahal_recorder_callback  in_recorder,
+                        void*                    in_callback_user_data,
+                        cahal_audio_format_flag  in_format_flags
+                        )
+{
+  return  (
+      android_start_recording  (
+          in_device,
+          in_format_id,
+          in_number_of_channels,
+          in_sample_rate,
+          in_bit_depth,
+          in_recorder,
+          in_callback_user_data,
+          in_format_flags,
+          CPC_FALSE
+          )
+      );
+}
+
+CPC_BOOL
+cahal_prepare_recording  (
+                          cahal_device*            in_device,
+                          cahal_audio_format_id    in_format_id,
+                          UINT32                   in_number_of_channels,
+                          FLOAT64                  in_sample_rate,
+                          UINT32                   in_bit_depth,
+                          cahal_recorder_callback  in_recorder,
+                          void*                    in_callback_user_data,
+                          cahal_audio_format_flag  in_format_flags
+                          )
+{
+  return  (
+      android_start_recording  (
+          in_device,
+          in_format_id,
+          in_number_of_channels,
+          in_sample_rate,
+          in_bit_depth,
+          in_recorder,
+          in_callback_user_data,
+          in_format_flags,
+          CPC_TRUE
+          )
+      );
+}
+
+CPC_BOOL
+android_start_recording (
+    cahal_device*            in_device,
+    cahal_audio_format_id    in_format_id,
+    UINT32                   in_number_of_channels,
+    FLOAT64                  in_sample_rate,
+    UINT32                   in_bit_depth,
+    cahal_recorder_callback  in_recorder,
+    void*                    in_callback_user_data,
+    cahal_audio_format_flag  in_format_flags,
+    CPC_BOOL                 in_is_prepared
+                        )
 {
   CPC_BOOL return_value = CPC_FALSE;
 
@@ -1462,16 +2017,34 @@ cahal_start_recording (
   SLObjectItf                   recorder_object     = NULL;
   SLRecordItf                   recorder_interface  = NULL;
   SLAndroidSimpleBufferQueueItf buffer_interface    = NULL;
+  cahal_channel_layout          channel_layout;
 
   CPC_LOG_STRING( CPC_LOG_LEVEL_TRACE, "In start recording!" );
 
+  if( ! cahal_stream_state_begin_start( &g_cahal_recording_state ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Recording has already started." );
+
+    return( CPC_FALSE );
+  }
+
   if  (
+       ! cahal_get_stream_channel_layout  (
+                                           in_device,
+                                           CAHAL_DEVICE_INPUT_STREAM,
+                                           in_number_of_channels,
+                                           &channel_layout
+                                           )
+       )
+  {
+    CPC_ERROR( "Cannot record %d channels.", in_number_of_channels );
+  }
+  else if  (
        cahal_test_device_direction_support  (
                                              in_device,
                                              CAHAL_DEVICE_INPUT_STREAM
                                              )
        && CAHAL_STATE_INITIALIZED == g_cahal_state
-       && NULL == g_recorder_callback_info
        )
   {
     if  (
@@ -1523,6 +2096,14 @@ cahal_start_recording (
           {
             CPC_LOG_STRING( CPC_LOG_LEVEL_TRACE, "Registered callback" );
 
+            g_recorder_callback_info->format_id           = in_format_id;
+            g_recorder_callback_info->number_of_channels  =
+                in_number_of_channels;
+            g_recorder_callback_info->channel_layout      = channel_layout;
+            g_recorder_callback_info->sample_rate         = in_sample_rate;
+            g_recorder_callback_info->bit_depth           = in_bit_depth;
+            g_recorder_callback_info->format_flags        = in_format_flags;
+
             result =
                 android_enqueue_record_buffers  (
                     audio_format,
@@ -1535,7 +2116,9 @@ cahal_start_recording (
               SLresult opensl_result =
               ( *recorder_interface )->SetRecordState (
                   recorder_interface,
-                  SL_RECORDSTATE_RECORDING
+                  in_is_prepared
+                  ? SL_RECORDSTATE_PAUSED
+                  : SL_RECORDSTATE_RECORDING
                   );
 
               if( SL_RESULT_SUCCESS == opensl_result )
@@ -1590,6 +2173,22 @@ cahal_start_recording (
     }
   }
 
+  //  A failed start is released by cahal_stop_recording, as before
+  if( in_is_prepared )
+  {
+    cahal_stream_state_end_prepare  (
+        &g_cahal_recording_state,
+        NULL != g_recorder_callback_info
+        );
+  }
+  else
+  {
+    cahal_stream_state_end_start  (
+        &g_cahal_recording_state,
+        NULL != g_recorder_callback_info
+        );
+  }
+
   return( return_value );
 }
 
@@ -1601,7 +2200,13 @@ android_playback_callback (
 {
   CPC_LOG_STRING( CPC_LOG_LEVEL_INFO, "In android playback callback!" );
 
-  if( NULL != in_user_data )
+  if( NULL == in_user_data )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null user data." );
+  }
+  //  OpenSL ES may still deliver a buffer while the playback is stopped, after
+  //  which the callback info is freed.
+  else if( cahal_stream_state_enter_callback( &g_cahal_playback_state ) )
   {
     cahal_playback_info* callback_info    =
         ( cahal_playback_info* ) in_user_data;
@@ -1637,12 +2242,13 @@ android_playback_callback (
                );
 
       if  (
-           callback_info->playback_callback (
-               callback_info->playback_device,
+           cahal_dispatch_playback  (
+               callback_info,
                platform_info->buffers[ platform_info->current_buffer_index ],
                &buffer_size,
-               callback_info->user_data
-                                             )
+               ( platform_info->number_of_buffers - 1 )
+               * platform_info->buffer_size
+                                    )
            )
       {
 
@@ -1692,10 +2298,8 @@ android_playback_callback (
     {
       CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null platform info" );
     }
-  }
-  else
-  {
-    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null user data." );
+
+    cahal_stream_state_leave_callback( &g_cahal_playback_state );
   }
 }
 
@@ -1707,7 +2311,13 @@ android_recorder_callback (
 {
   CPC_LOG_STRING( CPC_LOG_LEVEL_INFO, "In android recorder callback!" );
 
-  if( NULL != in_user_data )
+  if( NULL == in_user_data )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null user data." );
+  }
+  //  OpenSL ES may still deliver a buffer while the recording is stopped, after
+  //  which the callback info is freed.
+  else if( cahal_stream_state_enter_callback( &g_cahal_recording_state ) )
   {
     cahal_recorder_info* callback_info    =
         ( cahal_recorder_info* ) in_user_data;
@@ -1766,12 +2376,11 @@ android_recorder_callback (
                          );
 
         if  (
-             callback_info->recording_callback (
-                 callback_info->recording_device,
+             cahal_dispatch_recording (
+                 callback_info,
                  buffer,
-                 platform_info->buffer_size,
-                 callback_info->user_data
-                                               )
+                 platform_info->buffer_size
+                                      )
              )
         {
           CPC_LOG_STRING( CPC_LOG_LEVEL_TRACE, "Called callback" );
@@ -1823,9 +2432,7 @@ android_recorder_callback (
     {
       CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null platform info" );
     }
-  }
-  else
-  {
-    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null user data." );
+
+    cahal_stream_state_leave_callback( &g_cahal_recording_state );
   }
 }
@@ -0,0 +1,722 @@
+/*! \file   cahal_aggregate.c
+
+    \author Brent Carrara
+ */
+#include "cahal_aggregate.h"
+
+#include "cahal.h"
+#include "cahal_audio_convert.h"
+
+#include <math.h>
+
+/*! \fn     CPC_BOOL cahal_aggregate_member_initialize (
+              cahal_aggregate_recording* io_aggregate,
+              cahal_aggregate_member*    io_member,
+              cahal_device*              in_device,
+              UINT32                     in_number_of_channels,
+              cahal_audio_format_id      in_format_id
+            )
+    \brief  Fills in the recorder info of a member and allocates its
+            resampler.
+
+    \param  io_aggregate  The aggregate the member belongs to, whose format
+                          is set.
+    \param  io_member The member, whose index and first channel are set.
+    \param  in_device The device of the member or NULL.
+    \param  in_number_of_channels The number of channels of the member.
+    \param  in_format_id  The audio format to record in.
+    \return True iff the member was initialized.
+ */
+static
+CPC_BOOL
+cahal_aggregate_member_initialize (
+                               cahal_aggregate_recording* io_aggregate,
+                               cahal_aggregate_member*    io_member,
+                               cahal_device*              in_device,
+                               UINT32                     in_number_of_channels,
+                               cahal_audio_format_id      in_format_id
+                                   );
+
+/*! \fn     CPC_BOOL cahal_aggregate_render  (
+              cahal_aggregate_recording* io_aggregate,
+              UINT32                     in_number_of_frames
+            )
+    \brief  Reads in_number_of_frames frames from every member, steering the
+            resamplers to the master, and hands them to the consolidated
+            callback. Called on the master's thread only.
+
+    \param  io_aggregate  The aggregate.
+    \param  in_number_of_frames The number of frames the master delivered.
+    \return True unless the consolidated callback failed.
+ */
+static
+CPC_BOOL
+cahal_aggregate_render  (
+                         cahal_aggregate_recording* io_aggregate,
+                         UINT32                     in_number_of_frames
+                         );
+
+/*! \fn     void cahal_aggregate_steer (
+              cahal_aggregate_recording* in_aggregate,
+              cahal_aggregate_member*    io_member,
+              UINT32                     in_target_fill
+            )
+    \brief  Steers the resampler of a member to the fill level of the
+            master, counted as if the member had delivered all the frames
+            recorded by the master and scaled by its clock offset. The members
+            then buffer the same duration, so the frames read from them at
+            once were recorded at the same time. Called on the master's
+            thread only.
+
+    \param  in_aggregate  The aggregate.
+    \param  io_member The member to steer.
+    \param  in_target_fill  The fill level of the master.
+ */
+static
+void
+cahal_aggregate_steer (
+                       cahal_aggregate_recording* in_aggregate,
+                       cahal_aggregate_member*    io_member,
+                       UINT32                     in_target_fill
+                       );
+
+/*! \fn     UINT32 cahal_aggregate_get_fill  (
+              cahal_aggregate_member* in_member
+            )
+    \brief  Returns the number of frames buffered in the resampler of a
+            member.
+
+    \param  in_member The member.
+    \return The number of frames.
+ */
+static
+UINT32
+cahal_aggregate_get_fill  (
+                           cahal_aggregate_member* in_member
+                           );
+
+cahal_aggregate_recording*
+cahal_aggregate_recording_create  (
+                              UINT32                   in_number_of_members,
+                              cahal_device**           in_devices,
+                              const UINT32*            in_number_of_channels,
+                              cahal_audio_format_id    in_format_id,
+                              FLOAT64                  in_sample_rate,
+                              UINT32                   in_bit_depth,
+                              cahal_recorder_callback  in_recorder,
+                              void*                    in_callback_user_data,
+                              cahal_audio_format_flag  in_format_flags,
+                              UINT64                   in_start_time
+                                   )
+{
+  cahal_aggregate_recording* aggregate  = NULL;
+  UINT32 maximum_channels               = 0;
+  CPC_BOOL is_initialized               = CPC_TRUE;
+
+  if  (
+       0 == in_number_of_members
+       || NULL == in_number_of_channels
+       || NULL == in_recorder
+       || 0.0 >= in_sample_rate
+       || ! cahal_test_conversion_support( in_bit_depth, in_format_flags )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid aggregate parameters." );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &aggregate,
+                            sizeof( cahal_aggregate_recording )
+                            )
+       || CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &aggregate->members,
+                            sizeof( cahal_aggregate_member )
+                            * in_number_of_members
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not allocate aggregate." );
+
+    cahal_aggregate_recording_free( aggregate );
+
+    return( NULL );
+  }
+
+  aggregate->sample_rate        = in_sample_rate;
+  aggregate->bit_depth          = in_bit_depth;
+  aggregate->format_flags       = in_format_flags;
+  aggregate->start_time         = in_start_time;
+  aggregate->latency            =
+    ( UINT32 ) ( CAHAL_AGGREGATE_LATENCY * in_sample_rate );
+  aggregate->recording_callback = in_recorder;
+  aggregate->user_data          = in_callback_user_data;
+
+  for( UINT32 i = 0; i < in_number_of_members && is_initialized; i++ )
+  {
+    aggregate->members[ i ].index = i;
+
+    is_initialized =
+      cahal_aggregate_member_initialize (
+                           aggregate,
+                           &aggregate->members[ i ],
+                           ( NULL == in_devices ) ? NULL : in_devices[ i ],
+                           in_number_of_channels[ i ],
+                           in_format_id
+                                         );
+
+    if( is_initialized )
+    {
+      aggregate->number_of_members++;
+
+      if( maximum_channels < in_number_of_channels[ i ] )
+      {
+        maximum_channels = in_number_of_channels[ i ];
+      }
+    }
+  }
+
+  if  (
+       ! is_initialized
+       || CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &aggregate->member_frames,
+                            sizeof( FLOAT32 ) * maximum_channels
+                            * CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES
+                            )
+       || CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &aggregate->frames,
+                            sizeof( FLOAT32 ) * aggregate->number_of_channels
+                            * CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES
+                            )
+       || CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &aggregate->data_buffer,
+                            cahal_get_bytes_per_sample( in_bit_depth )
+                            * aggregate->number_of_channels
+                            * CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not create aggregate." );
+
+    cahal_aggregate_recording_free( aggregate );
+
+    return( NULL );
+  }
+
+  CPC_LOG (
+           CPC_LOG_LEVEL_DEBUG,
+           "Created aggregate of %d devices and %d channels starting at %.0f.",
+           aggregate->number_of_members,
+           aggregate->number_of_channels,
+           ( FLOAT64 ) in_start_time
+           );
+
+  return( aggregate );
+}
+
+void
+cahal_aggregate_recording_free  (
+                                 cahal_aggregate_recording* in_aggregate
+                                 )
+{
+  if( NULL == in_aggregate )
+  {
+    return;
+  }
+
+  if( NULL != in_aggregate->members )
+  {
+    for( UINT32 i = 0; i < in_aggregate->number_of_members; i++ )
+    {
+      cahal_drift_resampler_free( in_aggregate->members[ i ].resampler );
+
+      if( NULL != in_aggregate->members[ i ].silence )
+      {
+        cpc_safe_free( ( void** ) &in_aggregate->members[ i ].silence );
+      }
+    }
+
+    cpc_safe_free( ( void** ) &in_aggregate->members );
+  }
+
+  if( NULL != in_aggregate->member_frames )
+  {
+    cpc_safe_free( ( void** ) &in_aggregate->member_frames );
+  }
+
+  if( NULL != in_aggregate->frames )
+  {
+    cpc_safe_free( ( void** ) &in_aggregate->frames );
+  }
+
+  if( NULL != in_aggregate->data_buffer )
+  {
+    cpc_safe_free( ( void** ) &in_aggregate->data_buffer );
+  }
+
+  cpc_safe_free( ( void** ) &in_aggregate );
+}
+
+cahal_aggregate_recording*
+cahal_start_aggregate_recording (
+                              UINT32                   in_number_of_members,
+                              cahal_device**           in_devices,
+                              const UINT32*            in_number_of_channels,
+                              cahal_audio_format_id    in_format_id,
+                              FLOAT64                  in_sample_rate,
+                              UINT32                   in_bit_depth,
+                              cahal_recorder_callback  in_recorder,
+                              void*                    in_callback_user_data,
+                              cahal_audio_format_flag  in_format_flags
+                                 )
+{
+  cahal_aggregate_recording* aggregate  = NULL;
+  UINT64 start_time                     = 0;
+
+  if( NULL == in_devices )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null aggregate devices." );
+
+    return( NULL );
+  }
+
+  start_time =
+    cahal_get_time()
+    + ( UINT64 ) ( CAHAL_AGGREGATE_START_DELAY * 1000000000.0 );
+
+  aggregate =
+    cahal_aggregate_recording_create  (
+                                       in_number_of_members,
+                                       in_devices,
+                                       in_number_of_channels,
+                                       in_format_id,
+                                       in_sample_rate,
+                                       in_bit_depth,
+                                       in_recorder,
+                                       in_callback_user_data,
+                                       in_format_flags,
+                                       start_time
+                                       );
+
+  if( NULL == aggregate )
+  {
+    return( NULL );
+  }
+
+  for( UINT32 i = 0; i < aggregate->number_of_members; i++ )
+  {
+    if  (
+         ! cahal_start_aggregate_member  (
+                                          &aggregate->members[ i ],
+                                          start_time
+                                          )
+         )
+    {
+      CPC_ERROR (
+                 "Could not start member %d of the aggregate.",
+                 i
+                 );
+
+      while( 0 < i )
+      {
+        cahal_stop_aggregate_member( &aggregate->members[ --i ] );
+      }
+
+      cahal_aggregate_recording_free( aggregate );
+
+      return( NULL );
+    }
+  }
+
+  return( aggregate );
+}
+
+void
+cahal_stop_aggregate_recording (
+                                cahal_aggregate_recording* in_aggregate
+                                )
+{
+  if( NULL == in_aggregate )
+  {
+    return;
+  }
+
+  for( UINT32 i = 0; i < in_aggregate->number_of_members; i++ )
+  {
+    cahal_stop_aggregate_member( &in_aggregate->members[ i ] );
+  }
+
+  for( UINT32 i = 1; i < in_aggregate->number_of_members; i++ )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_DEBUG,
+             "Aggregate member %d: %.1f ppm, %d overruns, %d underruns.",
+             i,
+             cahal_aggregate_get_ppm( in_aggregate, i ),
+             cahal_drift_resampler_get_overruns (
+                                       in_aggregate->members[ i ].resampler
+                                                 ),
+             cahal_drift_resampler_get_underruns  (
+                                       in_aggregate->members[ i ].resampler
+                                                  )
+             );
+  }
+
+  cahal_aggregate_recording_free( in_aggregate );
+}
+
+CPC_BOOL
+cahal_aggregate_push  (
+                       cahal_aggregate_member* io_member,
+                       UCHAR*                  in_data_buffer,
+                       UINT32                  in_data_buffer_length,
+                       UINT64                  in_record_time
+                       )
+{
+  cahal_aggregate_recording* aggregate  = NULL;
+  UINT32 number_of_frames               = 0;
+  UINT32 silence                        = 0;
+  FLOAT64 record_time                   = 0;
+  FLOAT64 offset                        = 0;
+  FLOAT64 sample_rate                   = 0;
+  FLOAT64 end_time                      = 0;
+
+  if( NULL == io_member || NULL == in_data_buffer )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null aggregate member or buffer." );
+
+    return( CPC_FALSE );
+  }
+
+  aggregate         = io_member->aggregate;
+  number_of_frames  = in_data_buffer_length / io_member->frame_size;
+  sample_rate       = aggregate->sample_rate;
+  record_time       =
+    ( FLOAT64 ) in_record_time - ( FLOAT64 ) aggregate->start_time;
+
+  //  The position of the buffer in the stream of the member, in frames
+  offset = floor( record_time * sample_rate / 1000000000.0 + 0.5 );
+
+  if( ! io_member->has_started )
+  {
+    if( 0 >= offset + number_of_frames )
+    {
+      return( CPC_TRUE );
+    }
+
+    //  Drop the frames recorded before the start, or pad a late start
+    if( 0 > offset )
+    {
+      in_data_buffer    += ( UINT32 ) -offset * io_member->frame_size;
+      number_of_frames  -= ( UINT32 ) -offset;
+    }
+    else if( 0 < offset )
+    {
+      silence = ( UINT32 ) offset;
+
+      CPC_LOG (
+               CPC_LOG_LEVEL_WARN,
+               "Aggregate member %d started %d frames late.",
+               io_member->index,
+               silence
+               );
+    }
+
+    io_member->has_started        = CPC_TRUE;
+    io_member->first_record_time  = record_time;
+  }
+  else if( CAHAL_AGGREGATE_RATE_INTERVAL * 1000000000.0
+          < record_time - io_member->first_record_time )
+  {
+    //  The rate of the member's clock, measured against the host clock
+    sample_rate =
+      io_member->number_of_recorded_frames * 1000000000.0
+      / ( record_time - io_member->first_record_time );
+  }
+
+  io_member->number_of_recorded_frames +=
+    in_data_buffer_length / io_member->frame_size;
+
+  end_time =
+    record_time / 1000.0
+    + ( in_data_buffer_length / io_member->frame_size ) * 1000000.0
+      / sample_rate;
+
+  for( UINT32 remaining = silence; 0 < remaining; )
+  {
+    UINT32 chunk = remaining;
+
+    if( CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES < chunk )
+    {
+      chunk = CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES;
+    }
+
+    cahal_drift_resampler_write (
+                                 io_member->resampler,
+                                 io_member->silence,
+                                 chunk
+                                 );
+
+    remaining -= chunk;
+  }
+
+  cahal_drift_resampler_recorder_callback (
+                                   io_member->recorder_info.recording_device,
+                                   in_data_buffer,
+                                   number_of_frames * io_member->frame_size,
+                                   io_member->resampler
+                                           );
+
+  CAHAL_ATOMIC_STORE  (
+                       &io_member->end_time,
+                       ( UINT32 ) fmod( end_time, 4294967296.0 )
+                       );
+
+  if( 0 != io_member->index )
+  {
+    return( CPC_TRUE );
+  }
+
+  return( cahal_aggregate_render( aggregate, silence + number_of_frames ) );
+}
+
+FLOAT64
+cahal_aggregate_get_ppm  (
+                          cahal_aggregate_recording* in_aggregate,
+                          UINT32                     in_member
+                          )
+{
+  if( NULL == in_aggregate || in_member >= in_aggregate->number_of_members )
+  {
+    return( 0.0 );
+  }
+
+  return  (
+           cahal_drift_resampler_get_ppm  (
+                                 in_aggregate->members[ in_member ].resampler
+                                           )
+           );
+}
+
+static
+CPC_BOOL
+cahal_aggregate_member_initialize (
+                               cahal_aggregate_recording* io_aggregate,
+                               cahal_aggregate_member*    io_member,
+                               cahal_device*              in_device,
+                               UINT32                     in_number_of_channels,
+                               cahal_audio_format_id      in_format_id
+                                   )
+{
+  cahal_recorder_info* recorder_info = &io_member->recorder_info;
+
+  if  (
+       NULL != in_device
+       && ! cahal_get_stream_channel_layout  (
+                                              in_device,
+                                              CAHAL_DEVICE_INPUT_STREAM,
+                                              in_number_of_channels,
+                                              &recorder_info->channel_layout
+                                              )
+       )
+  {
+    CPC_ERROR( "Cannot record %d channels.", in_number_of_channels );
+
+    return( CPC_FALSE );
+  }
+
+  io_member->aggregate      = io_aggregate;
+  io_member->first_channel  = io_aggregate->number_of_channels;
+  io_member->frame_size     =
+    cahal_get_bytes_per_sample( io_aggregate->bit_depth )
+    * in_number_of_channels;
+
+  recorder_info->recording_device   = in_device;
+  recorder_info->user_data          = io_member;
+  recorder_info->format_id          = in_format_id;
+  recorder_info->number_of_channels = in_number_of_channels;
+  recorder_info->sample_rate        = io_aggregate->sample_rate;
+  recorder_info->bit_depth          = io_aggregate->bit_depth;
+  recorder_info->format_flags       = io_aggregate->format_flags;
+
+  io_member->resampler =
+    cahal_drift_resampler_create  (
+                                   in_number_of_channels,
+                                   io_aggregate->sample_rate,
+                                   CAHAL_AGGREGATE_LATENCY,
+                                   CAHAL_AGGREGATE_MAXIMUM_LATENCY,
+                                   io_aggregate->bit_depth,
+                                   io_aggregate->format_flags,
+                                   io_aggregate->bit_depth,
+                                   io_aggregate->format_flags
+                                   );
+
+  if  (
+       NULL == io_member->resampler
+       || CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &io_member->silence,
+                            sizeof( FLOAT32 ) * in_number_of_channels
+                            * CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not create member." );
+
+    cahal_drift_resampler_free( io_member->resampler );
+
+    io_member->resampler = NULL;
+
+    return( CPC_FALSE );
+  }
+
+  CAHAL_ATOMIC_STORE( &io_member->end_time, 0 );
+
+  io_aggregate->number_of_channels += in_number_of_channels;
+
+  return( CPC_TRUE );
+}
+
+static
+CPC_BOOL
+cahal_aggregate_render  (
+                         cahal_aggregate_recording* io_aggregate,
+                         UINT32                     in_number_of_frames
+                         )
+{
+  cahal_aggregate_member* master  = &io_aggregate->members[ 0 ];
+  UINT32 channels                 = io_aggregate->number_of_channels;
+  CPC_BOOL return_value           = CPC_TRUE;
+
+  if( ! io_aggregate->is_primed )
+  {
+    if( cahal_aggregate_get_fill( master ) < io_aggregate->latency )
+    {
+      return( CPC_TRUE );
+    }
+
+    //  Start reading every member from its first frame at once
+    for( UINT32 i = 0; i < io_aggregate->number_of_members; i++ )
+    {
+      cahal_aggregate_steer( io_aggregate, &io_aggregate->members[ i ], 0 );
+
+      cahal_drift_resampler_read  (
+                                   io_aggregate->members[ i ].resampler,
+                                   io_aggregate->member_frames,
+                                   1
+                                   );
+    }
+
+    io_aggregate->is_primed = CPC_TRUE;
+  }
+
+  while( 0 < in_number_of_frames )
+  {
+    UINT32 chunk  = in_number_of_frames;
+    UINT32 fill   = cahal_aggregate_get_fill( master );
+
+    if( CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES < chunk )
+    {
+      chunk = CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES;
+    }
+
+    for( UINT32 i = 0; i < io_aggregate->number_of_members; i++ )
+    {
+      cahal_aggregate_member* member  = &io_aggregate->members[ i ];
+      UINT32 member_channels          =
+        member->recorder_info.number_of_channels;
+
+      cahal_aggregate_steer( io_aggregate, member, fill );
+
+      cahal_drift_resampler_read  (
+                                   member->resampler,
+                                   io_aggregate->member_frames,
+                                   chunk
+                                   );
+
+      for( UINT32 frame = 0; frame < chunk; frame++ )
+      {
+        memcpy  (
+                 io_aggregate->frames
+                 + frame * channels + member->first_channel,
+                 io_aggregate->member_frames + frame * member_channels,
+                 sizeof( FLOAT32 ) * member_channels
+                 );
+      }
+    }
+
+    cahal_convert_from_float32  (
+                                 io_aggregate->frames,
+                                 chunk * channels,
+                                 io_aggregate->bit_depth,
+                                 io_aggregate->format_flags,
+                                 io_aggregate->data_buffer
+                                 );
+
+    if  (
+         ! io_aggregate->recording_callback (
+                                  master->recorder_info.recording_device,
+                                  io_aggregate->data_buffer,
+                                  chunk * channels
+                                  * cahal_get_bytes_per_sample (
+                                                     io_aggregate->bit_depth
+                                                                ),
+                                  io_aggregate->user_data
+                                             )
+         )
+    {
+      return_value = CPC_FALSE;
+    }
+
+    in_number_of_frames -= chunk;
+  }
+
+  return( return_value );
+}
+
+static
+void
+cahal_aggregate_steer (
+                       cahal_aggregate_recording* in_aggregate,
+                       cahal_aggregate_member*    io_member,
+                       UINT32                     in_target_fill
+                       )
+{
+  UINT32 end_time =
+    CAHAL_ATOMIC_LOAD( &in_aggregate->members[ 0 ].end_time );
+
+  //  The same duration holds more frames of a member that runs faster
+  io_member->resampler->target_fill =
+    ( UINT32 )  (
+                 in_target_fill
+                 * ( 1.0 + cahal_drift_resampler_get_ppm( io_member->resampler )
+                     * 1e-6 )
+                 + 0.5
+                 );
+
+  //  The frames the member has recorded but not delivered yet as of the last
+  //  frame delivered by the master, negative if it is ahead. Counting them
+  //  removes the saw-tooth of its buffer arrivals from its fill level.
+  io_member->resampler->fill_offset =
+    ( INT32 ) ( end_time - CAHAL_ATOMIC_LOAD( &io_member->end_time ) )
+    * in_aggregate->sample_rate / 1000000.0;
+}
+
+static
+UINT32
+cahal_aggregate_get_fill  (
+                           cahal_aggregate_member* in_member
+                           )
+{
+  return  (
+           cahal_ring_buffer_get_fill( in_member->resampler->ring_buffer )
+           / ( sizeof( FLOAT32 ) * in_member->recorder_info.number_of_channels )
+           );
+}
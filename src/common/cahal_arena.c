@@ -0,0 +1,328 @@
+/*! \file   cahal_arena.c
+
+    \author Brent Carrara
+ */
+#include "cahal_arena.h"
+
+/*! \def    CAHAL_ARENA_HEADER_SIZE
+    \brief  The size of a block header rounded up to CAHAL_ARENA_ALIGNMENT.
+ */
+#define CAHAL_ARENA_HEADER_SIZE CAHAL_ARENA_ROUND( sizeof( cahal_arena_block ) )
+
+/*! \def    CAHAL_ARENA_INITIAL_STRINGS
+    \brief  The initial number of slots in the string table.
+ */
+#define CAHAL_ARENA_INITIAL_STRINGS   32
+
+/*! \fn     CPC_BOOL cahal_arena_add_block  (
+              cahal_arena*  io_arena,
+              SIZE          in_size
+            )
+    \brief  Allocates a new block with room for at least in_size bytes, and
+            at least twice the size of the previous block, and makes it the
+            block allocations are made from.
+
+    \param  io_arena  The arena to grow.
+    \param  in_size The number of usable bytes needed.
+    \return True iff the block was allocated.
+ */
+static
+CPC_BOOL
+cahal_arena_add_block  (
+                        cahal_arena*  io_arena,
+                        SIZE          in_size
+                        );
+
+/*! \fn     UINT32 cahal_arena_hash  (
+              const CHAR* in_string
+            )
+    \brief  Returns the 32-bit FNV-1a hash of in_string.
+
+    \param  in_string The string to hash.
+    \return The hash.
+ */
+static
+UINT32
+cahal_arena_hash  (
+                   const CHAR* in_string
+                   );
+
+/*! \fn     CPC_BOOL cahal_arena_grow_strings  (
+              cahal_arena* io_arena
+            )
+    \brief  Doubles the number of slots in the string table of io_arena and
+            rehashes the interned strings.
+
+    \param  io_arena  The arena whose table is grown.
+    \return True iff the table was grown.
+ */
+static
+CPC_BOOL
+cahal_arena_grow_strings  (
+                           cahal_arena* io_arena
+                           );
+
+cahal_arena*
+cahal_arena_create  (
+                     SIZE in_initial_size
+                     )
+{
+  cahal_arena* arena = NULL;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &arena, sizeof( cahal_arena ) )
+       )
+  {
+    CPC_ERROR (
+               "Could not malloc arena: %lu.",
+               ( unsigned long ) sizeof( cahal_arena )
+               );
+  }
+  else if( ! cahal_arena_add_block( arena, in_initial_size ) )
+  {
+    cpc_safe_free( ( void** ) &arena );
+  }
+
+  return( arena );
+}
+
+void*
+cahal_arena_allocate  (
+                       cahal_arena*  io_arena,
+                       SIZE          in_size
+                       )
+{
+  UCHAR* memory = NULL;
+
+  if( NULL == io_arena )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid arena." );
+  }
+  else
+  {
+    SIZE size = CAHAL_ARENA_ROUND( in_size );
+
+    if( 0 == size )
+    {
+      size = CAHAL_ARENA_ALIGNMENT;
+    }
+
+    if  (
+         io_arena->blocks->size - io_arena->blocks->used < size
+         && ! cahal_arena_add_block( io_arena, size )
+         )
+    {
+      CPC_ERROR (
+                 "Could not allocate %lu bytes from arena.",
+                 ( unsigned long ) in_size
+                 );
+    }
+    else
+    {
+      memory  =
+        ( ( UCHAR* ) io_arena->blocks ) + CAHAL_ARENA_HEADER_SIZE
+        + io_arena->blocks->used;
+
+      io_arena->blocks->used  += size;
+      io_arena->bytes_used    += size;
+    }
+  }
+
+  return( memory );
+}
+
+CHAR*
+cahal_arena_intern  (
+                     cahal_arena*  io_arena,
+                     const CHAR*   in_string
+                     )
+{
+  CHAR* interned = NULL;
+
+  if( NULL == io_arena || NULL == in_string )
+  {
+    return( NULL );
+  }
+
+  if  (
+       ( io_arena->number_of_strings + 1 ) * 2 > io_arena->strings_capacity
+       && ! cahal_arena_grow_strings( io_arena )
+       )
+  {
+    return( NULL );
+  }
+
+  UINT32 mask   = io_arena->strings_capacity - 1;
+  UINT32 slot   = cahal_arena_hash( in_string ) & mask;
+
+  while( NULL != io_arena->strings[ slot ] )
+  {
+    if( 0 == strcmp( io_arena->strings[ slot ], in_string ) )
+    {
+      io_arena->number_of_interned++;
+
+      return( io_arena->strings[ slot ] );
+    }
+
+    slot = ( slot + 1 ) & mask;
+  }
+
+  SIZE length = strlen( in_string ) + 1;
+
+  interned = ( CHAR* ) cahal_arena_allocate( io_arena, length );
+
+  if( NULL != interned )
+  {
+    memcpy( interned, in_string, length );
+
+    io_arena->strings[ slot ] = interned;
+
+    io_arena->number_of_strings++;
+    io_arena->number_of_interned++;
+  }
+
+  return( interned );
+}
+
+void
+cahal_arena_free  (
+                   cahal_arena* in_arena
+                   )
+{
+  if( NULL != in_arena )
+  {
+    cahal_arena_block* block = in_arena->blocks;
+
+    while( NULL != block )
+    {
+      cahal_arena_block* next = block->next;
+
+      cpc_safe_free( ( void** ) &block );
+
+      block = next;
+    }
+
+    cpc_safe_free( ( void** ) &( in_arena->strings ) );
+    cpc_safe_free( ( void** ) &in_arena );
+  }
+}
+
+static
+CPC_BOOL
+cahal_arena_add_block  (
+                        cahal_arena*  io_arena,
+                        SIZE          in_size
+                        )
+{
+  cahal_arena_block* block  = NULL;
+  SIZE size                 = in_size;
+
+  //  Grow geometrically so that a badly sized first block costs a
+  //  logarithmic number of blocks.
+  if  (
+       NULL != io_arena->blocks
+       && ( ( SIZE ) -1 ) / 2 >= io_arena->blocks->size
+       && 2 * io_arena->blocks->size > size
+       )
+  {
+    size = 2 * io_arena->blocks->size;
+  }
+
+  if( CAHAL_ARENA_MINIMUM_BLOCK_SIZE > size )
+  {
+    size = CAHAL_ARENA_MINIMUM_BLOCK_SIZE;
+  }
+
+  size = CAHAL_ARENA_ROUND( size );
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &block,
+                            CAHAL_ARENA_HEADER_SIZE + size
+                            )
+       )
+  {
+    CPC_ERROR (
+               "Could not malloc arena block: %lu.",
+               ( unsigned long ) size
+               );
+
+    return( CPC_FALSE );
+  }
+
+  block->next = io_arena->blocks;
+  block->size = size;
+
+  io_arena->blocks = block;
+
+  io_arena->number_of_blocks++;
+
+  return( CPC_TRUE );
+}
+
+static
+UINT32
+cahal_arena_hash  (
+                   const CHAR* in_string
+                   )
+{
+  UINT32 hash = 2166136261U;
+
+  while( 0 != *in_string )
+  {
+    hash ^= ( UCHAR ) *in_string++;
+    hash *= 16777619U;
+  }
+
+  return( hash );
+}
+
+static
+CPC_BOOL
+cahal_arena_grow_strings  (
+                           cahal_arena* io_arena
+                           )
+{
+  CHAR** strings    = NULL;
+  UINT32 capacity   = io_arena->strings_capacity * 2;
+
+  if( 0 == capacity )
+  {
+    capacity = CAHAL_ARENA_INITIAL_STRINGS;
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &strings, sizeof( CHAR* ) * capacity )
+       )
+  {
+    CPC_ERROR( "Could not malloc string table: 0x%x.", capacity );
+
+    return( CPC_FALSE );
+  }
+
+  for( UINT32 i = 0; i < io_arena->strings_capacity; i++ )
+  {
+    if( NULL != io_arena->strings[ i ] )
+    {
+      UINT32 slot =
+        cahal_arena_hash( io_arena->strings[ i ] ) & ( capacity - 1 );
+
+      while( NULL != strings[ slot ] )
+      {
+        slot = ( slot + 1 ) & ( capacity - 1 );
+      }
+
+      strings[ slot ] = io_arena->strings[ i ];
+    }
+  }
+
+  cpc_safe_free( ( void** ) &( io_arena->strings ) );
+
+  io_arena->strings           = strings;
+  io_arena->strings_capacity  = capacity;
+
+  return( CPC_TRUE );
+}
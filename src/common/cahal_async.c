@@ -0,0 +1,743 @@
+/*! \file   cahal_async.c
+
+    \author Brent Carrara
+ */
+#include "cahal_async.h"
+
+/*! \var    cahal_async_start_arguments
+    \brief  Struct definition for the parameters of a queued
+            cahal_start_recording or cahal_start_playback.
+ */
+typedef struct cahal_async_start_arguments_t
+{
+  /*! \var    device
+      \brief  The device to start.
+   */
+  cahal_device*           device;
+
+  /*! \var    format_id
+      \brief  The audio format.
+   */
+  cahal_audio_format_id   format_id;
+
+  /*! \var    number_of_channels
+      \brief  The number of channels.
+   */
+  UINT32                  number_of_channels;
+
+  /*! \var    sample_rate
+      \brief  The sample rate.
+   */
+  FLOAT64                 sample_rate;
+
+  /*! \var    bit_depth
+      \brief  The number of bits per sample.
+   */
+  UINT32                  bit_depth;
+
+  /*! \var    volume
+      \brief  The volume of a playback.
+   */
+  FLOAT32                 volume;
+
+  /*! \var    recorder
+      \brief  The callback of a recording.
+   */
+  cahal_recorder_callback recorder;
+
+  /*! \var    playback
+      \brief  The callback of a playback.
+   */
+  cahal_playback_callback playback;
+
+  /*! \var    user_data
+      \brief  The user data passed to recorder or playback.
+   */
+  void*                   user_data;
+
+  /*! \var    format_flags
+      \brief  The format flags.
+   */
+  cahal_audio_format_flag format_flags;
+
+} cahal_async_start_arguments;
+
+/*! \var    g_cahal_async_once
+    \brief  The state of the creation of the control thread, one of
+            cahal_once_states. CAHAL_ONCE_FAILED once cahal_async_terminate
+            ran before any operation was submitted.
+ */
+static cahal_atomic_uint32 g_cahal_async_once = CAHAL_ONCE_PENDING;
+
+/*! \var    g_cahal_async_lock
+    \brief  Protects g_cahal_async_head, g_cahal_async_tail and
+            g_cahal_async_is_terminated.
+ */
+static cahal_mutex g_cahal_async_lock;
+
+/*! \var    g_cahal_async_ready
+    \brief  Signalled when an operation is queued or the control thread is
+            terminated.
+ */
+static cahal_condition g_cahal_async_ready;
+
+/*! \var    g_cahal_async_head
+    \brief  The next operation to run, or NULL.
+ */
+static cahal_async_operation* g_cahal_async_head = NULL;
+
+/*! \var    g_cahal_async_tail
+    \brief  The last operation queued, or NULL.
+ */
+static cahal_async_operation* g_cahal_async_tail = NULL;
+
+/*! \var    g_cahal_async_is_terminated
+    \brief  True once cahal_async_terminate has been called.
+ */
+static CPC_BOOL g_cahal_async_is_terminated = CPC_FALSE;
+
+/*! \var    g_cahal_async_thread
+    \brief  The control thread.
+ */
+static cahal_thread g_cahal_async_thread;
+
+/*! \fn     CPC_BOOL cahal_async_create_thread (
+              void* io_argument
+            )
+    \brief  The cahal_once_routine creating the queue and the control thread.
+
+    \param  io_argument Ignored.
+    \return True iff the control thread is running.
+ */
+static
+CPC_BOOL
+cahal_async_create_thread (
+                           void* io_argument
+                           );
+
+/*! \fn     void cahal_async_thread_routine (
+              void* in_argument
+            )
+    \brief  The control thread. Runs the queued operations in order until
+            the queue is empty and cahal_async_terminate has been called.
+
+    \param  in_argument Ignored.
+ */
+static
+void
+cahal_async_thread_routine (
+                            void* in_argument
+                            );
+
+/*! \fn     CPC_BOOL cahal_async_start_recording (
+              void* io_arguments
+            )
+    \brief  The routine of cahal_start_recording_async.
+
+    \param  io_arguments  The cahal_async_start_arguments, which are freed.
+    \return The result of cahal_start_recording.
+ */
+static
+CPC_BOOL
+cahal_async_start_recording (
+                             void* io_arguments
+                             );
+
+/*! \fn     CPC_BOOL cahal_async_start_playback  (
+              void* io_arguments
+            )
+    \brief  The routine of cahal_start_playback_async.
+
+    \param  io_arguments  The cahal_async_start_arguments, which are freed.
+    \return The result of cahal_start_playback.
+ */
+static
+CPC_BOOL
+cahal_async_start_playback  (
+                             void* io_arguments
+                             );
+
+/*! \fn     CPC_BOOL cahal_async_stop_recording  (
+              void* io_argument
+            )
+    \brief  The routine of cahal_stop_recording_async.
+
+    \param  io_argument Ignored.
+    \return The result of cahal_stop_recording.
+ */
+static
+CPC_BOOL
+cahal_async_stop_recording  (
+                             void* io_argument
+                             );
+
+/*! \fn     CPC_BOOL cahal_async_stop_playback (
+              void* io_argument
+            )
+    \brief  The routine of cahal_stop_playback_async without draining.
+
+    \param  io_argument Ignored.
+    \return The result of cahal_stop_playback.
+ */
+static
+CPC_BOOL
+cahal_async_stop_playback (
+                           void* io_argument
+                           );
+
+/*! \fn     CPC_BOOL cahal_async_drain_playback  (
+              void* io_argument
+            )
+    \brief  The routine of cahal_stop_playback_async when draining.
+
+    \param  io_argument Ignored.
+    \return The result of cahal_drain_playback.
+ */
+static
+CPC_BOOL
+cahal_async_drain_playback  (
+                             void* io_argument
+                             );
+
+/*! \fn     cahal_async_operation* cahal_async_submit_start (
+              cahal_async_routine           in_routine,
+              cahal_async_start_arguments*  in_arguments,
+              cahal_async_callback          in_completion,
+              void*                         in_completion_user_data
+            )
+    \brief  Queues a start with a copy of in_arguments.
+
+    \param  in_routine  cahal_async_start_recording or
+                        cahal_async_start_playback.
+    \param  in_arguments  The parameters of the start.
+    \param  in_completion Called once the start has completed, or NULL.
+    \param  in_completion_user_data The user data passed to in_completion.
+    \return The handle of the operation or NULL.
+ */
+static
+cahal_async_operation*
+cahal_async_submit_start (
+                          cahal_async_routine           in_routine,
+                          cahal_async_start_arguments*  in_arguments,
+                          cahal_async_callback          in_completion,
+                          void*                         in_completion_user_data
+                          );
+
+cahal_async_operation*
+cahal_async_submit  (
+                     cahal_async_routine   in_routine,
+                     void*                 io_argument,
+                     cahal_async_callback  in_callback,
+                     void*                 in_user_data
+                     )
+{
+  cahal_async_operation* operation  = NULL;
+  CPC_BOOL is_queued                = CPC_FALSE;
+
+  if( NULL == in_routine )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Routine is null." );
+
+    return( NULL );
+  }
+
+  if  (
+       ! cahal_call_once  (
+                           &g_cahal_async_once,
+                           cahal_async_create_thread,
+                           NULL
+                           )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Control thread is not running." );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &operation,
+                            sizeof( cahal_async_operation )
+                            )
+       )
+  {
+    return( NULL );
+  }
+
+  if( ! cahal_mutex_initialize( &( operation->lock ) ) )
+  {
+    cpc_safe_free( ( void** ) &operation );
+
+    return( NULL );
+  }
+
+  if( ! cahal_condition_initialize( &( operation->completed ) ) )
+  {
+    cahal_mutex_destroy( &( operation->lock ) );
+
+    cpc_safe_free( ( void** ) &operation );
+
+    return( NULL );
+  }
+
+  operation->routine    = in_routine;
+  operation->argument   = io_argument;
+  operation->callback   = in_callback;
+  operation->user_data  = in_user_data;
+
+  CAHAL_ATOMIC_STORE( &( operation->references ), 2 );
+
+  cahal_mutex_lock( &g_cahal_async_lock );
+
+  if( ! g_cahal_async_is_terminated )
+  {
+    if( NULL == g_cahal_async_tail )
+    {
+      g_cahal_async_head = operation;
+    }
+    else
+    {
+      g_cahal_async_tail->next = operation;
+    }
+
+    g_cahal_async_tail  = operation;
+    is_queued           = CPC_TRUE;
+
+    cahal_condition_signal( &g_cahal_async_ready );
+  }
+
+  cahal_mutex_unlock( &g_cahal_async_lock );
+
+  if( ! is_queued )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_WARN, "Control thread has terminated." );
+
+    cahal_condition_destroy( &( operation->completed ) );
+    cahal_mutex_destroy( &( operation->lock ) );
+
+    cpc_safe_free( ( void** ) &operation );
+  }
+
+  return( operation );
+}
+
+CPC_BOOL
+cahal_async_is_complete (
+                         cahal_async_operation* in_operation
+                         )
+{
+  CPC_BOOL is_complete = CPC_FALSE;
+
+  if( NULL != in_operation )
+  {
+    cahal_mutex_lock( &( in_operation->lock ) );
+
+    is_complete = in_operation->is_complete;
+
+    cahal_mutex_unlock( &( in_operation->lock ) );
+  }
+
+  return( is_complete );
+}
+
+CPC_BOOL
+cahal_async_wait  (
+                   cahal_async_operation* in_operation
+                   )
+{
+  CPC_BOOL result = CPC_FALSE;
+
+  if( NULL != in_operation )
+  {
+    cahal_mutex_lock( &( in_operation->lock ) );
+
+    while( ! in_operation->is_complete )
+    {
+      cahal_condition_wait  (
+                             &( in_operation->completed ),
+                             &( in_operation->lock )
+                             );
+    }
+
+    result = in_operation->result;
+
+    cahal_mutex_unlock( &( in_operation->lock ) );
+  }
+
+  return( result );
+}
+
+void
+cahal_async_release (
+                     cahal_async_operation* io_operation
+                     )
+{
+  if  (
+       NULL != io_operation
+       && 0 == CAHAL_ATOMIC_ADD( &( io_operation->references ), -1 )
+       )
+  {
+    cahal_condition_destroy( &( io_operation->completed ) );
+    cahal_mutex_destroy( &( io_operation->lock ) );
+
+    cpc_safe_free( ( void** ) &io_operation );
+  }
+}
+
+void
+cahal_async_terminate( void )
+{
+  //  Refuse operations for good if the control thread was never created,
+  //  otherwise wait for it to be created
+  if  (
+       ! CAHAL_ATOMIC_COMPARE_AND_SWAP  (
+                                         &g_cahal_async_once,
+                                         CAHAL_ONCE_PENDING,
+                                         CAHAL_ONCE_FAILED
+                                         )
+       && cahal_call_once  (
+                            &g_cahal_async_once,
+                            cahal_async_create_thread,
+                            NULL
+                            )
+       )
+  {
+    CPC_BOOL is_terminated = CPC_FALSE;
+
+    cahal_mutex_lock( &g_cahal_async_lock );
+
+    is_terminated               = g_cahal_async_is_terminated;
+    g_cahal_async_is_terminated = CPC_TRUE;
+
+    cahal_condition_signal( &g_cahal_async_ready );
+
+    cahal_mutex_unlock( &g_cahal_async_lock );
+
+    if( ! is_terminated )
+    {
+      cahal_thread_join( &g_cahal_async_thread );
+    }
+  }
+}
+
+cahal_async_operation*
+cahal_start_recording_async (
+                             cahal_device*            in_device,
+                             cahal_audio_format_id    in_format_id,
+                             UINT32                   in_number_of_channels,
+                             FLOAT64                  in_sample_rate,
+                             UINT32                   in_bit_depth,
+                             cahal_recorder_callback  in_recorder,
+                             void*                    in_callback_user_data,
+                             cahal_audio_format_flag  in_format_flags,
+                             cahal_async_callback     in_completion,
+                             void*                    in_completion_user_data
+                             )
+{
+  cahal_async_start_arguments arguments;
+
+  memset( &arguments, 0, sizeof( cahal_async_start_arguments ) );
+
+  arguments.device              = in_device;
+  arguments.format_id           = in_format_id;
+  arguments.number_of_channels  = in_number_of_channels;
+  arguments.sample_rate         = in_sample_rate;
+  arguments.bit_depth           = in_bit_depth;
+  arguments.recorder            = in_recorder;
+  arguments.user_data           = in_callback_user_data;
+  arguments.format_flags        = in_format_flags;
+
+  return  (
+           cahal_async_submit_start (
+                                     cahal_async_start_recording,
+                                     &arguments,
+                                     in_completion,
+                                     in_completion_user_data
+                                     )
+           );
+}
+
+cahal_async_operation*
+cahal_start_playback_async  (
+                             cahal_device*            in_device,
+                             cahal_audio_format_id    in_format_id,
+                             UINT32                   in_number_of_channels,
+                             FLOAT64                  in_sample_rate,
+                             UINT32                   in_bit_depth,
+                             FLOAT32                  in_volume,
+                             cahal_playback_callback  in_playback,
+                             void*                    in_callback_user_data,
+                             cahal_audio_format_flag  in_format_flags,
+                             cahal_async_callback     in_completion,
+                             void*                    in_completion_user_data
+                             )
+{
+  cahal_async_start_arguments arguments;
+
+  memset( &arguments, 0, sizeof( cahal_async_start_arguments ) );
+
+  arguments.device              = in_device;
+  arguments.format_id           = in_format_id;
+  arguments.number_of_channels  = in_number_of_channels;
+  arguments.sample_rate         = in_sample_rate;
+  arguments.bit_depth           = in_bit_depth;
+  arguments.volume              = in_volume;
+  arguments.playback            = in_playback;
+  arguments.user_data           = in_callback_user_data;
+  arguments.format_flags        = in_format_flags;
+
+  return  (
+           cahal_async_submit_start (
+                                     cahal_async_start_playback,
+                                     &arguments,
+                                     in_completion,
+                                     in_completion_user_data
+                                     )
+           );
+}
+
+cahal_async_operation*
+cahal_stop_recording_async  (
+                             cahal_async_callback in_completion,
+                             void*                in_completion_user_data
+                             )
+{
+  return  (
+           cahal_async_submit (
+                               cahal_async_stop_recording,
+                               NULL,
+                               in_completion,
+                               in_completion_user_data
+                               )
+           );
+}
+
+cahal_async_operation*
+cahal_stop_playback_async (
+                           CPC_BOOL             in_drain,
+                           cahal_async_callback in_completion,
+                           void*                in_completion_user_data
+                           )
+{
+  return  (
+           cahal_async_submit (
+                               in_drain
+                               ? cahal_async_drain_playback
+                               : cahal_async_stop_playback,
+                               NULL,
+                               in_completion,
+                               in_completion_user_data
+                               )
+           );
+}
+
+static
+CPC_BOOL
+cahal_async_create_thread (
+                           void* io_argument
+                           )
+{
+  if( ! cahal_mutex_initialize( &g_cahal_async_lock ) )
+  {
+    return( CPC_FALSE );
+  }
+
+  if( ! cahal_condition_initialize( &g_cahal_async_ready ) )
+  {
+    cahal_mutex_destroy( &g_cahal_async_lock );
+
+    return( CPC_FALSE );
+  }
+
+  if  (
+       ! cahal_thread_create  (
+                               &g_cahal_async_thread,
+                               cahal_async_thread_routine,
+                               NULL
+                               )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not create control thread." );
+
+    cahal_condition_destroy( &g_cahal_async_ready );
+    cahal_mutex_destroy( &g_cahal_async_lock );
+
+    return( CPC_FALSE );
+  }
+
+  return( CPC_TRUE );
+}
+
+static
+void
+cahal_async_thread_routine (
+                            void* in_argument
+                            )
+{
+  cahal_mutex_lock( &g_cahal_async_lock );
+
+  while( NULL != g_cahal_async_head || ! g_cahal_async_is_terminated )
+  {
+    cahal_async_operation* operation = g_cahal_async_head;
+
+    if( NULL == operation )
+    {
+      cahal_condition_wait( &g_cahal_async_ready, &g_cahal_async_lock );
+
+      continue;
+    }
+
+    g_cahal_async_head = operation->next;
+
+    if( NULL == g_cahal_async_head )
+    {
+      g_cahal_async_tail = NULL;
+    }
+
+    cahal_mutex_unlock( &g_cahal_async_lock );
+
+    CPC_BOOL result = operation->routine( operation->argument );
+
+    if( NULL != operation->callback )
+    {
+      operation->callback( operation, result, operation->user_data );
+    }
+
+    cahal_mutex_lock( &( operation->lock ) );
+
+    operation->result       = result;
+    operation->is_complete  = CPC_TRUE;
+
+    cahal_condition_broadcast( &( operation->completed ) );
+
+    cahal_mutex_unlock( &( operation->lock ) );
+
+    cahal_async_release( operation );
+
+    cahal_mutex_lock( &g_cahal_async_lock );
+  }
+
+  cahal_mutex_unlock( &g_cahal_async_lock );
+}
+
+static
+CPC_BOOL
+cahal_async_start_recording (
+                             void* io_arguments
+                             )
+{
+  cahal_async_start_arguments* arguments =
+    ( cahal_async_start_arguments* ) io_arguments;
+
+  CPC_BOOL result =
+    cahal_start_recording (
+                           arguments->device,
+                           arguments->format_id,
+                           arguments->number_of_channels,
+                           arguments->sample_rate,
+                           arguments->bit_depth,
+                           arguments->recorder,
+                           arguments->user_data,
+                           arguments->format_flags
+                           );
+
+  cpc_safe_free( ( void** ) &arguments );
+
+  return( result );
+}
+
+static
+CPC_BOOL
+cahal_async_start_playback  (
+                             void* io_arguments
+                             )
+{
+  cahal_async_start_arguments* arguments =
+    ( cahal_async_start_arguments* ) io_arguments;
+
+  CPC_BOOL result =
+    cahal_start_playback  (
+                           arguments->device,
+                           arguments->format_id,
+                           arguments->number_of_channels,
+                           arguments->sample_rate,
+                           arguments->bit_depth,
+                           arguments->volume,
+                           arguments->playback,
+                           arguments->user_data,
+                           arguments->format_flags
+                           );
+
+  cpc_safe_free( ( void** ) &arguments );
+
+  return( result );
+}
+
+static
+CPC_BOOL
+cahal_async_stop_recording  (
+                             void* io_argument
+                             )
+{
+  return( cahal_stop_recording() );
+}
+
+static
+CPC_BOOL
+cahal_async_stop_playback (
+                           void* io_argument
+                           )
+{
+  return( cahal_stop_playback() );
+}
+
+static
+CPC_BOOL
+cahal_async_drain_playback  (
+                             void* io_argument
+                             )
+{
+  return( cahal_drain_playback() );
+}
+
+static
+cahal_async_operation*
+cahal_async_submit_start (
+                          cahal_async_routine           in_routine,
+                          cahal_async_start_arguments*  in_arguments,
+                          cahal_async_callback          in_completion,
+                          void*                         in_completion_user_data
+                          )
+{
+  cahal_async_operation* operation        = NULL;
+  cahal_async_start_arguments* arguments  = NULL;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &arguments,
+                            sizeof( cahal_async_start_arguments )
+                            )
+       )
+  {
+    return( NULL );
+  }
+
+  memcpy( arguments, in_arguments, sizeof( cahal_async_start_arguments ) );
+
+  operation =
+    cahal_async_submit  (
+                         in_routine,
+                         arguments,
+                         in_completion,
+                         in_completion_user_data
+                         );
+
+  if( NULL == operation )
+  {
+    cpc_safe_free( ( void** ) &arguments );
+  }
+
+  return( operation );
+}
@@ -0,0 +1,543 @@
+/*! \file   cahal_audio_convert.c
+
+    \author Brent Carrara
+ */
+#include "cahal_audio_convert.h"
+
+/*! \def    CAHAL_CONVERT_SCALE_8
+    \brief  Scale factor between 8-bit samples and floating point samples.
+ */
+#define CAHAL_CONVERT_SCALE_8   128.0f
+
+/*! \def    CAHAL_CONVERT_SCALE_16
+    \brief  Scale factor between 16-bit samples and floating point samples.
+ */
+#define CAHAL_CONVERT_SCALE_16  32768.0f
+
+/*! \def    CAHAL_CONVERT_SCALE_24
+    \brief  Scale factor between 24-bit samples and floating point samples.
+ */
+#define CAHAL_CONVERT_SCALE_24  8388608.0f
+
+/*! \def    CAHAL_CONVERT_SCALE_32
+    \brief  Scale factor between 32-bit samples and floating point samples.
+ */
+#define CAHAL_CONVERT_SCALE_32  2147483648.0
+
+/*! \fn     FLOAT32 cahal_clip_sample (
+              FLOAT32 in_sample
+            )
+    \brief  Clips in_sample to the range [ -1, 1 ].
+
+    \param  in_sample The sample to clip.
+    \return The clipped sample.
+ */
+static
+FLOAT32
+cahal_clip_sample (
+                   FLOAT32 in_sample
+                   );
+
+UINT32
+cahal_get_bytes_per_sample (
+                            UINT32 in_bit_depth
+                            )
+{
+  return( ( in_bit_depth + 7 ) / 8 );
+}
+
+CPC_BOOL
+cahal_test_conversion_support (
+                               UINT32                  in_bit_depth,
+                               cahal_audio_format_flag in_format_flags
+                               )
+{
+  if( in_format_flags & CAHAL_AUDIO_FORMAT_FLAGISNONINTERLEAVED )
+  {
+    return( CPC_FALSE );
+  }
+
+  if( in_format_flags & CAHAL_AUDIO_FORMAT_FLAGISFLOAT )
+  {
+    return( 32 == in_bit_depth || 64 == in_bit_depth );
+  }
+
+  return  (
+           8 == in_bit_depth || 16 == in_bit_depth
+           || 24 == in_bit_depth || 32 == in_bit_depth
+           );
+}
+
+static
+FLOAT32
+cahal_clip_sample (
+                   FLOAT32 in_sample
+                   )
+{
+  if( 1.0f < in_sample )
+  {
+    return( 1.0f );
+  }
+  else if( -1.0f > in_sample )
+  {
+    return( -1.0f );
+  }
+
+  return( in_sample );
+}
+
+CPC_BOOL
+cahal_convert_to_float32  (
+                           const UCHAR*            in_buffer,
+                           UINT32                  in_number_of_samples,
+                           UINT32                  in_bit_depth,
+                           cahal_audio_format_flag in_format_flags,
+                           FLOAT32*                out_samples
+                           )
+{
+  UINT32 i            = 0;
+  CPC_BOOL big_endian =
+    ( 0 != ( in_format_flags & CAHAL_AUDIO_FORMAT_FLAGISBIGENDIAN ) );
+
+  if( NULL == in_buffer || NULL == out_samples )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null conversion buffer." );
+
+    return( CPC_FALSE );
+  }
+
+  if( ! cahal_test_conversion_support( in_bit_depth, in_format_flags ) )
+  {
+    CPC_ERROR (
+               "Unsupported conversion: bd=%d, flags=0x%x.",
+               in_bit_depth,
+               in_format_flags
+               );
+
+    return( CPC_FALSE );
+  }
+
+  if( in_format_flags & CAHAL_AUDIO_FORMAT_FLAGISFLOAT )
+  {
+    UINT32 bytes  = cahal_get_bytes_per_sample( in_bit_depth );
+    UCHAR swapped[ 8 ];
+
+    for( i = 0; i < in_number_of_samples; i++ )
+    {
+      const UCHAR* sample = in_buffer + i * bytes;
+
+      if( big_endian )
+      {
+        for( UINT32 j = 0; j < bytes; j++ )
+        {
+          swapped[ j ] = sample[ bytes - 1 - j ];
+        }
+
+        sample = swapped;
+      }
+
+      if( 4 == bytes )
+      {
+        FLOAT32 value;
+
+        memcpy( &value, sample, sizeof( FLOAT32 ) );
+
+        out_samples[ i ] = value;
+      }
+      else
+      {
+        FLOAT64 value;
+
+        memcpy( &value, sample, sizeof( FLOAT64 ) );
+
+        out_samples[ i ] = ( FLOAT32 ) value;
+      }
+    }
+
+    return( CPC_TRUE );
+  }
+
+  switch( in_bit_depth )
+  {
+    case 8:
+      if( in_format_flags & CAHAL_AUDIO_FORMAT_FLAGISSIGNEDINTEGER )
+      {
+        for( i = 0; i < in_number_of_samples; i++ )
+        {
+          out_samples[ i ] =
+            ( ( INT8 ) in_buffer[ i ] ) / CAHAL_CONVERT_SCALE_8;
+        }
+      }
+      else
+      {
+        for( i = 0; i < in_number_of_samples; i++ )
+        {
+          out_samples[ i ] =
+            ( ( INT32 ) in_buffer[ i ] - 128 ) / CAHAL_CONVERT_SCALE_8;
+        }
+      }
+      break;
+    case 16:
+      if( big_endian )
+      {
+        for( i = 0; i < in_number_of_samples; i++ )
+        {
+          INT16 value =
+            ( INT16 ) ( ( in_buffer[ 2 * i ] << 8 ) | in_buffer[ 2 * i + 1 ] );
+
+          out_samples[ i ] = value / CAHAL_CONVERT_SCALE_16;
+        }
+      }
+      else
+      {
+        for( i = 0; i < in_number_of_samples; i++ )
+        {
+          INT16 value =
+            ( INT16 ) ( in_buffer[ 2 * i ] | ( in_buffer[ 2 * i + 1 ] << 8 ) );
+
+          out_samples[ i ] = value / CAHAL_CONVERT_SCALE_16;
+        }
+      }
+      break;
+    case 24:
+      for( i = 0; i < in_number_of_samples; i++ )
+      {
+        const UCHAR* sample = in_buffer + 3 * i;
+        UINT32 value        = 0;
+
+        if( big_endian )
+        {
+          value = ( ( UINT32 ) sample[ 0 ] << 16 )
+                  | ( ( UINT32 ) sample[ 1 ] << 8 )
+                  | sample[ 2 ];
+        }
+        else
+        {
+          value = ( ( UINT32 ) sample[ 2 ] << 16 )
+                  | ( ( UINT32 ) sample[ 1 ] << 8 )
+                  | sample[ 0 ];
+        }
+
+        if( value & 0x800000 )
+        {
+          value |= 0xFF000000;
+        }
+
+        out_samples[ i ] = ( ( INT32 ) value ) / CAHAL_CONVERT_SCALE_24;
+      }
+      break;
+    case 32:
+      for( i = 0; i < in_number_of_samples; i++ )
+      {
+        const UCHAR* sample = in_buffer + 4 * i;
+        UINT32 value        = 0;
+
+        if( big_endian )
+        {
+          value = ( ( UINT32 ) sample[ 0 ] << 24 )
+                  | ( ( UINT32 ) sample[ 1 ] << 16 )
+                  | ( ( UINT32 ) sample[ 2 ] << 8 )
+                  | sample[ 3 ];
+        }
+        else
+        {
+          value = ( ( UINT32 ) sample[ 3 ] << 24 )
+                  | ( ( UINT32 ) sample[ 2 ] << 16 )
+                  | ( ( UINT32 ) sample[ 1 ] << 8 )
+                  | sample[ 0 ];
+        }
+
+        out_samples[ i ] =
+          ( FLOAT32 ) ( ( INT32 ) value / CAHAL_CONVERT_SCALE_32 );
+      }
+      break;
+  }
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_convert_from_float32  (
+                             const FLOAT32*          in_samples,
+                             UINT32                  in_number_of_samples,
+                             UINT32                  in_bit_depth,
+                             cahal_audio_format_flag in_format_flags,
+                             UCHAR*                  out_buffer
+                             )
+{
+  UINT32 i            = 0;
+  CPC_BOOL big_endian =
+    ( 0 != ( in_format_flags & CAHAL_AUDIO_FORMAT_FLAGISBIGENDIAN ) );
+
+  if( NULL == in_samples || NULL == out_buffer )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null conversion buffer." );
+
+    return( CPC_FALSE );
+  }
+
+  if( ! cahal_test_conversion_support( in_bit_depth, in_format_flags ) )
+  {
+    CPC_ERROR (
+               "Unsupported conversion: bd=%d, flags=0x%x.",
+               in_bit_depth,
+               in_format_flags
+               );
+
+    return( CPC_FALSE );
+  }
+
+  if( in_format_flags & CAHAL_AUDIO_FORMAT_FLAGISFLOAT )
+  {
+    UINT32 bytes  = cahal_get_bytes_per_sample( in_bit_depth );
+
+    for( i = 0; i < in_number_of_samples; i++ )
+    {
+      UCHAR* sample = out_buffer + i * bytes;
+
+      if( 4 == bytes )
+      {
+        FLOAT32 value = in_samples[ i ];
+
+        memcpy( sample, &value, sizeof( FLOAT32 ) );
+      }
+      else
+      {
+        FLOAT64 value = in_samples[ i ];
+
+        memcpy( sample, &value, sizeof( FLOAT64 ) );
+      }
+
+      if( big_endian )
+      {
+        for( UINT32 j = 0; j < bytes / 2; j++ )
+        {
+          UCHAR temp                = sample[ j ];
+          sample[ j ]               = sample[ bytes - 1 - j ];
+          sample[ bytes - 1 - j ]   = temp;
+        }
+      }
+    }
+
+    return( CPC_TRUE );
+  }
+
+  switch( in_bit_depth )
+  {
+    case 8:
+      for( i = 0; i < in_number_of_samples; i++ )
+      {
+        INT32 value =
+          ( INT32 ) ( cahal_clip_sample( in_samples[ i ] )
+                      * ( CAHAL_CONVERT_SCALE_8 - 1 ) );
+
+        if( in_format_flags & CAHAL_AUDIO_FORMAT_FLAGISSIGNEDINTEGER )
+        {
+          out_buffer[ i ] = ( UCHAR ) ( INT8 ) value;
+        }
+        else
+        {
+          out_buffer[ i ] = ( UCHAR ) ( value + 128 );
+        }
+      }
+      break;
+    case 16:
+      for( i = 0; i < in_number_of_samples; i++ )
+      {
+        INT16 value =
+          ( INT16 ) ( cahal_clip_sample( in_samples[ i ] )
+                      * ( CAHAL_CONVERT_SCALE_16 - 1 ) );
+
+        if( big_endian )
+        {
+          out_buffer[ 2 * i ]     = ( UCHAR ) ( ( value >> 8 ) & 0xFF );
+          out_buffer[ 2 * i + 1 ] = ( UCHAR ) ( value & 0xFF );
+        }
+        else
+        {
+          out_buffer[ 2 * i ]     = ( UCHAR ) ( value & 0xFF );
+          out_buffer[ 2 * i + 1 ] = ( UCHAR ) ( ( value >> 8 ) & 0xFF );
+        }
+      }
+      break;
+    case 24:
+      for( i = 0; i < in_number_of_samples; i++ )
+      {
+        UCHAR* sample = out_buffer + 3 * i;
+        INT32 value   =
+          ( INT32 ) ( cahal_clip_sample( in_samples[ i ] )
+                      * ( CAHAL_CONVERT_SCALE_24 - 1 ) );
+
+        if( big_endian )
+        {
+          sample[ 0 ] = ( UCHAR ) ( ( value >> 16 ) & 0xFF );
+          sample[ 1 ] = ( UCHAR ) ( ( value >> 8 ) & 0xFF );
+          sample[ 2 ] = ( UCHAR ) ( value & 0xFF );
+        }
+        else
+        {
+          sample[ 0 ] = ( UCHAR ) ( value & 0xFF );
+          sample[ 1 ] = ( UCHAR ) ( ( value >> 8 ) & 0xFF );
+          sample[ 2 ] = ( UCHAR ) ( ( value >> 16 ) & 0xFF );
+        }
+      }
+      break;
+    case 32:
+      for( i = 0; i < in_number_of_samples; i++ )
+      {
+        UCHAR* sample = out_buffer + 4 * i;
+        INT32 value   =
+          ( INT32 ) ( cahal_clip_sample( in_samples[ i ] )
+                      * ( CAHAL_CONVERT_SCALE_32 - 1 ) );
+
+        if( big_endian )
+        {
+          sample[ 0 ] = ( UCHAR ) ( ( value >> 24 ) & 0xFF );
+          sample[ 1 ] = ( UCHAR ) ( ( value >> 16 ) & 0xFF );
+          sample[ 2 ] = ( UCHAR ) ( ( value >> 8 ) & 0xFF );
+          sample[ 3 ] = ( UCHAR ) ( value & 0xFF );
+        }
+        else
+        {
+          sample[ 0 ] = ( UCHAR ) ( value & 0xFF );
+          sample[ 1 ] = ( UCHAR ) ( ( value >> 8 ) & 0xFF );
+          sample[ 2 ] = ( UCHAR ) ( ( value >> 16 ) & 0xFF );
+          sample[ 3 ] = ( UCHAR ) ( ( value >> 24 ) & 0xFF );
+        }
+      }
+      break;
+  }
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_deinterleave_float32  (
+                             const FLOAT32*  in_samples,
+                             UINT32          in_number_of_frames,
+                             UINT32          in_number_of_channels,
+                             FLOAT32*        out_samples
+                             )
+{
+  if( NULL == in_samples || NULL == out_samples )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null conversion buffer." );
+
+    return( CPC_FALSE );
+  }
+
+  //  Writing each channel's block in turn keeps the stores unit-stride, which
+  //  the compiler can vectorise, at any number of channels
+
+  for( UINT32 channel = 0; channel < in_number_of_channels; channel++ )
+  {
+    const FLOAT32* input  = in_samples + channel;
+    FLOAT32* output       = out_samples + channel * in_number_of_frames;
+
+    for( UINT32 frame = 0; frame < in_number_of_frames; frame++ )
+    {
+      output[ frame ] = input[ frame * in_number_of_channels ];
+    }
+  }
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_interleave_float32  (
+                           const FLOAT32*  in_samples,
+                           UINT32          in_number_of_frames,
+                           UINT32          in_number_of_channels,
+                           FLOAT32*        out_samples
+                           )
+{
+  if( NULL == in_samples || NULL == out_samples )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null conversion buffer." );
+
+    return( CPC_FALSE );
+  }
+
+  for( UINT32 channel = 0; channel < in_number_of_channels; channel++ )
+  {
+    const FLOAT32* input  = in_samples + channel * in_number_of_frames;
+    FLOAT32* output       = out_samples + channel;
+
+    for( UINT32 frame = 0; frame < in_number_of_frames; frame++ )
+    {
+      output[ frame * in_number_of_channels ] = input[ frame ];
+    }
+  }
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_remap_channels_float32  (
+                               const FLOAT32*              in_samples,
+                               UINT32                      in_number_of_frames,
+                               const cahal_channel_layout* in_input_layout,
+                               const cahal_channel_layout* in_output_layout,
+                               FLOAT32*                    out_samples
+                               )
+{
+  UINT32 map[ CAHAL_MAXIMUM_NUMBER_OF_CHANNELS ];
+  UINT32 input_channels   = 0;
+  UINT32 output_channels  = 0;
+
+  if  (
+       NULL == in_samples || NULL == out_samples
+       || NULL == in_input_layout || NULL == in_output_layout
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null conversion buffer." );
+
+    return( CPC_FALSE );
+  }
+
+  input_channels  = cahal_get_channel_layout_size( in_input_layout );
+  output_channels = cahal_get_channel_layout_size( in_output_layout );
+
+  if  (
+       in_input_layout->layout_type != in_output_layout->layout_type
+       || ! cahal_test_channel_layout( in_input_layout, input_channels )
+       || ! cahal_test_channel_layout( in_output_layout, output_channels )
+       || CAHAL_CHANNEL_LAYOUT_UNSPECIFIED == in_input_layout->layout_type
+       )
+  {
+    CPC_ERROR (
+               "Cannot remap channel layout %s to %s.",
+               cahal_convert_channel_layout_type_to_cstring (
+                                                in_input_layout->layout_type
+                                                             ),
+               cahal_convert_channel_layout_type_to_cstring (
+                                                in_output_layout->layout_type
+                                                             )
+               );
+
+    return( CPC_FALSE );
+  }
+
+  //  map[ i ] is the input channel feeding output channel i
+
+  for( UINT32 bit = 0, i = 0; bit < CAHAL_MAXIMUM_NUMBER_OF_CHANNELS; bit++ )
+  {
+    if( in_output_layout->channel_mask & ( ( ( UINT64 ) 1 ) << bit ) )
+    {
+      map[ i++ ] = cahal_get_channel_index( in_input_layout, bit );
+    }
+  }
+
+  for( UINT32 frame = 0; frame < in_number_of_frames; frame++ )
+  {
+    const FLOAT32* input  = in_samples + frame * input_channels;
+    FLOAT32* output       = out_samples + frame * output_channels;
+
+    for( UINT32 i = 0; i < output_channels; i++ )
+    {
+      output[ i ] = ( CAHAL_NO_CHANNEL == map[ i ] ) ? 0.0f : input[ map[ i ] ];
+    }
+  }
+
+  return( CPC_TRUE );
+}
@@ -4,6 +4,77 @@
  */
 #include "cahal_audio_format_description.h"
 
+/*! \def    CAHAL_NUMBER_OF_DEFAULT_SPEAKER_LAYOUTS
+    \brief  The length of the default_speaker_masks array.
+ */
+#define CAHAL_NUMBER_OF_DEFAULT_SPEAKER_LAYOUTS 8
+
+/*! \def    CAHAL_CHANNEL_BIT
+    \brief  The channel_mask bit of the speaker position or array element x.
+ */
+#define CAHAL_CHANNEL_BIT( x )  ( ( ( UINT64 ) 1 ) << ( x ) )
+
+/*! \var    default_speaker_masks
+    \brief  The speaker layouts of 1 (mono), 2 (stereo), 3 (3.0), 4 (quad),
+            5 (5.0), 6 (5.1), 7 (6.1) and 8 (7.1) channel frames, as used by
+            WAVEFORMATEXTENSIBLE.
+ */
+static const UINT64 default_speaker_masks [
+                                       CAHAL_NUMBER_OF_DEFAULT_SPEAKER_LAYOUTS
+                                           ] =
+{
+  CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_CENTER ),
+  CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_LEFT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_RIGHT ),
+  CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_LEFT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_RIGHT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_CENTER ),
+  CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_LEFT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_RIGHT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_BACK_LEFT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_BACK_RIGHT ),
+  CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_LEFT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_RIGHT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_CENTER )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_BACK_LEFT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_BACK_RIGHT ),
+  CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_LEFT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_RIGHT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_CENTER )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_LOW_FREQUENCY )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_BACK_LEFT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_BACK_RIGHT ),
+  CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_LEFT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_RIGHT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_CENTER )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_LOW_FREQUENCY )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_BACK_CENTER )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_SIDE_LEFT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_SIDE_RIGHT ),
+  CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_LEFT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_RIGHT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_FRONT_CENTER )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_LOW_FREQUENCY )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_BACK_LEFT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_BACK_RIGHT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_SIDE_LEFT )
+  | CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_SIDE_RIGHT )
+};
+
+/*! \fn     UINT32 cahal_count_channel_bits (
+              UINT64 in_channel_mask
+            )
+    \brief  Returns the number of bits set in in_channel_mask.
+
+    \param  in_channel_mask The mask to count.
+    \return The number of set bits.
+ */
+static
+UINT32
+cahal_count_channel_bits (
+                          UINT64 in_channel_mask
+                          );
+
 /*! \fn     void log_cahal_audio_format  (
              cpc_log_level          in_log_level,
              CHAR*                  in_label,
@@ -162,6 +233,17 @@ cahal_print_audio_format_description  (
              in_audio_format_description->bit_depth
              );
     
+    CPC_LOG (
+             CPC_LOG_LEVEL_INFO,
+             "\t\t\t\tChannel layout: %s (0x%08x%08x)",
+             cahal_convert_channel_layout_type_to_cstring (
+                   in_audio_format_description->channel_layout.layout_type
+                                                           ),
+             ( UINT32 )
+             ( in_audio_format_description->channel_layout.channel_mask >> 32 ),
+             ( UINT32 ) in_audio_format_description->channel_layout.channel_mask
+             );
+    
     CPC_LOG (
              CPC_LOG_LEVEL_INFO,
              "\t\t\t\tMinimum supported sample rate: %.2f",
@@ -175,3 +257,186 @@ cahal_print_audio_format_description  (
              );
   }
 }
+
+void
+cahal_free_audio_format_description_list (
+                       cahal_audio_format_description** in_format_list
+                                          )
+{
+  if( NULL != in_format_list )
+  {
+    UINT32 format_index = 0;
+    cahal_audio_format_description* format =
+    in_format_list[ format_index++ ];
+    
+    while( NULL != format )
+    {
+      cpc_safe_free( ( void** ) &format );
+      
+      format = in_format_list[ format_index++ ];
+    }
+    
+    cpc_safe_free( ( void** ) &in_format_list );
+  }
+}
+
+CPC_BOOL
+cahal_get_default_channel_layout  (
+                                   UINT32                in_number_of_channels,
+                                   cahal_channel_layout* out_channel_layout
+                                   )
+{
+  if( NULL == out_channel_layout )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null channel layout." );
+
+    return( CPC_FALSE );
+  }
+
+  memset( out_channel_layout, 0, sizeof( cahal_channel_layout ) );
+
+  if  (
+       0 == in_number_of_channels
+       || CAHAL_MAXIMUM_NUMBER_OF_CHANNELS < in_number_of_channels
+       )
+  {
+    CPC_ERROR( "Invalid number of channels: %d.", in_number_of_channels );
+
+    return( CPC_FALSE );
+  }
+
+  if( CAHAL_NUMBER_OF_DEFAULT_SPEAKER_LAYOUTS >= in_number_of_channels )
+  {
+    out_channel_layout->layout_type   = CAHAL_CHANNEL_LAYOUT_SPEAKERS;
+    out_channel_layout->channel_mask  =
+      default_speaker_masks[ in_number_of_channels - 1 ];
+  }
+  else
+  {
+    out_channel_layout->layout_type   = CAHAL_CHANNEL_LAYOUT_DISCRETE;
+    out_channel_layout->channel_mask  =
+      ( CAHAL_MAXIMUM_NUMBER_OF_CHANNELS == in_number_of_channels )
+      ? ~( ( UINT64 ) 0 )
+      : CAHAL_CHANNEL_BIT( in_number_of_channels ) - 1;
+  }
+
+  return( CPC_TRUE );
+}
+
+UINT32
+cahal_get_channel_layout_size  (
+                                const cahal_channel_layout* in_channel_layout
+                                )
+{
+  if( NULL == in_channel_layout )
+  {
+    return( 0 );
+  }
+
+  return( cahal_count_channel_bits( in_channel_layout->channel_mask ) );
+}
+
+UINT32
+cahal_get_channel_index  (
+                          const cahal_channel_layout* in_channel_layout,
+                          UINT32                      in_channel
+                          )
+{
+  if  (
+       NULL == in_channel_layout
+       || CAHAL_MAXIMUM_NUMBER_OF_CHANNELS <= in_channel
+       || 0 == ( in_channel_layout->channel_mask
+                 & CAHAL_CHANNEL_BIT( in_channel ) )
+       )
+  {
+    return( CAHAL_NO_CHANNEL );
+  }
+
+  //  Channels are stored in the order of their bits, so the index is the
+  //  number of channels with lower bits
+
+  return  (
+           cahal_count_channel_bits (
+                                     in_channel_layout->channel_mask
+                                     & ( CAHAL_CHANNEL_BIT( in_channel ) - 1 )
+                                     )
+           );
+}
+
+CPC_BOOL
+cahal_test_channel_layout  (
+                            const cahal_channel_layout* in_channel_layout,
+                            UINT32                      in_number_of_channels
+                            )
+{
+  if  (
+       NULL == in_channel_layout
+       || 0 == in_number_of_channels
+       || CAHAL_MAXIMUM_NUMBER_OF_CHANNELS < in_number_of_channels
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  switch( in_channel_layout->layout_type )
+  {
+    case CAHAL_CHANNEL_LAYOUT_UNSPECIFIED:
+      return( 0 == in_channel_layout->channel_mask );
+    case CAHAL_CHANNEL_LAYOUT_SPEAKERS:
+      if  (
+           in_channel_layout->channel_mask
+           >= CAHAL_CHANNEL_BIT( CAHAL_CHANNEL_NUMBER_OF_POSITIONS )
+           )
+      {
+        return( CPC_FALSE );
+      }
+
+      //  Fall through, speaker layouts must also carry every channel
+
+    case CAHAL_CHANNEL_LAYOUT_DISCRETE:
+      return  (
+               cahal_get_channel_layout_size( in_channel_layout )
+               == in_number_of_channels
+               );
+    default:
+      return( CPC_FALSE );
+  }
+}
+
+CHAR*
+cahal_convert_channel_layout_type_to_cstring  (
+                                      cahal_channel_layout_type in_layout_type
+                                               )
+{
+  switch( in_layout_type )
+  {
+    case CAHAL_CHANNEL_LAYOUT_UNSPECIFIED:
+      return( "Unspecified" );
+    case CAHAL_CHANNEL_LAYOUT_SPEAKERS:
+      return( "Speakers" );
+    case CAHAL_CHANNEL_LAYOUT_DISCRETE:
+      return( "Discrete" );
+    default:
+      return( "Unknown layout" );
+  }
+}
+
+static
+UINT32
+cahal_count_channel_bits (
+                          UINT64 in_channel_mask
+                          )
+{
+  UINT32 count = 0;
+
+  //  Clears the lowest set bit until none remain
+
+  while( 0 != in_channel_mask )
+  {
+    in_channel_mask &= in_channel_mask - 1;
+
+    count++;
+  }
+
+  return( count );
+}
@@ -0,0 +1,329 @@
+/*! \file   cahal_callback.c
+
+    \author Brent Carrara
+ */
+#include "cahal_callback.h"
+#include "cahal_audio_convert.h"
+
+/*! \fn     UINT64 cahal_callback_get_duration  (
+              UINT32  in_number_of_bytes,
+              UINT32  in_number_of_channels,
+              UINT32  in_bit_depth,
+              FLOAT64 in_sample_rate
+            )
+    \brief  Returns the time it takes to play or record in_number_of_bytes.
+
+    \param  in_number_of_bytes  The number of bytes of samples.
+    \param  in_number_of_channels The number of channels per frame.
+    \param  in_bit_depth  The quantization level of the samples.
+    \param  in_sample_rate  The sample rate.
+    \return The duration in nanoseconds.
+ */
+static
+UINT64
+cahal_callback_get_duration  (
+                              UINT32  in_number_of_bytes,
+                              UINT32  in_number_of_channels,
+                              UINT32  in_bit_depth,
+                              FLOAT64 in_sample_rate
+                              );
+
+static
+UINT64
+cahal_callback_get_duration  (
+                              UINT32  in_number_of_bytes,
+                              UINT32  in_number_of_channels,
+                              UINT32  in_bit_depth,
+                              FLOAT64 in_sample_rate
+                              )
+{
+  UINT32 frame_size =
+    cahal_get_bytes_per_sample( in_bit_depth ) * in_number_of_channels;
+
+  if( 0 == frame_size || 0.0 >= in_sample_rate )
+  {
+    return( 0 );
+  }
+
+  return  (
+           ( UINT64 ) ( ( in_number_of_bytes / frame_size )
+                        * 1000000000.0 / in_sample_rate )
+           );
+}
+
+CPC_BOOL
+cahal_dispatch_recording  (
+                           cahal_recorder_info* in_recorder_info,
+                           UCHAR*               io_data_buffer,
+                           UINT32               in_data_buffer_length
+                           )
+{
+  CPC_BOOL return_value = CPC_FALSE;
+  UINT64 record_time    = 0;
+
+  if( ! cahal_stream_state_enter_callback( &g_cahal_recording_state ) )
+  {
+    CPC_LOG_STRING  (
+                     CPC_LOG_LEVEL_TRACE,
+                     "Dropping buffer of a stopped recording."
+                     );
+
+    return( CPC_FALSE );
+  }
+
+  record_time =
+    cahal_get_time()
+    - cahal_callback_get_duration (
+                                   in_data_buffer_length,
+                                   in_recorder_info->number_of_channels,
+                                   in_recorder_info->bit_depth,
+                                   in_recorder_info->sample_rate
+                                   );
+
+  if( NULL != in_recorder_info->dispatcher )
+  {
+    return_value =
+      cahal_dispatcher_push_recording (
+                                       in_recorder_info->dispatcher,
+                                       io_data_buffer,
+                                       in_data_buffer_length,
+                                       record_time
+                                       );
+  }
+  else
+  {
+    return_value =
+      cahal_process_recording  (
+                                in_recorder_info,
+                                io_data_buffer,
+                                in_data_buffer_length,
+                                record_time
+                                );
+  }
+
+  cahal_stream_state_leave_callback( &g_cahal_recording_state );
+
+  return( return_value );
+}
+
+CPC_BOOL
+cahal_dispatch_playback (
+                         cahal_playback_info* in_playback_info,
+                         UCHAR*               out_data_buffer,
+                         UINT32*              io_data_buffer_length,
+                         UINT32               in_queued_bytes
+                         )
+{
+  cahal_playback_schedule* schedule = NULL;
+  CPC_BOOL return_value             = CPC_FALSE;
+  UINT32 silence                    = 0;
+
+  if( ! cahal_stream_state_enter_callback( &g_cahal_playback_state ) )
+  {
+    CPC_LOG_STRING  (
+                     CPC_LOG_LEVEL_TRACE,
+                     "Not rendering for a stopped playback."
+                     );
+
+    *io_data_buffer_length = 0;
+
+    return( CPC_FALSE );
+  }
+
+  schedule = in_playback_info->schedule;
+
+  if( NULL != schedule )
+  {
+    silence =
+      cahal_playback_schedule_get_silence (
+                                           schedule,
+                                           *io_data_buffer_length,
+                                           in_queued_bytes
+                                           );
+
+    CPC_MEMSET( out_data_buffer, 0, silence );
+  }
+
+  if( NULL != schedule && ! schedule->has_started )
+  {
+    //  The playback starts in a later buffer
+    *io_data_buffer_length  = silence;
+    return_value            = CPC_TRUE;
+  }
+  else
+  {
+    //  The first sample of the playback is spliced in after the silence
+    *io_data_buffer_length -= silence;
+
+    if( NULL != in_playback_info->dispatcher )
+    {
+      return_value =
+        cahal_dispatcher_pull_playback  (
+                                         in_playback_info->dispatcher,
+                                         out_data_buffer + silence,
+                                         io_data_buffer_length,
+                                         in_queued_bytes + silence
+                                         );
+    }
+    else
+    {
+      return_value =
+        cahal_process_playback (
+                                in_playback_info,
+                                out_data_buffer + silence,
+                                io_data_buffer_length,
+                                in_queued_bytes + silence
+                                );
+    }
+
+    *io_data_buffer_length += silence;
+  }
+
+  if( NULL != schedule )
+  {
+    cahal_playback_schedule_advance( schedule, *io_data_buffer_length );
+  }
+
+  cahal_stream_state_leave_callback( &g_cahal_playback_state );
+
+  return( return_value );
+}
+
+CPC_BOOL
+cahal_process_recording  (
+                          cahal_recorder_info* in_recorder_info,
+                          UCHAR*               io_data_buffer,
+                          UINT32               in_data_buffer_length,
+                          UINT64               in_record_time
+                          )
+{
+  cahal_echo_canceller* canceller   = g_echo_canceller;
+  cahal_filter_bank*    filter_bank = g_capture_filter_bank;
+
+  if  (
+       NULL != canceller
+       && CAHAL_AUDIO_FORMAT_LINEARPCM == in_recorder_info->format_id
+       && canceller->number_of_channels
+          == in_recorder_info->number_of_channels
+       && canceller->sample_rate == in_recorder_info->sample_rate
+       )
+  {
+    if  (
+         ! cahal_echo_canceller_process_buffer  (
+                                                 canceller,
+                                                 io_data_buffer,
+                                                 in_data_buffer_length,
+                                                 in_recorder_info->bit_depth,
+                                                 in_recorder_info->format_flags,
+                                                 in_record_time
+                                                 )
+         )
+    {
+      CPC_LOG_STRING  (
+                       CPC_LOG_LEVEL_TRACE,
+                       "Echo canceller does not support recording format."
+                       );
+    }
+  }
+
+  if  (
+       NULL != filter_bank
+       && CAHAL_AUDIO_FORMAT_LINEARPCM == in_recorder_info->format_id
+       && filter_bank->number_of_channels
+          == in_recorder_info->number_of_channels
+       && filter_bank->sample_rate == in_recorder_info->sample_rate
+       )
+  {
+    if  (
+         ! cahal_filter_bank_process_buffer (
+                                             filter_bank,
+                                             io_data_buffer,
+                                             in_data_buffer_length,
+                                             in_recorder_info->bit_depth,
+                                             in_recorder_info->format_flags
+                                             )
+         )
+    {
+      CPC_LOG_STRING  (
+                       CPC_LOG_LEVEL_TRACE,
+                       "Filter bank does not support recording format."
+                       );
+    }
+  }
+
+  if( NULL != in_recorder_info->coalescer )
+  {
+    return  (
+             cahal_coalescer_push (
+                                   in_recorder_info->coalescer,
+                                   in_recorder_info,
+                                   io_data_buffer,
+                                   in_data_buffer_length
+                                   )
+             );
+  }
+
+  return  (
+           in_recorder_info->recording_callback (
+                                         in_recorder_info->recording_device,
+                                         io_data_buffer,
+                                         in_data_buffer_length,
+                                         in_recorder_info->user_data
+                                                 )
+           );
+}
+
+CPC_BOOL
+cahal_process_playback (
+                        cahal_playback_info* in_playback_info,
+                        UCHAR*               out_data_buffer,
+                        UINT32*              io_data_buffer_length,
+                        UINT32               in_queued_bytes
+                        )
+{
+  cahal_echo_canceller* canceller = g_echo_canceller;
+  CPC_BOOL return_value           =
+    in_playback_info->playback_callback (
+                                         in_playback_info->playback_device,
+                                         out_data_buffer,
+                                         io_data_buffer_length,
+                                         in_playback_info->user_data
+                                         );
+
+  if  (
+       return_value
+       && NULL != canceller
+       && CAHAL_AUDIO_FORMAT_LINEARPCM == in_playback_info->format_id
+       && canceller->sample_rate == in_playback_info->sample_rate
+       )
+  {
+    UINT64 play_time =
+      cahal_get_time()
+      + cahal_callback_get_duration (
+                                     in_queued_bytes,
+                                     in_playback_info->number_of_channels,
+                                     in_playback_info->bit_depth,
+                                     in_playback_info->sample_rate
+                                     );
+
+    if  (
+         ! cahal_echo_canceller_write_reference_buffer  (
+                                       canceller,
+                                       out_data_buffer,
+                                       *io_data_buffer_length,
+                                       in_playback_info->number_of_channels,
+                                       in_playback_info->bit_depth,
+                                       in_playback_info->format_flags,
+                                       play_time
+                                                         )
+         )
+    {
+      CPC_LOG_STRING  (
+                       CPC_LOG_LEVEL_TRACE,
+                       "Echo canceller does not support playback format."
+                       );
+    }
+  }
+
+  return( return_value );
+}
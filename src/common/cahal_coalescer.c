@@ -0,0 +1,268 @@
+/*! \file   cahal_coalescer.c
+
+    \author Brent Carrara
+ */
+#include "cahal_coalescer.h"
+
+#include "cahal_audio_convert.h"
+
+/*! \var    g_coalesce_options
+    \brief  The options set using cahal_set_coalesce_options.
+ */
+static cahal_coalesce_options g_coalesce_options;
+
+/*! \var    g_is_coalescing
+    \brief  True iff the callbacks of new recordings are coalesced.
+ */
+static CPC_BOOL g_is_coalescing = CPC_FALSE;
+
+/*! \fn     CPC_BOOL cahal_coalescer_call  (
+              cahal_coalescer*     io_coalescer,
+              cahal_recorder_info* in_recorder_info
+            )
+    \brief  Passes the accumulated samples to the recording callback and
+            empties the buffer.
+
+    \param  io_coalescer  The coalescer of the recording.
+    \param  in_recorder_info  The recording.
+    \return The value returned by the recording callback.
+ */
+static
+CPC_BOOL
+cahal_coalescer_call  (
+                       cahal_coalescer*     io_coalescer,
+                       cahal_recorder_info* in_recorder_info
+                       );
+
+void
+cahal_set_coalesce_options  (
+                             const cahal_coalesce_options* in_options
+                             )
+{
+  if( NULL == in_options )
+  {
+    g_is_coalescing = CPC_FALSE;
+  }
+  else
+  {
+    g_coalesce_options  = *in_options;
+    g_is_coalescing     = CPC_TRUE;
+  }
+}
+
+CPC_BOOL
+cahal_get_coalesce_options  (
+                             cahal_coalesce_options* out_options
+                             )
+{
+  if( g_is_coalescing && NULL != out_options )
+  {
+    *out_options = g_coalesce_options;
+  }
+
+  return( g_is_coalescing );
+}
+
+cahal_coalescer*
+cahal_coalescer_create  (
+                         const cahal_coalesce_options* in_options,
+                         cahal_recorder_info*          in_recorder_info,
+                         UINT32                        in_buffer_size
+                         )
+{
+  cahal_coalescer* coalescer  = NULL;
+  UINT32 frame_size           = 0;
+  UINT32 buffer_size          = 0;
+
+  if( NULL == in_options || NULL == in_recorder_info || 0 == in_buffer_size )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid coalescer parameters." );
+
+    return( NULL );
+  }
+
+  frame_size =
+    cahal_get_bytes_per_sample( in_recorder_info->bit_depth )
+    * in_recorder_info->number_of_channels;
+
+  if( 0 == frame_size )
+  {
+    frame_size = 1;
+  }
+
+  buffer_size = in_options->number_of_periods * in_buffer_size;
+
+  if( in_options->number_of_bytes > buffer_size )
+  {
+    buffer_size = in_options->number_of_bytes;
+  }
+
+  if  (
+       in_options->duration * in_recorder_info->sample_rate * frame_size
+       > buffer_size
+       )
+  {
+    buffer_size =
+      ( UINT32 ) ( in_options->duration * in_recorder_info->sample_rate )
+      * frame_size;
+  }
+
+  if( 0 == buffer_size )
+  {
+    buffer_size = CAHAL_COALESCE_DEFAULT_NUMBER_OF_PERIODS * in_buffer_size;
+  }
+
+  //  Every callback gets whole frames
+  buffer_size = ( ( buffer_size + frame_size - 1 ) / frame_size ) * frame_size;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &coalescer, sizeof( cahal_coalescer ) )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc( ( void** ) &( coalescer->buffer ), buffer_size )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not allocate coalescer." );
+
+    cahal_coalescer_free( coalescer );
+
+    return( NULL );
+  }
+
+  coalescer->buffer_size = buffer_size;
+
+  CPC_LOG (
+           CPC_LOG_LEVEL_DEBUG,
+           "Coalescing %d-byte periods into %d-byte callbacks.",
+           in_buffer_size,
+           buffer_size
+           );
+
+  return( coalescer );
+}
+
+void
+cahal_coalescer_free  (
+                       cahal_coalescer* in_coalescer
+                       )
+{
+  if( NULL != in_coalescer )
+  {
+    if( NULL != in_coalescer->buffer )
+    {
+      cpc_safe_free( ( void** ) &( in_coalescer->buffer ) );
+    }
+
+    cpc_safe_free( ( void** ) &in_coalescer );
+  }
+}
+
+CPC_BOOL
+cahal_coalescer_push  (
+                       cahal_coalescer*     io_coalescer,
+                       cahal_recorder_info* in_recorder_info,
+                       const UCHAR*         in_data_buffer,
+                       UINT32               in_data_buffer_length
+                       )
+{
+  UINT32 offset = 0;
+
+  while( ! io_coalescer->has_failed && offset < in_data_buffer_length )
+  {
+    UINT32 length = io_coalescer->buffer_size - io_coalescer->fill;
+
+    if( in_data_buffer_length - offset < length )
+    {
+      length = in_data_buffer_length - offset;
+    }
+
+    memcpy  (
+             io_coalescer->buffer + io_coalescer->fill,
+             in_data_buffer + offset,
+             length
+             );
+
+    io_coalescer->fill  += length;
+    offset              += length;
+
+    if( io_coalescer->buffer_size == io_coalescer->fill )
+    {
+      cahal_coalescer_call( io_coalescer, in_recorder_info );
+    }
+  }
+
+  return( ! io_coalescer->has_failed );
+}
+
+CPC_BOOL
+cahal_coalescer_flush (
+                       cahal_coalescer*     io_coalescer,
+                       cahal_recorder_info* in_recorder_info
+                       )
+{
+  if( ! io_coalescer->has_failed && 0 < io_coalescer->fill )
+  {
+    cahal_coalescer_call( io_coalescer, in_recorder_info );
+  }
+
+  return( ! io_coalescer->has_failed );
+}
+
+CPC_BOOL
+cahal_attach_recording_coalescer  (
+                                   cahal_recorder_info*  io_recorder_info,
+                                   UINT32                in_buffer_size
+                                   )
+{
+  cahal_coalesce_options options;
+
+  if( ! cahal_get_coalesce_options( &options ) )
+  {
+    return( CPC_TRUE );
+  }
+
+  io_recorder_info->coalescer =
+    cahal_coalescer_create( &options, io_recorder_info, in_buffer_size );
+
+  return( NULL != io_recorder_info->coalescer );
+}
+
+void
+cahal_detach_recording_coalescer  (
+                                   cahal_recorder_info* io_recorder_info
+                                   )
+{
+  if( NULL != io_recorder_info->coalescer )
+  {
+    cahal_coalescer_flush( io_recorder_info->coalescer, io_recorder_info );
+
+    cahal_coalescer_free( io_recorder_info->coalescer );
+
+    io_recorder_info->coalescer = NULL;
+  }
+}
+
+static
+CPC_BOOL
+cahal_coalescer_call  (
+                       cahal_coalescer*     io_coalescer,
+                       cahal_recorder_info* in_recorder_info
+                       )
+{
+  CPC_BOOL return_value =
+    in_recorder_info->recording_callback  (
+                                           in_recorder_info->recording_device,
+                                           io_coalescer->buffer,
+                                           io_coalescer->fill,
+                                           in_recorder_info->user_data
+                                           );
+
+  io_coalescer->fill = 0;
+
+  if( ! return_value )
+  {
+    io_coalescer->has_failed = CPC_TRUE;
+  }
+
+  return( return_value );
+}
@@ -6,6 +6,81 @@
 
 cahal_device** g_device_list    = NULL;
 
+CPC_BOOL g_cahal_lazy_device_details = CPC_FALSE;
+
+/*! \fn     SIZE cahal_get_packed_list_size  (
+              void** in_list,
+              SIZE   in_element_size
+            )
+    \brief  Returns the number of arena bytes taken up by a copy of the
+            null-terminated list in_list and its elements.
+
+    \param  in_list The list to measure. May be NULL.
+    \param  in_element_size The size of each element of in_list.
+    \return The number of bytes.
+ */
+static
+SIZE
+cahal_get_packed_list_size  (
+                             void** in_list,
+                             SIZE   in_element_size
+                             );
+
+/*! \fn     SIZE cahal_get_packed_string_size  (
+              const CHAR* in_string
+            )
+    \brief  Returns the number of arena bytes taken up by a copy of in_string,
+            assuming it has not been interned before.
+
+    \param  in_string The string to measure. May be NULL.
+    \return The number of bytes.
+ */
+static
+SIZE
+cahal_get_packed_string_size  (
+                               const CHAR* in_string
+                               );
+
+/*! \fn     CPC_BOOL cahal_pack_list (
+              cahal_arena*  io_arena,
+              void**        in_list,
+              SIZE          in_element_size,
+              void***       out_list
+            )
+    \brief  Copies the null-terminated list in_list, and a shallow copy of
+            each of its elements, into io_arena. The elements are stored
+            contiguously after the list.
+
+    \param  io_arena  The arena to copy into.
+    \param  in_list The list to copy. May be NULL.
+    \param  in_element_size The size of each element of in_list.
+    \param  out_list  The copy, or NULL if in_list is NULL.
+    \return True iff the list was copied.
+ */
+static
+CPC_BOOL
+cahal_pack_list (
+                 cahal_arena*  io_arena,
+                 void**        in_list,
+                 SIZE          in_element_size,
+                 void***       out_list
+                 );
+
+/*! \fn     CPC_BOOL cahal_call_device_details_loader  (
+              void* io_device
+            )
+    \brief  The cahal_once_routine of cahal_load_device_details. Calls the
+            details_loader of io_device.
+
+    \param  io_device The cahal_device whose details are to be loaded.
+    \return True iff every detail was loaded.
+ */
+static
+CPC_BOOL
+cahal_call_device_details_loader  (
+                                   void* io_device
+                                   );
+
 void
 cahal_print_device_list (
                          cahal_device** in_device_list
@@ -135,75 +210,317 @@ cahal_print_device  (
           );
 }
 
-void
-cahal_free_device_list( void )
+cahal_device**
+cahal_pack_device_list (
+                        cahal_device** in_device_list,
+                        cahal_arena**  out_arena
+                        )
 {
-  if( NULL != g_device_list )
+  cahal_device** device_list  = NULL;
+  cahal_arena* arena          = NULL;
+  CPC_BOOL packed             = CPC_TRUE;
+  SIZE size                   = 0;
+  UINT32 number_of_devices    = 0;
+
+  *out_arena = NULL;
+
+  if( NULL == in_device_list )
   {
-    UINT32 device_index   = 0;
-    cahal_device* device  = g_device_list[ 0 ];
-    
-    while( NULL != device )
+    return( NULL );
+  }
+
+  size =
+    cahal_get_packed_list_size  (
+                                 ( void** ) in_device_list,
+                                 sizeof( cahal_device )
+                                 );
+
+  for( ; NULL != in_device_list[ number_of_devices ]; number_of_devices++ )
+  {
+    cahal_device* device = in_device_list[ number_of_devices ];
+
+    size +=
+      cahal_get_packed_list_size  (
+                                   ( void** ) device->supported_sample_rates,
+                                   sizeof( cahal_sample_rate_range )
+                                   )
+      + cahal_get_packed_list_size  (
+                                     ( void** ) device->device_streams,
+                                     sizeof( cahal_device_stream )
+                                     )
+      + cahal_get_packed_string_size( device->device_name )
+      + cahal_get_packed_string_size( device->model )
+      + cahal_get_packed_string_size( device->manufacturer )
+      + cahal_get_packed_string_size( device->serial_number )
+      + cahal_get_packed_string_size( device->version )
+      + cahal_get_packed_string_size( device->device_uid )
+      + cahal_get_packed_string_size( device->model_uid );
+
+    for (
+         UINT32 i = 0;
+         NULL != device->device_streams && NULL != device->device_streams[ i ];
+         i++
+         )
     {
-      CPC_LOG_BUFFER  (
-                       CPC_LOG_LEVEL_TRACE,
-                       "device",
-                       ( UCHAR* ) device,
-                       sizeof( cahal_device ),
-                       8
+      size +=
+        cahal_get_packed_list_size  (
+                  ( void** ) device->device_streams[ i ]->supported_formats,
+                  sizeof( cahal_audio_format_description )
+                                     );
+    }
+  }
+
+  arena = cahal_arena_create( size );
+
+  if( NULL == arena )
+  {
+    CPC_ERROR (
+               "Could not create arena for %lu bytes.",
+               ( unsigned long ) size
+               );
+
+    return( in_device_list );
+  }
+
+  //  Devices first, then the streams and formats of each device, then the
+  //  strings, so that scanning devices and their formats touches as few cache
+  //  lines as possible.
+  packed =
+    cahal_pack_list (
+                     arena,
+                     ( void** ) in_device_list,
+                     sizeof( cahal_device ),
+                     ( void*** ) &device_list
+                     );
+
+  for( UINT32 i = 0; packed && i < number_of_devices; i++ )
+  {
+    cahal_device* device = device_list[ i ];
+
+    packed =
+      cahal_pack_list (
+                       arena,
+                       ( void** ) in_device_list[ i ]->device_streams,
+                       sizeof( cahal_device_stream ),
+                       ( void*** ) &( device->device_streams )
                        );
-      
-      cpc_safe_free( ( void** ) &( device->device_name ) );
-      cpc_safe_free( ( void** ) &( device->model ) );
-      cpc_safe_free( ( void** ) &( device->manufacturer ) );
-      cpc_safe_free( ( void** ) &( device->serial_number ) );
-      cpc_safe_free( ( void** ) &( device->version ) );
-      cpc_safe_free( ( void** ) &( device->device_uid ) );
-      cpc_safe_free( ( void** ) &( device->model_uid ) );
-      
-      
-      if( NULL != device->supported_sample_rates )
+
+    for (
+         UINT32 j = 0;
+         packed
+         && NULL != device->device_streams
+         && NULL != device->device_streams[ j ];
+         j++
+         )
+    {
+      cahal_device_stream* stream = device->device_streams[ j ];
+
+      packed =
+        cahal_pack_list (
+                         arena,
+                         ( void** ) stream->supported_formats,
+                         sizeof( cahal_audio_format_description ),
+                         ( void*** ) &( stream->supported_formats )
+                         );
+    }
+
+    packed =
+      packed
+      && cahal_pack_list  (
+                           arena,
+                           ( void** ) device->supported_sample_rates,
+                           sizeof( cahal_sample_rate_range ),
+                           ( void*** ) &( device->supported_sample_rates )
+                           );
+  }
+
+  for( UINT32 i = 0; packed && i < number_of_devices; i++ )
+  {
+    cahal_device* device  = device_list[ i ];
+    CHAR** strings[]      =
+    {
+      &( device->device_name ), &( device->model ), &( device->manufacturer ),
+      &( device->serial_number ), &( device->version ),
+      &( device->device_uid ), &( device->model_uid )
+    };
+
+    for( UINT32 j = 0; packed && j < sizeof( strings ) / sizeof( CHAR** ); j++ )
+    {
+      if( NULL != *strings[ j ] )
       {
-        UINT32 index                          = 0;
-        cahal_sample_rate_range* sample_rate  =
-        device->supported_sample_rates[ index++ ];
-        
-        while( NULL != sample_rate )
-        {
-          cpc_safe_free( ( void** ) &( sample_rate ) );
-          
-          sample_rate = device->supported_sample_rates[ index++ ];
-        }
-        
-        cpc_safe_free( ( void** ) &( device->supported_sample_rates ) );
+        *strings[ j ] = cahal_arena_intern( arena, *strings[ j ] );
+
+        packed = ( NULL != *strings[ j ] );
       }
+    }
+
+    //  Details that are loaded from now on are allocated outside the arena
+    //  and freed by cahal_free_device_details; those loaded so far are not.
+    if( CAHAL_ONCE_PENDING != device->details_state )
+    {
+      device->details_loader = NULL;
+    }
+  }
+
+  if( ! packed )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not pack device list." );
+
+    cahal_arena_free( arena );
+
+    return( in_device_list );
+  }
+
+  CPC_LOG (
+           CPC_LOG_LEVEL_DEBUG,
+           "Packed %d devices into %d bytes in %d block(s), %d strings "
+           "interned as %d.",
+           number_of_devices,
+           ( UINT32 ) arena->bytes_used,
+           arena->number_of_blocks,
+           arena->number_of_interned,
+           arena->number_of_strings
+           );
+
+  for( UINT32 i = 0; i < number_of_devices; i++ )
+  {
+    cahal_free_device( in_device_list[ i ] );
+  }
+
+  cpc_safe_free( ( void** ) &in_device_list );
+
+  *out_arena = arena;
+
+  return( device_list );
+}
+
+void
+cahal_free_device (
+                   cahal_device* in_device
+                   )
+{
+  if( NULL != in_device )
+  {
+    CPC_LOG_BUFFER  (
+                     CPC_LOG_LEVEL_TRACE,
+                     "device",
+                     ( UCHAR* ) in_device,
+                     sizeof( cahal_device ),
+                     8
+                     );
+    
+    cpc_safe_free( ( void** ) &( in_device->device_name ) );
+    cpc_safe_free( ( void** ) &( in_device->model ) );
+    cpc_safe_free( ( void** ) &( in_device->manufacturer ) );
+    cpc_safe_free( ( void** ) &( in_device->serial_number ) );
+    cpc_safe_free( ( void** ) &( in_device->version ) );
+    cpc_safe_free( ( void** ) &( in_device->device_uid ) );
+    cpc_safe_free( ( void** ) &( in_device->model_uid ) );
+    
+    if( NULL != in_device->supported_sample_rates )
+    {
+      UINT32 index                          = 0;
+      cahal_sample_rate_range* sample_rate  =
+      in_device->supported_sample_rates[ index++ ];
       
-      if( NULL != device->device_streams )
+      while( NULL != sample_rate )
       {
-        cahal_free_device_stream_list( device->device_streams );
+        cpc_safe_free( ( void** ) &( sample_rate ) );
         
-        cpc_safe_free( ( void** ) &( device->device_streams ) );
+        sample_rate = in_device->supported_sample_rates[ index++ ];
       }
       
-      CPC_LOG_BUFFER  (
-                       CPC_LOG_LEVEL_TRACE, "device",
-                       ( UCHAR* ) device,
-                       sizeof( cahal_device ),
-                       8
-                       );
-      
-      cpc_safe_free( ( void** ) &( device ) );
-      
-      device_index++;
+      cpc_safe_free( ( void** ) &( in_device->supported_sample_rates ) );
+    }
+    
+    if( NULL != in_device->device_streams )
+    {
+      cahal_free_device_stream_list( in_device->device_streams );
       
-      device = g_device_list[ device_index ];
+      cpc_safe_free( ( void** ) &( in_device->device_streams ) );
     }
     
-    cpc_safe_free( ( void** ) ( &g_device_list ) );
+    cpc_safe_free( ( void** ) &( in_device ) );
   }
-  else
+}
+
+void
+cahal_set_lazy_device_details (
+                               CPC_BOOL in_lazy
+                               )
+{
+  g_cahal_lazy_device_details = in_lazy;
+
+  CPC_LOG (
+           CPC_LOG_LEVEL_INFO,
+           "Device details are loaded %s.",
+           in_lazy ? "lazily" : "eagerly"
+           );
+}
+
+CPC_BOOL
+cahal_load_device_details  (
+                            cahal_device* io_device
+                            )
+{
+  if( NULL == io_device )
+  {
+    return( CPC_FALSE );
+  }
+
+  return  (
+           cahal_call_once  (
+                             &( io_device->details_state ),
+                             cahal_call_device_details_loader,
+                             io_device
+                             )
+           );
+}
+
+void
+cahal_free_device_details  (
+                            cahal_device* io_device
+                            )
+{
+  if  (
+       NULL == io_device
+       || NULL == io_device->details_loader
+       || CAHAL_ONCE_PENDING == io_device->details_state
+       )
+  {
+    return;
+  }
+
+  cpc_safe_free( ( void** ) &( io_device->model ) );
+  cpc_safe_free( ( void** ) &( io_device->manufacturer ) );
+  cpc_safe_free( ( void** ) &( io_device->serial_number ) );
+  cpc_safe_free( ( void** ) &( io_device->version ) );
+  cpc_safe_free( ( void** ) &( io_device->model_uid ) );
+
+  for  (
+        UINT32 i = 0;
+        NULL != io_device->supported_sample_rates
+        && NULL != io_device->supported_sample_rates[ i ];
+        i++
+        )
+  {
+    cpc_safe_free( ( void** ) &( io_device->supported_sample_rates[ i ] ) );
+  }
+
+  cpc_safe_free( ( void** ) &( io_device->supported_sample_rates ) );
+
+  for  (
+        UINT32 i = 0;
+        NULL != io_device->device_streams
+        && NULL != io_device->device_streams[ i ];
+        i++
+        )
   {
-    CPC_LOG_STRING( CPC_LOG_LEVEL_WARN, "CAHAL device list is not set." );
+    cahal_free_audio_format_description_list  (
+                            io_device->device_streams[ i ]->supported_formats
+                                               );
+
+    io_device->device_streams[ i ]->supported_formats = NULL;
   }
 }
 
@@ -245,3 +562,177 @@ cahal_test_device_direction_support  (
   
   return( result );
 }
+
+CPC_BOOL
+cahal_get_stream_channel_layout  (
+                           cahal_device*                 in_device,
+                           cahal_device_stream_direction in_direction,
+                           UINT32                        in_number_of_channels,
+                           cahal_channel_layout*         out_channel_layout
+                                  )
+{
+  if  (
+       ! cahal_get_default_channel_layout (
+                                           in_number_of_channels,
+                                           out_channel_layout
+                                           )
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  if  (
+       NULL == in_device
+       || ! cahal_load_device_details( in_device )
+       || NULL == in_device->device_streams
+       )
+  {
+    return( CPC_TRUE );
+  }
+
+  for  (
+        UINT32 i = 0;
+        NULL != in_device->device_streams[ i ];
+        i++
+        )
+  {
+    cahal_device_stream* stream = in_device->device_streams[ i ];
+
+    if  (
+         in_direction != stream->direction
+         || NULL == stream->supported_formats
+         )
+    {
+      continue;
+    }
+
+    for( UINT32 j = 0; NULL != stream->supported_formats[ j ]; j++ )
+    {
+      cahal_audio_format_description* format = stream->supported_formats[ j ];
+
+      if  (
+           in_number_of_channels == format->number_of_channels
+           && CAHAL_CHANNEL_LAYOUT_UNSPECIFIED
+              != format->channel_layout.layout_type
+           && cahal_test_channel_layout  (
+                                          &( format->channel_layout ),
+                                          in_number_of_channels
+                                          )
+           )
+      {
+        *out_channel_layout = format->channel_layout;
+
+        return( CPC_TRUE );
+      }
+    }
+  }
+
+  return( CPC_TRUE );
+}
+
+static
+SIZE
+cahal_get_packed_list_size  (
+                             void** in_list,
+                             SIZE   in_element_size
+                             )
+{
+  SIZE size = 0;
+
+  if( NULL != in_list )
+  {
+    UINT32 length = 0;
+
+    while( NULL != in_list[ length ] )
+    {
+      length++;
+    }
+
+    size =
+      CAHAL_ARENA_ROUND( sizeof( void* ) * ( length + 1 ) )
+      + CAHAL_ARENA_ROUND( in_element_size ) * length;
+  }
+
+  return( size );
+}
+
+static
+SIZE
+cahal_get_packed_string_size  (
+                               const CHAR* in_string
+                               )
+{
+  return  (
+           NULL == in_string ? 0 : CAHAL_ARENA_ROUND( strlen( in_string ) + 1 )
+           );
+}
+
+static
+CPC_BOOL
+cahal_pack_list (
+                 cahal_arena*  io_arena,
+                 void**        in_list,
+                 SIZE          in_element_size,
+                 void***       out_list
+                 )
+{
+  void** list   = NULL;
+  UINT32 length = 0;
+
+  *out_list = NULL;
+
+  if( NULL == in_list )
+  {
+    return( CPC_TRUE );
+  }
+
+  while( NULL != in_list[ length ] )
+  {
+    length++;
+  }
+
+  list  =
+    ( void** ) cahal_arena_allocate (
+                                     io_arena,
+                                     sizeof( void* ) * ( length + 1 )
+                                     );
+
+  if( NULL == list )
+  {
+    return( CPC_FALSE );
+  }
+
+  for( UINT32 i = 0; i < length; i++ )
+  {
+    list[ i ] = cahal_arena_allocate( io_arena, in_element_size );
+
+    if( NULL == list[ i ] )
+    {
+      return( CPC_FALSE );
+    }
+
+    memcpy( list[ i ], in_list[ i ], in_element_size );
+  }
+
+  *out_list = list;
+
+  return( CPC_TRUE );
+}
+
+static
+CPC_BOOL
+cahal_call_device_details_loader  (
+                                   void* io_device
+                                   )
+{
+  cahal_device* device  = ( cahal_device* ) io_device;
+  CPC_BOOL result       =
+    NULL != device->details_loader && device->details_loader( device );
+
+  if( ! result )
+  {
+    CPC_ERROR( "Could not load the details of device 0x%x.", device->handle );
+  }
+
+  return( result );
+}
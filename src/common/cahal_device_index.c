@@ -0,0 +1,613 @@
+/*! \file   cahal_device_index.c
+
+    \author Brent Carrara
+ */
+#include "cahal_device_index.h"
+
+/*! \var    cahal_device_index_keys
+    \brief  The strings the tables of an index are keyed by.
+ */
+enum cahal_device_index_keys
+{
+  CAHAL_DEVICE_INDEX_UID = 0,
+  CAHAL_DEVICE_INDEX_NAME,
+  CAHAL_DEVICE_INDEX_KEY
+};
+
+/*! \fn     UINT32 cahal_hash_device_string  (
+              const CHAR* in_string
+            )
+    \brief  Returns the 32-bit FNV-1a hash of in_string.
+
+    \param  in_string The string to hash.
+    \return The hash.
+ */
+static
+UINT32
+cahal_hash_device_string  (
+                           const CHAR* in_string
+                           );
+
+/*! \fn     void cahal_insert_device  (
+              UINT32*       io_buckets,
+              UINT32        in_number_of_buckets,
+              cahal_device** in_devices,
+              UINT32        in_device_index,
+              UINT32        in_key
+            )
+    \brief  Adds device in_device_index to a table unless a previous device
+            has the same key.
+
+    \param  io_buckets  The table.
+    \param  in_number_of_buckets  The number of slots in io_buckets.
+    \param  in_devices  The indexed devices.
+    \param  in_device_index The index of the device in in_devices.
+    \param  in_key  The cahal_device_index_keys value the table is keyed by.
+                    Nothing is added if the device has no such key.
+ */
+static
+void
+cahal_insert_device  (
+                      UINT32*         io_buckets,
+                      UINT32          in_number_of_buckets,
+                      cahal_device**  in_devices,
+                      UINT32          in_device_index,
+                      UINT32          in_key
+                      );
+
+/*! \fn     cahal_device* cahal_lookup_device  (
+              cahal_device_snapshot*  in_snapshot,
+              UINT32*                 in_buckets,
+              const CHAR*             in_string,
+              UINT32                  in_key
+            )
+    \brief  Looks in_string up in one of the tables of the index of
+            in_snapshot.
+
+    \param  in_snapshot The indexed snapshot. May be NULL.
+    \param  in_buckets  The table.
+    \param  in_string The string to look up. May be NULL.
+    \param  in_key  The cahal_device_index_keys value the table is keyed by.
+    \return The device or NULL if there is none.
+ */
+static
+cahal_device*
+cahal_lookup_device  (
+                      cahal_device_snapshot*  in_snapshot,
+                      UINT32*                 in_buckets,
+                      const CHAR*             in_string,
+                      UINT32                  in_key
+                      );
+
+/*! \fn     const CHAR* cahal_get_device_index_key  (
+              cahal_device* in_device,
+              UINT32        in_key
+            )
+    \brief  Returns the key of in_device. CAHAL_DEVICE_INDEX_KEY is the UID of
+            the device, or its name if it has no UID.
+
+    \param  in_device The device.
+    \param  in_key  The cahal_device_index_keys value to return.
+    \return The key. May be NULL.
+ */
+static
+const CHAR*
+cahal_get_device_index_key  (
+                             cahal_device* in_device,
+                             UINT32        in_key
+                             );
+
+/*! \fn     cahal_device_capability cahal_get_capabilities  (
+              cahal_device*                 in_device,
+              cahal_device_stream_direction in_direction,
+              CPC_BOOL*                     out_has_stream
+            )
+    \brief  Works out the capabilities of the streams of in_device in
+            in_direction.
+
+    \param  in_device The device.
+    \param  in_direction  The direction.
+    \param  out_has_stream  Set to true iff in_device has a stream in
+                            in_direction.
+    \return The bitmask of cahal_device_capabilities.
+ */
+static
+cahal_device_capability
+cahal_get_capabilities  (
+                         cahal_device*                 in_device,
+                         cahal_device_stream_direction in_direction,
+                         CPC_BOOL*                     out_has_stream
+                         );
+
+/*! \fn     void cahal_list_devices  (
+              cahal_device_index*     io_index,
+              cahal_device_snapshot*  in_snapshot,
+              cahal_device_capability in_first_set,
+              cahal_device_capability in_end_set
+            )
+    \brief  Fills in the device lists of the capability sets in_first_set up
+            to, but not including, in_end_set for both directions, and the
+            default devices if in_first_set is CAHAL_DEVICE_CAPABILITY_NONE.
+
+    \param  io_index  The index to fill in.
+    \param  in_snapshot The snapshot being indexed.
+    \param  in_first_set  The first capability set to list.
+    \param  in_end_set  One past the last capability set to list.
+ */
+static
+void
+cahal_list_devices  (
+                     cahal_device_index*     io_index,
+                     cahal_device_snapshot*  in_snapshot,
+                     cahal_device_capability in_first_set,
+                     cahal_device_capability in_end_set
+                     );
+
+cahal_device_index*
+cahal_create_device_index  (
+                            cahal_device_snapshot* in_snapshot
+                            )
+{
+  cahal_device_index* index             = NULL;
+  cahal_device** storage                = NULL;
+  UINT32 number_of_devices              = 0;
+  UINT32 number_of_lists                =
+    CAHAL_DEVICE_DIRECTIONS * CAHAL_DEVICE_CAPABILITY_SETS;
+
+  if( NULL == in_snapshot )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid snapshot." );
+
+    return( NULL );
+  }
+
+  number_of_devices = in_snapshot->number_of_devices;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &index, sizeof( cahal_device_index ) )
+       )
+  {
+    CPC_ERROR (
+               "Could not malloc device index: %lu.",
+               ( unsigned long ) sizeof( cahal_device_index )
+               );
+
+    return( NULL );
+  }
+
+  index->number_of_buckets = 4;
+
+  while( index->number_of_buckets < number_of_devices * 2 )
+  {
+    index->number_of_buckets *= 2;
+  }
+
+  //  Every list is null-terminated and can hold every device, and all of
+  //  them share one allocation.
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &( index->uid_buckets ),
+                            sizeof( UINT32 ) * index->number_of_buckets
+                            )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( index->name_buckets ),
+                               sizeof( UINT32 ) * index->number_of_buckets
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( index->key_buckets ),
+                               sizeof( UINT32 ) * index->number_of_buckets
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( index->device_lists ),
+                               sizeof( cahal_device** ) * number_of_lists
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &storage,
+                               sizeof( cahal_device* )
+                               * number_of_lists * ( number_of_devices + 1 )
+                               )
+       )
+  {
+    CPC_ERROR( "Could not malloc device index tables: 0x%x.",
+               number_of_devices );
+
+    cahal_free_device_index( index );
+
+    return( NULL );
+  }
+
+  for( UINT32 i = 0; i < number_of_lists; i++ )
+  {
+    index->device_lists[ i ] = &( storage[ i * ( number_of_devices + 1 ) ] );
+  }
+
+  for( UINT32 i = 0; i < number_of_devices; i++ )
+  {
+    cahal_insert_device (
+                         index->uid_buckets,
+                         index->number_of_buckets,
+                         in_snapshot->devices,
+                         i,
+                         CAHAL_DEVICE_INDEX_UID
+                         );
+    cahal_insert_device (
+                         index->name_buckets,
+                         index->number_of_buckets,
+                         in_snapshot->devices,
+                         i,
+                         CAHAL_DEVICE_INDEX_NAME
+                         );
+    cahal_insert_device (
+                         index->key_buckets,
+                         index->number_of_buckets,
+                         in_snapshot->devices,
+                         i,
+                         CAHAL_DEVICE_INDEX_KEY
+                         );
+  }
+
+  //  Without the details of every device only the directions are known.
+  cahal_list_devices  (
+                       index,
+                       in_snapshot,
+                       CAHAL_DEVICE_CAPABILITY_NONE,
+                       CAHAL_ONCE_DONE == in_snapshot->details_state
+                       ? CAHAL_DEVICE_CAPABILITY_SETS : 1
+                       );
+
+  return( index );
+}
+
+void
+cahal_index_device_capabilities (
+                                 cahal_device_snapshot* io_snapshot
+                                 )
+{
+  if( NULL != io_snapshot && NULL != io_snapshot->device_index )
+  {
+    cahal_list_devices  (
+                         io_snapshot->device_index,
+                         io_snapshot,
+                         CAHAL_DEVICE_CAPABILITY_NONE + 1,
+                         CAHAL_DEVICE_CAPABILITY_SETS
+                         );
+  }
+}
+
+cahal_device*
+cahal_find_device_by_uid  (
+                           cahal_device_snapshot*  in_snapshot,
+                           const CHAR*             in_device_uid
+                           )
+{
+  return  (
+           cahal_lookup_device  (
+                 in_snapshot,
+                 NULL == in_snapshot || NULL == in_snapshot->device_index
+                 ? NULL : in_snapshot->device_index->uid_buckets,
+                 in_device_uid,
+                 CAHAL_DEVICE_INDEX_UID
+                                 )
+           );
+}
+
+cahal_device*
+cahal_find_device_by_name  (
+                            cahal_device_snapshot*  in_snapshot,
+                            const CHAR*             in_device_name
+                            )
+{
+  return  (
+           cahal_lookup_device  (
+                 in_snapshot,
+                 NULL == in_snapshot || NULL == in_snapshot->device_index
+                 ? NULL : in_snapshot->device_index->name_buckets,
+                 in_device_name,
+                 CAHAL_DEVICE_INDEX_NAME
+                                 )
+           );
+}
+
+cahal_device*
+cahal_find_device_by_key  (
+                           cahal_device_snapshot*  in_snapshot,
+                           const CHAR*             in_key
+                           )
+{
+  return  (
+           cahal_lookup_device  (
+                 in_snapshot,
+                 NULL == in_snapshot || NULL == in_snapshot->device_index
+                 ? NULL : in_snapshot->device_index->key_buckets,
+                 in_key,
+                 CAHAL_DEVICE_INDEX_KEY
+                                 )
+           );
+}
+
+cahal_device*
+cahal_find_default_device  (
+                            cahal_device_snapshot*        in_snapshot,
+                            cahal_device_stream_direction in_direction
+                            )
+{
+  if  (
+       NULL == in_snapshot
+       || NULL == in_snapshot->device_index
+       || CAHAL_DEVICE_DIRECTIONS <= in_direction
+       )
+  {
+    return( NULL );
+  }
+
+  return( in_snapshot->device_index->default_devices[ in_direction ] );
+}
+
+cahal_device**
+cahal_find_devices  (
+                     cahal_device_snapshot*        in_snapshot,
+                     cahal_device_stream_direction in_direction,
+                     cahal_device_capability       in_capabilities
+                     )
+{
+  if  (
+       NULL == in_snapshot
+       || NULL == in_snapshot->device_index
+       || CAHAL_DEVICE_DIRECTIONS <= in_direction
+       || CAHAL_DEVICE_CAPABILITY_SETS <= in_capabilities
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid parameters." );
+
+    return( NULL );
+  }
+
+  if( CAHAL_DEVICE_CAPABILITY_NONE != in_capabilities )
+  {
+    cahal_load_device_snapshot_details( in_snapshot );
+  }
+
+  return  (
+           in_snapshot->device_index->device_lists[
+             in_direction * CAHAL_DEVICE_CAPABILITY_SETS + in_capabilities
+                                                    ]
+           );
+}
+
+void
+cahal_free_device_index  (
+                          cahal_device_index* in_index
+                          )
+{
+  if( NULL != in_index )
+  {
+    if( NULL != in_index->device_lists )
+    {
+      cpc_safe_free( ( void** ) &( in_index->device_lists[ 0 ] ) );
+    }
+
+    cpc_safe_free( ( void** ) &( in_index->device_lists ) );
+    cpc_safe_free( ( void** ) &( in_index->uid_buckets ) );
+    cpc_safe_free( ( void** ) &( in_index->name_buckets ) );
+    cpc_safe_free( ( void** ) &( in_index->key_buckets ) );
+    cpc_safe_free( ( void** ) &in_index );
+  }
+}
+
+static
+UINT32
+cahal_hash_device_string  (
+                           const CHAR* in_string
+                           )
+{
+  UINT32 hash = 2166136261U;
+
+  while( 0 != *in_string )
+  {
+    hash ^= ( UCHAR ) *in_string++;
+    hash *= 16777619U;
+  }
+
+  return( hash );
+}
+
+static
+void
+cahal_insert_device  (
+                      UINT32*         io_buckets,
+                      UINT32          in_number_of_buckets,
+                      cahal_device**  in_devices,
+                      UINT32          in_device_index,
+                      UINT32          in_key
+                      )
+{
+  UINT32 mask         = in_number_of_buckets - 1;
+  UINT32 slot         = 0;
+  const CHAR* string  =
+    cahal_get_device_index_key( in_devices[ in_device_index ], in_key );
+
+  if( NULL == string )
+  {
+    return;
+  }
+
+  slot = cahal_hash_device_string( string ) & mask;
+
+  while( 0 != io_buckets[ slot ] )
+  {
+    const CHAR* key =
+      cahal_get_device_index_key  (
+                                   in_devices[ io_buckets[ slot ] - 1 ],
+                                   in_key
+                                   );
+
+    if( 0 == strcmp( key, string ) )
+    {
+      return;
+    }
+
+    slot = ( slot + 1 ) & mask;
+  }
+
+  io_buckets[ slot ] = in_device_index + 1;
+}
+
+static
+cahal_device*
+cahal_lookup_device  (
+                      cahal_device_snapshot*  in_snapshot,
+                      UINT32*                 in_buckets,
+                      const CHAR*             in_string,
+                      UINT32                  in_key
+                      )
+{
+  if( NULL == in_buckets || NULL == in_string )
+  {
+    return( NULL );
+  }
+
+  UINT32 mask = in_snapshot->device_index->number_of_buckets - 1;
+  UINT32 slot = cahal_hash_device_string( in_string ) & mask;
+
+  while( 0 != in_buckets[ slot ] )
+  {
+    cahal_device* device = in_snapshot->devices[ in_buckets[ slot ] - 1 ];
+
+    if( 0 == strcmp( cahal_get_device_index_key( device, in_key ), in_string ) )
+    {
+      return( device );
+    }
+
+    slot = ( slot + 1 ) & mask;
+  }
+
+  return( NULL );
+}
+
+static
+const CHAR*
+cahal_get_device_index_key  (
+                             cahal_device* in_device,
+                             UINT32        in_key
+                             )
+{
+  switch( in_key )
+  {
+    case CAHAL_DEVICE_INDEX_UID:
+      return( in_device->device_uid );
+    case CAHAL_DEVICE_INDEX_NAME:
+      return( in_device->device_name );
+    default:
+      return  (
+               NULL != in_device->device_uid
+               ? in_device->device_uid
+               : in_device->device_name
+               );
+  }
+}
+
+static
+cahal_device_capability
+cahal_get_capabilities  (
+                         cahal_device*                 in_device,
+                         cahal_device_stream_direction in_direction,
+                         CPC_BOOL*                     out_has_stream
+                         )
+{
+  cahal_device_capability capabilities  = CAHAL_DEVICE_CAPABILITY_NONE;
+  cahal_device_stream** streams         = in_device->device_streams;
+
+  *out_has_stream = CPC_FALSE;
+
+  for( UINT32 i = 0; NULL != streams && NULL != streams[ i ]; i++ )
+  {
+    cahal_audio_format_description** formats = streams[ i ]->supported_formats;
+
+    if( in_direction != streams[ i ]->direction )
+    {
+      continue;
+    }
+
+    *out_has_stream = CPC_TRUE;
+
+    for( UINT32 j = 0; NULL != formats && NULL != formats[ j ]; j++ )
+    {
+      if( CAHAL_AUDIO_FORMAT_LINEARPCM == formats[ j ]->format_id )
+      {
+        capabilities |= CAHAL_DEVICE_CAPABILITY_LINEAR_PCM;
+      }
+
+      if( 2 < formats[ j ]->number_of_channels )
+      {
+        capabilities |= CAHAL_DEVICE_CAPABILITY_MULTICHANNEL;
+      }
+
+      if( 16 < formats[ j ]->bit_depth )
+      {
+        capabilities |= CAHAL_DEVICE_CAPABILITY_HIGH_RESOLUTION;
+      }
+
+      if  (
+           CAHAL_DEVICE_HIGH_SAMPLE_RATE
+           < formats[ j ]->sample_rate_range.maximum_rate
+           )
+      {
+        capabilities |= CAHAL_DEVICE_CAPABILITY_HIGH_SAMPLE_RATE;
+      }
+    }
+  }
+
+  return( capabilities );
+}
+
+static
+void
+cahal_list_devices  (
+                     cahal_device_index*     io_index,
+                     cahal_device_snapshot*  in_snapshot,
+                     cahal_device_capability in_first_set,
+                     cahal_device_capability in_end_set
+                     )
+{
+  for( UINT32 direction = 0; direction < CAHAL_DEVICE_DIRECTIONS; direction++ )
+  {
+    UINT32 lengths[ CAHAL_DEVICE_CAPABILITY_SETS ] = { 0 };
+    cahal_device*** lists                           =
+      &( io_index->device_lists[ direction * CAHAL_DEVICE_CAPABILITY_SETS ] );
+
+    for( UINT32 i = 0; i < in_snapshot->number_of_devices; i++ )
+    {
+      cahal_device* device  = in_snapshot->devices[ i ];
+      CPC_BOOL has_stream   = CPC_FALSE;
+      cahal_device_capability device_capabilities =
+        cahal_get_capabilities( device, direction, &has_stream );
+
+      if( ! has_stream )
+      {
+        continue;
+      }
+
+      if  (
+           CAHAL_DEVICE_CAPABILITY_NONE == in_first_set
+           && NULL == io_index->default_devices[ direction ]
+           )
+      {
+        io_index->default_devices[ direction ] = device;
+      }
+
+      for( UINT32 set = in_first_set; set < in_end_set; set++ )
+      {
+        if( set == ( set & device_capabilities ) )
+        {
+          lists[ set ][ lengths[ set ]++ ] = device;
+        }
+      }
+    }
+  }
+}
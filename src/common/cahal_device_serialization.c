@@ -0,0 +1,2459 @@
+/*! \file   cahal_device_serialization.c
+
+    \author Brent Carrara
+ */
+#include "cahal_device_serialization.h"
+#include "cahal_device_snapshot.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*! \def    CAHAL_DEVICE_LIST_NULL_STRING
+    \brief  The length stored in a binary file for a NULL string.
+ */
+#define CAHAL_DEVICE_LIST_NULL_STRING     0xFFFFFFFF
+
+/*! \def    CAHAL_DEVICE_LIST_MAXIMUM_DEPTH
+    \brief  The deepest nesting of JSON values accepted, including the values
+            of unknown members that are skipped.
+ */
+#define CAHAL_DEVICE_LIST_MAXIMUM_DEPTH   64
+
+/*! \def    CAHAL_DEVICE_NUMBER_OF_STRINGS
+    \brief  The number of string members of cahal_device.
+ */
+#define CAHAL_DEVICE_NUMBER_OF_STRINGS    7
+
+/*! \def    CAHAL_DEVICE_STRING
+    \brief  The string member of in_device described by
+            g_device_strings[ in_index ].
+ */
+#define CAHAL_DEVICE_STRING( in_device, in_index )                        \
+  ( *( CHAR** ) ( ( UCHAR* ) ( in_device )                                \
+                  + g_device_strings[ in_index ].offset ) )
+
+/*! \var    cahal_device_string
+    \brief  Struct definition for the name and location of a string member of
+            cahal_device.
+ */
+typedef struct cahal_device_string_t
+{
+  /*! \var    name
+      \brief  The name of the member, which is also its JSON key.
+   */
+  const CHAR* name;
+
+  /*! \var    offset
+      \brief  The offset of the member in cahal_device.
+   */
+  SIZE        offset;
+
+} cahal_device_string;
+
+/*! \var    cahal_json_buffer
+    \brief  Struct definition for the growing buffer JSON is written to.
+ */
+typedef struct cahal_json_buffer_t
+{
+  /*! \var    data
+      \brief  The null-terminated text written so far.
+   */
+  CHAR*     data;
+
+  /*! \var    length
+      \brief  The length of data, excluding the terminator.
+   */
+  SIZE      length;
+
+  /*! \var    capacity
+      \brief  The number of bytes allocated for data.
+   */
+  SIZE      capacity;
+
+  /*! \var    failed
+      \brief  True iff an allocation failed, in which case data is
+              incomplete.
+   */
+  CPC_BOOL  failed;
+
+} cahal_json_buffer;
+
+/*! \var    cahal_json_parser
+    \brief  Struct definition for the state of the JSON parser.
+ */
+typedef struct cahal_json_parser_t
+{
+  /*! \var    cursor
+      \brief  The next character to parse.
+   */
+  const CHAR* cursor;
+
+  /*! \var    depth
+      \brief  The number of objects and arrays currently open.
+   */
+  UINT32      depth;
+
+} cahal_json_parser;
+
+/*! \def    cahal_json_member_parser
+    \brief  Parses the value of the member in_key of an object.
+
+    \param  io_parser The parser, positioned at the value.
+    \param  in_key  The key of the member.
+    \param  io_context  The context passed to cahal_json_parse_object.
+    \return True iff the value was parsed.
+ */
+typedef CPC_BOOL (*cahal_json_member_parser) (
+                                              cahal_json_parser*  io_parser,
+                                              const CHAR*         in_key,
+                                              void*               io_context
+                                              );
+
+/*! \def    cahal_json_element_parser
+    \brief  Parses an element of an array.
+
+    \param  io_parser The parser, positioned at the element.
+    \param  io_context  The context passed to cahal_json_parse_array.
+    \return True iff the element was parsed.
+ */
+typedef CPC_BOOL (*cahal_json_element_parser) (
+                                               cahal_json_parser* io_parser,
+                                               void*              io_context
+                                               );
+
+CHAR* g_device_replay_path = NULL;
+
+/*! \var    g_device_strings
+    \brief  The string members of cahal_device, in the order they are saved.
+ */
+static const cahal_device_string
+g_device_strings[ CAHAL_DEVICE_NUMBER_OF_STRINGS ] =
+{
+  { "device_name",    offsetof( cahal_device, device_name ) },
+  { "model",          offsetof( cahal_device, model ) },
+  { "manufacturer",   offsetof( cahal_device, manufacturer ) },
+  { "serial_number",  offsetof( cahal_device, serial_number ) },
+  { "version",        offsetof( cahal_device, version ) },
+  { "device_uid",     offsetof( cahal_device, device_uid ) },
+  { "model_uid",      offsetof( cahal_device, model_uid ) }
+};
+
+/*! \fn     UINT32 cahal_count_items  (
+              void** in_list
+            )
+    \brief  Returns the number of items in a null-terminated list.
+
+    \param  in_list The list. May be NULL.
+    \return The number of items.
+ */
+static
+UINT32
+cahal_count_items  (
+                    void** in_list
+                    );
+
+/*! \fn     CPC_BOOL cahal_append_item  (
+              void*** io_list,
+              void*   in_item
+            )
+    \brief  Appends in_item to a null-terminated heap list.
+
+    \param  io_list The list, which is reallocated. May point to NULL.
+    \param  in_item The item to append.
+    \return True iff in_item was appended. The caller still owns it
+            otherwise.
+ */
+static
+CPC_BOOL
+cahal_append_item  (
+                    void*** io_list,
+                    void*   in_item
+                    );
+
+/*! \fn     void cahal_free_loaded_device_list  (
+              cahal_device** in_device_list
+            )
+    \brief  Frees a heap list being loaded and all of its devices.
+
+    \param  in_device_list  The list. May be NULL.
+ */
+static
+void
+cahal_free_loaded_device_list  (
+                                cahal_device** in_device_list
+                                );
+
+/*! \fn     CPC_BOOL cahal_write_binary_device_list  (
+              FILE*          in_file,
+              cahal_device** in_device_list
+            )
+    \brief  Writes in_device_list to in_file in the binary encoding.
+
+    \param  in_file The file to write to.
+    \param  in_device_list  The list to write. May be NULL.
+    \return True iff the list was written.
+ */
+static
+CPC_BOOL
+cahal_write_binary_device_list  (
+                                 FILE*          in_file,
+                                 cahal_device** in_device_list
+                                 );
+
+/*! \fn     CPC_BOOL cahal_write_binary_string  (
+              FILE*       in_file,
+              const CHAR* in_string
+            )
+    \brief  Writes the length of in_string followed by its characters.
+
+    \param  in_file The file to write to.
+    \param  in_string The string. May be NULL.
+    \return True iff the string was written.
+ */
+static
+CPC_BOOL
+cahal_write_binary_string  (
+                            FILE*       in_file,
+                            const CHAR* in_string
+                            );
+
+/*! \fn     cahal_device** cahal_read_binary_device_list  (
+              FILE* in_file
+            )
+    \brief  Reads a list written by cahal_write_binary_device_list, after
+            its magic.
+
+    \param  in_file The file to read from.
+    \return The heap list or NULL on error.
+ */
+static
+cahal_device**
+cahal_read_binary_device_list  (
+                                FILE* in_file
+                                );
+
+/*! \fn     cahal_device* cahal_read_binary_device  (
+              FILE*   in_file,
+              UINT32  in_version
+            )
+    \brief  Reads one device written by cahal_write_binary_device_list.
+
+    \param  in_file The file to read from.
+    \param  in_version  The version of the file.
+    \return The heap device or NULL on error.
+ */
+static
+cahal_device*
+cahal_read_binary_device  (
+                           FILE*   in_file,
+                           UINT32  in_version
+                           );
+
+/*! \fn     CPC_BOOL cahal_read_binary_string  (
+              FILE*   in_file,
+              CHAR**  out_string
+            )
+    \brief  Reads a string written by cahal_write_binary_string.
+
+    \param  in_file The file to read from.
+    \param  out_string  The newly allocated string, or NULL.
+    \return True iff the string was read.
+ */
+static
+CPC_BOOL
+cahal_read_binary_string  (
+                           FILE*   in_file,
+                           CHAR**  out_string
+                           );
+
+/*! \fn     CPC_BOOL cahal_read_binary_count  (
+              FILE*   in_file,
+              UINT32* out_count
+            )
+    \brief  Reads the number of items of a list, which must not exceed
+            CAHAL_DEVICE_LIST_MAXIMUM_ITEMS.
+
+    \param  in_file The file to read from.
+    \param  out_count The number of items.
+    \return True iff a valid count was read.
+ */
+static
+CPC_BOOL
+cahal_read_binary_count  (
+                          FILE*   in_file,
+                          UINT32* out_count
+                          );
+
+/*! \fn     void cahal_json_append  (
+              cahal_json_buffer*  io_buffer,
+              const CHAR*         in_format,
+              ...
+            )
+    \brief  Appends printf style formatted text to io_buffer.
+
+    \param  io_buffer The buffer.
+    \param  in_format The format of the text.
+ */
+static
+void
+cahal_json_append  (
+                    cahal_json_buffer*  io_buffer,
+                    const CHAR*         in_format,
+                    ...
+                    );
+
+/*! \fn     void cahal_json_append_string  (
+              cahal_json_buffer*  io_buffer,
+              const CHAR*         in_string
+            )
+    \brief  Appends in_string as a quoted and escaped JSON string, or null.
+
+    \param  io_buffer The buffer.
+    \param  in_string The string. May be NULL.
+ */
+static
+void
+cahal_json_append_string  (
+                           cahal_json_buffer*  io_buffer,
+                           const CHAR*         in_string
+                           );
+
+/*! \fn     void cahal_json_append_device  (
+              cahal_json_buffer*  io_buffer,
+              cahal_device*       in_device
+            )
+    \brief  Appends in_device as a JSON object.
+
+    \param  io_buffer The buffer.
+    \param  in_device The device.
+ */
+static
+void
+cahal_json_append_device  (
+                           cahal_json_buffer*  io_buffer,
+                           cahal_device*       in_device
+                           );
+
+/*! \fn     CPC_BOOL cahal_json_consume  (
+              cahal_json_parser*  io_parser,
+              CHAR                in_character
+            )
+    \brief  Skips whitespace and then in_character if it is next.
+
+    \param  io_parser The parser.
+    \param  in_character  The character to consume.
+    \return True iff in_character was consumed.
+ */
+static
+CPC_BOOL
+cahal_json_consume  (
+                     cahal_json_parser*  io_parser,
+                     CHAR                in_character
+                     );
+
+/*! \fn     CPC_BOOL cahal_json_parse_object  (
+              cahal_json_parser*        io_parser,
+              cahal_json_member_parser  in_member_parser,
+              void*                     io_context
+            )
+    \brief  Parses an object, passing each member to in_member_parser.
+
+    \param  io_parser The parser.
+    \param  in_member_parser  The parser of the members.
+    \param  io_context  The context passed to in_member_parser.
+    \return True iff the object was parsed.
+ */
+static
+CPC_BOOL
+cahal_json_parse_object  (
+                          cahal_json_parser*        io_parser,
+                          cahal_json_member_parser  in_member_parser,
+                          void*                     io_context
+                          );
+
+/*! \fn     CPC_BOOL cahal_json_parse_array  (
+              cahal_json_parser*        io_parser,
+              cahal_json_element_parser in_element_parser,
+              void*                     io_context
+            )
+    \brief  Parses an array, passing each element to in_element_parser.
+
+    \param  io_parser The parser.
+    \param  in_element_parser The parser of the elements.
+    \param  io_context  The context passed to in_element_parser.
+    \return True iff the array was parsed.
+ */
+static
+CPC_BOOL
+cahal_json_parse_array  (
+                         cahal_json_parser*        io_parser,
+                         cahal_json_element_parser in_element_parser,
+                         void*                     io_context
+                         );
+
+/*! \fn     CPC_BOOL cahal_json_parse_string  (
+              cahal_json_parser*  io_parser,
+              CHAR**              out_string
+            )
+    \brief  Parses a string or null.
+
+    \param  io_parser The parser.
+    \param  out_string  The newly allocated unescaped string, or NULL for
+                        null.
+    \return True iff a string or null was parsed.
+ */
+static
+CPC_BOOL
+cahal_json_parse_string  (
+                          cahal_json_parser*  io_parser,
+                          CHAR**              out_string
+                          );
+
+/*! \fn     CPC_BOOL cahal_json_parse_number  (
+              cahal_json_parser*  io_parser,
+              FLOAT64*            out_number
+            )
+    \brief  Parses a number.
+
+    \param  io_parser The parser.
+    \param  out_number  The number.
+    \return True iff a number was parsed.
+ */
+static
+CPC_BOOL
+cahal_json_parse_number  (
+                          cahal_json_parser*  io_parser,
+                          FLOAT64*            out_number
+                          );
+
+/*! \fn     CPC_BOOL cahal_json_parse_uint32  (
+              cahal_json_parser*  io_parser,
+              UINT32*             out_number
+            )
+    \brief  Parses a number that must be a non-negative 32-bit integer.
+
+    \param  io_parser The parser.
+    \param  out_number  The number.
+    \return True iff such a number was parsed.
+ */
+static
+CPC_BOOL
+cahal_json_parse_uint32  (
+                          cahal_json_parser*  io_parser,
+                          UINT32*             out_number
+                          );
+
+/*! \fn     CPC_BOOL cahal_json_skip_value  (
+              cahal_json_parser* io_parser
+            )
+    \brief  Parses and discards any value.
+
+    \param  io_parser The parser.
+    \return True iff a value was parsed.
+ */
+static
+CPC_BOOL
+cahal_json_skip_value  (
+                        cahal_json_parser* io_parser
+                        );
+
+/*! \fn     CPC_BOOL cahal_json_skip_member  (
+              cahal_json_parser*  io_parser,
+              const CHAR*         in_key,
+              void*               io_context
+            )
+    \brief  cahal_json_member_parser that skips every member.
+ */
+static
+CPC_BOOL
+cahal_json_skip_member  (
+                         cahal_json_parser*  io_parser,
+                         const CHAR*         in_key,
+                         void*               io_context
+                         );
+
+/*! \fn     CPC_BOOL cahal_json_skip_element  (
+              cahal_json_parser*  io_parser,
+              void*               io_context
+            )
+    \brief  cahal_json_element_parser that skips every element.
+ */
+static
+CPC_BOOL
+cahal_json_skip_element  (
+                          cahal_json_parser*  io_parser,
+                          void*               io_context
+                          );
+
+/*! \fn     CPC_BOOL cahal_json_parse_document_member  (
+              cahal_json_parser*  io_parser,
+              const CHAR*         in_key,
+              void*               io_context
+            )
+    \brief  cahal_json_member_parser of the top level object. io_context is
+            the cahal_device** list being loaded.
+ */
+static
+CPC_BOOL
+cahal_json_parse_document_member  (
+                                   cahal_json_parser*  io_parser,
+                                   const CHAR*         in_key,
+                                   void*               io_context
+                                   );
+
+/*! \fn     CPC_BOOL cahal_json_parse_device  (
+              cahal_json_parser*  io_parser,
+              void*               io_context
+            )
+    \brief  cahal_json_element_parser of the devices. io_context is the
+            cahal_device** list being loaded.
+ */
+static
+CPC_BOOL
+cahal_json_parse_device  (
+                          cahal_json_parser*  io_parser,
+                          void*               io_context
+                          );
+
+/*! \fn     CPC_BOOL cahal_json_parse_device_member  (
+              cahal_json_parser*  io_parser,
+              const CHAR*         in_key,
+              void*               io_context
+            )
+    \brief  cahal_json_member_parser of a device. io_context is the
+            cahal_device.
+ */
+static
+CPC_BOOL
+cahal_json_parse_device_member  (
+                                 cahal_json_parser*  io_parser,
+                                 const CHAR*         in_key,
+                                 void*               io_context
+                                 );
+
+/*! \fn     CPC_BOOL cahal_json_parse_sample_rate_range  (
+              cahal_json_parser*  io_parser,
+              void*               io_context
+            )
+    \brief  cahal_json_element_parser of the sample rate ranges of a device.
+            io_context is the cahal_device.
+ */
+static
+CPC_BOOL
+cahal_json_parse_sample_rate_range  (
+                                     cahal_json_parser*  io_parser,
+                                     void*               io_context
+                                     );
+
+/*! \fn     CPC_BOOL cahal_json_parse_sample_rate_range_member  (
+              cahal_json_parser*  io_parser,
+              const CHAR*         in_key,
+              void*               io_context
+            )
+    \brief  cahal_json_member_parser of a sample rate range, also used for
+            the rates of formats. io_context is the cahal_sample_rate_range.
+ */
+static
+CPC_BOOL
+cahal_json_parse_sample_rate_range_member  (
+                                           cahal_json_parser*  io_parser,
+                                           const CHAR*         in_key,
+                                           void*               io_context
+                                            );
+
+/*! \fn     CPC_BOOL cahal_json_parse_stream  (
+              cahal_json_parser*  io_parser,
+              void*               io_context
+            )
+    \brief  cahal_json_element_parser of the streams of a device.
+            io_context is the cahal_device.
+ */
+static
+CPC_BOOL
+cahal_json_parse_stream  (
+                          cahal_json_parser*  io_parser,
+                          void*               io_context
+                          );
+
+/*! \fn     CPC_BOOL cahal_json_parse_stream_member  (
+              cahal_json_parser*  io_parser,
+              const CHAR*         in_key,
+              void*               io_context
+            )
+    \brief  cahal_json_member_parser of a stream. io_context is the
+            cahal_device_stream.
+ */
+static
+CPC_BOOL
+cahal_json_parse_stream_member  (
+                                 cahal_json_parser*  io_parser,
+                                 const CHAR*         in_key,
+                                 void*               io_context
+                                 );
+
+/*! \fn     CPC_BOOL cahal_json_parse_format  (
+              cahal_json_parser*  io_parser,
+              void*               io_context
+            )
+    \brief  cahal_json_element_parser of the formats of a stream. io_context
+            is the cahal_device_stream.
+ */
+static
+CPC_BOOL
+cahal_json_parse_format  (
+                          cahal_json_parser*  io_parser,
+                          void*               io_context
+                          );
+
+/*! \fn     CPC_BOOL cahal_json_parse_format_member  (
+              cahal_json_parser*  io_parser,
+              const CHAR*         in_key,
+              void*               io_context
+            )
+    \brief  cahal_json_member_parser of a format. io_context is the
+            cahal_audio_format_description.
+ */
+static
+CPC_BOOL
+cahal_json_parse_format_member  (
+                                 cahal_json_parser*  io_parser,
+                                 const CHAR*         in_key,
+                                 void*               io_context
+                                 );
+
+/*! \fn     CPC_BOOL cahal_json_parse_channel_position  (
+              cahal_json_parser*  io_parser,
+              void*               io_context
+            )
+    \brief  cahal_json_element_parser of the channel positions of a format.
+            io_context is the cahal_channel_layout, whose channel_mask bit is
+            set for each position. Positions must be distinct and less than
+            CAHAL_MAXIMUM_NUMBER_OF_CHANNELS.
+ */
+static
+CPC_BOOL
+cahal_json_parse_channel_position  (
+                                    cahal_json_parser*  io_parser,
+                                    void*               io_context
+                                    );
+
+CPC_BOOL
+cahal_save_device_list  (
+                         cahal_device**              in_device_list,
+                         const CHAR*                 in_path,
+                         cahal_device_list_encoding  in_encoding
+                         )
+{
+  CPC_BOOL return_value = CPC_TRUE;
+  CHAR* temporary_path  = NULL;
+  FILE* file            = NULL;
+
+  if( NULL == in_path || CAHAL_DEVICE_LIST_JSON < in_encoding )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid path or encoding." );
+
+    return( CPC_FALSE );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &temporary_path,
+                            strlen( in_path ) + 5
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc device list path." );
+
+    return( CPC_FALSE );
+  }
+
+  memcpy( temporary_path, in_path, strlen( in_path ) );
+  memcpy( temporary_path + strlen( in_path ), ".tmp", 4 );
+
+  file = fopen( temporary_path, "wb" );
+
+  if( NULL == file )
+  {
+    CPC_ERROR( "Could not open %s for writing.", temporary_path );
+
+    cpc_safe_free( ( void** ) &temporary_path );
+
+    return( CPC_FALSE );
+  }
+
+  if( CAHAL_DEVICE_LIST_BINARY == in_encoding )
+  {
+    return_value = cahal_write_binary_device_list( file, in_device_list );
+  }
+  else
+  {
+    CHAR* json = cahal_device_list_to_json( in_device_list );
+
+    return_value =
+      NULL != json
+      && strlen( json ) == fwrite( json, 1, strlen( json ), file );
+
+    cpc_safe_free( ( void** ) &json );
+  }
+
+  if( 0 != fclose( file ) )
+  {
+    return_value = CPC_FALSE;
+  }
+
+  if( return_value )
+  {
+#ifdef _WIN32
+    remove( in_path );
+#endif
+
+    return_value = ( 0 == rename( temporary_path, in_path ) );
+  }
+
+  if( ! return_value )
+  {
+    CPC_ERROR( "Could not write device list %s.", in_path );
+
+    remove( temporary_path );
+  }
+
+  cpc_safe_free( ( void** ) &temporary_path );
+
+  return( return_value );
+}
+
+cahal_device**
+cahal_load_device_list  (
+                         const CHAR* in_path
+                         )
+{
+  cahal_device** device_list  = NULL;
+  FILE* file                  = NULL;
+  UINT32 magic                = 0;
+
+  if( NULL == in_path )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid path." );
+
+    return( NULL );
+  }
+
+  file = fopen( in_path, "rb" );
+
+  if( NULL == file )
+  {
+    CPC_ERROR( "Could not open device list %s.", in_path );
+
+    return( NULL );
+  }
+
+  if  (
+       1 == fread( &magic, sizeof( UINT32 ), 1, file )
+       && CAHAL_DEVICE_LIST_MAGIC == magic
+       )
+  {
+    device_list = cahal_read_binary_device_list( file );
+  }
+  else if( 0 == fseek( file, 0, SEEK_END ) )
+  {
+    long length = ftell( file );
+    CHAR* json  = NULL;
+
+    if  (
+         0 <= length
+         && 0 == fseek( file, 0, SEEK_SET )
+         && CPC_ERROR_CODE_NO_ERROR
+            == cpc_safe_malloc( ( void** ) &json, ( SIZE ) length + 1 )
+         && ( SIZE ) length == fread( json, 1, ( SIZE ) length, file )
+         )
+    {
+      device_list = cahal_device_list_from_json( json );
+    }
+
+    cpc_safe_free( ( void** ) &json );
+  }
+
+  fclose( file );
+
+  if( NULL == device_list )
+  {
+    CPC_ERROR( "Could not load device list %s.", in_path );
+  }
+  else
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_DEBUG,
+             "Loaded %d devices from %s.",
+             cahal_count_items( ( void** ) device_list ),
+             in_path
+             );
+  }
+
+  return( device_list );
+}
+
+CHAR*
+cahal_device_list_to_json  (
+                            cahal_device** in_device_list
+                            )
+{
+  cahal_json_buffer buffer;
+  UINT32 number_of_devices  =
+    cahal_count_items( ( void** ) in_device_list );
+
+  memset( &buffer, 0, sizeof( cahal_json_buffer ) );
+
+  cahal_json_append  (
+                      &buffer,
+                      "{\n  \"version\": %u,\n  \"devices\": [",
+                      CAHAL_DEVICE_LIST_VERSION
+                      );
+
+  for( UINT32 i = 0; i < number_of_devices; i++ )
+  {
+    cahal_load_device_details( in_device_list[ i ] );
+
+    cahal_json_append( &buffer, 0 == i ? "\n" : ",\n" );
+    cahal_json_append_device( &buffer, in_device_list[ i ] );
+  }
+
+  cahal_json_append  (
+                      &buffer,
+                      0 == number_of_devices ? "]\n}\n" : "\n  ]\n}\n"
+                      );
+
+  if( buffer.failed )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not encode device list." );
+
+    cpc_safe_free( ( void** ) &( buffer.data ) );
+  }
+
+  return( buffer.data );
+}
+
+cahal_device**
+cahal_device_list_from_json  (
+                              const CHAR* in_json
+                              )
+{
+  cahal_device** device_list = NULL;
+  cahal_json_parser parser;
+
+  if( NULL == in_json )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid JSON." );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &device_list, sizeof( cahal_device* ) )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc device list." );
+
+    return( NULL );
+  }
+
+  parser.cursor = in_json;
+  parser.depth  = 0;
+
+  if  (
+       ! cahal_json_parse_object  (
+                                   &parser,
+                                   cahal_json_parse_document_member,
+                                   &device_list
+                                   )
+       || cahal_json_consume( &parser, '\0' )
+       || '\0' != *parser.cursor
+       )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_ERROR,
+             "Invalid device list JSON at offset %d.",
+             ( INT32 ) ( parser.cursor - in_json )
+             );
+
+    cahal_free_loaded_device_list( device_list );
+
+    device_list = NULL;
+  }
+
+  return( device_list );
+}
+
+CPC_BOOL
+cahal_set_device_replay_file  (
+                               const CHAR* in_path
+                               )
+{
+  CHAR* path = NULL;
+
+  if( NULL != in_path )
+  {
+    if  (
+         CPC_ERROR_CODE_NO_ERROR
+         != cpc_safe_malloc( ( void** ) &path, strlen( in_path ) + 1 )
+         )
+    {
+      CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc replay path." );
+
+      return( CPC_FALSE );
+    }
+
+    memcpy( path, in_path, strlen( in_path ) );
+  }
+
+  //  Refreshes scheduled by OS notifications may be reading the old path
+  cahal_lock_device_queries();
+
+  cpc_safe_free( ( void** ) &g_device_replay_path );
+
+  g_device_replay_path = path;
+
+  cahal_unlock_device_queries();
+
+  CPC_LOG (
+           CPC_LOG_LEVEL_INFO,
+           "Device list replay: %s.",
+           NULL == path ? "off" : path
+           );
+
+  return( CPC_TRUE );
+}
+
+static
+UINT32
+cahal_count_items  (
+                    void** in_list
+                    )
+{
+  UINT32 number_of_items = 0;
+
+  while( NULL != in_list && NULL != in_list[ number_of_items ] )
+  {
+    number_of_items++;
+  }
+
+  return( number_of_items );
+}
+
+static
+CPC_BOOL
+cahal_append_item  (
+                    void*** io_list,
+                    void*   in_item
+                    )
+{
+  UINT32 number_of_items = cahal_count_items( *io_list );
+
+  if( CAHAL_DEVICE_LIST_MAXIMUM_ITEMS <= number_of_items )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Too many items in list." );
+
+    return( CPC_FALSE );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_realloc  (
+                             ( void** ) io_list,
+                             NULL == *io_list
+                             ? 0 : ( number_of_items + 1 ) * sizeof( void* ),
+                             ( number_of_items + 2 ) * sizeof( void* )
+                             )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not grow list." );
+
+    return( CPC_FALSE );
+  }
+
+  ( *io_list )[ number_of_items ]     = in_item;
+  ( *io_list )[ number_of_items + 1 ] = NULL;
+
+  return( CPC_TRUE );
+}
+
+static
+void
+cahal_free_loaded_device_list  (
+                                cahal_device** in_device_list
+                                )
+{
+  for  (
+        UINT32 i = 0;
+        NULL != in_device_list && NULL != in_device_list[ i ];
+        i++
+        )
+  {
+    cahal_free_device( in_device_list[ i ] );
+  }
+
+  cpc_safe_free( ( void** ) &in_device_list );
+}
+
+static
+CPC_BOOL
+cahal_write_binary_device_list  (
+                                 FILE*          in_file,
+                                 cahal_device** in_device_list
+                                 )
+{
+  UINT32 header[ 3 ] =
+  {
+    CAHAL_DEVICE_LIST_MAGIC,
+    CAHAL_DEVICE_LIST_VERSION,
+    cahal_count_items( ( void** ) in_device_list )
+  };
+  CPC_BOOL return_value =
+    ( 3 == fwrite( header, sizeof( UINT32 ), 3, in_file ) );
+
+  //  Lazily enumerated devices are saved with all of their details.
+  for( UINT32 i = 0; i < header[ 2 ]; i++ )
+  {
+    cahal_load_device_details( in_device_list[ i ] );
+  }
+
+  for( UINT32 i = 0; i < header[ 2 ] && return_value; i++ )
+  {
+    cahal_device* device  = in_device_list[ i ];
+    UINT32 values[ 4 ]    =
+    {
+      device->handle,
+      device->preferred_number_of_channels,
+      device->is_alive,
+      device->is_running
+    };
+    UINT32 number_of_rates    =
+      cahal_count_items( ( void** ) device->supported_sample_rates );
+    UINT32 number_of_streams  =
+      cahal_count_items( ( void** ) device->device_streams );
+
+    for( UINT32 j = 0; j < CAHAL_DEVICE_NUMBER_OF_STRINGS && return_value; j++ )
+    {
+      return_value =
+        cahal_write_binary_string( in_file, CAHAL_DEVICE_STRING( device, j ) );
+    }
+
+    return_value =
+      return_value
+      && 1 == fwrite  (
+                       &( device->preferred_sample_rate ),
+                       sizeof( FLOAT64 ),
+                       1,
+                       in_file
+                       )
+      && 4 == fwrite( values, sizeof( UINT32 ), 4, in_file )
+      && 1 == fwrite( &number_of_rates, sizeof( UINT32 ), 1, in_file );
+
+    for( UINT32 j = 0; j < number_of_rates && return_value; j++ )
+    {
+      return_value =
+        1 == fwrite  (
+                      device->supported_sample_rates[ j ],
+                      sizeof( cahal_sample_rate_range ),
+                      1,
+                      in_file
+                      );
+    }
+
+    return_value =
+      return_value
+      && 1 == fwrite( &number_of_streams, sizeof( UINT32 ), 1, in_file );
+
+    for( UINT32 j = 0; j < number_of_streams && return_value; j++ )
+    {
+      cahal_device_stream* stream = device->device_streams[ j ];
+      UINT32 stream_values[ 4 ]   =
+      {
+        stream->handle,
+        stream->direction,
+        stream->preferred_format,
+        cahal_count_items( ( void** ) stream->supported_formats )
+      };
+
+      return_value = 4 == fwrite( stream_values, sizeof( UINT32 ), 4, in_file );
+
+      for( UINT32 k = 0; k < stream_values[ 3 ] && return_value; k++ )
+      {
+        cahal_audio_format_description* format =
+          stream->supported_formats[ k ];
+        UINT32 format_values[ 3 ] =
+        {
+          format->format_id,
+          format->number_of_channels,
+          format->bit_depth
+        };
+
+        return_value =
+          3 == fwrite( format_values, sizeof( UINT32 ), 3, in_file )
+          && 1 == fwrite  (
+                           &( format->sample_rate_range ),
+                           sizeof( cahal_sample_rate_range ),
+                           1,
+                           in_file
+                           )
+          && 1 == fwrite  (
+                           &( format->channel_layout.layout_type ),
+                           sizeof( UINT32 ),
+                           1,
+                           in_file
+                           )
+          && 1 == fwrite  (
+                           &( format->channel_layout.channel_mask ),
+                           sizeof( UINT64 ),
+                           1,
+                           in_file
+                           );
+      }
+    }
+  }
+
+  return( return_value );
+}
+
+static
+CPC_BOOL
+cahal_write_binary_string  (
+                            FILE*       in_file,
+                            const CHAR* in_string
+                            )
+{
+  UINT32 length =
+    NULL == in_string
+    ? CAHAL_DEVICE_LIST_NULL_STRING : ( UINT32 ) strlen( in_string );
+
+  return  (
+           1 == fwrite( &length, sizeof( UINT32 ), 1, in_file )
+           && (
+               NULL == in_string
+               || length == fwrite( in_string, 1, length, in_file )
+               )
+           );
+}
+
+static
+cahal_device**
+cahal_read_binary_device_list  (
+                                FILE* in_file
+                                )
+{
+  cahal_device** device_list  = NULL;
+  UINT32 version              = 0;
+  UINT32 number_of_devices    = 0;
+
+  if  (
+       1 != fread( &version, sizeof( UINT32 ), 1, in_file )
+       || CAHAL_DEVICE_LIST_MINIMUM_VERSION > version
+       || CAHAL_DEVICE_LIST_VERSION < version
+       )
+  {
+    CPC_LOG( CPC_LOG_LEVEL_WARN, "Unsupported device list version %d.",
+             version );
+
+    return( NULL );
+  }
+  else if( ! cahal_read_binary_count( in_file, &number_of_devices ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_WARN, "Corrupt device list." );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &device_list,
+                            sizeof( cahal_device* ) * ( number_of_devices + 1 )
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc device list." );
+
+    return( NULL );
+  }
+
+  for( UINT32 i = 0; i < number_of_devices; i++ )
+  {
+    device_list[ i ] = cahal_read_binary_device( in_file, version );
+
+    if( NULL == device_list[ i ] )
+    {
+      cahal_free_loaded_device_list( device_list );
+
+      return( NULL );
+    }
+  }
+
+  return( device_list );
+}
+
+static
+cahal_device*
+cahal_read_binary_device  (
+                           FILE*   in_file,
+                           UINT32  in_version
+                           )
+{
+  cahal_device* device      = NULL;
+  CPC_BOOL return_value     = CPC_TRUE;
+  UINT32 values[ 4 ]        = { 0, 0, 0, 0 };
+  UINT32 number_of_rates    = 0;
+  UINT32 number_of_streams  = 0;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &device, sizeof( cahal_device ) )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc device." );
+
+    return( NULL );
+  }
+
+  for( UINT32 i = 0; i < CAHAL_DEVICE_NUMBER_OF_STRINGS && return_value; i++ )
+  {
+    return_value =
+      cahal_read_binary_string( in_file, &CAHAL_DEVICE_STRING( device, i ) );
+  }
+
+  return_value =
+    return_value
+    && 1 == fread  (
+                    &( device->preferred_sample_rate ),
+                    sizeof( FLOAT64 ),
+                    1,
+                    in_file
+                    )
+    && 4 == fread( values, sizeof( UINT32 ), 4, in_file )
+    && cahal_read_binary_count( in_file, &number_of_rates )
+    && CPC_ERROR_CODE_NO_ERROR
+       == cpc_safe_malloc  (
+                            ( void** ) &( device->supported_sample_rates ),
+                            sizeof( cahal_sample_rate_range* )
+                            * ( number_of_rates + 1 )
+                            );
+
+  device->handle                        = values[ 0 ];
+  device->preferred_number_of_channels  = values[ 1 ];
+  device->is_alive                      = values[ 2 ];
+  device->is_running                    = values[ 3 ];
+
+  for( UINT32 i = 0; i < number_of_rates && return_value; i++ )
+  {
+    return_value =
+      CPC_ERROR_CODE_NO_ERROR
+      == cpc_safe_malloc  (
+                           ( void** ) &( device->supported_sample_rates[ i ] ),
+                           sizeof( cahal_sample_rate_range )
+                           )
+      && 1 == fread  (
+                      device->supported_sample_rates[ i ],
+                      sizeof( cahal_sample_rate_range ),
+                      1,
+                      in_file
+                      );
+  }
+
+  return_value =
+    return_value
+    && cahal_read_binary_count( in_file, &number_of_streams )
+    && CPC_ERROR_CODE_NO_ERROR
+       == cpc_safe_malloc  (
+                            ( void** ) &( device->device_streams ),
+                            sizeof( cahal_device_stream* )
+                            * ( number_of_streams + 1 )
+                            );
+
+  for( UINT32 i = 0; i < number_of_streams && return_value; i++ )
+  {
+    cahal_device_stream* stream = NULL;
+    UINT32 stream_values[ 4 ]   = { 0, 0, 0, 0 };
+
+    return_value =
+      CPC_ERROR_CODE_NO_ERROR
+      == cpc_safe_malloc( ( void** ) &stream, sizeof( cahal_device_stream ) );
+
+    if( ! return_value )
+    {
+      break;
+    }
+
+    device->device_streams[ i ] = stream;
+
+    return_value =
+      3 == fread( stream_values, sizeof( UINT32 ), 3, in_file )
+      && cahal_read_binary_count( in_file, &( stream_values[ 3 ] ) )
+      && CPC_ERROR_CODE_NO_ERROR
+         == cpc_safe_malloc  (
+                              ( void** ) &( stream->supported_formats ),
+                              sizeof( cahal_audio_format_description* )
+                              * ( stream_values[ 3 ] + 1 )
+                              );
+
+    stream->handle            = stream_values[ 0 ];
+    stream->direction         = stream_values[ 1 ];
+    stream->preferred_format  = stream_values[ 2 ];
+
+    for( UINT32 j = 0; j < stream_values[ 3 ] && return_value; j++ )
+    {
+      cahal_audio_format_description* format = NULL;
+      UINT32 format_values[ 3 ]             = { 0, 0, 0 };
+
+      return_value =
+        CPC_ERROR_CODE_NO_ERROR
+        == cpc_safe_malloc  (
+                             ( void** ) &format,
+                             sizeof( cahal_audio_format_description )
+                             );
+
+      if( ! return_value )
+      {
+        break;
+      }
+
+      stream->supported_formats[ j ] = format;
+
+      return_value =
+        3 == fread( format_values, sizeof( UINT32 ), 3, in_file )
+        && 1 == fread  (
+                        &( format->sample_rate_range ),
+                        sizeof( cahal_sample_rate_range ),
+                        1,
+                        in_file
+                        )
+        && (
+            2 > in_version
+            || (
+                1 == fread  (
+                             &( format->channel_layout.layout_type ),
+                             sizeof( UINT32 ),
+                             1,
+                             in_file
+                             )
+                && 1 == fread  (
+                                &( format->channel_layout.channel_mask ),
+                                sizeof( UINT64 ),
+                                1,
+                                in_file
+                                )
+                )
+            );
+
+      format->format_id           = format_values[ 0 ];
+      format->number_of_channels  = format_values[ 1 ];
+      format->bit_depth           = format_values[ 2 ];
+    }
+  }
+
+  if( ! return_value )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_WARN, "Corrupt device list." );
+
+    cahal_free_device( device );
+
+    device = NULL;
+  }
+
+  return( device );
+}
+
+static
+CPC_BOOL
+cahal_read_binary_string  (
+                           FILE*   in_file,
+                           CHAR**  out_string
+                           )
+{
+  UINT32 length = 0;
+
+  *out_string = NULL;
+
+  if( 1 != fread( &length, sizeof( UINT32 ), 1, in_file ) )
+  {
+    return( CPC_FALSE );
+  }
+
+  if( CAHAL_DEVICE_LIST_NULL_STRING == length )
+  {
+    return( CPC_TRUE );
+  }
+
+  return  (
+           CAHAL_DEVICE_LIST_MAXIMUM_STRING_LENGTH >= length
+           && CPC_ERROR_CODE_NO_ERROR
+              == cpc_safe_malloc( ( void** ) out_string, length + 1 )
+           && length == fread( *out_string, 1, length, in_file )
+           );
+}
+
+static
+CPC_BOOL
+cahal_read_binary_count  (
+                          FILE*   in_file,
+                          UINT32* out_count
+                          )
+{
+  return  (
+           1 == fread( out_count, sizeof( UINT32 ), 1, in_file )
+           && CAHAL_DEVICE_LIST_MAXIMUM_ITEMS >= *out_count
+           );
+}
+
+static
+void
+cahal_json_append  (
+                    cahal_json_buffer*  io_buffer,
+                    const CHAR*         in_format,
+                    ...
+                    )
+{
+  va_list arguments;
+  INT32 length = 0;
+
+  if( io_buffer->failed )
+  {
+    return;
+  }
+
+  va_start( arguments, in_format );
+  length = vsnprintf( NULL, 0, in_format, arguments );
+  va_end( arguments );
+
+  if( 0 > length )
+  {
+    io_buffer->failed = CPC_TRUE;
+
+    return;
+  }
+
+  if( io_buffer->length + length + 1 > io_buffer->capacity )
+  {
+    SIZE capacity = 0 == io_buffer->capacity ? 1024 : io_buffer->capacity;
+
+    while( io_buffer->length + length + 1 > capacity )
+    {
+      capacity *= 2;
+    }
+
+    if  (
+         CPC_ERROR_CODE_NO_ERROR
+         != cpc_safe_realloc  (
+                               ( void** ) &( io_buffer->data ),
+                               io_buffer->capacity,
+                               capacity
+                               )
+         )
+    {
+      io_buffer->failed = CPC_TRUE;
+
+      return;
+    }
+
+    io_buffer->capacity = capacity;
+  }
+
+  va_start( arguments, in_format );
+  vsnprintf (
+             io_buffer->data + io_buffer->length,
+             io_buffer->capacity - io_buffer->length,
+             in_format,
+             arguments
+             );
+  va_end( arguments );
+
+  io_buffer->length += length;
+}
+
+static
+void
+cahal_json_append_string  (
+                           cahal_json_buffer*  io_buffer,
+                           const CHAR*         in_string
+                           )
+{
+  if( NULL == in_string )
+  {
+    cahal_json_append( io_buffer, "null" );
+
+    return;
+  }
+
+  cahal_json_append( io_buffer, "\"" );
+
+  for( const UCHAR* c = ( const UCHAR* ) in_string; 0 != *c; c++ )
+  {
+    if( '"' == *c || '\\' == *c )
+    {
+      cahal_json_append( io_buffer, "\\%c", *c );
+    }
+    else if( 0x20 > *c )
+    {
+      cahal_json_append( io_buffer, "\\u%04x", *c );
+    }
+    else
+    {
+      cahal_json_append( io_buffer, "%c", *c );
+    }
+  }
+
+  cahal_json_append( io_buffer, "\"" );
+}
+
+static
+void
+cahal_json_append_device  (
+                           cahal_json_buffer*  io_buffer,
+                           cahal_device*       in_device
+                           )
+{
+  cahal_json_append( io_buffer, "    {\n" );
+
+  for( UINT32 i = 0; i < CAHAL_DEVICE_NUMBER_OF_STRINGS; i++ )
+  {
+    cahal_json_append  (
+                        io_buffer,
+                        "      \"%s\": ",
+                        g_device_strings[ i ].name
+                        );
+    cahal_json_append_string( io_buffer, CAHAL_DEVICE_STRING( in_device, i ) );
+    cahal_json_append( io_buffer, ",\n" );
+  }
+
+  cahal_json_append  (
+                      io_buffer,
+                      "      \"preferred_sample_rate\": %.17g,\n"
+                      "      \"handle\": %u,\n"
+                      "      \"preferred_number_of_channels\": %u,\n"
+                      "      \"is_alive\": %u,\n"
+                      "      \"is_running\": %u,\n"
+                      "      \"supported_sample_rates\": [",
+                      in_device->preferred_sample_rate,
+                      in_device->handle,
+                      in_device->preferred_number_of_channels,
+                      in_device->is_alive,
+                      in_device->is_running
+                      );
+
+  for  (
+        UINT32 i = 0;
+        NULL != in_device->supported_sample_rates
+        && NULL != in_device->supported_sample_rates[ i ];
+        i++
+        )
+  {
+    cahal_json_append  (
+                    io_buffer,
+                    "%s\n        "
+                    "{ \"minimum_rate\": %.17g, \"maximum_rate\": %.17g }",
+                    0 == i ? "" : ",",
+                    in_device->supported_sample_rates[ i ]->minimum_rate,
+                    in_device->supported_sample_rates[ i ]->maximum_rate
+                        );
+  }
+
+  cahal_json_append( io_buffer, " ],\n      \"device_streams\": [" );
+
+  for  (
+        UINT32 i = 0;
+        NULL != in_device->device_streams
+        && NULL != in_device->device_streams[ i ];
+        i++
+        )
+  {
+    cahal_device_stream* stream = in_device->device_streams[ i ];
+
+    cahal_json_append  (
+                        io_buffer,
+                        "%s\n        {\n"
+                        "          \"handle\": %u,\n"
+                        "          \"direction\": %u,\n"
+                        "          \"preferred_format\": %u,\n"
+                        "          \"supported_formats\": [",
+                        0 == i ? "" : ",",
+                        stream->handle,
+                        stream->direction,
+                        stream->preferred_format
+                        );
+
+    for  (
+          UINT32 j = 0;
+          NULL != stream->supported_formats
+          && NULL != stream->supported_formats[ j ];
+          j++
+          )
+    {
+      cahal_audio_format_description* format = stream->supported_formats[ j ];
+
+      const CHAR* separator                  = "";
+
+      cahal_json_append  (
+                          io_buffer,
+                          "%s\n            "
+                          "{ \"format_id\": %u, \"number_of_channels\": %u, "
+                          "\"bit_depth\": %u,\n              "
+                          "\"minimum_rate\": %.17g, \"maximum_rate\": %.17g,"
+                          "\n              \"channel_layout\": %u, "
+                          "\"channel_positions\": [",
+                          0 == j ? "" : ",",
+                          format->format_id,
+                          format->number_of_channels,
+                          format->bit_depth,
+                          format->sample_rate_range.minimum_rate,
+                          format->sample_rate_range.maximum_rate,
+                          format->channel_layout.layout_type
+                          );
+
+      for( UINT32 k = 0; k < CAHAL_MAXIMUM_NUMBER_OF_CHANNELS; k++ )
+      {
+        if( format->channel_layout.channel_mask & ( ( ( UINT64 ) 1 ) << k ) )
+        {
+          cahal_json_append( io_buffer, "%s %u", separator, k );
+
+          separator = ",";
+        }
+      }
+
+      cahal_json_append( io_buffer, " ] }" );
+    }
+
+    cahal_json_append( io_buffer, " ]\n        }" );
+  }
+
+  cahal_json_append( io_buffer, " ]\n    }" );
+}
+
+static
+CPC_BOOL
+cahal_json_consume  (
+                     cahal_json_parser*  io_parser,
+                     CHAR                in_character
+                     )
+{
+  while  (
+          ' ' == *io_parser->cursor || '\t' == *io_parser->cursor
+          || '\n' == *io_parser->cursor || '\r' == *io_parser->cursor
+          )
+  {
+    io_parser->cursor++;
+  }
+
+  if( '\0' != in_character && in_character == *io_parser->cursor )
+  {
+    io_parser->cursor++;
+
+    return( CPC_TRUE );
+  }
+
+  return( CPC_FALSE );
+}
+
+static
+CPC_BOOL
+cahal_json_parse_object  (
+                          cahal_json_parser*        io_parser,
+                          cahal_json_member_parser  in_member_parser,
+                          void*                     io_context
+                          )
+{
+  CPC_BOOL return_value = CPC_TRUE;
+
+  if  (
+       CAHAL_DEVICE_LIST_MAXIMUM_DEPTH <= io_parser->depth
+       || ! cahal_json_consume( io_parser, '{' )
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  io_parser->depth++;
+
+  if( ! cahal_json_consume( io_parser, '}' ) )
+  {
+    do
+    {
+      CHAR* key = NULL;
+
+      return_value =
+        cahal_json_parse_string( io_parser, &key )
+        && NULL != key
+        && cahal_json_consume( io_parser, ':' )
+        && in_member_parser( io_parser, key, io_context );
+
+      cpc_safe_free( ( void** ) &key );
+    }
+    while( return_value && cahal_json_consume( io_parser, ',' ) );
+
+    return_value = return_value && cahal_json_consume( io_parser, '}' );
+  }
+
+  io_parser->depth--;
+
+  return( return_value );
+}
+
+static
+CPC_BOOL
+cahal_json_parse_array  (
+                         cahal_json_parser*        io_parser,
+                         cahal_json_element_parser in_element_parser,
+                         void*                     io_context
+                         )
+{
+  CPC_BOOL return_value = CPC_TRUE;
+
+  if  (
+       CAHAL_DEVICE_LIST_MAXIMUM_DEPTH <= io_parser->depth
+       || ! cahal_json_consume( io_parser, '[' )
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  io_parser->depth++;
+
+  if( ! cahal_json_consume( io_parser, ']' ) )
+  {
+    do
+    {
+      return_value = in_element_parser( io_parser, io_context );
+    }
+    while( return_value && cahal_json_consume( io_parser, ',' ) );
+
+    return_value = return_value && cahal_json_consume( io_parser, ']' );
+  }
+
+  io_parser->depth--;
+
+  return( return_value );
+}
+
+static
+CPC_BOOL
+cahal_json_parse_string  (
+                          cahal_json_parser*  io_parser,
+                          CHAR**              out_string
+                          )
+{
+  CHAR* string  = NULL;
+  SIZE length   = 0;
+
+  *out_string = NULL;
+
+  cahal_json_consume( io_parser, '\0' );
+
+  if( 0 == strncmp( io_parser->cursor, "null", 4 ) )
+  {
+    io_parser->cursor += 4;
+
+    return( CPC_TRUE );
+  }
+
+  if( ! cahal_json_consume( io_parser, '"' ) )
+  {
+    return( CPC_FALSE );
+  }
+
+  //  The unescaped string is never longer than the escaped one.
+  for  (
+        const CHAR* c = io_parser->cursor;
+        '"' != *c && '\0' != *c;
+        c += ( '\\' == *c && '\0' != c[ 1 ] ) ? 2 : 1
+        )
+  {
+    length += ( '\\' == *c ) ? 2 : 1;
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &string, length + 1 )
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  length = 0;
+
+  while( '"' != *io_parser->cursor )
+  {
+    CHAR c = *io_parser->cursor++;
+
+    if( '\0' == c || ( 0x20 > ( UCHAR ) c ) )
+    {
+      cpc_safe_free( ( void** ) &string );
+
+      return( CPC_FALSE );
+    }
+    else if( '\\' != c )
+    {
+      string[ length++ ] = c;
+
+      continue;
+    }
+
+    c = *io_parser->cursor++;
+
+    switch( c )
+    {
+      case '"':
+      case '\\':
+      case '/':
+        string[ length++ ] = c;
+        break;
+      case 'b':
+        string[ length++ ] = '\b';
+        break;
+      case 'f':
+        string[ length++ ] = '\f';
+        break;
+      case 'n':
+        string[ length++ ] = '\n';
+        break;
+      case 'r':
+        string[ length++ ] = '\r';
+        break;
+      case 't':
+        string[ length++ ] = '\t';
+        break;
+      case 'u':
+      {
+        UINT32 code_point = 0;
+
+        for( UINT32 i = 0; i < 4; i++ )
+        {
+          CHAR digit = *io_parser->cursor++;
+
+          code_point <<= 4;
+
+          if( '0' <= digit && '9' >= digit )
+          {
+            code_point |= digit - '0';
+          }
+          else if( 'a' <= ( digit | 0x20 ) && 'f' >= ( digit | 0x20 ) )
+          {
+            code_point |= ( digit | 0x20 ) - 'a' + 10;
+          }
+          else
+          {
+            cpc_safe_free( ( void** ) &string );
+
+            return( CPC_FALSE );
+          }
+        }
+
+        //  Six escaped bytes never encode to more than three UTF-8 bytes.
+        //  Surrogate pairs are kept as two separate code points.
+        if( 0x80 > code_point )
+        {
+          string[ length++ ] = ( CHAR ) code_point;
+        }
+        else if( 0x800 > code_point )
+        {
+          string[ length++ ] = ( CHAR ) ( 0xC0 | ( code_point >> 6 ) );
+          string[ length++ ] = ( CHAR ) ( 0x80 | ( code_point & 0x3F ) );
+        }
+        else
+        {
+          string[ length++ ] = ( CHAR ) ( 0xE0 | ( code_point >> 12 ) );
+          string[ length++ ] =
+            ( CHAR ) ( 0x80 | ( ( code_point >> 6 ) & 0x3F ) );
+          string[ length++ ] = ( CHAR ) ( 0x80 | ( code_point & 0x3F ) );
+        }
+        break;
+      }
+      default:
+        cpc_safe_free( ( void** ) &string );
+
+        return( CPC_FALSE );
+    }
+  }
+
+  io_parser->cursor++;
+
+  *out_string = string;
+
+  return( CPC_TRUE );
+}
+
+static
+CPC_BOOL
+cahal_json_parse_number  (
+                          cahal_json_parser*  io_parser,
+                          FLOAT64*            out_number
+                          )
+{
+  CHAR* end = NULL;
+
+  cahal_json_consume( io_parser, '\0' );
+
+  if  (
+       '-' != *io_parser->cursor
+       && ( '0' > *io_parser->cursor || '9' < *io_parser->cursor )
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  *out_number = strtod( io_parser->cursor, &end );
+
+  if( end == io_parser->cursor )
+  {
+    return( CPC_FALSE );
+  }
+
+  io_parser->cursor = end;
+
+  return( CPC_TRUE );
+}
+
+static
+CPC_BOOL
+cahal_json_parse_uint32  (
+                          cahal_json_parser*  io_parser,
+                          UINT32*             out_number
+                          )
+{
+  FLOAT64 number = 0;
+
+  if  (
+       ! cahal_json_parse_number( io_parser, &number )
+       || 0 > number
+       || 4294967295.0 < number
+       || number != ( FLOAT64 ) ( UINT32 ) number
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  *out_number = ( UINT32 ) number;
+
+  return( CPC_TRUE );
+}
+
+static
+CPC_BOOL
+cahal_json_skip_value  (
+                        cahal_json_parser* io_parser
+                        )
+{
+  FLOAT64 number  = 0;
+  CHAR* string    = NULL;
+
+  cahal_json_consume( io_parser, '\0' );
+
+  switch( *io_parser->cursor )
+  {
+    case '{':
+      return  (
+               cahal_json_parse_object  (
+                                         io_parser,
+                                         cahal_json_skip_member,
+                                         NULL
+                                         )
+               );
+    case '[':
+      return  (
+               cahal_json_parse_array  (
+                                        io_parser,
+                                        cahal_json_skip_element,
+                                        NULL
+                                        )
+               );
+    case '"':
+    case 'n':
+      if( cahal_json_parse_string( io_parser, &string ) )
+      {
+        cpc_safe_free( ( void** ) &string );
+
+        return( CPC_TRUE );
+      }
+
+      return( CPC_FALSE );
+    case 't':
+      if( 0 == strncmp( io_parser->cursor, "true", 4 ) )
+      {
+        io_parser->cursor += 4;
+
+        return( CPC_TRUE );
+      }
+
+      return( CPC_FALSE );
+    case 'f':
+      if( 0 == strncmp( io_parser->cursor, "false", 5 ) )
+      {
+        io_parser->cursor += 5;
+
+        return( CPC_TRUE );
+      }
+
+      return( CPC_FALSE );
+    default:
+      return( cahal_json_parse_number( io_parser, &number ) );
+  }
+}
+
+static
+CPC_BOOL
+cahal_json_skip_member  (
+                         cahal_json_parser*  io_parser,
+                         const CHAR*         in_key,
+                         void*               io_context
+                         )
+{
+  return( cahal_json_skip_value( io_parser ) );
+}
+
+static
+CPC_BOOL
+cahal_json_skip_element  (
+                          cahal_json_parser*  io_parser,
+                          void*               io_context
+                          )
+{
+  return( cahal_json_skip_value( io_parser ) );
+}
+
+static
+CPC_BOOL
+cahal_json_parse_document_member  (
+                                   cahal_json_parser*  io_parser,
+                                   const CHAR*         in_key,
+                                   void*               io_context
+                                   )
+{
+  UINT32 version = 0;
+
+  if( 0 == strcmp( in_key, "version" ) )
+  {
+    if( ! cahal_json_parse_uint32( io_parser, &version ) )
+    {
+      return( CPC_FALSE );
+    }
+    else if  (
+              CAHAL_DEVICE_LIST_MINIMUM_VERSION > version
+              || CAHAL_DEVICE_LIST_VERSION < version
+              )
+    {
+      CPC_LOG( CPC_LOG_LEVEL_WARN, "Unsupported device list version %d.",
+               version );
+
+      return( CPC_FALSE );
+    }
+
+    return( CPC_TRUE );
+  }
+  else if( 0 == strcmp( in_key, "devices" ) )
+  {
+    return  (
+             cahal_json_parse_array  (
+                                      io_parser,
+                                      cahal_json_parse_device,
+                                      io_context
+                                      )
+             );
+  }
+  else
+  {
+    return( cahal_json_skip_value( io_parser ) );
+  }
+}
+
+static
+CPC_BOOL
+cahal_json_parse_device  (
+                          cahal_json_parser*  io_parser,
+                          void*               io_context
+                          )
+{
+  cahal_device* device = NULL;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &device, sizeof( cahal_device ) )
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  if( ! cahal_append_item( ( void*** ) io_context, device ) )
+  {
+    cpc_safe_free( ( void** ) &device );
+
+    return( CPC_FALSE );
+  }
+
+  return  (
+           cahal_json_parse_object  (
+                                     io_parser,
+                                     cahal_json_parse_device_member,
+                                     device
+                                     )
+           );
+}
+
+static
+CPC_BOOL
+cahal_json_parse_device_member  (
+                                 cahal_json_parser*  io_parser,
+                                 const CHAR*         in_key,
+                                 void*               io_context
+                                 )
+{
+  cahal_device* device = ( cahal_device* ) io_context;
+
+  for( UINT32 i = 0; i < CAHAL_DEVICE_NUMBER_OF_STRINGS; i++ )
+  {
+    if( 0 == strcmp( in_key, g_device_strings[ i ].name ) )
+    {
+      cpc_safe_free( ( void** ) &CAHAL_DEVICE_STRING( device, i ) );
+
+      return  (
+               cahal_json_parse_string  (
+                                         io_parser,
+                                         &CAHAL_DEVICE_STRING( device, i )
+                                         )
+               );
+    }
+  }
+
+  if( 0 == strcmp( in_key, "preferred_sample_rate" ) )
+  {
+    return  (
+             cahal_json_parse_number  (
+                                       io_parser,
+                                       &( device->preferred_sample_rate )
+                                       )
+             );
+  }
+  else if( 0 == strcmp( in_key, "handle" ) )
+  {
+    return( cahal_json_parse_uint32( io_parser, &( device->handle ) ) );
+  }
+  else if( 0 == strcmp( in_key, "preferred_number_of_channels" ) )
+  {
+    return  (
+             cahal_json_parse_uint32  (
+                                   io_parser,
+                                   &( device->preferred_number_of_channels )
+                                       )
+             );
+  }
+  else if( 0 == strcmp( in_key, "is_alive" ) )
+  {
+    return( cahal_json_parse_uint32( io_parser, &( device->is_alive ) ) );
+  }
+  else if( 0 == strcmp( in_key, "is_running" ) )
+  {
+    return( cahal_json_parse_uint32( io_parser, &( device->is_running ) ) );
+  }
+  else if( 0 == strcmp( in_key, "supported_sample_rates" ) )
+  {
+    return  (
+             cahal_json_parse_array  (
+                                      io_parser,
+                                      cahal_json_parse_sample_rate_range,
+                                      device
+                                      )
+             );
+  }
+  else if( 0 == strcmp( in_key, "device_streams" ) )
+  {
+    return  (
+             cahal_json_parse_array  (
+                                      io_parser,
+                                      cahal_json_parse_stream,
+                                      device
+                                      )
+             );
+  }
+  else
+  {
+    return( cahal_json_skip_value( io_parser ) );
+  }
+}
+
+static
+CPC_BOOL
+cahal_json_parse_sample_rate_range  (
+                                     cahal_json_parser*  io_parser,
+                                     void*               io_context
+                                     )
+{
+  cahal_device* device            = ( cahal_device* ) io_context;
+  cahal_sample_rate_range* range  = NULL;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &range,
+                            sizeof( cahal_sample_rate_range )
+                            )
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  if  (
+       ! cahal_append_item  (
+                             ( void*** ) &( device->supported_sample_rates ),
+                             range
+                             )
+       )
+  {
+    cpc_safe_free( ( void** ) &range );
+
+    return( CPC_FALSE );
+  }
+
+  return  (
+           cahal_json_parse_object  (
+                                     io_parser,
+                                     cahal_json_parse_sample_rate_range_member,
+                                     range
+                                     )
+           );
+}
+
+static
+CPC_BOOL
+cahal_json_parse_sample_rate_range_member  (
+                                           cahal_json_parser*  io_parser,
+                                           const CHAR*         in_key,
+                                           void*               io_context
+                                            )
+{
+  cahal_sample_rate_range* range = ( cahal_sample_rate_range* ) io_context;
+
+  if( 0 == strcmp( in_key, "minimum_rate" ) )
+  {
+    return( cahal_json_parse_number( io_parser, &( range->minimum_rate ) ) );
+  }
+  else if( 0 == strcmp( in_key, "maximum_rate" ) )
+  {
+    return( cahal_json_parse_number( io_parser, &( range->maximum_rate ) ) );
+  }
+  else
+  {
+    return( cahal_json_skip_value( io_parser ) );
+  }
+}
+
+static
+CPC_BOOL
+cahal_json_parse_stream  (
+                          cahal_json_parser*  io_parser,
+                          void*               io_context
+                          )
+{
+  cahal_device* device        = ( cahal_device* ) io_context;
+  cahal_device_stream* stream = NULL;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &stream, sizeof( cahal_device_stream ) )
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  if  (
+       ! cahal_append_item  (
+                             ( void*** ) &( device->device_streams ),
+                             stream
+                             )
+       )
+  {
+    cpc_safe_free( ( void** ) &stream );
+
+    return( CPC_FALSE );
+  }
+
+  return  (
+           cahal_json_parse_object  (
+                                     io_parser,
+                                     cahal_json_parse_stream_member,
+                                     stream
+                                     )
+           );
+}
+
+static
+CPC_BOOL
+cahal_json_parse_stream_member  (
+                                 cahal_json_parser*  io_parser,
+                                 const CHAR*         in_key,
+                                 void*               io_context
+                                 )
+{
+  cahal_device_stream* stream = ( cahal_device_stream* ) io_context;
+
+  if( 0 == strcmp( in_key, "handle" ) )
+  {
+    return( cahal_json_parse_uint32( io_parser, &( stream->handle ) ) );
+  }
+  else if( 0 == strcmp( in_key, "direction" ) )
+  {
+    return( cahal_json_parse_uint32( io_parser, &( stream->direction ) ) );
+  }
+  else if( 0 == strcmp( in_key, "preferred_format" ) )
+  {
+    return  (
+             cahal_json_parse_uint32( io_parser, &( stream->preferred_format ) )
+             );
+  }
+  else if( 0 == strcmp( in_key, "supported_formats" ) )
+  {
+    return  (
+             cahal_json_parse_array  (
+                                      io_parser,
+                                      cahal_json_parse_format,
+                                      stream
+                                      )
+             );
+  }
+  else
+  {
+    return( cahal_json_skip_value( io_parser ) );
+  }
+}
+
+static
+CPC_BOOL
+cahal_json_parse_format  (
+                          cahal_json_parser*  io_parser,
+                          void*               io_context
+                          )
+{
+  cahal_device_stream* stream             = ( cahal_device_stream* ) io_context;
+  cahal_audio_format_description* format  = NULL;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &format,
+                            sizeof( cahal_audio_format_description )
+                            )
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  if  (
+       ! cahal_append_item  (
+                             ( void*** ) &( stream->supported_formats ),
+                             format
+                             )
+       )
+  {
+    cpc_safe_free( ( void** ) &format );
+
+    return( CPC_FALSE );
+  }
+
+  return  (
+           cahal_json_parse_object  (
+                                     io_parser,
+                                     cahal_json_parse_format_member,
+                                     format
+                                     )
+           );
+}
+
+static
+CPC_BOOL
+cahal_json_parse_format_member  (
+                                 cahal_json_parser*  io_parser,
+                                 const CHAR*         in_key,
+                                 void*               io_context
+                                 )
+{
+  cahal_audio_format_description* format =
+    ( cahal_audio_format_description* ) io_context;
+
+  if( 0 == strcmp( in_key, "format_id" ) )
+  {
+    return( cahal_json_parse_uint32( io_parser, &( format->format_id ) ) );
+  }
+  else if( 0 == strcmp( in_key, "number_of_channels" ) )
+  {
+    return  (
+             cahal_json_parse_uint32  (
+                                       io_parser,
+                                       &( format->number_of_channels )
+                                       )
+             );
+  }
+  else if( 0 == strcmp( in_key, "bit_depth" ) )
+  {
+    return( cahal_json_parse_uint32( io_parser, &( format->bit_depth ) ) );
+  }
+  else if( 0 == strcmp( in_key, "channel_layout" ) )
+  {
+    return  (
+             cahal_json_parse_uint32  (
+                                       io_parser,
+                                       &( format->channel_layout.layout_type )
+                                       )
+             );
+  }
+  else if( 0 == strcmp( in_key, "channel_positions" ) )
+  {
+    format->channel_layout.channel_mask = 0;
+
+    return  (
+             cahal_json_parse_array  (
+                                      io_parser,
+                                      cahal_json_parse_channel_position,
+                                      &( format->channel_layout )
+                                      )
+             );
+  }
+  else
+  {
+    //  The rates of a format are stored flat rather than as a nested range.
+    return  (
+             cahal_json_parse_sample_rate_range_member  (
+                                         io_parser,
+                                         in_key,
+                                         &( format->sample_rate_range )
+                                                         )
+             );
+  }
+}
+
+static
+CPC_BOOL
+cahal_json_parse_channel_position  (
+                                    cahal_json_parser*  io_parser,
+                                    void*               io_context
+                                    )
+{
+  cahal_channel_layout* layout  = ( cahal_channel_layout* ) io_context;
+  UINT32 position               = 0;
+  UINT64 bit                    = 0;
+
+  if  (
+       ! cahal_json_parse_uint32( io_parser, &position )
+       || CAHAL_MAXIMUM_NUMBER_OF_CHANNELS <= position
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  bit = ( ( UINT64 ) 1 ) << position;
+
+  if( layout->channel_mask & bit )
+  {
+    return( CPC_FALSE );
+  }
+
+  layout->channel_mask |= bit;
+
+  return( CPC_TRUE );
+}
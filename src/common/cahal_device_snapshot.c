@@ -0,0 +1,1315 @@
+/*! \file   cahal_device_snapshot.c
+
+    \author Brent Carrara
+ */
+#include "cahal.h"
+#include "cahal_device_snapshot.h"
+#include "cahal_device_index.h"
+#include "cahal_device_serialization.h"
+#include "cahal_profile.h"
+
+/*! \var    cahal_device_subscription
+    \brief  Struct definition for a device change subscription.
+ */
+typedef struct cahal_device_subscription_t
+{
+  /*! \var    identifier
+      \brief  The identifier of the subscription, 0 if the slot is free.
+   */
+  UINT32                        identifier;
+
+  /*! \var    callback
+      \brief  The callback of the subscription.
+   */
+  cahal_device_change_callback  callback;
+
+  /*! \var    user_data
+      \brief  User data passed to callback.
+   */
+  void*                         user_data;
+
+} cahal_device_subscription;
+
+/*! \var    g_current_snapshot
+    \brief  The current snapshot. The library holds one reference to it.
+            Protected by g_snapshot_lock.
+ */
+static cahal_device_snapshot* g_current_snapshot     = NULL;
+
+/*! \var    g_retired_snapshots
+    \brief  Pinned snapshots that have been replaced. The library holds one
+            reference to each until cahal_free_device_list. Protected by
+            g_publish_lock.
+ */
+static cahal_device_snapshot* g_retired_snapshots    = NULL;
+
+/*! \var    g_snapshot_lock
+    \brief  Spin lock held only while g_current_snapshot is read and
+            referenced or swapped.
+ */
+static cahal_atomic_uint32 g_snapshot_lock           = 0;
+
+/*! \var    g_publish_lock
+    \brief  Lock held while a snapshot is built or published, subscribers are
+            notified or the subscriptions are changed.
+ */
+static cahal_atomic_uint32 g_publish_lock            = 0;
+
+/*! \var    g_query_lock
+    \brief  Lock held while the OS is queried for its devices so that queries
+            never overlap. Taken before g_publish_lock.
+ */
+static cahal_atomic_uint32 g_query_lock              = 0;
+
+/*! \var    g_subscriptions
+    \brief  The device change subscriptions. Protected by g_publish_lock.
+ */
+static cahal_device_subscription
+  g_subscriptions[ CAHAL_DEVICE_MAXIMUM_SUBSCRIBERS ];
+
+/*! \var    g_last_subscription
+    \brief  The identifier of the last subscription. Protected by
+            g_publish_lock.
+ */
+static UINT32 g_last_subscription                    = 0;
+
+/*! \var    g_refresh_is_queued
+    \brief  Set while a refresh queued by cahal_schedule_device_list_refresh
+            has not started yet, so that a burst of OS notifications queues a
+            single refresh.
+ */
+static cahal_atomic_uint32 g_refresh_is_queued       = 0;
+
+/*! \fn     CPC_BOOL cahal_run_scheduled_refresh (
+              void* io_argument
+            )
+    \brief  The cahal_async_routine of cahal_schedule_device_list_refresh.
+
+    \param  io_argument Ignored.
+    \return The result of cahal_refresh_device_list, or false if CAHAL was
+            terminated since the refresh was queued.
+ */
+static
+CPC_BOOL
+cahal_run_scheduled_refresh (
+                             void* io_argument
+                             );
+
+/*! \fn     void cahal_lock_device_snapshots (
+              cahal_atomic_uint32* io_lock
+            )
+    \brief  Acquires io_lock, sleeping between attempts unless it is the
+            snapshot lock since the others may be held for a whole
+            enumeration.
+
+    \param  io_lock The lock to acquire.
+ */
+static
+void
+cahal_lock_device_snapshots (
+                             cahal_atomic_uint32* io_lock
+                             );
+
+/*! \fn     void cahal_unlock_device_snapshots (
+              cahal_atomic_uint32* io_lock
+            )
+    \brief  Releases io_lock.
+
+    \param  io_lock The lock to release.
+ */
+static
+void
+cahal_unlock_device_snapshots (
+                               cahal_atomic_uint32* io_lock
+                               );
+
+/*! \fn     CPC_BOOL cahal_can_query_devices( void )
+    \brief  Returns true iff the device list can be queried, i.e. CAHAL has
+            been initialized or the device list is replayed from a file.
+
+    \return True iff the device list can be queried.
+ */
+static
+CPC_BOOL
+cahal_can_query_devices( void );
+
+/*! \fn     cahal_device** cahal_query_devices (
+              cahal_device_list_callback  in_callback,
+              void*                       in_user_data
+            )
+    \brief  Reads the devices from the replay file if one is set, calling
+            in_callback with each device, or queries the OS otherwise.
+
+    \param  in_callback The callback to call with each device, or NULL.
+    \param  in_user_data  User data passed to in_callback.
+    \return A newly allocated heap list of devices, or NULL.
+ */
+static
+cahal_device**
+cahal_query_devices (
+                     cahal_device_list_callback  in_callback,
+                     void*                       in_user_data
+                     );
+
+/*! \fn     cahal_device_snapshot* cahal_create_device_snapshot  (
+              cahal_device** in_device_list,
+              UINT32         in_version
+            )
+    \brief  Packs in_device_list into a new snapshot with a reference count of
+            one.
+
+    \param  in_device_list  The heap allocated list. It is owned by the
+                            snapshot, or freed on error.
+    \param  in_version  The version of the snapshot.
+    \return The snapshot or NULL on error.
+ */
+static
+cahal_device_snapshot*
+cahal_create_device_snapshot  (
+                               cahal_device** in_device_list,
+                               UINT32         in_version
+                               );
+
+/*! \fn     void cahal_create_format_indexes  (
+              cahal_device_snapshot* io_snapshot
+            )
+    \brief  Builds the format index of every stream of io_snapshot. The
+            snapshot is left without indexes on error.
+
+    \param  io_snapshot The snapshot to index.
+ */
+static
+void
+cahal_create_format_indexes  (
+                              cahal_device_snapshot* io_snapshot
+                              );
+
+/*! \fn     CPC_BOOL cahal_load_snapshot_details  (
+              void* io_snapshot
+            )
+    \brief  The cahal_once_routine of cahal_load_device_snapshot_details.
+
+    \param  io_snapshot The cahal_device_snapshot.
+    \return True iff the format indexes were built.
+ */
+static
+CPC_BOOL
+cahal_load_snapshot_details  (
+                              void* io_snapshot
+                              );
+
+/*! \fn     void cahal_create_first_device_snapshot  (
+              cahal_device_list_callback  in_callback,
+              void*                       in_user_data
+            )
+    \brief  Queries the OS and publishes the first snapshot unless another
+            thread has done so already. Either way in_callback is called with
+            every device of the current snapshot.
+
+    \param  in_callback The callback to call with each device, or NULL.
+    \param  in_user_data  User data passed to in_callback.
+ */
+static
+void
+cahal_create_first_device_snapshot  (
+                                     cahal_device_list_callback  in_callback,
+                                     void*                       in_user_data
+                                     );
+
+/*! \fn     void cahal_set_current_device_snapshot (
+              cahal_device_snapshot* in_snapshot
+            )
+    \brief  Makes in_snapshot the current snapshot, transferring the caller's
+            reference to the library, and retires or releases the previous
+            one. Must be called with g_publish_lock held.
+
+    \param  in_snapshot The new current snapshot, or NULL.
+ */
+static
+void
+cahal_set_current_device_snapshot (
+                                   cahal_device_snapshot* in_snapshot
+                                   );
+
+/*! \fn     const CHAR* cahal_get_device_key  (
+              cahal_device* in_device
+            )
+    \brief  Returns the string that identifies in_device across snapshots.
+
+    \param  in_device The device.
+    \return The UID of the device, or its name if it has no UID.
+ */
+static
+const CHAR*
+cahal_get_device_key  (
+                       cahal_device* in_device
+                       );
+
+/*! \fn     CPC_BOOL cahal_device_formats_equal  (
+              cahal_device* in_device,
+              cahal_device* in_other_device
+            )
+    \brief  Compares the preferred settings, streams and formats of two
+            devices.
+
+    \param  in_device The first device.
+    \param  in_other_device The second device.
+    \return True iff both devices have the same streams and formats.
+ */
+static
+CPC_BOOL
+cahal_device_formats_equal  (
+                             cahal_device* in_device,
+                             cahal_device* in_other_device
+                             );
+
+/*! \fn     UINT32 cahal_notify_device_changes  (
+              cahal_device_snapshot* in_previous,
+              cahal_device_snapshot* in_current,
+              CPC_BOOL               in_notify
+            )
+    \brief  Counts the changes between two snapshots and, if in_notify is
+            true, calls every subscriber with each of them: removals first,
+            then additions, format changes and default changes. Must be called
+            with g_publish_lock held.
+
+    \param  in_previous The previous snapshot. May be NULL.
+    \param  in_current  The new snapshot.
+    \param  in_notify True to notify subscribers.
+    \return The number of changes.
+ */
+static
+UINT32
+cahal_notify_device_changes  (
+                              cahal_device_snapshot* in_previous,
+                              cahal_device_snapshot* in_current,
+                              CPC_BOOL               in_notify
+                              );
+
+/*! \fn     void cahal_notify_device_change (
+              cahal_device_change_type in_change,
+              cahal_device*            in_device,
+              cahal_device_snapshot*   in_snapshot
+            )
+    \brief  Calls every subscriber with one change. Must be called with
+            g_publish_lock held.
+
+    \param  in_change The kind of change.
+    \param  in_device The device that changed.
+    \param  in_snapshot The new snapshot.
+ */
+static
+void
+cahal_notify_device_change (
+                            cahal_device_change_type in_change,
+                            cahal_device*            in_device,
+                            cahal_device_snapshot*   in_snapshot
+                            );
+
+cahal_device**
+cahal_get_device_list( void )
+{
+  return( cahal_enumerate_devices( NULL, NULL ) );
+}
+
+cahal_device**
+cahal_enumerate_devices  (
+                          cahal_device_list_callback  in_callback,
+                          void*                       in_user_data
+                          )
+{
+  cahal_device** device_list = NULL;
+
+  if( ! cahal_can_query_devices() )
+  {
+    CPC_ERROR( "CAHAL has not been initialized: %d.", g_cahal_state );
+
+    return( NULL );
+  }
+
+  cahal_lock_device_snapshots( &g_publish_lock );
+
+  if( NULL == g_current_snapshot )
+  {
+    cahal_unlock_device_snapshots( &g_publish_lock );
+
+    cahal_create_first_device_snapshot( in_callback, in_user_data );
+
+    cahal_lock_device_snapshots( &g_publish_lock );
+  }
+  else
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_DEBUG,
+             "Returning existing device list: %p.",
+             ( void* ) g_current_snapshot
+             );
+
+    for (
+         UINT32 device_index = 0;
+         NULL != in_callback
+         && NULL != g_current_snapshot->devices[ device_index ];
+         device_index++
+         )
+    {
+      in_callback( g_current_snapshot->devices[ device_index ], in_user_data );
+    }
+  }
+
+  if( NULL != g_current_snapshot )
+  {
+    g_current_snapshot->pinned  = CPC_TRUE;
+    g_device_list               = g_current_snapshot->devices;
+    device_list                 = g_device_list;
+  }
+
+  cahal_unlock_device_snapshots( &g_publish_lock );
+
+  return( device_list );
+}
+
+void
+cahal_free_device_list( void )
+{
+  cahal_lock_device_snapshots( &g_publish_lock );
+
+  if( NULL == g_current_snapshot )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_WARN, "CAHAL device list is not set." );
+  }
+
+  cahal_set_current_device_snapshot( NULL );
+
+  while( NULL != g_retired_snapshots )
+  {
+    cahal_device_snapshot* snapshot = g_retired_snapshots;
+
+    g_retired_snapshots = snapshot->next_retired;
+
+    cahal_release_device_snapshot( snapshot );
+  }
+
+  g_device_list = NULL;
+
+  cahal_unlock_device_snapshots( &g_publish_lock );
+}
+
+cahal_device_snapshot*
+cahal_acquire_device_snapshot( void )
+{
+  cahal_device_snapshot* snapshot = NULL;
+
+  for( UINT32 attempt = 0; 2 > attempt && NULL == snapshot; attempt++ )
+  {
+    if( 0 < attempt )
+    {
+      if( ! cahal_can_query_devices() )
+      {
+        CPC_ERROR( "CAHAL has not been initialized: %d.", g_cahal_state );
+
+        break;
+      }
+
+      cahal_create_first_device_snapshot( NULL, NULL );
+    }
+
+    cahal_lock_device_snapshots( &g_snapshot_lock );
+
+    snapshot = g_current_snapshot;
+
+    if( NULL != snapshot )
+    {
+      CAHAL_ATOMIC_ADD( &( snapshot->reference_count ), 1 );
+    }
+
+    cahal_unlock_device_snapshots( &g_snapshot_lock );
+  }
+
+  return( snapshot );
+}
+
+void
+cahal_release_device_snapshot (
+                               cahal_device_snapshot* in_snapshot
+                               )
+{
+  if  (
+       NULL != in_snapshot
+       && 0 == CAHAL_ATOMIC_ADD( &( in_snapshot->reference_count ), -1 )
+       )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_DEBUG,
+             "Freeing device snapshot version %d.",
+             in_snapshot->version
+             );
+
+    for  (
+          UINT32 i = 0;
+          NULL != in_snapshot->format_indexes
+          && NULL != in_snapshot->format_indexes[ i ];
+          i++
+          )
+    {
+      cahal_free_format_index( in_snapshot->format_indexes[ i ] );
+    }
+
+    cpc_safe_free( ( void** ) &( in_snapshot->format_indexes ) );
+
+    cahal_free_device_index( in_snapshot->device_index );
+
+    if( NULL != in_snapshot->arena )
+    {
+      for( UINT32 i = 0; i < in_snapshot->number_of_devices; i++ )
+      {
+        cahal_free_device_details( in_snapshot->devices[ i ] );
+      }
+
+      cahal_arena_free( in_snapshot->arena );
+    }
+    else if( NULL != in_snapshot->devices )
+    {
+      for( UINT32 i = 0; NULL != in_snapshot->devices[ i ]; i++ )
+      {
+        cahal_free_device( in_snapshot->devices[ i ] );
+      }
+
+      cpc_safe_free( ( void** ) &( in_snapshot->devices ) );
+    }
+
+    cpc_safe_free( ( void** ) &in_snapshot );
+  }
+}
+
+UINT32
+cahal_subscribe_device_changes (
+                                cahal_device_change_callback  in_callback,
+                                void*                         in_user_data
+                                )
+{
+  UINT32 identifier = 0;
+
+  if( NULL == in_callback )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid device change callback." );
+
+    return( 0 );
+  }
+
+  cahal_lock_device_snapshots( &g_publish_lock );
+
+  for( UINT32 i = 0; i < CAHAL_DEVICE_MAXIMUM_SUBSCRIBERS; i++ )
+  {
+    if( 0 == g_subscriptions[ i ].identifier )
+    {
+      g_last_subscription++;
+
+      if( 0 == g_last_subscription )
+      {
+        g_last_subscription++;
+      }
+
+      identifier = g_last_subscription;
+
+      g_subscriptions[ i ].identifier = identifier;
+      g_subscriptions[ i ].callback   = in_callback;
+      g_subscriptions[ i ].user_data  = in_user_data;
+
+      break;
+    }
+  }
+
+  cahal_unlock_device_snapshots( &g_publish_lock );
+
+  if( 0 == identifier )
+  {
+    CPC_ERROR (
+               "All %d device change subscriptions are in use.",
+               CAHAL_DEVICE_MAXIMUM_SUBSCRIBERS
+               );
+  }
+
+  return( identifier );
+}
+
+void
+cahal_unsubscribe_device_changes (
+                                  UINT32 in_subscription
+                                  )
+{
+  cahal_lock_device_snapshots( &g_publish_lock );
+
+  for (
+       UINT32 i = 0;
+       0 != in_subscription && i < CAHAL_DEVICE_MAXIMUM_SUBSCRIBERS;
+       i++
+       )
+  {
+    if( in_subscription == g_subscriptions[ i ].identifier )
+    {
+      CPC_MEMSET  (
+                   &( g_subscriptions[ i ] ),
+                   0,
+                   sizeof( cahal_device_subscription )
+                   );
+    }
+  }
+
+  cahal_unlock_device_snapshots( &g_publish_lock );
+}
+
+CPC_BOOL
+cahal_refresh_device_list( void )
+{
+  if( ! cahal_can_query_devices() )
+  {
+    CPC_ERROR( "CAHAL has not been initialized: %d.", g_cahal_state );
+
+    return( CPC_FALSE );
+  }
+
+  CPC_BOOL result = CPC_FALSE;
+  UINT32 stage    = cahal_profile_begin( "cahal_refresh_device_list" );
+
+  //  The OS is queried without holding the locks taken by readers and
+  //  publishers, so they are not held up by the enumeration.
+  cahal_lock_device_snapshots( &g_query_lock );
+
+  result = cahal_update_device_list( cahal_query_devices( NULL, NULL ) );
+
+  cahal_unlock_device_snapshots( &g_query_lock );
+
+  cahal_profile_end( stage );
+
+  return( result );
+}
+
+void
+cahal_lock_device_queries( void )
+{
+  cahal_lock_device_snapshots( &g_query_lock );
+}
+
+void
+cahal_unlock_device_queries( void )
+{
+  cahal_unlock_device_snapshots( &g_query_lock );
+}
+
+void
+cahal_schedule_device_list_refresh( void )
+{
+  cahal_async_operation* operation = NULL;
+
+  if( CAHAL_ATOMIC_COMPARE_AND_SWAP( &g_refresh_is_queued, 0, 1 ) )
+  {
+    operation =
+      cahal_async_submit( cahal_run_scheduled_refresh, NULL, NULL, NULL );
+
+    if( NULL == operation )
+    {
+      CAHAL_ATOMIC_STORE( &g_refresh_is_queued, 0 );
+    }
+    else
+    {
+      cahal_async_release( operation );
+    }
+  }
+}
+
+CPC_BOOL
+cahal_update_device_list (
+                          cahal_device** in_device_list
+                          )
+{
+  cahal_device_snapshot* snapshot = NULL;
+  UINT32 number_of_changes        = 0;
+
+  cahal_lock_device_snapshots( &g_publish_lock );
+
+  snapshot  =
+    cahal_create_device_snapshot  (
+              in_device_list,
+              NULL == g_current_snapshot ? 1 : g_current_snapshot->version + 1
+                                   );
+
+  if( NULL == snapshot )
+  {
+    cahal_unlock_device_snapshots( &g_publish_lock );
+
+    return( CPC_FALSE );
+  }
+
+  number_of_changes =
+    cahal_notify_device_changes( g_current_snapshot, snapshot, CPC_FALSE );
+
+  if( NULL != g_current_snapshot && 0 == number_of_changes )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_DEBUG,
+             "Device list version %d is unchanged.",
+             g_current_snapshot->version
+             );
+
+    cahal_release_device_snapshot( snapshot );
+  }
+  else
+  {
+    cahal_device_snapshot* previous = g_current_snapshot;
+
+    //  Keep the previous snapshot alive until every subscriber has seen the
+    //  devices that were removed from it.
+    if( NULL != previous )
+    {
+      CAHAL_ATOMIC_ADD( &( previous->reference_count ), 1 );
+    }
+
+    cahal_set_current_device_snapshot( snapshot );
+
+    CPC_LOG (
+             CPC_LOG_LEVEL_INFO,
+             "Published device list version %d with %d change(s).",
+             snapshot->version,
+             number_of_changes
+             );
+
+    cahal_notify_device_changes( previous, snapshot, CPC_TRUE );
+
+    cahal_release_device_snapshot( previous );
+  }
+
+  cahal_unlock_device_snapshots( &g_publish_lock );
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_load_device_snapshot_details (
+                                    cahal_device_snapshot* io_snapshot
+                                    )
+{
+  if( NULL == io_snapshot )
+  {
+    return( CPC_FALSE );
+  }
+
+  return  (
+           cahal_call_once  (
+                             &( io_snapshot->details_state ),
+                             cahal_load_snapshot_details,
+                             io_snapshot
+                             )
+           );
+}
+
+cahal_format_index*
+cahal_get_format_index (
+                        cahal_device_snapshot* in_snapshot,
+                        cahal_device_stream*   in_stream
+                        )
+{
+  if( NULL == in_snapshot || NULL == in_stream )
+  {
+    return( NULL );
+  }
+
+  cahal_load_device_snapshot_details( in_snapshot );
+
+  for  (
+        UINT32 i = 0;
+        NULL != in_snapshot->format_indexes
+        && NULL != in_snapshot->format_indexes[ i ];
+        i++
+        )
+  {
+    if( in_snapshot->format_indexes[ i ]->stream == in_stream )
+    {
+      return( in_snapshot->format_indexes[ i ] );
+    }
+  }
+
+  return( NULL );
+}
+
+static
+void
+cahal_lock_device_snapshots (
+                             cahal_atomic_uint32* io_lock
+                             )
+{
+  while( ! CAHAL_ATOMIC_COMPARE_AND_SWAP( io_lock, 0, 1 ) )
+  {
+    if( &g_snapshot_lock != io_lock )
+    {
+      cahal_sleep( 1 );
+    }
+  }
+}
+
+static
+void
+cahal_unlock_device_snapshots (
+                               cahal_atomic_uint32* io_lock
+                               )
+{
+  CAHAL_ATOMIC_STORE( io_lock, 0 );
+}
+
+static
+cahal_device_snapshot*
+cahal_create_device_snapshot  (
+                               cahal_device** in_device_list,
+                               UINT32         in_version
+                               )
+{
+  cahal_device_snapshot* snapshot = NULL;
+  cahal_device** device_list      = in_device_list;
+  UINT32 stage                    = CAHAL_PROFILE_NO_STAGE;
+
+  if  (
+       NULL == device_list
+       && CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc( ( void** ) &device_list, sizeof( cahal_device* ) )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc device list." );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &snapshot,
+                            sizeof( cahal_device_snapshot )
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc device snapshot." );
+
+    for( UINT32 i = 0; NULL != device_list[ i ]; i++ )
+    {
+      cahal_free_device( device_list[ i ] );
+    }
+
+    cpc_safe_free( ( void** ) &device_list );
+
+    return( NULL );
+  }
+
+  stage                     = cahal_profile_begin( "cahal_pack_device_list" );
+  snapshot->devices         =
+    cahal_pack_device_list( device_list, &( snapshot->arena ) );
+  snapshot->version         = in_version;
+
+  cahal_profile_end( stage );
+
+  snapshot->reference_count = 1;
+
+  while( NULL != snapshot->devices[ snapshot->number_of_devices ] )
+  {
+    if  (
+         CAHAL_ONCE_PENDING
+         == snapshot->devices[ snapshot->number_of_devices ]->details_state
+         )
+    {
+      snapshot->details_state = CAHAL_ONCE_PENDING;
+    }
+
+    snapshot->number_of_devices++;
+  }
+
+  if( CAHAL_ONCE_DONE == snapshot->details_state )
+  {
+    stage = cahal_profile_begin( "cahal_create_format_indexes" );
+
+    cahal_create_format_indexes( snapshot );
+
+    cahal_profile_end( stage );
+  }
+
+  stage                   = cahal_profile_begin( "cahal_create_device_index" );
+  snapshot->device_index  = cahal_create_device_index( snapshot );
+
+  cahal_profile_end( stage );
+
+  if( NULL == snapshot->device_index )
+  {
+    cahal_release_device_snapshot( snapshot );
+
+    return( NULL );
+  }
+
+  return( snapshot );
+}
+
+static
+void
+cahal_create_format_indexes  (
+                              cahal_device_snapshot* io_snapshot
+                              )
+{
+  UINT32 number_of_streams  = 0;
+  UINT32 index              = 0;
+
+  for( UINT32 i = 0; i < io_snapshot->number_of_devices; i++ )
+  {
+    cahal_device_stream** streams = io_snapshot->devices[ i ]->device_streams;
+
+    for( UINT32 j = 0; NULL != streams && NULL != streams[ j ]; j++ )
+    {
+      number_of_streams++;
+    }
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &( io_snapshot->format_indexes ),
+                            sizeof( cahal_format_index* )
+                            * ( number_of_streams + 1 )
+                            )
+       )
+  {
+    CPC_ERROR( "Could not malloc format indexes: 0x%x.", number_of_streams );
+
+    return;
+  }
+
+  for( UINT32 i = 0; i < io_snapshot->number_of_devices; i++ )
+  {
+    cahal_device_stream** streams = io_snapshot->devices[ i ]->device_streams;
+
+    for( UINT32 j = 0; NULL != streams && NULL != streams[ j ]; j++ )
+    {
+      io_snapshot->format_indexes[ index ] =
+        cahal_create_format_index( streams[ j ] );
+
+      if( NULL == io_snapshot->format_indexes[ index ] )
+      {
+        for( UINT32 k = 0; k < index; k++ )
+        {
+          cahal_free_format_index( io_snapshot->format_indexes[ k ] );
+        }
+
+        cpc_safe_free( ( void** ) &( io_snapshot->format_indexes ) );
+
+        return;
+      }
+
+      index++;
+    }
+  }
+}
+
+static
+CPC_BOOL
+cahal_load_snapshot_details  (
+                              void* io_snapshot
+                              )
+{
+  cahal_device_snapshot* snapshot = ( cahal_device_snapshot* ) io_snapshot;
+  UINT32 stage                    =
+    cahal_profile_begin( "cahal_load_device_snapshot_details" );
+
+  for( UINT32 i = 0; i < snapshot->number_of_devices; i++ )
+  {
+    cahal_load_device_details( snapshot->devices[ i ] );
+  }
+
+  cahal_create_format_indexes( snapshot );
+
+  cahal_index_device_capabilities( snapshot );
+
+  cahal_profile_end( stage );
+
+  return( NULL != snapshot->format_indexes );
+}
+
+static
+void
+cahal_create_first_device_snapshot  (
+                                     cahal_device_list_callback  in_callback,
+                                     void*                       in_user_data
+                                     )
+{
+  cahal_lock_device_snapshots( &g_query_lock );
+
+  if( NULL == g_current_snapshot )
+  {
+    UINT32 stage                    =
+      cahal_profile_begin( "cahal_create_first_device_snapshot" );
+    cahal_device_snapshot* snapshot =
+      cahal_create_device_snapshot  (
+                      cahal_query_devices( in_callback, in_user_data ),
+                      1
+                                     );
+
+    cahal_lock_device_snapshots( &g_publish_lock );
+
+    //  Only queries publish a first snapshot, but cahal_update_device_list
+    //  may have published one in the meantime.
+    if( NULL == g_current_snapshot )
+    {
+      cahal_set_current_device_snapshot( snapshot );
+
+      CPC_LOG (
+               CPC_LOG_LEVEL_DEBUG,
+               "Generated device list: %p.",
+               ( void* ) g_current_snapshot
+               );
+    }
+    else
+    {
+      cahal_release_device_snapshot( snapshot );
+    }
+
+    cahal_unlock_device_snapshots( &g_publish_lock );
+
+    cahal_profile_end( stage );
+  }
+  else
+  {
+    cahal_lock_device_snapshots( &g_publish_lock );
+
+    for (
+         UINT32 device_index = 0;
+         NULL != in_callback
+         && NULL != g_current_snapshot
+         && NULL != g_current_snapshot->devices[ device_index ];
+         device_index++
+         )
+    {
+      in_callback( g_current_snapshot->devices[ device_index ], in_user_data );
+    }
+
+    cahal_unlock_device_snapshots( &g_publish_lock );
+  }
+
+  cahal_unlock_device_snapshots( &g_query_lock );
+}
+
+static
+void
+cahal_set_current_device_snapshot (
+                                   cahal_device_snapshot* in_snapshot
+                                   )
+{
+  cahal_device_snapshot* previous = NULL;
+
+  cahal_lock_device_snapshots( &g_snapshot_lock );
+
+  previous            = g_current_snapshot;
+  g_current_snapshot  = in_snapshot;
+
+  cahal_unlock_device_snapshots( &g_snapshot_lock );
+
+  if( NULL != previous && previous->pinned )
+  {
+    //  The list may still be in use by callers of cahal_get_device_list,
+    //  e.g. by a running stream, so it is kept until the library is
+    //  terminated.
+    previous->next_retired  = g_retired_snapshots;
+    g_retired_snapshots     = previous;
+
+    g_device_list = NULL;
+  }
+  else
+  {
+    cahal_release_device_snapshot( previous );
+  }
+}
+
+static
+const CHAR*
+cahal_get_device_key  (
+                       cahal_device* in_device
+                       )
+{
+  return  (
+           NULL != in_device->device_uid
+           ? in_device->device_uid
+           : in_device->device_name
+           );
+}
+
+static
+CPC_BOOL
+cahal_device_formats_equal  (
+                             cahal_device* in_device,
+                             cahal_device* in_other_device
+                             )
+{
+  cahal_device_stream** streams       = in_device->device_streams;
+  cahal_device_stream** other_streams = in_other_device->device_streams;
+  UINT32 i                            = 0;
+
+  //  Details that have not been loaded on both sides cannot be compared, and
+  //  comparing them would load them.
+  if  (
+       CAHAL_ONCE_DONE != CAHAL_ATOMIC_LOAD( &( in_device->details_state ) )
+       || CAHAL_ONCE_DONE
+          != CAHAL_ATOMIC_LOAD( &( in_other_device->details_state ) )
+       )
+  {
+    return( CPC_TRUE );
+  }
+
+  if  (
+       in_device->preferred_sample_rate
+       != in_other_device->preferred_sample_rate
+       || in_device->preferred_number_of_channels
+          != in_other_device->preferred_number_of_channels
+       || ( NULL == streams ) != ( NULL == other_streams )
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  for( i = 0; NULL != streams && NULL != streams[ i ]; i++ )
+  {
+    cahal_audio_format_description** formats        = NULL;
+    cahal_audio_format_description** other_formats  = NULL;
+    UINT32 j                                        = 0;
+
+    if  (
+         NULL == other_streams[ i ]
+         || streams[ i ]->direction != other_streams[ i ]->direction
+         || streams[ i ]->preferred_format
+            != other_streams[ i ]->preferred_format
+         )
+    {
+      return( CPC_FALSE );
+    }
+
+    formats       = streams[ i ]->supported_formats;
+    other_formats = other_streams[ i ]->supported_formats;
+
+    if( ( NULL == formats ) != ( NULL == other_formats ) )
+    {
+      return( CPC_FALSE );
+    }
+
+    for( j = 0; NULL != formats && NULL != formats[ j ]; j++ )
+    {
+      if  (
+           NULL == other_formats[ j ]
+           || formats[ j ]->format_id != other_formats[ j ]->format_id
+           || formats[ j ]->number_of_channels
+              != other_formats[ j ]->number_of_channels
+           || formats[ j ]->bit_depth != other_formats[ j ]->bit_depth
+           || formats[ j ]->sample_rate_range.minimum_rate
+              != other_formats[ j ]->sample_rate_range.minimum_rate
+           || formats[ j ]->sample_rate_range.maximum_rate
+              != other_formats[ j ]->sample_rate_range.maximum_rate
+           || formats[ j ]->channel_layout.layout_type
+              != other_formats[ j ]->channel_layout.layout_type
+           || formats[ j ]->channel_layout.channel_mask
+              != other_formats[ j ]->channel_layout.channel_mask
+           )
+      {
+        return( CPC_FALSE );
+      }
+    }
+
+    if( NULL != other_formats && NULL != other_formats[ j ] )
+    {
+      return( CPC_FALSE );
+    }
+  }
+
+  return( NULL == other_streams || NULL == other_streams[ i ] );
+}
+
+static
+UINT32
+cahal_notify_device_changes  (
+                              cahal_device_snapshot* in_previous,
+                              cahal_device_snapshot* in_current,
+                              CPC_BOOL               in_notify
+                              )
+{
+  UINT32 number_of_changes                    = 0;
+  cahal_device_stream_direction directions[]  =
+  {
+    CAHAL_DEVICE_OUTPUT_STREAM, CAHAL_DEVICE_INPUT_STREAM
+  };
+
+  for (
+       UINT32 i = 0;
+       NULL != in_previous && i < in_previous->number_of_devices;
+       i++
+       )
+  {
+    cahal_device* device = in_previous->devices[ i ];
+
+    if  (
+         NULL
+         == cahal_find_device_by_key  (
+                                       in_current,
+                                       cahal_get_device_key( device )
+                                       )
+         )
+    {
+      number_of_changes++;
+
+      if( in_notify )
+      {
+        cahal_notify_device_change  (
+                                     CAHAL_DEVICE_CHANGE_REMOVED,
+                                     device,
+                                     in_current
+                                     );
+      }
+    }
+  }
+
+  for( UINT32 i = 0; i < in_current->number_of_devices; i++ )
+  {
+    cahal_device* device          = in_current->devices[ i ];
+    cahal_device* previous_device =
+      cahal_find_device_by_key  (
+                                 in_previous,
+                                 cahal_get_device_key( device )
+                                 );
+    cahal_device_change_type change = CAHAL_DEVICE_CHANGE_ADDED;
+
+    if( NULL != previous_device )
+    {
+      if( cahal_device_formats_equal( device, previous_device ) )
+      {
+        continue;
+      }
+
+      change = CAHAL_DEVICE_CHANGE_FORMAT_CHANGED;
+    }
+
+    number_of_changes++;
+
+    if( in_notify )
+    {
+      cahal_notify_device_change( change, device, in_current );
+    }
+  }
+
+  for( UINT32 i = 0; i < sizeof( directions ) / sizeof( directions[ 0 ] ); i++ )
+  {
+    cahal_device* device          =
+      cahal_find_default_device( in_current, directions[ i ] );
+    cahal_device* previous_device =
+      cahal_find_default_device( in_previous, directions[ i ] );
+
+    if  (
+         NULL != device
+         && previous_device
+            != cahal_find_device_by_key  (
+                                          in_previous,
+                                          cahal_get_device_key( device )
+                                          )
+         )
+    {
+      number_of_changes++;
+
+      if( in_notify )
+      {
+        cahal_notify_device_change  (
+                                     CAHAL_DEVICE_CHANGE_DEFAULT_CHANGED,
+                                     device,
+                                     in_current
+                                     );
+      }
+    }
+  }
+
+  return( number_of_changes );
+}
+
+static
+void
+cahal_notify_device_change (
+                            cahal_device_change_type in_change,
+                            cahal_device*            in_device,
+                            cahal_device_snapshot*   in_snapshot
+                            )
+{
+  CPC_LOG (
+           CPC_LOG_LEVEL_DEBUG,
+           "Device change %d: %s.",
+           in_change,
+           cahal_get_device_key( in_device )
+           );
+
+  for( UINT32 i = 0; i < CAHAL_DEVICE_MAXIMUM_SUBSCRIBERS; i++ )
+  {
+    if( 0 != g_subscriptions[ i ].identifier )
+    {
+      g_subscriptions[ i ].callback (
+                                     in_change,
+                                     in_device,
+                                     in_snapshot,
+                                     g_subscriptions[ i ].user_data
+                                     );
+    }
+  }
+}
+
+static
+CPC_BOOL
+cahal_can_query_devices( void )
+{
+  return  (
+           CAHAL_STATE_INITIALIZED == g_cahal_state
+           || NULL != g_device_replay_path
+           );
+}
+
+static
+cahal_device**
+cahal_query_devices (
+                     cahal_device_list_callback  in_callback,
+                     void*                       in_user_data
+                     )
+{
+  cahal_device** device_list = NULL;
+  UINT32 stage               = cahal_profile_begin( "cahal_query_devices" );
+
+  if( NULL == g_device_replay_path )
+  {
+    device_list = cahal_query_device_list( in_callback, in_user_data );
+  }
+  else
+  {
+    device_list = cahal_load_device_list( g_device_replay_path );
+
+    for  (
+          UINT32 i = 0;
+          NULL != in_callback
+          && NULL != device_list
+          && NULL != device_list[ i ];
+          i++
+          )
+    {
+      in_callback( device_list[ i ], in_user_data );
+    }
+  }
+
+  cahal_profile_end( stage );
+
+  return( device_list );
+}
+
+static
+CPC_BOOL
+cahal_run_scheduled_refresh (
+                             void* io_argument
+                             )
+{
+  //  Cleared before querying so that a change notified during the query
+  //  queues another refresh
+  CAHAL_ATOMIC_STORE( &g_refresh_is_queued, 0 );
+
+  return  (
+           CAHAL_STATE_INITIALIZED == CAHAL_ATOMIC_LOAD( &g_cahal_state )
+           && cahal_refresh_device_list()
+           );
+}
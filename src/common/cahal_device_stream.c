@@ -83,25 +83,24 @@ cahal_free_device_stream_list (
     
     while( NULL != device_stream )
     {
-      if( NULL != device_stream->supported_formats )
-      {
-        UINT32 format_index = 0;
-        cahal_audio_format_description* format =
-        device_stream->supported_formats[ format_index++ ];
-        
-        while( NULL != format )
-        {
-          cpc_safe_free( ( void** ) &format );
-          
-          format = device_stream->supported_formats[ format_index++ ];
-        }
-        
-        cpc_safe_free( ( void** ) &device_stream->supported_formats );
-      }
-      
-      cpc_safe_free( ( void** ) &device_stream );
+      cahal_free_device_stream( device_stream );
       
       device_stream = in_device_stream_list[ stream_index++ ];
     }
   }
 }
+
+void
+cahal_free_device_stream  (
+                           cahal_device_stream* in_device_stream
+                           )
+{
+  if( NULL != in_device_stream )
+  {
+    cahal_free_audio_format_description_list  (
+                                        in_device_stream->supported_formats
+                                               );
+
+    cpc_safe_free( ( void** ) &in_device_stream );
+  }
+}
@@ -0,0 +1,617 @@
+/*! \file   cahal_dispatcher.c
+
+    \author Brent Carrara
+ */
+#include "cahal_dispatcher.h"
+
+#include "cahal_audio_convert.h"
+#include "cahal_callback.h"
+
+/*! \var    g_dispatch_options
+    \brief  The options set using cahal_set_dispatch_options.
+ */
+static cahal_dispatch_options g_dispatch_options;
+
+/*! \var    g_is_dispatching
+    \brief  True iff new streams get a dispatch thread.
+ */
+static CPC_BOOL g_is_dispatching = CPC_FALSE;
+
+/*! \fn     void cahal_dispatcher_run  (
+              void* in_argument
+            )
+    \brief  The routine of a dispatch thread.
+
+    \param  in_argument The cahal_dispatcher the thread belongs to.
+ */
+static
+void
+cahal_dispatcher_run  (
+                       void* in_argument
+                       );
+
+/*! \fn     CPC_BOOL cahal_dispatcher_process_packet  (
+              cahal_dispatcher* io_dispatcher
+            )
+    \brief  Passes the oldest recorded buffer in the ring buffer to the
+            recording, or discards it once a callback has failed.
+
+    \param  io_dispatcher The dispatcher of the recording.
+    \return True iff a complete buffer was in the ring buffer.
+ */
+static
+CPC_BOOL
+cahal_dispatcher_process_packet  (
+                                  cahal_dispatcher* io_dispatcher
+                                  );
+
+/*! \fn     void cahal_dispatcher_render  (
+              cahal_dispatcher* io_dispatcher
+            )
+    \brief  Calls the playback callback until target_fill bytes are rendered
+            ahead, the callback fails or it returns no samples.
+
+    \param  io_dispatcher The dispatcher of the playback.
+ */
+static
+void
+cahal_dispatcher_render  (
+                          cahal_dispatcher* io_dispatcher
+                          );
+
+/*! \fn     void cahal_dispatcher_release  (
+              cahal_dispatcher* in_dispatcher
+            )
+    \brief  Frees the buffers and semaphores of a dispatcher whose thread is
+            not running, then the dispatcher itself.
+
+    \param  in_dispatcher The dispatcher to free.
+ */
+static
+void
+cahal_dispatcher_release  (
+                           cahal_dispatcher* in_dispatcher
+                           );
+
+void
+cahal_set_dispatch_options  (
+                             const cahal_dispatch_options* in_options
+                             )
+{
+  if( NULL == in_options )
+  {
+    g_is_dispatching = CPC_FALSE;
+  }
+  else
+  {
+    g_dispatch_options  = *in_options;
+    g_is_dispatching    = CPC_TRUE;
+  }
+}
+
+CPC_BOOL
+cahal_get_dispatch_options  (
+                             cahal_dispatch_options* out_options
+                             )
+{
+  if( g_is_dispatching && NULL != out_options )
+  {
+    *out_options = g_dispatch_options;
+  }
+
+  return( g_is_dispatching );
+}
+
+cahal_dispatcher*
+cahal_dispatcher_create  (
+                          const cahal_dispatch_options*  in_options,
+                          cahal_device_stream_direction  in_direction,
+                          void*                          in_stream_info,
+                          UINT32                         in_buffer_size
+                          )
+{
+  cahal_dispatcher* dispatcher  = NULL;
+  UINT32 ring_size              = 0;
+
+  if( NULL == in_options || NULL == in_stream_info || 0 == in_buffer_size )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid dispatcher parameters." );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc (
+                           ( void** ) &dispatcher,
+                           sizeof( cahal_dispatcher )
+                           )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not allocate dispatcher." );
+
+    return( NULL );
+  }
+
+  dispatcher->options     = *in_options;
+  dispatcher->direction   = in_direction;
+  dispatcher->stream_info = in_stream_info;
+
+  if( 0.0 >= dispatcher->options.scheduling.period )
+  {
+    dispatcher->options.scheduling.period = CAHAL_DISPATCH_DEFAULT_PERIOD;
+  }
+
+  if( 0 == dispatcher->options.number_of_periods )
+  {
+    dispatcher->options.number_of_periods =
+      CAHAL_DISPATCH_DEFAULT_NUMBER_OF_PERIODS;
+  }
+
+  if( CAHAL_DEVICE_INPUT_STREAM == in_direction )
+  {
+    cahal_recorder_info* recorder_info =
+      ( cahal_recorder_info* ) in_stream_info;
+
+    dispatcher->frame_size  =
+      cahal_get_bytes_per_sample( recorder_info->bit_depth )
+      * recorder_info->number_of_channels;
+    dispatcher->buffer_size = in_buffer_size;
+
+    ring_size =
+      CAHAL_DISPATCH_NUMBER_OF_RECORDED_BUFFERS
+      * ( sizeof( cahal_dispatch_packet_header ) + in_buffer_size );
+  }
+  else
+  {
+    cahal_playback_info* playback_info =
+      ( cahal_playback_info* ) in_stream_info;
+    UINT32 number_of_frames             =
+      ( UINT32 ) ( playback_info->sample_rate
+                   * dispatcher->options.scheduling.period );
+
+    dispatcher->frame_size  =
+      cahal_get_bytes_per_sample( playback_info->bit_depth )
+      * playback_info->number_of_channels;
+
+    if( 0 == dispatcher->frame_size )
+    {
+      dispatcher->frame_size = 1;
+    }
+
+    if( 0 == number_of_frames )
+    {
+      number_of_frames = 1;
+    }
+
+    dispatcher->buffer_size = number_of_frames * dispatcher->frame_size;
+    dispatcher->target_fill =
+      in_buffer_size
+      + dispatcher->options.number_of_periods * dispatcher->buffer_size;
+
+    ring_size = dispatcher->target_fill;
+  }
+
+  if( ! cahal_semaphore_initialize( &( dispatcher->wake ) ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not create semaphore." );
+
+    cpc_safe_free( ( void** ) &dispatcher );
+
+    return( NULL );
+  }
+
+  if( ! cahal_semaphore_initialize( &( dispatcher->ready ) ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not create semaphore." );
+
+    cahal_semaphore_destroy( &( dispatcher->wake ) );
+    cpc_safe_free( ( void** ) &dispatcher );
+
+    return( NULL );
+  }
+
+  dispatcher->ring_buffer = cahal_ring_buffer_create( ring_size );
+
+  if  (
+       NULL == dispatcher->ring_buffer
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( dispatcher->buffer ),
+                               dispatcher->buffer_size
+                               )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not allocate buffers." );
+
+    cahal_dispatcher_release( dispatcher );
+
+    return( NULL );
+  }
+
+  if  (
+       ! cahal_thread_create  (
+                               &( dispatcher->thread ),
+                               cahal_dispatcher_run,
+                               dispatcher
+                               )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not start dispatch thread." );
+
+    cahal_dispatcher_release( dispatcher );
+
+    return( NULL );
+  }
+
+  cahal_semaphore_wait( &( dispatcher->ready ) );
+
+  if( ! dispatcher->is_scheduled )
+  {
+    CPC_LOG_STRING  (
+                     CPC_LOG_LEVEL_WARN,
+                     "Dispatch thread runs with the default scheduling."
+                     );
+  }
+
+  return( dispatcher );
+}
+
+void
+cahal_dispatcher_free  (
+                        cahal_dispatcher* in_dispatcher
+                        )
+{
+  if( NULL == in_dispatcher )
+  {
+    return;
+  }
+
+  CAHAL_ATOMIC_STORE( &( in_dispatcher->is_stopping ), 1 );
+
+  cahal_semaphore_post( &( in_dispatcher->wake ) );
+  cahal_thread_join( &( in_dispatcher->thread ) );
+
+  if  (
+       0 != CAHAL_ATOMIC_LOAD( &( in_dispatcher->number_of_overruns ) )
+       || 0 != CAHAL_ATOMIC_LOAD( &( in_dispatcher->number_of_underruns ) )
+       )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_INFO,
+             "Dispatcher had %d overrun(s) and %d underrun(s).",
+             CAHAL_ATOMIC_LOAD( &( in_dispatcher->number_of_overruns ) ),
+             CAHAL_ATOMIC_LOAD( &( in_dispatcher->number_of_underruns ) )
+             );
+  }
+
+  cahal_dispatcher_release( in_dispatcher );
+}
+
+CPC_BOOL
+cahal_dispatcher_push_recording  (
+                                  cahal_dispatcher* io_dispatcher,
+                                  const UCHAR*      in_data_buffer,
+                                  UINT32            in_data_buffer_length,
+                                  UINT64            in_record_time
+                                  )
+{
+  cahal_dispatch_packet_header header;
+
+  if( CAHAL_ATOMIC_LOAD( &( io_dispatcher->has_failed ) ) )
+  {
+    return( CPC_FALSE );
+  }
+
+  header.length       = in_data_buffer_length;
+  header.record_time  = in_record_time;
+
+  //  The header is published before the samples; the dispatch thread only
+  //  reads a packet once the ring buffer holds all of it.
+  if  (
+       in_data_buffer_length <= io_dispatcher->buffer_size
+       && sizeof( cahal_dispatch_packet_header ) + in_data_buffer_length
+          <= cahal_ring_buffer_get_space( io_dispatcher->ring_buffer )
+       )
+  {
+    cahal_ring_buffer_write (
+                             io_dispatcher->ring_buffer,
+                             ( UCHAR* ) &header,
+                             sizeof( cahal_dispatch_packet_header )
+                             );
+    cahal_ring_buffer_write (
+                             io_dispatcher->ring_buffer,
+                             in_data_buffer,
+                             in_data_buffer_length
+                             );
+
+    cahal_semaphore_post( &( io_dispatcher->wake ) );
+  }
+  else
+  {
+    CAHAL_ATOMIC_ADD( &( io_dispatcher->number_of_overruns ), 1 );
+  }
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_dispatcher_pull_playback  (
+                                 cahal_dispatcher* io_dispatcher,
+                                 UCHAR*            out_data_buffer,
+                                 UINT32*           io_data_buffer_length,
+                                 UINT32            in_queued_bytes
+                                 )
+{
+  UINT32 capacity = *io_data_buffer_length;
+  UINT32 length   = 0;
+
+  capacity -= capacity % io_dispatcher->frame_size;
+  length    =
+    cahal_ring_buffer_read  (
+                             io_dispatcher->ring_buffer,
+                             out_data_buffer,
+                             capacity
+                             );
+
+  CAHAL_ATOMIC_STORE( &( io_dispatcher->queued_bytes ), in_queued_bytes );
+
+  if( CAHAL_ATOMIC_LOAD( &( io_dispatcher->has_failed ) ) )
+  {
+    //  Play out what was rendered before the callback failed.
+    *io_data_buffer_length = length;
+
+    return( 0 != length );
+  }
+
+  if( length < capacity )
+  {
+    CPC_MEMSET( out_data_buffer + length, 0, capacity - length );
+
+    CAHAL_ATOMIC_ADD( &( io_dispatcher->number_of_underruns ), 1 );
+  }
+
+  *io_data_buffer_length = capacity;
+
+  cahal_semaphore_post( &( io_dispatcher->wake ) );
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_attach_recording_dispatcher (
+                                   cahal_recorder_info*  io_recorder_info,
+                                   UINT32                in_buffer_size
+                                   )
+{
+  cahal_dispatch_options options;
+
+  if( ! cahal_get_dispatch_options( &options ) )
+  {
+    return( CPC_TRUE );
+  }
+
+  io_recorder_info->dispatcher =
+    cahal_dispatcher_create (
+                             &options,
+                             CAHAL_DEVICE_INPUT_STREAM,
+                             io_recorder_info,
+                             in_buffer_size
+                             );
+
+  return( NULL != io_recorder_info->dispatcher );
+}
+
+CPC_BOOL
+cahal_attach_playback_dispatcher  (
+                                   cahal_playback_info*  io_playback_info,
+                                   UINT32                in_buffer_size
+                                   )
+{
+  cahal_dispatch_options options;
+
+  if( ! cahal_get_dispatch_options( &options ) )
+  {
+    return( CPC_TRUE );
+  }
+
+  io_playback_info->dispatcher =
+    cahal_dispatcher_create (
+                             &options,
+                             CAHAL_DEVICE_OUTPUT_STREAM,
+                             io_playback_info,
+                             in_buffer_size
+                             );
+
+  return( NULL != io_playback_info->dispatcher );
+}
+
+void
+cahal_detach_recording_dispatcher (
+                                   cahal_recorder_info* io_recorder_info
+                                   )
+{
+  cahal_dispatcher_free( io_recorder_info->dispatcher );
+
+  io_recorder_info->dispatcher = NULL;
+}
+
+void
+cahal_detach_playback_dispatcher  (
+                                   cahal_playback_info* io_playback_info
+                                   )
+{
+  cahal_dispatcher_free( io_playback_info->dispatcher );
+
+  io_playback_info->dispatcher = NULL;
+}
+
+static
+void
+cahal_dispatcher_run  (
+                       void* in_argument
+                       )
+{
+  cahal_dispatcher* dispatcher = ( cahal_dispatcher* ) in_argument;
+
+  dispatcher->is_scheduled =
+    cahal_thread_set_scheduling( &( dispatcher->options.scheduling ) );
+
+  if( CAHAL_DEVICE_OUTPUT_STREAM == dispatcher->direction )
+  {
+    cahal_dispatcher_render( dispatcher );
+  }
+
+  cahal_semaphore_post( &( dispatcher->ready ) );
+
+  do
+  {
+    cahal_semaphore_wait( &( dispatcher->wake ) );
+
+    if( CAHAL_DEVICE_INPUT_STREAM == dispatcher->direction )
+    {
+      while( cahal_dispatcher_process_packet( dispatcher ) );
+    }
+    else if( ! CAHAL_ATOMIC_LOAD( &( dispatcher->is_stopping ) ) )
+    {
+      cahal_dispatcher_render( dispatcher );
+    }
+  }
+  while( ! CAHAL_ATOMIC_LOAD( &( dispatcher->is_stopping ) ) );
+
+  //  The OS has stopped recording; process what it delivered last.
+  if( CAHAL_DEVICE_INPUT_STREAM == dispatcher->direction )
+  {
+    while( cahal_dispatcher_process_packet( dispatcher ) );
+  }
+
+  cahal_thread_reset_scheduling();
+}
+
+static
+CPC_BOOL
+cahal_dispatcher_process_packet  (
+                                  cahal_dispatcher* io_dispatcher
+                                  )
+{
+  cahal_recorder_info* recorder_info =
+    ( cahal_recorder_info* ) io_dispatcher->stream_info;
+  cahal_dispatch_packet_header header;
+
+  if  (
+       sizeof( cahal_dispatch_packet_header )
+       != cahal_ring_buffer_peek  (
+                                   io_dispatcher->ring_buffer,
+                                   ( UCHAR* ) &header,
+                                   sizeof( cahal_dispatch_packet_header )
+                                   )
+       || sizeof( cahal_dispatch_packet_header ) + header.length
+          > cahal_ring_buffer_get_fill( io_dispatcher->ring_buffer )
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  cahal_ring_buffer_read  (
+                           io_dispatcher->ring_buffer,
+                           NULL,
+                           sizeof( cahal_dispatch_packet_header )
+                           );
+  cahal_ring_buffer_read  (
+                           io_dispatcher->ring_buffer,
+                           io_dispatcher->buffer,
+                           header.length
+                           );
+
+  if  (
+       ! CAHAL_ATOMIC_LOAD( &( io_dispatcher->has_failed ) )
+       && ! cahal_process_recording (
+                                     recorder_info,
+                                     io_dispatcher->buffer,
+                                     header.length,
+                                     header.record_time
+                                     )
+       )
+  {
+    CAHAL_ATOMIC_STORE( &( io_dispatcher->has_failed ), 1 );
+  }
+
+  return( CPC_TRUE );
+}
+
+static
+void
+cahal_dispatcher_render  (
+                          cahal_dispatcher* io_dispatcher
+                          )
+{
+  cahal_playback_info* playback_info =
+    ( cahal_playback_info* ) io_dispatcher->stream_info;
+
+  while  (
+          ! CAHAL_ATOMIC_LOAD( &( io_dispatcher->has_failed ) )
+          && cahal_ring_buffer_get_fill( io_dispatcher->ring_buffer )
+             + io_dispatcher->buffer_size
+             <= io_dispatcher->target_fill
+          )
+  {
+    UINT32 length = io_dispatcher->buffer_size;
+    UINT32 queued_bytes =
+      CAHAL_ATOMIC_LOAD( &( io_dispatcher->queued_bytes ) )
+      + cahal_ring_buffer_get_fill( io_dispatcher->ring_buffer );
+
+    if  (
+         ! cahal_process_playback  (
+                                    playback_info,
+                                    io_dispatcher->buffer,
+                                    &length,
+                                    queued_bytes
+                                    )
+         )
+    {
+      CAHAL_ATOMIC_STORE( &( io_dispatcher->has_failed ), 1 );
+
+      break;
+    }
+
+    if( length > io_dispatcher->buffer_size )
+    {
+      length = io_dispatcher->buffer_size;
+    }
+
+    length -= length % io_dispatcher->frame_size;
+
+    if( 0 == length )
+    {
+      break;
+    }
+
+    cahal_ring_buffer_write (
+                             io_dispatcher->ring_buffer,
+                             io_dispatcher->buffer,
+                             length
+                             );
+  }
+}
+
+static
+void
+cahal_dispatcher_release  (
+                           cahal_dispatcher* in_dispatcher
+                           )
+{
+  if( NULL != in_dispatcher->ring_buffer )
+  {
+    cahal_ring_buffer_free( in_dispatcher->ring_buffer );
+  }
+
+  if( NULL != in_dispatcher->buffer )
+  {
+    cpc_safe_free( ( void** ) &( in_dispatcher->buffer ) );
+  }
+
+  cahal_semaphore_destroy( &( in_dispatcher->wake ) );
+  cahal_semaphore_destroy( &( in_dispatcher->ready ) );
+
+  cpc_safe_free( ( void** ) &in_dispatcher );
+}
@@ -0,0 +1,659 @@
+/*! \file   cahal_drift_resampler.c
+
+    \author Brent Carrara
+ */
+#include <math.h>
+
+#include "cahal_drift_resampler.h"
+#include "cahal_audio_convert.h"
+
+/*! \def    CAHAL_DRIFT_RESAMPLER_FILL_TIME_CONSTANT
+    \brief  Time constant (in seconds) of the low-pass filter applied to the
+            fill level before it is used by the controller. It must be longer
+            than the duration of a recorded buffer to smooth out the bursts.
+ */
+#define CAHAL_DRIFT_RESAMPLER_FILL_TIME_CONSTANT  4.0
+
+/*! \def    CAHAL_DRIFT_RESAMPLER_PROPORTIONAL_GAIN
+    \brief  Proportional gain of the controller: ratio correction per second
+            of latency error.
+ */
+#define CAHAL_DRIFT_RESAMPLER_PROPORTIONAL_GAIN   0.05
+
+/*! \def    CAHAL_DRIFT_RESAMPLER_INTEGRAL_GAIN
+    \brief  Integral gain of the controller. Chosen as KP^2 / 4 which
+            critically damps the fill level loop.
+ */
+#define CAHAL_DRIFT_RESAMPLER_INTEGRAL_GAIN                       \
+  ( CAHAL_DRIFT_RESAMPLER_PROPORTIONAL_GAIN                       \
+    * CAHAL_DRIFT_RESAMPLER_PROPORTIONAL_GAIN / 4.0 )
+
+/*! \def    CAHAL_DRIFT_RESAMPLER_HISTORY_FRAMES
+    \brief  Minimum number of frames carried over between reads for the
+            4-point interpolator. One more is carried over when a read ends
+            on a frame it already fetched the next one for.
+ */
+#define CAHAL_DRIFT_RESAMPLER_HISTORY_FRAMES      3
+
+/*! \fn     void cahal_drift_resampler_update_ratio  (
+              cahal_drift_resampler* io_resampler,
+              UINT32                 in_fill,
+              UINT32                 in_number_of_frames
+            )
+    \brief  Runs one step of the PI controller that maps the fill level onto
+            the resampling ratio.
+
+    \param  io_resampler  The resampler whose ratio is updated.
+    \param  in_fill The number of frames currently buffered.
+    \param  in_number_of_frames The number of frames about to be produced.
+ */
+static
+void
+cahal_drift_resampler_update_ratio  (
+                                     cahal_drift_resampler* io_resampler,
+                                     UINT32                 in_fill,
+                                     UINT32                 in_number_of_frames
+                                     );
+
+/*! \fn     void cahal_drift_resampler_read_chunk  (
+              cahal_drift_resampler* io_resampler,
+              FLOAT32*               out_frames,
+              UINT32                 in_number_of_frames
+            )
+    \brief  Produces up to CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES frames.
+
+    \param  io_resampler  The resampler to read from.
+    \param  out_frames  The buffer to fill.
+    \param  in_number_of_frames The number of frames to produce.
+ */
+static
+void
+cahal_drift_resampler_read_chunk  (
+                                   cahal_drift_resampler* io_resampler,
+                                   FLOAT32*               out_frames,
+                                   UINT32                 in_number_of_frames
+                                   );
+
+/*! \def    CAHAL_DRIFT_RESAMPLER_IS_PRIMED
+    \brief  True once the fill level has reached the target. The reader
+            outputs silence until then; a negative filtered fill level marks
+            the resampler as (re)buffering.
+ */
+#define CAHAL_DRIFT_RESAMPLER_IS_PRIMED( resampler )  \
+  ( 0.0 <= ( resampler )->filtered_fill )
+
+cahal_drift_resampler*
+cahal_drift_resampler_create  (
+                               UINT32                  in_number_of_channels,
+                               FLOAT64                 in_sample_rate,
+                               FLOAT64                 in_target_latency,
+                               FLOAT64                 in_maximum_latency,
+                               UINT32                  in_input_bit_depth,
+                               cahal_audio_format_flag in_input_format_flags,
+                               UINT32                  in_output_bit_depth,
+                               cahal_audio_format_flag in_output_format_flags
+                               )
+{
+  cahal_drift_resampler* resampler  = NULL;
+  UINT32 frame_size                 = sizeof( FLOAT32 ) * in_number_of_channels;
+  UINT32 chunk_samples              =
+    CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES * in_number_of_channels;
+
+  if  (
+       0 == in_number_of_channels
+       || 0.0 >= in_sample_rate
+       || 0.0 >= in_target_latency
+       || in_target_latency >= in_maximum_latency
+       )
+  {
+    CPC_ERROR (
+               "Invalid drift resampler parameters: nc=%d, sr=%.2f, "
+               "target=%.3f, max=%.3f.",
+               in_number_of_channels,
+               in_sample_rate,
+               in_target_latency,
+               in_maximum_latency
+               );
+
+    return( NULL );
+  }
+
+  if  (
+       ! cahal_test_conversion_support  (
+                                         in_input_bit_depth,
+                                         in_input_format_flags
+                                         )
+       || ! cahal_test_conversion_support  (
+                                            in_output_bit_depth,
+                                            in_output_format_flags
+                                            )
+       )
+  {
+    CPC_LOG_STRING  (
+                     CPC_LOG_LEVEL_ERROR,
+                     "Unsupported sample format for drift resampler."
+                     );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc (
+                           ( void** ) &resampler,
+                           sizeof( cahal_drift_resampler )
+                           )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc resampler." );
+
+    return( NULL );
+  }
+
+  resampler->number_of_channels   = in_number_of_channels;
+  resampler->sample_rate          = in_sample_rate;
+  resampler->target_fill          =
+    ( UINT32 ) ( in_target_latency * in_sample_rate );
+  resampler->maximum_fill         =
+    ( UINT32 ) ( in_maximum_latency * in_sample_rate );
+  resampler->ratio                = 1.0;
+  resampler->integral             = 0.0;
+  resampler->filtered_fill        = -1.0;
+  resampler->position             = 0.0;
+  resampler->number_of_history_frames =
+    CAHAL_DRIFT_RESAMPLER_HISTORY_FRAMES;
+  resampler->input_bit_depth      = in_input_bit_depth;
+  resampler->input_format_flags   = in_input_format_flags;
+  resampler->output_bit_depth     = in_output_bit_depth;
+  resampler->output_format_flags  = in_output_format_flags;
+  resampler->work_capacity        =
+    ( UINT32 )  (
+                 CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES
+                 * ( 1.0 + CAHAL_DRIFT_RESAMPLER_MAXIMUM_PPM * 1e-6 )
+                 )
+    + 2 * CAHAL_DRIFT_RESAMPLER_HISTORY_FRAMES + 2;
+
+  CAHAL_ATOMIC_STORE( &resampler->overruns, 0 );
+  CAHAL_ATOMIC_STORE( &resampler->underruns, 0 );
+
+  resampler->ring_buffer =
+    cahal_ring_buffer_create( resampler->maximum_fill * frame_size );
+
+  if  (
+       NULL == resampler->ring_buffer
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( resampler->work_buffer ),
+                               resampler->work_capacity * frame_size
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( resampler->input_scratch ),
+                               chunk_samples * sizeof( FLOAT32 )
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( resampler->output_scratch ),
+                               chunk_samples * sizeof( FLOAT32 )
+                               )
+       )
+  {
+    CPC_LOG_STRING  (
+                     CPC_LOG_LEVEL_ERROR,
+                     "Could not malloc drift resampler buffers."
+                     );
+
+    cahal_drift_resampler_free( resampler );
+
+    resampler = NULL;
+  }
+
+  return( resampler );
+}
+
+void
+cahal_drift_resampler_free  (
+                             cahal_drift_resampler* in_resampler
+                             )
+{
+  if( NULL != in_resampler )
+  {
+    cahal_ring_buffer_free( in_resampler->ring_buffer );
+
+    cpc_safe_free( ( void** ) &( in_resampler->work_buffer ) );
+    cpc_safe_free( ( void** ) &( in_resampler->input_scratch ) );
+    cpc_safe_free( ( void** ) &( in_resampler->output_scratch ) );
+
+    cpc_safe_free( ( void** ) &in_resampler );
+  }
+}
+
+UINT32
+cahal_drift_resampler_write (
+                             cahal_drift_resampler* io_resampler,
+                             const FLOAT32*         in_frames,
+                             UINT32                 in_number_of_frames
+                             )
+{
+  UINT32 frame_size = 0;
+  UINT32 fill       = 0;
+  UINT32 accepted   = 0;
+
+  if( NULL == io_resampler || NULL == in_frames )
+  {
+    return( 0 );
+  }
+
+  frame_size  = sizeof( FLOAT32 ) * io_resampler->number_of_channels;
+  fill        =
+    cahal_ring_buffer_get_fill( io_resampler->ring_buffer ) / frame_size;
+
+  accepted = in_number_of_frames;
+
+  if( fill + accepted > io_resampler->maximum_fill )
+  {
+    accepted =
+      ( fill < io_resampler->maximum_fill )
+      ? io_resampler->maximum_fill - fill : 0;
+  }
+
+  accepted =
+    cahal_ring_buffer_write (
+                             io_resampler->ring_buffer,
+                             ( const UCHAR* ) in_frames,
+                             accepted * frame_size
+                             ) / frame_size;
+
+  if( accepted < in_number_of_frames )
+  {
+    CAHAL_ATOMIC_ADD  (
+                       &io_resampler->overruns,
+                       in_number_of_frames - accepted
+                       );
+  }
+
+  return( accepted );
+}
+
+static
+void
+cahal_drift_resampler_update_ratio  (
+                                     cahal_drift_resampler* io_resampler,
+                                     UINT32                 in_fill,
+                                     UINT32                 in_number_of_frames
+                                     )
+{
+  FLOAT64 elapsed   = in_number_of_frames / io_resampler->sample_rate;
+  FLOAT64 alpha     = elapsed / CAHAL_DRIFT_RESAMPLER_FILL_TIME_CONSTANT;
+  FLOAT64 error     = 0.0;
+  FLOAT64 limit     = CAHAL_DRIFT_RESAMPLER_MAXIMUM_PPM * 1e-6;
+  FLOAT64 drift     = 0.0;
+  FLOAT64 ratio     = 0.0;
+
+  if( 1.0 < alpha )
+  {
+    alpha = 1.0;
+  }
+
+  io_resampler->filtered_fill +=
+    alpha
+    * ( in_fill + io_resampler->fill_offset - io_resampler->filtered_fill );
+
+  error =
+    ( io_resampler->filtered_fill - io_resampler->target_fill )
+    / io_resampler->sample_rate;
+
+  io_resampler->integral += error * elapsed;
+
+  /*
+   * Anti-windup: the integral term alone is the drift estimate and is never
+   * allowed to exceed the correction limit.
+   */
+  drift = CAHAL_DRIFT_RESAMPLER_INTEGRAL_GAIN * io_resampler->integral;
+
+  if( limit < fabs( drift ) )
+  {
+    drift                   = ( 0.0 < drift ) ? limit : -limit;
+    io_resampler->integral  = drift / CAHAL_DRIFT_RESAMPLER_INTEGRAL_GAIN;
+  }
+
+  ratio = CAHAL_DRIFT_RESAMPLER_PROPORTIONAL_GAIN * error + drift;
+
+  if( limit < fabs( ratio ) )
+  {
+    ratio = ( 0.0 < ratio ) ? limit : -limit;
+  }
+
+  io_resampler->ratio = 1.0 + ratio;
+}
+
+static
+void
+cahal_drift_resampler_read_chunk  (
+                                   cahal_drift_resampler* io_resampler,
+                                   FLOAT32*               out_frames,
+                                   UINT32                 in_number_of_frames
+                                   )
+{
+  UINT32 channels     = io_resampler->number_of_channels;
+  UINT32 frame_size   = sizeof( FLOAT32 ) * channels;
+  UINT32 fill         =
+    cahal_ring_buffer_get_fill( io_resampler->ring_buffer ) / frame_size;
+  FLOAT32* work       = io_resampler->work_buffer;
+  FLOAT64 position    = 0.0;
+  FLOAT64 end         = 0.0;
+  UINT32 last_index   = 0;
+  UINT32 base         = 0;
+  UINT32 total        = 0;
+  UINT32 history      = io_resampler->number_of_history_frames;
+  UINT32 needed       = 0;
+  UINT32 received     = 0;
+
+  if( ! CAHAL_DRIFT_RESAMPLER_IS_PRIMED( io_resampler ) )
+  {
+    memset( out_frames, 0, in_number_of_frames * frame_size );
+
+    if( fill >= io_resampler->target_fill )
+    {
+      io_resampler->filtered_fill =
+        ( 0.0 < fill + io_resampler->fill_offset )
+        ? fill + io_resampler->fill_offset : 0.0;
+      io_resampler->position      = 0.0;
+      io_resampler->number_of_history_frames  =
+        CAHAL_DRIFT_RESAMPLER_HISTORY_FRAMES;
+
+      memset  (
+               work,
+               0,
+               CAHAL_DRIFT_RESAMPLER_HISTORY_FRAMES * frame_size
+               );
+    }
+
+    return;
+  }
+
+  cahal_drift_resampler_update_ratio  (
+                                       io_resampler,
+                                       fill,
+                                       in_number_of_frames
+                                       );
+
+  position    = io_resampler->position;
+  end         = position + in_number_of_frames * io_resampler->ratio;
+  last_index  =
+    ( UINT32 ) ( position + ( in_number_of_frames - 1 ) * io_resampler->ratio );
+  base        = ( UINT32 ) end;
+  total       = last_index + 4;
+
+  if( base + CAHAL_DRIFT_RESAMPLER_HISTORY_FRAMES > total )
+  {
+    total = base + CAHAL_DRIFT_RESAMPLER_HISTORY_FRAMES;
+  }
+
+  //  The history may already hold every frame this read needs
+  if( history > total )
+  {
+    total = history;
+  }
+
+  needed = total - history;
+
+  received =
+    cahal_ring_buffer_read  (
+                             io_resampler->ring_buffer,
+                             ( UCHAR* ) ( work + history * channels ),
+                             needed * frame_size
+                             ) / frame_size;
+
+  if( received < needed )
+  {
+    memset  (
+             work + ( history + received ) * channels,
+             0,
+             ( needed - received ) * frame_size
+             );
+
+    CAHAL_ATOMIC_ADD( &io_resampler->underruns, needed - received );
+
+    /*
+     * The buffer ran dry: rebuffer up to the target before producing audio
+     * again rather than stuttering on every callback.
+     */
+    if( 0 == received )
+    {
+      io_resampler->filtered_fill = -1.0;
+    }
+  }
+
+  for( UINT32 frame = 0; frame < in_number_of_frames; frame++ )
+  {
+    UINT32 index        = ( UINT32 ) position;
+    FLOAT32 t           = ( FLOAT32 ) ( position - index );
+    const FLOAT32* x    = work + index * channels;
+    FLOAT32* out        = out_frames + frame * channels;
+
+    for( UINT32 channel = 0; channel < channels; channel++ )
+    {
+      FLOAT32 x0 = x[ channel ];
+      FLOAT32 x1 = x[ channels + channel ];
+      FLOAT32 x2 = x[ 2 * channels + channel ];
+      FLOAT32 x3 = x[ 3 * channels + channel ];
+
+      FLOAT32 c1 = 0.5f * ( x2 - x0 );
+      FLOAT32 c2 = x0 - 2.5f * x1 + 2.0f * x2 - 0.5f * x3;
+      FLOAT32 c3 = 0.5f * ( x3 - x0 ) + 1.5f * ( x1 - x2 );
+
+      out[ channel ] = ( ( c3 * t + c2 ) * t + c1 ) * t + x1;
+    }
+
+    position += io_resampler->ratio;
+  }
+
+  //  Every frame fetched beyond base is carried over, so none is skipped
+  memmove (
+           work,
+           work + base * channels,
+           ( total - base ) * frame_size
+           );
+
+  io_resampler->position                  = end - base;
+  io_resampler->number_of_history_frames  = total - base;
+}
+
+void
+cahal_drift_resampler_read  (
+                             cahal_drift_resampler* io_resampler,
+                             FLOAT32*               out_frames,
+                             UINT32                 in_number_of_frames
+                             )
+{
+  if( NULL == io_resampler || NULL == out_frames )
+  {
+    return;
+  }
+
+  while( 0 < in_number_of_frames )
+  {
+    UINT32 chunk = in_number_of_frames;
+
+    if( CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES < chunk )
+    {
+      chunk = CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES;
+    }
+
+    cahal_drift_resampler_read_chunk( io_resampler, out_frames, chunk );
+
+    out_frames          += chunk * io_resampler->number_of_channels;
+    in_number_of_frames -= chunk;
+  }
+}
+
+FLOAT64
+cahal_drift_resampler_get_ppm  (
+                                cahal_drift_resampler* in_resampler
+                                )
+{
+  if( NULL == in_resampler )
+  {
+    return( 0.0 );
+  }
+
+  return( CAHAL_DRIFT_RESAMPLER_INTEGRAL_GAIN * in_resampler->integral * 1e6 );
+}
+
+FLOAT64
+cahal_drift_resampler_get_latency  (
+                                    cahal_drift_resampler* in_resampler
+                                    )
+{
+  UINT32 frame_size = 0;
+
+  if( NULL == in_resampler )
+  {
+    return( 0.0 );
+  }
+
+  frame_size = sizeof( FLOAT32 ) * in_resampler->number_of_channels;
+
+  return  (
+           ( cahal_ring_buffer_get_fill( in_resampler->ring_buffer )
+             / frame_size )
+           / in_resampler->sample_rate
+           );
+}
+
+UINT32
+cahal_drift_resampler_get_overruns  (
+                                     cahal_drift_resampler* in_resampler
+                                     )
+{
+  if( NULL == in_resampler )
+  {
+    return( 0 );
+  }
+
+  return( CAHAL_ATOMIC_LOAD( &in_resampler->overruns ) );
+}
+
+UINT32
+cahal_drift_resampler_get_underruns  (
+                                      cahal_drift_resampler* in_resampler
+                                      )
+{
+  if( NULL == in_resampler )
+  {
+    return( 0 );
+  }
+
+  return( CAHAL_ATOMIC_LOAD( &in_resampler->underruns ) );
+}
+
+CPC_BOOL
+cahal_drift_resampler_recorder_callback (
+                                         cahal_device* in_recording_device,
+                                         UCHAR*        in_data_buffer,
+                                         UINT32        in_data_buffer_length,
+                                         void*         in_client_data
+                                         )
+{
+  cahal_drift_resampler* resampler  = ( cahal_drift_resampler* ) in_client_data;
+  UINT32 frame_size                 = 0;
+  UINT32 number_of_frames           = 0;
+
+  if( NULL == resampler || NULL == in_data_buffer )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null drift resampler or buffer." );
+
+    return( CPC_FALSE );
+  }
+
+  frame_size        =
+    cahal_get_bytes_per_sample( resampler->input_bit_depth )
+    * resampler->number_of_channels;
+  number_of_frames  = in_data_buffer_length / frame_size;
+
+  while( 0 < number_of_frames )
+  {
+    UINT32 chunk = number_of_frames;
+
+    if( CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES < chunk )
+    {
+      chunk = CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES;
+    }
+
+    cahal_convert_to_float32  (
+                               in_data_buffer,
+                               chunk * resampler->number_of_channels,
+                               resampler->input_bit_depth,
+                               resampler->input_format_flags,
+                               resampler->input_scratch
+                               );
+
+    cahal_drift_resampler_write( resampler, resampler->input_scratch, chunk );
+
+    in_data_buffer    += chunk * frame_size;
+    number_of_frames  -= chunk;
+  }
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_drift_resampler_playback_callback (
+                                         cahal_device* in_playback_device,
+                                         UCHAR*        out_data_buffer,
+                                         UINT32*       io_data_buffer_length,
+                                         void*         in_client_data
+                                         )
+{
+  cahal_drift_resampler* resampler  = ( cahal_drift_resampler* ) in_client_data;
+  UINT32 frame_size                 = 0;
+  UINT32 number_of_frames           = 0;
+
+  if  (
+       NULL == resampler
+       || NULL == out_data_buffer
+       || NULL == io_data_buffer_length
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null drift resampler or buffer." );
+
+    return( CPC_FALSE );
+  }
+
+  frame_size        =
+    cahal_get_bytes_per_sample( resampler->output_bit_depth )
+    * resampler->number_of_channels;
+  number_of_frames  = *io_data_buffer_length / frame_size;
+
+  *io_data_buffer_length = number_of_frames * frame_size;
+
+  while( 0 < number_of_frames )
+  {
+    UINT32 chunk = number_of_frames;
+
+    if( CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES < chunk )
+    {
+      chunk = CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES;
+    }
+
+    cahal_drift_resampler_read_chunk  (
+                                       resampler,
+                                       resampler->output_scratch,
+                                       chunk
+                                       );
+
+    cahal_convert_from_float32  (
+                                 resampler->output_scratch,
+                                 chunk * resampler->number_of_channels,
+                                 resampler->output_bit_depth,
+                                 resampler->output_format_flags,
+                                 out_data_buffer
+                                 );
+
+    out_data_buffer   += chunk * frame_size;
+    number_of_frames  -= chunk;
+  }
+
+  return( CPC_TRUE );
+}
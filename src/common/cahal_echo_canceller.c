@@ -0,0 +1,907 @@
+/*! \file   cahal_echo_canceller.c
+
+    \author Brent Carrara
+ */
+#include <math.h>
+
+#include "cahal_echo_canceller.h"
+#include "cahal_audio_convert.h"
+#include "cahal_device.h"
+#include "cahal_stream_state.h"
+
+/*! \def    CAHAL_ECHO_CANCELLER_STEP_SIZE
+    \brief  Normalized step size of the adaptive filter.
+ */
+#define CAHAL_ECHO_CANCELLER_STEP_SIZE          0.5f
+
+/*! \def    CAHAL_ECHO_CANCELLER_POWER_SMOOTHING
+    \brief  Forgetting factor of the reference power spectrum estimate.
+ */
+#define CAHAL_ECHO_CANCELLER_POWER_SMOOTHING    0.9f
+
+/*! \def    CAHAL_ECHO_CANCELLER_REGULARIZATION
+    \brief  Regularization of the step size normalization per transform
+            sample. Prevents adaptation on (near) silent references.
+ */
+#define CAHAL_ECHO_CANCELLER_REGULARIZATION     1e-6f
+
+/*! \def    CAHAL_ECHO_CANCELLER_ENERGY_SMOOTHING
+    \brief  Forgetting factor of the energies used to compute the ERLE.
+ */
+#define CAHAL_ECHO_CANCELLER_ENERGY_SMOOTHING   0.99
+
+/*! \def    CAHAL_ECHO_CANCELLER_ALIGNMENT_MARGIN
+    \brief  The reference is aligned this many seconds ahead of the recording
+            so that jitter in the reported times does not push the echo path
+            outside of the (causal) filter.
+ */
+#define CAHAL_ECHO_CANCELLER_ALIGNMENT_MARGIN   0.01
+
+/*! \def    CAHAL_ECHO_CANCELLER_ANCHOR_CAPACITY
+    \brief  The number of reference timestamps that can be queued.
+ */
+#define CAHAL_ECHO_CANCELLER_ANCHOR_CAPACITY    256
+
+/*! \def    CAHAL_ECHO_CANCELLER_NANOSECONDS
+    \brief  The number of nanoseconds in a second.
+ */
+#define CAHAL_ECHO_CANCELLER_NANOSECONDS        1000000000.0
+
+/*! \var    cahal_echo_canceller_anchor
+    \brief  Associates the index of a reference sample with its play time.
+ */
+typedef struct cahal_echo_canceller_anchor_t
+{
+  /*! \var    time
+      \brief  The play time in ns.
+   */
+  UINT64 time;
+
+  /*! \var    index
+      \brief  The reference sample index.
+   */
+  UINT32 index;
+
+  /*! \var    reserved
+      \brief  Padding.
+   */
+  UINT32 reserved;
+
+} cahal_echo_canceller_anchor;
+
+cahal_echo_canceller* g_echo_canceller = NULL;
+
+/*! \fn     void cahal_echo_canceller_read_reference (
+              cahal_echo_canceller* io_canceller
+            )
+    \brief  Reads the block of reference samples aligned with the block of
+            recorded samples in io_canceller->input into the second half of
+            io_canceller->reference_frame. Missing reference samples are set
+            to zero.
+
+    \param  io_canceller  The canceller to read the reference of.
+ */
+static
+void
+cahal_echo_canceller_read_reference (
+                                     cahal_echo_canceller* io_canceller
+                                     );
+
+/*! \fn     void cahal_echo_canceller_process_block  (
+              cahal_echo_canceller* io_canceller
+            )
+    \brief  Filters and adapts on the block of recorded samples in
+            io_canceller->input and stores the result in io_canceller->output.
+
+    \param  io_canceller  The canceller to process the block of.
+ */
+static
+void
+cahal_echo_canceller_process_block  (
+                                     cahal_echo_canceller* io_canceller
+                                     );
+
+cahal_echo_canceller*
+cahal_echo_canceller_create  (
+                              UINT32  in_number_of_channels,
+                              FLOAT64 in_sample_rate,
+                              FLOAT64 in_tail_length
+                              )
+{
+  cahal_echo_canceller* canceller = NULL;
+  UINT32 block                    = CAHAL_ECHO_CANCELLER_BLOCK_SIZE;
+  UINT32 bins                     = block + 1;
+  UINT32 partitions               = 0;
+  UINT32 reference_samples        = 0;
+
+  if  (
+       0 == in_number_of_channels
+       || in_number_of_channels > CAHAL_ECHO_CANCELLER_SCRATCH_SAMPLES
+       || 0.0 >= in_sample_rate
+       || 0.0 >= in_tail_length
+       || CAHAL_ECHO_CANCELLER_MAXIMUM_TAIL_LENGTH < in_tail_length
+       )
+  {
+    CPC_ERROR (
+               "Invalid echo canceller parameters: nc=%d, sr=%.2f, tail=%.3f.",
+               in_number_of_channels,
+               in_sample_rate,
+               in_tail_length
+               );
+
+    return( NULL );
+  }
+
+  partitions        =
+    ( UINT32 ) ceil( in_tail_length * in_sample_rate / block );
+
+  /*
+   * The reference is written when the playback buffer is filled, i.e. up to
+   * the total queue duration before it is recorded.
+   */
+  reference_samples =
+    ( UINT32 )  (
+                 ( CAHAL_QUEUE_NUMBER_OF_QUEUES + 1 )
+                 * CAHAL_QUEUE_BUFFER_DURATION
+                 * in_sample_rate
+                 );
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc (
+                           ( void** ) &canceller,
+                           sizeof( cahal_echo_canceller )
+                           )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc echo canceller." );
+
+    return( NULL );
+  }
+
+  canceller->number_of_channels   = in_number_of_channels;
+  canceller->sample_rate          = in_sample_rate;
+  canceller->number_of_partitions = partitions;
+  canceller->has_anchor           = CPC_FALSE;
+
+  canceller->fft        = cahal_fft_create( 2 * block );
+  canceller->reference  =
+    cahal_ring_buffer_create( reference_samples * sizeof( FLOAT32 ) );
+  canceller->anchors    =
+    cahal_ring_buffer_create  (
+                               CAHAL_ECHO_CANCELLER_ANCHOR_CAPACITY
+                               * sizeof( cahal_echo_canceller_anchor )
+                               );
+
+  if  (
+       NULL == canceller->fft
+       || NULL == canceller->reference
+       || NULL == canceller->anchors
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( canceller->reference_frame ),
+                               sizeof( FLOAT32 ) * 2 * block
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( canceller->reference_real ),
+                               sizeof( FLOAT32 ) * partitions * bins
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( canceller->reference_imaginary ),
+                               sizeof( FLOAT32 ) * partitions * bins
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( canceller->reference_power ),
+                               sizeof( FLOAT32 ) * bins
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( canceller->weights_real ),
+                               sizeof( FLOAT32 ) * in_number_of_channels
+                               * partitions * bins
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( canceller->weights_imaginary ),
+                               sizeof( FLOAT32 ) * in_number_of_channels
+                               * partitions * bins
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( canceller->input ),
+                               sizeof( FLOAT32 ) * in_number_of_channels * block
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( canceller->output ),
+                               sizeof( FLOAT32 ) * in_number_of_channels * block
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( canceller->time_domain ),
+                               sizeof( FLOAT32 ) * 2 * block
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( canceller->spectrum_real ),
+                               sizeof( FLOAT32 ) * bins
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( canceller->spectrum_imaginary ),
+                               sizeof( FLOAT32 ) * bins
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( canceller->capture_scratch ),
+                               sizeof( FLOAT32 )
+                               * CAHAL_ECHO_CANCELLER_SCRATCH_SAMPLES
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( canceller->playback_scratch ),
+                               sizeof( FLOAT32 )
+                               * CAHAL_ECHO_CANCELLER_SCRATCH_SAMPLES
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( canceller->mono_scratch ),
+                               sizeof( FLOAT32 )
+                               * CAHAL_ECHO_CANCELLER_SCRATCH_SAMPLES
+                               )
+       )
+  {
+    CPC_LOG_STRING  (
+                     CPC_LOG_LEVEL_ERROR,
+                     "Could not malloc echo canceller buffers."
+                     );
+
+    cahal_echo_canceller_free( canceller );
+
+    canceller = NULL;
+  }
+
+  return( canceller );
+}
+
+void
+cahal_echo_canceller_free  (
+                            cahal_echo_canceller* in_canceller
+                            )
+{
+  if( NULL != in_canceller )
+  {
+    cahal_fft_free( in_canceller->fft );
+    cahal_ring_buffer_free( in_canceller->reference );
+    cahal_ring_buffer_free( in_canceller->anchors );
+
+    cpc_safe_free( ( void** ) &( in_canceller->reference_frame ) );
+    cpc_safe_free( ( void** ) &( in_canceller->reference_real ) );
+    cpc_safe_free( ( void** ) &( in_canceller->reference_imaginary ) );
+    cpc_safe_free( ( void** ) &( in_canceller->reference_power ) );
+    cpc_safe_free( ( void** ) &( in_canceller->weights_real ) );
+    cpc_safe_free( ( void** ) &( in_canceller->weights_imaginary ) );
+    cpc_safe_free( ( void** ) &( in_canceller->input ) );
+    cpc_safe_free( ( void** ) &( in_canceller->output ) );
+    cpc_safe_free( ( void** ) &( in_canceller->time_domain ) );
+    cpc_safe_free( ( void** ) &( in_canceller->spectrum_real ) );
+    cpc_safe_free( ( void** ) &( in_canceller->spectrum_imaginary ) );
+    cpc_safe_free( ( void** ) &( in_canceller->capture_scratch ) );
+    cpc_safe_free( ( void** ) &( in_canceller->playback_scratch ) );
+    cpc_safe_free( ( void** ) &( in_canceller->mono_scratch ) );
+
+    cpc_safe_free( ( void** ) &in_canceller );
+  }
+}
+
+CPC_BOOL
+cahal_set_echo_canceller  (
+                           cahal_echo_canceller* in_canceller
+                           )
+{
+  //  The callbacks of both streams read the canceller, so neither may start
+  //  while it is replaced, after which nothing uses the old one
+  if( ! cahal_stream_state_begin_configure( &g_cahal_recording_state ) )
+  {
+    CPC_LOG_STRING  (
+                     CPC_LOG_LEVEL_ERROR,
+                     "Cannot set the echo canceller while recording."
+                     );
+
+    return( CPC_FALSE );
+  }
+
+  if( ! cahal_stream_state_begin_configure( &g_cahal_playback_state ) )
+  {
+    cahal_stream_state_end_configure( &g_cahal_recording_state );
+
+    CPC_LOG_STRING  (
+                     CPC_LOG_LEVEL_ERROR,
+                     "Cannot set the echo canceller while playing back."
+                     );
+
+    return( CPC_FALSE );
+  }
+
+  g_echo_canceller = in_canceller;
+
+  cahal_stream_state_end_configure( &g_cahal_playback_state );
+  cahal_stream_state_end_configure( &g_cahal_recording_state );
+
+  return( CPC_TRUE );
+}
+
+void
+cahal_echo_canceller_write_reference  (
+                                   cahal_echo_canceller* io_canceller,
+                                   const FLOAT32*        in_frames,
+                                   UINT32                in_number_of_frames,
+                                   UINT32                in_number_of_channels,
+                                   UINT64                in_play_time
+                                   )
+{
+  cahal_echo_canceller_anchor anchor;
+  UINT32 chunk_frames = 0;
+
+  if  (
+       NULL == io_canceller
+       || NULL == in_frames
+       || 0 == in_number_of_frames
+       || 0 == in_number_of_channels
+       )
+  {
+    return;
+  }
+
+  memset( &anchor, 0, sizeof( cahal_echo_canceller_anchor ) );
+
+  anchor.time   = in_play_time;
+  anchor.index  = io_canceller->reference_write_index;
+
+  cahal_ring_buffer_write (
+                           io_canceller->anchors,
+                           ( const UCHAR* ) &anchor,
+                           sizeof( cahal_echo_canceller_anchor )
+                           );
+
+  chunk_frames = CAHAL_ECHO_CANCELLER_SCRATCH_SAMPLES;
+
+  while( 0 < in_number_of_frames )
+  {
+    UINT32 frames = in_number_of_frames;
+
+    if( chunk_frames < frames )
+    {
+      frames = chunk_frames;
+    }
+
+    for( UINT32 frame = 0; frame < frames; frame++ )
+    {
+      FLOAT32 sum = 0.0f;
+
+      for( UINT32 channel = 0; channel < in_number_of_channels; channel++ )
+      {
+        sum += in_frames[ frame * in_number_of_channels + channel ];
+      }
+
+      io_canceller->mono_scratch[ frame ] = sum / in_number_of_channels;
+    }
+
+    /*
+     * Only samples that fit are counted so that the anchor indices always
+     * refer to the samples that are actually in the reference.
+     */
+    io_canceller->reference_write_index +=
+      cahal_ring_buffer_write (
+                               io_canceller->reference,
+                               ( const UCHAR* ) io_canceller->mono_scratch,
+                               frames * sizeof( FLOAT32 )
+                               ) / sizeof( FLOAT32 );
+
+    in_frames           += frames * in_number_of_channels;
+    in_number_of_frames -= frames;
+  }
+}
+
+static
+void
+cahal_echo_canceller_read_reference (
+                                     cahal_echo_canceller* io_canceller
+                                     )
+{
+  cahal_echo_canceller_anchor anchor;
+  UINT32 block          = CAHAL_ECHO_CANCELLER_BLOCK_SIZE;
+  FLOAT32* current      = io_canceller->reference_frame + block;
+  UINT32 available      = 0;
+  UINT32 leading_zeros  = 0;
+  UINT32 received       = 0;
+  INT32 offset          = 0;
+
+  while  (
+          sizeof( cahal_echo_canceller_anchor )
+          == cahal_ring_buffer_read (
+                                     io_canceller->anchors,
+                                     ( UCHAR* ) &anchor,
+                                     sizeof( cahal_echo_canceller_anchor )
+                                     )
+          )
+  {
+    io_canceller->has_anchor  = CPC_TRUE;
+    io_canceller->anchor_time = anchor.time;
+    io_canceller->anchor_index = anchor.index;
+  }
+
+  if( io_canceller->has_anchor )
+  {
+    FLOAT64 delta =
+      ( ( FLOAT64 ) ( INT64 )
+        ( io_canceller->block_time - io_canceller->anchor_time )
+        / CAHAL_ECHO_CANCELLER_NANOSECONDS
+        + CAHAL_ECHO_CANCELLER_ALIGNMENT_MARGIN )
+      * io_canceller->sample_rate;
+    UINT32 desired =
+      io_canceller->anchor_index + ( INT32 ) floor( delta + 0.5 );
+
+    offset = ( INT32 ) ( desired - io_canceller->reference_position );
+
+    /*
+     * Small offsets are timing jitter which the filter absorbs, larger ones
+     * mean one of the streams skipped and the reference is realigned.
+     */
+    if( ( INT32 ) block < offset || -( INT32 ) block > offset )
+    {
+      CPC_LOG (
+               CPC_LOG_LEVEL_DEBUG,
+               "Realigning echo canceller reference by %d samples.",
+               offset
+               );
+
+      io_canceller->reference_position = desired;
+    }
+  }
+
+  available =
+    cahal_ring_buffer_get_fill( io_canceller->reference ) / sizeof( FLOAT32 );
+  offset    =
+    ( INT32 )
+    ( io_canceller->reference_position - io_canceller->reference_read_index );
+
+  if( 0 < offset )
+  {
+    UINT32 skip =
+      ( ( UINT32 ) offset < available ) ? ( UINT32 ) offset : available;
+
+    cahal_ring_buffer_read  (
+                             io_canceller->reference,
+                             NULL,
+                             skip * sizeof( FLOAT32 )
+                             );
+
+    io_canceller->reference_read_index  += skip;
+    available                           -= skip;
+  }
+  else if( 0 > offset )
+  {
+    leading_zeros =
+      ( ( UINT32 ) -offset < block ) ? ( UINT32 ) -offset : block;
+  }
+
+  memset( current, 0, leading_zeros * sizeof( FLOAT32 ) );
+
+  if  (
+       io_canceller->reference_position + leading_zeros
+       == io_canceller->reference_read_index
+       )
+  {
+    received =
+      cahal_ring_buffer_read  (
+                               io_canceller->reference,
+                               ( UCHAR* ) ( current + leading_zeros ),
+                               ( block - leading_zeros ) * sizeof( FLOAT32 )
+                               ) / sizeof( FLOAT32 );
+
+    io_canceller->reference_read_index += received;
+  }
+
+  memset  (
+           current + leading_zeros + received,
+           0,
+           ( block - leading_zeros - received ) * sizeof( FLOAT32 )
+           );
+
+  io_canceller->reference_position += block;
+}
+
+static
+void
+cahal_echo_canceller_process_block  (
+                                     cahal_echo_canceller* io_canceller
+                                     )
+{
+  UINT32 block          = CAHAL_ECHO_CANCELLER_BLOCK_SIZE;
+  UINT32 bins           = block + 1;
+  UINT32 partitions     = io_canceller->number_of_partitions;
+  UINT32 head           = 0;
+  FLOAT32* x_real       = NULL;
+  FLOAT32* x_imag       = NULL;
+  FLOAT32* e_real       = io_canceller->spectrum_real;
+  FLOAT32* e_imag       = io_canceller->spectrum_imaginary;
+  FLOAT32* time_domain  = io_canceller->time_domain;
+  UINT32 channels       = io_canceller->number_of_channels;
+  FLOAT32 regularization  =
+    CAHAL_ECHO_CANCELLER_REGULARIZATION * 2 * block;
+
+  cahal_echo_canceller_read_reference( io_canceller );
+
+  /*
+   * The newest reference spectrum replaces the oldest partition.
+   */
+  io_canceller->partition_head  =
+    ( io_canceller->partition_head + partitions - 1 ) % partitions;
+  head                          = io_canceller->partition_head;
+  x_real                        = io_canceller->reference_real + head * bins;
+  x_imag                        =
+    io_canceller->reference_imaginary + head * bins;
+
+  cahal_fft_forward (
+                     io_canceller->fft,
+                     io_canceller->reference_frame,
+                     x_real,
+                     x_imag
+                     );
+
+  memmove (
+           io_canceller->reference_frame,
+           io_canceller->reference_frame + block,
+           block * sizeof( FLOAT32 )
+           );
+
+  for( UINT32 k = 0; k < bins; k++ )
+  {
+    io_canceller->reference_power[ k ] =
+      CAHAL_ECHO_CANCELLER_POWER_SMOOTHING
+      * io_canceller->reference_power[ k ]
+      + ( 1.0f - CAHAL_ECHO_CANCELLER_POWER_SMOOTHING )
+        * ( x_real[ k ] * x_real[ k ] + x_imag[ k ] * x_imag[ k ] );
+  }
+
+  for( UINT32 channel = 0; channel < channels; channel++ )
+  {
+    FLOAT32* w_real   =
+      io_canceller->weights_real + channel * partitions * bins;
+    FLOAT32* w_imag   =
+      io_canceller->weights_imaginary + channel * partitions * bins;
+    FLOAT32* near_end = io_canceller->input + channel * block;
+    FLOAT32* output   = io_canceller->output + channel * block;
+    FLOAT64 near      = 0.0;
+    FLOAT64 error     = 0.0;
+
+    /*
+     * Echo estimate: sum over the partitions of the filter times the delayed
+     * reference spectra.
+     */
+    memset( e_real, 0, bins * sizeof( FLOAT32 ) );
+    memset( e_imag, 0, bins * sizeof( FLOAT32 ) );
+
+    for( UINT32 partition = 0; partition < partitions; partition++ )
+    {
+      UINT32 delayed      = ( ( head + partition ) % partitions ) * bins;
+      const FLOAT32* ar   = io_canceller->reference_real + delayed;
+      const FLOAT32* ai   = io_canceller->reference_imaginary + delayed;
+      const FLOAT32* br   = w_real + partition * bins;
+      const FLOAT32* bi   = w_imag + partition * bins;
+
+      for( UINT32 k = 0; k < bins; k++ )
+      {
+        e_real[ k ] += ar[ k ] * br[ k ] - ai[ k ] * bi[ k ];
+        e_imag[ k ] += ar[ k ] * bi[ k ] + ai[ k ] * br[ k ];
+      }
+    }
+
+    cahal_fft_inverse( io_canceller->fft, e_real, e_imag, time_domain );
+
+    for( UINT32 i = 0; i < block; i++ )
+    {
+      FLOAT32 residual = near_end[ i ] - time_domain[ block + i ];
+
+      near  += near_end[ i ] * near_end[ i ];
+      error += residual * residual;
+
+      time_domain[ i ]          = 0.0f;
+      time_domain[ block + i ]  = residual;
+    }
+
+    if( error > near && 0.0 < near )
+    {
+      /*
+       * The filter is adding energy (it diverged or the echo path changed
+       * abruptly). Pass the recording through and shrink the filter.
+       */
+      memcpy( output, near_end, block * sizeof( FLOAT32 ) );
+
+      for( UINT32 i = 0; i < partitions * bins; i++ )
+      {
+        w_real[ i ] *= 0.5f;
+        w_imag[ i ] *= 0.5f;
+      }
+
+      error = near;
+    }
+    else
+    {
+      memcpy( output, time_domain + block, block * sizeof( FLOAT32 ) );
+
+      cahal_fft_forward( io_canceller->fft, time_domain, e_real, e_imag );
+
+      for( UINT32 k = 0; k < bins; k++ )
+      {
+        FLOAT32 step =
+          CAHAL_ECHO_CANCELLER_STEP_SIZE
+          / ( partitions * io_canceller->reference_power[ k ]
+              + regularization );
+
+        e_real[ k ] *= step;
+        e_imag[ k ] *= step;
+      }
+
+      for( UINT32 partition = 0; partition < partitions; partition++ )
+      {
+        UINT32 delayed      = ( ( head + partition ) % partitions ) * bins;
+        const FLOAT32* ar   = io_canceller->reference_real + delayed;
+        const FLOAT32* ai   = io_canceller->reference_imaginary + delayed;
+        FLOAT32* br         = w_real + partition * bins;
+        FLOAT32* bi         = w_imag + partition * bins;
+
+        for( UINT32 k = 0; k < bins; k++ )
+        {
+          br[ k ] += ar[ k ] * e_real[ k ] + ai[ k ] * e_imag[ k ];
+          bi[ k ] += ar[ k ] * e_imag[ k ] - ai[ k ] * e_real[ k ];
+        }
+      }
+
+      /*
+       * Gradient constraint: keep the time domain filter partition causal and
+       * block long. One partition per block keeps the cost bounded.
+       */
+      {
+        FLOAT32* br =
+          w_real + io_canceller->constraint_partition * bins;
+        FLOAT32* bi =
+          w_imag + io_canceller->constraint_partition * bins;
+
+        cahal_fft_inverse( io_canceller->fft, br, bi, time_domain );
+
+        memset( time_domain + block, 0, block * sizeof( FLOAT32 ) );
+
+        cahal_fft_forward( io_canceller->fft, time_domain, br, bi );
+      }
+    }
+
+    io_canceller->near_energy =
+      CAHAL_ECHO_CANCELLER_ENERGY_SMOOTHING * io_canceller->near_energy
+      + ( 1.0 - CAHAL_ECHO_CANCELLER_ENERGY_SMOOTHING ) * near;
+    io_canceller->error_energy =
+      CAHAL_ECHO_CANCELLER_ENERGY_SMOOTHING * io_canceller->error_energy
+      + ( 1.0 - CAHAL_ECHO_CANCELLER_ENERGY_SMOOTHING ) * error;
+  }
+
+  io_canceller->constraint_partition =
+    ( io_canceller->constraint_partition + 1 ) % partitions;
+}
+
+void
+cahal_echo_canceller_process  (
+                               cahal_echo_canceller* io_canceller,
+                               FLOAT32*              io_frames,
+                               UINT32                in_number_of_frames,
+                               UINT64                in_record_time
+                               )
+{
+  UINT32 block    = CAHAL_ECHO_CANCELLER_BLOCK_SIZE;
+  UINT32 channels = 0;
+
+  if( NULL == io_canceller || NULL == io_frames )
+  {
+    return;
+  }
+
+  channels = io_canceller->number_of_channels;
+
+  for( UINT32 frame = 0; frame < in_number_of_frames; frame++ )
+  {
+    UINT32 position = io_canceller->block_position;
+
+    if( 0 == position )
+    {
+      io_canceller->block_time =
+        in_record_time
+        + ( UINT64 )  (
+                       frame * CAHAL_ECHO_CANCELLER_NANOSECONDS
+                       / io_canceller->sample_rate
+                       );
+    }
+
+    for( UINT32 channel = 0; channel < channels; channel++ )
+    {
+      FLOAT32* sample = io_frames + frame * channels + channel;
+
+      io_canceller->input[ channel * block + position ] = *sample;
+
+      *sample = io_canceller->output[ channel * block + position ];
+    }
+
+    io_canceller->block_position = position + 1;
+
+    if( block == io_canceller->block_position )
+    {
+      cahal_echo_canceller_process_block( io_canceller );
+
+      io_canceller->block_position = 0;
+    }
+  }
+}
+
+CPC_BOOL
+cahal_echo_canceller_write_reference_buffer  (
+                                 cahal_echo_canceller*   io_canceller,
+                                 const UCHAR*            in_buffer,
+                                 UINT32                  in_buffer_length,
+                                 UINT32                  in_number_of_channels,
+                                 UINT32                  in_bit_depth,
+                                 cahal_audio_format_flag in_format_flags,
+                                 UINT64                  in_play_time
+                                 )
+{
+  UINT32 frame_size       = 0;
+  UINT32 number_of_frames = 0;
+  UINT32 chunk_frames     = 0;
+
+  if  (
+       NULL == io_canceller
+       || NULL == in_buffer
+       || 0 == in_number_of_channels
+       || CAHAL_ECHO_CANCELLER_SCRATCH_SAMPLES < in_number_of_channels
+       || ! cahal_test_conversion_support( in_bit_depth, in_format_flags )
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  frame_size        =
+    cahal_get_bytes_per_sample( in_bit_depth ) * in_number_of_channels;
+  number_of_frames  = in_buffer_length / frame_size;
+  chunk_frames      =
+    CAHAL_ECHO_CANCELLER_SCRATCH_SAMPLES / in_number_of_channels;
+
+  while( 0 < number_of_frames )
+  {
+    UINT32 frames = number_of_frames;
+
+    if( chunk_frames < frames )
+    {
+      frames = chunk_frames;
+    }
+
+    cahal_convert_to_float32  (
+                               in_buffer,
+                               frames * in_number_of_channels,
+                               in_bit_depth,
+                               in_format_flags,
+                               io_canceller->playback_scratch
+                               );
+
+    cahal_echo_canceller_write_reference  (
+                                           io_canceller,
+                                           io_canceller->playback_scratch,
+                                           frames,
+                                           in_number_of_channels,
+                                           in_play_time
+                                           );
+
+    in_buffer         += frames * frame_size;
+    number_of_frames  -= frames;
+    in_play_time      +=
+      ( UINT64 )  (
+                   frames * CAHAL_ECHO_CANCELLER_NANOSECONDS
+                   / io_canceller->sample_rate
+                   );
+  }
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_echo_canceller_process_buffer  (
+                                      cahal_echo_canceller*   io_canceller,
+                                      UCHAR*                  io_buffer,
+                                      UINT32                  in_buffer_length,
+                                      UINT32                  in_bit_depth,
+                                      cahal_audio_format_flag in_format_flags,
+                                      UINT64                  in_record_time
+                                      )
+{
+  UINT32 frame_size       = 0;
+  UINT32 number_of_frames = 0;
+  UINT32 chunk_frames     = 0;
+  UINT32 channels         = 0;
+
+  if  (
+       NULL == io_canceller
+       || NULL == io_buffer
+       || ! cahal_test_conversion_support( in_bit_depth, in_format_flags )
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  channels          = io_canceller->number_of_channels;
+  frame_size        = cahal_get_bytes_per_sample( in_bit_depth ) * channels;
+  number_of_frames  = in_buffer_length / frame_size;
+  chunk_frames      = CAHAL_ECHO_CANCELLER_SCRATCH_SAMPLES / channels;
+
+  while( 0 < number_of_frames )
+  {
+    UINT32 frames = number_of_frames;
+
+    if( chunk_frames < frames )
+    {
+      frames = chunk_frames;
+    }
+
+    cahal_convert_to_float32  (
+                               io_buffer,
+                               frames * channels,
+                               in_bit_depth,
+                               in_format_flags,
+                               io_canceller->capture_scratch
+                               );
+
+    cahal_echo_canceller_process  (
+                                   io_canceller,
+                                   io_canceller->capture_scratch,
+                                   frames,
+                                   in_record_time
+                                   );
+
+    cahal_convert_from_float32  (
+                                 io_canceller->capture_scratch,
+                                 frames * channels,
+                                 in_bit_depth,
+                                 in_format_flags,
+                                 io_buffer
+                                 );
+
+    io_buffer         += frames * frame_size;
+    number_of_frames  -= frames;
+    in_record_time    +=
+      ( UINT64 )  (
+                   frames * CAHAL_ECHO_CANCELLER_NANOSECONDS
+                   / io_canceller->sample_rate
+                   );
+  }
+
+  return( CPC_TRUE );
+}
+
+FLOAT64
+cahal_echo_canceller_get_erle  (
+                                cahal_echo_canceller* in_canceller
+                                )
+{
+  if  (
+       NULL == in_canceller
+       || 0.0 >= in_canceller->near_energy
+       || 0.0 >= in_canceller->error_energy
+       )
+  {
+    return( 0.0 );
+  }
+
+  return  (
+           10.0
+           * log10( in_canceller->near_energy / in_canceller->error_energy )
+           );
+}
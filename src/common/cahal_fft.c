@@ -0,0 +1,272 @@
+/*! \file   cahal_fft.c
+
+    \author Brent Carrara
+ */
+#include <math.h>
+
+#include "cahal_fft.h"
+
+/*! \def    CAHAL_FFT_PI
+    \brief  The constant pi.
+ */
+#define CAHAL_FFT_PI  3.14159265358979323846
+
+/*! \fn     void cahal_fft_transform (
+              cahal_fft* io_fft
+            )
+    \brief  Runs the in-place radix-2 butterflies of the complex transform on
+            the work buffers. The work buffers must hold their input in bit
+            reversed order.
+
+    \param  io_fft  The transform whose work buffers are transformed.
+ */
+static
+void
+cahal_fft_transform (
+                     cahal_fft* io_fft
+                     );
+
+cahal_fft*
+cahal_fft_create  (
+                   UINT32 in_size
+                   )
+{
+  cahal_fft* fft  = NULL;
+  UINT32 half     = in_size / 2;
+  UINT32 bits     = 0;
+
+  if( 4 > in_size || 0 != ( in_size & ( in_size - 1 ) ) )
+  {
+    CPC_ERROR( "Invalid FFT size: %d.", in_size );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &fft, sizeof( cahal_fft ) )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc FFT." );
+
+    return( NULL );
+  }
+
+  fft->size       = in_size;
+  fft->half_size  = half;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( fft->bit_reverse ),
+                               sizeof( UINT32 ) * half
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( fft->twiddle_real ),
+                               sizeof( FLOAT32 ) * half
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( fft->twiddle_imaginary ),
+                               sizeof( FLOAT32 ) * half
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( fft->split_real ),
+                               sizeof( FLOAT32 ) * half
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( fft->split_imaginary ),
+                               sizeof( FLOAT32 ) * half
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( fft->work_real ),
+                               sizeof( FLOAT32 ) * half
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( fft->work_imaginary ),
+                               sizeof( FLOAT32 ) * half
+                               )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc FFT tables." );
+
+    cahal_fft_free( fft );
+
+    return( NULL );
+  }
+
+  while( ( 1U << bits ) < half )
+  {
+    bits++;
+  }
+
+  for( UINT32 i = 0; i < half; i++ )
+  {
+    UINT32 reversed = 0;
+
+    for( UINT32 bit = 0; bit < bits; bit++ )
+    {
+      reversed |= ( ( i >> bit ) & 1 ) << ( bits - 1 - bit );
+    }
+
+    fft->bit_reverse[ i ] = reversed;
+
+    fft->twiddle_real[ i ]      =
+      ( FLOAT32 ) cos( -2.0 * CAHAL_FFT_PI * i / half );
+    fft->twiddle_imaginary[ i ] =
+      ( FLOAT32 ) sin( -2.0 * CAHAL_FFT_PI * i / half );
+
+    fft->split_real[ i ]        =
+      ( FLOAT32 ) cos( -2.0 * CAHAL_FFT_PI * i / in_size );
+    fft->split_imaginary[ i ]   =
+      ( FLOAT32 ) sin( -2.0 * CAHAL_FFT_PI * i / in_size );
+  }
+
+  return( fft );
+}
+
+void
+cahal_fft_free  (
+                 cahal_fft* in_fft
+                 )
+{
+  if( NULL != in_fft )
+  {
+    cpc_safe_free( ( void** ) &( in_fft->bit_reverse ) );
+    cpc_safe_free( ( void** ) &( in_fft->twiddle_real ) );
+    cpc_safe_free( ( void** ) &( in_fft->twiddle_imaginary ) );
+    cpc_safe_free( ( void** ) &( in_fft->split_real ) );
+    cpc_safe_free( ( void** ) &( in_fft->split_imaginary ) );
+    cpc_safe_free( ( void** ) &( in_fft->work_real ) );
+    cpc_safe_free( ( void** ) &( in_fft->work_imaginary ) );
+
+    cpc_safe_free( ( void** ) &in_fft );
+  }
+}
+
+static
+void
+cahal_fft_transform (
+                     cahal_fft* io_fft
+                     )
+{
+  UINT32 n        = io_fft->half_size;
+  FLOAT32* real   = io_fft->work_real;
+  FLOAT32* imag   = io_fft->work_imaginary;
+
+  for( UINT32 length = 2; length <= n; length <<= 1 )
+  {
+    UINT32 half = length / 2;
+    UINT32 step = n / length;
+
+    for( UINT32 start = 0; start < n; start += length )
+    {
+      for( UINT32 j = 0; j < half; j++ )
+      {
+        FLOAT32 w_real  = io_fft->twiddle_real[ j * step ];
+        FLOAT32 w_imag  = io_fft->twiddle_imaginary[ j * step ];
+        UINT32 a        = start + j;
+        UINT32 b        = a + half;
+        FLOAT32 t_real  = w_real * real[ b ] - w_imag * imag[ b ];
+        FLOAT32 t_imag  = w_real * imag[ b ] + w_imag * real[ b ];
+
+        real[ b ] = real[ a ] - t_real;
+        imag[ b ] = imag[ a ] - t_imag;
+        real[ a ] += t_real;
+        imag[ a ] += t_imag;
+      }
+    }
+  }
+}
+
+void
+cahal_fft_forward (
+                   cahal_fft*     in_fft,
+                   const FLOAT32* in_samples,
+                   FLOAT32*       out_real,
+                   FLOAT32*       out_imaginary
+                   )
+{
+  UINT32 n        = in_fft->half_size;
+  FLOAT32* real   = in_fft->work_real;
+  FLOAT32* imag   = in_fft->work_imaginary;
+
+  /*
+   * Even samples form the real part and odd samples the imaginary part of a
+   * complex sequence of half the length.
+   */
+  for( UINT32 i = 0; i < n; i++ )
+  {
+    UINT32 index = in_fft->bit_reverse[ i ];
+
+    real[ index ] = in_samples[ 2 * i ];
+    imag[ index ] = in_samples[ 2 * i + 1 ];
+  }
+
+  cahal_fft_transform( in_fft );
+
+  out_real[ 0 ]       = real[ 0 ] + imag[ 0 ];
+  out_imaginary[ 0 ]  = 0.0f;
+  out_real[ n ]       = real[ 0 ] - imag[ 0 ];
+  out_imaginary[ n ]  = 0.0f;
+
+  for( UINT32 k = 1; k < n; k++ )
+  {
+    FLOAT32 even_real = 0.5f * ( real[ k ] + real[ n - k ] );
+    FLOAT32 even_imag = 0.5f * ( imag[ k ] - imag[ n - k ] );
+    FLOAT32 odd_real  = 0.5f * ( imag[ k ] + imag[ n - k ] );
+    FLOAT32 odd_imag  = -0.5f * ( real[ k ] - real[ n - k ] );
+    FLOAT32 w_real    = in_fft->split_real[ k ];
+    FLOAT32 w_imag    = in_fft->split_imaginary[ k ];
+
+    out_real[ k ]       = even_real + w_real * odd_real - w_imag * odd_imag;
+    out_imaginary[ k ]  = even_imag + w_real * odd_imag + w_imag * odd_real;
+  }
+}
+
+void
+cahal_fft_inverse (
+                   cahal_fft*     in_fft,
+                   const FLOAT32* in_real,
+                   const FLOAT32* in_imaginary,
+                   FLOAT32*       out_samples
+                   )
+{
+  UINT32 n        = in_fft->half_size;
+  FLOAT32* real   = in_fft->work_real;
+  FLOAT32* imag   = in_fft->work_imaginary;
+  FLOAT32 scale   = 1.0f / n;
+
+  for( UINT32 k = 0; k < n; k++ )
+  {
+    UINT32 index        = in_fft->bit_reverse[ k ];
+    FLOAT32 even_real   = 0.5f * ( in_real[ k ] + in_real[ n - k ] );
+    FLOAT32 even_imag   = 0.5f * ( in_imaginary[ k ] - in_imaginary[ n - k ] );
+    FLOAT32 diff_real   = 0.5f * ( in_real[ k ] - in_real[ n - k ] );
+    FLOAT32 diff_imag   = 0.5f * ( in_imaginary[ k ] + in_imaginary[ n - k ] );
+    FLOAT32 w_real      = in_fft->split_real[ k ];
+    FLOAT32 w_imag      = -in_fft->split_imaginary[ k ];
+    FLOAT32 odd_real    = diff_real * w_real - diff_imag * w_imag;
+    FLOAT32 odd_imag    = diff_real * w_imag + diff_imag * w_real;
+
+    /*
+     * The inverse transform is computed as the conjugate of the forward
+     * transform of the conjugated input.
+     */
+    real[ index ] = even_real - odd_imag;
+    imag[ index ] = -( even_imag + odd_real );
+  }
+
+  cahal_fft_transform( in_fft );
+
+  for( UINT32 i = 0; i < n; i++ )
+  {
+    out_samples[ 2 * i ]      = real[ i ] * scale;
+    out_samples[ 2 * i + 1 ]  = -imag[ i ] * scale;
+  }
+}
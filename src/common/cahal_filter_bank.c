@@ -0,0 +1,588 @@
+/*! \file   cahal_filter_bank.c
+
+    \author Brent Carrara
+ */
+#include <math.h>
+
+#include "cahal_filter_bank.h"
+#include "cahal_audio_convert.h"
+#include "cahal_stream_state.h"
+
+#if     defined( __SSE__ ) || defined( _M_X64 )                           \
+        || ( defined( _M_IX86_FP ) && 1 <= _M_IX86_FP )
+#include <xmmintrin.h>
+#define CAHAL_FILTER_BANK_SSE
+#elif   defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#include <arm_neon.h>
+#define CAHAL_FILTER_BANK_NEON
+#endif
+
+/*! \def    CAHAL_FILTER_BANK_PI
+    \brief  The constant pi.
+ */
+#define CAHAL_FILTER_BANK_PI  3.14159265358979323846
+
+cahal_filter_bank* g_capture_filter_bank = NULL;
+
+/*! \fn     CPC_BOOL cahal_filter_bank_design  (
+              cahal_filter_section* io_section,
+              FLOAT64               in_sample_rate
+            )
+    \brief  Computes the coefficients of io_section for in_sample_rate. The
+            section passes samples through unchanged if the sample rate is not
+            known.
+
+    \param  io_section  The section to design.
+    \param  in_sample_rate  The sample rate of the stream.
+    \return True iff the section frequency is below the Nyquist frequency.
+ */
+static
+CPC_BOOL
+cahal_filter_bank_design  (
+                           cahal_filter_section* io_section,
+                           FLOAT64               in_sample_rate
+                           );
+
+/*! \fn     void cahal_filter_bank_run_section (
+              const FLOAT32*  in_coefficients,
+              FLOAT32*        io_state,
+              FLOAT32*        io_frames,
+              UINT32          in_number_of_frames,
+              UINT32          in_number_of_channels
+            )
+    \brief  Applies one section (transposed direct form II) to every channel
+            of io_frames in place. Channels are processed four at a time.
+
+    \param  in_coefficients The coefficients b0, b1, b2, a1 and a2.
+    \param  io_state  The memory of the section: the first state variable of
+                      every channel followed by the second one.
+    \param  io_frames The interleaved frames to filter.
+    \param  in_number_of_frames The number of frames in io_frames.
+    \param  in_number_of_channels The number of channels per frame.
+ */
+static
+void
+cahal_filter_bank_run_section (
+                               const FLOAT32*  in_coefficients,
+                               FLOAT32*        io_state,
+                               FLOAT32*        io_frames,
+                               UINT32          in_number_of_frames,
+                               UINT32          in_number_of_channels
+                               );
+
+cahal_filter_bank*
+cahal_filter_bank_create  (
+                           UINT32  in_number_of_channels,
+                           FLOAT64 in_sample_rate
+                           )
+{
+  cahal_filter_bank* bank = NULL;
+
+  if( 0 == in_number_of_channels || 0.0 > in_sample_rate )
+  {
+    CPC_ERROR (
+               "Invalid filter bank parameters: nc=%d, sr=%.2f.",
+               in_number_of_channels,
+               in_sample_rate
+               );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &bank, sizeof( cahal_filter_bank ) )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc filter bank." );
+
+    return( NULL );
+  }
+
+  bank->number_of_channels  = in_number_of_channels;
+  bank->sample_rate         = in_sample_rate;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &( bank->state ),
+                            2 * CAHAL_FILTER_BANK_MAXIMUM_SECTIONS
+                            * in_number_of_channels * sizeof( FLOAT32 )
+                            )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( bank->scratch ),
+                               CAHAL_FILTER_BANK_CHUNK_FRAMES
+                               * in_number_of_channels * sizeof( FLOAT32 )
+                               )
+       )
+  {
+    CPC_LOG_STRING  (
+                     CPC_LOG_LEVEL_ERROR,
+                     "Could not malloc filter bank buffers."
+                     );
+
+    cahal_filter_bank_free( bank );
+
+    bank = NULL;
+  }
+
+  return( bank );
+}
+
+void
+cahal_filter_bank_free  (
+                         cahal_filter_bank* in_bank
+                         )
+{
+  if( NULL != in_bank )
+  {
+    cpc_safe_free( ( void** ) &( in_bank->state ) );
+    cpc_safe_free( ( void** ) &( in_bank->scratch ) );
+
+    cpc_safe_free( ( void** ) &in_bank );
+  }
+}
+
+CPC_BOOL
+cahal_filter_bank_add_section  (
+                                cahal_filter_bank*  io_bank,
+                                cahal_filter_type   in_filter_type,
+                                FLOAT64             in_frequency,
+                                FLOAT64             in_quality,
+                                FLOAT64             in_gain
+                                )
+{
+  cahal_filter_section* section = NULL;
+
+  if  (
+       NULL == io_bank
+       || CAHAL_FILTER_BANK_MAXIMUM_SECTIONS <= io_bank->number_of_sections
+       || CAHAL_FILTER_DC_BLOCK < in_filter_type
+       || 0.0 >= in_frequency
+       || 0.0 >= in_quality
+       )
+  {
+    CPC_ERROR (
+               "Could not add filter section: type=%d, frequency=%.2f, "
+               "quality=%.3f.",
+               in_filter_type,
+               in_frequency,
+               in_quality
+               );
+
+    return( CPC_FALSE );
+  }
+
+  section = &( io_bank->sections[ io_bank->number_of_sections ] );
+
+  section->filter_type  = in_filter_type;
+  section->frequency    = in_frequency;
+  section->quality      = in_quality;
+  section->gain         = in_gain;
+
+  if( ! cahal_filter_bank_design( section, io_bank->sample_rate ) )
+  {
+    CPC_ERROR( "Filter frequency %.2f is above Nyquist.", in_frequency );
+
+    return( CPC_FALSE );
+  }
+
+  memset  (
+           io_bank->state
+           + 2 * io_bank->number_of_sections * io_bank->number_of_channels,
+           0,
+           2 * io_bank->number_of_channels * sizeof( FLOAT32 )
+           );
+
+  io_bank->number_of_sections++;
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_filter_bank_set_sample_rate (
+                                   cahal_filter_bank*  io_bank,
+                                   FLOAT64             in_sample_rate
+                                   )
+{
+  CPC_BOOL return_value = CPC_TRUE;
+
+  if( NULL == io_bank || 0.0 >= in_sample_rate )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid filter bank sample rate." );
+
+    return( CPC_FALSE );
+  }
+
+  io_bank->sample_rate = in_sample_rate;
+
+  for( UINT32 i = 0; i < io_bank->number_of_sections; i++ )
+  {
+    cahal_filter_section* section = &( io_bank->sections[ i ] );
+
+    if( ! cahal_filter_bank_design( section, in_sample_rate ) )
+    {
+      CPC_ERROR (
+                 "Filter frequency %.2f is above Nyquist.",
+                 section->frequency
+                 );
+
+      return_value = CPC_FALSE;
+    }
+  }
+
+  cahal_filter_bank_reset( io_bank );
+
+  return( return_value );
+}
+
+void
+cahal_filter_bank_reset (
+                         cahal_filter_bank* io_bank
+                         )
+{
+  if( NULL != io_bank )
+  {
+    memset  (
+             io_bank->state,
+             0,
+             2 * CAHAL_FILTER_BANK_MAXIMUM_SECTIONS
+             * io_bank->number_of_channels * sizeof( FLOAT32 )
+             );
+  }
+}
+
+void
+cahal_filter_bank_process (
+                           cahal_filter_bank* io_bank,
+                           FLOAT32*           io_frames,
+                           UINT32             in_number_of_frames
+                           )
+{
+  if( NULL == io_bank || NULL == io_frames )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null filter bank or buffer." );
+
+    return;
+  }
+
+  for( UINT32 i = 0; i < io_bank->number_of_sections; i++ )
+  {
+    cahal_filter_bank_run_section (
+                                   io_bank->sections[ i ].coefficients,
+                                   io_bank->state
+                                   + 2 * i * io_bank->number_of_channels,
+                                   io_frames,
+                                   in_number_of_frames,
+                                   io_bank->number_of_channels
+                                   );
+  }
+}
+
+CPC_BOOL
+cahal_filter_bank_process_buffer  (
+                                   cahal_filter_bank*      io_bank,
+                                   UCHAR*                  io_buffer,
+                                   UINT32                  in_buffer_length,
+                                   UINT32                  in_bit_depth,
+                                   cahal_audio_format_flag in_format_flags
+                                   )
+{
+  UINT32 frame_size       = 0;
+  UINT32 number_of_frames = 0;
+  UINT32 channels         = 0;
+
+  if  (
+       NULL == io_bank
+       || NULL == io_buffer
+       || ! cahal_test_conversion_support( in_bit_depth, in_format_flags )
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  channels          = io_bank->number_of_channels;
+  frame_size        = cahal_get_bytes_per_sample( in_bit_depth ) * channels;
+  number_of_frames  = in_buffer_length / frame_size;
+
+  while( 0 < number_of_frames )
+  {
+    UINT32 frames = number_of_frames;
+
+    if( CAHAL_FILTER_BANK_CHUNK_FRAMES < frames )
+    {
+      frames = CAHAL_FILTER_BANK_CHUNK_FRAMES;
+    }
+
+    cahal_convert_to_float32  (
+                               io_buffer,
+                               frames * channels,
+                               in_bit_depth,
+                               in_format_flags,
+                               io_bank->scratch
+                               );
+
+    cahal_filter_bank_process( io_bank, io_bank->scratch, frames );
+
+    cahal_convert_from_float32  (
+                                 io_bank->scratch,
+                                 frames * channels,
+                                 in_bit_depth,
+                                 in_format_flags,
+                                 io_buffer
+                                 );
+
+    io_buffer         += frames * frame_size;
+    number_of_frames  -= frames;
+  }
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_set_capture_filter_bank  (
+                                cahal_filter_bank* in_bank
+                                )
+{
+  if( NULL != in_bank && 0.0 >= in_bank->sample_rate )
+  {
+    CPC_LOG_STRING  (
+                     CPC_LOG_LEVEL_ERROR,
+                     "Capture filter bank needs a sample rate."
+                     );
+
+    return( CPC_FALSE );
+  }
+
+  //  The recording callbacks read the bank, so no recording may start while
+  //  it is replaced, after which nothing uses the old one
+  if( ! cahal_stream_state_begin_configure( &g_cahal_recording_state ) )
+  {
+    CPC_LOG_STRING  (
+                     CPC_LOG_LEVEL_ERROR,
+                     "Cannot set the capture filter bank while recording."
+                     );
+
+    return( CPC_FALSE );
+  }
+
+  g_capture_filter_bank = in_bank;
+
+  cahal_stream_state_end_configure( &g_cahal_recording_state );
+
+  return( CPC_TRUE );
+}
+
+static
+CPC_BOOL
+cahal_filter_bank_design  (
+                           cahal_filter_section* io_section,
+                           FLOAT64               in_sample_rate
+                           )
+{
+  FLOAT64 omega     = 0.0;
+  FLOAT64 cosine    = 0.0;
+  FLOAT64 alpha     = 0.0;
+  FLOAT64 amplitude = pow( 10.0, io_section->gain / 40.0 );
+  FLOAT64 root      = 0.0;
+  FLOAT64 b[ 3 ]    = { 1.0, 0.0, 0.0 };
+  FLOAT64 a[ 3 ]    = { 1.0, 0.0, 0.0 };
+
+  if( 0.0 < in_sample_rate )
+  {
+    if( io_section->frequency >= in_sample_rate / 2.0 )
+    {
+      return( CPC_FALSE );
+    }
+
+    omega   = 2.0 * CAHAL_FILTER_BANK_PI * io_section->frequency
+              / in_sample_rate;
+    cosine  = cos( omega );
+    alpha   = sin( omega ) / ( 2.0 * io_section->quality );
+    root    = 2.0 * sqrt( amplitude ) * alpha;
+
+    a[ 0 ] = 1.0 + alpha;
+    a[ 1 ] = -2.0 * cosine;
+    a[ 2 ] = 1.0 - alpha;
+
+    switch( io_section->filter_type )
+    {
+      case CAHAL_FILTER_LOWPASS:
+        b[ 0 ] = ( 1.0 - cosine ) / 2.0;
+        b[ 1 ] = 1.0 - cosine;
+        b[ 2 ] = ( 1.0 - cosine ) / 2.0;
+        break;
+
+      case CAHAL_FILTER_HIGHPASS:
+        b[ 0 ] = ( 1.0 + cosine ) / 2.0;
+        b[ 1 ] = -( 1.0 + cosine );
+        b[ 2 ] = ( 1.0 + cosine ) / 2.0;
+        break;
+
+      case CAHAL_FILTER_BANDPASS:
+        b[ 0 ] = alpha;
+        b[ 1 ] = 0.0;
+        b[ 2 ] = -alpha;
+        break;
+
+      case CAHAL_FILTER_NOTCH:
+        b[ 0 ] = 1.0;
+        b[ 1 ] = -2.0 * cosine;
+        b[ 2 ] = 1.0;
+        break;
+
+      case CAHAL_FILTER_PEAK:
+        b[ 0 ] = 1.0 + alpha * amplitude;
+        b[ 1 ] = -2.0 * cosine;
+        b[ 2 ] = 1.0 - alpha * amplitude;
+        a[ 0 ] = 1.0 + alpha / amplitude;
+        a[ 2 ] = 1.0 - alpha / amplitude;
+        break;
+
+      case CAHAL_FILTER_LOW_SHELF:
+        b[ 0 ] =
+          amplitude
+          * ( ( amplitude + 1.0 ) - ( amplitude - 1.0 ) * cosine + root );
+        b[ 1 ] =
+          2.0 * amplitude
+          * ( ( amplitude - 1.0 ) - ( amplitude + 1.0 ) * cosine );
+        b[ 2 ] =
+          amplitude
+          * ( ( amplitude + 1.0 ) - ( amplitude - 1.0 ) * cosine - root );
+        a[ 0 ] = ( amplitude + 1.0 ) + ( amplitude - 1.0 ) * cosine + root;
+        a[ 1 ] =
+          -2.0 * ( ( amplitude - 1.0 ) + ( amplitude + 1.0 ) * cosine );
+        a[ 2 ] = ( amplitude + 1.0 ) + ( amplitude - 1.0 ) * cosine - root;
+        break;
+
+      case CAHAL_FILTER_HIGH_SHELF:
+        b[ 0 ] =
+          amplitude
+          * ( ( amplitude + 1.0 ) + ( amplitude - 1.0 ) * cosine + root );
+        b[ 1 ] =
+          -2.0 * amplitude
+          * ( ( amplitude - 1.0 ) + ( amplitude + 1.0 ) * cosine );
+        b[ 2 ] =
+          amplitude
+          * ( ( amplitude + 1.0 ) + ( amplitude - 1.0 ) * cosine - root );
+        a[ 0 ] = ( amplitude + 1.0 ) - ( amplitude - 1.0 ) * cosine + root;
+        a[ 1 ] =
+          2.0 * ( ( amplitude - 1.0 ) - ( amplitude + 1.0 ) * cosine );
+        a[ 2 ] = ( amplitude + 1.0 ) - ( amplitude - 1.0 ) * cosine - root;
+        break;
+
+      case CAHAL_FILTER_DC_BLOCK:
+      default:
+        //  First order high-pass normalized to unity gain at Nyquist.
+        a[ 0 ] = 1.0;
+        a[ 1 ] = -exp( -omega );
+        a[ 2 ] = 0.0;
+        b[ 0 ] = ( 1.0 - a[ 1 ] ) / 2.0;
+        b[ 1 ] = -b[ 0 ];
+        b[ 2 ] = 0.0;
+        break;
+    }
+  }
+
+  io_section->coefficients[ 0 ] = ( FLOAT32 ) ( b[ 0 ] / a[ 0 ] );
+  io_section->coefficients[ 1 ] = ( FLOAT32 ) ( b[ 1 ] / a[ 0 ] );
+  io_section->coefficients[ 2 ] = ( FLOAT32 ) ( b[ 2 ] / a[ 0 ] );
+  io_section->coefficients[ 3 ] = ( FLOAT32 ) ( a[ 1 ] / a[ 0 ] );
+  io_section->coefficients[ 4 ] = ( FLOAT32 ) ( a[ 2 ] / a[ 0 ] );
+
+  return( CPC_TRUE );
+}
+
+static
+void
+cahal_filter_bank_run_section (
+                               const FLOAT32*  in_coefficients,
+                               FLOAT32*        io_state,
+                               FLOAT32*        io_frames,
+                               UINT32          in_number_of_frames,
+                               UINT32          in_number_of_channels
+                               )
+{
+  FLOAT32 b0      = in_coefficients[ 0 ];
+  FLOAT32 b1      = in_coefficients[ 1 ];
+  FLOAT32 b2      = in_coefficients[ 2 ];
+  FLOAT32 a1      = in_coefficients[ 3 ];
+  FLOAT32 a2      = in_coefficients[ 4 ];
+  FLOAT32* z1     = io_state;
+  FLOAT32* z2     = io_state + in_number_of_channels;
+  UINT32 vector   = 0;
+
+#if defined( CAHAL_FILTER_BANK_SSE )
+  __m128 vb0  = _mm_set1_ps( b0 );
+  __m128 vb1  = _mm_set1_ps( b1 );
+  __m128 vb2  = _mm_set1_ps( b2 );
+  __m128 va1  = _mm_set1_ps( a1 );
+  __m128 va2  = _mm_set1_ps( a2 );
+
+  vector = in_number_of_channels & ~3U;
+#elif defined( CAHAL_FILTER_BANK_NEON )
+  vector = in_number_of_channels & ~3U;
+#endif
+
+  for( UINT32 frame = 0; frame < in_number_of_frames; frame++ )
+  {
+    FLOAT32* samples = io_frames + frame * in_number_of_channels;
+
+#if defined( CAHAL_FILTER_BANK_SSE )
+    for( UINT32 channel = 0; channel < vector; channel += 4 )
+    {
+      __m128 x  = _mm_loadu_ps( samples + channel );
+      __m128 y  =
+        _mm_add_ps( _mm_mul_ps( vb0, x ), _mm_loadu_ps( z1 + channel ) );
+
+      _mm_storeu_ps (
+                     z1 + channel,
+                     _mm_add_ps (
+                                 _mm_sub_ps (
+                                             _mm_mul_ps( vb1, x ),
+                                             _mm_mul_ps( va1, y )
+                                             ),
+                                 _mm_loadu_ps( z2 + channel )
+                                 )
+                     );
+      _mm_storeu_ps (
+                     z2 + channel,
+                     _mm_sub_ps( _mm_mul_ps( vb2, x ), _mm_mul_ps( va2, y ) )
+                     );
+      _mm_storeu_ps( samples + channel, y );
+    }
+#elif defined( CAHAL_FILTER_BANK_NEON )
+    for( UINT32 channel = 0; channel < vector; channel += 4 )
+    {
+      float32x4_t x = vld1q_f32( samples + channel );
+      float32x4_t y = vmlaq_n_f32( vld1q_f32( z1 + channel ), x, b0 );
+
+      vst1q_f32 (
+                 z1 + channel,
+                 vmlsq_n_f32  (
+                               vmlaq_n_f32( vld1q_f32( z2 + channel ), x, b1 ),
+                               y,
+                               a1
+                               )
+                 );
+      vst1q_f32 (
+                 z2 + channel,
+                 vmlsq_n_f32( vmulq_n_f32( x, b2 ), y, a2 )
+                 );
+      vst1q_f32( samples + channel, y );
+    }
+#endif
+
+    for( UINT32 channel = vector; channel < in_number_of_channels; channel++ )
+    {
+      FLOAT32 x = samples[ channel ];
+      FLOAT32 y = b0 * x + z1[ channel ];
+
+      z1[ channel ] = b1 * x - a1 * y + z2[ channel ];
+      z2[ channel ] = b2 * x - a2 * y;
+
+      samples[ channel ] = y;
+    }
+  }
+}
@@ -0,0 +1,595 @@
+/*! \file   cahal_format_negotiation.c
+
+    \author Brent Carrara
+ */
+#include "cahal_format_negotiation.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "cahal_audio_convert.h"
+#include "cahal_drift_resampler.h"
+
+/*! \def    CAHAL_FORMAT_RESAMPLE_COST
+    \brief  The cost of resampling, before the distance between the rates.
+ */
+#define CAHAL_FORMAT_RESAMPLE_COST        1000.0
+
+/*! \def    CAHAL_FORMAT_MIX_COST
+    \brief  The cost of mixing channels, before the difference in channels.
+ */
+#define CAHAL_FORMAT_MIX_COST             100.0
+
+/*! \def    CAHAL_FORMAT_SAMPLE_COST
+    \brief  The cost of converting samples, before the difference in bit
+            depth.
+ */
+#define CAHAL_FORMAT_SAMPLE_COST          10.0
+
+/*! \def    CAHAL_FORMAT_KEY
+    \brief  The index key of a format id, number of channels and bit depth.
+ */
+#define CAHAL_FORMAT_KEY( in_format_id, in_channels, in_bit_depth )       \
+  (                                                                       \
+    ( ( UINT64 ) ( ( in_format_id ) & 0xFFFF ) << 48 )                    \
+    | ( ( UINT64 ) ( in_channels ) << 16 )                                \
+    | ( UINT64 ) ( ( in_bit_depth ) & 0xFFFF )                            \
+  )
+
+/*! \fn     int cahal_compare_format_index_entries  (
+              const void* in_first,
+              const void* in_second
+            )
+    \brief  qsort comparator ordering entries by key and then minimum rate.
+
+    \param  in_first  The first entry.
+    \param  in_second The second entry.
+    \return Less than, equal to or greater than zero as in_first sorts
+            before, with or after in_second.
+ */
+static
+int
+cahal_compare_format_index_entries  (
+                                     const void* in_first,
+                                     const void* in_second
+                                     );
+
+/*! \fn     UINT32 cahal_hash_format_key  (
+              UINT64 in_key,
+              UINT32 in_number_of_buckets
+            )
+    \brief  Returns the bucket of in_key.
+
+    \param  in_key  The key to hash.
+    \param  in_number_of_buckets  The number of buckets, a power of two.
+    \return The bucket.
+ */
+static
+UINT32
+cahal_hash_format_key  (
+                        UINT64 in_key,
+                        UINT32 in_number_of_buckets
+                        );
+
+/*! \fn     CPC_BOOL cahal_score_format  (
+              cahal_format_index_entry* in_entry,
+              cahal_format_request*     in_request,
+              cahal_device_stream_direction in_direction,
+              cahal_format_match*       out_match
+            )
+    \brief  Works out the conversions needed between in_request and the
+            native format of in_entry, and their cost.
+
+    \param  in_entry  The native format.
+    \param  in_request  The requested format and constraints.
+    \param  in_direction  The direction of the stream, which orders the steps.
+    \param  out_match The match with in_entry.
+    \return True iff in_entry satisfies the constraints of in_request.
+ */
+static
+CPC_BOOL
+cahal_score_format  (
+                     cahal_format_index_entry*      in_entry,
+                     cahal_format_request*          in_request,
+                     cahal_device_stream_direction  in_direction,
+                     cahal_format_match*            out_match
+                     );
+
+/*! \fn     cahal_audio_format_flag cahal_get_native_format_flags  (
+              UINT32                  in_bit_depth,
+              cahal_audio_format_flag in_requested_flags
+            )
+    \brief  Returns the flags a native format of in_bit_depth is opened with.
+            Native formats only report their bit depth, so 32-bit formats are
+            assumed to be available as floating point samples as well as
+            integers and the request picks between the two. 8-bit samples are
+            unsigned and all others are signed.
+
+    \param  in_bit_depth  The bit depth of the native format.
+    \param  in_requested_flags  The flags of the request.
+    \return The flags.
+ */
+static
+cahal_audio_format_flag
+cahal_get_native_format_flags  (
+                                UINT32                  in_bit_depth,
+                                cahal_audio_format_flag in_requested_flags
+                                );
+
+cahal_format_index*
+cahal_create_format_index  (
+                            cahal_device_stream* in_stream
+                            )
+{
+  cahal_format_index* index = NULL;
+  UINT32 number_of_formats  = 0;
+
+  if( NULL == in_stream )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid stream." );
+
+    return( NULL );
+  }
+
+  while  (
+          NULL != in_stream->supported_formats
+          && NULL != in_stream->supported_formats[ number_of_formats ]
+          )
+  {
+    number_of_formats++;
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &index, sizeof( cahal_format_index ) )
+       )
+  {
+    CPC_ERROR (
+               "Could not malloc format index: %lu.",
+               ( unsigned long ) sizeof( cahal_format_index )
+               );
+
+    return( NULL );
+  }
+
+  index->stream             = in_stream;
+  index->number_of_buckets  = 4;
+
+  while( index->number_of_buckets < number_of_formats * 2 )
+  {
+    index->number_of_buckets *= 2;
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &( index->entries ),
+                            sizeof( cahal_format_index_entry )
+                            * ( number_of_formats + 1 )
+                            )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( index->buckets ),
+                               sizeof( UINT32 ) * index->number_of_buckets
+                               )
+       )
+  {
+    CPC_ERROR( "Could not malloc format index entries: 0x%x.",
+               number_of_formats );
+
+    cahal_free_format_index( index );
+
+    return( NULL );
+  }
+
+  for( UINT32 i = 0; i < number_of_formats; i++ )
+  {
+    cahal_audio_format_description* format = in_stream->supported_formats[ i ];
+    cahal_format_index_entry* entry = &( index->entries[ i ] );
+
+    entry->format       = format;
+    entry->key          =
+      CAHAL_FORMAT_KEY  (
+                         format->format_id,
+                         format->number_of_channels,
+                         format->bit_depth
+                         );
+    entry->minimum_rate = format->sample_rate_range.minimum_rate;
+    entry->maximum_rate = format->sample_rate_range.maximum_rate;
+  }
+
+  qsort (
+         index->entries,
+         number_of_formats,
+         sizeof( cahal_format_index_entry ),
+         cahal_compare_format_index_entries
+         );
+
+  for( UINT32 i = 0; i < number_of_formats; i++ )
+  {
+    cahal_format_index_entry* entry = &( index->entries[ i ] );
+    cahal_format_index_entry* last  =
+      0 == index->number_of_entries
+      ? NULL : &( index->entries[ index->number_of_entries - 1 ] );
+
+    //  Platforms may report the same format more than once, e.g. once per
+    //  data source, so duplicates are dropped.
+    if  (
+         NULL != last
+         && 0 == cahal_compare_format_index_entries( last, entry )
+         && last->maximum_rate == entry->maximum_rate
+         )
+    {
+      continue;
+    }
+
+    if( NULL == last || last->key != entry->key )
+    {
+      UINT32 mask = index->number_of_buckets - 1;
+      UINT32 slot =
+        cahal_hash_format_key( entry->key, index->number_of_buckets );
+
+      while( 0 != index->buckets[ slot ] )
+      {
+        slot = ( slot + 1 ) & mask;
+      }
+
+      index->buckets[ slot ] = index->number_of_entries + 1;
+    }
+
+    index->entries[ index->number_of_entries++ ] = *entry;
+  }
+
+  CPC_LOG (
+           CPC_LOG_LEVEL_DEBUG,
+           "Indexed 0x%x of 0x%x formats of stream 0x%x.",
+           index->number_of_entries,
+           number_of_formats,
+           in_stream->handle
+           );
+
+  return( index );
+}
+
+CPC_BOOL
+cahal_find_best_format  (
+                         cahal_format_index*   in_index,
+                         cahal_format_request* in_request,
+                         cahal_format_match*   out_match
+                         )
+{
+  cahal_format_match candidate;
+  CPC_BOOL found = CPC_FALSE;
+
+  if( NULL == in_index || NULL == in_request || NULL == out_match )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid parameters." );
+
+    return( CPC_FALSE );
+  }
+
+  //  Look the requested format up first. If the hardware supports it at the
+  //  requested rate there is nothing cheaper and the other formats need not
+  //  be looked at.
+  UINT64 key  =
+    CAHAL_FORMAT_KEY  (
+                       in_request->format_id,
+                       in_request->number_of_channels,
+                       in_request->bit_depth
+                       );
+  UINT32 mask = in_index->number_of_buckets - 1;
+  UINT32 slot = cahal_hash_format_key( key, in_index->number_of_buckets );
+
+  while( 0 != in_index->buckets[ slot ] )
+  {
+    UINT32 first = in_index->buckets[ slot ] - 1;
+
+    if( in_index->entries[ first ].key == key )
+    {
+      for  (
+            UINT32 i = first;
+            i < in_index->number_of_entries
+            && in_index->entries[ i ].key == key;
+            i++
+            )
+      {
+        if  (
+             cahal_score_format  (
+                                  &( in_index->entries[ i ] ),
+                                  in_request,
+                                  in_index->stream->direction,
+                                  &candidate
+                                  )
+             && CAHAL_FORMAT_CONVERSION_NONE == candidate.conversions
+             && ( ! found || candidate.cost < out_match->cost )
+             )
+        {
+          *out_match  = candidate;
+          found       = CPC_TRUE;
+        }
+      }
+
+      break;
+    }
+
+    slot = ( slot + 1 ) & mask;
+  }
+
+  if( found )
+  {
+    return( CPC_TRUE );
+  }
+
+  for( UINT32 i = 0; i < in_index->number_of_entries; i++ )
+  {
+    if  (
+         cahal_score_format  (
+                              &( in_index->entries[ i ] ),
+                              in_request,
+                              in_index->stream->direction,
+                              &candidate
+                              )
+         && ( ! found || candidate.cost < out_match->cost )
+         )
+    {
+      *out_match  = candidate;
+      found       = CPC_TRUE;
+    }
+  }
+
+  if( ! found )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_DEBUG,
+             "No format of stream 0x%x satisfies the request.",
+             in_index->stream->handle
+             );
+  }
+
+  return( found );
+}
+
+void
+cahal_free_format_index  (
+                          cahal_format_index* in_index
+                          )
+{
+  if( NULL != in_index )
+  {
+    cpc_safe_free( ( void** ) &( in_index->entries ) );
+    cpc_safe_free( ( void** ) &( in_index->buckets ) );
+    cpc_safe_free( ( void** ) &in_index );
+  }
+}
+
+static
+int
+cahal_compare_format_index_entries  (
+                                     const void* in_first,
+                                     const void* in_second
+                                     )
+{
+  const cahal_format_index_entry* first   = in_first;
+  const cahal_format_index_entry* second  = in_second;
+
+  if( first->key != second->key )
+  {
+    return( first->key < second->key ? -1 : 1 );
+  }
+  else if( first->minimum_rate != second->minimum_rate )
+  {
+    return( first->minimum_rate < second->minimum_rate ? -1 : 1 );
+  }
+  else
+  {
+    return( 0 );
+  }
+}
+
+static
+UINT32
+cahal_hash_format_key  (
+                        UINT64 in_key,
+                        UINT32 in_number_of_buckets
+                        )
+{
+  UINT64 hash = in_key * 0x9E3779B97F4A7C15ULL;
+
+  return( ( UINT32 ) ( hash >> 32 ) & ( in_number_of_buckets - 1 ) );
+}
+
+static
+CPC_BOOL
+cahal_score_format  (
+                     cahal_format_index_entry*      in_entry,
+                     cahal_format_request*          in_request,
+                     cahal_device_stream_direction  in_direction,
+                     cahal_format_match*            out_match
+                     )
+{
+  cahal_audio_format_description* format = in_entry->format;
+
+  if( format->format_id != in_request->format_id )
+  {
+    return( CPC_FALSE );
+  }
+
+  memset( out_match, 0, sizeof( cahal_format_match ) );
+
+  out_match->format       = format;
+  out_match->format_flags =
+    cahal_get_native_format_flags  (
+                                    format->bit_depth,
+                                    in_request->format_flags
+                                    );
+
+  //  Open the stream at the supported rate closest to the requested one.
+  //  It is only resampled if that is further away than the caller tolerates.
+  out_match->sample_rate = in_request->sample_rate;
+
+  if( out_match->sample_rate < in_entry->minimum_rate )
+  {
+    out_match->sample_rate = in_entry->minimum_rate;
+  }
+  else if( out_match->sample_rate > in_entry->maximum_rate )
+  {
+    out_match->sample_rate = in_entry->maximum_rate;
+  }
+
+  FLOAT64 rate_distance =
+    fabs( out_match->sample_rate - in_request->sample_rate );
+
+  if( rate_distance > in_request->sample_rate_tolerance )
+  {
+    out_match->conversions |= CAHAL_FORMAT_CONVERSION_SAMPLE_RATE;
+    out_match->cost        +=
+      CAHAL_FORMAT_RESAMPLE_COST
+      + 100.0
+        * fabs( log2( out_match->sample_rate / in_request->sample_rate ) );
+    out_match->latency      =
+      CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES / out_match->sample_rate;
+  }
+  else if( 0 < in_request->sample_rate )
+  {
+    out_match->cost += rate_distance / in_request->sample_rate;
+  }
+
+  if( format->number_of_channels != in_request->number_of_channels )
+  {
+    out_match->conversions |= CAHAL_FORMAT_CONVERSION_CHANNELS;
+    out_match->cost        +=
+      CAHAL_FORMAT_MIX_COST
+      + 10.0
+        * abs (
+               ( INT32 ) format->number_of_channels
+               - ( INT32 ) in_request->number_of_channels
+               );
+
+    //  Dropping channels loses information, adding them does not.
+    if( format->number_of_channels < in_request->number_of_channels )
+    {
+      out_match->cost += CAHAL_FORMAT_MIX_COST / 2;
+    }
+  }
+
+  CPC_BOOL native_float   =
+    ( out_match->format_flags & CAHAL_AUDIO_FORMAT_FLAGISFLOAT ) ? 1 : 0;
+  CPC_BOOL request_float  =
+    ( in_request->format_flags & CAHAL_AUDIO_FORMAT_FLAGISFLOAT ) ? 1 : 0;
+
+  if  (
+       format->bit_depth != in_request->bit_depth
+       || native_float != request_float
+       )
+  {
+    out_match->conversions |= CAHAL_FORMAT_CONVERSION_SAMPLE_FORMAT;
+    out_match->cost        +=
+      CAHAL_FORMAT_SAMPLE_COST
+      + abs( ( INT32 ) format->bit_depth - ( INT32 ) in_request->bit_depth )
+        / 8.0;
+
+    if( format->bit_depth < in_request->bit_depth )
+    {
+      out_match->cost += CAHAL_FORMAT_SAMPLE_COST * 2;
+    }
+  }
+
+  if  (
+       out_match->conversions
+       & ~in_request->allowed_conversions
+       & CAHAL_FORMAT_CONVERSION_ALL
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  if  (
+       0 < in_request->maximum_latency
+       && out_match->latency > in_request->maximum_latency
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  if( CAHAL_FORMAT_CONVERSION_NONE == out_match->conversions )
+  {
+    return( CPC_TRUE );
+  }
+
+  if  (
+       CAHAL_AUDIO_FORMAT_LINEARPCM != format->format_id
+       || ! cahal_test_conversion_support  (
+                                            format->bit_depth,
+                                            out_match->format_flags
+                                            )
+       || ! cahal_test_conversion_support  (
+                                            in_request->bit_depth,
+                                            in_request->format_flags
+                                            )
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  CPC_BOOL native_float32   = native_float && 32 == format->bit_depth;
+  CPC_BOOL request_float32  = request_float && 32 == in_request->bit_depth;
+  CPC_BOOL source_float32   =
+    CAHAL_DEVICE_OUTPUT_STREAM == in_direction
+    ? request_float32 : native_float32;
+  CPC_BOOL sink_float32     =
+    CAHAL_DEVICE_OUTPUT_STREAM == in_direction
+    ? native_float32 : request_float32;
+
+  if( ! source_float32 )
+  {
+    out_match->steps[ out_match->number_of_steps++ ] =
+      CAHAL_FORMAT_STEP_TO_FLOAT32;
+  }
+
+  if( out_match->conversions & CAHAL_FORMAT_CONVERSION_CHANNELS )
+  {
+    out_match->steps[ out_match->number_of_steps++ ] =
+      CAHAL_FORMAT_STEP_MIX_CHANNELS;
+  }
+
+  if( out_match->conversions & CAHAL_FORMAT_CONVERSION_SAMPLE_RATE )
+  {
+    out_match->steps[ out_match->number_of_steps++ ] =
+      CAHAL_FORMAT_STEP_RESAMPLE;
+  }
+
+  if( ! sink_float32 )
+  {
+    out_match->steps[ out_match->number_of_steps++ ] =
+      CAHAL_FORMAT_STEP_FROM_FLOAT32;
+  }
+
+  return( CPC_TRUE );
+}
+
+static
+cahal_audio_format_flag
+cahal_get_native_format_flags  (
+                                UINT32                  in_bit_depth,
+                                cahal_audio_format_flag in_requested_flags
+                                )
+{
+  if  (
+       32 == in_bit_depth
+       && ( in_requested_flags & CAHAL_AUDIO_FORMAT_FLAGISFLOAT )
+       )
+  {
+    return( CAHAL_AUDIO_FORMAT_FLAGISFLOAT | CAHAL_AUDIO_FORMAT_FLAGISPACKED );
+  }
+  else if( 8 == in_bit_depth )
+  {
+    return( CAHAL_AUDIO_FORMAT_FLAGISPACKED );
+  }
+  else
+  {
+    return  (
+             CAHAL_AUDIO_FORMAT_FLAGISSIGNEDINTEGER
+             | CAHAL_AUDIO_FORMAT_FLAGISPACKED
+             );
+  }
+}
@@ -0,0 +1,1543 @@
+/*! \file   cahal_graph.c
+
+    \author Brent Carrara
+ */
+#include <math.h>
+
+#include "cahal_graph.h"
+#include "cahal_audio_convert.h"
+
+/*! \def    CAHAL_GRAPH_IS_IN_PLACE
+    \brief  True iff nodes of type x process the frames of their first input
+            port in place.
+ */
+#define CAHAL_GRAPH_IS_IN_PLACE( x )                                      \
+  (                                                                       \
+   CAHAL_GRAPH_NODE_GAIN == ( x )                                         \
+   || CAHAL_GRAPH_NODE_FILTER == ( x )                                    \
+   || CAHAL_GRAPH_NODE_METER == ( x )                                     \
+   || CAHAL_GRAPH_NODE_USER == ( x )                                      \
+   || CAHAL_GRAPH_NODE_OUTPUT == ( x )                                    \
+  )
+
+/*! \fn     cahal_graph_node* cahal_graph_add_node (
+              cahal_graph*          io_graph,
+              cahal_graph_node_type in_node_type,
+              UINT32                in_number_of_channels,
+              UINT32                in_input_channels,
+              UINT32                in_number_of_inputs
+            )
+    \brief  Adds a node with the given port types to the graph.
+
+    \param  io_graph  The graph to add the node to.
+    \param  in_node_type  The kind of node.
+    \param  in_number_of_channels The type of the output port.
+    \param  in_input_channels The type of the input ports.
+    \param  in_number_of_inputs The number of input ports.
+    \return The new node or NULL on error.
+ */
+static
+cahal_graph_node*
+cahal_graph_add_node (
+                      cahal_graph*          io_graph,
+                      cahal_graph_node_type in_node_type,
+                      UINT32                in_number_of_channels,
+                      UINT32                in_input_channels,
+                      UINT32                in_number_of_inputs
+                      );
+
+/*! \fn     CPC_BOOL cahal_graph_allocate  (
+              FLOAT32** out_buffer,
+              UINT32    in_number_of_samples
+            )
+    \brief  Allocates a zeroed buffer of floating point samples.
+
+    \param  out_buffer  Set to the new buffer.
+    \param  in_number_of_samples  The number of samples in the buffer.
+    \return True iff the buffer was allocated.
+ */
+static
+CPC_BOOL
+cahal_graph_allocate  (
+                       FLOAT32** out_buffer,
+                       UINT32    in_number_of_samples
+                       );
+
+/*! \fn     CPC_BOOL cahal_graph_sort  (
+              cahal_graph* io_graph
+            )
+    \brief  Sorts the nodes topologically into io_graph->order.
+
+    \param  io_graph  The graph to sort.
+    \return True iff every node was reached, i.e. the graph has no cycle.
+ */
+static
+CPC_BOOL
+cahal_graph_sort  (
+                   cahal_graph* io_graph
+                   );
+
+/*! \fn     CPC_BOOL cahal_graph_resolve_node  (
+              cahal_graph*      io_graph,
+              cahal_graph_node* io_node
+            )
+    \brief  Resolves the sample rate and buffer of io_node from its inputs,
+            which must already have been resolved.
+
+    \param  io_graph  The graph being prepared.
+    \param  io_node The node to resolve.
+    \return True iff the node is valid.
+ */
+static
+CPC_BOOL
+cahal_graph_resolve_node  (
+                           cahal_graph*      io_graph,
+                           cahal_graph_node* io_node
+                           );
+
+/*! \fn     CPC_BOOL cahal_graph_run  (
+              cahal_graph* io_graph
+            )
+    \brief  Runs every node, in order, on the frames in the buffer of the
+            input node.
+
+    \param  io_graph  The prepared graph.
+    \return True iff every node succeeded.
+ */
+static
+CPC_BOOL
+cahal_graph_run  (
+                  cahal_graph* io_graph
+                  );
+
+/*! \fn     CPC_BOOL cahal_graph_run_node  (
+              cahal_graph_node* io_node
+            )
+    \brief  Runs a single node on the frames of its inputs.
+
+    \param  io_node The node to run.
+    \return True iff the node succeeded.
+ */
+static
+CPC_BOOL
+cahal_graph_run_node  (
+                       cahal_graph_node* io_node
+                       );
+
+/*! \fn     void cahal_graph_free_buffers  (
+              cahal_graph* io_graph
+            )
+    \brief  Frees the buffers allocated by cahal_graph_prepare.
+
+    \param  io_graph  The graph whose buffers are freed.
+ */
+static
+void
+cahal_graph_free_buffers  (
+                           cahal_graph* io_graph
+                           );
+
+cahal_graph*
+cahal_graph_create (
+                    UINT32 in_maximum_number_of_nodes
+                    )
+{
+  cahal_graph* graph = NULL;
+
+  if( 0 == in_maximum_number_of_nodes )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Graph must hold at least one node." );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &graph, sizeof( cahal_graph ) )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc graph." );
+
+    return( NULL );
+  }
+
+  graph->maximum_number_of_nodes = in_maximum_number_of_nodes;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &( graph->nodes ),
+                            in_maximum_number_of_nodes
+                            * sizeof( cahal_graph_node )
+                            )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( graph->order ),
+                               in_maximum_number_of_nodes
+                               * sizeof( cahal_graph_node* )
+                               )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc graph nodes." );
+
+    cahal_graph_free( graph );
+
+    graph = NULL;
+  }
+
+  return( graph );
+}
+
+void
+cahal_graph_free (
+                  cahal_graph* in_graph
+                  )
+{
+  if( NULL != in_graph )
+  {
+    cahal_graph_free_buffers( in_graph );
+
+    if( NULL != in_graph->nodes )
+    {
+      for( UINT32 i = 0; i < in_graph->number_of_nodes; i++ )
+      {
+        cpc_safe_free( ( void** ) &( in_graph->nodes[ i ].parameters ) );
+        cpc_safe_free( ( void** ) &( in_graph->nodes[ i ].state ) );
+
+        cahal_filter_bank_free( in_graph->nodes[ i ].filter_bank );
+      }
+    }
+
+    cpc_safe_free( ( void** ) &( in_graph->nodes ) );
+    cpc_safe_free( ( void** ) &( in_graph->order ) );
+
+    cpc_safe_free( ( void** ) &in_graph );
+  }
+}
+
+cahal_graph_node*
+cahal_graph_add_input  (
+                        cahal_graph*            io_graph,
+                        UINT32                  in_number_of_channels,
+                        FLOAT64                 in_sample_rate,
+                        UINT32                  in_bit_depth,
+                        cahal_audio_format_flag in_format_flags
+                        )
+{
+  cahal_graph_node* node = NULL;
+
+  if  (
+       NULL == io_graph
+       || NULL != io_graph->input
+       || 0.0 >= in_sample_rate
+       || ! cahal_test_conversion_support( in_bit_depth, in_format_flags )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid graph input node." );
+
+    return( NULL );
+  }
+
+  node =
+    cahal_graph_add_node  (
+                           io_graph,
+                           CAHAL_GRAPH_NODE_INPUT,
+                           in_number_of_channels,
+                           0,
+                           0
+                           );
+
+  if( NULL != node )
+  {
+    node->sample_rate   = in_sample_rate;
+    node->bit_depth     = in_bit_depth;
+    node->format_flags  = in_format_flags;
+
+    io_graph->input = node;
+  }
+
+  return( node );
+}
+
+cahal_graph_node*
+cahal_graph_add_output (
+                        cahal_graph*            io_graph,
+                        UINT32                  in_number_of_channels,
+                        FLOAT64                 in_sample_rate,
+                        UINT32                  in_bit_depth,
+                        cahal_audio_format_flag in_format_flags
+                        )
+{
+  cahal_graph_node* node = NULL;
+
+  if  (
+       NULL == io_graph
+       || NULL != io_graph->output
+       || 0.0 >= in_sample_rate
+       || ! cahal_test_conversion_support( in_bit_depth, in_format_flags )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid graph output node." );
+
+    return( NULL );
+  }
+
+  node =
+    cahal_graph_add_node  (
+                           io_graph,
+                           CAHAL_GRAPH_NODE_OUTPUT,
+                           in_number_of_channels,
+                           in_number_of_channels,
+                           1
+                           );
+
+  if( NULL != node )
+  {
+    node->sample_rate   = in_sample_rate;
+    node->bit_depth     = in_bit_depth;
+    node->format_flags  = in_format_flags;
+
+    io_graph->output = node;
+  }
+
+  return( node );
+}
+
+cahal_graph_node*
+cahal_graph_add_gain (
+                      cahal_graph*  io_graph,
+                      UINT32        in_number_of_channels,
+                      FLOAT32       in_gain
+                      )
+{
+  cahal_graph_node* node =
+    cahal_graph_add_node  (
+                           io_graph,
+                           CAHAL_GRAPH_NODE_GAIN,
+                           in_number_of_channels,
+                           in_number_of_channels,
+                           1
+                           );
+
+  if( NULL != node )
+  {
+    if  (
+         ! cahal_graph_allocate( &( node->parameters ), in_number_of_channels )
+         )
+    {
+      io_graph->number_of_nodes--;
+
+      return( NULL );
+    }
+
+    for( UINT32 i = 0; i < in_number_of_channels; i++ )
+    {
+      node->parameters[ i ] = in_gain;
+    }
+  }
+
+  return( node );
+}
+
+cahal_graph_node*
+cahal_graph_add_remix  (
+                        cahal_graph*  io_graph,
+                        UINT32        in_input_channels,
+                        UINT32        in_output_channels
+                        )
+{
+  cahal_graph_node* node = NULL;
+
+  if( 0 == in_input_channels )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid remix node." );
+
+    return( NULL );
+  }
+
+  node =
+    cahal_graph_add_node  (
+                           io_graph,
+                           CAHAL_GRAPH_NODE_REMIX,
+                           in_output_channels,
+                           in_input_channels,
+                           1
+                           );
+
+  if( NULL != node )
+  {
+    if  (
+         ! cahal_graph_allocate (
+                                 &( node->parameters ),
+                                 in_output_channels * in_input_channels
+                                 )
+         )
+    {
+      io_graph->number_of_nodes--;
+
+      return( NULL );
+    }
+
+    for( UINT32 output = 0; output < in_output_channels; output++ )
+    {
+      FLOAT32* row = node->parameters + output * in_input_channels;
+
+      if( 1 == in_output_channels )
+      {
+        for( UINT32 input = 0; input < in_input_channels; input++ )
+        {
+          row[ input ] = 1.0f / in_input_channels;
+        }
+      }
+      else
+      {
+        row[ output % in_input_channels ] = 1.0f;
+      }
+    }
+  }
+
+  return( node );
+}
+
+cahal_graph_node*
+cahal_graph_add_mix  (
+                      cahal_graph*  io_graph,
+                      UINT32        in_number_of_channels,
+                      UINT32        in_number_of_inputs
+                      )
+{
+  if  (
+       0 == in_number_of_inputs
+       || CAHAL_GRAPH_MAXIMUM_INPUTS < in_number_of_inputs
+       )
+  {
+    CPC_ERROR( "Invalid number of mix inputs: %d.", in_number_of_inputs );
+
+    return( NULL );
+  }
+
+  return  (
+           cahal_graph_add_node (
+                                 io_graph,
+                                 CAHAL_GRAPH_NODE_MIX,
+                                 in_number_of_channels,
+                                 in_number_of_channels,
+                                 in_number_of_inputs
+                                 )
+           );
+}
+
+cahal_graph_node*
+cahal_graph_add_resample (
+                          cahal_graph*  io_graph,
+                          UINT32        in_number_of_channels,
+                          FLOAT64       in_sample_rate
+                          )
+{
+  cahal_graph_node* node = NULL;
+
+  if( 0.0 >= in_sample_rate )
+  {
+    CPC_ERROR( "Invalid resample rate: %.2f.", in_sample_rate );
+
+    return( NULL );
+  }
+
+  node =
+    cahal_graph_add_node  (
+                           io_graph,
+                           CAHAL_GRAPH_NODE_RESAMPLE,
+                           in_number_of_channels,
+                           in_number_of_channels,
+                           1
+                           );
+
+  if( NULL != node )
+  {
+    if( ! cahal_graph_allocate( &( node->state ), in_number_of_channels ) )
+    {
+      io_graph->number_of_nodes--;
+
+      return( NULL );
+    }
+
+    node->sample_rate = in_sample_rate;
+  }
+
+  return( node );
+}
+
+cahal_graph_node*
+cahal_graph_add_filter (
+                        cahal_graph*      io_graph,
+                        UINT32            in_number_of_channels,
+                        cahal_filter_type in_filter_type,
+                        FLOAT64           in_frequency,
+                        FLOAT64           in_quality,
+                        FLOAT64           in_gain
+                        )
+{
+  cahal_graph_node* node =
+    cahal_graph_add_node  (
+                           io_graph,
+                           CAHAL_GRAPH_NODE_FILTER,
+                           in_number_of_channels,
+                           in_number_of_channels,
+                           1
+                           );
+
+  if( NULL != node )
+  {
+    //  The sample rate is only known once the graph is prepared.
+    node->filter_bank = cahal_filter_bank_create( in_number_of_channels, 0 );
+
+    if  (
+         ! cahal_graph_node_add_section (
+                                         node,
+                                         in_filter_type,
+                                         in_frequency,
+                                         in_quality,
+                                         in_gain
+                                         )
+         )
+    {
+      cahal_filter_bank_free( node->filter_bank );
+
+      node->filter_bank = NULL;
+
+      io_graph->number_of_nodes--;
+
+      return( NULL );
+    }
+  }
+
+  return( node );
+}
+
+CPC_BOOL
+cahal_graph_node_add_section  (
+                               cahal_graph_node* io_node,
+                               cahal_filter_type in_filter_type,
+                               FLOAT64           in_frequency,
+                               FLOAT64           in_quality,
+                               FLOAT64           in_gain
+                               )
+{
+  if( NULL == io_node || CAHAL_GRAPH_NODE_FILTER != io_node->node_type )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Not a filter node." );
+
+    return( CPC_FALSE );
+  }
+
+  return  (
+           cahal_filter_bank_add_section  (
+                                           io_node->filter_bank,
+                                           in_filter_type,
+                                           in_frequency,
+                                           in_quality,
+                                           in_gain
+                                           )
+           );
+}
+
+cahal_graph_node*
+cahal_graph_add_meter  (
+                        cahal_graph*  io_graph,
+                        UINT32        in_number_of_channels
+                        )
+{
+  cahal_graph_node* node =
+    cahal_graph_add_node  (
+                           io_graph,
+                           CAHAL_GRAPH_NODE_METER,
+                           in_number_of_channels,
+                           in_number_of_channels,
+                           1
+                           );
+
+  if( NULL != node )
+  {
+    if  (
+         ! cahal_graph_allocate( &( node->state ), 2 * in_number_of_channels )
+         )
+    {
+      io_graph->number_of_nodes--;
+
+      return( NULL );
+    }
+  }
+
+  return( node );
+}
+
+cahal_graph_node*
+cahal_graph_add_user (
+                      cahal_graph*              io_graph,
+                      UINT32                    in_number_of_channels,
+                      cahal_graph_node_callback in_callback,
+                      void*                     in_user_data
+                      )
+{
+  cahal_graph_node* node = NULL;
+
+  if( NULL == in_callback )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "User node needs a callback." );
+
+    return( NULL );
+  }
+
+  node =
+    cahal_graph_add_node  (
+                           io_graph,
+                           CAHAL_GRAPH_NODE_USER,
+                           in_number_of_channels,
+                           in_number_of_channels,
+                           1
+                           );
+
+  if( NULL != node )
+  {
+    node->callback  = in_callback;
+    node->user_data = in_user_data;
+  }
+
+  return( node );
+}
+
+CPC_BOOL
+cahal_graph_connect (
+                     cahal_graph*      io_graph,
+                     cahal_graph_node* in_source,
+                     cahal_graph_node* io_destination,
+                     UINT32            in_port
+                     )
+{
+  if  (
+       NULL == io_graph
+       || NULL == in_source
+       || NULL == io_destination
+       || in_source < io_graph->nodes
+       || in_source >= io_graph->nodes + io_graph->number_of_nodes
+       || io_destination < io_graph->nodes
+       || io_destination >= io_graph->nodes + io_graph->number_of_nodes
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Nodes do not belong to graph." );
+
+    return( CPC_FALSE );
+  }
+
+  if  (
+       in_source == io_destination
+       || CAHAL_GRAPH_NODE_OUTPUT == in_source->node_type
+       || io_destination->number_of_inputs <= in_port
+       || NULL != io_destination->inputs[ in_port ]
+       || in_source->number_of_channels != io_destination->input_channels
+       )
+  {
+    CPC_ERROR (
+               "Could not connect nodes: port=%d, channels=%d->%d.",
+               in_port,
+               in_source->number_of_channels,
+               io_destination->input_channels
+               );
+
+    return( CPC_FALSE );
+  }
+
+  io_destination->inputs[ in_port ] = in_source;
+
+  in_source->number_of_outputs++;
+
+  io_graph->prepared = CPC_FALSE;
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_graph_prepare (
+                     cahal_graph*  io_graph,
+                     UINT32        in_maximum_frames
+                     )
+{
+  cahal_graph_node* input   = NULL;
+  cahal_graph_node* output  = NULL;
+
+  if( NULL == io_graph || 0 == in_maximum_frames )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid graph parameters." );
+
+    return( CPC_FALSE );
+  }
+
+  input   = io_graph->input;
+  output  = io_graph->output;
+
+  io_graph->prepared = CPC_FALSE;
+
+  cahal_graph_free_buffers( io_graph );
+
+  if( NULL == input || NULL == output )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Graph needs an input and output." );
+
+    return( CPC_FALSE );
+  }
+
+  for( UINT32 i = 0; i < io_graph->number_of_nodes; i++ )
+  {
+    cahal_graph_node* node = &( io_graph->nodes[ i ] );
+
+    for( UINT32 port = 0; port < node->number_of_inputs; port++ )
+    {
+      if( NULL == node->inputs[ port ] )
+      {
+        CPC_ERROR( "Port %d of node %d is not connected.", port, i );
+
+        return( CPC_FALSE );
+      }
+    }
+  }
+
+  if( ! cahal_graph_sort( io_graph ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Graph has a cycle." );
+
+    return( CPC_FALSE );
+  }
+
+  io_graph->maximum_frames = in_maximum_frames;
+
+  for( UINT32 i = 0; i < io_graph->number_of_nodes; i++ )
+  {
+    if( ! cahal_graph_resolve_node( io_graph, io_graph->order[ i ] ) )
+    {
+      cahal_graph_free_buffers( io_graph );
+
+      return( CPC_FALSE );
+    }
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &( io_graph->input_scratch ),
+                            in_maximum_frames * input->number_of_channels
+                            * cahal_get_bytes_per_sample( input->bit_depth )
+                            )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( io_graph->output_scratch ),
+                               output->buffer_capacity
+                               * output->number_of_channels
+                               * cahal_get_bytes_per_sample( output->bit_depth )
+                               )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc graph buffers." );
+
+    cahal_graph_free_buffers( io_graph );
+
+    return( CPC_FALSE );
+  }
+
+  io_graph->prepared = CPC_TRUE;
+
+  return( CPC_TRUE );
+}
+
+UINT32
+cahal_graph_process (
+                     cahal_graph*   io_graph,
+                     const FLOAT32* in_frames,
+                     UINT32         in_number_of_frames,
+                     FLOAT32*       out_frames
+                     )
+{
+  cahal_graph_node* output = NULL;
+
+  if  (
+       NULL == io_graph
+       || NULL == in_frames
+       || NULL == out_frames
+       || ! io_graph->prepared
+       || io_graph->maximum_frames < in_number_of_frames
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Graph is not ready to process." );
+
+    return( 0 );
+  }
+
+  output = io_graph->output;
+
+  memcpy  (
+           io_graph->input->buffer,
+           in_frames,
+           in_number_of_frames * io_graph->input->number_of_channels
+           * sizeof( FLOAT32 )
+           );
+
+  io_graph->input->number_of_frames = in_number_of_frames;
+
+  if( ! cahal_graph_run( io_graph ) )
+  {
+    return( 0 );
+  }
+
+  memcpy  (
+           out_frames,
+           output->buffer,
+           output->number_of_frames * output->number_of_channels
+           * sizeof( FLOAT32 )
+           );
+
+  return( output->number_of_frames );
+}
+
+void
+cahal_graph_set_recorder_callback (
+                                   cahal_graph*            io_graph,
+                                   cahal_recorder_callback in_callback,
+                                   void*                   in_user_data
+                                   )
+{
+  if( NULL != io_graph )
+  {
+    io_graph->recorder_callback = in_callback;
+    io_graph->user_data         = in_user_data;
+  }
+}
+
+void
+cahal_graph_set_playback_callback (
+                                   cahal_graph*            io_graph,
+                                   cahal_playback_callback in_callback,
+                                   void*                   in_user_data
+                                   )
+{
+  if( NULL != io_graph )
+  {
+    io_graph->playback_callback = in_callback;
+    io_graph->user_data         = in_user_data;
+  }
+}
+
+CPC_BOOL
+cahal_graph_recorder_callback (
+                               cahal_device* in_recording_device,
+                               UCHAR*        in_data_buffer,
+                               UINT32        in_data_buffer_length,
+                               void*         in_client_data
+                               )
+{
+  cahal_graph* graph        = ( cahal_graph* ) in_client_data;
+  CPC_BOOL return_value     = CPC_TRUE;
+  cahal_graph_node* input   = NULL;
+  cahal_graph_node* output  = NULL;
+  UINT32 input_frame_size   = 0;
+  UINT32 output_frame_size  = 0;
+  UINT32 number_of_frames   = 0;
+
+  if  (
+       NULL == graph
+       || NULL == in_data_buffer
+       || ! graph->prepared
+       || NULL == graph->recorder_callback
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Graph is not ready to record." );
+
+    return( CPC_FALSE );
+  }
+
+  input             = graph->input;
+  output            = graph->output;
+  input_frame_size  =
+    cahal_get_bytes_per_sample( input->bit_depth ) * input->number_of_channels;
+  output_frame_size =
+    cahal_get_bytes_per_sample( output->bit_depth )
+    * output->number_of_channels;
+  number_of_frames  = in_data_buffer_length / input_frame_size;
+
+  while( 0 < number_of_frames && return_value )
+  {
+    UINT32 chunk = number_of_frames;
+
+    if( graph->maximum_frames < chunk )
+    {
+      chunk = graph->maximum_frames;
+    }
+
+    cahal_convert_to_float32  (
+                               in_data_buffer,
+                               chunk * input->number_of_channels,
+                               input->bit_depth,
+                               input->format_flags,
+                               input->buffer
+                               );
+
+    input->number_of_frames = chunk;
+
+    return_value = cahal_graph_run( graph );
+
+    if( return_value && 0 < output->number_of_frames )
+    {
+      cahal_convert_from_float32  (
+                                   output->buffer,
+                                   output->number_of_frames
+                                   * output->number_of_channels,
+                                   output->bit_depth,
+                                   output->format_flags,
+                                   graph->output_scratch
+                                   );
+
+      return_value =
+        graph->recorder_callback  (
+                                   in_recording_device,
+                                   graph->output_scratch,
+                                   output->number_of_frames * output_frame_size,
+                                   graph->user_data
+                                   );
+    }
+
+    in_data_buffer    += chunk * input_frame_size;
+    number_of_frames  -= chunk;
+  }
+
+  return( return_value );
+}
+
+CPC_BOOL
+cahal_graph_playback_callback (
+                               cahal_device* in_playback_device,
+                               UCHAR*        out_data_buffer,
+                               UINT32*       io_data_buffer_length,
+                               void*         in_client_data
+                               )
+{
+  cahal_graph* graph        = ( cahal_graph* ) in_client_data;
+  cahal_graph_node* input   = NULL;
+  cahal_graph_node* output  = NULL;
+  UINT32 input_frame_size   = 0;
+  UINT32 output_frame_size  = 0;
+  UINT32 number_of_frames   = 0;
+  UINT32 frames_written     = 0;
+
+  if  (
+       NULL == graph
+       || NULL == out_data_buffer
+       || NULL == io_data_buffer_length
+       || ! graph->prepared
+       || NULL == graph->playback_callback
+       || graph->input->sample_rate != graph->output->sample_rate
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Graph is not ready for playback." );
+
+    return( CPC_FALSE );
+  }
+
+  input             = graph->input;
+  output            = graph->output;
+  input_frame_size  =
+    cahal_get_bytes_per_sample( input->bit_depth ) * input->number_of_channels;
+  output_frame_size =
+    cahal_get_bytes_per_sample( output->bit_depth )
+    * output->number_of_channels;
+  number_of_frames  = *io_data_buffer_length / output_frame_size;
+
+  while( frames_written < number_of_frames )
+  {
+    UINT32 chunk    = number_of_frames - frames_written;
+    UINT32 length   = 0;
+    UINT32 produced = 0;
+
+    if( graph->maximum_frames < chunk )
+    {
+      chunk = graph->maximum_frames;
+    }
+
+    length = chunk * input_frame_size;
+
+    if  (
+         ! graph->playback_callback (
+                                     in_playback_device,
+                                     graph->input_scratch,
+                                     &length,
+                                     graph->user_data
+                                     )
+         || 0 == length / input_frame_size
+         )
+    {
+      break;
+    }
+
+    input->number_of_frames = length / input_frame_size;
+
+    cahal_convert_to_float32  (
+                               graph->input_scratch,
+                               input->number_of_frames
+                               * input->number_of_channels,
+                               input->bit_depth,
+                               input->format_flags,
+                               input->buffer
+                               );
+
+    if( ! cahal_graph_run( graph ) )
+    {
+      break;
+    }
+
+    produced = output->number_of_frames;
+
+    if( number_of_frames - frames_written < produced )
+    {
+      produced = number_of_frames - frames_written;
+    }
+
+    cahal_convert_from_float32  (
+                                 output->buffer,
+                                 produced * output->number_of_channels,
+                                 output->bit_depth,
+                                 output->format_flags,
+                                 out_data_buffer
+                                 + frames_written * output_frame_size
+                                 );
+
+    frames_written += produced;
+
+    if( input->number_of_frames < chunk )
+    {
+      break;
+    }
+  }
+
+  *io_data_buffer_length = frames_written * output_frame_size;
+
+  return( 0 < frames_written );
+}
+
+void
+cahal_graph_node_set_gain (
+                           cahal_graph_node* io_node,
+                           UINT32            in_channel,
+                           FLOAT32           in_gain
+                           )
+{
+  if  (
+       NULL != io_node
+       && CAHAL_GRAPH_NODE_GAIN == io_node->node_type
+       && io_node->number_of_channels > in_channel
+       )
+  {
+    io_node->parameters[ in_channel ] = in_gain;
+  }
+}
+
+void
+cahal_graph_node_set_remix_gain (
+                                 cahal_graph_node* io_node,
+                                 UINT32            in_output_channel,
+                                 UINT32            in_input_channel,
+                                 FLOAT32           in_gain
+                                 )
+{
+  if  (
+       NULL != io_node
+       && CAHAL_GRAPH_NODE_REMIX == io_node->node_type
+       && io_node->number_of_channels > in_output_channel
+       && io_node->input_channels > in_input_channel
+       )
+  {
+    io_node->parameters[ in_output_channel * io_node->input_channels
+                         + in_input_channel ] = in_gain;
+  }
+}
+
+FLOAT32
+cahal_graph_node_get_peak  (
+                            cahal_graph_node* in_node,
+                            UINT32            in_channel
+                            )
+{
+  if  (
+       NULL == in_node
+       || CAHAL_GRAPH_NODE_METER != in_node->node_type
+       || in_node->number_of_channels <= in_channel
+       )
+  {
+    return( 0.0f );
+  }
+
+  return( in_node->state[ 2 * in_channel ] );
+}
+
+FLOAT32
+cahal_graph_node_get_rms (
+                          cahal_graph_node* in_node,
+                          UINT32            in_channel
+                          )
+{
+  if  (
+       NULL == in_node
+       || CAHAL_GRAPH_NODE_METER != in_node->node_type
+       || in_node->number_of_channels <= in_channel
+       )
+  {
+    return( 0.0f );
+  }
+
+  return( in_node->state[ 2 * in_channel + 1 ] );
+}
+
+static
+cahal_graph_node*
+cahal_graph_add_node (
+                      cahal_graph*          io_graph,
+                      cahal_graph_node_type in_node_type,
+                      UINT32                in_number_of_channels,
+                      UINT32                in_input_channels,
+                      UINT32                in_number_of_inputs
+                      )
+{
+  cahal_graph_node* node = NULL;
+
+  if  (
+       NULL == io_graph
+       || io_graph->maximum_number_of_nodes <= io_graph->number_of_nodes
+       || 0 == in_number_of_channels
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not add node to graph." );
+
+    return( NULL );
+  }
+
+  node = &( io_graph->nodes[ io_graph->number_of_nodes ] );
+
+  memset( node, 0, sizeof( cahal_graph_node ) );
+
+  node->node_type           = in_node_type;
+  node->number_of_channels  = in_number_of_channels;
+  node->input_channels      = in_input_channels;
+  node->number_of_inputs    = in_number_of_inputs;
+
+  io_graph->number_of_nodes++;
+  io_graph->prepared = CPC_FALSE;
+
+  return( node );
+}
+
+static
+CPC_BOOL
+cahal_graph_allocate  (
+                       FLOAT32** out_buffer,
+                       UINT32    in_number_of_samples
+                       )
+{
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) out_buffer,
+                            in_number_of_samples * sizeof( FLOAT32 )
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc graph buffer." );
+
+    return( CPC_FALSE );
+  }
+
+  return( CPC_TRUE );
+}
+
+static
+CPC_BOOL
+cahal_graph_sort  (
+                   cahal_graph* io_graph
+                   )
+{
+  UINT32 number_of_nodes  = io_graph->number_of_nodes;
+  UINT32 head             = 0;
+  UINT32 tail             = 0;
+  UINT32* pending         = NULL;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &pending,
+                            number_of_nodes * sizeof( UINT32 )
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc sort buffer." );
+
+    return( CPC_FALSE );
+  }
+
+  //  Kahn's algorithm: order is used as the queue of nodes whose inputs have
+  //  all been placed.
+  for( UINT32 i = 0; i < number_of_nodes; i++ )
+  {
+    pending[ i ] = io_graph->nodes[ i ].number_of_inputs;
+
+    if( 0 == pending[ i ] )
+    {
+      io_graph->order[ tail++ ] = &( io_graph->nodes[ i ] );
+    }
+  }
+
+  while( head < tail )
+  {
+    cahal_graph_node* node = io_graph->order[ head++ ];
+
+    for( UINT32 i = 0; i < number_of_nodes; i++ )
+    {
+      cahal_graph_node* consumer = &( io_graph->nodes[ i ] );
+
+      for( UINT32 port = 0; port < consumer->number_of_inputs; port++ )
+      {
+        if( node == consumer->inputs[ port ] && 0 == --pending[ i ] )
+        {
+          io_graph->order[ tail++ ] = consumer;
+        }
+      }
+    }
+  }
+
+  cpc_safe_free( ( void** ) &pending );
+
+  return( tail == number_of_nodes );
+}
+
+static
+CPC_BOOL
+cahal_graph_resolve_node  (
+                           cahal_graph*      io_graph,
+                           cahal_graph_node* io_node
+                           )
+{
+  cahal_graph_node* source  = io_node->inputs[ 0 ];
+  UINT32 capacity           = 0;
+
+  io_node->owns_buffer      = CPC_TRUE;
+  io_node->number_of_frames = 0;
+  io_node->position         = 1.0;
+
+  if( CAHAL_GRAPH_NODE_INPUT == io_node->node_type )
+  {
+    capacity = io_graph->maximum_frames;
+  }
+  else if( CAHAL_GRAPH_NODE_RESAMPLE == io_node->node_type )
+  {
+    capacity  =
+      ( UINT32 ) ceil (
+                       source->buffer_capacity
+                       * io_node->sample_rate / source->sample_rate
+                       ) + 2;
+
+    memset  (
+             io_node->state,
+             0,
+             io_node->number_of_channels * sizeof( FLOAT32 )
+             );
+  }
+  else
+  {
+    if  (
+         CAHAL_GRAPH_NODE_OUTPUT == io_node->node_type
+         && io_node->sample_rate != source->sample_rate
+         )
+    {
+      CPC_ERROR (
+                 "Output rate %.2f does not match graph rate %.2f.",
+                 io_node->sample_rate,
+                 source->sample_rate
+                 );
+
+      return( CPC_FALSE );
+    }
+
+    io_node->sample_rate  = source->sample_rate;
+    capacity              = source->buffer_capacity;
+
+    for( UINT32 port = 1; port < io_node->number_of_inputs; port++ )
+    {
+      if( io_node->inputs[ port ]->sample_rate != io_node->sample_rate )
+      {
+        CPC_LOG_STRING  (
+                         CPC_LOG_LEVEL_ERROR,
+                         "Mixed inputs have different sample rates."
+                         );
+
+        return( CPC_FALSE );
+      }
+
+      if( io_node->inputs[ port ]->buffer_capacity > capacity )
+      {
+        capacity = io_node->inputs[ port ]->buffer_capacity;
+      }
+    }
+
+    if  (
+         CAHAL_GRAPH_NODE_FILTER == io_node->node_type
+         && ! cahal_filter_bank_set_sample_rate (
+                                                 io_node->filter_bank,
+                                                 io_node->sample_rate
+                                                 )
+         )
+    {
+      return( CPC_FALSE );
+    }
+
+    if( NULL != io_node->state )
+    {
+      memset  (
+               io_node->state,
+               0,
+               2 * io_node->number_of_channels * sizeof( FLOAT32 )
+               );
+    }
+
+    //  In-place nodes that are the only consumer of their source work on the
+    //  buffer of the source directly.
+    if  (
+         CAHAL_GRAPH_IS_IN_PLACE( io_node->node_type )
+         && 1 == source->number_of_outputs
+         )
+    {
+      io_node->buffer           = source->buffer;
+      io_node->buffer_capacity  = source->buffer_capacity;
+      io_node->owns_buffer      = CPC_FALSE;
+
+      return( CPC_TRUE );
+    }
+  }
+
+  io_node->buffer_capacity = capacity;
+
+  return  (
+           cahal_graph_allocate (
+                                 &( io_node->buffer ),
+                                 capacity * io_node->number_of_channels
+                                 )
+           );
+}
+
+static
+CPC_BOOL
+cahal_graph_run  (
+                  cahal_graph* io_graph
+                  )
+{
+  //  order[ 0 ] is always the input node, which has been filled by the
+  //  caller.
+  for( UINT32 i = 1; i < io_graph->number_of_nodes; i++ )
+  {
+    if( ! cahal_graph_run_node( io_graph->order[ i ] ) )
+    {
+      return( CPC_FALSE );
+    }
+  }
+
+  return( CPC_TRUE );
+}
+
+static
+CPC_BOOL
+cahal_graph_run_node  (
+                       cahal_graph_node* io_node
+                       )
+{
+  cahal_graph_node* source  = io_node->inputs[ 0 ];
+  UINT32 channels           = io_node->number_of_channels;
+  UINT32 frames             = source->number_of_frames;
+  FLOAT32* buffer           = io_node->buffer;
+
+  if  (
+       CAHAL_GRAPH_IS_IN_PLACE( io_node->node_type )
+       && io_node->owns_buffer
+       )
+  {
+    memcpy( buffer, source->buffer, frames * channels * sizeof( FLOAT32 ) );
+  }
+
+  switch( io_node->node_type )
+  {
+    case CAHAL_GRAPH_NODE_GAIN:
+      for( UINT32 frame = 0; frame < frames; frame++ )
+      {
+        for( UINT32 channel = 0; channel < channels; channel++ )
+        {
+          buffer[ frame * channels + channel ] *=
+            io_node->parameters[ channel ];
+        }
+      }
+      break;
+
+    case CAHAL_GRAPH_NODE_REMIX:
+      {
+        UINT32 inputs = io_node->input_channels;
+
+        for( UINT32 frame = 0; frame < frames; frame++ )
+        {
+          const FLOAT32* in = source->buffer + frame * inputs;
+
+          for( UINT32 channel = 0; channel < channels; channel++ )
+          {
+            const FLOAT32* row  = io_node->parameters + channel * inputs;
+            FLOAT32 sum         = 0.0f;
+
+            for( UINT32 input = 0; input < inputs; input++ )
+            {
+              sum += row[ input ] * in[ input ];
+            }
+
+            buffer[ frame * channels + channel ] = sum;
+          }
+        }
+      }
+      break;
+
+    case CAHAL_GRAPH_NODE_MIX:
+      for( UINT32 port = 1; port < io_node->number_of_inputs; port++ )
+      {
+        if( io_node->inputs[ port ]->number_of_frames < frames )
+        {
+          frames = io_node->inputs[ port ]->number_of_frames;
+        }
+      }
+
+      memcpy( buffer, source->buffer, frames * channels * sizeof( FLOAT32 ) );
+
+      for( UINT32 port = 1; port < io_node->number_of_inputs; port++ )
+      {
+        const FLOAT32* in = io_node->inputs[ port ]->buffer;
+
+        for( UINT32 i = 0; i < frames * channels; i++ )
+        {
+          buffer[ i ] += in[ i ];
+        }
+      }
+      break;
+
+    case CAHAL_GRAPH_NODE_RESAMPLE:
+      {
+        //  position is measured in input frames from the last frame of the
+        //  previous call, which is kept in state.
+        FLOAT64 step      = source->sample_rate / io_node->sample_rate;
+        FLOAT64 position  = io_node->position;
+        UINT32 produced   = 0;
+
+        while( position < frames && produced < io_node->buffer_capacity )
+        {
+          UINT32 index      = ( UINT32 ) position;
+          FLOAT32 fraction  = ( FLOAT32 ) ( position - index );
+          const FLOAT32* a  =
+            ( 0 == index )
+            ? io_node->state : source->buffer + ( index - 1 ) * channels;
+          const FLOAT32* b  = source->buffer + index * channels;
+
+          for( UINT32 channel = 0; channel < channels; channel++ )
+          {
+            buffer[ produced * channels + channel ] =
+              a[ channel ] + fraction * ( b[ channel ] - a[ channel ] );
+          }
+
+          produced++;
+          position += step;
+        }
+
+        if( 0 < frames )
+        {
+          memcpy  (
+                   io_node->state,
+                   source->buffer + ( frames - 1 ) * channels,
+                   channels * sizeof( FLOAT32 )
+                   );
+
+          io_node->position = position - frames;
+        }
+
+        frames = produced;
+      }
+      break;
+
+    case CAHAL_GRAPH_NODE_FILTER:
+      cahal_filter_bank_process( io_node->filter_bank, buffer, frames );
+      break;
+
+    case CAHAL_GRAPH_NODE_METER:
+      for( UINT32 channel = 0; channel < channels && 0 < frames; channel++ )
+      {
+        FLOAT32 peak  = 0.0f;
+        FLOAT32 power = 0.0f;
+
+        for( UINT32 frame = 0; frame < frames; frame++ )
+        {
+          FLOAT32 sample = buffer[ frame * channels + channel ];
+
+          if( fabsf( sample ) > peak )
+          {
+            peak = fabsf( sample );
+          }
+
+          power += sample * sample;
+        }
+
+        io_node->state[ 2 * channel ]     = peak;
+        io_node->state[ 2 * channel + 1 ] = sqrtf( power / frames );
+      }
+      break;
+
+    case CAHAL_GRAPH_NODE_USER:
+      if  (
+           ! io_node->callback  (
+                                 buffer,
+                                 frames,
+                                 channels,
+                                 io_node->user_data
+                                 )
+           )
+      {
+        return( CPC_FALSE );
+      }
+      break;
+
+    case CAHAL_GRAPH_NODE_OUTPUT:
+    default:
+      break;
+  }
+
+  io_node->number_of_frames = frames;
+
+  return( CPC_TRUE );
+}
+
+static
+void
+cahal_graph_free_buffers  (
+                           cahal_graph* io_graph
+                           )
+{
+  if( NULL != io_graph->nodes )
+  {
+    for( UINT32 i = 0; i < io_graph->number_of_nodes; i++ )
+    {
+      if( io_graph->nodes[ i ].owns_buffer )
+      {
+        cpc_safe_free( ( void** ) &( io_graph->nodes[ i ].buffer ) );
+      }
+
+      io_graph->nodes[ i ].buffer           = NULL;
+      io_graph->nodes[ i ].buffer_capacity  = 0;
+      io_graph->nodes[ i ].owns_buffer      = CPC_FALSE;
+    }
+  }
+
+  cpc_safe_free( ( void** ) &( io_graph->input_scratch ) );
+  cpc_safe_free( ( void** ) &( io_graph->output_scratch ) );
+}
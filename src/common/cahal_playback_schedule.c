@@ -0,0 +1,247 @@
+/*! \file   cahal_playback_schedule.c
+
+    \author Brent Carrara
+ */
+#include "cahal_playback_schedule.h"
+
+#include "cahal.h"
+#include "cahal_audio_convert.h"
+
+#include <math.h>
+
+/*! \var    g_playback_start_time
+    \brief  The start time set using cahal_set_playback_start_time.
+ */
+static cahal_start_time g_playback_start_time;
+
+/*! \var    g_is_scheduling
+    \brief  True iff new playbacks are scheduled.
+ */
+static CPC_BOOL g_is_scheduling = CPC_FALSE;
+
+/*! \fn     FLOAT64 cahal_playback_schedule_get_offset (
+              cahal_playback_schedule* in_schedule,
+              UINT32                   in_queued_bytes
+            )
+    \brief  Returns the number of frames between the first frame of the next
+            buffer and the start of the playback, converting a host start
+            time using the current time and the latency of the OS.
+
+    \param  in_schedule The schedule of the playback.
+    \param  in_queued_bytes The number of bytes queued in the OS that will be
+                            played before the next buffer.
+    \return The number of frames, rounded to the nearest one. Negative if the
+            start time has passed.
+ */
+static
+FLOAT64
+cahal_playback_schedule_get_offset (
+                                    cahal_playback_schedule* in_schedule,
+                                    UINT32                   in_queued_bytes
+                                    );
+
+void
+cahal_set_playback_start_time (
+                               const cahal_start_time* in_start_time
+                               )
+{
+  if( NULL == in_start_time )
+  {
+    g_is_scheduling = CPC_FALSE;
+  }
+  else
+  {
+    g_playback_start_time = *in_start_time;
+    g_is_scheduling       = CPC_TRUE;
+  }
+}
+
+CPC_BOOL
+cahal_get_playback_start_time (
+                               cahal_start_time* out_start_time
+                               )
+{
+  if( g_is_scheduling && NULL != out_start_time )
+  {
+    *out_start_time = g_playback_start_time;
+  }
+
+  return( g_is_scheduling );
+}
+
+cahal_playback_schedule*
+cahal_playback_schedule_create  (
+                                 const cahal_start_time*   in_start_time,
+                                 cahal_playback_info*      in_playback_info
+                                 )
+{
+  cahal_playback_schedule* schedule = NULL;
+
+  if  (
+       NULL == in_start_time
+       || NULL == in_playback_info
+       || 0.0 >= in_playback_info->sample_rate
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid schedule parameters." );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &schedule,
+                            sizeof( cahal_playback_schedule )
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not allocate schedule." );
+
+    return( NULL );
+  }
+
+  schedule->start_time  = *in_start_time;
+  schedule->sample_rate = in_playback_info->sample_rate;
+  schedule->frame_size  =
+    cahal_get_bytes_per_sample( in_playback_info->bit_depth )
+    * in_playback_info->number_of_channels;
+
+  if( 0 == schedule->frame_size )
+  {
+    schedule->frame_size = 1;
+  }
+
+  CPC_LOG (
+           CPC_LOG_LEVEL_DEBUG,
+           "Scheduling playback at %s time %.0f.",
+           ( CAHAL_START_TIME_BASE_HOST == in_start_time->base )
+           ? "host" : "sample",
+           ( FLOAT64 ) in_start_time->time
+           );
+
+  return( schedule );
+}
+
+void
+cahal_playback_schedule_free  (
+                               cahal_playback_schedule* in_schedule
+                               )
+{
+  if( NULL != in_schedule )
+  {
+    cpc_safe_free( ( void** ) &in_schedule );
+  }
+}
+
+UINT32
+cahal_playback_schedule_get_silence (
+                              cahal_playback_schedule* io_schedule,
+                              UINT32                   in_data_buffer_length,
+                              UINT32                   in_queued_bytes
+                                     )
+{
+  UINT32 number_of_frames = in_data_buffer_length / io_schedule->frame_size;
+  FLOAT64 offset          = 0;
+
+  if( io_schedule->has_started )
+  {
+    return( 0 );
+  }
+
+  offset = cahal_playback_schedule_get_offset( io_schedule, in_queued_bytes );
+
+  if( number_of_frames <= offset )
+  {
+    return( number_of_frames * io_schedule->frame_size );
+  }
+
+  if( 0 > offset )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_WARN,
+             "Scheduled playback started %.0f frames late.",
+             -offset
+             );
+
+    offset = 0;
+  }
+
+  io_schedule->has_started        = CPC_TRUE;
+  io_schedule->start_sample_time  =
+    io_schedule->sample_time + ( UINT64 ) offset;
+
+  return( ( UINT32 ) offset * io_schedule->frame_size );
+}
+
+void
+cahal_playback_schedule_advance (
+                                 cahal_playback_schedule* io_schedule,
+                                 UINT32                   in_data_buffer_length
+                                 )
+{
+  io_schedule->sample_time += in_data_buffer_length / io_schedule->frame_size;
+}
+
+CPC_BOOL
+cahal_attach_playback_schedule (
+                                cahal_playback_info* io_playback_info
+                                )
+{
+  cahal_start_time start_time;
+
+  if( ! cahal_get_playback_start_time( &start_time ) )
+  {
+    return( CPC_TRUE );
+  }
+
+  io_playback_info->schedule =
+    cahal_playback_schedule_create( &start_time, io_playback_info );
+
+  return( NULL != io_playback_info->schedule );
+}
+
+void
+cahal_detach_playback_schedule (
+                                cahal_playback_info* io_playback_info
+                                )
+{
+  if( NULL != io_playback_info->schedule )
+  {
+    cahal_playback_schedule_free( io_playback_info->schedule );
+
+    io_playback_info->schedule = NULL;
+  }
+}
+
+static
+FLOAT64
+cahal_playback_schedule_get_offset (
+                                    cahal_playback_schedule* in_schedule,
+                                    UINT32                   in_queued_bytes
+                                    )
+{
+  FLOAT64 play_time = 0;
+
+  if( CAHAL_START_TIME_BASE_HOST != in_schedule->start_time.base )
+  {
+    return  (
+             ( FLOAT64 ) in_schedule->start_time.time
+             - ( FLOAT64 ) in_schedule->sample_time
+             );
+  }
+
+  //  The time the first frame of the next buffer is played
+  play_time =
+    ( FLOAT64 ) cahal_get_time()
+    + ( in_queued_bytes / in_schedule->frame_size )
+      * 1000000000.0 / in_schedule->sample_rate;
+
+  return  (
+           floor  (
+                   ( ( FLOAT64 ) in_schedule->start_time.time - play_time )
+                   * in_schedule->sample_rate / 1000000000.0
+                   + 0.5
+                   )
+           );
+}
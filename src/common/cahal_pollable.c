@@ -0,0 +1,701 @@
+/*! \file   cahal_pollable.c
+
+    \author Brent Carrara
+ */
+#include "cahal_pollable.h"
+
+#include "cahal_audio_convert.h"
+
+#if ! defined( _WIN32 )
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined( __linux__ )
+#include <sys/eventfd.h>
+#endif
+
+/*! \fn     CPC_BOOL cahal_pollable_open_descriptors  (
+              cahal_pollable_stream* io_stream
+            )
+    \brief  Opens the eventfd, or the pipe, of a stream. Both ends are
+            non-blocking.
+
+    \param  io_stream The stream. Its descriptors are set.
+    \return True iff the descriptors were opened.
+ */
+static
+CPC_BOOL
+cahal_pollable_open_descriptors  (
+                                  cahal_pollable_stream* io_stream
+                                  );
+
+/*! \fn     CPC_BOOL cahal_pollable_is_ready (
+              cahal_pollable_stream* in_stream
+            )
+    \brief  Tests whether at least threshold bytes can be read (recording) or
+            written (playback).
+
+    \param  in_stream The stream.
+    \return True iff the descriptor should be readable.
+ */
+static
+CPC_BOOL
+cahal_pollable_is_ready (
+                         cahal_pollable_stream* in_stream
+                         );
+
+/*! \fn     void cahal_pollable_signal  (
+              cahal_pollable_stream* io_stream
+            )
+    \brief  Makes the descriptor readable, unless it already is. Never blocks,
+            so it may be called on the OS thread.
+
+    \param  io_stream The stream.
+ */
+static
+void
+cahal_pollable_signal  (
+                        cahal_pollable_stream* io_stream
+                        );
+
+/*! \fn     CPC_BOOL cahal_pollable_post  (
+              cahal_pollable_stream* io_stream
+            )
+    \brief  Writes to the eventfd, or the pipe, making the descriptor
+            readable.
+
+    \param  io_stream The stream.
+    \return True iff the descriptor was written.
+ */
+static
+CPC_BOOL
+cahal_pollable_post  (
+                      cahal_pollable_stream* io_stream
+                      );
+
+/*! \fn     CPC_BOOL cahal_pollable_drain (
+              cahal_pollable_stream* io_stream
+            )
+    \brief  Reads what cahal_pollable_post wrote, so the descriptor is no
+            longer readable.
+
+    \param  io_stream The stream.
+    \return True iff the descriptor was read.
+ */
+static
+CPC_BOOL
+cahal_pollable_drain (
+                      cahal_pollable_stream* io_stream
+                      );
+
+/*! \fn     UINT32 cahal_pollable_get_capacity (
+              FLOAT64 in_sample_rate,
+              UINT32  in_frame_size,
+              UINT32  in_threshold
+            )
+    \brief  Returns the number of bytes the ring of a stream holds:
+            CAHAL_POLLABLE_BUFFER_DURATION of audio, or twice the threshold if
+            that is more.
+
+    \param  in_sample_rate  The sample rate of the stream.
+    \param  in_frame_size The number of bytes in a frame.
+    \param  in_threshold  The threshold of the stream, in frames.
+    \return The capacity of the ring in bytes.
+ */
+static
+UINT32
+cahal_pollable_get_capacity (
+                             FLOAT64 in_sample_rate,
+                             UINT32  in_frame_size,
+                             UINT32  in_threshold
+                             );
+
+/*! \fn     void cahal_pollable_update  (
+              cahal_pollable_stream* io_stream
+            )
+    \brief  Called by the event loop once it has read or written: clears the
+            descriptor if the stream is no longer ready and signals it again
+            if the OS thread made it ready meanwhile.
+
+    \param  io_stream The stream.
+ */
+static
+void
+cahal_pollable_update  (
+                        cahal_pollable_stream* io_stream
+                        );
+
+cahal_pollable_stream*
+cahal_pollable_stream_create (
+                              cahal_device_stream_direction in_direction,
+                              UINT32                        in_frame_size,
+                              UINT32                        in_threshold,
+                              UINT32                        in_capacity
+                              )
+{
+  cahal_pollable_stream* stream = NULL;
+
+  if( 0 == in_frame_size || 0 == in_threshold )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid pollable parameters." );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc (
+                           ( void** ) &stream,
+                           sizeof( cahal_pollable_stream )
+                           )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not allocate stream." );
+
+    return( NULL );
+  }
+
+  stream->direction         = in_direction;
+  stream->frame_size        = in_frame_size;
+  stream->threshold         = in_threshold * in_frame_size;
+  stream->read_descriptor   = CAHAL_POLLABLE_INVALID_DESCRIPTOR;
+  stream->write_descriptor  = CAHAL_POLLABLE_INVALID_DESCRIPTOR;
+
+  if( in_capacity < stream->threshold )
+  {
+    in_capacity = stream->threshold;
+  }
+
+  stream->ring_buffer = cahal_ring_buffer_create( in_capacity );
+
+  if  (
+       NULL == stream->ring_buffer
+       || ! cahal_pollable_open_descriptors( stream )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not create pollable stream." );
+
+    cahal_pollable_stream_free( stream );
+
+    return( NULL );
+  }
+
+  //  An empty playback is ready to be written to
+  if( cahal_pollable_is_ready( stream ) )
+  {
+    cahal_pollable_signal( stream );
+  }
+
+  return( stream );
+}
+
+void
+cahal_pollable_stream_free (
+                            cahal_pollable_stream* in_stream
+                            )
+{
+  if( NULL != in_stream )
+  {
+#if ! defined( _WIN32 )
+    if( CAHAL_POLLABLE_INVALID_DESCRIPTOR != in_stream->read_descriptor )
+    {
+      close( in_stream->read_descriptor );
+    }
+
+    if  (
+         CAHAL_POLLABLE_INVALID_DESCRIPTOR != in_stream->write_descriptor
+         && in_stream->write_descriptor != in_stream->read_descriptor
+         )
+    {
+      close( in_stream->write_descriptor );
+    }
+#endif
+
+    if( NULL != in_stream->ring_buffer )
+    {
+      cahal_ring_buffer_free( in_stream->ring_buffer );
+    }
+
+    cpc_safe_free( ( void** ) &in_stream );
+  }
+}
+
+cahal_pollable_stream*
+cahal_start_recording_pollable  (
+                                 cahal_device*            in_device,
+                                 cahal_audio_format_id    in_format_id,
+                                 UINT32                   in_number_of_channels,
+                                 FLOAT64                  in_sample_rate,
+                                 UINT32                   in_bit_depth,
+                                 cahal_audio_format_flag  in_format_flags,
+                                 UINT32                   in_threshold
+                                 )
+{
+  cahal_pollable_stream* stream = NULL;
+  UINT32 frame_size             =
+    cahal_get_bytes_per_sample( in_bit_depth ) * in_number_of_channels;
+  UINT32 capacity               =
+    cahal_pollable_get_capacity( in_sample_rate, frame_size, in_threshold );
+
+  stream =
+    cahal_pollable_stream_create  (
+                                   CAHAL_DEVICE_INPUT_STREAM,
+                                   frame_size,
+                                   in_threshold,
+                                   capacity
+                                   );
+
+  if  (
+       NULL != stream
+       && ! cahal_start_recording (
+                                   in_device,
+                                   in_format_id,
+                                   in_number_of_channels,
+                                   in_sample_rate,
+                                   in_bit_depth,
+                                   cahal_pollable_recorder_callback,
+                                   stream,
+                                   in_format_flags
+                                   )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not start recording." );
+
+    //  A failed start may still hold callback info that points to stream
+    if  (
+         NULL != g_recorder_callback_info
+         && stream == g_recorder_callback_info->user_data
+         )
+    {
+      cahal_stop_recording();
+    }
+
+    cahal_pollable_stream_free( stream );
+
+    stream = NULL;
+  }
+
+  return( stream );
+}
+
+cahal_pollable_stream*
+cahal_create_playback_pollable  (
+                                 UINT32                   in_number_of_channels,
+                                 FLOAT64                  in_sample_rate,
+                                 UINT32                   in_bit_depth,
+                                 UINT32                   in_threshold
+                                 )
+{
+  UINT32 frame_size =
+    cahal_get_bytes_per_sample( in_bit_depth ) * in_number_of_channels;
+  UINT32 capacity   =
+    cahal_pollable_get_capacity( in_sample_rate, frame_size, in_threshold );
+
+  return  (
+           cahal_pollable_stream_create  (
+                                          CAHAL_DEVICE_OUTPUT_STREAM,
+                                          frame_size,
+                                          in_threshold,
+                                          capacity
+                                          )
+           );
+}
+
+CPC_BOOL
+cahal_start_playback_pollable (
+                               cahal_pollable_stream*   io_stream,
+                               cahal_device*            in_device,
+                               cahal_audio_format_id    in_format_id,
+                               UINT32                   in_number_of_channels,
+                               FLOAT64                  in_sample_rate,
+                               UINT32                   in_bit_depth,
+                               FLOAT32                  in_volume,
+                               cahal_audio_format_flag  in_format_flags
+                               )
+{
+  if  (
+       NULL == io_stream
+       || CAHAL_DEVICE_OUTPUT_STREAM != io_stream->direction
+       || io_stream->frame_size
+          != cahal_get_bytes_per_sample( in_bit_depth ) * in_number_of_channels
+       )
+  {
+    CPC_LOG_STRING  (
+                     CPC_LOG_LEVEL_ERROR,
+                     "Stream was not created for this playback."
+                     );
+
+    return( CPC_FALSE );
+  }
+
+  //  The first buffers are filled from the ring as the playback starts, so
+  //  the event loop is expected to have written to it already
+  if  (
+       ! cahal_start_playback  (
+                                in_device,
+                                in_format_id,
+                                in_number_of_channels,
+                                in_sample_rate,
+                                in_bit_depth,
+                                in_volume,
+                                cahal_pollable_playback_callback,
+                                io_stream,
+                                in_format_flags
+                                )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not start playback." );
+
+    if  (
+         NULL != g_playback_callback_info
+         && io_stream == g_playback_callback_info->user_data
+         )
+    {
+      cahal_stop_playback();
+    }
+
+    return( CPC_FALSE );
+  }
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_stop_pollable  (
+                      cahal_pollable_stream* in_stream
+                      )
+{
+  CPC_BOOL return_value = CPC_FALSE;
+
+  if( NULL == in_stream )
+  {
+    return( CPC_FALSE );
+  }
+
+  //  Stopping waits for the callbacks that use the stream to return
+  if( CAHAL_DEVICE_INPUT_STREAM == in_stream->direction )
+  {
+    return_value = cahal_stop_recording();
+  }
+  else
+  {
+    return_value = cahal_stop_playback();
+  }
+
+  cahal_pollable_stream_free( in_stream );
+
+  return( return_value );
+}
+
+INT32
+cahal_pollable_get_descriptor  (
+                                cahal_pollable_stream* in_stream
+                                )
+{
+  return( in_stream->read_descriptor );
+}
+
+UINT32
+cahal_pollable_read (
+                     cahal_pollable_stream* io_stream,
+                     UCHAR*                 out_data_buffer,
+                     UINT32                 in_data_buffer_length
+                     )
+{
+  UINT32 length = cahal_ring_buffer_get_fill( io_stream->ring_buffer );
+
+  if( in_data_buffer_length < length )
+  {
+    length = in_data_buffer_length;
+  }
+
+  length -= length % io_stream->frame_size;
+  length  =
+    cahal_ring_buffer_read( io_stream->ring_buffer, out_data_buffer, length );
+
+  cahal_pollable_update( io_stream );
+
+  return( length );
+}
+
+UINT32
+cahal_pollable_write  (
+                       cahal_pollable_stream* io_stream,
+                       const UCHAR*           in_data_buffer,
+                       UINT32                 in_data_buffer_length
+                       )
+{
+  UINT32 length = cahal_ring_buffer_get_space( io_stream->ring_buffer );
+
+  if( in_data_buffer_length < length )
+  {
+    length = in_data_buffer_length;
+  }
+
+  length -= length % io_stream->frame_size;
+  length  =
+    cahal_ring_buffer_write( io_stream->ring_buffer, in_data_buffer, length );
+
+  cahal_pollable_update( io_stream );
+
+  return( length );
+}
+
+CPC_BOOL
+cahal_pollable_recorder_callback (
+                                  cahal_device* in_recording_device,
+                                  UCHAR*        in_data_buffer,
+                                  UINT32        in_data_buffer_length,
+                                  void*         in_user_data
+                                  )
+{
+  cahal_pollable_stream* stream = ( cahal_pollable_stream* ) in_user_data;
+
+  //  A partial buffer would leave a partial frame in the ring
+  if  (
+       in_data_buffer_length
+       > cahal_ring_buffer_get_space( stream->ring_buffer )
+       )
+  {
+    CAHAL_ATOMIC_ADD( &( stream->number_of_overruns ), 1 );
+  }
+  else
+  {
+    cahal_ring_buffer_write  (
+                              stream->ring_buffer,
+                              in_data_buffer,
+                              in_data_buffer_length
+                              );
+  }
+
+  if( cahal_pollable_is_ready( stream ) )
+  {
+    cahal_pollable_signal( stream );
+  }
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_pollable_playback_callback (
+                                  cahal_device* in_playback_device,
+                                  UCHAR*        out_data_buffer,
+                                  UINT32*       io_data_buffer_length,
+                                  void*         in_user_data
+                                  )
+{
+  cahal_pollable_stream* stream = ( cahal_pollable_stream* ) in_user_data;
+  UINT32 capacity               = *io_data_buffer_length;
+  UINT32 length                 = 0;
+
+  capacity -= capacity % stream->frame_size;
+  length    =
+    cahal_ring_buffer_read( stream->ring_buffer, out_data_buffer, capacity );
+
+  if( length < capacity )
+  {
+    CPC_MEMSET( out_data_buffer + length, 0, capacity - length );
+
+    CAHAL_ATOMIC_ADD( &( stream->number_of_underruns ), 1 );
+  }
+
+  *io_data_buffer_length = capacity;
+
+  if( cahal_pollable_is_ready( stream ) )
+  {
+    cahal_pollable_signal( stream );
+  }
+
+  return( CPC_TRUE );
+}
+
+static
+UINT32
+cahal_pollable_get_capacity (
+                             FLOAT64 in_sample_rate,
+                             UINT32  in_frame_size,
+                             UINT32  in_threshold
+                             )
+{
+  UINT32 capacity =
+    ( UINT32 ) ( in_sample_rate * CAHAL_POLLABLE_BUFFER_DURATION )
+    * in_frame_size;
+
+  if( 2 * in_threshold * in_frame_size > capacity )
+  {
+    capacity = 2 * in_threshold * in_frame_size;
+  }
+
+  return( capacity );
+}
+
+static
+CPC_BOOL
+cahal_pollable_open_descriptors  (
+                                  cahal_pollable_stream* io_stream
+                                  )
+{
+#if defined( _WIN32 )
+  CPC_LOG_STRING  (
+                   CPC_LOG_LEVEL_ERROR,
+                   "Pollable streams are not supported on Windows."
+                   );
+
+  return( CPC_FALSE );
+#elif defined( __linux__ )
+  io_stream->read_descriptor = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+
+  if( CAHAL_POLLABLE_INVALID_DESCRIPTOR == io_stream->read_descriptor )
+  {
+    CPC_ERROR( "Could not create eventfd: %d.", errno );
+
+    return( CPC_FALSE );
+  }
+
+  io_stream->write_descriptor = io_stream->read_descriptor;
+
+  return( CPC_TRUE );
+#else
+  int descriptors[ 2 ];
+
+  if( 0 != pipe( descriptors ) )
+  {
+    CPC_ERROR( "Could not create pipe: %d.", errno );
+
+    return( CPC_FALSE );
+  }
+
+  io_stream->read_descriptor  = descriptors[ 0 ];
+  io_stream->write_descriptor = descriptors[ 1 ];
+
+  for( UINT32 i = 0; i < 2; i++ )
+  {
+    if  (
+         -1 == fcntl (
+                      descriptors[ i ],
+                      F_SETFL,
+                      fcntl( descriptors[ i ], F_GETFL ) | O_NONBLOCK
+                      )
+         || -1 == fcntl( descriptors[ i ], F_SETFD, FD_CLOEXEC )
+         )
+    {
+      CPC_ERROR( "Could not configure pipe: %d.", errno );
+
+      return( CPC_FALSE );
+    }
+  }
+
+  return( CPC_TRUE );
+#endif
+}
+
+static
+CPC_BOOL
+cahal_pollable_is_ready (
+                         cahal_pollable_stream* in_stream
+                         )
+{
+  if( CAHAL_DEVICE_INPUT_STREAM == in_stream->direction )
+  {
+    return  (
+             cahal_ring_buffer_get_fill( in_stream->ring_buffer )
+             >= in_stream->threshold
+             );
+  }
+  else
+  {
+    return  (
+             cahal_ring_buffer_get_space( in_stream->ring_buffer )
+             >= in_stream->threshold
+             );
+  }
+}
+
+static
+void
+cahal_pollable_signal  (
+                        cahal_pollable_stream* io_stream
+                        )
+{
+  if  (
+       CAHAL_ATOMIC_COMPARE_AND_SWAP( &( io_stream->is_signalled ), 0, 1 )
+       && ! cahal_pollable_post( io_stream )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_WARN, "Could not signal descriptor." );
+  }
+}
+
+static
+void
+cahal_pollable_update  (
+                        cahal_pollable_stream* io_stream
+                        )
+{
+  if  (
+       ! cahal_pollable_is_ready( io_stream )
+       && CAHAL_ATOMIC_LOAD( &( io_stream->is_signalled ) )
+       )
+  {
+    //  The OS thread does not signal while is_signalled is set, so the
+    //  descriptor is drained before it is cleared, never after.
+    if( ! cahal_pollable_drain( io_stream ) )
+    {
+      CPC_LOG_STRING( CPC_LOG_LEVEL_WARN, "Could not clear descriptor." );
+    }
+
+    CAHAL_ATOMIC_STORE( &( io_stream->is_signalled ), 0 );
+
+    //  The OS thread may have made the stream ready after it was tested
+    if( cahal_pollable_is_ready( io_stream ) )
+    {
+      cahal_pollable_signal( io_stream );
+    }
+  }
+}
+
+static
+CPC_BOOL
+cahal_pollable_post  (
+                      cahal_pollable_stream* io_stream
+                      )
+{
+#if defined( _WIN32 )
+  return( CPC_FALSE );
+#elif defined( __linux__ )
+  UINT64 value = 1;
+
+  return  (
+           sizeof( value )
+           == write( io_stream->write_descriptor, &value, sizeof( value ) )
+           );
+#else
+  UCHAR value = 1;
+
+  return( 1 == write( io_stream->write_descriptor, &value, 1 ) );
+#endif
+}
+
+static
+CPC_BOOL
+cahal_pollable_drain (
+                      cahal_pollable_stream* io_stream
+                      )
+{
+#if defined( _WIN32 )
+  return( CPC_FALSE );
+#elif defined( __linux__ )
+  UINT64 value = 0;
+
+  return  (
+           sizeof( value )
+           == read( io_stream->read_descriptor, &value, sizeof( value ) )
+           );
+#else
+  UCHAR value = 0;
+
+  return( 1 == read( io_stream->read_descriptor, &value, 1 ) );
+#endif
+}
@@ -0,0 +1,341 @@
+/*! \file   cahal_probe.c
+
+    \author Brent Carrara
+ */
+#include "cahal_probe.h"
+
+cahal_prober*
+cahal_prober_create (
+                     cahal_probe_callback  in_callback,
+                     void*                 in_user_data,
+                     cahal_audio_format_id in_format_id
+                     )
+{
+  cahal_prober* prober = NULL;
+
+  if( NULL == in_callback )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null probe callback." );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &prober, sizeof( cahal_prober ) )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc prober." );
+
+    return( NULL );
+  }
+
+  prober->test_configuration  = in_callback;
+  prober->user_data           = in_user_data;
+  prober->format_id           = in_format_id;
+
+  return( prober );
+}
+
+void
+cahal_prober_free  (
+                    cahal_prober* in_prober
+                    )
+{
+  if( NULL != in_prober )
+  {
+    cpc_safe_free( ( void** ) &in_prober );
+  }
+}
+
+CPC_BOOL
+cahal_prober_add_channels (
+                           cahal_prober* io_prober,
+                           UINT32        in_number_of_channels
+                           )
+{
+  if  (
+       NULL == io_prober
+       || CAHAL_PROBER_MAXIMUM_VALUES <= io_prober->number_of_channel_counts
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not add channel count." );
+
+    return( CPC_FALSE );
+  }
+
+  io_prober->channels[ io_prober->number_of_channel_counts++ ] =
+    in_number_of_channels;
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_prober_add_sample_rate  (
+                               cahal_prober* io_prober,
+                               FLOAT64       in_sample_rate
+                               )
+{
+  if  (
+       NULL == io_prober
+       || CAHAL_PROBER_MAXIMUM_VALUES <= io_prober->number_of_sample_rates
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not add sample rate." );
+
+    return( CPC_FALSE );
+  }
+
+  io_prober->sample_rates[ io_prober->number_of_sample_rates++ ] =
+    in_sample_rate;
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_prober_add_bit_depth  (
+                             cahal_prober* io_prober,
+                             UINT32        in_bit_depth
+                             )
+{
+  if  (
+       NULL == io_prober
+       || CAHAL_PROBER_MAXIMUM_VALUES <= io_prober->number_of_bit_depths
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not add bit depth." );
+
+    return( CPC_FALSE );
+  }
+
+  io_prober->bit_depths[ io_prober->number_of_bit_depths++ ] = in_bit_depth;
+
+  return( CPC_TRUE );
+}
+
+UINT32
+cahal_prober_get_number_of_configurations (
+                                           cahal_prober* in_prober
+                                           )
+{
+  if( NULL == in_prober )
+  {
+    return( 0 );
+  }
+
+  return  (
+           in_prober->number_of_channel_counts
+           * in_prober->number_of_sample_rates
+           * in_prober->number_of_bit_depths
+           );
+}
+
+CPC_BOOL
+cahal_prober_test (
+                   cahal_prober* io_prober,
+                   UINT32        in_configuration,
+                   UINT32        in_index
+                   )
+{
+  UINT32 bit_depth_index  = 0;
+  UINT32 rate_index       = 0;
+  UINT32 channel_index    = 0;
+  CPC_BOOL supported      = CPC_FALSE;
+
+  if  (
+       in_index
+       >= cahal_prober_get_number_of_configurations( io_prober )
+       )
+  {
+    CPC_LOG( CPC_LOG_LEVEL_ERROR, "Invalid configuration %d.", in_index );
+
+    return( CPC_FALSE );
+  }
+
+  bit_depth_index = in_index % io_prober->number_of_bit_depths;
+  rate_index      =
+    ( in_index / io_prober->number_of_bit_depths )
+    % io_prober->number_of_sample_rates;
+  channel_index   =
+    in_index
+    / ( io_prober->number_of_bit_depths * io_prober->number_of_sample_rates );
+
+  CAHAL_ATOMIC_ADD( &( io_prober->number_of_probes ), 1 );
+
+  supported =
+    io_prober->test_configuration (
+                                   in_configuration,
+                                   io_prober->channels[ channel_index ],
+                                   io_prober->sample_rates[ rate_index ],
+                                   io_prober->bit_depths[ bit_depth_index ],
+                                   io_prober->user_data
+                                   );
+
+  if( supported )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_DEBUG,
+             "Supported nc=%d, sr=%.2f, bps=%d, c=%d",
+             io_prober->channels[ channel_index ],
+             io_prober->sample_rates[ rate_index ],
+             io_prober->bit_depths[ bit_depth_index ],
+             in_configuration
+             );
+  }
+
+  return( supported );
+}
+
+cahal_audio_format_description*
+cahal_prober_create_format (
+                            cahal_prober* in_prober,
+                            UINT32        in_index
+                            )
+{
+  cahal_audio_format_description* format  = NULL;
+  UINT32 bit_depth_index                  = 0;
+  UINT32 rate_index                       = 0;
+  UINT32 channel_index                    = 0;
+
+  if  (
+       in_index
+       >= cahal_prober_get_number_of_configurations( in_prober )
+       )
+  {
+    CPC_LOG( CPC_LOG_LEVEL_ERROR, "Invalid configuration %d.", in_index );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &format,
+                            sizeof( cahal_audio_format_description )
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc format." );
+
+    return( NULL );
+  }
+
+  bit_depth_index = in_index % in_prober->number_of_bit_depths;
+  rate_index      =
+    ( in_index / in_prober->number_of_bit_depths )
+    % in_prober->number_of_sample_rates;
+  channel_index   =
+    in_index
+    / ( in_prober->number_of_bit_depths * in_prober->number_of_sample_rates );
+
+  format->format_id                       = in_prober->format_id;
+  format->number_of_channels              =
+    in_prober->channels[ channel_index ];
+  format->bit_depth                       =
+    in_prober->bit_depths[ bit_depth_index ];
+  format->sample_rate_range.minimum_rate  =
+    in_prober->sample_rates[ rate_index ];
+  format->sample_rate_range.maximum_rate  =
+    in_prober->sample_rates[ rate_index ];
+
+  cahal_get_default_channel_layout  (
+                                     format->number_of_channels,
+                                     &( format->channel_layout )
+                                     );
+
+  return( format );
+}
+
+cahal_audio_format_description**
+cahal_prober_probe  (
+                     cahal_prober* io_prober,
+                     UINT32        in_configuration
+                     )
+{
+  cahal_audio_format_description** formats = NULL;
+  UINT32 number_of_formats                 = 0;
+  UINT32 number_of_configurations          =
+    cahal_prober_get_number_of_configurations( io_prober );
+
+  if( NULL == io_prober )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null prober." );
+
+    return( NULL );
+  }
+
+  //  Room for every combination plus the terminator, so that the list never
+  //  has to be grown while probing.
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &formats,
+                            ( number_of_configurations + 1 )
+                            * sizeof( cahal_audio_format_description* )
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc format list." );
+
+    return( NULL );
+  }
+
+  for( UINT32 i = 0; i < number_of_configurations; i++ )
+  {
+    if( cahal_prober_test( io_prober, in_configuration, i ) )
+    {
+      formats[ number_of_formats ] = cahal_prober_create_format( io_prober, i );
+
+      if( NULL == formats[ number_of_formats++ ] )
+      {
+        cahal_free_audio_format_description_list( formats );
+
+        return( NULL );
+      }
+    }
+  }
+
+  return( formats );
+}
+
+cahal_audio_format_description**
+cahal_prober_probe_cached (
+                           cahal_prober*       io_prober,
+                           UINT32              in_configuration,
+                           cahal_probe_cache*  io_cache,
+                           const CHAR*         in_device_key,
+                           UINT64              in_fingerprint
+                           )
+{
+  cahal_audio_format_description** formats =
+    cahal_probe_cache_lookup( io_cache, in_device_key, in_fingerprint );
+
+  if( NULL != formats )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_DEBUG,
+             "Using cached formats of %s.",
+             in_device_key
+             );
+
+    return( formats );
+  }
+
+  formats = cahal_prober_probe( io_prober, in_configuration );
+
+  if  (
+       NULL != formats
+       && NULL != io_cache
+       && ! cahal_probe_cache_store  (
+                                      io_cache,
+                                      in_device_key,
+                                      in_fingerprint,
+                                      formats
+                                      )
+       )
+  {
+    CPC_ERROR( "Could not cache formats of %s.", in_device_key );
+  }
+
+  return( formats );
+}
@@ -0,0 +1,706 @@
+/*! \file   cahal_probe_cache.c
+
+    \author Brent Carrara
+ */
+#include <stdio.h>
+
+#include "cahal_probe_cache.h"
+
+/*! \def    CAHAL_PROBE_CACHE_FNV_OFFSET
+    \brief  The offset basis of the 64-bit FNV-1a hash.
+ */
+#define CAHAL_PROBE_CACHE_FNV_OFFSET  0xcbf29ce484222325ULL
+
+/*! \def    CAHAL_PROBE_CACHE_FNV_PRIME
+    \brief  The prime of the 64-bit FNV-1a hash.
+ */
+#define CAHAL_PROBE_CACHE_FNV_PRIME   0x00000100000001b3ULL
+
+CHAR* g_probe_cache_path = NULL;
+
+/*! \fn     UINT64 cahal_probe_cache_hash (
+              UINT64      in_hash,
+              const CHAR* in_string
+            )
+    \brief  Adds in_string, followed by a separator, to in_hash.
+
+    \param  in_hash The hash so far.
+    \param  in_string The string to add. NULL is hashed as an empty string.
+    \return The updated hash.
+ */
+static
+UINT64
+cahal_probe_cache_hash (
+                        UINT64      in_hash,
+                        const CHAR* in_string
+                        );
+
+/*! \fn     CHAR* cahal_probe_cache_copy_string  (
+              const CHAR* in_string
+            )
+    \brief  Returns a newly allocated copy of in_string.
+
+    \param  in_string The string to copy.
+    \return The copy or NULL on error.
+ */
+static
+CHAR*
+cahal_probe_cache_copy_string  (
+                                const CHAR* in_string
+                                );
+
+/*! \fn     cahal_probe_cache_entry* cahal_probe_cache_find  (
+              cahal_probe_cache*  in_cache,
+              const CHAR*         in_device_key
+            )
+    \brief  Returns the entry stored under in_device_key.
+
+    \param  in_cache  The cache to search.
+    \param  in_device_key The key of the device.
+    \return The entry or NULL if there is none.
+ */
+static
+cahal_probe_cache_entry*
+cahal_probe_cache_find  (
+                         cahal_probe_cache*  in_cache,
+                         const CHAR*         in_device_key
+                         );
+
+/*! \fn     void cahal_probe_cache_remove  (
+              cahal_probe_cache*        io_cache,
+              cahal_probe_cache_entry*  in_entry
+            )
+    \brief  Frees in_entry and removes it from io_cache.
+
+    \param  io_cache  The cache to update.
+    \param  in_entry  The entry to remove.
+ */
+static
+void
+cahal_probe_cache_remove  (
+                           cahal_probe_cache*        io_cache,
+                           cahal_probe_cache_entry*  in_entry
+                           );
+
+/*! \fn     CPC_BOOL cahal_probe_cache_read_entries  (
+              cahal_probe_cache*  io_cache,
+              FILE*               in_file
+            )
+    \brief  Reads the entries of a cache file whose header has been read.
+
+    \param  io_cache  The cache to add the entries to.
+    \param  in_file The cache file.
+    \return True iff the whole file was read and is valid.
+ */
+static
+CPC_BOOL
+cahal_probe_cache_read_entries  (
+                                 cahal_probe_cache*  io_cache,
+                                 FILE*               in_file
+                                 );
+
+UINT64
+cahal_probe_cache_fingerprint  (
+                                const CHAR* in_name,
+                                const CHAR* in_uid,
+                                const CHAR* in_model,
+                                const CHAR* in_os_build
+                                )
+{
+  UINT64 hash = CAHAL_PROBE_CACHE_FNV_OFFSET;
+
+  hash = cahal_probe_cache_hash( hash, in_name );
+  hash = cahal_probe_cache_hash( hash, in_uid );
+  hash = cahal_probe_cache_hash( hash, in_model );
+  hash = cahal_probe_cache_hash( hash, in_os_build );
+
+  return( hash );
+}
+
+cahal_probe_cache*
+cahal_probe_cache_create( void )
+{
+  cahal_probe_cache* cache = NULL;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &cache, sizeof( cahal_probe_cache ) )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc probe cache." );
+  }
+
+  return( cache );
+}
+
+cahal_probe_cache*
+cahal_probe_cache_load  (
+                         const CHAR* in_path
+                         )
+{
+  cahal_probe_cache* cache  = cahal_probe_cache_create();
+  FILE* file                = NULL;
+  UINT32 header[ 2 ]        = { 0, 0 };
+
+  if( NULL == cache || NULL == in_path )
+  {
+    return( cache );
+  }
+
+  file = fopen( in_path, "rb" );
+
+  if( NULL == file )
+  {
+    CPC_LOG( CPC_LOG_LEVEL_DEBUG, "No probe cache at %s.", in_path );
+
+    return( cache );
+  }
+
+  if  (
+       2 != fread( header, sizeof( UINT32 ), 2, file )
+       || CAHAL_PROBE_CACHE_MAGIC != header[ 0 ]
+       || CAHAL_PROBE_CACHE_VERSION != header[ 1 ]
+       )
+  {
+    CPC_LOG( CPC_LOG_LEVEL_INFO, "Ignoring incompatible cache %s.", in_path );
+  }
+  else if( ! cahal_probe_cache_read_entries( cache, file ) )
+  {
+    CPC_LOG( CPC_LOG_LEVEL_WARN, "Ignoring corrupt cache %s.", in_path );
+
+    while( 0 < cache->number_of_entries )
+    {
+      cahal_probe_cache_remove( cache, &( cache->entries[ 0 ] ) );
+    }
+  }
+
+  fclose( file );
+
+  cache->modified = CPC_FALSE;
+
+  CPC_LOG (
+           CPC_LOG_LEVEL_DEBUG,
+           "Loaded %d devices from %s.",
+           cache->number_of_entries,
+           in_path
+           );
+
+  return( cache );
+}
+
+CPC_BOOL
+cahal_probe_cache_save  (
+                         cahal_probe_cache*  io_cache,
+                         const CHAR*         in_path
+                         )
+{
+  CPC_BOOL return_value = CPC_TRUE;
+  CHAR* temporary_path  = NULL;
+  FILE* file            = NULL;
+  UINT32 header[ 3 ]    =
+  {
+    CAHAL_PROBE_CACHE_MAGIC,
+    CAHAL_PROBE_CACHE_VERSION,
+    0
+  };
+
+  if( NULL == io_cache || NULL == in_path )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null cache or path." );
+
+    return( CPC_FALSE );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &temporary_path,
+                            strlen( in_path ) + 5
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc cache path." );
+
+    return( CPC_FALSE );
+  }
+
+  memcpy( temporary_path, in_path, strlen( in_path ) );
+  memcpy( temporary_path + strlen( in_path ), ".tmp", 4 );
+
+  file = fopen( temporary_path, "wb" );
+
+  if( NULL == file )
+  {
+    CPC_ERROR( "Could not open %s for writing.", temporary_path );
+
+    cpc_safe_free( ( void** ) &temporary_path );
+
+    return( CPC_FALSE );
+  }
+
+  header[ 2 ] = io_cache->number_of_entries;
+
+  return_value = ( 3 == fwrite( header, sizeof( UINT32 ), 3, file ) );
+
+  for (
+       UINT32 i = 0;
+       i < io_cache->number_of_entries && return_value;
+       i++
+       )
+  {
+    cahal_probe_cache_entry* entry  = &( io_cache->entries[ i ] );
+    UINT32 key_length               = ( UINT32 ) strlen( entry->device_key );
+
+    return_value =
+      1 == fwrite( &key_length, sizeof( UINT32 ), 1, file )
+      && key_length == fwrite( entry->device_key, 1, key_length, file )
+      && 1 == fwrite( &( entry->fingerprint ), sizeof( UINT64 ), 1, file )
+      && 1 == fwrite  (
+                       &( entry->number_of_formats ),
+                       sizeof( UINT32 ),
+                       1,
+                       file
+                       );
+
+    for( UINT32 j = 0; j < entry->number_of_formats && return_value; j++ )
+    {
+      cahal_audio_format_description* format = &( entry->formats[ j ] );
+
+      return_value =
+        1 == fwrite( &( format->format_id ), sizeof( UINT32 ), 1, file )
+        && 1 == fwrite  (
+                         &( format->number_of_channels ),
+                         sizeof( UINT32 ),
+                         1,
+                         file
+                         )
+        && 1 == fwrite( &( format->bit_depth ), sizeof( UINT32 ), 1, file )
+        && 1 == fwrite  (
+                         &( format->sample_rate_range.minimum_rate ),
+                         sizeof( FLOAT64 ),
+                         1,
+                         file
+                         )
+        && 1 == fwrite  (
+                         &( format->sample_rate_range.maximum_rate ),
+                         sizeof( FLOAT64 ),
+                         1,
+                         file
+                         );
+    }
+  }
+
+  if( 0 != fclose( file ) )
+  {
+    return_value = CPC_FALSE;
+  }
+
+  if( return_value )
+  {
+#ifdef _WIN32
+    remove( in_path );
+#endif
+
+    return_value = ( 0 == rename( temporary_path, in_path ) );
+  }
+
+  if( return_value )
+  {
+    io_cache->modified = CPC_FALSE;
+  }
+  else
+  {
+    CPC_ERROR( "Could not write probe cache %s.", in_path );
+
+    remove( temporary_path );
+  }
+
+  cpc_safe_free( ( void** ) &temporary_path );
+
+  return( return_value );
+}
+
+void
+cahal_probe_cache_free  (
+                         cahal_probe_cache* in_cache
+                         )
+{
+  if( NULL != in_cache )
+  {
+    while( 0 < in_cache->number_of_entries )
+    {
+      cahal_probe_cache_remove( in_cache, &( in_cache->entries[ 0 ] ) );
+    }
+
+    cpc_safe_free( ( void** ) &( in_cache->entries ) );
+
+    cpc_safe_free( ( void** ) &in_cache );
+  }
+}
+
+cahal_audio_format_description**
+cahal_probe_cache_lookup (
+                          cahal_probe_cache*  io_cache,
+                          const CHAR*         in_device_key,
+                          UINT64              in_fingerprint
+                          )
+{
+  cahal_audio_format_description** formats = NULL;
+  cahal_probe_cache_entry* entry           =
+    cahal_probe_cache_find( io_cache, in_device_key );
+
+  if( NULL == entry )
+  {
+    if( NULL != io_cache )
+    {
+      io_cache->number_of_misses++;
+    }
+
+    return( NULL );
+  }
+
+  if( in_fingerprint != entry->fingerprint )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_INFO,
+             "Fingerprint of %s changed, invalidating cached formats.",
+             in_device_key
+             );
+
+    cahal_probe_cache_remove( io_cache, entry );
+
+    io_cache->modified = CPC_TRUE;
+    io_cache->number_of_misses++;
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &formats,
+                            ( entry->number_of_formats + 1 )
+                            * sizeof( cahal_audio_format_description* )
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc format list." );
+
+    return( NULL );
+  }
+
+  for( UINT32 i = 0; i < entry->number_of_formats; i++ )
+  {
+    if  (
+         CPC_ERROR_CODE_NO_ERROR
+         != cpc_safe_malloc  (
+                              ( void** ) &( formats[ i ] ),
+                              sizeof( cahal_audio_format_description )
+                              )
+         )
+    {
+      CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc format." );
+
+      cahal_free_audio_format_description_list( formats );
+
+      return( NULL );
+    }
+
+    *( formats[ i ] ) = entry->formats[ i ];
+  }
+
+  io_cache->number_of_hits++;
+
+  return( formats );
+}
+
+CPC_BOOL
+cahal_probe_cache_store  (
+                          cahal_probe_cache*                io_cache,
+                          const CHAR*                       in_device_key,
+                          UINT64                            in_fingerprint,
+                          cahal_audio_format_description**  in_formats
+                          )
+{
+  cahal_probe_cache_entry entry;
+  cahal_probe_cache_entry* existing = NULL;
+
+  if( NULL == io_cache || NULL == in_device_key || NULL == in_formats )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid probe cache parameters." );
+
+    return( CPC_FALSE );
+  }
+
+  memset( &entry, 0, sizeof( cahal_probe_cache_entry ) );
+
+  while( NULL != in_formats[ entry.number_of_formats ] )
+  {
+    entry.number_of_formats++;
+  }
+
+  entry.fingerprint = in_fingerprint;
+  entry.device_key  = cahal_probe_cache_copy_string( in_device_key );
+
+  if  (
+       NULL == entry.device_key
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( entry.formats ),
+                               ( entry.number_of_formats + 1 )
+                               * sizeof( cahal_audio_format_description )
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_realloc  (
+                                ( void** ) &( io_cache->entries ),
+                                io_cache->number_of_entries
+                                * sizeof( cahal_probe_cache_entry ),
+                                ( io_cache->number_of_entries + 1 )
+                                * sizeof( cahal_probe_cache_entry )
+                                )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc cache entry." );
+
+    cpc_safe_free( ( void** ) &( entry.device_key ) );
+    cpc_safe_free( ( void** ) &( entry.formats ) );
+
+    return( CPC_FALSE );
+  }
+
+  for( UINT32 i = 0; i < entry.number_of_formats; i++ )
+  {
+    entry.formats[ i ] = *( in_formats[ i ] );
+  }
+
+  existing = cahal_probe_cache_find( io_cache, in_device_key );
+
+  if( NULL != existing )
+  {
+    cahal_probe_cache_remove( io_cache, existing );
+  }
+
+  io_cache->entries[ io_cache->number_of_entries++ ] = entry;
+  io_cache->modified                                  = CPC_TRUE;
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_set_probe_cache_path  (
+                             const CHAR* in_path
+                             )
+{
+  CHAR* path = NULL;
+
+  if( NULL != in_path )
+  {
+    path = cahal_probe_cache_copy_string( in_path );
+
+    if( NULL == path )
+    {
+      return( CPC_FALSE );
+    }
+  }
+
+  cpc_safe_free( ( void** ) &g_probe_cache_path );
+
+  g_probe_cache_path = path;
+
+  return( CPC_TRUE );
+}
+
+static
+UINT64
+cahal_probe_cache_hash (
+                        UINT64      in_hash,
+                        const CHAR* in_string
+                        )
+{
+  if( NULL != in_string )
+  {
+    for( const CHAR* c = in_string; '\0' != *c; c++ )
+    {
+      in_hash ^= ( UCHAR ) *c;
+      in_hash *= CAHAL_PROBE_CACHE_FNV_PRIME;
+    }
+  }
+
+  //  Separator so that ( "ab", "c" ) and ( "a", "bc" ) differ.
+  in_hash ^= 0xff;
+  in_hash *= CAHAL_PROBE_CACHE_FNV_PRIME;
+
+  return( in_hash );
+}
+
+static
+CHAR*
+cahal_probe_cache_copy_string  (
+                                const CHAR* in_string
+                                )
+{
+  CHAR* copy    = NULL;
+  SIZE length   = strlen( in_string );
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &copy, length + 1 )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc string." );
+
+    return( NULL );
+  }
+
+  memcpy( copy, in_string, length );
+
+  return( copy );
+}
+
+static
+cahal_probe_cache_entry*
+cahal_probe_cache_find  (
+                         cahal_probe_cache*  in_cache,
+                         const CHAR*         in_device_key
+                         )
+{
+  if( NULL != in_cache && NULL != in_device_key )
+  {
+    for( UINT32 i = 0; i < in_cache->number_of_entries; i++ )
+    {
+      if( 0 == strcmp( in_cache->entries[ i ].device_key, in_device_key ) )
+      {
+        return( &( in_cache->entries[ i ] ) );
+      }
+    }
+  }
+
+  return( NULL );
+}
+
+static
+void
+cahal_probe_cache_remove  (
+                           cahal_probe_cache*        io_cache,
+                           cahal_probe_cache_entry*  in_entry
+                           )
+{
+  UINT32 index = ( UINT32 ) ( in_entry - io_cache->entries );
+
+  cpc_safe_free( ( void** ) &( in_entry->device_key ) );
+  cpc_safe_free( ( void** ) &( in_entry->formats ) );
+
+  memmove (
+           in_entry,
+           in_entry + 1,
+           ( io_cache->number_of_entries - index - 1 )
+           * sizeof( cahal_probe_cache_entry )
+           );
+
+  io_cache->number_of_entries--;
+}
+
+static
+CPC_BOOL
+cahal_probe_cache_read_entries  (
+                                 cahal_probe_cache*  io_cache,
+                                 FILE*               in_file
+                                 )
+{
+  UINT32 number_of_entries = 0;
+
+  if( 1 != fread( &number_of_entries, sizeof( UINT32 ), 1, in_file ) )
+  {
+    return( CPC_FALSE );
+  }
+
+  for( UINT32 i = 0; i < number_of_entries; i++ )
+  {
+    cahal_probe_cache_entry entry;
+    CPC_BOOL valid    = CPC_FALSE;
+    UINT32 key_length = 0;
+
+    memset( &entry, 0, sizeof( cahal_probe_cache_entry ) );
+
+    if  (
+         1 == fread( &key_length, sizeof( UINT32 ), 1, in_file )
+         && 0 < key_length
+         && CAHAL_PROBE_CACHE_MAXIMUM_KEY_LENGTH >= key_length
+         && CPC_ERROR_CODE_NO_ERROR
+            == cpc_safe_malloc  (
+                                 ( void** ) &( entry.device_key ),
+                                 key_length + 1
+                                 )
+         && key_length == fread( entry.device_key, 1, key_length, in_file )
+         && 1 == fread( &( entry.fingerprint ), sizeof( UINT64 ), 1, in_file )
+         && 1 == fread  (
+                         &( entry.number_of_formats ),
+                         sizeof( UINT32 ),
+                         1,
+                         in_file
+                         )
+         && CAHAL_PROBE_CACHE_MAXIMUM_FORMATS >= entry.number_of_formats
+         && CPC_ERROR_CODE_NO_ERROR
+            == cpc_safe_malloc  (
+                                 ( void** ) &( entry.formats ),
+                                 ( entry.number_of_formats + 1 )
+                                 * sizeof( cahal_audio_format_description )
+                                 )
+         && CPC_ERROR_CODE_NO_ERROR
+            == cpc_safe_realloc  (
+                                  ( void** ) &( io_cache->entries ),
+                                  io_cache->number_of_entries
+                                  * sizeof( cahal_probe_cache_entry ),
+                                  ( io_cache->number_of_entries + 1 )
+                                  * sizeof( cahal_probe_cache_entry )
+                                  )
+         )
+    {
+      valid = CPC_TRUE;
+
+      for( UINT32 j = 0; j < entry.number_of_formats && valid; j++ )
+      {
+        cahal_audio_format_description* format = &( entry.formats[ j ] );
+
+        valid =
+          1 == fread( &( format->format_id ), sizeof( UINT32 ), 1, in_file )
+          && 1 == fread (
+                         &( format->number_of_channels ),
+                         sizeof( UINT32 ),
+                         1,
+                         in_file
+                         )
+          && 1 == fread( &( format->bit_depth ), sizeof( UINT32 ), 1, in_file )
+          && 1 == fread (
+                         &( format->sample_rate_range.minimum_rate ),
+                         sizeof( FLOAT64 ),
+                         1,
+                         in_file
+                         )
+          && 1 == fread (
+                         &( format->sample_rate_range.maximum_rate ),
+                         sizeof( FLOAT64 ),
+                         1,
+                         in_file
+                         )
+          && cahal_get_default_channel_layout  (
+                                                format->number_of_channels,
+                                                &( format->channel_layout )
+                                                );
+      }
+    }
+
+    if( ! valid )
+    {
+      cpc_safe_free( ( void** ) &( entry.device_key ) );
+      cpc_safe_free( ( void** ) &( entry.formats ) );
+
+      return( CPC_FALSE );
+    }
+
+    io_cache->entries[ io_cache->number_of_entries++ ] = entry;
+  }
+
+  //  Trailing bytes mean the file was not written by this version.
+  return( EOF == fgetc( in_file ) );
+}
@@ -0,0 +1,732 @@
+/*! \file   cahal_probe_scheduler.c
+
+    \author Brent Carrara
+ */
+#include "cahal_probe_scheduler.h"
+
+/*! \fn     void cahal_probe_scheduler_worker  (
+              void* in_scheduler
+            )
+    \brief  The routine of the worker threads. Takes the next queued
+            configuration, tests it and completes its task once all of the
+            task's configurations have been tested.
+
+    \param  in_scheduler  The scheduler.
+ */
+static
+void
+cahal_probe_scheduler_worker  (
+                               void* in_scheduler
+                               );
+
+/*! \fn     void cahal_probe_scheduler_complete  (
+              cahal_probe_scheduler*            io_scheduler,
+              cahal_probe_task*                 in_task,
+              cahal_audio_format_description**  in_formats
+            )
+    \brief  Attaches in_formats to the stream of in_task, publishes the device
+            (or frees it if it has no stream) and frees in_task. Must be called
+            with the lock held; the lock is released while the callback runs.
+
+    \param  io_scheduler  The scheduler.
+    \param  in_task The task that is done. It must not be in the task list.
+    \param  in_formats  The supported formats of the stream (may be NULL on
+                        error). Ownership passes to the stream.
+ */
+static
+void
+cahal_probe_scheduler_complete  (
+                                 cahal_probe_scheduler*            io_scheduler,
+                                 cahal_probe_task*                 in_task,
+                                 cahal_audio_format_description**  in_formats
+                                 );
+
+/*! \fn     cahal_audio_format_description** cahal_probe_scheduler_collect (
+              cahal_probe_task* in_task
+            )
+    \brief  Builds the list of supported formats from the test results of
+            in_task.
+
+    \param  in_task The task whose configurations have all been tested.
+    \return A newly allocated null-terminated list or NULL on error.
+ */
+static
+cahal_audio_format_description**
+cahal_probe_scheduler_collect (
+                               cahal_probe_task* in_task
+                               );
+
+/*! \fn     void cahal_probe_scheduler_free_task (
+              cahal_probe_task* in_task
+            )
+    \brief  Frees a task. The device and stream are not freed.
+
+    \param  in_task The task to free.
+ */
+static
+void
+cahal_probe_scheduler_free_task (
+                                 cahal_probe_task* in_task
+                                 );
+
+cahal_probe_scheduler*
+cahal_probe_scheduler_create  (
+                               UINT32                      in_number_of_workers,
+                               cahal_probe_cache*          io_cache,
+                               cahal_device_list_callback  in_callback,
+                               void*                       in_user_data
+                               )
+{
+  cahal_probe_scheduler* scheduler = NULL;
+
+  if  (
+       0 == in_number_of_workers
+       || CAHAL_PROBE_SCHEDULER_MAXIMUM_WORKERS < in_number_of_workers
+       )
+  {
+    CPC_ERROR( "Invalid number of workers: %d.", in_number_of_workers );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &scheduler,
+                            sizeof( cahal_probe_scheduler )
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc scheduler." );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &( scheduler->workers ),
+                            in_number_of_workers * sizeof( cahal_thread )
+                            )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( scheduler->devices ),
+                               sizeof( cahal_device* )
+                               )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc scheduler." );
+
+    cpc_safe_free( ( void** ) &( scheduler->workers ) );
+    cpc_safe_free( ( void** ) &scheduler );
+
+    return( NULL );
+  }
+
+  scheduler->cache      = io_cache;
+  scheduler->callback   = in_callback;
+  scheduler->user_data  = in_user_data;
+
+  if( ! cahal_mutex_initialize( &( scheduler->lock ) ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not initialize lock." );
+
+    cpc_safe_free( ( void** ) &( scheduler->devices ) );
+    cpc_safe_free( ( void** ) &( scheduler->workers ) );
+    cpc_safe_free( ( void** ) &scheduler );
+
+    return( NULL );
+  }
+
+  if( ! cahal_condition_initialize( &( scheduler->work_available ) ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not initialize condition." );
+
+    cahal_mutex_destroy( &( scheduler->lock ) );
+
+    cpc_safe_free( ( void** ) &( scheduler->devices ) );
+    cpc_safe_free( ( void** ) &( scheduler->workers ) );
+    cpc_safe_free( ( void** ) &scheduler );
+
+    return( NULL );
+  }
+
+  if( ! cahal_condition_initialize( &( scheduler->device_published ) ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not initialize condition." );
+
+    cahal_condition_destroy( &( scheduler->work_available ) );
+    cahal_mutex_destroy( &( scheduler->lock ) );
+
+    cpc_safe_free( ( void** ) &( scheduler->devices ) );
+    cpc_safe_free( ( void** ) &( scheduler->workers ) );
+    cpc_safe_free( ( void** ) &scheduler );
+
+    return( NULL );
+  }
+
+  for( UINT32 i = 0; i < in_number_of_workers; i++ )
+  {
+    if  (
+         ! cahal_thread_create  (
+                                 &( scheduler->workers[ i ] ),
+                                 cahal_probe_scheduler_worker,
+                                 scheduler
+                                 )
+         )
+    {
+      CPC_ERROR( "Could not start worker %d.", i );
+
+      cahal_probe_scheduler_free( scheduler );
+
+      return( NULL );
+    }
+
+    scheduler->number_of_workers++;
+  }
+
+  return( scheduler );
+}
+
+CPC_BOOL
+cahal_probe_scheduler_add  (
+                            cahal_probe_scheduler*  io_scheduler,
+                            cahal_device*           in_device,
+                            cahal_device_stream*    in_stream,
+                            cahal_prober*           in_prober,
+                            UINT32                  in_configuration,
+                            const CHAR*             in_device_key,
+                            UINT64                  in_fingerprint
+                            )
+{
+  cahal_probe_task* task                    = NULL;
+  cahal_audio_format_description** formats = NULL;
+  SIZE key_length                           = 0;
+
+  if  (
+       NULL == io_scheduler
+       || NULL == in_device
+       || NULL == in_stream
+       || NULL == in_prober
+       || NULL == in_device_key
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid scheduler parameters." );
+
+    return( CPC_FALSE );
+  }
+
+  key_length = strlen( in_device_key );
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &task, sizeof( cahal_probe_task ) )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( task->device_key ),
+                               key_length + 1
+                               )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc task." );
+
+    cahal_probe_scheduler_free_task( task );
+
+    return( CPC_FALSE );
+  }
+
+  memcpy( task->device_key, in_device_key, key_length );
+
+  task->device                    = in_device;
+  task->stream                    = in_stream;
+  task->prober                    = in_prober;
+  task->configuration             = in_configuration;
+  task->fingerprint               = in_fingerprint;
+  task->number_of_configurations  =
+    cahal_prober_get_number_of_configurations( in_prober );
+  task->number_of_pending         = task->number_of_configurations;
+
+  cahal_mutex_lock( &( io_scheduler->lock ) );
+
+  if( io_scheduler->finished || io_scheduler->stopping )
+  {
+    cahal_mutex_unlock( &( io_scheduler->lock ) );
+
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Scheduler has been finished." );
+
+    cahal_probe_scheduler_free_task( task );
+
+    return( CPC_FALSE );
+  }
+
+  io_scheduler->number_of_pending_tasks++;
+
+  formats =
+    cahal_probe_cache_lookup  (
+                               io_scheduler->cache,
+                               in_device_key,
+                               in_fingerprint
+                               );
+
+  if( NULL != formats || 0 == task->number_of_configurations )
+  {
+    if( NULL == formats )
+    {
+      formats = cahal_probe_scheduler_collect( task );
+    }
+
+    cahal_probe_scheduler_complete( io_scheduler, task, formats );
+
+    cahal_mutex_unlock( &( io_scheduler->lock ) );
+
+    return( CPC_TRUE );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &( task->supported ),
+                            task->number_of_configurations * sizeof( CPC_BOOL )
+                            )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_realloc  (
+                                ( void** ) &( io_scheduler->tasks ),
+                                io_scheduler->number_of_tasks
+                                * sizeof( cahal_probe_task* ),
+                                ( io_scheduler->number_of_tasks + 1 )
+                                * sizeof( cahal_probe_task* )
+                                )
+       )
+  {
+    io_scheduler->number_of_pending_tasks--;
+
+    cahal_mutex_unlock( &( io_scheduler->lock ) );
+
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not queue task." );
+
+    cahal_probe_scheduler_free_task( task );
+
+    return( CPC_FALSE );
+  }
+
+  io_scheduler->tasks[ io_scheduler->number_of_tasks++ ] = task;
+
+  cahal_condition_broadcast( &( io_scheduler->work_available ) );
+
+  cahal_mutex_unlock( &( io_scheduler->lock ) );
+
+  return( CPC_TRUE );
+}
+
+void
+cahal_probe_scheduler_finish (
+                              cahal_probe_scheduler* io_scheduler
+                              )
+{
+  if( NULL != io_scheduler )
+  {
+    cahal_mutex_lock( &( io_scheduler->lock ) );
+
+    io_scheduler->finished = CPC_TRUE;
+
+    cahal_condition_broadcast( &( io_scheduler->device_published ) );
+
+    cahal_mutex_unlock( &( io_scheduler->lock ) );
+  }
+}
+
+cahal_device*
+cahal_probe_scheduler_next (
+                            cahal_probe_scheduler* io_scheduler
+                            )
+{
+  cahal_device* device = NULL;
+
+  if( NULL == io_scheduler )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null scheduler." );
+
+    return( NULL );
+  }
+
+  cahal_mutex_lock( &( io_scheduler->lock ) );
+
+  while (
+         io_scheduler->number_of_returned_devices
+         == io_scheduler->number_of_devices
+         && ! (
+               io_scheduler->finished
+               && 0 == io_scheduler->number_of_pending_tasks
+               )
+         )
+  {
+    cahal_condition_wait  (
+                           &( io_scheduler->device_published ),
+                           &( io_scheduler->lock )
+                           );
+  }
+
+  if  (
+       io_scheduler->number_of_returned_devices
+       < io_scheduler->number_of_devices
+       )
+  {
+    device =
+      io_scheduler->devices[ io_scheduler->number_of_returned_devices++ ];
+  }
+
+  cahal_mutex_unlock( &( io_scheduler->lock ) );
+
+  return( device );
+}
+
+cahal_device**
+cahal_probe_scheduler_wait (
+                            cahal_probe_scheduler* io_scheduler
+                            )
+{
+  cahal_device** devices    = NULL;
+  UINT32 number_of_devices  = 0;
+
+  if( NULL == io_scheduler )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null scheduler." );
+
+    return( NULL );
+  }
+
+  cahal_mutex_lock( &( io_scheduler->lock ) );
+
+  io_scheduler->finished = CPC_TRUE;
+
+  while( 0 < io_scheduler->number_of_pending_tasks )
+  {
+    cahal_condition_wait  (
+                           &( io_scheduler->device_published ),
+                           &( io_scheduler->lock )
+                           );
+  }
+
+  number_of_devices =
+    io_scheduler->number_of_devices
+    - io_scheduler->number_of_returned_devices;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       == cpc_safe_malloc  (
+                            ( void** ) &devices,
+                            ( number_of_devices + 1 ) * sizeof( cahal_device* )
+                            )
+       )
+  {
+    memcpy  (
+             devices,
+             io_scheduler->devices + io_scheduler->number_of_returned_devices,
+             number_of_devices * sizeof( cahal_device* )
+             );
+
+    io_scheduler->number_of_returned_devices = io_scheduler->number_of_devices;
+  }
+  else
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc device list." );
+  }
+
+  cahal_condition_broadcast( &( io_scheduler->device_published ) );
+
+  cahal_mutex_unlock( &( io_scheduler->lock ) );
+
+  return( devices );
+}
+
+void
+cahal_probe_scheduler_free (
+                            cahal_probe_scheduler* in_scheduler
+                            )
+{
+  if( NULL == in_scheduler )
+  {
+    return;
+  }
+
+  cahal_mutex_lock( &( in_scheduler->lock ) );
+
+  in_scheduler->stopping = CPC_TRUE;
+
+  cahal_condition_broadcast( &( in_scheduler->work_available ) );
+
+  cahal_mutex_unlock( &( in_scheduler->lock ) );
+
+  for( UINT32 i = 0; i < in_scheduler->number_of_workers; i++ )
+  {
+    cahal_thread_join( &( in_scheduler->workers[ i ] ) );
+  }
+
+  for( UINT32 i = 0; i < in_scheduler->number_of_tasks; i++ )
+  {
+    cahal_probe_task* task = in_scheduler->tasks[ i ];
+
+    if( NULL != task )
+    {
+      cahal_free_device_stream( task->stream );
+      cahal_free_device( task->device );
+
+      cahal_probe_scheduler_free_task( task );
+    }
+  }
+
+  for (
+       UINT32 i = in_scheduler->number_of_returned_devices;
+       i < in_scheduler->number_of_devices;
+       i++
+       )
+  {
+    cahal_free_device( in_scheduler->devices[ i ] );
+  }
+
+  cahal_condition_destroy( &( in_scheduler->device_published ) );
+  cahal_condition_destroy( &( in_scheduler->work_available ) );
+  cahal_mutex_destroy( &( in_scheduler->lock ) );
+
+  cpc_safe_free( ( void** ) &( in_scheduler->tasks ) );
+  cpc_safe_free( ( void** ) &( in_scheduler->devices ) );
+  cpc_safe_free( ( void** ) &( in_scheduler->workers ) );
+  cpc_safe_free( ( void** ) &in_scheduler );
+}
+
+static
+void
+cahal_probe_scheduler_worker  (
+                               void* in_scheduler
+                               )
+{
+  cahal_probe_scheduler* scheduler = ( cahal_probe_scheduler* ) in_scheduler;
+
+  cahal_mutex_lock( &( scheduler->lock ) );
+
+  while( ! scheduler->stopping )
+  {
+    cahal_probe_task* task  = NULL;
+    UINT32 index            = 0;
+    CPC_BOOL supported      = CPC_FALSE;
+
+    while (
+           scheduler->next_task < scheduler->number_of_tasks
+           && (
+               NULL == scheduler->tasks[ scheduler->next_task ]
+               || scheduler->tasks[ scheduler->next_task ]->next_configuration
+                  == scheduler->tasks[ scheduler->next_task ]
+                       ->number_of_configurations
+               )
+           )
+    {
+      scheduler->next_task++;
+    }
+
+    if( scheduler->next_task == scheduler->number_of_tasks )
+    {
+      cahal_condition_wait  (
+                             &( scheduler->work_available ),
+                             &( scheduler->lock )
+                             );
+
+      continue;
+    }
+
+    task  = scheduler->tasks[ scheduler->next_task ];
+    index = task->next_configuration++;
+
+    cahal_mutex_unlock( &( scheduler->lock ) );
+
+    supported =
+      cahal_prober_test( task->prober, task->configuration, index );
+
+    cahal_mutex_lock( &( scheduler->lock ) );
+
+    task->supported[ index ] = supported;
+
+    if( 0 == --task->number_of_pending )
+    {
+      cahal_audio_format_description** formats =
+        cahal_probe_scheduler_collect( task );
+
+      for( UINT32 i = 0; i < scheduler->number_of_tasks; i++ )
+      {
+        if( task == scheduler->tasks[ i ] )
+        {
+          scheduler->tasks[ i ] = NULL;
+
+          break;
+        }
+      }
+
+      if  (
+           NULL != formats
+           && NULL != scheduler->cache
+           && ! cahal_probe_cache_store  (
+                                          scheduler->cache,
+                                          task->device_key,
+                                          task->fingerprint,
+                                          formats
+                                          )
+           )
+      {
+        CPC_ERROR( "Could not cache formats of %s.", task->device_key );
+      }
+
+      cahal_probe_scheduler_complete( scheduler, task, formats );
+    }
+  }
+
+  cahal_mutex_unlock( &( scheduler->lock ) );
+}
+
+static
+void
+cahal_probe_scheduler_complete  (
+                                 cahal_probe_scheduler*            io_scheduler,
+                                 cahal_probe_task*                 in_task,
+                                 cahal_audio_format_description**  in_formats
+                                 )
+{
+  cahal_device* device          = in_task->device;
+  cahal_device_stream* stream   = in_task->stream;
+  UINT32 number_of_streams      = 0;
+
+  cahal_probe_scheduler_free_task( in_task );
+
+  stream->supported_formats = in_formats;
+
+  while  (
+          NULL != device->device_streams
+          && NULL != device->device_streams[ number_of_streams ]
+          )
+  {
+    number_of_streams++;
+  }
+
+  if  (
+       NULL != in_formats
+       && NULL != in_formats[ 0 ]
+       && CPC_ERROR_CODE_NO_ERROR
+          == cpc_safe_realloc  (
+                                ( void** ) &( device->device_streams ),
+                                ( number_of_streams + 1 )
+                                * sizeof( cahal_device_stream* ),
+                                ( number_of_streams + 2 )
+                                * sizeof( cahal_device_stream* )
+                                )
+       )
+  {
+    device->device_streams[ number_of_streams++ ] = stream;
+  }
+  else
+  {
+    cahal_free_device_stream( stream );
+  }
+
+  if( 0 == number_of_streams )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_DEBUG,
+             "Device %s has no supported formats.",
+             device->device_name
+             );
+
+    cahal_free_device( device );
+
+    device = NULL;
+  }
+  else if( NULL != io_scheduler->callback )
+  {
+    cahal_mutex_unlock( &( io_scheduler->lock ) );
+
+    io_scheduler->callback( device, io_scheduler->user_data );
+
+    cahal_mutex_lock( &( io_scheduler->lock ) );
+  }
+
+  if  (
+       NULL != device
+       && CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_realloc  (
+                                ( void** ) &( io_scheduler->devices ),
+                                ( io_scheduler->number_of_devices + 1 )
+                                * sizeof( cahal_device* ),
+                                ( io_scheduler->number_of_devices + 2 )
+                                * sizeof( cahal_device* )
+                                )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not publish device." );
+
+    cahal_free_device( device );
+
+    device = NULL;
+  }
+
+  if( NULL != device )
+  {
+    io_scheduler->devices[ io_scheduler->number_of_devices++ ] = device;
+  }
+
+  io_scheduler->number_of_pending_tasks--;
+
+  cahal_condition_broadcast( &( io_scheduler->device_published ) );
+}
+
+static
+cahal_audio_format_description**
+cahal_probe_scheduler_collect (
+                               cahal_probe_task* in_task
+                               )
+{
+  cahal_audio_format_description** formats = NULL;
+  UINT32 number_of_formats                 = 0;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &formats,
+                            ( in_task->number_of_configurations + 1 )
+                            * sizeof( cahal_audio_format_description* )
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc format list." );
+
+    return( NULL );
+  }
+
+  for( UINT32 i = 0; i < in_task->number_of_configurations; i++ )
+  {
+    if( in_task->supported[ i ] )
+    {
+      formats[ number_of_formats ] =
+        cahal_prober_create_format( in_task->prober, i );
+
+      if( NULL == formats[ number_of_formats++ ] )
+      {
+        cahal_free_audio_format_description_list( formats );
+
+        return( NULL );
+      }
+    }
+  }
+
+  return( formats );
+}
+
+static
+void
+cahal_probe_scheduler_free_task (
+                                 cahal_probe_task* in_task
+                                 )
+{
+  if( NULL != in_task )
+  {
+    cpc_safe_free( ( void** ) &( in_task->device_key ) );
+    cpc_safe_free( ( void** ) &( in_task->supported ) );
+    cpc_safe_free( ( void** ) &in_task );
+  }
+}
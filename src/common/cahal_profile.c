@@ -0,0 +1,279 @@
+/*! \file   cahal_profile.c
+
+    \author Brent Carrara
+ */
+#include "cahal_profile.h"
+
+#include "cahal.h"
+
+/*! \var    g_init_profile
+    \brief  The profile recorded by cahal_profile_begin and cahal_profile_end.
+ */
+static cahal_init_profile g_init_profile;
+
+/*! \fn     UINT32 cahal_get_number_of_recorded_stages( void )
+    \brief  Returns the number of stages stored in g_init_profile.
+
+    \return The number of stages that have begun, at most
+            CAHAL_PROFILE_MAXIMUM_STAGES.
+ */
+static
+UINT32
+cahal_get_number_of_recorded_stages( void );
+
+/*! \fn     UINT64 cahal_get_init_profile_origin( void )
+    \brief  Returns the time at which the earliest completed stage began.
+
+    \return The time (ns, see cahal_get_time) or 0 if no stage has completed.
+ */
+static
+UINT64
+cahal_get_init_profile_origin( void );
+
+/*! \fn     UINT32 cahal_get_init_profile_depth (
+              UINT32 in_index
+            )
+    \brief  Returns the number of completed stages that began before the
+            in_index'th stage and lie around it.
+
+    \param  in_index  The index of a completed stage.
+    \return The depth of the stage, 0 for stages that are not nested.
+ */
+static
+UINT32
+cahal_get_init_profile_depth (
+                              UINT32 in_index
+                              );
+
+UINT32
+cahal_profile_begin  (
+                      const CHAR* in_name
+                      )
+{
+  UINT32 stage =
+    CAHAL_ATOMIC_ADD( &( g_init_profile.number_of_stages ), 1 ) - 1;
+
+  if( CAHAL_PROFILE_MAXIMUM_STAGES <= stage )
+  {
+    return( CAHAL_PROFILE_NO_STAGE );
+  }
+
+  g_init_profile.stages[ stage ].name       = in_name;
+  g_init_profile.stages[ stage ].start_time = cahal_get_time();
+
+  return( stage );
+}
+
+void
+cahal_profile_end  (
+                    UINT32 in_stage
+                    )
+{
+  if( CAHAL_PROFILE_MAXIMUM_STAGES <= in_stage )
+  {
+    return;
+  }
+
+  g_init_profile.stages[ in_stage ].duration =
+    cahal_get_time() - g_init_profile.stages[ in_stage ].start_time;
+
+  CAHAL_ATOMIC_STORE( &( g_init_profile.stages[ in_stage ].is_complete ), 1 );
+}
+
+const cahal_init_profile*
+cahal_get_init_profile( void )
+{
+  return( &g_init_profile );
+}
+
+const cahal_profile_stage*
+cahal_get_init_profile_stage  (
+                               UINT32 in_index
+                               )
+{
+  cahal_profile_stage* stage = NULL;
+
+  if( cahal_get_number_of_recorded_stages() <= in_index )
+  {
+    return( NULL );
+  }
+
+  stage = &( g_init_profile.stages[ in_index ] );
+
+  return( CAHAL_ATOMIC_LOAD( &( stage->is_complete ) ) ? stage : NULL );
+}
+
+void
+cahal_reset_init_profile( void )
+{
+  memset( &g_init_profile, 0, sizeof( cahal_init_profile ) );
+}
+
+void
+cahal_print_init_profile( void )
+{
+  UINT64 origin = cahal_get_init_profile_origin();
+
+  CPC_LOG_STRING( CPC_LOG_LEVEL_INFO, "CAHAL startup profile:" );
+
+  for( UINT32 i = 0; i < cahal_get_number_of_recorded_stages(); i++ )
+  {
+    const cahal_profile_stage* stage = cahal_get_init_profile_stage( i );
+
+    if( NULL != stage )
+    {
+      CPC_LOG (
+               CPC_LOG_LEVEL_INFO,
+               "\t%*s%s: +%.3f ms, %.3f ms",
+               2 * cahal_get_init_profile_depth( i ),
+               "",
+               stage->name,
+               ( stage->start_time - origin ) / 1000000.0,
+               stage->duration / 1000000.0
+               );
+    }
+  }
+
+  if  (
+       CAHAL_PROFILE_MAXIMUM_STAGES
+       < CAHAL_ATOMIC_LOAD( &( g_init_profile.number_of_stages ) )
+       )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_INFO,
+             "\t%d stage(s) were not recorded.",
+             CAHAL_ATOMIC_LOAD( &( g_init_profile.number_of_stages ) )
+             - CAHAL_PROFILE_MAXIMUM_STAGES
+             );
+  }
+}
+
+CPC_BOOL
+cahal_dump_init_profile  (
+                          const CHAR* in_path
+                          )
+{
+  FILE* file            = NULL;
+  UINT64 origin         = cahal_get_init_profile_origin();
+  CPC_BOOL return_value = CPC_TRUE;
+  const CHAR* separator = "";
+
+  if( NULL == in_path )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null trace path." );
+
+    return( CPC_FALSE );
+  }
+
+  file = fopen( in_path, "w" );
+
+  if( NULL == file )
+  {
+    CPC_ERROR( "Could not open %s for writing.", in_path );
+
+    return( CPC_FALSE );
+  }
+
+  return_value = ( 0 <= fprintf( file, "{ \"traceEvents\": [" ) );
+
+  for  (
+        UINT32 i = 0;
+        i < cahal_get_number_of_recorded_stages() && return_value;
+        i++
+        )
+  {
+    const cahal_profile_stage* stage = cahal_get_init_profile_stage( i );
+
+    if( NULL != stage )
+    {
+      return_value =
+        0 <= fprintf  (
+                       file,
+                       "%s\n  { \"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, "
+                       "\"tid\": 1, \"ts\": %.3f, \"dur\": %.3f }",
+                       separator,
+                       stage->name,
+                       ( stage->start_time - origin ) / 1000.0,
+                       stage->duration / 1000.0
+                       );
+
+      separator = ",";
+    }
+  }
+
+  return_value =
+    return_value
+    && 0 <= fprintf( file, "\n], \"displayTimeUnit\": \"ms\" }\n" );
+
+  if( 0 != fclose( file ) )
+  {
+    return_value = CPC_FALSE;
+  }
+
+  if( ! return_value )
+  {
+    CPC_ERROR( "Could not write trace to %s.", in_path );
+  }
+
+  return( return_value );
+}
+
+static
+UINT32
+cahal_get_number_of_recorded_stages( void )
+{
+  UINT32 number_of_stages =
+    CAHAL_ATOMIC_LOAD( &( g_init_profile.number_of_stages ) );
+
+  return  (
+           CAHAL_PROFILE_MAXIMUM_STAGES < number_of_stages
+           ? CAHAL_PROFILE_MAXIMUM_STAGES
+           : number_of_stages
+           );
+}
+
+static
+UINT64
+cahal_get_init_profile_origin( void )
+{
+  UINT64 origin = 0;
+
+  for( UINT32 i = 0; i < cahal_get_number_of_recorded_stages(); i++ )
+  {
+    const cahal_profile_stage* stage = cahal_get_init_profile_stage( i );
+
+    if( NULL != stage && ( 0 == origin || stage->start_time < origin ) )
+    {
+      origin = stage->start_time;
+    }
+  }
+
+  return( origin );
+}
+
+static
+UINT32
+cahal_get_init_profile_depth (
+                              UINT32 in_index
+                              )
+{
+  const cahal_profile_stage* inner  = cahal_get_init_profile_stage( in_index );
+  UINT32 depth                      = 0;
+
+  for( UINT32 i = 0; i < in_index && NULL != inner; i++ )
+  {
+    const cahal_profile_stage* outer = cahal_get_init_profile_stage( i );
+
+    if  (
+         NULL != outer
+         && outer->start_time <= inner->start_time
+         && inner->start_time + inner->duration
+            <= outer->start_time + outer->duration
+         )
+    {
+      depth++;
+    }
+  }
+
+  return( depth );
+}
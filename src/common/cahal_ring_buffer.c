@@ -0,0 +1,305 @@
+/*! \file   cahal_ring_buffer.c
+
+    \author Brent Carrara
+ */
+#include "cahal_ring_buffer.h"
+
+/*! \def    CAHAL_RING_BUFFER_MAXIMUM_CAPACITY
+    \brief  The largest supported capacity. The difference between the read
+            and write indices must always be representable in 32 bits.
+ */
+#define CAHAL_RING_BUFFER_MAXIMUM_CAPACITY  0x80000000U
+
+/*! \fn     void cahal_ring_buffer_copy_out  (
+              cahal_ring_buffer* in_ring_buffer,
+              UINT32             in_index,
+              UCHAR*             out_data,
+              UINT32             in_length
+            )
+    \brief  Copies in_length bytes starting at the (unmasked) in_index out of
+            the ring buffer, handling the wrap around the end of the storage.
+
+    \param  in_ring_buffer  The ring buffer to copy from.
+    \param  in_index  The unmasked index of the first byte to copy.
+    \param  out_data  The destination buffer.
+    \param  in_length The number of bytes to copy.
+ */
+static
+void
+cahal_ring_buffer_copy_out  (
+                             cahal_ring_buffer* in_ring_buffer,
+                             UINT32             in_index,
+                             UCHAR*             out_data,
+                             UINT32             in_length
+                             );
+
+cahal_ring_buffer*
+cahal_ring_buffer_create (
+                          UINT32 in_capacity
+                          )
+{
+  cahal_ring_buffer* ring_buffer  = NULL;
+  UINT32 capacity                 = 1;
+
+  if( 0 == in_capacity || CAHAL_RING_BUFFER_MAXIMUM_CAPACITY < in_capacity )
+  {
+    CPC_ERROR( "Invalid ring buffer capacity: %d.", in_capacity );
+
+    return( NULL );
+  }
+
+  while( capacity < in_capacity )
+  {
+    capacity <<= 1;
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       == cpc_safe_malloc (
+                           ( void** ) &ring_buffer,
+                           sizeof( cahal_ring_buffer )
+                           )
+       )
+  {
+    if  (
+         CPC_ERROR_CODE_NO_ERROR
+         == cpc_safe_malloc (
+                             ( void** ) &( ring_buffer->buffer ),
+                             sizeof( UCHAR ) * capacity
+                             )
+         )
+    {
+      ring_buffer->capacity = capacity;
+
+      CAHAL_ATOMIC_STORE( &ring_buffer->write_index, 0 );
+      CAHAL_ATOMIC_STORE( &ring_buffer->read_index, 0 );
+    }
+    else
+    {
+      CPC_ERROR( "Could not malloc ring buffer storage (0x%x).", capacity );
+
+      cpc_safe_free( ( void** ) &ring_buffer );
+    }
+  }
+  else
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc ring buffer." );
+  }
+
+  return( ring_buffer );
+}
+
+void
+cahal_ring_buffer_free (
+                        cahal_ring_buffer* in_ring_buffer
+                        )
+{
+  if( NULL != in_ring_buffer )
+  {
+    cpc_safe_free( ( void** ) &( in_ring_buffer->buffer ) );
+
+    cpc_safe_free( ( void** ) &in_ring_buffer );
+  }
+}
+
+void
+cahal_ring_buffer_reset (
+                         cahal_ring_buffer* io_ring_buffer
+                         )
+{
+  if( NULL != io_ring_buffer )
+  {
+    CAHAL_ATOMIC_STORE( &io_ring_buffer->write_index, 0 );
+    CAHAL_ATOMIC_STORE( &io_ring_buffer->read_index, 0 );
+  }
+}
+
+UINT32
+cahal_ring_buffer_get_fill (
+                            cahal_ring_buffer* in_ring_buffer
+                            )
+{
+  if( NULL == in_ring_buffer )
+  {
+    return( 0 );
+  }
+
+  return  (
+           CAHAL_ATOMIC_LOAD( &in_ring_buffer->write_index )
+           - CAHAL_ATOMIC_LOAD( &in_ring_buffer->read_index )
+           );
+}
+
+UINT32
+cahal_ring_buffer_get_space (
+                             cahal_ring_buffer* in_ring_buffer
+                             )
+{
+  if( NULL == in_ring_buffer )
+  {
+    return( 0 );
+  }
+
+  return  (
+           in_ring_buffer->capacity
+           - cahal_ring_buffer_get_fill( in_ring_buffer )
+           );
+}
+
+UINT32
+cahal_ring_buffer_write (
+                         cahal_ring_buffer* io_ring_buffer,
+                         const UCHAR*       in_data,
+                         UINT32             in_length
+                         )
+{
+  UINT32 write_index  = 0;
+  UINT32 read_index   = 0;
+  UINT32 offset       = 0;
+  UINT32 first_part   = 0;
+
+  if( NULL == io_ring_buffer || NULL == in_data || 0 == in_length )
+  {
+    return( 0 );
+  }
+
+  write_index = io_ring_buffer->write_index;
+  read_index  = CAHAL_ATOMIC_LOAD( &io_ring_buffer->read_index );
+
+  if( in_length > io_ring_buffer->capacity - ( write_index - read_index ) )
+  {
+    in_length = io_ring_buffer->capacity - ( write_index - read_index );
+  }
+
+  if( 0 < in_length )
+  {
+    offset      = write_index & ( io_ring_buffer->capacity - 1 );
+    first_part  = io_ring_buffer->capacity - offset;
+
+    if( first_part > in_length )
+    {
+      first_part = in_length;
+    }
+
+    memcpy( io_ring_buffer->buffer + offset, in_data, first_part );
+
+    if( first_part < in_length )
+    {
+      memcpy  (
+               io_ring_buffer->buffer,
+               in_data + first_part,
+               in_length - first_part
+               );
+    }
+
+    CAHAL_ATOMIC_STORE( &io_ring_buffer->write_index, write_index + in_length );
+  }
+
+  return( in_length );
+}
+
+static
+void
+cahal_ring_buffer_copy_out  (
+                             cahal_ring_buffer* in_ring_buffer,
+                             UINT32             in_index,
+                             UCHAR*             out_data,
+                             UINT32             in_length
+                             )
+{
+  UINT32 offset     = in_index & ( in_ring_buffer->capacity - 1 );
+  UINT32 first_part = in_ring_buffer->capacity - offset;
+
+  if( first_part > in_length )
+  {
+    first_part = in_length;
+  }
+
+  memcpy( out_data, in_ring_buffer->buffer + offset, first_part );
+
+  if( first_part < in_length )
+  {
+    memcpy  (
+             out_data + first_part,
+             in_ring_buffer->buffer,
+             in_length - first_part
+             );
+  }
+}
+
+UINT32
+cahal_ring_buffer_read (
+                        cahal_ring_buffer* io_ring_buffer,
+                        UCHAR*             out_data,
+                        UINT32             in_length
+                        )
+{
+  UINT32 read_index   = 0;
+  UINT32 write_index  = 0;
+
+  if( NULL == io_ring_buffer || 0 == in_length )
+  {
+    return( 0 );
+  }
+
+  read_index  = io_ring_buffer->read_index;
+  write_index = CAHAL_ATOMIC_LOAD( &io_ring_buffer->write_index );
+
+  if( in_length > write_index - read_index )
+  {
+    in_length = write_index - read_index;
+  }
+
+  if( 0 < in_length )
+  {
+    if( NULL != out_data )
+    {
+      cahal_ring_buffer_copy_out  (
+                                   io_ring_buffer,
+                                   read_index,
+                                   out_data,
+                                   in_length
+                                   );
+    }
+
+    CAHAL_ATOMIC_STORE( &io_ring_buffer->read_index, read_index + in_length );
+  }
+
+  return( in_length );
+}
+
+UINT32
+cahal_ring_buffer_peek (
+                        cahal_ring_buffer* in_ring_buffer,
+                        UCHAR*             out_data,
+                        UINT32             in_length
+                        )
+{
+  UINT32 read_index   = 0;
+  UINT32 write_index  = 0;
+
+  if( NULL == in_ring_buffer || NULL == out_data || 0 == in_length )
+  {
+    return( 0 );
+  }
+
+  read_index  = in_ring_buffer->read_index;
+  write_index = CAHAL_ATOMIC_LOAD( &in_ring_buffer->write_index );
+
+  if( in_length > write_index - read_index )
+  {
+    in_length = write_index - read_index;
+  }
+
+  if( 0 < in_length )
+  {
+    cahal_ring_buffer_copy_out  (
+                                 in_ring_buffer,
+                                 read_index,
+                                 out_data,
+                                 in_length
+                                 );
+  }
+
+  return( in_length );
+}
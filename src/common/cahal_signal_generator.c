@@ -0,0 +1,712 @@
+/*! \file   cahal_signal_generator.c
+
+    \author Brent Carrara
+ */
+#include <math.h>
+
+#include "cahal_signal_generator.h"
+#include "cahal_audio_convert.h"
+
+#if     defined( __SSE__ ) || defined( _M_X64 )                           \
+        || ( defined( _M_IX86_FP ) && 1 <= _M_IX86_FP )
+#include <xmmintrin.h>
+#define CAHAL_SIGNAL_GENERATOR_SSE
+#elif   defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#include <arm_neon.h>
+#define CAHAL_SIGNAL_GENERATOR_NEON
+#endif
+
+/*! \def    CAHAL_SIGNAL_GENERATOR_PI
+    \brief  The constant pi.
+ */
+#define CAHAL_SIGNAL_GENERATOR_PI           3.14159265358979323846
+
+/*! \def    CAHAL_SIGNAL_GENERATOR_NOISE_SEED
+    \brief  Initial (non-zero) state of the noise generator. A fixed seed makes
+            every run of a noise signal identical.
+ */
+#define CAHAL_SIGNAL_GENERATOR_NOISE_SEED   0x12345678
+
+/*! \fn     void cahal_signal_generator_oscillate  (
+              FLOAT32   in_level,
+              FLOAT64   in_phase,
+              FLOAT64   in_increment,
+              FLOAT32*  io_samples,
+              UINT32    in_number_of_samples
+            )
+    \brief  Adds in_number_of_samples samples of a sinusoid to io_samples. Four
+            consecutive samples are held in the lanes of a vector phasor that
+            is rotated by four times in_increment per step, so the kernel only
+            needs multiplies and adds.
+
+    \param  in_level  The peak level of the sinusoid.
+    \param  in_phase  The phase of the first sample.
+    \param  in_increment  The phase increment per sample.
+    \param  io_samples  The samples to add the sinusoid to.
+    \param  in_number_of_samples  The number of samples. Must be a multiple of
+                                  four.
+ */
+static
+void
+cahal_signal_generator_oscillate  (
+                                   FLOAT32  in_level,
+                                   FLOAT64  in_phase,
+                                   FLOAT64  in_increment,
+                                   FLOAT32* io_samples,
+                                   UINT32   in_number_of_samples
+                                   );
+
+/*! \fn     void cahal_signal_generator_synthesize  (
+              cahal_signal_generator* io_generator
+            )
+    \brief  Synthesizes the next CAHAL_SIGNAL_GENERATOR_CHUNK_FRAMES mono
+            samples into io_generator->chunk.
+
+    \param  io_generator  The generator to synthesize.
+ */
+static
+void
+cahal_signal_generator_synthesize  (
+                                    cahal_signal_generator* io_generator
+                                    );
+
+/*! \fn     FLOAT32 cahal_signal_generator_next_noise  (
+              cahal_signal_generator* io_generator
+            )
+    \brief  Returns the next uniformly distributed sample in [ -1, 1 ).
+
+    \param  io_generator  The generator whose noise state is advanced.
+    \return The next white noise sample.
+ */
+static
+FLOAT32
+cahal_signal_generator_next_noise  (
+                                    cahal_signal_generator* io_generator
+                                    );
+
+cahal_signal_generator*
+cahal_signal_generator_create  (
+                                cahal_signal_type       in_signal_type,
+                                UINT32                  in_number_of_channels,
+                                FLOAT64                 in_sample_rate,
+                                UINT32                  in_bit_depth,
+                                cahal_audio_format_flag in_format_flags,
+                                FLOAT32                 in_amplitude
+                                )
+{
+  cahal_signal_generator* generator = NULL;
+
+  if  (
+       CAHAL_SIGNAL_IMPULSE_TRAIN < in_signal_type
+       || 0 == in_number_of_channels
+       || 0.0 >= in_sample_rate
+       || 0.0f > in_amplitude
+       || 1.0f < in_amplitude
+       )
+  {
+    CPC_ERROR (
+               "Invalid signal generator parameters: type=%d, nc=%d, "
+               "sr=%.2f, amplitude=%.3f.",
+               in_signal_type,
+               in_number_of_channels,
+               in_sample_rate,
+               in_amplitude
+               );
+
+    return( NULL );
+  }
+
+  if( ! cahal_test_conversion_support( in_bit_depth, in_format_flags ) )
+  {
+    CPC_LOG_STRING  (
+                     CPC_LOG_LEVEL_ERROR,
+                     "Unsupported sample format for signal generator."
+                     );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc (
+                           ( void** ) &generator,
+                           sizeof( cahal_signal_generator )
+                           )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc generator." );
+
+    return( NULL );
+  }
+
+  generator->signal_type        = in_signal_type;
+  generator->number_of_channels = in_number_of_channels;
+  generator->sample_rate        = in_sample_rate;
+  generator->bit_depth          = in_bit_depth;
+  generator->format_flags       = in_format_flags;
+  generator->amplitude          = in_amplitude;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &( generator->chunk ),
+                            CAHAL_SIGNAL_GENERATOR_CHUNK_FRAMES
+                            * sizeof( FLOAT32 )
+                            )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( generator->output_scratch ),
+                               CAHAL_SIGNAL_GENERATOR_CHUNK_FRAMES
+                               * in_number_of_channels * sizeof( FLOAT32 )
+                               )
+       )
+  {
+    CPC_LOG_STRING  (
+                     CPC_LOG_LEVEL_ERROR,
+                     "Could not malloc signal generator buffers."
+                     );
+
+    cahal_signal_generator_free( generator );
+
+    return( NULL );
+  }
+
+  cahal_signal_generator_reset( generator );
+
+  return( generator );
+}
+
+void
+cahal_signal_generator_free  (
+                              cahal_signal_generator* in_generator
+                              )
+{
+  if( NULL != in_generator )
+  {
+    cpc_safe_free( ( void** ) &( in_generator->chunk ) );
+    cpc_safe_free( ( void** ) &( in_generator->output_scratch ) );
+
+    cpc_safe_free( ( void** ) &in_generator );
+  }
+}
+
+CPC_BOOL
+cahal_signal_generator_add_tone  (
+                                  cahal_signal_generator* io_generator,
+                                  FLOAT64                 in_frequency,
+                                  FLOAT32                 in_level
+                                  )
+{
+  UINT32 maximum_tones = CAHAL_SIGNAL_GENERATOR_MAXIMUM_TONES;
+
+  if( NULL == io_generator )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null signal generator." );
+
+    return( CPC_FALSE );
+  }
+
+  if( CAHAL_SIGNAL_SINE == io_generator->signal_type )
+  {
+    maximum_tones = 1;
+  }
+  else if( CAHAL_SIGNAL_MULTITONE != io_generator->signal_type )
+  {
+    maximum_tones = 0;
+  }
+
+  if  (
+       maximum_tones <= io_generator->number_of_tones
+       || 0.0 >= in_frequency
+       || io_generator->sample_rate / 2.0 <= in_frequency
+       )
+  {
+    CPC_ERROR (
+               "Could not add tone: type=%d, tones=%d, frequency=%.2f.",
+               io_generator->signal_type,
+               io_generator->number_of_tones,
+               in_frequency
+               );
+
+    return( CPC_FALSE );
+  }
+
+  io_generator->tones[ io_generator->number_of_tones ].frequency =
+    in_frequency;
+  io_generator->tones[ io_generator->number_of_tones ].level     = in_level;
+  io_generator->tones[ io_generator->number_of_tones ].phase     = 0.0;
+
+  io_generator->number_of_tones++;
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_signal_generator_set_sweep  (
+                                   cahal_signal_generator* io_generator,
+                                   FLOAT64                 in_start_frequency,
+                                   FLOAT64                 in_end_frequency,
+                                   FLOAT64                 in_duration
+                                   )
+{
+  if  (
+       NULL == io_generator
+       || CAHAL_SIGNAL_LOG_SWEEP != io_generator->signal_type
+       || 0.0 >= in_start_frequency
+       || 0.0 >= in_end_frequency
+       || in_start_frequency == in_end_frequency
+       || io_generator->sample_rate / 2.0 < in_start_frequency
+       || io_generator->sample_rate / 2.0 < in_end_frequency
+       || 1.0 > in_duration * io_generator->sample_rate
+       )
+  {
+    CPC_ERROR (
+               "Invalid sweep: start=%.2f, end=%.2f, duration=%.3f.",
+               in_start_frequency,
+               in_end_frequency,
+               in_duration
+               );
+
+    return( CPC_FALSE );
+  }
+
+  io_generator->sweep_start_frequency = in_start_frequency;
+  io_generator->sweep_end_frequency   = in_end_frequency;
+  io_generator->sweep_length          =
+    ( UINT32 ) ( in_duration * io_generator->sample_rate );
+
+  cahal_signal_generator_reset( io_generator );
+
+  return( CPC_TRUE );
+}
+
+CPC_BOOL
+cahal_signal_generator_set_period  (
+                                    cahal_signal_generator* io_generator,
+                                    FLOAT64                 in_period
+                                    )
+{
+  if  (
+       NULL == io_generator
+       || CAHAL_SIGNAL_IMPULSE_TRAIN != io_generator->signal_type
+       || 1.0 > in_period * io_generator->sample_rate
+       )
+  {
+    CPC_ERROR( "Invalid impulse period: period=%.6f.", in_period );
+
+    return( CPC_FALSE );
+  }
+
+  io_generator->impulse_period  =
+    ( UINT32 ) ( in_period * io_generator->sample_rate + 0.5 );
+
+  cahal_signal_generator_reset( io_generator );
+
+  return( CPC_TRUE );
+}
+
+void
+cahal_signal_generator_reset  (
+                               cahal_signal_generator* io_generator
+                               )
+{
+  if( NULL != io_generator )
+  {
+    for( UINT32 i = 0; i < io_generator->number_of_tones; i++ )
+    {
+      io_generator->tones[ i ].phase = 0.0;
+    }
+
+    for( UINT32 i = 0; i < 7; i++ )
+    {
+      io_generator->pink_state[ i ] = 0.0f;
+    }
+
+    io_generator->position      = 0;
+    io_generator->noise_state   = CAHAL_SIGNAL_GENERATOR_NOISE_SEED;
+    io_generator->chunk_offset  = CAHAL_SIGNAL_GENERATOR_CHUNK_FRAMES;
+  }
+}
+
+void
+cahal_signal_generator_generate  (
+                                  cahal_signal_generator* io_generator,
+                                  FLOAT32*                out_frames,
+                                  UINT32                  in_number_of_frames
+                                  )
+{
+  UINT32 channels = 0;
+
+  if( NULL == io_generator || NULL == out_frames )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null signal generator or buffer." );
+
+    return;
+  }
+
+  channels = io_generator->number_of_channels;
+
+  while( 0 < in_number_of_frames )
+  {
+    UINT32 count            = 0;
+    const FLOAT32* samples  = NULL;
+
+    if( CAHAL_SIGNAL_GENERATOR_CHUNK_FRAMES == io_generator->chunk_offset )
+    {
+      cahal_signal_generator_synthesize( io_generator );
+
+      io_generator->chunk_offset = 0;
+    }
+
+    count   =
+      CAHAL_SIGNAL_GENERATOR_CHUNK_FRAMES - io_generator->chunk_offset;
+    samples = io_generator->chunk + io_generator->chunk_offset;
+
+    if( in_number_of_frames < count )
+    {
+      count = in_number_of_frames;
+    }
+
+    if( 1 == channels )
+    {
+      memcpy( out_frames, samples, count * sizeof( FLOAT32 ) );
+    }
+    else
+    {
+      for( UINT32 frame = 0; frame < count; frame++ )
+      {
+        for( UINT32 channel = 0; channel < channels; channel++ )
+        {
+          out_frames[ frame * channels + channel ] = samples[ frame ];
+        }
+      }
+    }
+
+    io_generator->chunk_offset  += count;
+    out_frames                  += count * channels;
+    in_number_of_frames         -= count;
+  }
+}
+
+CPC_BOOL
+cahal_signal_generator_playback_callback (
+                                          cahal_device* in_playback_device,
+                                          UCHAR*        out_data_buffer,
+                                          UINT32*       io_data_buffer_length,
+                                          void*         in_client_data
+                                          )
+{
+  cahal_signal_generator* generator =
+    ( cahal_signal_generator* ) in_client_data;
+  UINT32 frame_size                 = 0;
+  UINT32 number_of_frames           = 0;
+
+  if  (
+       NULL == generator
+       || NULL == out_data_buffer
+       || NULL == io_data_buffer_length
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null signal generator or buffer." );
+
+    return( CPC_FALSE );
+  }
+
+  frame_size        =
+    cahal_get_bytes_per_sample( generator->bit_depth )
+    * generator->number_of_channels;
+  number_of_frames  = *io_data_buffer_length / frame_size;
+
+  *io_data_buffer_length = number_of_frames * frame_size;
+
+  while( 0 < number_of_frames )
+  {
+    UINT32 chunk = number_of_frames;
+
+    if( CAHAL_SIGNAL_GENERATOR_CHUNK_FRAMES < chunk )
+    {
+      chunk = CAHAL_SIGNAL_GENERATOR_CHUNK_FRAMES;
+    }
+
+    cahal_signal_generator_generate (
+                                     generator,
+                                     generator->output_scratch,
+                                     chunk
+                                     );
+
+    cahal_convert_from_float32  (
+                                 generator->output_scratch,
+                                 chunk * generator->number_of_channels,
+                                 generator->bit_depth,
+                                 generator->format_flags,
+                                 out_data_buffer
+                                 );
+
+    out_data_buffer   += chunk * frame_size;
+    number_of_frames  -= chunk;
+  }
+
+  return( CPC_TRUE );
+}
+
+static
+void
+cahal_signal_generator_synthesize  (
+                                    cahal_signal_generator* io_generator
+                                    )
+{
+  FLOAT32* chunk    = io_generator->chunk;
+  FLOAT32 amplitude = io_generator->amplitude;
+  UINT32 length     = CAHAL_SIGNAL_GENERATOR_CHUNK_FRAMES;
+
+  memset( chunk, 0, length * sizeof( FLOAT32 ) );
+
+  switch( io_generator->signal_type )
+  {
+    case CAHAL_SIGNAL_SINE:
+    case CAHAL_SIGNAL_MULTITONE:
+      for( UINT32 i = 0; i < io_generator->number_of_tones; i++ )
+      {
+        cahal_signal_tone* tone = &( io_generator->tones[ i ] );
+        FLOAT64 increment       =
+          2.0 * CAHAL_SIGNAL_GENERATOR_PI * tone->frequency
+          / io_generator->sample_rate;
+
+        cahal_signal_generator_oscillate  (
+                                           amplitude * tone->level,
+                                           tone->phase,
+                                           increment,
+                                           chunk,
+                                           length
+                                           );
+
+        tone->phase =
+          fmod(
+               tone->phase + increment * length,
+               2.0 * CAHAL_SIGNAL_GENERATOR_PI
+               );
+      }
+      break;
+
+    case CAHAL_SIGNAL_LOG_SWEEP:
+      if( 0 < io_generator->sweep_length )
+      {
+        FLOAT64 sample_rate = io_generator->sample_rate;
+        FLOAT64 log_ratio   =
+          log (
+               io_generator->sweep_end_frequency
+               / io_generator->sweep_start_frequency
+               );
+        FLOAT64 rate        =
+          log_ratio / io_generator->sweep_length;
+        FLOAT64 scale       =
+          2.0 * CAHAL_SIGNAL_GENERATOR_PI
+          * io_generator->sweep_start_frequency
+          * io_generator->sweep_length / ( sample_rate * log_ratio );
+        FLOAT64 growth      = exp( rate );
+        FLOAT64 envelope    = exp( rate * io_generator->position );
+
+        //  phase( n ) = scale * ( exp( rate * n ) - 1 ), the envelope is
+        //  resynchronised to the exact value at the start of every chunk.
+        for( UINT32 i = 0; i < length; i++ )
+        {
+          chunk[ i ] =
+            amplitude * ( FLOAT32 ) sin( scale * ( envelope - 1.0 ) );
+
+          envelope *= growth;
+
+          io_generator->position++;
+
+          if( io_generator->sweep_length == io_generator->position )
+          {
+            io_generator->position  = 0;
+            envelope                = 1.0;
+          }
+        }
+      }
+      break;
+
+    case CAHAL_SIGNAL_WHITE_NOISE:
+      for( UINT32 i = 0; i < length; i++ )
+      {
+        chunk[ i ] =
+          amplitude * cahal_signal_generator_next_noise( io_generator );
+      }
+      break;
+
+    case CAHAL_SIGNAL_PINK_NOISE:
+      {
+        FLOAT32* b = io_generator->pink_state;
+
+        //  Paul Kellet's refined -3 dB/octave filter, accurate to within
+        //  +/- 0.05 dB above 9.2 Hz at 44.1 kHz.
+        for( UINT32 i = 0; i < length; i++ )
+        {
+          FLOAT32 white = cahal_signal_generator_next_noise( io_generator );
+          FLOAT32 pink  = 0.0f;
+
+          b[ 0 ] = 0.99886f * b[ 0 ] + white * 0.0555179f;
+          b[ 1 ] = 0.99332f * b[ 1 ] + white * 0.0750759f;
+          b[ 2 ] = 0.96900f * b[ 2 ] + white * 0.1538520f;
+          b[ 3 ] = 0.86650f * b[ 3 ] + white * 0.3104856f;
+          b[ 4 ] = 0.55000f * b[ 4 ] + white * 0.5329522f;
+          b[ 5 ] = -0.7616f * b[ 5 ] - white * 0.0168980f;
+
+          pink  =
+            ( b[ 0 ] + b[ 1 ] + b[ 2 ] + b[ 3 ] + b[ 4 ] + b[ 5 ] + b[ 6 ]
+              + white * 0.5362f ) * 0.11f;
+
+          b[ 6 ] = white * 0.115926f;
+
+          if( 1.0f < pink )
+          {
+            pink = 1.0f;
+          }
+          else if( -1.0f > pink )
+          {
+            pink = -1.0f;
+          }
+
+          chunk[ i ] = amplitude * pink;
+        }
+      }
+      break;
+
+    case CAHAL_SIGNAL_IMPULSE_TRAIN:
+      if( 0 < io_generator->impulse_period )
+      {
+        UINT32 period = io_generator->impulse_period;
+        UINT32 next   =
+          ( period - io_generator->position % period ) % period;
+
+        for( UINT32 i = next; i < length; i += period )
+        {
+          chunk[ i ] = amplitude;
+        }
+
+        io_generator->position =
+          ( io_generator->position + length ) % period;
+      }
+      break;
+
+    case CAHAL_SIGNAL_SILENCE:
+    default:
+      break;
+  }
+}
+
+static
+FLOAT32
+cahal_signal_generator_next_noise  (
+                                    cahal_signal_generator* io_generator
+                                    )
+{
+  UINT32 state = io_generator->noise_state;
+
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+
+  io_generator->noise_state = state;
+
+  return( ( FLOAT32 ) ( ( INT32 ) state ) * ( 1.0f / 2147483648.0f ) );
+}
+
+static
+void
+cahal_signal_generator_oscillate  (
+                                   FLOAT32  in_level,
+                                   FLOAT64  in_phase,
+                                   FLOAT64  in_increment,
+                                   FLOAT32* io_samples,
+                                   UINT32   in_number_of_samples
+                                   )
+{
+  FLOAT32 lanes_real[ 4 ];
+  FLOAT32 lanes_imaginary[ 4 ];
+  FLOAT32 rotation_real       = ( FLOAT32 ) cos( 4.0 * in_increment );
+  FLOAT32 rotation_imaginary  = ( FLOAT32 ) sin( 4.0 * in_increment );
+
+  for( UINT32 lane = 0; lane < 4; lane++ )
+  {
+    lanes_real[ lane ]      =
+      in_level * ( FLOAT32 ) cos( in_phase + lane * in_increment );
+    lanes_imaginary[ lane ] =
+      in_level * ( FLOAT32 ) sin( in_phase + lane * in_increment );
+  }
+
+#if defined( CAHAL_SIGNAL_GENERATOR_SSE )
+  {
+    __m128 real       = _mm_loadu_ps( lanes_real );
+    __m128 imaginary  = _mm_loadu_ps( lanes_imaginary );
+    __m128 cosine     = _mm_set1_ps( rotation_real );
+    __m128 sine       = _mm_set1_ps( rotation_imaginary );
+
+    for( UINT32 i = 0; i < in_number_of_samples; i += 4 )
+    {
+      __m128 rotated  =
+        _mm_sub_ps  (
+                     _mm_mul_ps( real, cosine ),
+                     _mm_mul_ps( imaginary, sine )
+                     );
+
+      _mm_storeu_ps (
+                     io_samples + i,
+                     _mm_add_ps( _mm_loadu_ps( io_samples + i ), imaginary )
+                     );
+
+      imaginary =
+        _mm_add_ps  (
+                     _mm_mul_ps( real, sine ),
+                     _mm_mul_ps( imaginary, cosine )
+                     );
+      real      = rotated;
+    }
+  }
+#elif defined( CAHAL_SIGNAL_GENERATOR_NEON )
+  {
+    float32x4_t real      = vld1q_f32( lanes_real );
+    float32x4_t imaginary = vld1q_f32( lanes_imaginary );
+
+    for( UINT32 i = 0; i < in_number_of_samples; i += 4 )
+    {
+      float32x4_t rotated =
+        vmlsq_n_f32 (
+                     vmulq_n_f32( real, rotation_real ),
+                     imaginary,
+                     rotation_imaginary
+                     );
+
+      vst1q_f32 (
+                 io_samples + i,
+                 vaddq_f32( vld1q_f32( io_samples + i ), imaginary )
+                 );
+
+      imaginary =
+        vmlaq_n_f32 (
+                     vmulq_n_f32( imaginary, rotation_real ),
+                     real,
+                     rotation_imaginary
+                     );
+      real      = rotated;
+    }
+  }
+#else
+  for( UINT32 i = 0; i < in_number_of_samples; i += 4 )
+  {
+    for( UINT32 lane = 0; lane < 4; lane++ )
+    {
+      FLOAT32 rotated =
+        lanes_real[ lane ] * rotation_real
+        - lanes_imaginary[ lane ] * rotation_imaginary;
+
+      io_samples[ i + lane ] += lanes_imaginary[ lane ];
+
+      lanes_imaginary[ lane ] =
+        lanes_real[ lane ] * rotation_imaginary
+        + lanes_imaginary[ lane ] * rotation_real;
+      lanes_real[ lane ]      = rotated;
+    }
+  }
+#endif
+}
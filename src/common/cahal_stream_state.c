@@ -0,0 +1,373 @@
+/*! \file   cahal_stream_state.c
+
+    \author Brent Carrara
+ */
+#include "cahal_stream_state.h"
+
+#include "cahal_thread.h"
+
+cahal_stream_state g_cahal_recording_state  = { CAHAL_STREAM_STATE_IDLE };
+cahal_stream_state g_cahal_playback_state   = { CAHAL_STREAM_STATE_IDLE };
+
+/*! \fn     CPC_BOOL cahal_stream_state_move (
+              cahal_stream_state* io_state,
+              UINT32              in_from,
+              UINT32              in_to
+            )
+    \brief  Replaces the state of a stream, leaving the number of callbacks
+            using it untouched.
+
+    \param  io_state  The lifecycle of the stream.
+    \param  in_from The state the stream must be in.
+    \param  in_to The new state.
+    \return True iff the stream was in in_from and is now in in_to.
+ */
+static
+CPC_BOOL
+cahal_stream_state_move (
+                         cahal_stream_state* io_state,
+                         UINT32              in_from,
+                         UINT32              in_to
+                         );
+
+/*! \fn     CPC_BOOL cahal_stream_state_is_allocated (
+              UINT32 in_state
+            )
+    \brief  Tests whether the callback info of a stream in in_state is
+            allocated and may be used by callbacks.
+
+    \param  in_state  One of cahal_stream_states.
+    \return True iff in_state is STARTING, RUNNING, PAUSING or PAUSED.
+ */
+static
+CPC_BOOL
+cahal_stream_state_is_allocated (
+                                 UINT32 in_state
+                                 );
+
+UINT32
+cahal_stream_state_get  (
+                         cahal_stream_state* in_state
+                         )
+{
+  return( CAHAL_ATOMIC_LOAD( &( in_state->value ) ) & CAHAL_STREAM_STATE_MASK );
+}
+
+CPC_BOOL
+cahal_stream_state_begin_start  (
+                                 cahal_stream_state* io_state
+                                 )
+{
+  return  (
+           cahal_stream_state_move  (
+                                     io_state,
+                                     CAHAL_STREAM_STATE_IDLE,
+                                     CAHAL_STREAM_STATE_STARTING
+                                     )
+           || cahal_stream_state_move (
+                                       io_state,
+                                       CAHAL_STREAM_STATE_STOPPED,
+                                       CAHAL_STREAM_STATE_STARTING
+                                       )
+           );
+}
+
+void
+cahal_stream_state_end_start  (
+                               cahal_stream_state* io_state,
+                               CPC_BOOL            in_is_running
+                               )
+{
+  if  (
+       ! cahal_stream_state_move  (
+                                   io_state,
+                                   CAHAL_STREAM_STATE_STARTING,
+                                   in_is_running
+                                   ? CAHAL_STREAM_STATE_RUNNING
+                                   : CAHAL_STREAM_STATE_IDLE
+                                   )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Stream was not starting." );
+  }
+}
+
+CPC_BOOL
+cahal_stream_state_begin_stop  (
+                                cahal_stream_state* io_state,
+                                UINT32*             out_state
+                                )
+{
+  UINT32 state = cahal_stream_state_get( io_state );
+
+  //  A pause or resume may move the stream between reading and swapping it,
+  //  so read again until the stream settles
+  while  (
+          CAHAL_STREAM_STATE_STARTING == state
+          || CAHAL_STREAM_STATE_PAUSING == state
+          || (
+              (
+               CAHAL_STREAM_STATE_RUNNING == state
+               || CAHAL_STREAM_STATE_PAUSED == state
+               )
+              && ! cahal_stream_state_move (
+                                            io_state,
+                                            state,
+                                            CAHAL_STREAM_STATE_STOPPING
+                                            )
+              )
+          )
+  {
+    cahal_thread_yield();
+
+    state = cahal_stream_state_get( io_state );
+  }
+
+  if( NULL != out_state )
+  {
+    *out_state = state;
+  }
+
+  return  (
+           CAHAL_STREAM_STATE_RUNNING == state
+           || CAHAL_STREAM_STATE_PAUSED == state
+           );
+}
+
+void
+cahal_stream_state_wait_for_callbacks (
+                                       cahal_stream_state* in_state
+                                       )
+{
+  //  Callbacks are refused once stopping, so only those that were already
+  //  running are waited for; they are short, yielding is enough.
+  while  (
+          CAHAL_ATOMIC_LOAD( &( in_state->value ) )
+          & ~( ( UINT32 ) CAHAL_STREAM_STATE_MASK )
+          )
+  {
+    cahal_thread_yield();
+  }
+}
+
+void
+cahal_stream_state_end_stop  (
+                              cahal_stream_state* io_state
+                              )
+{
+  if  (
+       ! cahal_stream_state_move  (
+                                   io_state,
+                                   CAHAL_STREAM_STATE_STOPPING,
+                                   CAHAL_STREAM_STATE_STOPPED
+                                   )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Stream was not stopping." );
+  }
+}
+
+void
+cahal_stream_state_end_prepare  (
+                                 cahal_stream_state* io_state,
+                                 CPC_BOOL            in_is_prepared
+                                 )
+{
+  if  (
+       ! cahal_stream_state_move  (
+                                   io_state,
+                                   CAHAL_STREAM_STATE_STARTING,
+                                   in_is_prepared
+                                   ? CAHAL_STREAM_STATE_PAUSED
+                                   : CAHAL_STREAM_STATE_IDLE
+                                   )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Stream was not starting." );
+  }
+}
+
+CPC_BOOL
+cahal_stream_state_begin_pause  (
+                                 cahal_stream_state* io_state
+                                 )
+{
+  return  (
+           cahal_stream_state_move  (
+                                     io_state,
+                                     CAHAL_STREAM_STATE_RUNNING,
+                                     CAHAL_STREAM_STATE_PAUSING
+                                     )
+           );
+}
+
+void
+cahal_stream_state_end_pause  (
+                               cahal_stream_state* io_state,
+                               CPC_BOOL            in_is_paused
+                               )
+{
+  if  (
+       ! cahal_stream_state_move  (
+                                   io_state,
+                                   CAHAL_STREAM_STATE_PAUSING,
+                                   in_is_paused
+                                   ? CAHAL_STREAM_STATE_PAUSED
+                                   : CAHAL_STREAM_STATE_RUNNING
+                                   )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Stream was not pausing." );
+  }
+}
+
+CPC_BOOL
+cahal_stream_state_begin_resume (
+                                 cahal_stream_state* io_state
+                                 )
+{
+  return  (
+           cahal_stream_state_move  (
+                                     io_state,
+                                     CAHAL_STREAM_STATE_PAUSED,
+                                     CAHAL_STREAM_STATE_STARTING
+                                     )
+           );
+}
+
+void
+cahal_stream_state_end_resume (
+                               cahal_stream_state* io_state,
+                               CPC_BOOL            in_is_running
+                               )
+{
+  if  (
+       ! cahal_stream_state_move  (
+                                   io_state,
+                                   CAHAL_STREAM_STATE_STARTING,
+                                   in_is_running
+                                   ? CAHAL_STREAM_STATE_RUNNING
+                                   : CAHAL_STREAM_STATE_PAUSED
+                                   )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Stream was not resuming." );
+  }
+}
+
+CPC_BOOL
+cahal_stream_state_begin_configure  (
+                                     cahal_stream_state* io_state
+                                     )
+{
+  return  (
+           cahal_stream_state_move  (
+                                     io_state,
+                                     CAHAL_STREAM_STATE_IDLE,
+                                     CAHAL_STREAM_STATE_CONFIGURING
+                                     )
+           || cahal_stream_state_move (
+                                       io_state,
+                                       CAHAL_STREAM_STATE_STOPPED,
+                                       CAHAL_STREAM_STATE_CONFIGURING
+                                       )
+           );
+}
+
+void
+cahal_stream_state_end_configure  (
+                                   cahal_stream_state* io_state
+                                   )
+{
+  if  (
+       ! cahal_stream_state_move  (
+                                   io_state,
+                                   CAHAL_STREAM_STATE_CONFIGURING,
+                                   CAHAL_STREAM_STATE_IDLE
+                                   )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Stream was not configuring." );
+  }
+}
+
+CPC_BOOL
+cahal_stream_state_enter_callback (
+                                   cahal_stream_state* io_state
+                                   )
+{
+  UINT32 value = CAHAL_ATOMIC_LOAD( &( io_state->value ) );
+
+  //  Entering and checking the state is one swap, so a stop either sees the
+  //  callback or the callback sees the stop.
+  while( cahal_stream_state_is_allocated( value & CAHAL_STREAM_STATE_MASK ) )
+  {
+    if  (
+         CAHAL_ATOMIC_COMPARE_AND_SWAP  (
+                                         &( io_state->value ),
+                                         value,
+                                         value + CAHAL_STREAM_STATE_CALLBACK
+                                         )
+         )
+    {
+      return( CPC_TRUE );
+    }
+
+    value = CAHAL_ATOMIC_LOAD( &( io_state->value ) );
+  }
+
+  return( CPC_FALSE );
+}
+
+void
+cahal_stream_state_leave_callback (
+                                   cahal_stream_state* io_state
+                                   )
+{
+  CAHAL_ATOMIC_ADD( &( io_state->value ), -CAHAL_STREAM_STATE_CALLBACK );
+}
+
+static
+CPC_BOOL
+cahal_stream_state_move (
+                         cahal_stream_state* io_state,
+                         UINT32              in_from,
+                         UINT32              in_to
+                         )
+{
+  UINT32 value = CAHAL_ATOMIC_LOAD( &( io_state->value ) );
+
+  while( in_from == ( value & CAHAL_STREAM_STATE_MASK ) )
+  {
+    UINT32 callbacks = value & ~( ( UINT32 ) CAHAL_STREAM_STATE_MASK );
+
+    if  (
+         CAHAL_ATOMIC_COMPARE_AND_SWAP  (
+                                         &( io_state->value ),
+                                         value,
+                                         callbacks | in_to
+                                         )
+         )
+    {
+      return( CPC_TRUE );
+    }
+
+    value = CAHAL_ATOMIC_LOAD( &( io_state->value ) );
+  }
+
+  return( CPC_FALSE );
+}
+
+static
+CPC_BOOL
+cahal_stream_state_is_allocated (
+                                 UINT32 in_state
+                                 )
+{
+  return  (
+           CAHAL_STREAM_STATE_STARTING == in_state
+           || CAHAL_STREAM_STATE_RUNNING == in_state
+           || CAHAL_STREAM_STATE_PAUSING == in_state
+           || CAHAL_STREAM_STATE_PAUSED == in_state
+           );
+}
@@ -0,0 +1,597 @@
+/*! \file   cahal_thread.c
+
+    \author Brent Carrara
+ */
+#if defined( __linux__ ) && ! defined( _GNU_SOURCE )
+//  Needed for sched_setaffinity and the CPU_* macros
+#define _GNU_SOURCE
+#endif
+
+#include "cahal_thread.h"
+
+#if defined( _WIN32 )
+#include <avrt.h>
+#else
+#include <errno.h>
+#include <sched.h>
+#endif
+
+#if defined( __APPLE__ )
+#include <mach/mach_time.h>
+#include <mach/thread_policy.h>
+#endif
+
+#if defined( _WIN32 )
+/*! \var    g_mmcss_task
+    \brief  The MMCSS task the calling thread joined in
+            cahal_thread_set_scheduling or NULL.
+ */
+static __declspec( thread ) HANDLE g_mmcss_task = NULL;
+
+/*! \fn     AVRT_PRIORITY cahal_thread_get_mmcss_priority  (
+              UINT32 in_priority
+            )
+    \brief  Maps a real-time priority onto one of the four MMCSS priorities.
+
+    \param  in_priority The priority from 1 to 99.
+    \return The MMCSS priority.
+ */
+static
+AVRT_PRIORITY
+cahal_thread_get_mmcss_priority  (
+                                  UINT32 in_priority
+                                  );
+#endif
+
+/*! \fn     void* cahal_thread_start  (
+              void* in_thread
+            )
+    \brief  The entry point of every thread. Runs the routine of in_thread.
+
+    \param  in_thread The cahal_thread being started.
+    \return Always returns 0 (NULL).
+ */
+#if defined( _WIN32 )
+static
+DWORD WINAPI
+cahal_thread_start  (
+                     LPVOID in_thread
+                     );
+#else
+static
+void*
+cahal_thread_start  (
+                     void* in_thread
+                     );
+#endif
+
+CPC_BOOL
+cahal_thread_create  (
+                      cahal_thread*         out_thread,
+                      cahal_thread_routine  in_routine,
+                      void*                 in_argument
+                      )
+{
+  if( NULL == out_thread || NULL == in_routine )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid thread parameters." );
+
+    return( CPC_FALSE );
+  }
+
+  out_thread->routine   = in_routine;
+  out_thread->argument  = in_argument;
+
+#if defined( _WIN32 )
+  out_thread->handle =
+    CreateThread( NULL, 0, cahal_thread_start, out_thread, 0, NULL );
+
+  if( NULL == out_thread->handle )
+  {
+    CPC_ERROR( "Could not create thread: %d.", GetLastError() );
+
+    return( CPC_FALSE );
+  }
+#else
+  INT32 result =
+    pthread_create  (
+                     &( out_thread->handle ),
+                     NULL,
+                     cahal_thread_start,
+                     out_thread
+                     );
+
+  if( 0 != result )
+  {
+    CPC_ERROR( "Could not create thread: %d.", result );
+
+    return( CPC_FALSE );
+  }
+#endif
+
+  return( CPC_TRUE );
+}
+
+void
+cahal_thread_join (
+                   cahal_thread* io_thread
+                   )
+{
+  if( NULL != io_thread )
+  {
+#if defined( _WIN32 )
+    WaitForSingleObject( io_thread->handle, INFINITE );
+
+    CloseHandle( io_thread->handle );
+#else
+    pthread_join( io_thread->handle, NULL );
+#endif
+  }
+}
+
+CPC_BOOL
+cahal_thread_set_scheduling  (
+                              const cahal_thread_scheduling* in_scheduling
+                              )
+{
+  CPC_BOOL return_value = CPC_TRUE;
+
+  if( NULL == in_scheduling )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Null thread scheduling." );
+
+    return( CPC_FALSE );
+  }
+
+#if defined( _WIN32 )
+  if( CAHAL_THREAD_POLICY_DEFAULT != in_scheduling->policy )
+  {
+    DWORD task_index = 0;
+
+    if( NULL == g_mmcss_task )
+    {
+      g_mmcss_task = AvSetMmThreadCharacteristicsA( "Pro Audio", &task_index );
+    }
+
+    if  (
+         NULL == g_mmcss_task
+         || ! AvSetMmThreadPriority (
+                    g_mmcss_task,
+                    cahal_thread_get_mmcss_priority( in_scheduling->priority )
+                                     )
+         )
+    {
+      CPC_LOG (
+               CPC_LOG_LEVEL_WARN,
+               "Could not join MMCSS task: %d.",
+               GetLastError()
+               );
+
+      return_value = CPC_FALSE;
+    }
+  }
+
+  if  (
+       0 != in_scheduling->cpu_affinity
+       && 0 == SetThreadAffinityMask  (
+                                       GetCurrentThread(),
+                                       ( DWORD_PTR ) in_scheduling->cpu_affinity
+                                       )
+       )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_WARN,
+             "Could not set CPU affinity: %d.",
+             GetLastError()
+             );
+
+    return_value = CPC_FALSE;
+  }
+#elif defined( __APPLE__ )
+  if( CAHAL_THREAD_POLICY_DEFAULT != in_scheduling->policy )
+  {
+    thread_time_constraint_policy_data_t policy;
+    mach_timebase_info_data_t timebase;
+
+    kern_return_t result  = KERN_INVALID_ARGUMENT;
+    FLOAT64 units         = 0;
+
+    mach_timebase_info( &timebase );
+
+    //  The policy is expressed in absolute time units rather than nanoseconds
+    units = 1000000000.0 * timebase.denom / timebase.numer;
+
+    policy.period       = ( uint32_t ) ( in_scheduling->period * units );
+    policy.computation  = policy.period / 2;
+    policy.constraint   = policy.period;
+    policy.preemptible  = 1;
+
+    if( 0 < policy.period )
+    {
+      result =
+        thread_policy_set (
+                           pthread_mach_thread_np( pthread_self() ),
+                           THREAD_TIME_CONSTRAINT_POLICY,
+                           ( thread_policy_t ) &policy,
+                           THREAD_TIME_CONSTRAINT_POLICY_COUNT
+                           );
+    }
+
+    if( KERN_SUCCESS != result )
+    {
+      CPC_LOG (
+               CPC_LOG_LEVEL_WARN,
+               "Could not set time-constraint policy: %d.",
+               result
+               );
+
+      return_value = CPC_FALSE;
+    }
+  }
+
+  if( 0 != in_scheduling->cpu_affinity )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_WARN, "CPU affinity is not supported." );
+
+    return_value = CPC_FALSE;
+  }
+#else
+  if( CAHAL_THREAD_POLICY_DEFAULT != in_scheduling->policy )
+  {
+    struct sched_param parameters;
+
+    INT32 policy    =
+      CAHAL_THREAD_POLICY_FIFO == in_scheduling->policy
+      ? SCHED_FIFO
+      : SCHED_RR;
+    INT32 priority  = ( INT32 ) in_scheduling->priority;
+    INT32 result    = 0;
+
+    if( sched_get_priority_min( policy ) > priority )
+    {
+      priority = sched_get_priority_min( policy );
+    }
+    else if( sched_get_priority_max( policy ) < priority )
+    {
+      priority = sched_get_priority_max( policy );
+    }
+
+    memset( &parameters, 0, sizeof( struct sched_param ) );
+
+    parameters.sched_priority = priority;
+
+    result = pthread_setschedparam( pthread_self(), policy, &parameters );
+
+    if( 0 != result )
+    {
+      CPC_LOG (
+               CPC_LOG_LEVEL_WARN,
+               "Could not set real-time policy: %d.",
+               result
+               );
+
+      return_value = CPC_FALSE;
+    }
+  }
+
+#if defined( __linux__ )
+  if( 0 != in_scheduling->cpu_affinity )
+  {
+    cpu_set_t cpus;
+
+    CPU_ZERO( &cpus );
+
+    for( UINT32 i = 0; i < 64 && i < CPU_SETSIZE; i++ )
+    {
+      if( in_scheduling->cpu_affinity & ( ( ( UINT64 ) 1 ) << i ) )
+      {
+        CPU_SET( i, &cpus );
+      }
+    }
+
+    //  A pid of 0 is the calling thread
+    if( 0 != sched_setaffinity( 0, sizeof( cpu_set_t ), &cpus ) )
+    {
+      CPC_LOG( CPC_LOG_LEVEL_WARN, "Could not set CPU affinity: %d.", errno );
+
+      return_value = CPC_FALSE;
+    }
+  }
+#else
+  if( 0 != in_scheduling->cpu_affinity )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_WARN, "CPU affinity is not supported." );
+
+    return_value = CPC_FALSE;
+  }
+#endif
+#endif
+
+  return( return_value );
+}
+
+void
+cahal_thread_reset_scheduling( void )
+{
+#if defined( _WIN32 )
+  if( NULL != g_mmcss_task )
+  {
+    AvRevertMmThreadCharacteristics( g_mmcss_task );
+
+    g_mmcss_task = NULL;
+  }
+#endif
+}
+
+void
+cahal_thread_yield( void )
+{
+#if defined( _WIN32 )
+  SwitchToThread();
+#else
+  sched_yield();
+#endif
+}
+
+CPC_BOOL
+cahal_mutex_initialize  (
+                         cahal_mutex* out_mutex
+                         )
+{
+#if defined( _WIN32 )
+  InitializeCriticalSection( out_mutex );
+
+  return( CPC_TRUE );
+#else
+  return( 0 == pthread_mutex_init( out_mutex, NULL ) );
+#endif
+}
+
+void
+cahal_mutex_destroy (
+                     cahal_mutex* io_mutex
+                     )
+{
+#if defined( _WIN32 )
+  DeleteCriticalSection( io_mutex );
+#else
+  pthread_mutex_destroy( io_mutex );
+#endif
+}
+
+void
+cahal_mutex_lock  (
+                   cahal_mutex* io_mutex
+                   )
+{
+#if defined( _WIN32 )
+  EnterCriticalSection( io_mutex );
+#else
+  pthread_mutex_lock( io_mutex );
+#endif
+}
+
+void
+cahal_mutex_unlock  (
+                     cahal_mutex* io_mutex
+                     )
+{
+#if defined( _WIN32 )
+  LeaveCriticalSection( io_mutex );
+#else
+  pthread_mutex_unlock( io_mutex );
+#endif
+}
+
+CPC_BOOL
+cahal_condition_initialize  (
+                             cahal_condition* out_condition
+                             )
+{
+#if defined( _WIN32 )
+  InitializeConditionVariable( out_condition );
+
+  return( CPC_TRUE );
+#else
+  return( 0 == pthread_cond_init( out_condition, NULL ) );
+#endif
+}
+
+void
+cahal_condition_destroy (
+                         cahal_condition* io_condition
+                         )
+{
+#if defined( _WIN32 )
+  //  Windows condition variables hold no resources.
+  ( void ) io_condition;
+#else
+  pthread_cond_destroy( io_condition );
+#endif
+}
+
+void
+cahal_condition_wait  (
+                       cahal_condition*  io_condition,
+                       cahal_mutex*      io_mutex
+                       )
+{
+#if defined( _WIN32 )
+  SleepConditionVariableCS( io_condition, io_mutex, INFINITE );
+#else
+  pthread_cond_wait( io_condition, io_mutex );
+#endif
+}
+
+void
+cahal_condition_signal  (
+                         cahal_condition* io_condition
+                         )
+{
+#if defined( _WIN32 )
+  WakeConditionVariable( io_condition );
+#else
+  pthread_cond_signal( io_condition );
+#endif
+}
+
+void
+cahal_condition_broadcast (
+                           cahal_condition* io_condition
+                           )
+{
+#if defined( _WIN32 )
+  WakeAllConditionVariable( io_condition );
+#else
+  pthread_cond_broadcast( io_condition );
+#endif
+}
+
+CPC_BOOL
+cahal_semaphore_initialize  (
+                             cahal_semaphore* out_semaphore
+                             )
+{
+#if defined( _WIN32 )
+  *out_semaphore = CreateSemaphore( NULL, 0, MAXLONG, NULL );
+
+  return( NULL != *out_semaphore );
+#elif defined( __APPLE__ )
+  return  (
+           KERN_SUCCESS
+           == semaphore_create  (
+                                 mach_task_self(),
+                                 out_semaphore,
+                                 SYNC_POLICY_FIFO,
+                                 0
+                                 )
+           );
+#else
+  return( 0 == sem_init( out_semaphore, 0, 0 ) );
+#endif
+}
+
+void
+cahal_semaphore_destroy (
+                         cahal_semaphore* io_semaphore
+                         )
+{
+#if defined( _WIN32 )
+  CloseHandle( *io_semaphore );
+#elif defined( __APPLE__ )
+  semaphore_destroy( mach_task_self(), *io_semaphore );
+#else
+  sem_destroy( io_semaphore );
+#endif
+}
+
+void
+cahal_semaphore_post  (
+                       cahal_semaphore* io_semaphore
+                       )
+{
+#if defined( _WIN32 )
+  ReleaseSemaphore( *io_semaphore, 1, NULL );
+#elif defined( __APPLE__ )
+  semaphore_signal( *io_semaphore );
+#else
+  sem_post( io_semaphore );
+#endif
+}
+
+void
+cahal_semaphore_wait  (
+                       cahal_semaphore* io_semaphore
+                       )
+{
+#if defined( _WIN32 )
+  WaitForSingleObject( *io_semaphore, INFINITE );
+#elif defined( __APPLE__ )
+  while( KERN_ABORTED == semaphore_wait( *io_semaphore ) );
+#else
+  //  Waits are interrupted by signals delivered to the thread
+  while( 0 != sem_wait( io_semaphore ) && EINTR == errno );
+#endif
+}
+
+CPC_BOOL
+cahal_call_once (
+                 cahal_atomic_uint32*  io_state,
+                 cahal_once_routine    in_routine,
+                 void*                 io_argument
+                 )
+{
+  UINT32 state = CAHAL_ATOMIC_LOAD( io_state );
+
+  if  (
+       CAHAL_ONCE_PENDING == state
+       && CAHAL_ATOMIC_COMPARE_AND_SWAP  (
+                                          io_state,
+                                          CAHAL_ONCE_PENDING,
+                                          CAHAL_ONCE_RUNNING
+                                          )
+       )
+  {
+    state = in_routine( io_argument ) ? CAHAL_ONCE_DONE : CAHAL_ONCE_FAILED;
+
+    CAHAL_ATOMIC_STORE( io_state, state );
+  }
+
+  //  The routine is expected to take long enough (e.g. querying the OS) that
+  //  yielding is cheaper than blocking on a condition variable.
+  while( CAHAL_ONCE_PENDING == state || CAHAL_ONCE_RUNNING == state )
+  {
+    cahal_thread_yield();
+
+    state = CAHAL_ATOMIC_LOAD( io_state );
+  }
+
+  return( CAHAL_ONCE_DONE == state );
+}
+
+#if defined( _WIN32 )
+static
+DWORD WINAPI
+cahal_thread_start  (
+                     LPVOID in_thread
+                     )
+#else
+static
+void*
+cahal_thread_start  (
+                     void* in_thread
+                     )
+#endif
+{
+  cahal_thread* thread = ( cahal_thread* ) in_thread;
+
+  thread->routine( thread->argument );
+
+  return( 0 );
+}
+
+#if defined( _WIN32 )
+static
+AVRT_PRIORITY
+cahal_thread_get_mmcss_priority  (
+                                  UINT32 in_priority
+                                  )
+{
+  if( 25 > in_priority )
+  {
+    return( AVRT_PRIORITY_LOW );
+  }
+  else if( 50 > in_priority )
+  {
+    return( AVRT_PRIORITY_NORMAL );
+  }
+  else if( 75 > in_priority )
+  {
+    return( AVRT_PRIORITY_HIGH );
+  }
+  else
+  {
+    return( AVRT_PRIORITY_CRITICAL );
+  }
+}
+#endif
@@ -0,0 +1,595 @@
+/*! \file   cahal_worker_pool.c
+
+    \author Brent Carrara
+ */
+#include "cahal_worker_pool.h"
+
+#include "cahal.h"
+
+/*! \fn     void cahal_worker_pool_worker  (
+              void* in_pool
+            )
+    \brief  The routine of the worker threads. Runs one job for every post of
+            work_available, taken from the worker's own queue or stolen from
+            another worker's, until the pool is freed.
+
+    \param  in_pool The pool.
+ */
+static
+void
+cahal_worker_pool_worker  (
+                           void* in_pool
+                           );
+
+/*! \fn     CPC_BOOL cahal_worker_pool_take  (
+              cahal_worker_queue* io_queue,
+              cahal_worker_job*   out_job
+            )
+    \brief  Removes the job with the earliest deadline from a queue.
+
+    \param  io_queue  The queue.
+    \param  out_job The job that was removed.
+    \return True iff the queue held a job.
+ */
+static
+CPC_BOOL
+cahal_worker_pool_take  (
+                         cahal_worker_queue* io_queue,
+                         cahal_worker_job*   out_job
+                         );
+
+/*! \fn     void cahal_worker_pool_complete  (
+              cahal_worker_pool*      io_pool,
+              const cahal_worker_job* in_job
+            )
+    \brief  Updates the statistics of the job's stream once it has run and
+            signals idle if it was the last pending job.
+
+    \param  io_pool The pool.
+    \param  in_job  The job that ran.
+ */
+static
+void
+cahal_worker_pool_complete  (
+                             cahal_worker_pool*      io_pool,
+                             const cahal_worker_job* in_job
+                             );
+
+/*! \fn     UINT32 cahal_worker_pool_get_number_of_streams  (
+              cahal_worker_pool* in_pool
+            )
+    \brief  Returns the number of streams that were added to the pool.
+
+    \param  in_pool The pool.
+    \return The number of streams, at most CAHAL_WORKER_POOL_MAXIMUM_STREAMS.
+ */
+static
+UINT32
+cahal_worker_pool_get_number_of_streams  (
+                                          cahal_worker_pool* in_pool
+                                          );
+
+/*! \fn     void cahal_worker_pool_release (
+              cahal_worker_pool* in_pool,
+              UINT32             in_number_of_queues
+            )
+    \brief  Frees a pool whose workers are not running.
+
+    \param  in_pool The pool.
+    \param  in_number_of_queues The number of queues whose lock was
+                                initialized.
+ */
+static
+void
+cahal_worker_pool_release (
+                           cahal_worker_pool* in_pool,
+                           UINT32             in_number_of_queues
+                           );
+
+cahal_worker_pool*
+cahal_worker_pool_create  (
+                           UINT32                          in_number_of_workers,
+                           const cahal_thread_scheduling*  in_scheduling
+                           )
+{
+  cahal_worker_pool* pool = NULL;
+
+  if  (
+       0 == in_number_of_workers
+       || CAHAL_WORKER_POOL_MAXIMUM_WORKERS < in_number_of_workers
+       )
+  {
+    CPC_ERROR( "Invalid number of workers: %d.", in_number_of_workers );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &pool, sizeof( cahal_worker_pool ) )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc pool." );
+
+    return( NULL );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &( pool->workers ),
+                            in_number_of_workers * sizeof( cahal_thread )
+                            )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( pool->queues ),
+                               in_number_of_workers
+                               * sizeof( cahal_worker_queue )
+                               )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc pool." );
+
+    cpc_safe_free( ( void** ) &( pool->workers ) );
+    cpc_safe_free( ( void** ) &pool );
+
+    return( NULL );
+  }
+
+  if( NULL != in_scheduling )
+  {
+    pool->scheduling = *in_scheduling;
+  }
+
+  if( ! cahal_semaphore_initialize( &( pool->work_available ) ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not initialize semaphore." );
+
+    cpc_safe_free( ( void** ) &( pool->queues ) );
+    cpc_safe_free( ( void** ) &( pool->workers ) );
+    cpc_safe_free( ( void** ) &pool );
+
+    return( NULL );
+  }
+
+  if( ! cahal_mutex_initialize( &( pool->lock ) ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not initialize lock." );
+
+    cahal_semaphore_destroy( &( pool->work_available ) );
+
+    cpc_safe_free( ( void** ) &( pool->queues ) );
+    cpc_safe_free( ( void** ) &( pool->workers ) );
+    cpc_safe_free( ( void** ) &pool );
+
+    return( NULL );
+  }
+
+  if( ! cahal_condition_initialize( &( pool->idle ) ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not initialize condition." );
+
+    cahal_mutex_destroy( &( pool->lock ) );
+    cahal_semaphore_destroy( &( pool->work_available ) );
+
+    cpc_safe_free( ( void** ) &( pool->queues ) );
+    cpc_safe_free( ( void** ) &( pool->workers ) );
+    cpc_safe_free( ( void** ) &pool );
+
+    return( NULL );
+  }
+
+  for( UINT32 i = 0; i < in_number_of_workers; i++ )
+  {
+    if( ! cahal_mutex_initialize( &( pool->queues[ i ].lock ) ) )
+    {
+      CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not initialize lock." );
+
+      cahal_worker_pool_release( pool, i );
+
+      return( NULL );
+    }
+  }
+
+  pool->number_of_workers = in_number_of_workers;
+
+  for( UINT32 i = 0; i < in_number_of_workers; i++ )
+  {
+    if  (
+         ! cahal_thread_create  (
+                                 &( pool->workers[ i ] ),
+                                 cahal_worker_pool_worker,
+                                 pool
+                                 )
+         )
+    {
+      CPC_ERROR( "Could not start worker %d.", i );
+
+      //  Only the workers that were started are joined by the free below
+      for( UINT32 j = i; j < in_number_of_workers; j++ )
+      {
+        cahal_mutex_destroy( &( pool->queues[ j ].lock ) );
+      }
+
+      pool->number_of_workers = i;
+
+      cahal_worker_pool_free( pool );
+
+      return( NULL );
+    }
+  }
+
+  return( pool );
+}
+
+UINT32
+cahal_worker_pool_add_stream  (
+                               cahal_worker_pool* io_pool,
+                               FLOAT64            in_period
+                               )
+{
+  UINT32 stream = 0;
+
+  if( NULL == io_pool || 0.0 >= in_period )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid stream parameters." );
+
+    return( CAHAL_WORKER_POOL_NO_STREAM );
+  }
+
+  stream = CAHAL_ATOMIC_ADD( &( io_pool->number_of_streams ), 1 ) - 1;
+
+  if( CAHAL_WORKER_POOL_MAXIMUM_STREAMS <= stream )
+  {
+    CPC_ERROR (
+               "Pool already has %d streams.",
+               CAHAL_WORKER_POOL_MAXIMUM_STREAMS
+               );
+
+    return( CAHAL_WORKER_POOL_NO_STREAM );
+  }
+
+  io_pool->streams[ stream ].period = ( UINT64 ) ( in_period * 1000000000.0 );
+
+  return( stream );
+}
+
+CPC_BOOL
+cahal_worker_pool_submit  (
+                           cahal_worker_pool*    io_pool,
+                           UINT32                in_stream,
+                           cahal_worker_routine  in_routine,
+                           void*                 in_argument
+                           )
+{
+  cahal_worker_queue* queue = NULL;
+  CPC_BOOL is_queued        = CPC_FALSE;
+
+  if  (
+       NULL == io_pool
+       || NULL == in_routine
+       || cahal_worker_pool_get_number_of_streams( io_pool ) <= in_stream
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Invalid job parameters." );
+
+    return( CPC_FALSE );
+  }
+
+  queue = &( io_pool->queues[ in_stream % io_pool->number_of_workers ] );
+
+  CAHAL_ATOMIC_ADD( &( io_pool->number_of_pending_jobs ), 1 );
+
+  cahal_mutex_lock( &( queue->lock ) );
+
+  if( CAHAL_WORKER_QUEUE_CAPACITY > queue->number_of_jobs )
+  {
+    cahal_worker_job* job = &( queue->jobs[ queue->number_of_jobs++ ] );
+
+    job->routine  = in_routine;
+    job->argument = in_argument;
+    job->deadline = cahal_get_time() + io_pool->streams[ in_stream ].period;
+    job->stream   = in_stream;
+
+    is_queued = CPC_TRUE;
+  }
+
+  cahal_mutex_unlock( &( queue->lock ) );
+
+  if( is_queued )
+  {
+    cahal_semaphore_post( &( io_pool->work_available ) );
+  }
+  else
+  {
+    CAHAL_ATOMIC_ADD  (
+                       &( io_pool->streams[ in_stream ].number_of_rejections ),
+                       1
+                       );
+
+    if( 0 == CAHAL_ATOMIC_ADD( &( io_pool->number_of_pending_jobs ), -1 ) )
+    {
+      cahal_mutex_lock( &( io_pool->lock ) );
+      cahal_condition_broadcast( &( io_pool->idle ) );
+      cahal_mutex_unlock( &( io_pool->lock ) );
+    }
+  }
+
+  return( is_queued );
+}
+
+void
+cahal_worker_pool_wait (
+                        cahal_worker_pool* io_pool
+                        )
+{
+  if( NULL == io_pool )
+  {
+    return;
+  }
+
+  cahal_mutex_lock( &( io_pool->lock ) );
+
+  while( 0 < CAHAL_ATOMIC_LOAD( &( io_pool->number_of_pending_jobs ) ) )
+  {
+    cahal_condition_wait( &( io_pool->idle ), &( io_pool->lock ) );
+  }
+
+  cahal_mutex_unlock( &( io_pool->lock ) );
+}
+
+CPC_BOOL
+cahal_worker_pool_get_statistics  (
+                                   cahal_worker_pool*        in_pool,
+                                   UINT32                    in_stream,
+                                   cahal_worker_statistics*  out_statistics
+                                   )
+{
+  cahal_worker_stream* stream = NULL;
+
+  if  (
+       NULL == in_pool
+       || NULL == out_statistics
+       || cahal_worker_pool_get_number_of_streams( in_pool ) <= in_stream
+       )
+  {
+    return( CPC_FALSE );
+  }
+
+  stream = &( in_pool->streams[ in_stream ] );
+
+  out_statistics->number_of_jobs        =
+    CAHAL_ATOMIC_LOAD( &( stream->number_of_jobs ) );
+  out_statistics->number_of_misses      =
+    CAHAL_ATOMIC_LOAD( &( stream->number_of_misses ) );
+  out_statistics->number_of_rejections  =
+    CAHAL_ATOMIC_LOAD( &( stream->number_of_rejections ) );
+  out_statistics->maximum_lateness      =
+    CAHAL_ATOMIC_LOAD( &( stream->maximum_lateness ) );
+
+  return( CPC_TRUE );
+}
+
+void
+cahal_worker_pool_print_statistics  (
+                                     cahal_worker_pool* in_pool
+                                     )
+{
+  cahal_worker_statistics statistics;
+  UINT32 number_of_streams = 0;
+
+  if( NULL == in_pool )
+  {
+    return;
+  }
+
+  number_of_streams = cahal_worker_pool_get_number_of_streams( in_pool );
+
+  for( UINT32 i = 0; i < number_of_streams; i++ )
+  {
+    if( cahal_worker_pool_get_statistics( in_pool, i, &statistics ) )
+    {
+      CPC_LOG (
+               CPC_LOG_LEVEL_INFO,
+               "Stream %d: %d job(s), %d deadline miss(es) (at most %.3f ms"
+               " late), %d rejected.",
+               i,
+               statistics.number_of_jobs,
+               statistics.number_of_misses,
+               statistics.maximum_lateness / 1000.0,
+               statistics.number_of_rejections
+               );
+    }
+  }
+}
+
+void
+cahal_worker_pool_free (
+                        cahal_worker_pool* in_pool
+                        )
+{
+  if( NULL == in_pool )
+  {
+    return;
+  }
+
+  cahal_worker_pool_wait( in_pool );
+
+  CAHAL_ATOMIC_STORE( &( in_pool->is_stopping ), 1 );
+
+  for( UINT32 i = 0; i < in_pool->number_of_workers; i++ )
+  {
+    cahal_semaphore_post( &( in_pool->work_available ) );
+  }
+
+  for( UINT32 i = 0; i < in_pool->number_of_workers; i++ )
+  {
+    cahal_thread_join( &( in_pool->workers[ i ] ) );
+  }
+
+  cahal_worker_pool_release( in_pool, in_pool->number_of_workers );
+}
+
+static
+void
+cahal_worker_pool_worker  (
+                           void* in_pool
+                           )
+{
+  cahal_worker_pool* pool = ( cahal_worker_pool* ) in_pool;
+  UINT32 index            =
+    CAHAL_ATOMIC_ADD( &( pool->number_of_started_workers ), 1 ) - 1;
+
+  if  (
+       CAHAL_THREAD_POLICY_DEFAULT != pool->scheduling.policy
+       || 0 != pool->scheduling.cpu_affinity
+       )
+  {
+    cahal_thread_set_scheduling( &( pool->scheduling ) );
+  }
+
+  while( CPC_TRUE )
+  {
+    cahal_worker_job job;
+    CPC_BOOL has_job = CPC_FALSE;
+
+    cahal_semaphore_wait( &( pool->work_available ) );
+
+    //  Every post stands for a queued job, but another worker may have
+    //  taken it from a queue this worker has already looked at; search
+    //  until a job is found. Workers only run out of jobs once stopping.
+    while( ! has_job && ! CAHAL_ATOMIC_LOAD( &( pool->is_stopping ) ) )
+    {
+      for( UINT32 i = 0; i < pool->number_of_workers && ! has_job; i++ )
+      {
+        UINT32 queue = ( index + i ) % pool->number_of_workers;
+
+        has_job = cahal_worker_pool_take( &( pool->queues[ queue ] ), &job );
+      }
+    }
+
+    if( ! has_job )
+    {
+      break;
+    }
+
+    job.routine( job.argument, job.deadline );
+
+    cahal_worker_pool_complete( pool, &job );
+  }
+
+  cahal_thread_reset_scheduling();
+}
+
+static
+CPC_BOOL
+cahal_worker_pool_take  (
+                         cahal_worker_queue* io_queue,
+                         cahal_worker_job*   out_job
+                         )
+{
+  UINT32 earliest = 0;
+
+  cahal_mutex_lock( &( io_queue->lock ) );
+
+  if( 0 == io_queue->number_of_jobs )
+  {
+    cahal_mutex_unlock( &( io_queue->lock ) );
+
+    return( CPC_FALSE );
+  }
+
+  for( UINT32 i = 1; i < io_queue->number_of_jobs; i++ )
+  {
+    if( io_queue->jobs[ i ].deadline < io_queue->jobs[ earliest ].deadline )
+    {
+      earliest = i;
+    }
+  }
+
+  *out_job = io_queue->jobs[ earliest ];
+
+  io_queue->jobs[ earliest ] =
+    io_queue->jobs[ --io_queue->number_of_jobs ];
+
+  cahal_mutex_unlock( &( io_queue->lock ) );
+
+  return( CPC_TRUE );
+}
+
+static
+void
+cahal_worker_pool_complete  (
+                             cahal_worker_pool*      io_pool,
+                             const cahal_worker_job* in_job
+                             )
+{
+  cahal_worker_stream* stream = &( io_pool->streams[ in_job->stream ] );
+  UINT64 now                  = cahal_get_time();
+
+  CAHAL_ATOMIC_ADD( &( stream->number_of_jobs ), 1 );
+
+  if( now > in_job->deadline )
+  {
+    UINT32 lateness = ( UINT32 ) ( ( now - in_job->deadline ) / 1000 );
+    UINT32 maximum  = CAHAL_ATOMIC_LOAD( &( stream->maximum_lateness ) );
+
+    CAHAL_ATOMIC_ADD( &( stream->number_of_misses ), 1 );
+
+    while  (
+            lateness > maximum
+            && ! CAHAL_ATOMIC_COMPARE_AND_SWAP  (
+                                                 &( stream->maximum_lateness ),
+                                                 maximum,
+                                                 lateness
+                                                 )
+            )
+    {
+      maximum = CAHAL_ATOMIC_LOAD( &( stream->maximum_lateness ) );
+    }
+  }
+
+  if( 0 == CAHAL_ATOMIC_ADD( &( io_pool->number_of_pending_jobs ), -1 ) )
+  {
+    cahal_mutex_lock( &( io_pool->lock ) );
+    cahal_condition_broadcast( &( io_pool->idle ) );
+    cahal_mutex_unlock( &( io_pool->lock ) );
+  }
+}
+
+static
+UINT32
+cahal_worker_pool_get_number_of_streams  (
+                                          cahal_worker_pool* in_pool
+                                          )
+{
+  UINT32 number_of_streams =
+    CAHAL_ATOMIC_LOAD( &( in_pool->number_of_streams ) );
+
+  return  (
+           CAHAL_WORKER_POOL_MAXIMUM_STREAMS < number_of_streams
+           ? CAHAL_WORKER_POOL_MAXIMUM_STREAMS
+           : number_of_streams
+           );
+}
+
+static
+void
+cahal_worker_pool_release (
+                           cahal_worker_pool* in_pool,
+                           UINT32             in_number_of_queues
+                           )
+{
+  for( UINT32 i = 0; i < in_number_of_queues; i++ )
+  {
+    cahal_mutex_destroy( &( in_pool->queues[ i ].lock ) );
+  }
+
+  cahal_condition_destroy( &( in_pool->idle ) );
+  cahal_mutex_destroy( &( in_pool->lock ) );
+  cahal_semaphore_destroy( &( in_pool->work_available ) );
+
+  cpc_safe_free( ( void** ) &( in_pool->queues ) );
+  cpc_safe_free( ( void** ) &( in_pool->workers ) );
+  cpc_safe_free( ( void** ) &in_pool );
+}
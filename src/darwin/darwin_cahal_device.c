@@ -7,6 +7,89 @@
 cahal_recorder_info* g_recorder_callback_info = NULL;
 cahal_playback_info* g_playback_callback_info = NULL;
 
+/*! \fn     CPC_BOOL darwin_stop_playback  (
+              CPC_BOOL in_drain
+            )
+    \brief  Stops the playback, after draining its audio queue if in_drain is
+            set. Shared by cahal_stop_playback and cahal_drain_playback.
+ 
+    \param  in_drain  True to play the enqueued buffers before stopping.
+    \return True iff playback has been stopped.
+ */
+static
+CPC_BOOL
+darwin_stop_playback  (
+                       CPC_BOOL in_drain
+                       );
+
+/*! \fn     CPC_BOOL darwin_start_playback (
+              cahal_device*            in_device,
+              cahal_audio_format_id    in_format_id,
+              UINT32                   in_number_of_channels,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              FLOAT32                  in_volume,
+              cahal_playback_callback  in_playback,
+              void*                    in_callback_user_data,
+              cahal_audio_format_flag  in_format_flags,
+              CPC_BOOL                 in_is_prepared
+            )
+    \brief  Sets up the playback and, unless in_is_prepared is set, starts
+            its audio queue. Shared by cahal_start_playback and
+            cahal_prepare_playback, whose parameters are documented there.
+ 
+    \param  in_is_prepared  True to leave the audio queue stopped and the
+                            playback paused.
+    \return True iff the playback was started (or prepared).
+ */
+static
+CPC_BOOL
+darwin_start_playback (
+                       cahal_device*            in_device,
+                       cahal_audio_format_id    in_format_id,
+                       UINT32                   in_number_of_channels,
+                       FLOAT64                  in_sample_rate,
+                       UINT32                   in_bit_depth,
+                       FLOAT32                  in_volume,
+                       cahal_playback_callback  in_playback,
+                       void*                    in_callback_user_data,
+                       cahal_audio_format_flag  in_format_flags,
+                       CPC_BOOL                 in_is_prepared
+                       );
+
+/*! \fn     CPC_BOOL darwin_start_recording  (
+              cahal_device*            in_device,
+              cahal_audio_format_id    in_format_id,
+              UINT32                   in_number_of_channels,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              cahal_recorder_callback  in_recorder,
+              void*                    in_callback_user_data,
+              cahal_audio_format_flag  in_format_flags,
+              CPC_BOOL                 in_is_prepared
+            )
+    \brief  Sets up the recording and, unless in_is_prepared is set, starts
+            its audio queue. Shared by cahal_start_recording and
+            cahal_prepare_recording, whose parameters are documented there.
+ 
+    \param  in_is_prepared  True to leave the audio queue stopped and the
+                            recording paused.
+    \return True iff the recording was started (or prepared).
+ */
+static
+CPC_BOOL
+darwin_start_recording  (
+                         cahal_device*            in_device,
+                         cahal_audio_format_id    in_format_id,
+                         UINT32                   in_number_of_channels,
+                         FLOAT64                  in_sample_rate,
+                         UINT32                   in_bit_depth,
+                         cahal_recorder_callback  in_recorder,
+                         void*                    in_callback_user_data,
+                         cahal_audio_format_flag  in_format_flags,
+                         CPC_BOOL                 in_is_prepared
+                         );
+
 static
 void
 darwin_playback_callback (
@@ -29,14 +112,21 @@ darwin_playback_callback (
   {
     UINT32 number_of_bytes              = in_buffer->mAudioDataBytesCapacity;
     cahal_playback_info* playback_info  = ( cahal_playback_info* ) in_user_data;
+    darwin_context* context             =
+      ( darwin_context* ) playback_info->platform_data;
+    
+    //  in_buffer has been played back, or is being primed and still empty,
+    //  so the buffers enqueued before it are what is played ahead of it
+    context->queued_bytes -= in_buffer->mAudioDataByteSize;
     
     if  (
-         playback_info->playback_callback  (
-                                       playback_info->playback_device,
-                                       in_buffer->mAudioData,
-                                       &number_of_bytes,
-                                       playback_info->user_data
-                                       )
+         cahal_dispatch_playback  (
+                                   playback_info,
+                                   in_buffer->mAudioData,
+                                   &number_of_bytes,
+                                   context->queued_bytes
+                                   + context->latency_bytes
+                                   )
          )
     {
       CPC_LOG (
@@ -78,9 +168,13 @@ darwin_playback_callback (
                  );
         
         CPC_PRINT_CODE( CPC_LOG_LEVEL_WARN, result );
+        
+        in_buffer->mAudioDataByteSize = 0;
       }
       else
       {
+        context->queued_bytes += in_buffer->mAudioDataByteSize;
+        
         CPC_LOG (
                  CPC_LOG_LEVEL_TRACE,
                  "Played back 0x%x bytes of data.",
@@ -161,12 +255,11 @@ darwin_recorder_callback  (
                              );
             
             if  (
-                 ! recorder_info->recording_callback (
-                                              recorder_info->recording_device,
-                                              buffer,
-                                              in_buffer->mAudioDataByteSize,
-                                              recorder_info->user_data
-                                                      )
+                 ! cahal_dispatch_recording (
+                                             recorder_info,
+                                             buffer,
+                                             in_buffer->mAudioDataByteSize
+                                             )
                  )
             {
               CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Error returning buffer." );
@@ -212,6 +305,87 @@ darwin_recorder_callback  (
   }
 }
 
+void
+darwin_aggregate_recorder_callback  (
+                      void*                                in_user_data,
+                      AudioQueueRef                        in_queue,
+                      AudioQueueBufferRef                  in_buffer,
+                      const AudioTimeStamp*                in_start_time,
+                      UINT32                               in_number_of_packets,
+                      const AudioStreamPacketDescription*  in_packet_description
+                                  )
+{
+  static mach_timebase_info_data_t timebase = { 0, 0 };
+  
+  cahal_recorder_info* recorder_info = ( cahal_recorder_info* ) in_user_data;
+  
+  if( 0 == timebase.denom )
+  {
+    mach_timebase_info( &timebase );
+  }
+  
+  if  (
+       0 < in_number_of_packets
+       && NULL == in_packet_description
+       && NULL != recorder_info
+       )
+  {
+    UINT64 record_time = 0;
+    
+    if  (
+         NULL != in_start_time
+         && ( kAudioTimeStampHostTimeValid & in_start_time->mFlags )
+         )
+    {
+      record_time =
+      in_start_time->mHostTime * timebase.numer / timebase.denom;
+    }
+    else
+    {
+      //  Without a timestamp the buffer is assumed to have just been recorded
+      record_time =
+      cahal_get_time()
+      - ( UINT64 )  (
+                     in_buffer->mAudioDataByteSize * 1000000000.0
+                     / ( cahal_get_bytes_per_sample( recorder_info->bit_depth )
+                        * recorder_info->number_of_channels
+                        * recorder_info->sample_rate )
+                     );
+    }
+    
+    if  (
+         ! cahal_aggregate_push  (
+                                  ( cahal_aggregate_member* )
+                                  recorder_info->user_data,
+                                  in_buffer->mAudioData,
+                                  in_buffer->mAudioDataByteSize,
+                                  record_time
+                                  )
+         )
+    {
+      CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Error returning buffer." );
+    }
+  }
+  else
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_WARN, "Invalid aggregate buffer." );
+  }
+  
+  OSStatus result =
+  AudioQueueEnqueueBuffer( in_queue, in_buffer, 0, NULL );
+  
+  if( result )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_WARN,
+             "Error re-enqueuing buffer: %d",
+             result
+             );
+    
+    CPC_PRINT_CODE( CPC_LOG_LEVEL_WARN, result );
+  }
+}
+
 CPC_BOOL
 cahal_start_playback  (
                        cahal_device*            in_device,
@@ -224,20 +398,98 @@ cahal_start_playback  (
                        void*                    in_callback_user_data,
                        cahal_audio_format_flag  in_format_flags
                        )
+{
+  return  (
+           darwin_start_playback (
+                                  in_device,
+                                  in_format_id,
+                                  in_number_of_channels,
+                                  in_sample_rate,
+                                  in_bit_depth,
+                                  in_volume,
+                                  in_playback,
+                                  in_callback_user_data,
+                                  in_format_flags,
+                                  CPC_FALSE
+                                  )
+           );
+}
+
+CPC_BOOL
+cahal_prepare_playback  (
+                         cahal_device*            in_device,
+                         cahal_audio_format_id    in_format_id,
+                         UINT32                   in_number_of_channels,
+                         FLOAT64                  in_sample_rate,
+                         UINT32                   in_bit_depth,
+                         FLOAT32                  in_volume,
+                         cahal_playback_callback  in_playback,
+                         void*                    in_callback_user_data,
+                         cahal_audio_format_flag  in_format_flags
+                         )
+{
+  return  (
+           darwin_start_playback (
+                                  in_device,
+                                  in_format_id,
+                                  in_number_of_channels,
+                                  in_sample_rate,
+                                  in_bit_depth,
+                                  in_volume,
+                                  in_playback,
+                                  in_callback_user_data,
+                                  in_format_flags,
+                                  CPC_TRUE
+                                  )
+           );
+}
+
+static
+CPC_BOOL
+darwin_start_playback (
+                       cahal_device*            in_device,
+                       cahal_audio_format_id    in_format_id,
+                       UINT32                   in_number_of_channels,
+                       FLOAT64                  in_sample_rate,
+                       UINT32                   in_bit_depth,
+                       FLOAT32                  in_volume,
+                       cahal_playback_callback  in_playback,
+                       void*                    in_callback_user_data,
+                       cahal_audio_format_flag  in_format_flags,
+                       CPC_BOOL                 in_is_prepared
+                       )
 {
   CPC_BOOL return_value = CPC_FALSE;
+  cahal_channel_layout channel_layout;
+  
+  if( ! cahal_stream_state_begin_start( &g_cahal_playback_state ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Playback has already started." );
+    
+    return( CPC_FALSE );
+  }
   
   if( 0.0 > in_volume || 1.0 < in_volume )
   {
     CPC_ERROR( "Volume (%.02f) must be in the range [ 0, 1 ].", in_volume );
   }
+  else if  (
+            ! cahal_get_stream_channel_layout  (
+                                                in_device,
+                                                CAHAL_DEVICE_OUTPUT_STREAM,
+                                                in_number_of_channels,
+                                                &channel_layout
+                                                )
+            )
+  {
+    CPC_ERROR( "Cannot play back %d channels.", in_number_of_channels );
+  }
   else if  (
        cahal_test_device_direction_support  (
                                              in_device,
                                              CAHAL_DEVICE_OUTPUT_STREAM
                                              )
        && CAHAL_STATE_INITIALIZED == g_cahal_state
-       && NULL == g_playback_callback_info
        )
   {
     AudioStreamBasicDescription playback_description;
@@ -257,6 +509,12 @@ cahal_start_playback  (
       g_playback_callback_info->playback_device   = in_device;
       g_playback_callback_info->playback_callback = in_playback;
       g_playback_callback_info->user_data         = in_callback_user_data;
+      g_playback_callback_info->format_id           = in_format_id;
+      g_playback_callback_info->number_of_channels  = in_number_of_channels;
+      g_playback_callback_info->channel_layout      = channel_layout;
+      g_playback_callback_info->sample_rate         = in_sample_rate;
+      g_playback_callback_info->bit_depth           = in_bit_depth;
+      g_playback_callback_info->format_flags        = in_format_flags;
       
       if  (
            CPC_ERROR_CODE_NO_ERROR
@@ -277,6 +535,47 @@ cahal_start_playback  (
                              &playback_description
                              );
         
+        if( noErr == result )
+        {
+          UINT32 bytes_per_buffer = 0;
+          
+          result =
+          darwin_compute_bytes_per_buffer  (
+                                            &playback_description,
+                                            CAHAL_QUEUE_BUFFER_DURATION,
+                                            &bytes_per_buffer
+                                            );
+          
+          if  (
+               noErr == result
+               && ! cahal_attach_playback_schedule( g_playback_callback_info )
+               )
+          {
+            CPC_LOG_STRING  (
+                             CPC_LOG_LEVEL_ERROR,
+                             "Could not schedule playback."
+                             );
+            
+            result = kAudio_MemFullError;
+          }
+          
+          if  (
+               noErr == result
+               && ! cahal_attach_playback_dispatcher  (
+                                                       g_playback_callback_info,
+                                                       bytes_per_buffer
+                                                       )
+               )
+          {
+            CPC_LOG_STRING  (
+                             CPC_LOG_LEVEL_ERROR,
+                             "Could not start dispatcher."
+                             );
+            
+            result = kAudio_MemFullError;
+          }
+        }
+        
         if( noErr == result )
         {
           CPC_LOG (
@@ -305,7 +604,14 @@ cahal_start_playback  (
             darwin_context* context =
               ( darwin_context* ) g_playback_callback_info->platform_data;
             
-            context->audio_queue = audio_queue;
+            context->audio_queue    = audio_queue;
+            context->queued_bytes   = 0;
+            context->latency_bytes  =
+              ( UINT32 )  (
+                           darwin_get_output_latency( in_device )
+                           * in_sample_rate
+                           )
+              * playback_description.mBytesPerFrame;
             
             result =
             darwin_configure_output_audio_queue_buffer (
@@ -327,7 +633,7 @@ cahal_start_playback  (
                      playback_description.mFramesPerPacket
                      );
             
-            if( noErr == result )
+            if( noErr == result && ! in_is_prepared )
             {
               result = AudioQueueStart( audio_queue, NULL );
               
@@ -357,6 +663,22 @@ cahal_start_playback  (
                );
   }
   
+  //  A failed start is released by cahal_stop_playback, as before
+  if( in_is_prepared )
+  {
+    cahal_stream_state_end_prepare  (
+                                     &g_cahal_playback_state,
+                                     NULL != g_playback_callback_info
+                                     );
+  }
+  else
+  {
+    cahal_stream_state_end_start  (
+                                   &g_cahal_playback_state,
+                                   NULL != g_playback_callback_info
+                                   );
+  }
+  
   return( return_value );
 }
 
@@ -422,27 +744,175 @@ darwin_free_context (
 
 CPC_BOOL
 cahal_stop_playback( void )
+{
+  return( darwin_stop_playback( CPC_FALSE ) );
+}
+
+CPC_BOOL
+cahal_drain_playback( void )
+{
+  return( darwin_stop_playback( CPC_TRUE ) );
+}
+
+OSStatus
+darwin_drain_context  (
+                       darwin_context* io_context
+                       )
+{
+  OSStatus result = kAudio_ParamError;
+  
+  if( NULL != io_context )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_DEBUG, "Draining audio queue..." );
+    
+    result = AudioQueueStop( io_context->audio_queue, false );
+    
+    if( noErr == result )
+    {
+      UInt32 is_running = 1;
+      UInt32 size       = sizeof( UInt32 );
+      
+      for (
+           UINT32 waited = 0;
+           noErr
+           == AudioQueueGetProperty (
+                                     io_context->audio_queue,
+                                     kAudioQueueProperty_IsRunning,
+                                     &is_running,
+                                     &size
+                                     )
+           && is_running
+           && waited < CAHAL_DRAIN_TIMEOUT;
+           waited += CAHAL_DRAIN_POLL_INTERVAL
+           )
+      {
+        cahal_sleep( CAHAL_DRAIN_POLL_INTERVAL );
+      }
+      
+      CPC_LOG_STRING( CPC_LOG_LEVEL_DEBUG, "Drained audio queue." );
+    }
+    else
+    {
+      CPC_ERROR( "Could not drain audio queue: 0x%x.", result );
+      
+      CPC_PRINT_CODE( CPC_LOG_LEVEL_ERROR, result );
+    }
+  }
+  
+  return( result );
+}
+
+CPC_BOOL
+cahal_pause_recording( void )
 {
   CPC_BOOL result = CPC_FALSE;
   
-  if  (
-       CAHAL_STATE_INITIALIZED == g_cahal_state
-       && NULL != g_playback_callback_info
-       )
+  if( cahal_stream_state_begin_pause( &g_cahal_recording_state ) )
   {
     darwin_context* context =
-    ( darwin_context* ) g_playback_callback_info->platform_data;
+      ( darwin_context* ) g_recorder_callback_info->platform_data;
     
-    if( NULL != context )
+    result = ( noErr == darwin_pause_context( context ) );
+    
+    cahal_stream_state_end_pause( &g_cahal_recording_state, result );
+  }
+  
+  return( result );
+}
+
+CPC_BOOL
+cahal_resume_recording( void )
+{
+  CPC_BOOL result = CPC_FALSE;
+  
+  if( cahal_stream_state_begin_resume( &g_cahal_recording_state ) )
+  {
+    darwin_context* context =
+      ( darwin_context* ) g_recorder_callback_info->platform_data;
+    
+    result = ( noErr == darwin_resume_context( context ) );
+    
+    cahal_stream_state_end_resume( &g_cahal_recording_state, result );
+  }
+  
+  return( result );
+}
+
+CPC_BOOL
+cahal_pause_playback( void )
+{
+  CPC_BOOL result = CPC_FALSE;
+  
+  if( cahal_stream_state_begin_pause( &g_cahal_playback_state ) )
+  {
+    darwin_context* context =
+      ( darwin_context* ) g_playback_callback_info->platform_data;
+    
+    result = ( noErr == darwin_pause_context( context ) );
+    
+    cahal_stream_state_end_pause( &g_cahal_playback_state, result );
+  }
+  
+  return( result );
+}
+
+CPC_BOOL
+cahal_resume_playback( void )
+{
+  CPC_BOOL result = CPC_FALSE;
+  
+  if( cahal_stream_state_begin_resume( &g_cahal_playback_state ) )
+  {
+    darwin_context* context =
+      ( darwin_context* ) g_playback_callback_info->platform_data;
+    
+    result = ( noErr == darwin_resume_context( context ) );
+    
+    cahal_stream_state_end_resume( &g_cahal_playback_state, result );
+  }
+  
+  return( result );
+}
+
+OSStatus
+darwin_pause_context (
+                      darwin_context* io_context
+                      )
+{
+  OSStatus result = kAudio_ParamError;
+  
+  if( NULL != io_context )
+  {
+    result = AudioQueuePause( io_context->audio_queue );
+    
+    if( result )
     {
-      darwin_free_context( context );
+      CPC_ERROR( "Could not pause audio queue: 0x%x.", result );
       
-      cpc_safe_free( ( void** ) &context );
+      CPC_PRINT_CODE( CPC_LOG_LEVEL_ERROR, result );
     }
+  }
+  
+  return( result );
+}
+
+OSStatus
+darwin_resume_context  (
+                        darwin_context* io_context
+                        )
+{
+  OSStatus result = kAudio_ParamError;
+  
+  if( NULL != io_context )
+  {
+    result = AudioQueueStart( io_context->audio_queue, NULL );
     
-    cpc_safe_free( ( void** ) &g_playback_callback_info );
-    
-    result = CPC_TRUE;
+    if( result )
+    {
+      CPC_ERROR( "Could not start audio queue: 0x%x.", result );
+      
+      CPC_PRINT_CODE( CPC_LOG_LEVEL_ERROR, result );
+    }
   }
   
   return( result );
@@ -453,10 +923,7 @@ cahal_stop_recording( void )
 {
   CPC_BOOL result = CPC_FALSE;
   
-  if  (
-       CAHAL_STATE_INITIALIZED == g_cahal_state
-       && NULL != g_recorder_callback_info
-       )
+  if( cahal_stream_state_begin_stop( &g_cahal_recording_state, NULL ) )
   {
     darwin_context* context =
       ( darwin_context* ) g_recorder_callback_info->platform_data;
@@ -468,8 +935,16 @@ cahal_stop_recording( void )
       cpc_safe_free( ( void** ) &context );
     }
     
+    cahal_stream_state_wait_for_callbacks( &g_cahal_recording_state );
+    
+    cahal_detach_recording_dispatcher( g_recorder_callback_info );
+    
+    cahal_detach_recording_coalescer( g_recorder_callback_info );
+    
     cpc_safe_free( ( void** ) &g_recorder_callback_info );
     
+    cahal_stream_state_end_stop( &g_cahal_recording_state );
+    
     result = CPC_TRUE;
   }
   
@@ -487,18 +962,92 @@ cahal_start_recording (
                        void*                    in_callback_user_data,
                        cahal_audio_format_flag  in_format_flags
                        )
+{
+  return  (
+           darwin_start_recording  (
+                                    in_device,
+                                    in_format_id,
+                                    in_number_of_channels,
+                                    in_sample_rate,
+                                    in_bit_depth,
+                                    in_recorder,
+                                    in_callback_user_data,
+                                    in_format_flags,
+                                    CPC_FALSE
+                                    )
+           );
+}
+
+CPC_BOOL
+cahal_prepare_recording (
+                         cahal_device*            in_device,
+                         cahal_audio_format_id    in_format_id,
+                         UINT32                   in_number_of_channels,
+                         FLOAT64                  in_sample_rate,
+                         UINT32                   in_bit_depth,
+                         cahal_recorder_callback  in_recorder,
+                         void*                    in_callback_user_data,
+                         cahal_audio_format_flag  in_format_flags
+                         )
+{
+  return  (
+           darwin_start_recording  (
+                                    in_device,
+                                    in_format_id,
+                                    in_number_of_channels,
+                                    in_sample_rate,
+                                    in_bit_depth,
+                                    in_recorder,
+                                    in_callback_user_data,
+                                    in_format_flags,
+                                    CPC_TRUE
+                                    )
+           );
+}
+
+static
+CPC_BOOL
+darwin_start_recording  (
+                         cahal_device*            in_device,
+                         cahal_audio_format_id    in_format_id,
+                         UINT32                   in_number_of_channels,
+                         FLOAT64                  in_sample_rate,
+                         UINT32                   in_bit_depth,
+                         cahal_recorder_callback  in_recorder,
+                         void*                    in_callback_user_data,
+                         cahal_audio_format_flag  in_format_flags,
+                         CPC_BOOL                 in_is_prepared
+                         )
 {
   CPC_BOOL return_value = CPC_FALSE;
+  cahal_channel_layout channel_layout;
   
   CPC_LOG_STRING( CPC_LOG_LEVEL_TRACE, "In start recording!" );
   
+  if( ! cahal_stream_state_begin_start( &g_cahal_recording_state ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Recording has already started." );
+    
+    return( CPC_FALSE );
+  }
+  
   if  (
+       ! cahal_get_stream_channel_layout  (
+                                           in_device,
+                                           CAHAL_DEVICE_INPUT_STREAM,
+                                           in_number_of_channels,
+                                           &channel_layout
+                                           )
+       )
+  {
+    CPC_ERROR( "Cannot record %d channels.", in_number_of_channels );
+  }
+  else if  (
        cahal_test_device_direction_support  (
                                              in_device,
                                              CAHAL_DEVICE_INPUT_STREAM
                                              )
        && CAHAL_STATE_INITIALIZED == g_cahal_state
-       && NULL == g_recorder_callback_info
        )
   {
     AudioStreamBasicDescription recorder_desciption;
@@ -515,6 +1064,12 @@ cahal_start_recording (
       g_recorder_callback_info->recording_device    = in_device;
       g_recorder_callback_info->recording_callback  = in_recorder;
       g_recorder_callback_info->user_data           = in_callback_user_data;
+      g_recorder_callback_info->format_id           = in_format_id;
+      g_recorder_callback_info->number_of_channels  = in_number_of_channels;
+      g_recorder_callback_info->channel_layout      = channel_layout;
+      g_recorder_callback_info->sample_rate         = in_sample_rate;
+      g_recorder_callback_info->bit_depth           = in_bit_depth;
+      g_recorder_callback_info->format_flags        = in_format_flags;
       
       if  (
            CPC_ERROR_CODE_NO_ERROR
@@ -535,6 +1090,50 @@ cahal_start_recording (
                              &recorder_desciption
                              );
         
+        if( noErr == result )
+        {
+          UINT32 bytes_per_buffer = 0;
+          
+          result =
+          darwin_compute_bytes_per_buffer  (
+                                            &recorder_desciption,
+                                            CAHAL_QUEUE_BUFFER_DURATION,
+                                            &bytes_per_buffer
+                                            );
+          
+          if  (
+               noErr == result
+               && ! cahal_attach_recording_coalescer  (
+                                                      g_recorder_callback_info,
+                                                      bytes_per_buffer
+                                                      )
+               )
+          {
+            CPC_LOG_STRING  (
+                             CPC_LOG_LEVEL_ERROR,
+                             "Could not start coalescer."
+                             );
+            
+            result = kAudio_MemFullError;
+          }
+          
+          if  (
+               noErr == result
+               && ! cahal_attach_recording_dispatcher (
+                                                      g_recorder_callback_info,
+                                                      bytes_per_buffer
+                                                      )
+               )
+          {
+            CPC_LOG_STRING  (
+                             CPC_LOG_LEVEL_ERROR,
+                             "Could not start dispatcher."
+                             );
+            
+            result = kAudio_MemFullError;
+          }
+        }
+        
         if( noErr == result )
         {
           AudioQueueRef audio_queue = NULL;
@@ -555,6 +1154,7 @@ cahal_start_recording (
           darwin_configure_input_audio_queue (
                                            in_device,
                                            g_recorder_callback_info,
+                                           darwin_recorder_callback,
                                            &recorder_desciption,
                                            &audio_queue
                                            );
@@ -585,7 +1185,7 @@ cahal_start_recording (
                                                      audio_queue
                                                      );
             
-            if( noErr == result )
+            if( noErr == result && ! in_is_prepared )
             {
               result = AudioQueueStart( audio_queue, NULL );
               
@@ -615,9 +1215,158 @@ cahal_start_recording (
                );
   }
   
+  //  A failed start is released by cahal_stop_recording, as before
+  if( in_is_prepared )
+  {
+    cahal_stream_state_end_prepare  (
+                                     &g_cahal_recording_state,
+                                     NULL != g_recorder_callback_info
+                                     );
+  }
+  else
+  {
+    cahal_stream_state_end_start  (
+                                   &g_cahal_recording_state,
+                                   NULL != g_recorder_callback_info
+                                   );
+  }
+  
   return( return_value );
 }
 
+CPC_BOOL
+cahal_start_aggregate_member  (
+                               cahal_aggregate_member* io_member,
+                               UINT64                  in_start_time
+                               )
+{
+  cahal_recorder_info* recorder_info  = &io_member->recorder_info;
+  darwin_context* context             = NULL;
+  AudioQueueRef audio_queue           = NULL;
+  OSStatus result                     = kAudio_ParamError;
+  AudioStreamBasicDescription recorder_desciption;
+  
+  memset( &recorder_desciption, 0, sizeof( AudioStreamBasicDescription ) );
+  
+  if  (
+       CAHAL_STATE_INITIALIZED != g_cahal_state
+       || NULL == recorder_info->recording_device
+       || ! cahal_test_device_direction_support  (
+                                         recorder_info->recording_device,
+                                         CAHAL_DEVICE_INPUT_STREAM
+                                                  )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Cannot record from member." );
+    
+    return( CPC_FALSE );
+  }
+  
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &context, sizeof( darwin_context ) )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc context." );
+    
+    return( CPC_FALSE );
+  }
+  
+  recorder_info->platform_data = context;
+  
+  result =
+  darwin_configure_asbd  (
+                          recorder_info->format_id,
+                          recorder_info->number_of_channels,
+                          recorder_info->sample_rate,
+                          recorder_info->bit_depth,
+                          recorder_info->format_flags,
+                          CAHAL_DEVICE_INPUT_STREAM,
+                          &recorder_desciption
+                          );
+  
+  if( noErr == result )
+  {
+    result =
+    darwin_configure_input_audio_queue (
+                                        recorder_info->recording_device,
+                                        recorder_info,
+                                        darwin_aggregate_recorder_callback,
+                                        &recorder_desciption,
+                                        &audio_queue
+                                        );
+    
+    context->audio_queue = audio_queue;
+  }
+  
+  if( noErr == result )
+  {
+    result =
+    darwin_configure_input_audio_queue_buffer  (
+                                                &recorder_desciption,
+                                                context,
+                                                audio_queue
+                                                );
+  }
+  
+  if( noErr == result )
+  {
+    mach_timebase_info_data_t timebase;
+    AudioTimeStamp start_time;
+    
+    mach_timebase_info( &timebase );
+    
+    memset( &start_time, 0, sizeof( AudioTimeStamp ) );
+    
+    //  All the members are started at the same host time
+    start_time.mFlags     = kAudioTimeStampHostTimeValid;
+    start_time.mHostTime  = in_start_time * timebase.denom / timebase.numer;
+    
+    result = AudioQueueStart( audio_queue, &start_time );
+    
+    if( result )
+    {
+      CPC_ERROR( "Could not start audio queue: 0x%x.", result );
+      
+      CPC_PRINT_CODE( CPC_LOG_LEVEL_ERROR, result );
+    }
+  }
+  
+  if( noErr != result )
+  {
+    if( NULL == audio_queue )
+    {
+      cpc_safe_free( ( void** ) &context );
+      
+      recorder_info->platform_data = NULL;
+    }
+    else
+    {
+      cahal_stop_aggregate_member( io_member );
+    }
+  }
+  
+  return( noErr == result );
+}
+
+void
+cahal_stop_aggregate_member (
+                             cahal_aggregate_member* io_member
+                             )
+{
+  darwin_context* context =
+  ( darwin_context* ) io_member->recorder_info.platform_data;
+  
+  if( NULL != context )
+  {
+    darwin_free_context( context );
+    
+    cpc_safe_free( ( void** ) &context );
+    
+    io_member->recorder_info.platform_data = NULL;
+  }
+}
+
 OSStatus
 darwin_configure_input_audio_queue_buffer  (
                                      AudioStreamBasicDescription* in_asbd,
@@ -871,6 +1620,15 @@ darwin_configure_output_audio_queue (
                                    );
         }
         
+        if( noErr == result )
+        {
+          result =
+          darwin_set_audio_queue_channel_layout (
+                                         *out_audio_queue,
+                                         &( in_callback_info->channel_layout )
+                                                 );
+        }
+        
         
         if( NULL != device_uid )
         {
@@ -915,6 +1673,7 @@ OSStatus
 darwin_configure_input_audio_queue (
                                  cahal_device*                 in_device,
                                  cahal_recorder_info*          in_callback_info,
+                                 AudioQueueInputCallback       in_callback,
                                  AudioStreamBasicDescription*  io_asbd,
                                  AudioQueueRef*                out_audio_queue
                                  )
@@ -926,7 +1685,7 @@ darwin_configure_input_audio_queue (
     result =
     AudioQueueNewInput  (
                          io_asbd,
-                         darwin_recorder_callback,
+                         in_callback,
                          in_callback_info,
                          NULL,
                          kCFRunLoopCommonModes,
@@ -981,12 +1740,21 @@ darwin_configure_input_audio_queue (
         UINT32 property_size = sizeof( AudioStreamBasicDescription );
         
         result =
-        AudioQueueGetProperty (
-                               *out_audio_queue,
-                               kAudioQueueProperty_StreamDescription,
-                               io_asbd,
-                               &property_size
-                               );
+        darwin_set_audio_queue_channel_layout (
+                                         *out_audio_queue,
+                                         &( in_callback_info->channel_layout )
+                                               );
+        
+        if( noErr == result )
+        {
+          result =
+          AudioQueueGetProperty (
+                                 *out_audio_queue,
+                                 kAudioQueueProperty_StreamDescription,
+                                 io_asbd,
+                                 &property_size
+                                 );
+        }
         
         if( result )
         {
@@ -1136,3 +1904,145 @@ darwin_configure_asbd  (
   return( result );
 }
 
+OSStatus
+darwin_set_audio_queue_channel_layout  (
+                                  AudioQueueRef               io_audio_queue,
+                                  const cahal_channel_layout* in_channel_layout
+                                        )
+{
+  OSStatus result             = noErr;
+  AudioChannelLayout* layout  = NULL;
+  UINT32 number_of_channels   =
+    cahal_get_channel_layout_size( in_channel_layout );
+  UINT32 layout_size          = sizeof( AudioChannelLayout );
+  
+  if( 2 >= number_of_channels )
+  {
+    return( noErr );
+  }
+  
+  if( CAHAL_CHANNEL_LAYOUT_DISCRETE == in_channel_layout->layout_type )
+  {
+    layout_size =
+      offsetof( AudioChannelLayout, mChannelDescriptions )
+      + number_of_channels * sizeof( AudioChannelDescription );
+  }
+  
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &layout, layout_size )
+       )
+  {
+    return( kAudio_MemFullError );
+  }
+  
+  if( CAHAL_CHANNEL_LAYOUT_DISCRETE == in_channel_layout->layout_type )
+  {
+    layout->mChannelLayoutTag = kAudioChannelLayoutTag_UseChannelDescriptions;
+    
+    for  (
+          UINT32 element = 0;
+          element < CAHAL_MAXIMUM_NUMBER_OF_CHANNELS;
+          element++
+          )
+    {
+      UINT32 index = cahal_get_channel_index( in_channel_layout, element );
+      
+      if( CAHAL_NO_CHANNEL != index )
+      {
+        layout->mChannelDescriptions[ index ].mChannelLabel =
+          kAudioChannelLabel_Discrete_0 + element;
+      }
+    }
+    
+    layout->mNumberChannelDescriptions = number_of_channels;
+  }
+  else
+  {
+    //  CAHAL speaker positions share the bit order of the channel bitmap
+    
+    layout->mChannelLayoutTag = kAudioChannelLayoutTag_UseChannelBitmap;
+    layout->mChannelBitmap    = ( UINT32 ) in_channel_layout->channel_mask;
+  }
+  
+  result =
+  AudioQueueSetProperty (
+                         io_audio_queue,
+                         kAudioQueueProperty_ChannelLayout,
+                         layout,
+                         layout_size
+                         );
+  
+  if( result )
+  {
+    CPC_ERROR (
+               "Error setting channel layout (0x%x) of %d channels: 0x%x",
+               kAudioQueueProperty_ChannelLayout,
+               number_of_channels,
+               result
+               );
+    
+    CPC_PRINT_CODE( CPC_LOG_LEVEL_ERROR, result );
+  }
+  
+  cpc_safe_free( ( void** ) &layout );
+  
+  return( result );
+}
+
+UINT64
+cahal_get_time( void )
+{
+  static mach_timebase_info_data_t timebase = { 0, 0 };
+  
+  if( 0 == timebase.denom )
+  {
+    mach_timebase_info( &timebase );
+  }
+  
+  return( mach_absolute_time() * timebase.numer / timebase.denom );
+}
+
+static
+CPC_BOOL
+darwin_stop_playback  (
+                       CPC_BOOL in_drain
+                       )
+{
+  CPC_BOOL result = CPC_FALSE;
+  UINT32 state    = CAHAL_STREAM_STATE_IDLE;
+  
+  if( cahal_stream_state_begin_stop( &g_cahal_playback_state, &state ) )
+  {
+    darwin_context* context =
+    ( darwin_context* ) g_playback_callback_info->platform_data;
+    
+    if( NULL != context )
+    {
+      //  The playback is stopping, so no buffer is enqueued again. A paused
+      //  queue does not play, so it is not drained.
+      if( in_drain && CAHAL_STREAM_STATE_RUNNING == state )
+      {
+        darwin_drain_context( context );
+      }
+      
+      darwin_free_context( context );
+      
+      cpc_safe_free( ( void** ) &context );
+    }
+    
+    cahal_stream_state_wait_for_callbacks( &g_cahal_playback_state );
+    
+    cahal_detach_playback_dispatcher( g_playback_callback_info );
+    
+    cahal_detach_playback_schedule( g_playback_callback_info );
+    
+    cpc_safe_free( ( void** ) &g_playback_callback_info );
+    
+    cahal_stream_state_end_stop( &g_cahal_playback_state );
+    
+    result = CPC_TRUE;
+  }
+  
+  return( result );
+}
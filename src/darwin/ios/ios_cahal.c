@@ -7,11 +7,18 @@
 void
 cahal_initialize( void )
 {
+  UINT32 stage = cahal_profile_begin( "cahal_initialize" );
+  UINT32 step  = CAHAL_PROFILE_NO_STAGE;
+  
   switch( g_cahal_state )
   {
     case CAHAL_STATE_NOT_INITIALIZED:
+      step = cahal_profile_begin( "ios_initialize_recording" );
+      
       ios_initialize_recording();
       
+      cahal_profile_end( step );
+      
       g_cahal_state = CAHAL_STATE_INITIALIZED;
       
       break;
@@ -23,6 +30,8 @@ cahal_initialize( void )
                        );
       break;
   }
+  
+  cahal_profile_end( stage );
 }
 
 void
@@ -42,47 +51,52 @@ cahal_terminate( void )
                        );
       break;
     case CAHAL_STATE_INITIALIZED:
-      ios_terminate_recording();
-      
-      g_cahal_state = CAHAL_STATE_TERMINATED;
+      if  (
+           CAHAL_ATOMIC_COMPARE_AND_SWAP  (
+                                           &g_cahal_state,
+                                           CAHAL_STATE_INITIALIZED,
+                                           CAHAL_STATE_TERMINATED
+                                           )
+           )
+      {
+        //  Queued starts and stops run before the streams are stopped
+        cahal_async_terminate();
+        
+        cahal_stop_recording();
+        cahal_stop_playback();
+        
+        ios_terminate_recording();
+      }
       
       break;
   }
 }
 
 cahal_device**
-cahal_get_device_list( void )
+cahal_query_device_list (
+                         cahal_device_list_callback  in_callback,
+                         void*                       in_user_data
+                         )
 {
-  cahal_device** device_list = NULL;
+  UINT32 stage               =
+    cahal_profile_begin( "ios_set_cahal_device_struct" );
+  cahal_device** device_list = ios_set_cahal_device_struct();
   
-  if( CAHAL_STATE_INITIALIZED == g_cahal_state )
-  {
-    if( NULL == g_device_list )
-    {
-      g_device_list = ios_set_cahal_device_struct();
-      
-      CPC_LOG (
-               CPC_LOG_LEVEL_DEBUG,
-               "Generated device list: 0x%x.",
-               g_device_list
-               );
-    }
-    else
-    {
-      CPC_LOG (
-               CPC_LOG_LEVEL_DEBUG,
-               "Returning existing device list: 0x%x.",
-               g_device_list
-               );
-    }
-    
-    device_list = g_device_list;
-  }
-  else
+  cahal_profile_end( stage );
+  
+  //  Formats come from fixed tables rather than being probed, so the whole
+  //  list is ready at once.
+  for (
+       UINT32 device_index = 0;
+       NULL != in_callback
+       && NULL != device_list
+       && NULL != device_list[ device_index ];
+       device_index++
+       )
   {
-    CPC_ERROR( "CAHAL has not been initialized: %d.", g_cahal_state );
+    in_callback( device_list[ device_index ], in_user_data );
   }
-
+  
   return( device_list );
 }
 void
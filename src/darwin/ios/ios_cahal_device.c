@@ -3,6 +3,7 @@
     \author Brent Carrara
  */
 #include "darwin/ios/ios_cahal_device.h"
+#include "darwin/darwin_cahal_device.h"
 
 cahal_device**
 ios_set_cahal_device_struct( void )
@@ -439,6 +440,31 @@ ios_get_device_property_value (
 }
 
 
+FLOAT64
+darwin_get_output_latency  (
+                            cahal_device* in_device
+                            )
+{
+  Float32 latency       = 0;
+  UINT32 property_size  = sizeof( Float32 );
+  
+  ( void ) in_device;
+  
+  //  The audio session only knows the route, which is the output device
+  if  (
+       ios_get_device_property_value  (
+                             kAudioSessionProperty_CurrentHardwareOutputLatency,
+                             &property_size,
+                             &latency
+                                       )
+       )
+  {
+    latency = 0;
+  }
+  
+  return( latency );
+}
+
 void
 cahal_sleep (
              UINT32 in_sleep_time
@@ -188,6 +188,11 @@ ios_add_format_description  (
     description->sample_rate_range.minimum_rate = in_sample_rate;
     description->sample_rate_range.maximum_rate = in_sample_rate;
     
+    cahal_get_default_channel_layout  (
+                                       in_num_channels,
+                                       &( description->channel_layout )
+                                       );
+    
     result =
     cpc_safe_realloc(
                      ( void** )&( io_device_stream->supported_formats ),
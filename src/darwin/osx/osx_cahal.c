@@ -4,14 +4,48 @@
  */
 #include "darwin/osx/osx_cahal.h"
 
+/*! \var    g_osx_device_change_properties
+    \brief  The properties of the system object that osx_device_change_listener
+            listens to.
+ */
+static const AudioObjectPropertyAddress g_osx_device_change_properties[] =
+{
+  {
+    kAudioHardwarePropertyDevices,
+    kAudioObjectPropertyScopeGlobal,
+    kAudioObjectPropertyElementMaster
+  },
+  {
+    kAudioHardwarePropertyDefaultInputDevice,
+    kAudioObjectPropertyScopeGlobal,
+    kAudioObjectPropertyElementMaster
+  },
+  {
+    kAudioHardwarePropertyDefaultOutputDevice,
+    kAudioObjectPropertyScopeGlobal,
+    kAudioObjectPropertyElementMaster
+  }
+};
+
+/*! \def    OSX_NUMBER_OF_DEVICE_CHANGE_PROPERTIES
+    \brief  The number of elements of g_osx_device_change_properties.
+ */
+#define OSX_NUMBER_OF_DEVICE_CHANGE_PROPERTIES                               \
+  ( sizeof( g_osx_device_change_properties )                                \
+    / sizeof( AudioObjectPropertyAddress ) )
+
 void
 cahal_initialize( void )
 {
+  UINT32 stage = cahal_profile_begin( "cahal_initialize" );
+  
   switch( g_cahal_state )
   {
     case CAHAL_STATE_NOT_INITIALIZED:
       g_cahal_state = CAHAL_STATE_INITIALIZED;
       
+      osx_add_device_change_listeners();
+      
       break;
     case CAHAL_STATE_INITIALIZED:
     case CAHAL_STATE_TERMINATED:
@@ -21,6 +55,8 @@ cahal_initialize( void )
                        );
       break;
   }
+  
+  cahal_profile_end( stage );
 }
 
 void
@@ -38,46 +74,122 @@ cahal_terminate( void )
                        );
       break;
     case CAHAL_STATE_INITIALIZED:
-      g_cahal_state = CAHAL_STATE_TERMINATED;
+      if  (
+           CAHAL_ATOMIC_COMPARE_AND_SWAP  (
+                                           &g_cahal_state,
+                                           CAHAL_STATE_INITIALIZED,
+                                           CAHAL_STATE_TERMINATED
+                                           )
+           )
+      {
+        //  Without the listeners no more refreshes are queued, and those
+        //  already queued run before the control thread stops
+        osx_remove_device_change_listeners();
+        
+        //  Queued starts and stops run before the streams are stopped
+        cahal_async_terminate();
+        
+        cahal_stop_recording();
+        cahal_stop_playback();
+      }
       
       break;
   }
 }
 
 cahal_device**
-cahal_get_device_list( void )
+cahal_query_device_list (
+                         cahal_device_list_callback  in_callback,
+                         void*                       in_user_data
+                         )
 {
-  cahal_device** device_list = NULL;
+  cahal_device** device_list = osx_get_device_list();
   
-  if( CAHAL_STATE_INITIALIZED == g_cahal_state )
+  //  Formats are read from Core Audio properties rather than probed, so the
+  //  whole list is ready at once.
+  for (
+       UINT32 device_index = 0;
+       NULL != in_callback
+       && NULL != device_list
+       && NULL != device_list[ device_index ];
+       device_index++
+       )
   {
-    if( NULL == g_device_list )
+    in_callback( device_list[ device_index ], in_user_data );
+  }
+  
+  return( device_list );
+}
+
+void
+osx_add_device_change_listeners( void )
+{
+  for( UINT32 i = 0; i < OSX_NUMBER_OF_DEVICE_CHANGE_PROPERTIES; i++ )
+  {
+    OSStatus result =
+    AudioObjectAddPropertyListener  (
+                                     kAudioObjectSystemObject,
+                                     &g_osx_device_change_properties[ i ],
+                                     osx_device_change_listener,
+                                     NULL
+                                     );
+    
+    if( result )
     {
-      g_device_list = osx_get_device_list();
+      CPC_ERROR (
+                 "Error in AudioObjectAddPropertyListener: %d",
+                 result
+                 );
       
-      CPC_LOG (
-               CPC_LOG_LEVEL_DEBUG,
-               "Generated device list: 0x%x.",
-               g_device_list
-               );
-    }
-    else
-    {
-      CPC_LOG (
-               CPC_LOG_LEVEL_DEBUG,
-               "Returning existing device list: 0x%x.",
-               g_device_list
-               );
+      CPC_PRINT_CODE( CPC_LOG_LEVEL_ERROR, result );
     }
-    
-    device_list = g_device_list;
   }
-  else
+}
+
+void
+osx_remove_device_change_listeners( void )
+{
+  for( UINT32 i = 0; i < OSX_NUMBER_OF_DEVICE_CHANGE_PROPERTIES; i++ )
   {
-    CPC_ERROR( "CAHAL has not been initialized: %d.", g_cahal_state );
+    OSStatus result =
+    AudioObjectRemovePropertyListener  (
+                                        kAudioObjectSystemObject,
+                                        &g_osx_device_change_properties[ i ],
+                                        osx_device_change_listener,
+                                        NULL
+                                        );
+    
+    if( result )
+    {
+      CPC_ERROR (
+                 "Error in AudioObjectRemovePropertyListener: %d",
+                 result
+                 );
+      
+      CPC_PRINT_CODE( CPC_LOG_LEVEL_ERROR, result );
+    }
   }
+}
+
+OSStatus
+osx_device_change_listener  (
+                    AudioObjectID                      in_object,
+                    UINT32                             in_number_of_addresses,
+                    const AudioObjectPropertyAddress*  in_addresses,
+                    void*                              in_user_data
+                             )
+{
+  CPC_LOG (
+           CPC_LOG_LEVEL_DEBUG,
+           "%d device properties changed.",
+           in_number_of_addresses
+           );
   
-  return( device_list );
+  //  Querying the devices from the HAL's notification thread would hold it
+  //  up, so the query runs on the control thread
+  cahal_schedule_device_list_refresh();
+  
+  return( noErr );
 }
 
 cahal_device**
@@ -86,9 +198,17 @@ osx_get_device_list( void )
   AudioObjectID* device_ids   = NULL;
   cahal_device** device_list  = NULL;
   UINT32 num_devices          = 0;
+  UINT32 stage                =
+    cahal_profile_begin( "osx_get_audio_device_handles" );
+  OSStatus result             =
+    osx_get_audio_device_handles( &device_ids, &num_devices );
+  
+  cahal_profile_end( stage );
 
-  if( noErr == osx_get_audio_device_handles( &device_ids, &num_devices ) )
+  if( noErr == result )
   {
+    stage = cahal_profile_begin( "osx_set_cahal_device_struct" );
+    
     CPC_LOG_BUFFER  (
                      CPC_LOG_LEVEL_TRACE,
                      "ObjectIDs",
@@ -142,6 +262,8 @@ osx_get_device_list( void )
         }
       }
     }
+    
+    cahal_profile_end( stage );
   }
   
   cpc_safe_free( ( void** ) &device_ids );
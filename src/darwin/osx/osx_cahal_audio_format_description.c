@@ -58,6 +58,11 @@ osx_set_cahal_audio_format_description_list  (
             io_device_stream->supported_formats[ i ]->number_of_channels =
             stream_description_list[ i ].mFormat.mChannelsPerFrame;
             
+            cahal_get_default_channel_layout  (
+                  stream_description_list[ i ].mFormat.mChannelsPerFrame,
+                  &( io_device_stream->supported_formats[ i ]->channel_layout )
+                                               );
+            
             if( kAudioStreamAnyRate ==
                stream_description_list[ i ].mFormat.mSampleRate
                )
@@ -4,6 +4,7 @@
     \author Brent Carrara
  */
 #include "darwin/osx/osx_cahal_device.h"
+#include "darwin/darwin_cahal_device.h"
 
 void
 osx_set_cahal_device_struct(
@@ -28,6 +29,47 @@ osx_set_cahal_device_struct(
              );
   }
   
+  if( osx_get_device_string_property (
+                                      io_device->handle,
+                                      kAudioDevicePropertyDeviceUID,
+                                      &io_device->device_uid
+                                      )
+     )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_WARN,
+             "Could not read device UID proprety (0x%x)",
+             kAudioDevicePropertyDeviceUID
+             );
+  }
+  
+  if( osx_get_device_streams( io_device ) )
+  {
+    CPC_LOG (
+             CPC_LOG_LEVEL_WARN,
+             "Could not read available streams (0x%x)",
+             kAudioDevicePropertyStreams
+             );
+  }
+  
+  if( g_cahal_lazy_device_details )
+  {
+    io_device->details_loader = osx_load_cahal_device_details;
+    io_device->details_state  = CAHAL_ONCE_PENDING;
+  }
+  else
+  {
+    osx_load_cahal_device_details( io_device );
+  }
+}
+
+CPC_BOOL
+osx_load_cahal_device_details(
+                              cahal_device* io_device
+                              )
+{
+  CPC_BOOL result = CPC_TRUE;
+  
   if( osx_get_device_string_property (
                                       io_device->handle,
                                       kAudioObjectPropertyModelName,
@@ -40,6 +82,8 @@ osx_set_cahal_device_struct(
              "Could not read model proprety (0x%x)",
              kAudioObjectPropertyModelName
              );
+    
+    result = CPC_FALSE;
   }
   
   if( osx_get_device_string_property (
@@ -54,6 +98,8 @@ osx_set_cahal_device_struct(
              "Could not read manufacturer proprety (0x%x)",
              kAudioObjectPropertyManufacturer
              );
+    
+    result = CPC_FALSE;
   }
   
   if( osx_get_device_string_property (
@@ -68,6 +114,8 @@ osx_set_cahal_device_struct(
              "Could not read serial number proprety (0x%x)",
              kAudioObjectPropertySerialNumber
              );
+    
+    result = CPC_FALSE;
   }
   
   if( osx_get_device_string_property (
@@ -82,20 +130,8 @@ osx_set_cahal_device_struct(
              "Could not read firmware version proprety (0x%x)",
              kAudioObjectPropertyFirmwareVersion
              );
-  }
-  
-  if( osx_get_device_string_property (
-                                      io_device->handle,
-                                      kAudioDevicePropertyDeviceUID,
-                                      &io_device->device_uid
-                                      )
-     )
-  {
-    CPC_LOG (
-             CPC_LOG_LEVEL_WARN,
-             "Could not read device UID proprety (0x%x)",
-             kAudioDevicePropertyDeviceUID
-             );
+    
+    result = CPC_FALSE;
   }
   
   if( osx_get_device_string_property (
@@ -110,6 +146,8 @@ osx_set_cahal_device_struct(
              "Could not read model UID proprety (0x%x)",
              kAudioDevicePropertyModelUID
              );
+    
+    result = CPC_FALSE;
   }
   
   if( osx_get_device_float64_property (
@@ -124,6 +162,8 @@ osx_set_cahal_device_struct(
              "Could not read nominal sample rate proprety (0x%x)",
              kAudioDevicePropertyNominalSampleRate
              );
+    
+    result = CPC_FALSE;
   }
   
   if( osx_get_device_uint32_property (
@@ -138,6 +178,8 @@ osx_set_cahal_device_struct(
              "Could not read is alive flag (0x%x)",
              kAudioDevicePropertyDeviceIsAlive
              );
+    
+    result = CPC_FALSE;
   }
   
   if( osx_get_device_uint32_property (
@@ -152,6 +194,8 @@ osx_set_cahal_device_struct(
              "Could not read is running flag (0x%x)",
              kAudioDevicePropertyDeviceIsRunning
              );
+    
+    result = CPC_FALSE;
   }
   
   if( osx_get_device_supported_sample_rates( io_device ) )
@@ -161,15 +205,8 @@ osx_set_cahal_device_struct(
              "Could not read available sample rates proprety (0x%x)",
              kAudioDevicePropertyAvailableNominalSampleRates
              );
-  }
-  
-  if( osx_get_device_streams( io_device ) )
-  {
-    CPC_LOG (
-             CPC_LOG_LEVEL_WARN,
-             "Could not read available streams (0x%x)",
-             kAudioDevicePropertyStreams
-             );
+    
+    result = CPC_FALSE;
   }
   
   if( osx_get_number_of_channels( io_device ) )
@@ -179,7 +216,36 @@ osx_set_cahal_device_struct(
              "Could not read number of channels (0x%x)",
              kAudioDevicePropertyPreferredChannelLayout
              );
+    
+    result = CPC_FALSE;
   }
+  
+  for (
+       UINT32 i = 0;
+       NULL != io_device->device_streams
+       && NULL != io_device->device_streams[ i ];
+       i++
+       )
+  {
+    //  Enumerated streams only have a handle and a direction.
+    if  (
+         NULL == io_device->device_streams[ i ]->supported_formats
+         && osx_get_device_stream_supported_formats  (
+                                                io_device->device_streams[ i ]
+                                                      )
+         )
+    {
+      CPC_LOG (
+               CPC_LOG_LEVEL_WARN,
+               "Could not get stream's physical formats (0x%x)",
+               kAudioStreamPropertyPhysicalFormat
+               );
+      
+      result = CPC_FALSE;
+    }
+  }
+  
+  return( result );
 }
 
 OSStatus
@@ -187,43 +253,45 @@ osx_get_number_of_channels  (
                              cahal_device* io_device
                              )
 {
-  AudioChannelLayout layout_property;
-  
-  UINT32 property_size = sizeof( AudioChannelLayout );
+  AudioChannelLayout* layout_property = NULL;
+  UINT32 property_size                = 0;
   
   io_device->preferred_number_of_channels = 0;
   
+  //  The layout is variable length: devices with more channels than fit the
+  //  bitmap (e.g. mic arrays) list one description per channel
+  
   OSStatus result =
-  osx_get_device_property_value (
+  osx_get_device_property_size_and_value  (
                                  io_device->handle,
                                  kAudioDevicePropertyPreferredChannelLayout,
-                                 property_size,
-                                 &layout_property
-                                 );
+                                 &property_size,
+                                 ( void** ) &layout_property
+                                           );
   
   if( noErr == result )
   {
     CPC_LOG (
              CPC_LOG_LEVEL_TRACE,
              "Channel layout tag: 0x%x.",
-             layout_property.mChannelLayoutTag
+             layout_property->mChannelLayoutTag
              );
     
-    if( layout_property.mChannelLayoutTag ==
+    if( layout_property->mChannelLayoutTag ==
        kAudioChannelLayoutTag_UseChannelDescriptions )
     {
       io_device->preferred_number_of_channels =
-      layout_property.mNumberChannelDescriptions;
+      layout_property->mNumberChannelDescriptions;
     }
-    else if(  layout_property.mChannelLayoutTag !=
+    else if(  layout_property->mChannelLayoutTag ==
             kAudioChannelLayoutTag_UseChannelBitmap )
     {
       //  Count the number of bits in the bit map to determine the number of
       //  channels
       
-      UINT32 channel_bitmap = layout_property.mChannelBitmap;
+      UINT32 channel_bitmap = layout_property->mChannelBitmap;
       
-      for( UINT32 i = 0; i < sizeof( UINT32 ); i++ )
+      while( 0 != channel_bitmap )
       {
         if( channel_bitmap & 0x0001 )
         {
@@ -237,7 +305,7 @@ osx_get_number_of_channels  (
     {
       io_device->preferred_number_of_channels =
       AudioChannelLayoutTag_GetNumberOfChannels (
-                                               layout_property.mChannelLayoutTag
+                                             layout_property->mChannelLayoutTag
                                                  );
     }
   }
@@ -268,6 +336,11 @@ osx_get_number_of_channels  (
     }
   }
   
+  if( NULL != layout_property )
+  {
+    cpc_safe_free( ( void** ) &layout_property );
+  }
+  
   return( result );
 }
 
@@ -572,6 +645,71 @@ osx_get_device_string_property  (
   return( result );
 }
 
+FLOAT64
+darwin_get_output_latency  (
+                            cahal_device* in_device
+                            )
+{
+  UINT32 latency        = 0;
+  UINT32 safety_offset  = 0;
+  UINT32 property_size  = sizeof( UINT32 );
+  FLOAT64 sample_rate   = 0;
+  
+  AudioObjectPropertyAddress property_address =
+  {
+    kAudioDevicePropertyLatency,
+    kAudioDevicePropertyScopeOutput,
+    kAudioObjectPropertyElementMaster
+  };
+  
+  if  (
+       NULL == in_device
+       || osx_get_device_float64_property (
+                                         in_device->handle,
+                                         kAudioDevicePropertyNominalSampleRate,
+                                         &sample_rate
+                                           )
+       || 0 >= sample_rate
+       )
+  {
+    return( 0 );
+  }
+  
+  //  Both are in frames of the output scope, and missing on some devices
+  if  (
+       AudioObjectGetPropertyData  (
+                                    in_device->handle,
+                                    &property_address,
+                                    0,
+                                    NULL,
+                                    &property_size,
+                                    &latency
+                                    )
+       )
+  {
+    latency = 0;
+  }
+  
+  property_address.mSelector  = kAudioDevicePropertySafetyOffset;
+  property_size               = sizeof( UINT32 );
+  
+  if  (
+       AudioObjectGetPropertyData  (
+                                    in_device->handle,
+                                    &property_address,
+                                    0,
+                                    NULL,
+                                    &property_size,
+                                    &safety_offset
+                                    )
+       )
+  {
+    safety_offset = 0;
+  }
+  
+  return( ( latency + safety_offset ) / sample_rate );
+}
+
 void
 cahal_sleep (
              UINT32 in_sleep_time
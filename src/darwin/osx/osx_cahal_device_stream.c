@@ -28,15 +28,6 @@ osx_set_cahal_device_stream_struct(
                kAudioStreamPropertyDirection
                );
     }
-    
-    if( osx_get_device_stream_supported_formats( io_device_stream ) )
-    {
-      CPC_LOG (
-               CPC_LOG_LEVEL_WARN,
-               "Could not get stream's physical formats (0x%x)",
-               kAudioStreamPropertyPhysicalFormat
-               );
-    }
   }
   else
   {
@@ -16,6 +16,8 @@
 
 #include "cahal.h"
 
+#include "cahal_probe_scheduler.h"
+
 #include "android_cahal_audio_format_description.h"
 
 /*! \def    ANDROID_DEVICE_HANDLE_OUTPUT
@@ -252,39 +254,42 @@ android_init_and_test_input_configuration (
                                     );
 
 /*! \fn     cpc_error_code android_set_output_device (
-              cahal_device*** io_device_list,
-              UINT32*         io_num_devices
+              cahal_probe_scheduler*  io_scheduler,
+              cahal_prober*           in_prober
                           )
-    \brief  Collect the list of supported output audio configurations and adds
-            them to the list.
-
-    \param  io_device_list  The list to add any supported audio devices to.
-    \param  io_num_devices The updated number of supported devices.
-    \return NO_ERROR if the structures have been configured, an error code
-            otherwise.
+    \brief  Queues the probing of the supported output audio configurations on
+            io_scheduler. The configurations are read from the probe cache of
+            io_scheduler when the device fingerprint matches and probed (and
+            cached) otherwise. The device is published by io_scheduler iff it
+            supports at least one configuration.
+
+    \param  io_scheduler  The scheduler to queue the output device on.
+    \param  in_prober The prober of output configurations. Must not be freed
+                      until io_scheduler is done.
+    \return NO_ERROR if the device has been queued, an error code otherwise.
  */
 cpc_error_code
 android_set_output_device (
-    cahal_device*** io_device_list,
-    UINT32*         io_num_devices
+    cahal_probe_scheduler*  io_scheduler,
+    cahal_prober*           in_prober
                           );
 
 /*! \fn     cpc_error_code android_set_input_devices (
-              cahal_device*** io_device_list,
-              UINT32*         io_num_devices
+              cahal_probe_scheduler*  io_scheduler,
+              cahal_prober*           in_prober
                           )
-    \brief  Collect the list of supported input audio configurations and adds
-            them to the list.
+    \brief  Queues the probing of the supported input audio configurations of
+            every input preset on io_scheduler. See android_set_output_device.
 
-    \param  io_device_list  The list to add any supported audio devices to.
-    \param  io_num_devices The updated number of supported devices.
-    \return NO_ERROR if the structures have been configured, an error code
-            otherwise.
+    \param  io_scheduler  The scheduler to queue the input devices on.
+    \param  in_prober The prober of input configurations. Must not be freed
+                      until io_scheduler is done.
+    \return NO_ERROR if the devices have been queued, an error code otherwise.
  */
 cpc_error_code
 android_set_input_devices (
-    cahal_device*** io_device_list,
-    UINT32*         io_num_devices
+    cahal_probe_scheduler*  io_scheduler,
+    cahal_prober*           in_prober
                           );
 
 /*! \fn     cpc_error_code android_add_device_to_list  (
@@ -13,6 +13,7 @@
 #include <cpcommon.h>
 
 #include "cahal.h"
+#include "cahal_callback.h"
 
 #include "android_cahal.h"
 
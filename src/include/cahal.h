@@ -15,6 +15,30 @@
 #include "cahal_device_stream.h"
 #include "cahal_audio_format_flags.h"
 #include "cahal_audio_format_description.h"
+#include "cahal_audio_convert.h"
+#include "cahal_drift_resampler.h"
+#include "cahal_echo_canceller.h"
+#include "cahal_signal_generator.h"
+#include "cahal_filter_bank.h"
+#include "cahal_graph.h"
+#include "cahal_probe_cache.h"
+#include "cahal_probe.h"
+#include "cahal_thread.h"
+#include "cahal_probe_scheduler.h"
+#include "cahal_arena.h"
+#include "cahal_device_snapshot.h"
+#include "cahal_format_negotiation.h"
+#include "cahal_device_index.h"
+#include "cahal_device_serialization.h"
+#include "cahal_profile.h"
+#include "cahal_dispatcher.h"
+#include "cahal_worker_pool.h"
+#include "cahal_stream_state.h"
+#include "cahal_async.h"
+#include "cahal_coalescer.h"
+#include "cahal_pollable.h"
+#include "cahal_playback_schedule.h"
+#include "cahal_aggregate.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -50,9 +74,11 @@ enum cahal_states
 };
 
 /*! \var    cahal_state
- *  \brief  The global CAHAL library state variable
+ *  \brief  The global CAHAL library state variable. It is atomic so that
+ *          terminate can race the other entry points: exactly one caller
+ *          moves it to CAHAL_STATE_TERMINATED.
  */
-typedef UINT32 cahal_state;
+typedef cahal_atomic_uint32 cahal_state;
 
 /*! \var    g_cahal_state
  *  \brief  This is the global state of the CAHAL library. This value should
@@ -114,6 +140,16 @@ cahal_sleep (
     UINT32 in_sleep_time
             );
 
+/*! \fn     UINT64 cahal_get_time( void )
+    \brief  Platform-specific call to read a monotonic clock. The times passed
+            between the recording and playback paths (e.g. to align the echo
+            canceller reference) are all read from this clock.
+
+    \return The current time in nanoseconds. The origin is unspecified.
+ */
+UINT64
+cahal_get_time( void );
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,1291 @@
+/*! \file   cahal.hpp
+    \brief  Optional header-only C++20 layer over the C API, for C++ services
+            that would otherwise wrap cahal_recorder_callback and its void*
+            user data by hand.
+
+            - cahal::Session initializes the library. It never terminates
+              it, as the C API cannot be initialized again afterwards.
+            - cahal::Recording and cahal::Playback start a stream when they
+              are constructed and stop it when they are destroyed. Their
+              callbacks receive std::span of samples of type T and are
+              called without type erasure, so they can be inlined into the
+              callback of the OS thread.
+            - cahal::Stream records into a ring buffer maintained by the
+              wrapper and is read with co_await stream.read( frames ).
+            - cahal::Platform starts and stops the streams through the C
+              API. Tests substitute their own, see test_cahal_hpp.cpp.
+
+            The type of the samples (int16_t, int32_t or float) is a template
+            parameter: sample_traits selects the format requested from the OS
+            and, where it differs from T, the conversion, which is inlined.
+            Floating point samples are recorded and played back as 32-bit
+            integers, like int32_t samples, and converted, which keeps the
+            full precision of a float.
+
+            Objects that stream are movable, not copyable. The state the OS
+            thread uses is allocated once and never moves, so moving an
+            object while it streams is safe. Only one recording and one
+            playback can run at a time, as in the C API. Errors are reported
+            the way the C API reports them: is_running returns false and the
+            reason is logged. The only exception is a Session constructed
+            after cahal_terminate, which throws.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_HPP__
+#define __CAHAL_HPP__
+
+#if __cplusplus < 202002L
+#error "cahal.hpp requires C++20."
+#endif
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cahal.h"
+
+namespace cahal
+{
+
+/*! \var    stream_buffer_duration
+    \brief  The amount of audio (in seconds) a read of a Stream can request
+            by default. The ring holds one OS buffer more.
+ */
+inline constexpr FLOAT64 stream_buffer_duration = 0.5;
+
+/*! \var    sample_traits
+    \brief  The format a sample type is recorded and played back in.
+            Specialised for int16_t, int32_t and float. Every specialisation
+            defines device_sample, the type of the samples exchanged with the
+            OS, their bit_depth and format_flags, and from_device / to_device
+            to convert a single sample.
+ */
+template< typename T >
+struct sample_traits;
+
+template<>
+struct sample_traits< int16_t >
+{
+  using device_sample = int16_t;
+
+  static constexpr UINT32 bit_depth                   = 16;
+  static constexpr cahal_audio_format_flag format_flags =
+    CAHAL_AUDIO_FORMAT_FLAGISSIGNEDINTEGER | CAHAL_AUDIO_FORMAT_FLAGISPACKED;
+
+  static int16_t from_device( device_sample in_sample )
+  {
+    return( in_sample );
+  }
+
+  static device_sample to_device( int16_t in_sample )
+  {
+    return( in_sample );
+  }
+};
+
+template<>
+struct sample_traits< int32_t >
+{
+  using device_sample = int32_t;
+
+  static constexpr UINT32 bit_depth                   = 32;
+  static constexpr cahal_audio_format_flag format_flags =
+    CAHAL_AUDIO_FORMAT_FLAGISSIGNEDINTEGER | CAHAL_AUDIO_FORMAT_FLAGISPACKED;
+
+  static int32_t from_device( device_sample in_sample )
+  {
+    return( in_sample );
+  }
+
+  static device_sample to_device( int32_t in_sample )
+  {
+    return( in_sample );
+  }
+};
+
+template<>
+struct sample_traits< float >
+{
+  using device_sample = int32_t;
+
+  static constexpr UINT32 bit_depth                   = 32;
+  static constexpr cahal_audio_format_flag format_flags =
+    CAHAL_AUDIO_FORMAT_FLAGISSIGNEDINTEGER | CAHAL_AUDIO_FORMAT_FLAGISPACKED;
+
+  //  The scale of cahal_convert_to_float32 and cahal_convert_from_float32
+  static float from_device( device_sample in_sample )
+  {
+    return( static_cast< float >( in_sample * ( 1.0 / 2147483648.0 ) ) );
+  }
+
+  static device_sample to_device( float in_sample )
+  {
+    //  Clipped to the range of the integers, which is asymmetric
+    if( 1.0f <= in_sample )
+    {
+      return( INT32_MAX );
+    }
+    else if( -1.0f >= in_sample )
+    {
+      return( INT32_MIN );
+    }
+
+    return( static_cast< device_sample >( in_sample * 2147483648.0 ) );
+  }
+};
+
+/*! \var    Sample
+    \brief  The sample types that sample_traits is specialised for.
+ */
+template< typename T >
+concept Sample = requires { typename sample_traits< T >::device_sample; };
+
+/*! \var    Platform
+    \brief  What the streams are started and stopped through: the C API.
+            Recording, Playback and Stream take another type with the same
+            static members as their last template parameter, e.g. to run
+            against an in-process device in tests.
+ */
+struct Platform
+{
+  /*! \var    buffer_duration
+      \brief  The longest buffer (in seconds) the platforms record in.
+   */
+  static constexpr FLOAT64 buffer_duration = CAHAL_QUEUE_BUFFER_DURATION;
+
+  static
+  CPC_BOOL
+  start_recording (
+                   cahal_device*            in_device,
+                   cahal_audio_format_id    in_format_id,
+                   UINT32                   in_number_of_channels,
+                   FLOAT64                  in_sample_rate,
+                   UINT32                   in_bit_depth,
+                   cahal_recorder_callback  in_recorder,
+                   void*                    in_callback_user_data,
+                   cahal_audio_format_flag  in_format_flags
+                   )
+  {
+    return  (
+             cahal_start_recording  (
+                                     in_device,
+                                     in_format_id,
+                                     in_number_of_channels,
+                                     in_sample_rate,
+                                     in_bit_depth,
+                                     in_recorder,
+                                     in_callback_user_data,
+                                     in_format_flags
+                                     )
+             );
+  }
+
+  static CPC_BOOL stop_recording( void )
+  {
+    return( cahal_stop_recording() );
+  }
+
+  static
+  CPC_BOOL
+  start_playback  (
+                   cahal_device*            in_device,
+                   cahal_audio_format_id    in_format_id,
+                   UINT32                   in_number_of_channels,
+                   FLOAT64                  in_sample_rate,
+                   UINT32                   in_bit_depth,
+                   FLOAT32                  in_volume,
+                   cahal_playback_callback  in_playback,
+                   void*                    in_callback_user_data,
+                   cahal_audio_format_flag  in_format_flags
+                   )
+  {
+    return  (
+             cahal_start_playback (
+                                   in_device,
+                                   in_format_id,
+                                   in_number_of_channels,
+                                   in_sample_rate,
+                                   in_bit_depth,
+                                   in_volume,
+                                   in_playback,
+                                   in_callback_user_data,
+                                   in_format_flags
+                                   )
+             );
+  }
+
+  static CPC_BOOL stop_playback( void )
+  {
+    return( cahal_stop_playback() );
+  }
+
+  /*! \fn     static cahal_recorder_info* get_recorder_info( void )
+      \brief  The callback info of the recording, which a failed start may
+              leave behind.
+   */
+  static cahal_recorder_info* get_recorder_info( void )
+  {
+    return( g_recorder_callback_info );
+  }
+
+  /*! \fn     static cahal_playback_info* get_playback_info( void )
+      \brief  The callback info of the playback, which a failed start may
+              leave behind.
+   */
+  static cahal_playback_info* get_playback_info( void )
+  {
+    return( g_playback_callback_info );
+  }
+};
+
+namespace detail
+{
+
+/*! \fn     template< Sample T > constexpr bool is_native( void )
+    \brief  True iff samples of type T are exchanged with the OS unconverted.
+ */
+template< Sample T >
+constexpr bool
+is_native( void )
+{
+  return( std::is_same_v< T, typename sample_traits< T >::device_sample > );
+}
+
+/*! \fn     template< Sample T > std::span< const T > from_device (
+              const UCHAR*      in_data_buffer,
+              UINT32            in_data_buffer_length,
+              std::vector< T >& io_samples
+            )
+    \brief  Returns the samples in a buffer of the OS, converted into
+            io_samples if T is not native.
+
+    \param  in_data_buffer  The samples, in the format of sample_traits< T >.
+    \param  in_data_buffer_length The size of in_data_buffer in bytes.
+    \param  io_samples  Scratch space, which only grows.
+    \return The samples.
+ */
+template< Sample T >
+std::span< const T >
+from_device (
+             const UCHAR*      in_data_buffer,
+             UINT32            in_data_buffer_length,
+             std::vector< T >& io_samples
+             )
+{
+  using device_sample = typename sample_traits< T >::device_sample;
+
+  const device_sample* samples =
+    reinterpret_cast< const device_sample* >( in_data_buffer );
+  std::size_t number_of_samples =
+    in_data_buffer_length / sizeof( device_sample );
+
+  if constexpr( is_native< T >() )
+  {
+    ( void ) io_samples;
+
+    return( std::span< const T >( samples, number_of_samples ) );
+  }
+  else
+  {
+    if( io_samples.size() < number_of_samples )
+    {
+      io_samples.resize( number_of_samples );
+    }
+
+    for( std::size_t i = 0; i < number_of_samples; i++ )
+    {
+      io_samples[ i ] = sample_traits< T >::from_device( samples[ i ] );
+    }
+
+    return( std::span< const T >( io_samples.data(), number_of_samples ) );
+  }
+}
+
+/*! \fn     template< Sample T > std::span< T > get_device_buffer (
+              UCHAR*            out_data_buffer,
+              UINT32            in_data_buffer_length,
+              std::vector< T >& io_samples
+            )
+    \brief  Returns the span a playback callback fills: the buffer of the OS
+            itself if T is native, io_samples otherwise.
+
+    \param  out_data_buffer The buffer of the OS.
+    \param  in_data_buffer_length The capacity of out_data_buffer in bytes.
+    \param  io_samples  Scratch space, which only grows.
+    \return The span to fill.
+ */
+template< Sample T >
+std::span< T >
+get_device_buffer (
+                   UCHAR*            out_data_buffer,
+                   UINT32            in_data_buffer_length,
+                   std::vector< T >& io_samples
+                   )
+{
+  using device_sample = typename sample_traits< T >::device_sample;
+
+  std::size_t number_of_samples =
+    in_data_buffer_length / sizeof( device_sample );
+
+  if constexpr( is_native< T >() )
+  {
+    ( void ) io_samples;
+
+    return  (
+             std::span< T >  (
+                              reinterpret_cast< T* >( out_data_buffer ),
+                              number_of_samples
+                              )
+             );
+  }
+  else
+  {
+    if( io_samples.size() < number_of_samples )
+    {
+      io_samples.resize( number_of_samples );
+    }
+
+    return( std::span< T >( io_samples.data(), number_of_samples ) );
+  }
+}
+
+/*! \fn     template< Sample T > void to_device (
+              std::span< const T > in_samples,
+              UCHAR*               out_data_buffer
+            )
+    \brief  Converts the samples written to the span returned by
+            get_device_buffer into the buffer of the OS, if T is not native.
+
+    \param  in_samples  The samples written.
+    \param  out_data_buffer The buffer of the OS.
+ */
+template< Sample T >
+void
+to_device (
+           std::span< const T > in_samples,
+           UCHAR*               out_data_buffer
+           )
+{
+  if constexpr( ! is_native< T >() )
+  {
+    using device_sample = typename sample_traits< T >::device_sample;
+
+    device_sample* samples =
+      reinterpret_cast< device_sample* >( out_data_buffer );
+
+    for( std::size_t i = 0; i < in_samples.size(); i++ )
+    {
+      samples[ i ] = sample_traits< T >::to_device( in_samples[ i ] );
+    }
+  }
+  else
+  {
+    ( void ) in_samples;
+    ( void ) out_data_buffer;
+  }
+}
+
+/*! \fn     template< typename P > void release_failed_recording (
+              const void* in_user_data
+            )
+    \brief  Releases a recording whose start failed. A failed start may still
+            hold callback info that points to in_user_data, and leaves the
+            stream unusable until it is stopped.
+
+    \param  in_user_data  The user data the recording was started with.
+ */
+template< typename P >
+void
+release_failed_recording  (
+                           const void* in_user_data
+                           )
+{
+  cahal_recorder_info* recorder_info = P::get_recorder_info();
+
+  if( NULL != recorder_info && in_user_data == recorder_info->user_data )
+  {
+    P::stop_recording();
+  }
+}
+
+/*! \fn     template< typename P > void release_failed_playback (
+              const void* in_user_data
+            )
+    \brief  Releases a playback whose start failed, as
+            release_failed_recording does for a recording.
+
+    \param  in_user_data  The user data the playback was started with.
+ */
+template< typename P >
+void
+release_failed_playback (
+                         const void* in_user_data
+                         )
+{
+  cahal_playback_info* playback_info = P::get_playback_info();
+
+  if( NULL != playback_info && in_user_data == playback_info->user_data )
+  {
+    P::stop_playback();
+  }
+}
+
+}
+
+/*! \var    Session
+    \brief  Keeps the library initialized. The first session calls
+            cahal_initialize. Sessions never call cahal_terminate: the
+            library cannot be initialized again once it has been terminated,
+            so terminating it is left to the application, e.g. at exit, once
+            every stream has been destroyed. Constructing a session after
+            that throws std::logic_error rather than handing out a library
+            that no longer works.
+ */
+class Session
+{
+public:
+  Session( void )
+  {
+    std::lock_guard< std::mutex > guard( get_lock() );
+
+    switch( CAHAL_ATOMIC_LOAD( &g_cahal_state ) )
+    {
+      case CAHAL_STATE_NOT_INITIALIZED:
+        cahal_initialize();
+        break;
+      case CAHAL_STATE_TERMINATED:
+        throw std::logic_error( "CAHAL has been terminated." );
+      default:
+        break;
+    }
+  }
+
+  /*! \fn     std::span< cahal_device* const > get_devices( void ) const
+      \brief  Returns the devices listed by cahal_get_device_list. They stay
+              valid until the library is terminated.
+   */
+  std::span< cahal_device* const > get_devices( void ) const
+  {
+    cahal_device** devices = cahal_get_device_list();
+    std::size_t number_of_devices = 0;
+
+    while( NULL != devices && NULL != devices[ number_of_devices ] )
+    {
+      number_of_devices++;
+    }
+
+    return( std::span< cahal_device* const >( devices, number_of_devices ) );
+  }
+
+private:
+  static std::mutex& get_lock( void )
+  {
+    static std::mutex lock;
+
+    return( lock );
+  }
+};
+
+/*! \var    Recording
+    \brief  A recording that calls F( std::span< const T > ) with every
+            buffer, on the OS thread, and stops when it is destroyed. F
+            returns false to stop receiving buffers. The span is only valid
+            for the duration of the call.
+ */
+template< Sample T, typename F, typename P = Platform >
+class Recording
+{
+public:
+  Recording (
+             const Session&  in_session,
+             cahal_device*   in_device,
+             UINT32          in_number_of_channels,
+             FLOAT64         in_sample_rate,
+             F               in_callback
+             )
+  : m_state( std::make_unique< State >( std::move( in_callback ) ) ),
+    m_is_running( false )
+  {
+    ( void ) in_session;
+
+    m_is_running =
+      P::start_recording  (
+                           in_device,
+                           CAHAL_AUDIO_FORMAT_LINEARPCM,
+                           in_number_of_channels,
+                           in_sample_rate,
+                           sample_traits< T >::bit_depth,
+                           &Recording::recorder_callback,
+                           m_state.get(),
+                           sample_traits< T >::format_flags
+                           );
+
+    if( ! m_is_running )
+    {
+      detail::release_failed_recording< P >( m_state.get() );
+    }
+  }
+
+  Recording( Recording&& io_other ) noexcept
+  : m_state( std::move( io_other.m_state ) ),
+    m_is_running( std::exchange( io_other.m_is_running, false ) )
+  {
+  }
+
+  Recording& operator=( Recording&& io_other ) noexcept
+  {
+    if( this != &io_other )
+    {
+      stop();
+
+      m_state       = std::move( io_other.m_state );
+      m_is_running  = std::exchange( io_other.m_is_running, false );
+    }
+
+    return( *this );
+  }
+
+  Recording( const Recording& ) = delete;
+  Recording& operator=( const Recording& ) = delete;
+
+  ~Recording( void )
+  {
+    stop();
+  }
+
+  /*! \fn     bool is_running( void ) const
+      \brief  True iff the recording was started and has not been stopped.
+   */
+  bool is_running( void ) const
+  {
+    return( m_is_running );
+  }
+
+  /*! \fn     bool stop( void )
+      \brief  Stops the recording. The callback is not called afterwards.
+      \return True iff the recording was running and has been stopped.
+   */
+  bool stop( void )
+  {
+    if( m_is_running )
+    {
+      m_is_running = false;
+
+      return( P::stop_recording() );
+    }
+
+    return( false );
+  }
+
+private:
+  /*! \var    State
+      \brief  The user data of the recording, which never moves.
+   */
+  struct State
+  {
+    explicit State( F&& in_callback )
+    : callback( std::move( in_callback ) )
+    {
+    }
+
+    F                 callback;
+    std::vector< T >  samples;
+  };
+
+  static
+  CPC_BOOL
+  recorder_callback (
+                     cahal_device* in_recording_device,
+                     UCHAR*        in_data_buffer,
+                     UINT32        in_data_buffer_length,
+                     void*         in_user_data
+                     )
+  {
+    State* state = static_cast< State* >( in_user_data );
+
+    ( void ) in_recording_device;
+
+    return  (
+             state->callback  (
+                               detail::from_device< T > (
+                                                         in_data_buffer,
+                                                         in_data_buffer_length,
+                                                         state->samples
+                                                         )
+                               )
+             ? CPC_TRUE : CPC_FALSE
+             );
+  }
+
+  std::unique_ptr< State >  m_state;
+  bool                      m_is_running;
+};
+
+/*! \var    Playback
+    \brief  A playback that calls F( std::span< T > ) to fill every buffer,
+            on the OS thread, and stops when it is destroyed. F returns the
+            number of samples it wrote, a whole number of frames; fewer than
+            the size of the span ends the playback.
+ */
+template< Sample T, typename F, typename P = Platform >
+class Playback
+{
+public:
+  Playback  (
+             const Session&  in_session,
+             cahal_device*   in_device,
+             UINT32          in_number_of_channels,
+             FLOAT64         in_sample_rate,
+             FLOAT32         in_volume,
+             F               in_callback
+             )
+  : m_state( std::make_unique< State >( std::move( in_callback ) ) ),
+    m_is_running( false )
+  {
+    ( void ) in_session;
+
+    m_is_running =
+      P::start_playback (
+                         in_device,
+                         CAHAL_AUDIO_FORMAT_LINEARPCM,
+                         in_number_of_channels,
+                         in_sample_rate,
+                         sample_traits< T >::bit_depth,
+                         in_volume,
+                         &Playback::playback_callback,
+                         m_state.get(),
+                         sample_traits< T >::format_flags
+                         );
+
+    if( ! m_is_running )
+    {
+      detail::release_failed_playback< P >( m_state.get() );
+    }
+  }
+
+  Playback( Playback&& io_other ) noexcept
+  : m_state( std::move( io_other.m_state ) ),
+    m_is_running( std::exchange( io_other.m_is_running, false ) )
+  {
+  }
+
+  Playback& operator=( Playback&& io_other ) noexcept
+  {
+    if( this != &io_other )
+    {
+      stop();
+
+      m_state       = std::move( io_other.m_state );
+      m_is_running  = std::exchange( io_other.m_is_running, false );
+    }
+
+    return( *this );
+  }
+
+  Playback( const Playback& ) = delete;
+  Playback& operator=( const Playback& ) = delete;
+
+  ~Playback( void )
+  {
+    stop();
+  }
+
+  /*! \fn     bool is_running( void ) const
+      \brief  True iff the playback was started and has not been stopped.
+   */
+  bool is_running( void ) const
+  {
+    return( m_is_running );
+  }
+
+  /*! \fn     bool stop( void )
+      \brief  Stops the playback. The callback is not called afterwards.
+      \return True iff the playback was running and has been stopped.
+   */
+  bool stop( void )
+  {
+    if( m_is_running )
+    {
+      m_is_running = false;
+
+      return( P::stop_playback() );
+    }
+
+    return( false );
+  }
+
+private:
+  /*! \var    State
+      \brief  The user data of the playback, which never moves.
+   */
+  struct State
+  {
+    explicit State( F&& in_callback )
+    : callback( std::move( in_callback ) )
+    {
+    }
+
+    F                 callback;
+    std::vector< T >  samples;
+  };
+
+  static
+  CPC_BOOL
+  playback_callback (
+                     cahal_device* in_playback_device,
+                     UCHAR*        out_data_buffer,
+                     UINT32*       io_data_buffer_length,
+                     void*         in_user_data
+                     )
+  {
+    using device_sample = typename sample_traits< T >::device_sample;
+
+    State* state = static_cast< State* >( in_user_data );
+    std::span< T > samples =
+      detail::get_device_buffer< T >  (
+                                       out_data_buffer,
+                                       *io_data_buffer_length,
+                                       state->samples
+                                       );
+    std::size_t number_of_samples = state->callback( samples );
+
+    ( void ) in_playback_device;
+
+    if( samples.size() < number_of_samples )
+    {
+      number_of_samples = samples.size();
+    }
+
+    detail::to_device< T >  (
+                             samples.first( number_of_samples ),
+                             out_data_buffer
+                             );
+
+    *io_data_buffer_length =
+      static_cast< UINT32 >( number_of_samples * sizeof( device_sample ) );
+
+    return( CPC_TRUE );
+  }
+
+  std::unique_ptr< State >  m_state;
+  bool                      m_is_running;
+};
+
+/*! \fn     template< Sample T, typename P, typename F >
+              Recording< T, std::decay_t< F >, P > record  (
+                const Session&  in_session,
+                cahal_device*   in_device,
+                UINT32          in_number_of_channels,
+                FLOAT64         in_sample_rate,
+                F&&             in_callback
+              )
+    \brief  Starts a Recording, deducing the type of the callback.
+ */
+template< Sample T, typename P = Platform, typename F >
+Recording< T, std::decay_t< F >, P >
+record  (
+         const Session&  in_session,
+         cahal_device*   in_device,
+         UINT32          in_number_of_channels,
+         FLOAT64         in_sample_rate,
+         F&&             in_callback
+         )
+{
+  using recording = Recording< T, std::decay_t< F >, P >;
+
+  return  (
+           recording  (
+                       in_session,
+                       in_device,
+                       in_number_of_channels,
+                       in_sample_rate,
+                       std::forward< F >( in_callback )
+                       )
+           );
+}
+
+/*! \fn     template< Sample T, typename P, typename F >
+              Playback< T, std::decay_t< F >, P > play  (
+                const Session&  in_session,
+                cahal_device*   in_device,
+                UINT32          in_number_of_channels,
+                FLOAT64         in_sample_rate,
+                FLOAT32         in_volume,
+                F&&             in_callback
+              )
+    \brief  Starts a Playback, deducing the type of the callback.
+ */
+template< Sample T, typename P = Platform, typename F >
+Playback< T, std::decay_t< F >, P >
+play  (
+       const Session&  in_session,
+       cahal_device*   in_device,
+       UINT32          in_number_of_channels,
+       FLOAT64         in_sample_rate,
+       FLOAT32         in_volume,
+       F&&             in_callback
+       )
+{
+  using playback = Playback< T, std::decay_t< F >, P >;
+
+  return  (
+           playback (
+                     in_session,
+                     in_device,
+                     in_number_of_channels,
+                     in_sample_rate,
+                     in_volume,
+                     std::forward< F >( in_callback )
+                     )
+           );
+}
+
+/*! \var    Stream
+    \brief  A recording read by coroutines:
+
+              std::vector< float > samples = co_await stream.read( frames );
+
+            The OS thread copies every buffer into a ring buffer, or drops it
+            (counting an overrun) if it does not fit, so the ring holds one
+            OS buffer more than the longest read. A coroutine that awaits
+            more frames than are in the ring is suspended and resumed once
+            they have been recorded, on a thread owned by the stream: the OS
+            thread only wakes that thread, which neither allocates nor locks.
+            A resumed coroutine may destroy the stream. Reads must be awaited
+            by one coroutine at a time, and must have completed before the
+            stream is destroyed by any other thread.
+ */
+template< Sample T, typename P = Platform >
+class Stream
+{
+  struct State;
+
+public:
+  /*! \var    ReadAwaiter
+      \brief  The awaitable returned by read. Resumes with the frames read
+              as interleaved samples: the number requested, or fewer once
+              the stream has stopped.
+   */
+  class ReadAwaiter
+  {
+  public:
+    ReadAwaiter (
+                 std::shared_ptr< State > in_state,
+                 UINT32                   in_number_of_bytes
+                 )
+    : m_state( std::move( in_state ) ),
+      m_number_of_bytes( in_number_of_bytes )
+    {
+    }
+
+    bool await_ready( void ) const
+    {
+      return( m_state->is_ready( m_number_of_bytes ) );
+    }
+
+    bool await_suspend( std::coroutine_handle<> in_coroutine )
+    {
+      //  Once the waiter is set the coroutine may be resumed, finish and
+      //  destroy this awaiter and the stream, so only locals are used after
+      std::shared_ptr< State > state  = m_state;
+      UINT32 number_of_bytes          = m_number_of_bytes;
+
+      state->number_of_requested_bytes.store( number_of_bytes );
+      state->waiter.store( in_coroutine.address() );
+
+      //  The OS thread may have recorded enough before the waiter was set,
+      //  in which case whichever thread clears the waiter resumes it
+      if  (
+           state->is_ready( number_of_bytes )
+           && NULL != state->waiter.exchange( NULL )
+           )
+      {
+        return( false );
+      }
+
+      return( true );
+    }
+
+    std::vector< T > await_resume( void )
+    {
+      return( m_state->read( m_number_of_bytes ) );
+    }
+
+  private:
+    std::shared_ptr< State >  m_state;
+    UINT32                    m_number_of_bytes;
+  };
+
+  Stream  (
+           const Session&  in_session,
+           cahal_device*   in_device,
+           UINT32          in_number_of_channels,
+           FLOAT64         in_sample_rate,
+           FLOAT64         in_buffer_duration = stream_buffer_duration
+           )
+  : m_state( std::make_shared< State >() ),
+    m_is_running( false )
+  {
+    UINT32 frame_size =
+      sizeof( typename sample_traits< T >::device_sample )
+      * in_number_of_channels;
+
+    ( void ) in_session;
+
+    //  The OS writes whole buffers, which are dropped unless they fit, so
+    //  the ring has room for one while it holds the largest read
+    UINT32 os_buffer_size =
+      static_cast< UINT32 >( P::buffer_duration * in_sample_rate )
+      * frame_size;
+
+    m_state->frame_size         = frame_size;
+    m_state->number_of_channels = in_number_of_channels;
+    m_state->ring_buffer        =
+      cahal_ring_buffer_create  (
+                                 static_cast< UINT32 >  (
+                                   in_buffer_duration * in_sample_rate
+                                   )
+                                 * frame_size
+                                 + os_buffer_size
+                                 );
+
+    if( NULL != m_state->ring_buffer )
+    {
+      m_state->maximum_read_size =
+        m_state->ring_buffer->capacity - os_buffer_size;
+      m_state->maximum_read_size -=
+        m_state->maximum_read_size % frame_size;
+
+      //  Started first, so that nothing is recorded that cannot be resumed
+      m_resumer = std::thread( &State::resume_waiters, m_state );
+
+      m_is_running =
+        P::start_recording  (
+                             in_device,
+                             CAHAL_AUDIO_FORMAT_LINEARPCM,
+                             in_number_of_channels,
+                             in_sample_rate,
+                             sample_traits< T >::bit_depth,
+                             &State::recorder_callback,
+                             m_state.get(),
+                             sample_traits< T >::format_flags
+                             );
+
+      if( ! m_is_running )
+      {
+        detail::release_failed_recording< P >( m_state.get() );
+      }
+    }
+
+    m_state->is_stopped.store( ! m_is_running );
+  }
+
+  Stream( Stream&& io_other ) noexcept
+  : m_state( std::move( io_other.m_state ) ),
+    m_resumer( std::move( io_other.m_resumer ) ),
+    m_is_running( std::exchange( io_other.m_is_running, false ) )
+  {
+  }
+
+  Stream& operator=( Stream&& io_other ) noexcept
+  {
+    if( this != &io_other )
+    {
+      release();
+
+      m_state       = std::move( io_other.m_state );
+      m_resumer     = std::move( io_other.m_resumer );
+      m_is_running  = std::exchange( io_other.m_is_running, false );
+    }
+
+    return( *this );
+  }
+
+  Stream( const Stream& ) = delete;
+  Stream& operator=( const Stream& ) = delete;
+
+  ~Stream( void )
+  {
+    release();
+  }
+
+  /*! \fn     bool is_running( void ) const
+      \brief  True iff the recording was started and has not been stopped.
+   */
+  bool is_running( void ) const
+  {
+    return( m_is_running );
+  }
+
+  /*! \fn     ReadAwaiter read( UINT32 in_number_of_frames )
+      \brief  Returns an awaitable reading in_number_of_frames frames, at
+              most what the ring holds besides one OS buffer, which is at
+              least the buffer duration the stream was constructed with.
+   */
+  ReadAwaiter read( UINT32 in_number_of_frames )
+  {
+    UINT32 maximum_number_of_frames =
+      m_state->maximum_read_size / m_state->frame_size;
+
+    if( maximum_number_of_frames < in_number_of_frames )
+    {
+      in_number_of_frames = maximum_number_of_frames;
+    }
+
+    return  (
+             ReadAwaiter  (
+                           m_state,
+                           in_number_of_frames * m_state->frame_size
+                           )
+             );
+  }
+
+  /*! \fn     UINT32 get_number_of_overruns( void ) const
+      \brief  The number of recorded buffers dropped because the ring was
+              full.
+   */
+  UINT32 get_number_of_overruns( void ) const
+  {
+    return( m_state->number_of_overruns.load() );
+  }
+
+  /*! \fn     bool stop( void )
+      \brief  Stops the recording. A pending read is resumed with the frames
+              left in the ring, and later reads complete immediately.
+      \return True iff the recording was running and has been stopped.
+   */
+  bool stop( void )
+  {
+    bool is_stopped = false;
+
+    if( m_is_running )
+    {
+      m_is_running  = false;
+      is_stopped    = P::stop_recording();
+
+      m_state->is_stopped.store( true );
+      m_state->resume();
+    }
+
+    return( is_stopped );
+  }
+
+private:
+  /*! \fn     void release( void )
+      \brief  Stops the recording and the thread that resumes the readers.
+              The thread is detached rather than joined if the stream is
+              destroyed by a coroutine it resumed; it then exits once that
+              coroutine returns, and frees the state.
+   */
+  void release( void )
+  {
+    stop();
+
+    if( m_resumer.joinable() )
+    {
+      m_state->is_exiting.store( true );
+      m_state->wake.release();
+
+      if( std::this_thread::get_id() == m_resumer.get_id() )
+      {
+        m_resumer.detach();
+      }
+      else
+      {
+        m_resumer.join();
+      }
+    }
+  }
+
+  /*! \var    State
+      \brief  The user data of the recording, which never moves. Shared with
+              the thread that resumes the readers.
+   */
+  struct State
+  {
+    State( void )
+    : ring_buffer( NULL ),
+      maximum_read_size( 0 ),
+      frame_size( 0 ),
+      number_of_channels( 0 ),
+      number_of_requested_bytes( 0 ),
+      waiter( NULL ),
+      resumable( NULL ),
+      wake( 0 ),
+      is_exiting( false ),
+      is_stopped( false ),
+      number_of_overruns( 0 )
+    {
+    }
+
+    ~State( void )
+    {
+      if( NULL != ring_buffer )
+      {
+        cahal_ring_buffer_free( ring_buffer );
+      }
+    }
+
+    bool is_ready( UINT32 in_number_of_bytes ) const
+    {
+      return  (
+               is_stopped.load()
+               || cahal_ring_buffer_get_fill( ring_buffer )
+                  >= in_number_of_bytes
+               );
+    }
+
+    std::vector< T > read( UINT32 in_number_of_bytes )
+    {
+      using device_sample = typename sample_traits< T >::device_sample;
+
+      UINT32 length = cahal_ring_buffer_get_fill( ring_buffer );
+      std::vector< T > samples;
+
+      if( in_number_of_bytes < length )
+      {
+        length = in_number_of_bytes;
+      }
+
+      length -= length % frame_size;
+
+      samples.resize( length / sizeof( device_sample ) );
+
+      if constexpr( detail::is_native< T >() )
+      {
+        cahal_ring_buffer_read  (
+                                 ring_buffer,
+                                 reinterpret_cast< UCHAR* >( samples.data() ),
+                                 length
+                                 );
+      }
+      else
+      {
+        std::vector< device_sample > device_samples( samples.size() );
+
+        cahal_ring_buffer_read  (
+                                 ring_buffer,
+                                 reinterpret_cast< UCHAR* >  (
+                                   device_samples.data()
+                                   ),
+                                 length
+                                 );
+
+        for( std::size_t i = 0; i < samples.size(); i++ )
+        {
+          samples[ i ] = sample_traits< T >::from_device( device_samples[ i ] );
+        }
+      }
+
+      return( samples );
+    }
+
+    /*! \fn     void resume( void )
+        \brief  Hands the waiting coroutine, if any, to the thread running
+                resume_waiters. Safe on the OS thread: it neither allocates
+                nor locks.
+     */
+    void resume( void )
+    {
+      void* coroutine = waiter.exchange( NULL );
+
+      if( NULL != coroutine )
+      {
+        resumable.store( coroutine );
+        wake.release();
+      }
+    }
+
+    /*! \fn     static void resume_waiters( std::shared_ptr< State > io_state )
+        \brief  The routine of the thread that resumes the readers, until
+                the stream is released.
+     */
+    static void resume_waiters( std::shared_ptr< State > io_state )
+    {
+      //  io_state outlives a coroutine that destroys the stream
+      do
+      {
+        io_state->wake.acquire();
+
+        void* coroutine = io_state->resumable.exchange( NULL );
+
+        if( NULL != coroutine )
+        {
+          std::coroutine_handle<>::from_address( coroutine ).resume();
+        }
+      } while( ! io_state->is_exiting.load() );
+    }
+
+    static
+    CPC_BOOL
+    recorder_callback (
+                       cahal_device* in_recording_device,
+                       UCHAR*        in_data_buffer,
+                       UINT32        in_data_buffer_length,
+                       void*         in_user_data
+                       )
+    {
+      State* state = static_cast< State* >( in_user_data );
+
+      ( void ) in_recording_device;
+
+      if  (
+           cahal_ring_buffer_get_space( state->ring_buffer )
+           < in_data_buffer_length
+           )
+      {
+        state->number_of_overruns++;
+      }
+      else
+      {
+        cahal_ring_buffer_write (
+                                 state->ring_buffer,
+                                 in_data_buffer,
+                                 in_data_buffer_length
+                                 );
+      }
+
+      //  Only the thread that clears the waiter resumes it, so a coroutine
+      //  is resumed exactly once
+      if  (
+           NULL != state->waiter.load()
+           && state->is_ready( state->number_of_requested_bytes.load() )
+           )
+      {
+        state->resume();
+      }
+
+      return( CPC_TRUE );
+    }
+
+    cahal_ring_buffer*        ring_buffer;
+    UINT32                    maximum_read_size;
+    UINT32                    frame_size;
+    UINT32                    number_of_channels;
+    std::atomic< UINT32 >     number_of_requested_bytes;
+    std::atomic< void* >      waiter;
+    std::atomic< void* >      resumable;
+    std::counting_semaphore<> wake;
+    std::atomic< bool >       is_exiting;
+    std::atomic< bool >       is_stopped;
+    std::atomic< UINT32 >     number_of_overruns;
+  };
+
+  std::shared_ptr< State >  m_state;
+  std::thread               m_resumer;
+  bool                      m_is_running;
+};
+
+}
+
+#endif  /*  __CAHAL_HPP__ */
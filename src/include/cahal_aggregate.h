@@ -0,0 +1,434 @@
+/*! \file   cahal_aggregate.h
+    \brief  Aggregate recordings: several input devices recorded together and
+            presented as one multichannel stream, e.g. 24 to 48 channels
+            captured from a stack of 8 channel USB interfaces. The channels of
+            the members are concatenated in order, so the first member's
+            channels come first in every frame, and one callback receives the
+            consolidated frames.
+
+            The members are started together at a common host time (see
+            cahal_get_time), CAHAL_AGGREGATE_START_DELAY in the future, and
+            every member drops the frames recorded before it, or is padded
+            with silence if it started late, using the timestamp of its
+            buffers. All members' streams therefore start at the same frame.
+
+            The first member is the master: its clock drives the aggregate
+            and the consolidated callback is called on its thread. The other
+            members run on their own clocks, so each member goes through a
+            cahal_drift_resampler. Instead of a fixed fill level the
+            resamplers of the other members are steered to the fill level of
+            the master's, less the frames each member has recorded but not
+            yet delivered (computed from the timestamps of its buffers). This
+            keeps them aligned to the master regardless of when their buffers
+            arrive; a member that overruns or underruns (e.g. a device that
+            was unplugged) loses its alignment and is slowly pulled back by
+            the resampler, at CAHAL_DRIFT_RESAMPLER_MAXIMUM_PPM at most.
+
+            The consolidated stream lags the devices by
+            CAHAL_AGGREGATE_LATENCY, which must cover the buffer size of the
+            slowest member.
+
+            Only input is aggregated. There is no aggregate playback: output
+            still goes through cahal_start_playback, which plays on a single
+            device (g_playback_callback_info), so several output devices
+            cannot be started together, aligned or drift corrected.
+
+            Opening several recordings at once is platform-specific and only
+            the Darwin platforms support it, where the audio queues of the
+            members are started at the same host time. On Android, Windows
+            and without an audio API cahal_start_aggregate_member always
+            fails, so cahal_start_aggregate_recording returns NULL.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_AGGREGATE_H__
+#define __CAHAL_AGGREGATE_H__
+
+#include <cpcommon.h>
+
+#include "cahal_atomic.h"
+#include "cahal_device.h"
+#include "cahal_drift_resampler.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_AGGREGATE_START_DELAY
+    \brief  The time (in seconds) between starting an aggregate recording and
+            the common start time of its members, to let all of them be set
+            up.
+ */
+#define CAHAL_AGGREGATE_START_DELAY       0.1
+
+/*! \def    CAHAL_AGGREGATE_LATENCY
+    \brief  The latency (in seconds) of the consolidated stream. Must be
+            larger than the duration of a recorded buffer (see
+            CAHAL_QUEUE_BUFFER_DURATION) plus the jitter of its delivery.
+ */
+#define CAHAL_AGGREGATE_LATENCY           ( 2 * CAHAL_QUEUE_BUFFER_DURATION )
+
+/*! \def    CAHAL_AGGREGATE_MAXIMUM_LATENCY
+    \brief  The number of seconds of audio buffered per member, beyond which
+            its frames are dropped.
+ */
+#define CAHAL_AGGREGATE_MAXIMUM_LATENCY   ( 4 * CAHAL_QUEUE_BUFFER_DURATION )
+
+/*! \def    CAHAL_AGGREGATE_RATE_INTERVAL
+    \brief  The time (in seconds) a member must have been recording for before
+            the rate of its clock is measured from the timestamps of its
+            buffers rather than assumed to be nominal.
+ */
+#define CAHAL_AGGREGATE_RATE_INTERVAL     1.0
+
+/*! \var    cahal_aggregate_member
+    \brief  Struct definition for one device of an aggregate recording.
+ */
+typedef struct cahal_aggregate_member_t
+{
+  /*! \var    aggregate
+      \brief  The aggregate recording the member belongs to.
+   */
+  struct cahal_aggregate_recording_t* aggregate;
+
+  /*! \var    index
+      \brief  The position of the member in the aggregate. Member 0 is the
+              master.
+   */
+  UINT32                              index;
+
+  /*! \var    first_channel
+      \brief  The channel of the consolidated frame the member's first
+              channel is copied to.
+   */
+  UINT32                              first_channel;
+
+  /*! \var    recorder_info
+      \brief  The recording of the member, set up like the one of
+              cahal_start_recording. Its user data is the member and its
+              platform data belongs to the platform.
+   */
+  cahal_recorder_info                 recorder_info;
+
+  /*! \var    frame_size
+      \brief  The number of bytes in a recorded frame.
+   */
+  UINT32                              frame_size;
+
+  /*! \var    resampler
+      \brief  The frames recorded by the member, read by the master's thread.
+   */
+  cahal_drift_resampler*              resampler;
+
+  /*! \var    silence
+      \brief  CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES frames of silence, written
+              for a member that started late.
+   */
+  FLOAT32*                            silence;
+
+  /*! \var    has_started
+      \brief  Set once the member has recorded a frame at or after the start
+              time. Only used by the member's thread.
+   */
+  CPC_BOOL                            has_started;
+
+  /*! \var    first_record_time
+      \brief  The time (in ns since the start time) at which the first buffer
+              of the member kept was recorded. Only used by the member's
+              thread.
+   */
+  FLOAT64                             first_record_time;
+
+  /*! \var    number_of_recorded_frames
+      \brief  The number of frames the member recorded since
+              first_record_time, up to its last buffer. Only used by the
+              member's thread.
+   */
+  FLOAT64                             number_of_recorded_frames;
+
+  /*! \var    end_time
+      \brief  The time (in microseconds since the start time, wrapping) at
+              which the last frame delivered by the member was recorded.
+   */
+  cahal_atomic_uint32                 end_time;
+
+} cahal_aggregate_member;
+
+/*! \var    cahal_aggregate_recording
+    \brief  Struct definition for an aggregate recording.
+ */
+typedef struct cahal_aggregate_recording_t
+{
+  /*! \var    number_of_members
+      \brief  The number of entries in members.
+   */
+  UINT32                  number_of_members;
+
+  /*! \var    members
+      \brief  The devices of the aggregate, the master first.
+   */
+  cahal_aggregate_member* members;
+
+  /*! \var    number_of_channels
+      \brief  The number of channels in a consolidated frame.
+   */
+  UINT32                  number_of_channels;
+
+  /*! \var    sample_rate
+      \brief  The nominal sample rate of all the members.
+   */
+  FLOAT64                 sample_rate;
+
+  /*! \var    bit_depth
+      \brief  The bit depth of the members and of the consolidated frames.
+   */
+  UINT32                  bit_depth;
+
+  /*! \var    format_flags
+      \brief  The format flags of the members and of the consolidated frames.
+   */
+  cahal_audio_format_flag format_flags;
+
+  /*! \var    start_time
+      \brief  The host time (in ns, see cahal_get_time) of the first frame of
+              every member.
+   */
+  UINT64                  start_time;
+
+  /*! \var    latency
+      \brief  The number of frames the master buffers before the first
+              consolidated callback.
+   */
+  UINT32                  latency;
+
+  /*! \var    recording_callback
+      \brief  The callback receiving the consolidated frames.
+   */
+  cahal_recorder_callback recording_callback;
+
+  /*! \var    user_data
+      \brief  Passed to recording_callback unmodified.
+   */
+  void*                   user_data;
+
+  /*! \var    is_primed
+      \brief  Set once the master has buffered latency frames. Only used by
+              the master's thread.
+   */
+  CPC_BOOL                is_primed;
+
+  /*! \var    member_frames
+      \brief  The frames read from one member, one chunk at a time.
+   */
+  FLOAT32*                member_frames;
+
+  /*! \var    frames
+      \brief  One chunk of consolidated frames.
+   */
+  FLOAT32*                frames;
+
+  /*! \var    data_buffer
+      \brief  One chunk of consolidated frames in the recorded format.
+   */
+  UCHAR*                  data_buffer;
+
+} cahal_aggregate_recording;
+
+/*! \fn     cahal_aggregate_recording* cahal_aggregate_recording_create  (
+              UINT32                   in_number_of_members,
+              cahal_device**           in_devices,
+              const UINT32*            in_number_of_channels,
+              cahal_audio_format_id    in_format_id,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              cahal_recorder_callback  in_recorder,
+              void*                    in_callback_user_data,
+              cahal_audio_format_flag  in_format_flags,
+              UINT64                   in_start_time
+            )
+    \brief  Creates an aggregate recording whose members are not attached to
+            the OS. Used by cahal_start_aggregate_recording; the members of
+            an aggregate created directly are fed by calling
+            cahal_aggregate_push.
+
+    \param  in_number_of_members  The number of devices.
+    \param  in_devices  The devices, the master first, or NULL if the members
+                        are fed directly.
+    \param  in_number_of_channels The number of channels recorded from each
+                                  device.
+    \param  in_format_id  The audio format to record in.
+    \param  in_sample_rate  The sample rate of all the devices.
+    \param  in_bit_depth  The number of bits per sample.
+    \param  in_recorder The callback receiving the consolidated frames, on
+                        the master's thread. Its device is the master.
+    \param  in_callback_user_data Passed to in_recorder unmodified.
+    \param  in_format_flags The flags to be used in the recording.
+    \param  in_start_time The host time (in ns, see cahal_get_time) at which
+                          the members start.
+    \return The aggregate or NULL on error. Free using
+            cahal_aggregate_recording_free.
+ */
+cahal_aggregate_recording*
+cahal_aggregate_recording_create  (
+                              UINT32                   in_number_of_members,
+                              cahal_device**           in_devices,
+                              const UINT32*            in_number_of_channels,
+                              cahal_audio_format_id    in_format_id,
+                              FLOAT64                  in_sample_rate,
+                              UINT32                   in_bit_depth,
+                              cahal_recorder_callback  in_recorder,
+                              void*                    in_callback_user_data,
+                              cahal_audio_format_flag  in_format_flags,
+                              UINT64                   in_start_time
+                                   );
+
+/*! \fn     void cahal_aggregate_recording_free  (
+              cahal_aggregate_recording* in_aggregate
+            )
+    \brief  Frees an aggregate recording. The OS must have stopped calling
+            back.
+
+    \param  in_aggregate  The aggregate to free.
+ */
+void
+cahal_aggregate_recording_free  (
+                                 cahal_aggregate_recording* in_aggregate
+                                 );
+
+/*! \fn     cahal_aggregate_recording* cahal_start_aggregate_recording (
+              UINT32                   in_number_of_members,
+              cahal_device**           in_devices,
+              const UINT32*            in_number_of_channels,
+              cahal_audio_format_id    in_format_id,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              cahal_recorder_callback  in_recorder,
+              void*                    in_callback_user_data,
+              cahal_audio_format_flag  in_format_flags
+            )
+    \brief  Starts recording from several devices at once. The recording is
+            independent of the one of cahal_start_recording. Only supported
+            on the Darwin platforms.
+
+    \param  in_number_of_members  The number of devices.
+    \param  in_devices  The devices to record from, the master first.
+    \param  in_number_of_channels The number of channels to record from each
+                                  device.
+    \param  in_format_id  The audio format to record in.
+    \param  in_sample_rate  The sample rate of all the devices.
+    \param  in_bit_depth  The number of bits per sample.
+    \param  in_recorder The callback receiving the consolidated frames, on
+                        the master's thread. Its device is the master.
+    \param  in_callback_user_data Passed to in_recorder unmodified.
+    \param  in_format_flags The flags to be used in the recording.
+    \return The aggregate, or NULL if any device could not be started or
+            the platform does not support aggregates. Stop using
+            cahal_stop_aggregate_recording.
+ */
+cahal_aggregate_recording*
+cahal_start_aggregate_recording (
+                              UINT32                   in_number_of_members,
+                              cahal_device**           in_devices,
+                              const UINT32*            in_number_of_channels,
+                              cahal_audio_format_id    in_format_id,
+                              FLOAT64                  in_sample_rate,
+                              UINT32                   in_bit_depth,
+                              cahal_recorder_callback  in_recorder,
+                              void*                    in_callback_user_data,
+                              cahal_audio_format_flag  in_format_flags
+                                 );
+
+/*! \fn     void cahal_stop_aggregate_recording (
+              cahal_aggregate_recording* in_aggregate
+            )
+    \brief  Stops all the devices of an aggregate recording and frees it.
+
+    \param  in_aggregate  The aggregate, which must not be used afterwards.
+ */
+void
+cahal_stop_aggregate_recording (
+                                cahal_aggregate_recording* in_aggregate
+                                );
+
+/*! \fn     CPC_BOOL cahal_aggregate_push  (
+              cahal_aggregate_member* io_member,
+              UCHAR*                  in_data_buffer,
+              UINT32                  in_data_buffer_length,
+              UINT64                  in_record_time
+            )
+    \brief  Hands a buffer recorded by a member to the aggregate. Called by
+            the platforms on the member's thread. A buffer of the master
+            produces the same number of consolidated frames, once the master
+            has buffered CAHAL_AGGREGATE_LATENCY.
+
+    \param  io_member The member that recorded the buffer.
+    \param  in_data_buffer  The recorded samples.
+    \param  in_data_buffer_length The size of in_data_buffer in bytes.
+    \param  in_record_time  The host time (in ns, see cahal_get_time) at
+                            which the first frame of the buffer was recorded.
+    \return True unless the consolidated callback failed.
+ */
+CPC_BOOL
+cahal_aggregate_push  (
+                       cahal_aggregate_member* io_member,
+                       UCHAR*                  in_data_buffer,
+                       UINT32                  in_data_buffer_length,
+                       UINT64                  in_record_time
+                       );
+
+/*! \fn     FLOAT64 cahal_aggregate_get_ppm  (
+              cahal_aggregate_recording* in_aggregate,
+              UINT32                     in_member
+            )
+    \brief  Returns the clock offset of a member relative to the master.
+
+    \param  in_aggregate  The aggregate.
+    \param  in_member The index of the member.
+    \return The offset in parts per million, positive if the member runs
+            faster than the master.
+ */
+FLOAT64
+cahal_aggregate_get_ppm  (
+                          cahal_aggregate_recording* in_aggregate,
+                          UINT32                     in_member
+                          );
+
+/*! \fn     CPC_BOOL cahal_start_aggregate_member  (
+              cahal_aggregate_member* io_member,
+              UINT64                  in_start_time
+            )
+    \brief  Starts recording from a member, handing its buffers to
+            cahal_aggregate_push. Defined by the platform.
+
+    \param  io_member The member, whose recorder info is filled in. The
+                      platform sets its platform data.
+    \param  in_start_time The host time (in ns, see cahal_get_time) at which
+                          the device should start recording.
+    \return True iff the member was started.
+ */
+CPC_BOOL
+cahal_start_aggregate_member  (
+                               cahal_aggregate_member* io_member,
+                               UINT64                  in_start_time
+                               );
+
+/*! \fn     void cahal_stop_aggregate_member (
+              cahal_aggregate_member* io_member
+            )
+    \brief  Stops recording from a member started using
+            cahal_start_aggregate_member. Once it returns the member is not
+            called back anymore. Defined by the platform.
+
+    \param  io_member The member.
+ */
+void
+cahal_stop_aggregate_member (
+                             cahal_aggregate_member* io_member
+                             );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_AGGREGATE_H__ */
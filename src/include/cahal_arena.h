@@ -0,0 +1,171 @@
+/*! \file   cahal_arena.h
+    \brief  A bump allocator that hands out memory from a few large blocks and
+            frees all of it at once. Strings copied into an arena can be
+            interned so that equal strings share a single copy.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_ARENA_H__
+#define __CAHAL_ARENA_H__
+
+#include <cpcommon.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_ARENA_ALIGNMENT
+    \brief  The alignment, in bytes, of every allocation made from an arena.
+ */
+#define CAHAL_ARENA_ALIGNMENT         16
+
+/*! \def    CAHAL_ARENA_ROUND
+    \brief  The number of bytes an allocation of in_size bytes takes up in an
+            arena, i.e. in_size rounded up to CAHAL_ARENA_ALIGNMENT.
+ */
+#define CAHAL_ARENA_ROUND( in_size )                                    \
+  ( ( ( SIZE ) ( in_size ) + CAHAL_ARENA_ALIGNMENT - 1 )                \
+    & ~( ( SIZE ) CAHAL_ARENA_ALIGNMENT - 1 ) )
+
+/*! \def    CAHAL_ARENA_MINIMUM_BLOCK_SIZE
+    \brief  The smallest block, in bytes, that an arena allocates when it runs
+            out of space.
+ */
+#define CAHAL_ARENA_MINIMUM_BLOCK_SIZE 4096
+
+/*! \var    cahal_arena_block
+    \brief  Struct definition for one block of an arena. The usable memory
+            follows the header.
+ */
+typedef struct cahal_arena_block_t
+{
+  /*! \var    next
+      \brief  The previously allocated block, or NULL.
+   */
+  struct cahal_arena_block_t* next;
+
+  /*! \var    size
+      \brief  The number of usable bytes in the block.
+   */
+  SIZE                        size;
+
+  /*! \var    used
+      \brief  The number of bytes handed out from the block.
+   */
+  SIZE                        used;
+
+} cahal_arena_block;
+
+/*! \var    cahal_arena
+    \brief  Struct definition for an arena.
+ */
+typedef struct cahal_arena_t
+{
+  /*! \var    blocks
+      \brief  The most recently allocated block, which is the one allocations
+              are made from. Older blocks are chained through next.
+   */
+  cahal_arena_block*  blocks;
+
+  /*! \var    number_of_blocks
+      \brief  The number of blocks allocated.
+   */
+  UINT32              number_of_blocks;
+
+  /*! \var    bytes_used
+      \brief  The number of bytes handed out, including alignment padding.
+   */
+  SIZE                bytes_used;
+
+  /*! \var    strings
+      \brief  Open addressed hash table of the interned strings.
+   */
+  CHAR**              strings;
+
+  /*! \var    strings_capacity
+      \brief  The number of slots in strings. Always a power of two.
+   */
+  UINT32              strings_capacity;
+
+  /*! \var    number_of_strings
+      \brief  The number of distinct strings interned.
+   */
+  UINT32              number_of_strings;
+
+  /*! \var    number_of_interned
+      \brief  The number of times a string was interned, including repeats.
+   */
+  UINT32              number_of_interned;
+
+} cahal_arena;
+
+/*! \fn     cahal_arena* cahal_arena_create  (
+              SIZE in_initial_size
+            )
+    \brief  Creates an arena whose first block has room for in_initial_size
+            bytes. Sizing the first block to the expected total keeps
+            everything in one contiguous block.
+
+    \param  in_initial_size The size of the first block in bytes. Smaller
+                            values are rounded up to
+                            CAHAL_ARENA_MINIMUM_BLOCK_SIZE.
+    \return The new arena or NULL on error. Free using cahal_arena_free.
+ */
+cahal_arena*
+cahal_arena_create  (
+                     SIZE in_initial_size
+                     );
+
+/*! \fn     void* cahal_arena_allocate  (
+              cahal_arena*  io_arena,
+              SIZE          in_size
+            )
+    \brief  Allocates in_size zeroed bytes from io_arena. The memory is valid
+            until the arena is freed and must not be freed on its own.
+
+    \param  io_arena  The arena to allocate from.
+    \param  in_size The number of bytes to allocate.
+    \return The memory, aligned to CAHAL_ARENA_ALIGNMENT, or NULL on error.
+ */
+void*
+cahal_arena_allocate  (
+                       cahal_arena*  io_arena,
+                       SIZE          in_size
+                       );
+
+/*! \fn     CHAR* cahal_arena_intern  (
+              cahal_arena*  io_arena,
+              const CHAR*   in_string
+            )
+    \brief  Returns the copy of in_string held by io_arena, copying it into
+            the arena the first time it is seen. The copy is shared and must
+            not be modified.
+
+    \param  io_arena  The arena to intern in_string in.
+    \param  in_string The string to intern.
+    \return The interned copy, or NULL if in_string is NULL or on error.
+ */
+CHAR*
+cahal_arena_intern  (
+                     cahal_arena*  io_arena,
+                     const CHAR*   in_string
+                     );
+
+/*! \fn     void cahal_arena_free  (
+              cahal_arena* in_arena
+            )
+    \brief  Frees in_arena and every allocation made from it.
+
+    \param  in_arena  The arena to free. May be NULL.
+ */
+void
+cahal_arena_free  (
+                   cahal_arena* in_arena
+                   );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_ARENA_H__ */
@@ -0,0 +1,336 @@
+/*! \file   cahal_async.h
+    \brief  Non-blocking variants of cahal_start_* and cahal_stop_* for
+            control threads that manage many sessions and cannot wait for
+            every OS stream to be torn down (stopping blocks for up to one
+            buffer).
+
+            Every operation is queued on a single control thread, created the
+            first time one is submitted, and runs there in the order it was
+            submitted, so a start followed by a stop of the same stream always
+            happens in that order. The caller gets back a handle it can poll
+            or wait on, and may also pass a callback that the control thread
+            calls once the operation has completed.
+
+            Handles are reference counted: the caller must release every
+            handle it gets with cahal_async_release, which may be done before
+            the operation has completed.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_ASYNC_H__
+#define __CAHAL_ASYNC_H__
+
+#include <cpcommon.h>
+
+#include "cahal_atomic.h"
+#include "cahal_thread.h"
+#include "cahal_device.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \var    cahal_async_operation
+    \brief  The handle of a queued operation, defined below.
+ */
+typedef struct cahal_async_operation_t cahal_async_operation;
+
+/*! \fn     typedef CPC_BOOL ( *cahal_async_routine ) (
+              void* io_argument
+            )
+    \brief  The work of an operation, run on the control thread.
+
+    \param  io_argument The argument the operation was submitted with.
+    \return The result of the operation.
+ */
+typedef CPC_BOOL ( *cahal_async_routine )( void* io_argument );
+
+/*! \fn     typedef void ( *cahal_async_callback ) (
+              cahal_async_operation* in_operation,
+              CPC_BOOL               in_result,
+              void*                  in_user_data
+            )
+    \brief  Called on the control thread once an operation has completed. The
+            callback may submit other operations but must not wait on one, as
+            it would wait on itself.
+
+    \param  in_operation  The operation, which stays valid for the duration
+                          of the call even if the caller released it.
+    \param  in_result The result of the operation.
+    \param  in_user_data  The user data the operation was submitted with.
+ */
+typedef void  ( *cahal_async_callback ) (
+                                         cahal_async_operation* in_operation,
+                                         CPC_BOOL               in_result,
+                                         void*                  in_user_data
+                                         );
+
+/*! \var    cahal_async_operation_t
+    \brief  Struct definition for the handle of a queued operation.
+ */
+struct cahal_async_operation_t
+{
+  /*! \var    routine
+      \brief  The work of the operation.
+   */
+  cahal_async_routine             routine;
+
+  /*! \var    argument
+      \brief  The argument passed to routine.
+   */
+  void*                           argument;
+
+  /*! \var    callback
+      \brief  Called once routine has returned, or NULL.
+   */
+  cahal_async_callback            callback;
+
+  /*! \var    user_data
+      \brief  The user data passed to callback.
+   */
+  void*                           user_data;
+
+  /*! \var    lock
+      \brief  Protects is_complete and result.
+   */
+  cahal_mutex                     lock;
+
+  /*! \var    completed
+      \brief  Broadcast once is_complete is set.
+   */
+  cahal_condition                 completed;
+
+  /*! \var    is_complete
+      \brief  True once routine has returned and callback has been called.
+   */
+  CPC_BOOL                        is_complete;
+
+  /*! \var    result
+      \brief  The value returned by routine.
+   */
+  CPC_BOOL                        result;
+
+  /*! \var    references
+      \brief  The number of holders of the handle: the caller and, until the
+              operation has completed, the control thread.
+   */
+  cahal_atomic_uint32             references;
+
+  /*! \var    next
+      \brief  The operation queued after this one.
+   */
+  cahal_async_operation*          next;
+
+};
+
+/*! \fn     cahal_async_operation* cahal_async_submit  (
+              cahal_async_routine   in_routine,
+              void*                 io_argument,
+              cahal_async_callback  in_callback,
+              void*                 in_user_data
+            )
+    \brief  Queues in_routine( io_argument ) on the control thread and returns
+            without waiting for it.
+
+    \param  in_routine  The work of the operation.
+    \param  io_argument The argument passed to in_routine.
+    \param  in_callback Called on the control thread once the operation has
+                        completed, or NULL.
+    \param  in_user_data  The user data passed to in_callback.
+    \return The handle of the operation, to be released with
+            cahal_async_release, or NULL if it could not be queued (e.g.
+            after cahal_async_terminate), in which case in_routine is never
+            called.
+ */
+cahal_async_operation*
+cahal_async_submit  (
+                     cahal_async_routine   in_routine,
+                     void*                 io_argument,
+                     cahal_async_callback  in_callback,
+                     void*                 in_user_data
+                     );
+
+/*! \fn     CPC_BOOL cahal_async_is_complete (
+              cahal_async_operation* in_operation
+            )
+    \brief  Polls an operation without blocking.
+
+    \param  in_operation  The operation.
+    \return True iff the operation has completed and its callback returned.
+ */
+CPC_BOOL
+cahal_async_is_complete (
+                         cahal_async_operation* in_operation
+                         );
+
+/*! \fn     CPC_BOOL cahal_async_wait  (
+              cahal_async_operation* in_operation
+            )
+    \brief  Blocks until an operation has completed. Must not be called from
+            a cahal_async_callback.
+
+    \param  in_operation  The operation.
+    \return The result of the operation.
+ */
+CPC_BOOL
+cahal_async_wait  (
+                   cahal_async_operation* in_operation
+                   );
+
+/*! \fn     void cahal_async_release (
+              cahal_async_operation* io_operation
+            )
+    \brief  Gives up the caller's handle of an operation. An operation that
+            has not completed yet still runs, and still calls its callback.
+
+    \param  io_operation  The operation, which must not be used afterwards.
+ */
+void
+cahal_async_release (
+                     cahal_async_operation* io_operation
+                     );
+
+/*! \fn     void cahal_async_terminate( void )
+    \brief  Runs the operations that are still queued and stops the control
+            thread. Operations submitted afterwards are refused. Called by
+            cahal_terminate before the streams are stopped.
+ */
+void
+cahal_async_terminate( void );
+
+/*! \fn     cahal_async_operation* cahal_start_recording_async (
+              cahal_device*            in_device,
+              cahal_audio_format_id    in_format_id,
+              UINT32                   in_number_of_channels,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              cahal_recorder_callback  in_recorder,
+              void*                    in_callback_user_data,
+              cahal_audio_format_flag  in_format_flags,
+              cahal_async_callback     in_completion,
+              void*                    in_completion_user_data
+            )
+    \brief  Queues cahal_start_recording with the given parameters. in_device
+            must stay valid until the operation has completed.
+
+    \param  in_device The device to record from.
+    \param  in_format_id  The audio format to record in.
+    \param  in_number_of_channels The number of channels to record.
+    \param  in_sample_rate  The sample rate to record at.
+    \param  in_bit_depth  The number of bits per sample.
+    \param  in_recorder The callback receiving the recorded buffers.
+    \param  in_callback_user_data The user data passed to in_recorder.
+    \param  in_format_flags The flags to be used in the recording.
+    \param  in_completion Called once the recording has started (or failed
+                          to), or NULL.
+    \param  in_completion_user_data The user data passed to in_completion.
+    \return The handle of the operation, whose result is the one of
+            cahal_start_recording, or NULL if it could not be queued.
+ */
+cahal_async_operation*
+cahal_start_recording_async (
+                             cahal_device*            in_device,
+                             cahal_audio_format_id    in_format_id,
+                             UINT32                   in_number_of_channels,
+                             FLOAT64                  in_sample_rate,
+                             UINT32                   in_bit_depth,
+                             cahal_recorder_callback  in_recorder,
+                             void*                    in_callback_user_data,
+                             cahal_audio_format_flag  in_format_flags,
+                             cahal_async_callback     in_completion,
+                             void*                    in_completion_user_data
+                             );
+
+/*! \fn     cahal_async_operation* cahal_start_playback_async  (
+              cahal_device*            in_device,
+              cahal_audio_format_id    in_format_id,
+              UINT32                   in_number_of_channels,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              FLOAT32                  in_volume,
+              cahal_playback_callback  in_playback,
+              void*                    in_callback_user_data,
+              cahal_audio_format_flag  in_format_flags,
+              cahal_async_callback     in_completion,
+              void*                    in_completion_user_data
+            )
+    \brief  Queues cahal_start_playback with the given parameters. in_device
+            must stay valid until the operation has completed.
+
+    \param  in_device The device to play back to.
+    \param  in_format_id  The audio format samples are encoded in.
+    \param  in_number_of_channels The number of channels to play back.
+    \param  in_sample_rate  The sample rate to play back at.
+    \param  in_bit_depth  The number of bits per sample.
+    \param  in_volume Volume gain (value between 0 and 1).
+    \param  in_playback The callback filling the buffers to play back.
+    \param  in_callback_user_data The user data passed to in_playback.
+    \param  in_format_flags The flags to be used in the playback.
+    \param  in_completion Called once the playback has started (or failed
+                          to), or NULL.
+    \param  in_completion_user_data The user data passed to in_completion.
+    \return The handle of the operation, whose result is the one of
+            cahal_start_playback, or NULL if it could not be queued.
+ */
+cahal_async_operation*
+cahal_start_playback_async  (
+                             cahal_device*            in_device,
+                             cahal_audio_format_id    in_format_id,
+                             UINT32                   in_number_of_channels,
+                             FLOAT64                  in_sample_rate,
+                             UINT32                   in_bit_depth,
+                             FLOAT32                  in_volume,
+                             cahal_playback_callback  in_playback,
+                             void*                    in_callback_user_data,
+                             cahal_audio_format_flag  in_format_flags,
+                             cahal_async_callback     in_completion,
+                             void*                    in_completion_user_data
+                             );
+
+/*! \fn     cahal_async_operation* cahal_stop_recording_async  (
+              cahal_async_callback in_completion,
+              void*                in_completion_user_data
+            )
+    \brief  Queues cahal_stop_recording.
+
+    \param  in_completion Called once the recording has been stopped, or
+                          NULL.
+    \param  in_completion_user_data The user data passed to in_completion.
+    \return The handle of the operation, whose result is the one of
+            cahal_stop_recording, or NULL if it could not be queued.
+ */
+cahal_async_operation*
+cahal_stop_recording_async  (
+                             cahal_async_callback in_completion,
+                             void*                in_completion_user_data
+                             );
+
+/*! \fn     cahal_async_operation* cahal_stop_playback_async (
+              CPC_BOOL             in_drain,
+              cahal_async_callback in_completion,
+              void*                in_completion_user_data
+            )
+    \brief  Queues cahal_stop_playback, or cahal_drain_playback so that the
+            audio already handed to the OS is heard before the playback
+            stops.
+
+    \param  in_drain  True to let the queued audio play out first.
+    \param  in_completion Called once the playback has been stopped, or NULL.
+    \param  in_completion_user_data The user data passed to in_completion.
+    \return The handle of the operation, whose result is the one of
+            cahal_stop_playback (or cahal_drain_playback), or NULL if it
+            could not be queued.
+ */
+cahal_async_operation*
+cahal_stop_playback_async (
+                           CPC_BOOL             in_drain,
+                           cahal_async_callback in_completion,
+                           void*                in_completion_user_data
+                           );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_ASYNC_H__ */
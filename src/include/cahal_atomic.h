@@ -0,0 +1,95 @@
+/*! \file   cahal_atomic.h
+    \brief  Minimal set of atomic operations used by the lock-free structures
+            in the common layer. The operations map onto the compiler builtins
+            available on each of the supported platforms (GCC/Clang builtins
+            on Darwin and Android, Interlocked* intrinsics on Windows). Only
+            32-bit unsigned values are supported.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_ATOMIC_H__
+#define __CAHAL_ATOMIC_H__
+
+#include <cpcommon.h>
+
+#if defined( _MSC_VER )
+#include <windows.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \var    cahal_atomic_uint32
+    \brief  Type definition for a 32-bit unsigned value that is only accessed
+            using the CAHAL_ATOMIC_* macros.
+ */
+#if defined( _MSC_VER )
+typedef volatile LONG cahal_atomic_uint32;
+#else
+typedef volatile UINT32 cahal_atomic_uint32;
+#endif
+
+#if defined( _MSC_VER )
+
+/*! \def    CAHAL_ATOMIC_LOAD
+    \brief  Loads the value pointed to by in_pointer with acquire semantics.
+ */
+#define CAHAL_ATOMIC_LOAD( in_pointer )                                       \
+  ( ( UINT32 ) InterlockedOr( ( in_pointer ), 0 ) )
+
+/*! \def    CAHAL_ATOMIC_STORE
+    \brief  Stores in_value into the location pointed to by in_pointer with
+            release semantics.
+ */
+#define CAHAL_ATOMIC_STORE( in_pointer, in_value )                            \
+  ( ( void ) InterlockedExchange( ( in_pointer ), ( LONG ) ( in_value ) ) )
+
+/*! \def    CAHAL_ATOMIC_ADD
+    \brief  Adds in_value to the location pointed to by in_pointer and returns
+            the new value.
+ */
+#define CAHAL_ATOMIC_ADD( in_pointer, in_value )                              \
+  ( ( UINT32 ) ( InterlockedExchangeAdd  (                                   \
+                   ( in_pointer ),                                            \
+                   ( LONG ) ( in_value )                                      \
+                   ) + ( LONG ) ( in_value ) ) )
+
+/*! \def    CAHAL_ATOMIC_COMPARE_AND_SWAP
+    \brief  Atomically replaces the value pointed to by in_pointer with
+            in_desired iff it is currently equal to in_expected. Evaluates to
+            true iff the swap took place.
+ */
+#define CAHAL_ATOMIC_COMPARE_AND_SWAP( in_pointer, in_expected, in_desired )  \
+  ( InterlockedCompareExchange  (                                             \
+                                 ( in_pointer ),                              \
+                                 ( LONG ) ( in_desired ),                     \
+                                 ( LONG ) ( in_expected )                     \
+                                 ) == ( LONG ) ( in_expected ) )
+
+#else
+
+#define CAHAL_ATOMIC_LOAD( in_pointer )                                       \
+  __atomic_load_n( ( in_pointer ), __ATOMIC_ACQUIRE )
+
+#define CAHAL_ATOMIC_STORE( in_pointer, in_value )                            \
+  __atomic_store_n( ( in_pointer ), ( in_value ), __ATOMIC_RELEASE )
+
+#define CAHAL_ATOMIC_ADD( in_pointer, in_value )                              \
+  __atomic_add_fetch( ( in_pointer ), ( in_value ), __ATOMIC_ACQ_REL )
+
+#define CAHAL_ATOMIC_COMPARE_AND_SWAP( in_pointer, in_expected, in_desired )  \
+  __sync_bool_compare_and_swap  (                                            \
+                                 ( in_pointer ),                              \
+                                 ( in_expected ),                             \
+                                 ( in_desired )                               \
+                                 )
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_ATOMIC_H__ */
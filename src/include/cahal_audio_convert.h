@@ -0,0 +1,201 @@
+/*! \file   cahal_audio_convert.h
+    \brief  Helpers to convert linear PCM sample buffers, as they are passed to
+            and from the CAHAL callbacks, to and from 32-bit floating point
+            samples in the range [ -1, 1 ]. All processing done inside the
+            library (e.g. resampling) is performed on floating point samples.
+            Floating point frames can also be split into (and rebuilt from)
+            one block of samples per channel and moved between channel
+            layouts.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_AUDIO_CONVERT_H__
+#define __CAHAL_AUDIO_CONVERT_H__
+
+#include <cpcommon.h>
+
+#include "cahal_audio_format_flags.h"
+#include "cahal_audio_format_description.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \fn     UINT32 cahal_get_bytes_per_sample (
+              UINT32 in_bit_depth
+            )
+    \brief  Returns the number of bytes used to store a single packed sample of
+            in_bit_depth bits.
+
+    \param  in_bit_depth  The quantization level of the sample.
+    \return The number of bytes required to store a single sample.
+ */
+UINT32
+cahal_get_bytes_per_sample (
+                            UINT32 in_bit_depth
+                            );
+
+/*! \fn     CPC_BOOL cahal_test_conversion_support (
+              UINT32                  in_bit_depth,
+              cahal_audio_format_flag in_format_flags
+            )
+    \brief  Tests whether or not samples with the given bit depth and flags
+            can be converted to and from floating point samples.
+
+    \param  in_bit_depth  The quantization level of the samples.
+    \param  in_format_flags The CAHAL format flags describing the samples.
+    \return True iff cahal_convert_to_float32 and cahal_convert_from_float32
+            support the sample format.
+ */
+CPC_BOOL
+cahal_test_conversion_support (
+                               UINT32                  in_bit_depth,
+                               cahal_audio_format_flag in_format_flags
+                               );
+
+/*! \fn     CPC_BOOL cahal_convert_to_float32  (
+              const UCHAR*            in_buffer,
+              UINT32                  in_number_of_samples,
+              UINT32                  in_bit_depth,
+              cahal_audio_format_flag in_format_flags,
+              FLOAT32*                out_samples
+            )
+    \brief  Converts in_number_of_samples linear PCM samples stored in
+            in_buffer to floating point samples. Multi-channel buffers are
+            converted sample by sample, i.e. in_number_of_samples is the number
+            of frames multiplied by the number of channels.
+
+    \param  in_buffer The packed linear PCM samples to convert.
+    \param  in_number_of_samples  The number of samples in in_buffer.
+    \param  in_bit_depth  The quantization level of the samples in in_buffer.
+    \param  in_format_flags The CAHAL format flags describing in_buffer.
+    \param  out_samples The converted samples. Must hold at least
+                        in_number_of_samples samples.
+    \return True iff the samples were converted.
+ */
+CPC_BOOL
+cahal_convert_to_float32  (
+                           const UCHAR*            in_buffer,
+                           UINT32                  in_number_of_samples,
+                           UINT32                  in_bit_depth,
+                           cahal_audio_format_flag in_format_flags,
+                           FLOAT32*                out_samples
+                           );
+
+/*! \fn     CPC_BOOL cahal_convert_from_float32  (
+              const FLOAT32*          in_samples,
+              UINT32                  in_number_of_samples,
+              UINT32                  in_bit_depth,
+              cahal_audio_format_flag in_format_flags,
+              UCHAR*                  out_buffer
+            )
+    \brief  Converts in_number_of_samples floating point samples to packed
+            linear PCM samples. Samples outside of [ -1, 1 ] are clipped.
+
+    \param  in_samples  The floating point samples to convert.
+    \param  in_number_of_samples  The number of samples in in_samples.
+    \param  in_bit_depth  The quantization level to convert to.
+    \param  in_format_flags The CAHAL format flags describing out_buffer.
+    \param  out_buffer  The converted samples. Must be at least
+                        in_number_of_samples
+                        * cahal_get_bytes_per_sample( in_bit_depth ) bytes.
+    \return True iff the samples were converted.
+ */
+CPC_BOOL
+cahal_convert_from_float32  (
+                             const FLOAT32*          in_samples,
+                             UINT32                  in_number_of_samples,
+                             UINT32                  in_bit_depth,
+                             cahal_audio_format_flag in_format_flags,
+                             UCHAR*                  out_buffer
+                             );
+
+/*! \fn     CPC_BOOL cahal_deinterleave_float32  (
+              const FLOAT32*  in_samples,
+              UINT32          in_number_of_frames,
+              UINT32          in_number_of_channels,
+              FLOAT32*        out_samples
+            )
+    \brief  Splits interleaved frames into one contiguous block of
+            in_number_of_frames samples per channel, channel 0 first, so that
+            per-channel processing can run over unit-stride buffers.
+
+    \param  in_samples  The interleaved frames.
+    \param  in_number_of_frames The number of frames in in_samples.
+    \param  in_number_of_channels The number of channels in each frame.
+    \param  out_samples The deinterleaved samples. Must hold
+                        in_number_of_frames * in_number_of_channels samples and
+                        must not overlap in_samples.
+    \return True iff the samples were deinterleaved.
+ */
+CPC_BOOL
+cahal_deinterleave_float32  (
+                             const FLOAT32*  in_samples,
+                             UINT32          in_number_of_frames,
+                             UINT32          in_number_of_channels,
+                             FLOAT32*        out_samples
+                             );
+
+/*! \fn     CPC_BOOL cahal_interleave_float32  (
+              const FLOAT32*  in_samples,
+              UINT32          in_number_of_frames,
+              UINT32          in_number_of_channels,
+              FLOAT32*        out_samples
+            )
+    \brief  The inverse of cahal_deinterleave_float32.
+
+    \param  in_samples  One contiguous block of in_number_of_frames samples
+                        per channel, channel 0 first.
+    \param  in_number_of_frames The number of samples per channel.
+    \param  in_number_of_channels The number of channels.
+    \param  out_samples The interleaved frames. Must hold
+                        in_number_of_frames * in_number_of_channels samples and
+                        must not overlap in_samples.
+    \return True iff the samples were interleaved.
+ */
+CPC_BOOL
+cahal_interleave_float32  (
+                           const FLOAT32*  in_samples,
+                           UINT32          in_number_of_frames,
+                           UINT32          in_number_of_channels,
+                           FLOAT32*        out_samples
+                           );
+
+/*! \fn     CPC_BOOL cahal_remap_channels_float32  (
+              const FLOAT32*              in_samples,
+              UINT32                      in_number_of_frames,
+              const cahal_channel_layout* in_input_layout,
+              const cahal_channel_layout* in_output_layout,
+              FLOAT32*                    out_samples
+            )
+    \brief  Moves every channel of in_input_layout to the position of the
+            same speaker (or array element) in in_output_layout. Output
+            channels that in_input_layout does not carry are silent and input
+            channels that in_output_layout does not carry are dropped, e.g. to
+            select a subset of the elements of a mic array.
+
+    \param  in_samples  The interleaved frames laid out as in_input_layout.
+    \param  in_number_of_frames The number of frames in in_samples.
+    \param  in_input_layout The layout of in_samples.
+    \param  in_output_layout  The layout of out_samples. Must be of the same
+                              type as in_input_layout.
+    \param  out_samples The remapped frames. Must hold in_number_of_frames
+                        frames of in_output_layout and must not overlap
+                        in_samples.
+    \return True iff the samples were remapped.
+ */
+CPC_BOOL
+cahal_remap_channels_float32  (
+                               const FLOAT32*              in_samples,
+                               UINT32                      in_number_of_frames,
+                               const cahal_channel_layout* in_input_layout,
+                               const cahal_channel_layout* in_output_layout,
+                               FLOAT32*                    out_samples
+                               );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_AUDIO_CONVERT_H__ */
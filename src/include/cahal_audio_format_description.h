@@ -100,6 +100,90 @@ enum cahal_audio_format_ids
   CAHAL_AUDIO_FORMAT_UNKNOWN,
 };
 
+/*! \def    CAHAL_MAXIMUM_NUMBER_OF_CHANNELS
+    \brief  The largest number of channels a stream may carry. Every channel
+            of a stream has a bit in a cahal_channel_layout's channel_mask.
+ */
+#define CAHAL_MAXIMUM_NUMBER_OF_CHANNELS  64
+
+/*! \def    CAHAL_NO_CHANNEL
+    \brief  Returned by cahal_get_channel_index when a layout does not carry
+            the requested channel.
+ */
+#define CAHAL_NO_CHANNEL                  0xFFFFFFFF
+
+/*! \var    cahal_channel_layout_type
+    \brief  Definition for the channel layout types.
+ */
+typedef UINT32 cahal_channel_layout_type;
+
+/*! \enum   cahal_channel_layout_types
+    \brief  The ways in which the channels of a frame can be described.
+            CAHAL_CHANNEL_LAYOUT_UNSPECIFIED is used when the platform does not
+            report a layout, CAHAL_CHANNEL_LAYOUT_SPEAKERS when every channel
+            feeds (or is recorded from) a speaker position and
+            CAHAL_CHANNEL_LAYOUT_DISCRETE when channels are the elements of an
+            array (e.g. the microphones of a mic array) and have no position.
+ */
+enum cahal_channel_layout_types
+{
+  CAHAL_CHANNEL_LAYOUT_UNSPECIFIED,
+  CAHAL_CHANNEL_LAYOUT_SPEAKERS,
+  CAHAL_CHANNEL_LAYOUT_DISCRETE,
+};
+
+/*! \enum   cahal_channel_positions
+    \brief  The speaker positions of a CAHAL_CHANNEL_LAYOUT_SPEAKERS layout.
+            Each is the index of the position's bit in channel_mask and the
+            order matches the speaker masks of WAVEFORMATEXTENSIBLE, OpenSL ES
+            and the Core Audio channel bitmap, so masks can be passed between
+            CAHAL and the platforms unchanged.
+ */
+enum cahal_channel_positions
+{
+  CAHAL_CHANNEL_FRONT_LEFT,
+  CAHAL_CHANNEL_FRONT_RIGHT,
+  CAHAL_CHANNEL_FRONT_CENTER,
+  CAHAL_CHANNEL_LOW_FREQUENCY,
+  CAHAL_CHANNEL_BACK_LEFT,
+  CAHAL_CHANNEL_BACK_RIGHT,
+  CAHAL_CHANNEL_FRONT_LEFT_OF_CENTER,
+  CAHAL_CHANNEL_FRONT_RIGHT_OF_CENTER,
+  CAHAL_CHANNEL_BACK_CENTER,
+  CAHAL_CHANNEL_SIDE_LEFT,
+  CAHAL_CHANNEL_SIDE_RIGHT,
+  CAHAL_CHANNEL_TOP_CENTER,
+  CAHAL_CHANNEL_TOP_FRONT_LEFT,
+  CAHAL_CHANNEL_TOP_FRONT_CENTER,
+  CAHAL_CHANNEL_TOP_FRONT_RIGHT,
+  CAHAL_CHANNEL_TOP_BACK_LEFT,
+  CAHAL_CHANNEL_TOP_BACK_CENTER,
+  CAHAL_CHANNEL_TOP_BACK_RIGHT,
+  CAHAL_CHANNEL_NUMBER_OF_POSITIONS,
+};
+
+/*! \var    cahal_channel_layout
+    \brief  Describes what each channel of an interleaved frame carries.
+            Channels appear in a frame in the order of the set bits of
+            channel_mask, lowest bit first.
+ */
+typedef struct cahal_channel_layout_t
+{
+  /*! \var    layout_type
+      \brief  One of cahal_channel_layout_types.
+   */
+  cahal_channel_layout_type layout_type;
+
+  /*! \var    channel_mask
+      \brief  For CAHAL_CHANNEL_LAYOUT_SPEAKERS bit i is set iff the frame
+              carries speaker position i (see cahal_channel_positions). For
+              CAHAL_CHANNEL_LAYOUT_DISCRETE bit i is set iff the frame carries
+              array element i. 0 for CAHAL_CHANNEL_LAYOUT_UNSPECIFIED.
+   */
+  UINT64                    channel_mask;
+
+} cahal_channel_layout;
+
 /*! \var    cahal_sample_rate_range
     \brief  This struct is used to represent the sample rate ranges supported
             by various audio IO hardware devices. Sample rates are generally
@@ -153,6 +237,11 @@ typedef struct cahal_audio_format_description_t
    */
   UINT32                  bit_depth;
   
+  /*! \var    channel_layout
+      \brief  What each of the number_of_channels channels carries.
+   */
+  cahal_channel_layout    channel_layout;
+  
 } cahal_audio_format_description;
 
 /*! \fn      CHAR* cahal_convert_audio_format_id_to_cstring  (
@@ -205,6 +294,104 @@ cahal_print_audio_format_id (
                              cahal_audio_format_id  in_format_id
                              );
 
+/*! \fn     CPC_BOOL cahal_get_default_channel_layout  (
+              UINT32                in_number_of_channels,
+              cahal_channel_layout* out_channel_layout
+            )
+    \brief  Returns the layout conventionally used for in_number_of_channels
+            channels: mono, stereo, 3.0, quad, 5.0, 5.1, 6.1 and 7.1 speaker
+            layouts for up to 8 channels and a discrete layout of elements
+            0 to in_number_of_channels - 1 for wider streams.
+
+    \param  in_number_of_channels The number of channels in a frame.
+    \param  out_channel_layout  The default layout.
+    \return True iff in_number_of_channels is in the range [ 1,
+            CAHAL_MAXIMUM_NUMBER_OF_CHANNELS ].
+ */
+CPC_BOOL
+cahal_get_default_channel_layout  (
+                                   UINT32                in_number_of_channels,
+                                   cahal_channel_layout* out_channel_layout
+                                   );
+
+/*! \fn     UINT32 cahal_get_channel_layout_size  (
+              const cahal_channel_layout* in_channel_layout
+            )
+    \brief  Returns the number of channels carried by in_channel_layout.
+
+    \param  in_channel_layout The layout to count.
+    \return The number of bits set in its channel_mask.
+ */
+UINT32
+cahal_get_channel_layout_size  (
+                                const cahal_channel_layout* in_channel_layout
+                                );
+
+/*! \fn     UINT32 cahal_get_channel_index  (
+              const cahal_channel_layout* in_channel_layout,
+              UINT32                      in_channel
+            )
+    \brief  Returns the position within a frame of the channel carrying the
+            speaker position or array element in_channel.
+
+    \param  in_channel_layout The layout of the frame.
+    \param  in_channel  A speaker position (see cahal_channel_positions) or
+                        array element, depending on the layout's type.
+    \return The index of the channel within a frame or CAHAL_NO_CHANNEL if
+            in_channel_layout does not carry in_channel.
+ */
+UINT32
+cahal_get_channel_index  (
+                          const cahal_channel_layout* in_channel_layout,
+                          UINT32                      in_channel
+                          );
+
+/*! \fn     CPC_BOOL cahal_test_channel_layout  (
+              const cahal_channel_layout* in_channel_layout,
+              UINT32                      in_number_of_channels
+            )
+    \brief  Tests whether in_channel_layout can describe frames of
+            in_number_of_channels channels.
+
+    \param  in_channel_layout The layout to test.
+    \param  in_number_of_channels The number of channels in a frame.
+    \return True iff in_number_of_channels is in the range [ 1,
+            CAHAL_MAXIMUM_NUMBER_OF_CHANNELS ] and in_channel_layout is either
+            unspecified or a speaker or discrete layout carrying exactly
+            in_number_of_channels channels.
+ */
+CPC_BOOL
+cahal_test_channel_layout  (
+                            const cahal_channel_layout* in_channel_layout,
+                            UINT32                      in_number_of_channels
+                            );
+
+/*! \fn     CHAR* cahal_convert_channel_layout_type_to_cstring  (
+              cahal_channel_layout_type in_layout_type
+            )
+    \brief  Returns the name of in_layout_type. The string must not be freed.
+
+    \param  in_layout_type  The layout type to name.
+    \return The name of the layout type.
+ */
+CHAR*
+cahal_convert_channel_layout_type_to_cstring  (
+                                      cahal_channel_layout_type in_layout_type
+                                               );
+
+/*! \fn     void cahal_free_audio_format_description_list (
+              cahal_audio_format_description** in_format_list
+            )
+    \brief  Frees all format descriptions in the null-terminated list and then
+            frees the list itself.
+ 
+    \param  in_format_list  The list to free. May be NULL.
+ */
+void
+cahal_free_audio_format_description_list (
+                       cahal_audio_format_description** in_format_list
+                                          );
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,145 @@
+/*! \file   cahal_callback.h
+    \brief  Platform agnostic dispatch of recorded and playback buffers to the
+            caller-supplied callbacks. The platform-specific callbacks hand
+            every buffer to these functions rather than calling the
+            cahal_recorder_callback / cahal_playback_callback directly so that
+            processing shared by all platforms (e.g. echo cancellation and
+            capture filtering) is done in one place.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_CALLBACK_H__
+#define __CAHAL_CALLBACK_H__
+
+#include <cpcommon.h>
+
+#include "cahal.h"
+#include "cahal_coalescer.h"
+#include "cahal_device.h"
+#include "cahal_dispatcher.h"
+#include "cahal_echo_canceller.h"
+#include "cahal_filter_bank.h"
+#include "cahal_playback_schedule.h"
+#include "cahal_stream_state.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \fn     CPC_BOOL cahal_dispatch_recording  (
+              cahal_recorder_info* in_recorder_info,
+              UCHAR*               io_data_buffer,
+              UINT32               in_data_buffer_length
+            )
+    \brief  Processes a buffer of recorded samples and passes it to the
+            recording callback in in_recorder_info, or hands it to the
+            recording's dispatch thread to do so. Must be called as soon as
+            the buffer is received from the OS since the time of the call is
+            used as the time the buffer was completed.
+
+    \param  in_recorder_info  The recording that the buffer belongs to.
+    \param  io_data_buffer  The recorded samples. The buffer may be modified.
+    \param  in_data_buffer_length The size of io_data_buffer in bytes.
+    \return The value returned by the recording callback. With a dispatch
+            thread, false once the callback has returned false. False without
+            touching in_recorder_info once the recording is stopping (see
+            cahal_stream_state_enter_callback).
+ */
+CPC_BOOL
+cahal_dispatch_recording  (
+                           cahal_recorder_info* in_recorder_info,
+                           UCHAR*               io_data_buffer,
+                           UINT32               in_data_buffer_length
+                           );
+
+/*! \fn     CPC_BOOL cahal_dispatch_playback (
+              cahal_playback_info* in_playback_info,
+              UCHAR*               out_data_buffer,
+              UINT32*              io_data_buffer_length,
+              UINT32               in_queued_bytes
+            )
+    \brief  Fills a playback buffer using the playback callback in
+            in_playback_info, or with the samples rendered ahead by the
+            playback's dispatch thread, and taps the result for processing
+            done on the recording path. A scheduled playback is silent until
+            its start time, where the first sample of the callback is spliced
+            in.
+
+    \param  in_playback_info  The playback that the buffer belongs to.
+    \param  out_data_buffer The buffer to fill.
+    \param  io_data_buffer_length The capacity of out_data_buffer on input, the
+                                  number of bytes written on output.
+    \param  in_queued_bytes The number of bytes queued in the OS that will be
+                            played before the first sample in out_data_buffer.
+    \return The value returned by the playback callback. With a dispatch
+            thread, false once the callback has returned false and the
+            samples it rendered before have been played. False, with nothing
+            written, without touching in_playback_info once the playback is
+            stopping.
+ */
+CPC_BOOL
+cahal_dispatch_playback (
+                         cahal_playback_info* in_playback_info,
+                         UCHAR*               out_data_buffer,
+                         UINT32*              io_data_buffer_length,
+                         UINT32               in_queued_bytes
+                         );
+
+/*! \fn     CPC_BOOL cahal_process_recording  (
+              cahal_recorder_info* in_recorder_info,
+              UCHAR*               io_data_buffer,
+              UINT32               in_data_buffer_length,
+              UINT64               in_record_time
+            )
+    \brief  Processes a buffer of recorded samples and passes it to the
+            recording callback in in_recorder_info on the calling thread, or
+            to the coalescer of the recording, which calls the callback once
+            enough samples have been accumulated.
+
+    \param  in_recorder_info  The recording that the buffer belongs to.
+    \param  io_data_buffer  The recorded samples. The buffer may be modified.
+    \param  in_data_buffer_length The size of io_data_buffer in bytes.
+    \param  in_record_time  The time (ns) the first sample was recorded.
+    \return The value returned by the recording callback. With a coalescer,
+            false once the callback has returned false.
+ */
+CPC_BOOL
+cahal_process_recording  (
+                          cahal_recorder_info* in_recorder_info,
+                          UCHAR*               io_data_buffer,
+                          UINT32               in_data_buffer_length,
+                          UINT64               in_record_time
+                          );
+
+/*! \fn     CPC_BOOL cahal_process_playback (
+              cahal_playback_info* in_playback_info,
+              UCHAR*               out_data_buffer,
+              UINT32*              io_data_buffer_length,
+              UINT32               in_queued_bytes
+            )
+    \brief  Fills a playback buffer using the playback callback in
+            in_playback_info on the calling thread and taps the result for
+            processing done on the recording path.
+
+    \param  in_playback_info  The playback that the buffer belongs to.
+    \param  out_data_buffer The buffer to fill.
+    \param  io_data_buffer_length The capacity of out_data_buffer on input, the
+                                  number of bytes written on output.
+    \param  in_queued_bytes The number of bytes that will be played before
+                            the first sample in out_data_buffer.
+    \return The value returned by the playback callback.
+ */
+CPC_BOOL
+cahal_process_playback (
+                        cahal_playback_info* in_playback_info,
+                        UCHAR*               out_data_buffer,
+                        UINT32*              io_data_buffer_length,
+                        UINT32               in_queued_bytes
+                        );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_CALLBACK_H__ */
@@ -0,0 +1,231 @@
+/*! \file   cahal_coalescer.h
+    \brief  Callback coalescing for bulk capture. At small hardware periods
+            the cost of every call to the recording callback dominates,
+            especially when the callback has to take a lock such as the
+            Python GIL. Once coalescing options are set using
+            cahal_set_coalesce_options every recording started afterwards
+            accumulates the recorded periods and calls its callback with one
+            large contiguous buffer instead. The OS still delivers small
+            periods, so the latency of capture is unchanged; only the latency
+            of the callback grows by the size of the buffer.
+
+            The periods are accumulated after echo cancellation and capture
+            filtering, on the thread that would have called the callback (the
+            OS thread or the dispatch thread of the recording), so the
+            accumulation is never shared between threads. Every callback
+            gets exactly buffer_size bytes, except the last one, which gets
+            whatever is left once the recording stops.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_COALESCER_H__
+#define __CAHAL_COALESCER_H__
+
+#include <cpcommon.h>
+
+#include "cahal_device.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_COALESCE_DEFAULT_NUMBER_OF_PERIODS
+    \brief  The number of periods per callback used when no budget is given.
+ */
+#define CAHAL_COALESCE_DEFAULT_NUMBER_OF_PERIODS  8
+
+/*! \var    cahal_coalesce_options
+    \brief  Struct definition for the budget of a coalesced callback. The
+            largest of the budgets that are set is used; if none are set
+            CAHAL_COALESCE_DEFAULT_NUMBER_OF_PERIODS periods are used.
+ */
+typedef struct cahal_coalesce_options_t
+{
+  /*! \var    number_of_periods
+      \brief  The number of OS periods (the largest buffer the OS delivers in
+              one callback) per callback, or 0.
+   */
+  UINT32  number_of_periods;
+
+  /*! \var    number_of_bytes
+      \brief  The number of bytes per callback, or 0.
+   */
+  UINT32  number_of_bytes;
+
+  /*! \var    duration
+      \brief  The amount of audio (in seconds) per callback, or 0.
+   */
+  FLOAT64 duration;
+
+} cahal_coalesce_options;
+
+/*! \var    cahal_coalescer
+    \brief  Struct definition for the accumulation of one recording.
+ */
+typedef struct cahal_coalescer_t
+{
+  /*! \var    buffer
+      \brief  The samples accumulated since the last callback.
+   */
+  UCHAR*    buffer;
+
+  /*! \var    buffer_size
+      \brief  The number of bytes passed to every callback, a whole number of
+              frames.
+   */
+  UINT32    buffer_size;
+
+  /*! \var    fill
+      \brief  The number of bytes in buffer.
+   */
+  UINT32    fill;
+
+  /*! \var    has_failed
+      \brief  Set once the callback returned false. Every later buffer is
+              discarded.
+   */
+  CPC_BOOL  has_failed;
+
+} cahal_coalescer;
+
+/*! \fn     void cahal_set_coalesce_options  (
+              const cahal_coalesce_options* in_options
+            )
+    \brief  Sets the budget of the callbacks of the recordings started
+            afterwards. Recordings that are running keep theirs.
+
+    \param  in_options  The options to copy, or NULL to call the callbacks of
+                        new recordings once per OS period again.
+ */
+void
+cahal_set_coalesce_options  (
+                             const cahal_coalesce_options* in_options
+                             );
+
+/*! \fn     CPC_BOOL cahal_get_coalesce_options  (
+              cahal_coalesce_options* out_options
+            )
+    \brief  Returns the options set using cahal_set_coalesce_options.
+
+    \param  out_options The options. Left untouched if recordings are not
+                        coalesced.
+    \return True iff the callbacks of new recordings are coalesced.
+ */
+CPC_BOOL
+cahal_get_coalesce_options  (
+                             cahal_coalesce_options* out_options
+                             );
+
+/*! \fn     cahal_coalescer* cahal_coalescer_create  (
+              const cahal_coalesce_options* in_options,
+              cahal_recorder_info*          in_recorder_info,
+              UINT32                        in_buffer_size
+            )
+    \brief  Creates the accumulation of a recording.
+
+    \param  in_options  The budget of the callbacks.
+    \param  in_recorder_info  The recording, whose format sets the size of a
+                              frame.
+    \param  in_buffer_size  The largest number of bytes the OS delivers in one
+                            callback.
+    \return The coalescer or NULL on error. Free using cahal_coalescer_free.
+ */
+cahal_coalescer*
+cahal_coalescer_create  (
+                         const cahal_coalesce_options* in_options,
+                         cahal_recorder_info*          in_recorder_info,
+                         UINT32                        in_buffer_size
+                         );
+
+/*! \fn     void cahal_coalescer_free  (
+              cahal_coalescer* in_coalescer
+            )
+    \brief  Frees the coalescer, discarding the samples it holds.
+
+    \param  in_coalescer  The coalescer to free.
+ */
+void
+cahal_coalescer_free  (
+                       cahal_coalescer* in_coalescer
+                       );
+
+/*! \fn     CPC_BOOL cahal_coalescer_push  (
+              cahal_coalescer*     io_coalescer,
+              cahal_recorder_info* in_recorder_info,
+              const UCHAR*         in_data_buffer,
+              UINT32               in_data_buffer_length
+            )
+    \brief  Appends a recorded buffer and calls the recording callback once
+            for every buffer_size bytes accumulated.
+
+    \param  io_coalescer  The coalescer of the recording.
+    \param  in_recorder_info  The recording.
+    \param  in_data_buffer  The recorded samples. They are copied.
+    \param  in_data_buffer_length The size of in_data_buffer in bytes.
+    \return False iff the recording callback has returned false.
+ */
+CPC_BOOL
+cahal_coalescer_push  (
+                       cahal_coalescer*     io_coalescer,
+                       cahal_recorder_info* in_recorder_info,
+                       const UCHAR*         in_data_buffer,
+                       UINT32               in_data_buffer_length
+                       );
+
+/*! \fn     CPC_BOOL cahal_coalescer_flush (
+              cahal_coalescer*     io_coalescer,
+              cahal_recorder_info* in_recorder_info
+            )
+    \brief  Calls the recording callback with the samples accumulated so far,
+            if any.
+
+    \param  io_coalescer  The coalescer of the recording.
+    \param  in_recorder_info  The recording.
+    \return False iff the recording callback has returned false.
+ */
+CPC_BOOL
+cahal_coalescer_flush (
+                       cahal_coalescer*     io_coalescer,
+                       cahal_recorder_info* in_recorder_info
+                       );
+
+/*! \fn     CPC_BOOL cahal_attach_recording_coalescer  (
+              cahal_recorder_info*  io_recorder_info,
+              UINT32                in_buffer_size
+            )
+    \brief  Creates the coalescer of a recording if coalescing options are
+            set. Called by the platforms once io_recorder_info is filled in
+            and before its dispatcher is attached.
+
+    \param  io_recorder_info  The recording. Its coalescer is set.
+    \param  in_buffer_size  The largest number of bytes the OS delivers in one
+                            callback.
+    \return True iff the recording may start.
+ */
+CPC_BOOL
+cahal_attach_recording_coalescer  (
+                                   cahal_recorder_info*  io_recorder_info,
+                                   UINT32                in_buffer_size
+                                   );
+
+/*! \fn     void cahal_detach_recording_coalescer  (
+              cahal_recorder_info* io_recorder_info
+            )
+    \brief  Passes the samples still accumulated to the recording callback, on
+            the calling thread, and frees the coalescer of a recording, if
+            any. Called by the platforms once the OS has stopped delivering
+            buffers and the dispatcher has been detached.
+
+    \param  io_recorder_info  The recording.
+ */
+void
+cahal_detach_recording_coalescer  (
+                                   cahal_recorder_info* io_recorder_info
+                                   );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_COALESCER_H__ */
@@ -15,6 +15,8 @@
 #include "cahal_audio_format_flags.h"
 #include "cahal_audio_format_description.h"
 #include "cahal_device_stream.h"
+#include "cahal_arena.h"
+#include "cahal_thread.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -33,11 +35,39 @@ extern "C"
  */
 #define CAHAL_QUEUE_NUMBER_OF_QUEUES          5
 
+/*! \def    CAHAL_DRAIN_POLL_INTERVAL
+    \brief  The time (in milliseconds) cahal_drain_playback sleeps between
+            two checks of whether the OS has played out its buffers.
+ */
+#define CAHAL_DRAIN_POLL_INTERVAL             10
+
+/*! \def    CAHAL_DRAIN_TIMEOUT
+    \brief  The time (in milliseconds) after which cahal_drain_playback stops
+            the playback even if the OS has not played out its buffers, e.g.
+            because the device was removed. Every queued buffer is played well
+            within this time.
+ */
+#define CAHAL_DRAIN_TIMEOUT                                                  \
+  ( ( CAHAL_QUEUE_NUMBER_OF_QUEUES + 1 ) * CAHAL_QUEUE_BUFFER_DURATION * 1000 )
+
 /*! \var    cahal_device_handle
     \brief  Type definition for device handles
  */
 typedef UINT32 cahal_device_handle;
 
+struct cahal_device_t;
+
+/*! \def    cahal_device_details_loader
+    \brief  The function prototype of the platform specific function that
+            loads the details of a lazily enumerated device.
+
+    \param  io_device The device whose details are to be loaded.
+    \return True iff every detail was loaded.
+ */
+typedef CPC_BOOL (*cahal_device_details_loader) (
+                                         struct cahal_device_t* io_device
+                                                 );
+
 /*! \var    cahal_device
     \brief  Struct definition for devices
  */
@@ -131,14 +161,53 @@ typedef struct cahal_device_t
    */
   UINT32                is_running;
   
+  /*! \var    details_loader
+      \brief  Set by the platform when the device is enumerated lazily (see
+              cahal_set_lazy_device_details). It loads the details of the
+              device, i.e. every member except handle, device_name,
+              device_uid and the handle and direction of each stream, the
+              first time cahal_load_device_details is called. NULL if the
+              details were loaded when the device was enumerated.
+   */
+  cahal_device_details_loader details_loader;
+  
+  /*! \var    details_state
+      \brief  One of cahal_once_states. CAHAL_ONCE_PENDING while the details
+              have not been loaded yet.
+   */
+  cahal_atomic_uint32   details_state;
+  
 } cahal_device;
 
 /*! \var    g_device_list
     \brief  The global device list that is set the first time that
-            cahal_get_device_list is called.
+            cahal_get_device_list is called. It is the device list of the
+            current cahal_device_snapshot and is reset to NULL when
+            cahal_refresh_device_list publishes a new snapshot.
  */
 extern cahal_device** g_device_list;
 
+/*! \var    g_cahal_lazy_device_details
+    \brief  True iff devices are enumerated lazily. Set using
+            cahal_set_lazy_device_details.
+ */
+extern CPC_BOOL g_cahal_lazy_device_details;
+
+/*! \def    cahal_device_list_callback
+    \brief  The function prototype of the callback that is called with each
+            device as soon as it has been enumerated.
+
+    \param  in_device The device that has been enumerated. While the list is
+                      being built the device is only valid for the duration
+                      of the call; use the list returned by
+                      cahal_enumerate_devices to keep a reference to it.
+    \param  in_user_data  The user data passed along with the callback.
+ */
+typedef void (*cahal_device_list_callback) (
+                                   cahal_device* in_device,
+                                   void*         in_user_data
+                                   );
+
 /*! \def    cahal_recorder_callback
     \brief  The function prototype for the callback used when buffers of
             recorded samples are available from an input device. The callback
@@ -151,7 +220,8 @@ extern cahal_device** g_device_list;
             that was passed into cahal_start_recording. The callback that
             receives the populated buffer is responsible for decoding.
             Similarly, the bit depth and number of channels must also be taken
-            into account.
+            into account. Channels are interleaved in the order of the layout
+            returned by cahal_get_stream_channel_layout.
  
     \note   At this time only constant bit-rate codes are supported. When VBR
             codes are supported additional information will need to be passed
@@ -188,7 +258,8 @@ typedef CPC_BOOL (*cahal_recorder_callback) (
             that was passed into cahal_start_playback. The callback that
             receives the empty buffer is responsible for encoding the data.
             The data encoded must be in the correct format, bit depth and sample
-            rate.
+            rate, with channels interleaved in the order of the layout
+            returned by cahal_get_stream_channel_layout.
 
     \note   At this time only constant bit-rate codes are supported. When VBR
             codes are supported additional information will need to be passed
@@ -249,6 +320,48 @@ typedef struct cahal_recorder_info_t
    */
   void*                   platform_data;
   
+  /*! \var    format_id
+      \brief  The format the samples are recorded in.
+   */
+  cahal_audio_format_id   format_id;
+  
+  /*! \var    number_of_channels
+      \brief  The number of channels being recorded.
+   */
+  UINT32                  number_of_channels;
+  
+  /*! \var    channel_layout
+      \brief  What each channel of a recorded frame carries.
+   */
+  cahal_channel_layout    channel_layout;
+  
+  /*! \var    sample_rate
+      \brief  The sample rate of the recording.
+   */
+  FLOAT64                 sample_rate;
+  
+  /*! \var    bit_depth
+      \brief  The quantization level of the recorded samples.
+   */
+  UINT32                  bit_depth;
+  
+  /*! \var    format_flags
+      \brief  The flags describing the recorded samples.
+   */
+  cahal_audio_format_flag format_flags;
+  
+  /*! \var    dispatcher
+      \brief  The dispatch thread that runs the callbacks, or NULL if they run
+              on the OS' thread (see cahal_dispatcher.h).
+   */
+  struct cahal_dispatcher_t* dispatcher;
+  
+  /*! \var    coalescer
+      \brief  The accumulation of the recorded periods into larger callbacks,
+              or NULL if every period is passed on (see cahal_coalescer.h).
+   */
+  struct cahal_coalescer_t* coalescer;
+  
 } cahal_recorder_info;
 
 /*! \var    cahal_playback_info
@@ -284,8 +397,62 @@ typedef struct cahal_playback_info_t
    */
   void*                     platform_data;
   
+  /*! \var    format_id
+      \brief  The format the samples are played back in.
+   */
+  cahal_audio_format_id     format_id;
+  
+  /*! \var    number_of_channels
+      \brief  The number of channels being played back.
+   */
+  UINT32                    number_of_channels;
+  
+  /*! \var    channel_layout
+      \brief  What each channel of a played back frame carries.
+   */
+  cahal_channel_layout      channel_layout;
+  
+  /*! \var    sample_rate
+      \brief  The sample rate of the playback.
+   */
+  FLOAT64                   sample_rate;
+  
+  /*! \var    bit_depth
+      \brief  The quantization level of the played back samples.
+   */
+  UINT32                    bit_depth;
+  
+  /*! \var    format_flags
+      \brief  The flags describing the played back samples.
+   */
+  cahal_audio_format_flag   format_flags;
+  
+  /*! \var    dispatcher
+      \brief  The dispatch thread that runs the callbacks, or NULL if they run
+              on the OS' thread (see cahal_dispatcher.h).
+   */
+  struct cahal_dispatcher_t* dispatcher;
+  
+  /*! \var    schedule
+      \brief  The scheduled start of the playback, or NULL if it starts
+              immediately (see cahal_playback_schedule.h).
+   */
+  struct cahal_playback_schedule_t* schedule;
+  
 } cahal_playback_info;
 
+/*! \var    g_recorder_callback_info
+    \brief  The callback info of the recording, or NULL if there is none.
+            Defined by the platform.
+ */
+extern cahal_recorder_info* g_recorder_callback_info;
+
+/*! \var    g_playback_callback_info
+    \brief  The callback info of the playback, or NULL if there is none.
+            Defined by the platform.
+ */
+extern cahal_playback_info* g_playback_callback_info;
+
 /*! \fn     void cahal_print_device  (
               cahal_device* in_device
             )
@@ -322,6 +489,55 @@ cahal_print_device_list (
 cahal_device**
 cahal_get_device_list( void );
 
+/*! \fn     cahal_device** cahal_enumerate_devices  (
+              cahal_device_list_callback  in_callback,
+              void*                       in_user_data
+            )
+    \brief  Same as cahal_get_device_list but calls in_callback, on the calling
+            thread, with each device as soon as it is ready. On platforms that
+            probe devices (Android) the devices are probed concurrently and
+            are passed to in_callback in the order they finish, so a caller
+            that only needs the default device can act on it without waiting
+            for the slowest device. If the device list already exists
+            in_callback is called with every device in the list.
+
+    \param  in_callback The callback to call with each device.
+    \param  in_user_data  User data passed to in_callback.
+    \return The global device list, as returned by cahal_get_device_list.
+ */
+cahal_device**
+cahal_enumerate_devices  (
+                          cahal_device_list_callback  in_callback,
+                          void*                       in_user_data
+                          );
+
+/*! \fn     cahal_device** cahal_pack_device_list (
+              cahal_device** in_device_list,
+              cahal_arena**  out_arena
+            )
+    \brief  Copies in_device_list, and every device, stream, format, sample
+            rate range and string reachable from it, into a single arena and
+            frees the original. The copy has exactly the same layout as the
+            original; devices are stored contiguously followed by their streams
+            and formats, and equal strings (e.g. manufacturer and model names)
+            are stored once. Freeing the copy only frees the arena, except
+            for the details of devices that were not loaded before packing
+            (see cahal_load_device_details), which are loaded onto the heap
+            and must be freed using cahal_free_device_details.
+
+    \param  in_device_list  The null-terminated list to pack. Every member
+                            must have been allocated on the heap.
+    \param  out_arena The arena holding the packed list, or NULL if the list
+                      could not be packed.
+    \return The packed list. If it could not be packed in_device_list is
+            returned untouched.
+ */
+cahal_device**
+cahal_pack_device_list (
+                        cahal_device** in_device_list,
+                        cahal_arena**  out_arena
+                        );
+
 /*! \fn     void cahal_free_device_list()
     \brief  Frees the list of cahal_devices. This function will free all
             devices in the list as well as all members of those devices.
@@ -329,11 +545,79 @@ cahal_get_device_list( void );
     \note   This function will free the global device list that is generated
             the first time you call cahal_get_device_list(). You should however
             never need to call this function directly as the global device list
-            is freed when cahal_terminate is called.
+            is freed when cahal_terminate is called. Lists replaced by
+            cahal_refresh_device_list are freed too, while snapshots acquired
+            with cahal_acquire_device_snapshot live until they are released.
  */
 void
 cahal_free_device_list( void );
 
+/*! \fn     void cahal_free_device (
+              cahal_device* in_device
+            )
+    \brief  Frees a single device, all of its members and all of its streams.
+            Used for devices that are not (or not yet) in the global device
+            list. Must not be called on a device of a packed list.
+
+    \param  in_device The device to free. May be NULL.
+ */
+void
+cahal_free_device (
+                   cahal_device* in_device
+                   );
+
+/*! \fn     void cahal_set_lazy_device_details (
+              CPC_BOOL in_lazy
+            )
+    \brief  Chooses how devices are enumerated from the next query of the OS
+            on. Eager enumeration (the default) reads every property, sample
+            rate and stream format of every device up front. Lazy
+            enumeration only reads the handle, name and UID of each device
+            and the handle and direction of its streams, which is all most
+            callers need to pick a device, and defers everything else to
+            cahal_load_device_details. Platforms that cannot defer the
+            details ignore this setting.
+
+    \param  in_lazy True to enumerate lazily.
+ */
+void
+cahal_set_lazy_device_details (
+                               CPC_BOOL in_lazy
+                               );
+
+/*! \fn     CPC_BOOL cahal_load_device_details  (
+              cahal_device* io_device
+            )
+    \brief  Loads the details of a lazily enumerated device, once. Must be
+            called before reading any member other than handle, device_name,
+            device_uid and the handle and direction of each stream of a
+            device that may have been enumerated lazily. Safe to call
+            concurrently: exactly one caller loads the details and the others
+            wait for it. Returns immediately if the details are present.
+
+    \param  io_device The device. May be NULL.
+    \return True iff the details are present.
+ */
+CPC_BOOL
+cahal_load_device_details  (
+                            cahal_device* io_device
+                            );
+
+/*! \fn     void cahal_free_device_details  (
+              cahal_device* io_device
+            )
+    \brief  Frees the details that details_loader loaded into a device of a
+            packed list, which are allocated separately from the arena.
+            Does nothing if the device has no details_loader, since its
+            details then belong to the arena.
+
+    \param  io_device The device of a packed list.
+ */
+void
+cahal_free_device_details  (
+                            cahal_device* io_device
+                            );
+
 /*! \fn     CPC_BOOL cahal_test_device_direction_support  (
               cahal_device*                 in_device,
               cahal_device_stream_direction in_direction
@@ -357,6 +641,34 @@ cahal_test_device_direction_support  (
                                       cahal_device_stream_direction in_direction
                                       );
 
+/*! \fn     CPC_BOOL cahal_get_stream_channel_layout  (
+              cahal_device*                 in_device,
+              cahal_device_stream_direction in_direction,
+              UINT32                        in_number_of_channels,
+              cahal_channel_layout*         out_channel_layout
+            )
+    \brief  Returns the layout of in_number_of_channels channel frames
+            exchanged with in_device in in_direction: the layout of the first
+            format of a stream in that direction with in_number_of_channels
+            channels that specifies one, otherwise the default layout (see
+            cahal_get_default_channel_layout). Used by the platforms when a
+            recording or playback is started.
+
+    \param  in_device The device being started.
+    \param  in_direction  The direction of the stream being started.
+    \param  in_number_of_channels The number of channels being started.
+    \param  out_channel_layout  The layout of the frames.
+    \return True iff in_number_of_channels is in the range [ 1,
+            CAHAL_MAXIMUM_NUMBER_OF_CHANNELS ].
+ */
+CPC_BOOL
+cahal_get_stream_channel_layout  (
+                           cahal_device*                 in_device,
+                           cahal_device_stream_direction in_direction,
+                           UINT32                        in_number_of_channels,
+                           cahal_channel_layout*         out_channel_layout
+                                  );
+
 /*!  \fn     CPC_BOOL cahal_stop_recording( void )
    \brief  Calling this function will stop recording and free all structures
            related to the recording back to the OS. If no recording is taking
@@ -381,6 +693,59 @@ cahal_stop_recording( void );
 CPC_BOOL
 cahal_stop_playback( void );
 
+/*!  \fn     CPC_BOOL cahal_drain_playback( void )
+   \brief  Stops playback like cahal_stop_playback, but only once the audio
+           already handed to the OS has been played. The playback callback is
+           not called for more audio while the buffers drain. Blocks for up to
+           the length of the queued buffers (at most CAHAL_DRAIN_TIMEOUT).
+
+   \return True iff playback has been stopped. A paused playback is stopped
+           without draining, as it does not play.
+ */
+CPC_BOOL
+cahal_drain_playback( void );
+
+/*!  \fn     CPC_BOOL cahal_pause_recording( void )
+   \brief  Stops the clock of the recording, keeping its buffers and OS
+           objects so that cahal_resume_recording restarts it without
+           setting it up again. The recording callback may still receive the
+           buffer the OS was filling when the recording was paused.
+
+   \return True iff the recording was running and has been paused.
+ */
+CPC_BOOL
+cahal_pause_recording( void );
+
+/*!  \fn     CPC_BOOL cahal_resume_recording( void )
+   \brief  Restarts a recording paused by cahal_pause_recording or prepared by
+           cahal_prepare_recording.
+
+   \return True iff the recording was paused (or prepared) and is now
+           running.
+ */
+CPC_BOOL
+cahal_resume_recording( void );
+
+/*!  \fn     CPC_BOOL cahal_pause_playback( void )
+   \brief  Stops the clock of the playback, keeping its buffers and OS objects
+           so that cahal_resume_playback restarts it without setting it up
+           again. The audio that was queued when the playback was paused is
+           played once it is resumed.
+
+   \return True iff the playback was running and has been paused.
+ */
+CPC_BOOL
+cahal_pause_playback( void );
+
+/*!  \fn     CPC_BOOL cahal_resume_playback( void )
+   \brief  Restarts a playback paused by cahal_pause_playback or prepared by
+           cahal_prepare_playback.
+
+   \return True iff the playback was paused (or prepared) and is now running.
+ */
+CPC_BOOL
+cahal_resume_playback( void );
+
 /*! \fn     CPC_BOOL cahal_start_recording (
               cahal_device*            in_device,
               cahal_audio_format_id    in_format_id,
@@ -484,6 +849,86 @@ cahal_start_playback  (
                        cahal_audio_format_flag  in_format_flags
                        );
 
+/*! \fn     CPC_BOOL cahal_prepare_recording (
+              cahal_device*            in_device,
+              cahal_audio_format_id    in_format_id,
+              UINT32                   in_number_of_channels,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              cahal_recorder_callback  in_recorder,
+              void*                    in_callback_user_data,
+              cahal_audio_format_flag  in_format_flags
+            )
+    \brief  Sets up a recording like cahal_start_recording (allocating the
+            buffers, configuring the format and creating the OS objects)
+            without starting it, so that the latency of
+            cahal_resume_recording, which starts it, is only that of starting
+            the OS stream. A prepared recording that is not needed is released
+            with cahal_stop_recording.
+
+    \param  in_device The device to record from.
+    \param  in_format_id  The audio format to record in.
+    \param  in_number_of_channels The number of channels to record.
+    \param  in_sample_rate  The sample rate to record at.
+    \param  in_bit_depth  The number of bits per sample.
+    \param  in_recorder The callback receiving the recorded buffers.
+    \param  in_callback_user_data The user data passed to in_recorder.
+    \param  in_format_flags The flags to be used in the recording.
+    \return True iff the recording has been prepared on in_device.
+ */
+CPC_BOOL
+cahal_prepare_recording (
+                         cahal_device*            in_device,
+                         cahal_audio_format_id    in_format_id,
+                         UINT32                   in_number_of_channels,
+                         FLOAT64                  in_sample_rate,
+                         UINT32                   in_bit_depth,
+                         cahal_recorder_callback  in_recorder,
+                         void*                    in_callback_user_data,
+                         cahal_audio_format_flag  in_format_flags
+                         );
+
+/*! \fn     CPC_BOOL cahal_prepare_playback  (
+              cahal_device*            in_device,
+              cahal_audio_format_id    in_format_id,
+              UINT32                   in_number_of_channels,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              FLOAT32                  in_volume,
+              cahal_playback_callback  in_playback,
+              void*                    in_callback_user_data,
+              cahal_audio_format_flag  in_format_flags
+            )
+    \brief  Sets up a playback like cahal_start_playback without starting it,
+            so that the latency of cahal_resume_playback, which starts it, is
+            only that of starting the OS stream. The playback callback is
+            called to fill the first buffers, as when starting. A prepared
+            playback that is not needed is released with cahal_stop_playback.
+
+    \param  in_device The device to play back to.
+    \param  in_format_id  The audio format samples are encoded in.
+    \param  in_number_of_channels The number of channels to play back.
+    \param  in_sample_rate  The sample rate to play back at.
+    \param  in_bit_depth  The number of bits per sample.
+    \param  in_volume Volume gain (value between 0 and 1).
+    \param  in_playback The callback filling the buffers to play back.
+    \param  in_callback_user_data The user data passed to in_playback.
+    \param  in_format_flags The flags to be used in the playback.
+    \return True iff the playback has been prepared on in_device.
+ */
+CPC_BOOL
+cahal_prepare_playback  (
+                         cahal_device*            in_device,
+                         cahal_audio_format_id    in_format_id,
+                         UINT32                   in_number_of_channels,
+                         FLOAT64                  in_sample_rate,
+                         UINT32                   in_bit_depth,
+                         FLOAT32                  in_volume,
+                         cahal_playback_callback  in_playback,
+                         void*                    in_callback_user_data,
+                         cahal_audio_format_flag  in_format_flags
+                         );
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,247 @@
+/*! \file   cahal_device_index.h
+    \brief  Constant time lookups of the devices of a snapshot by UID, name,
+            default role, and direction and capabilities.
+
+            Every snapshot is indexed once, when it is created, and the index
+            is immutable like the rest of the snapshot. The devices are hashed
+            by UID and by name, the default device of each direction is
+            recorded, and for each direction and combination of
+            cahal_device_capabilities the matching devices are listed ahead
+            of time, so that no lookup walks the devices or their formats.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_DEVICE_INDEX_H__
+#define __CAHAL_DEVICE_INDEX_H__
+
+#include <cpcommon.h>
+
+#include "cahal_device.h"
+#include "cahal_device_stream.h"
+#include "cahal_device_snapshot.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_DEVICE_DIRECTIONS
+    \brief  The number of stream directions, i.e. output and input.
+ */
+#define CAHAL_DEVICE_DIRECTIONS         2
+
+/*! \def    CAHAL_DEVICE_CAPABILITY_SETS
+    \brief  The number of combinations of cahal_device_capabilities.
+ */
+#define CAHAL_DEVICE_CAPABILITY_SETS    16
+
+/*! \def    CAHAL_DEVICE_HIGH_SAMPLE_RATE
+    \brief  Sample rates above this rate count as high sample rates.
+ */
+#define CAHAL_DEVICE_HIGH_SAMPLE_RATE   48000.0
+
+/*! \var    cahal_device_capabilities
+    \brief  Capabilities of the streams of a device in one direction. Used as
+            a bitmask. A device has a capability if any format of its
+            streams in the direction is linear PCM, has more than two
+            channels, has more than 16 bits per sample or supports a rate
+            above CAHAL_DEVICE_HIGH_SAMPLE_RATE respectively.
+ */
+enum cahal_device_capabilities
+{
+  CAHAL_DEVICE_CAPABILITY_NONE              = 0,
+  CAHAL_DEVICE_CAPABILITY_LINEAR_PCM        = ( 1 << 0 ),
+  CAHAL_DEVICE_CAPABILITY_MULTICHANNEL      = ( 1 << 1 ),
+  CAHAL_DEVICE_CAPABILITY_HIGH_RESOLUTION   = ( 1 << 2 ),
+  CAHAL_DEVICE_CAPABILITY_HIGH_SAMPLE_RATE  = ( 1 << 3 ),
+  CAHAL_DEVICE_CAPABILITY_ALL               = ( 1 << 4 ) - 1
+};
+
+/*! \var    cahal_device_capability
+    \brief  Type definition for a bitmask of cahal_device_capabilities.
+ */
+typedef UINT32 cahal_device_capability;
+
+/*! \var    cahal_device_index
+    \brief  Struct definition for the lookup tables of a snapshot.
+ */
+typedef struct cahal_device_index_t
+{
+  /*! \var    uid_buckets
+      \brief  Open addressed hash table mapping a device_uid to one plus the
+              index of the first device with that UID, or 0 for an empty
+              slot.
+   */
+  UINT32*                 uid_buckets;
+
+  /*! \var    name_buckets
+      \brief  As uid_buckets, for device_name.
+   */
+  UINT32*                 name_buckets;
+
+  /*! \var    key_buckets
+      \brief  As uid_buckets, for the UID of a device or its name if it has
+              no UID. This is the key devices are matched by across
+              snapshots.
+   */
+  UINT32*                 key_buckets;
+
+  /*! \var    number_of_buckets
+      \brief  The number of slots in each table. Always a power of two.
+   */
+  UINT32                  number_of_buckets;
+
+  /*! \var    default_devices
+      \brief  The default device of each direction, or NULL.
+   */
+  cahal_device*           default_devices[ CAHAL_DEVICE_DIRECTIONS ];
+
+  /*! \var    device_lists
+      \brief  For each direction and capability set, in that order, the
+              null-terminated list of devices with a stream in the direction
+              and at least those capabilities.
+   */
+  cahal_device***         device_lists;
+
+} cahal_device_index;
+
+/*! \fn     cahal_device_index* cahal_create_device_index  (
+              cahal_device_snapshot* in_snapshot
+            )
+    \brief  Indexes the devices of in_snapshot. The index refers to the
+            devices and must not outlive them.
+
+    \param  in_snapshot The snapshot to index.
+    \return The index or NULL on error. Free using cahal_free_device_index.
+ */
+cahal_device_index*
+cahal_create_device_index  (
+                            cahal_device_snapshot* in_snapshot
+                            );
+
+/*! \fn     void cahal_index_device_capabilities (
+              cahal_device_snapshot* io_snapshot
+            )
+    \brief  Lists the devices of io_snapshot by capabilities once the details
+            of its lazily enumerated devices have been loaded. Until then only
+            the CAHAL_DEVICE_CAPABILITY_NONE lists are filled in. Called by
+            cahal_load_device_snapshot_details.
+
+    \param  io_snapshot The indexed snapshot.
+ */
+void
+cahal_index_device_capabilities (
+                                 cahal_device_snapshot* io_snapshot
+                                 );
+
+/*! \fn     cahal_device* cahal_find_device_by_uid  (
+              cahal_device_snapshot*  in_snapshot,
+              const CHAR*             in_device_uid
+            )
+    \brief  Returns the first device of in_snapshot whose device_uid is
+            in_device_uid.
+
+    \param  in_snapshot The snapshot to search. May be NULL.
+    \param  in_device_uid The UID to look up.
+    \return The device or NULL if there is none.
+ */
+cahal_device*
+cahal_find_device_by_uid  (
+                           cahal_device_snapshot*  in_snapshot,
+                           const CHAR*             in_device_uid
+                           );
+
+/*! \fn     cahal_device* cahal_find_device_by_name  (
+              cahal_device_snapshot*  in_snapshot,
+              const CHAR*             in_device_name
+            )
+    \brief  Returns the first device of in_snapshot whose device_name is
+            in_device_name.
+
+    \param  in_snapshot The snapshot to search. May be NULL.
+    \param  in_device_name  The name to look up.
+    \return The device or NULL if there is none.
+ */
+cahal_device*
+cahal_find_device_by_name  (
+                            cahal_device_snapshot*  in_snapshot,
+                            const CHAR*             in_device_name
+                            );
+
+/*! \fn     cahal_device* cahal_find_device_by_key  (
+              cahal_device_snapshot*  in_snapshot,
+              const CHAR*             in_key
+            )
+    \brief  Returns the first device of in_snapshot whose UID, or name if it
+            has no UID, is in_key. Devices are matched across snapshots by
+            this key.
+
+    \param  in_snapshot The snapshot to search. May be NULL.
+    \param  in_key  The key to look up.
+    \return The device or NULL if there is none.
+ */
+cahal_device*
+cahal_find_device_by_key  (
+                           cahal_device_snapshot*  in_snapshot,
+                           const CHAR*             in_key
+                           );
+
+/*! \fn     cahal_device* cahal_find_default_device  (
+              cahal_device_snapshot*        in_snapshot,
+              cahal_device_stream_direction in_direction
+            )
+    \brief  Returns the default device of in_direction, which is the first
+            device of in_snapshot with a stream in that direction.
+
+    \param  in_snapshot The snapshot to search. May be NULL.
+    \param  in_direction  The direction.
+    \return The device or NULL if there is none.
+ */
+cahal_device*
+cahal_find_default_device  (
+                            cahal_device_snapshot*        in_snapshot,
+                            cahal_device_stream_direction in_direction
+                            );
+
+/*! \fn     cahal_device** cahal_find_devices  (
+              cahal_device_snapshot*        in_snapshot,
+              cahal_device_stream_direction in_direction,
+              cahal_device_capability       in_capabilities
+            )
+    \brief  Returns the devices of in_snapshot with a stream in in_direction
+            and all of in_capabilities, in device order. Asking for any
+            capability loads the details of every lazily enumerated device of
+            in_snapshot, see cahal_load_device_snapshot_details.
+
+    \param  in_snapshot The snapshot to search.
+    \param  in_direction  The direction.
+    \param  in_capabilities A bitmask of cahal_device_capabilities, or
+                            CAHAL_DEVICE_CAPABILITY_NONE for every device
+                            with a stream in in_direction.
+    \return The null-terminated list, which belongs to in_snapshot and must
+            not be freed, or NULL on error.
+ */
+cahal_device**
+cahal_find_devices  (
+                     cahal_device_snapshot*        in_snapshot,
+                     cahal_device_stream_direction in_direction,
+                     cahal_device_capability       in_capabilities
+                     );
+
+/*! \fn     void cahal_free_device_index  (
+              cahal_device_index* in_index
+            )
+    \brief  Frees an index created by cahal_create_device_index.
+
+    \param  in_index  The index to free. May be NULL.
+ */
+void
+cahal_free_device_index  (
+                          cahal_device_index* in_index
+                          );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_DEVICE_INDEX_H__ */
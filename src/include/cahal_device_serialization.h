@@ -0,0 +1,180 @@
+/*! \file   cahal_device_serialization.h
+    \brief  Saving and loading of complete device lists (devices, streams,
+            formats and sample rate ranges) as compact binary files or as
+            JSON, and a replay mode that serves the device list from such a
+            file instead of querying the OS.
+
+            Replay makes it possible to reproduce the devices of another
+            machine, e.g. a customer's, on a machine without those devices or
+            without an audio backend at all, and to run the format
+            negotiation against many recorded device profiles. While a replay
+            file is set (see cahal_set_device_replay_file) the device list can
+            be enumerated and refreshed without calling cahal_initialize.
+
+            Binary files start with CAHAL_DEVICE_LIST_MAGIC and
+            CAHAL_DEVICE_LIST_VERSION, store every number in native byte order
+            and are meant to be read on the machine that wrote them. JSON
+            files are portable and can be edited by hand to write test
+            fixtures. The channel layout of a format is written to JSON as
+            "channel_layout" (its type) and "channel_positions" (the bits set
+            in its channel_mask); both are optional when reading.
+
+            Files of every version from CAHAL_DEVICE_LIST_MINIMUM_VERSION are
+            read. Version 1 files carry no channel layouts, so their formats
+            are loaded with unspecified layouts.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_DEVICE_SERIALIZATION_H__
+#define __CAHAL_DEVICE_SERIALIZATION_H__
+
+#include <cpcommon.h>
+
+#include "cahal_device.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_DEVICE_LIST_MAGIC
+    \brief  The first four bytes of a binary device list file ("CADL").
+ */
+#define CAHAL_DEVICE_LIST_MAGIC                   0x4C444143
+
+/*! \def    CAHAL_DEVICE_LIST_VERSION
+    \brief  The version of the binary and JSON layouts. Must be incremented
+            whenever either layout changes.
+ */
+#define CAHAL_DEVICE_LIST_VERSION                 2
+
+/*! \def    CAHAL_DEVICE_LIST_MINIMUM_VERSION
+    \brief  The oldest version of the layouts that can still be read.
+ */
+#define CAHAL_DEVICE_LIST_MINIMUM_VERSION         1
+
+/*! \def    CAHAL_DEVICE_LIST_MAXIMUM_STRING_LENGTH
+    \brief  The longest string (in bytes) accepted in a binary file.
+ */
+#define CAHAL_DEVICE_LIST_MAXIMUM_STRING_LENGTH   4096
+
+/*! \def    CAHAL_DEVICE_LIST_MAXIMUM_ITEMS
+    \brief  The largest number of devices, streams, formats or sample rate
+            ranges accepted in one list of a file.
+ */
+#define CAHAL_DEVICE_LIST_MAXIMUM_ITEMS           65536
+
+/*! \var    cahal_device_list_encodings
+    \brief  The encodings a device list can be saved in.
+ */
+enum cahal_device_list_encodings
+{
+  CAHAL_DEVICE_LIST_BINARY = 0,
+  CAHAL_DEVICE_LIST_JSON
+};
+
+/*! \var    cahal_device_list_encoding
+    \brief  Type definition for a value of cahal_device_list_encodings.
+ */
+typedef UINT32 cahal_device_list_encoding;
+
+/*! \var    g_device_replay_path
+    \brief  The file the device list is replayed from, or NULL to query the
+            OS. Set using cahal_set_device_replay_file, and only read while
+            the lock of cahal_lock_device_queries is held.
+ */
+extern CHAR* g_device_replay_path;
+
+/*! \fn     CPC_BOOL cahal_save_device_list  (
+              cahal_device**              in_device_list,
+              const CHAR*                 in_path,
+              cahal_device_list_encoding  in_encoding
+            )
+    \brief  Writes in_device_list to in_path. The file is written to a
+            temporary file first and renamed, so a reader never sees a
+            partially written file.
+
+    \param  in_device_list  The null-terminated list to save. May be NULL for
+                            an empty list.
+    \param  in_path The path of the file.
+    \param  in_encoding The encoding of the file.
+    \return True iff the file was written.
+ */
+CPC_BOOL
+cahal_save_device_list  (
+                         cahal_device**              in_device_list,
+                         const CHAR*                 in_path,
+                         cahal_device_list_encoding  in_encoding
+                         );
+
+/*! \fn     cahal_device** cahal_load_device_list  (
+              const CHAR* in_path
+            )
+    \brief  Reads a device list written by cahal_save_device_list. The
+            encoding is detected from the contents of the file.
+
+    \param  in_path The path of the file.
+    \return A newly allocated heap list, which is empty if the file has no
+            devices, or NULL on error. It can be passed to
+            cahal_update_device_list or freed device by device using
+            cahal_free_device.
+ */
+cahal_device**
+cahal_load_device_list  (
+                         const CHAR* in_path
+                         );
+
+/*! \fn     CHAR* cahal_device_list_to_json  (
+              cahal_device** in_device_list
+            )
+    \brief  Encodes in_device_list as JSON.
+
+    \param  in_device_list  The null-terminated list to encode. May be NULL
+                            for an empty list.
+    \return The null-terminated JSON document or NULL on error. Free using
+            cpc_safe_free.
+ */
+CHAR*
+cahal_device_list_to_json  (
+                            cahal_device** in_device_list
+                            );
+
+/*! \fn     cahal_device** cahal_device_list_from_json  (
+              const CHAR* in_json
+            )
+    \brief  Decodes a device list encoded by cahal_device_list_to_json.
+            Members may appear in any order, unknown members are ignored and
+            missing members are left zeroed.
+
+    \param  in_json The null-terminated JSON document.
+    \return A newly allocated heap list as returned by cahal_load_device_list,
+            or NULL on error.
+ */
+cahal_device**
+cahal_device_list_from_json  (
+                              const CHAR* in_json
+                              );
+
+/*! \fn     CPC_BOOL cahal_set_device_replay_file  (
+              const CHAR* in_path
+            )
+    \brief  Serves the device list from in_path instead of the OS. The file
+            is read every time the OS would have been queried, i.e. by the
+            first enumeration and by cahal_refresh_device_list, so replacing
+            the file and refreshing publishes the new devices and notifies
+            subscribers of the differences.
+
+    \param  in_path The file written by cahal_save_device_list, or NULL to
+                    query the OS again.
+    \return True iff the path was set.
+ */
+CPC_BOOL
+cahal_set_device_replay_file  (
+                               const CHAR* in_path
+                               );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_DEVICE_SERIALIZATION_H__ */
@@ -0,0 +1,327 @@
+/*! \file   cahal_device_snapshot.h
+    \brief  Immutable, versioned and reference counted snapshots of the device
+            list, and notifications of the changes between them.
+
+            The library keeps one current snapshot. Readers take a reference
+            to it with cahal_acquire_device_snapshot and may keep using it for
+            as long as they like, even after a newer snapshot is published.
+            cahal_refresh_device_list queries the OS for its devices again and,
+            if anything changed, publishes a new snapshot and tells every
+            subscriber which devices were added, removed or changed. On
+            macOS and Windows the library listens for device changes and
+            refreshes by itself (see cahal_schedule_device_list_refresh). On
+            iOS, whose devices are fixed, and on Android the list is only
+            refreshed when the application calls cahal_refresh_device_list. The query
+            runs without holding the lock readers take, so readers never wait
+            for an enumeration.
+
+            The devices of the current snapshot are also the global device list
+            returned by cahal_get_device_list. Lists returned that way remain
+            valid until cahal_free_device_list is called, even if they have
+            been replaced by a refresh.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_DEVICE_SNAPSHOT_H__
+#define __CAHAL_DEVICE_SNAPSHOT_H__
+
+#include <cpcommon.h>
+
+#include "cahal_device.h"
+#include "cahal_atomic.h"
+#include "cahal_arena.h"
+#include "cahal_format_negotiation.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_DEVICE_MAXIMUM_SUBSCRIBERS
+    \brief  The maximum number of simultaneous device change subscriptions.
+ */
+#define CAHAL_DEVICE_MAXIMUM_SUBSCRIBERS  16
+
+/*! \var    cahal_device_change_types
+    \brief  The kinds of device change that are notified.
+ */
+enum cahal_device_change_types
+{
+  CAHAL_DEVICE_CHANGE_ADDED = 0,
+  CAHAL_DEVICE_CHANGE_REMOVED,
+  CAHAL_DEVICE_CHANGE_DEFAULT_CHANGED,
+  CAHAL_DEVICE_CHANGE_FORMAT_CHANGED
+};
+
+/*! \var    cahal_device_change_type
+    \brief  Type definition for a value of cahal_device_change_types.
+ */
+typedef UINT32 cahal_device_change_type;
+
+/*! \var    cahal_device_snapshot
+    \brief  Struct definition for a snapshot of the device list. Nothing
+            reachable from a snapshot is modified once it is published,
+            except that the details of lazily enumerated devices, and the
+            format indexes and capability lists built from them, are filled
+            in once on first use.
+ */
+typedef struct cahal_device_snapshot_t
+{
+  /*! \var    devices
+      \brief  The null-terminated list of devices.
+   */
+  cahal_device**                  devices;
+
+  /*! \var    number_of_devices
+      \brief  The number of devices in devices.
+   */
+  UINT32                          number_of_devices;
+
+  /*! \var    version
+      \brief  The version of the snapshot. The first snapshot is version 1 and
+              each published snapshot increments it.
+   */
+  UINT32                          version;
+
+  /*! \var    arena
+      \brief  The arena holding devices, or NULL if they could not be packed
+              and are heap allocated.
+   */
+  cahal_arena*                    arena;
+
+  /*! \var    format_indexes
+      \brief  The null-terminated list of the format indexes of every stream
+              of devices, or NULL if they could not be built or if
+              details_state is still CAHAL_ONCE_PENDING.
+   */
+  cahal_format_index**            format_indexes;
+
+  /*! \var    device_index
+      \brief  The lookup tables of devices, see cahal_device_index.h.
+   */
+  struct cahal_device_index_t*    device_index;
+
+  /*! \var    details_state
+      \brief  One of cahal_once_states. CAHAL_ONCE_PENDING if some devices
+              were enumerated lazily and cahal_load_device_snapshot_details
+              has not been called yet.
+   */
+  cahal_atomic_uint32             details_state;
+
+  /*! \var    reference_count
+      \brief  The number of references to the snapshot. It is freed when the
+              count drops to zero.
+   */
+  cahal_atomic_uint32             reference_count;
+
+  /*! \var    pinned
+      \brief  True iff devices has been returned by cahal_get_device_list, in
+              which case the library keeps the snapshot until
+              cahal_free_device_list.
+   */
+  CPC_BOOL                        pinned;
+
+  /*! \var    next_retired
+      \brief  The next pinned snapshot that has been replaced, or NULL.
+   */
+  struct cahal_device_snapshot_t* next_retired;
+
+} cahal_device_snapshot;
+
+/*! \def    cahal_device_change_callback
+    \brief  The function prototype of the callback that is called with each
+            change between two snapshots.
+
+    \param  in_change The kind of change.
+    \param  in_device The device that changed. For removals it is the device
+                      from the previous snapshot, otherwise it is the device
+                      from in_snapshot. For default changes it is the new
+                      default device, notified once per direction.
+    \param  in_snapshot The newly published snapshot. The callback may acquire
+                        a reference to it to keep it.
+    \param  in_user_data  The user data passed to
+                          cahal_subscribe_device_changes.
+ */
+typedef void (*cahal_device_change_callback) (
+                                   cahal_device_change_type in_change,
+                                   cahal_device*            in_device,
+                                   cahal_device_snapshot*   in_snapshot,
+                                   void*                    in_user_data
+                                   );
+
+/*! \fn     cahal_device_snapshot* cahal_acquire_device_snapshot( void )
+    \brief  Returns the current snapshot with an added reference, enumerating
+            the devices first if there is no snapshot yet.
+
+    \return The snapshot or NULL on error. Release using
+            cahal_release_device_snapshot.
+ */
+cahal_device_snapshot*
+cahal_acquire_device_snapshot( void );
+
+/*! \fn     void cahal_release_device_snapshot (
+              cahal_device_snapshot* in_snapshot
+            )
+    \brief  Drops a reference taken by cahal_acquire_device_snapshot.
+
+    \param  in_snapshot The snapshot to release. May be NULL.
+ */
+void
+cahal_release_device_snapshot (
+                               cahal_device_snapshot* in_snapshot
+                               );
+
+/*! \fn     UINT32 cahal_subscribe_device_changes (
+              cahal_device_change_callback  in_callback,
+              void*                         in_user_data
+            )
+    \brief  Registers in_callback to be called with every change published by
+            cahal_refresh_device_list or cahal_update_device_list. Callbacks
+            run on the thread that publishes the changes, which for changes
+            notified by the OS is the control thread of cahal_async. They
+            must not wait on an asynchronous operation, subscribe,
+            unsubscribe, or enumerate, refresh or update the device list;
+            they may acquire snapshots.
+
+    \param  in_callback The callback to register.
+    \param  in_user_data  User data passed to in_callback.
+    \return The identifier of the subscription, or 0 on error.
+ */
+UINT32
+cahal_subscribe_device_changes (
+                                cahal_device_change_callback  in_callback,
+                                void*                         in_user_data
+                                );
+
+/*! \fn     void cahal_unsubscribe_device_changes (
+              UINT32 in_subscription
+            )
+    \brief  Removes a subscription. Once this function returns the callback
+            of the subscription is not running and will not be called again.
+
+    \param  in_subscription The identifier returned by
+                            cahal_subscribe_device_changes.
+ */
+void
+cahal_unsubscribe_device_changes (
+                                  UINT32 in_subscription
+                                  );
+
+/*! \fn     CPC_BOOL cahal_refresh_device_list( void )
+    \brief  Queries the OS for its devices and publishes them with
+            cahal_update_device_list. Devices whose formats are cached (see
+            cahal_probe_cache) are not probed again. Active streams are not
+            affected.
+
+    \return True iff the devices were queried and published.
+ */
+CPC_BOOL
+cahal_refresh_device_list( void );
+
+/*! \fn     void cahal_schedule_device_list_refresh( void )
+    \brief  Queues a cahal_refresh_device_list on the control thread of
+            cahal_async and returns without waiting for it. Called by the
+            platforms that are notified of device changes (macOS and
+            Windows) whenever a device is added or removed or a default
+            device changes; a refresh that is already queued is not queued
+            again. Never blocks, so it may be called from OS notification
+            threads.
+ */
+void
+cahal_schedule_device_list_refresh( void );
+
+/*! \fn     void cahal_lock_device_queries( void )
+    \brief  Takes the lock held while the devices are queried, waiting for a
+            query that is running to finish, so that what it reads (e.g.
+            g_device_replay_path) can be changed. Must not be called from a
+            device change callback.
+ */
+void
+cahal_lock_device_queries( void );
+
+/*! \fn     void cahal_unlock_device_queries( void )
+    \brief  Releases the lock taken by cahal_lock_device_queries.
+ */
+void
+cahal_unlock_device_queries( void );
+
+/*! \fn     CPC_BOOL cahal_update_device_list (
+              cahal_device** in_device_list
+            )
+    \brief  Compares in_device_list with the current snapshot and, if they
+            differ, publishes it as a new snapshot and notifies subscribers.
+            Devices are matched by device_uid, or by device_name when they
+            have no UID. The default device of a direction is the first device
+            in the list that supports it.
+
+    \param  in_device_list  A heap allocated null-terminated list of devices,
+                            as built by the platform. It is owned by the
+                            library once passed in.
+    \return True iff in_device_list was accepted, whether or not it differed
+            from the current snapshot.
+ */
+CPC_BOOL
+cahal_update_device_list (
+                          cahal_device** in_device_list
+                          );
+
+/*! \fn     CPC_BOOL cahal_load_device_snapshot_details (
+              cahal_device_snapshot* io_snapshot
+            )
+    \brief  Loads the details of every lazily enumerated device of
+            io_snapshot, then builds the format indexes and capability lists
+            that depend on them. Runs once per snapshot; concurrent callers
+            wait for it. Called by cahal_get_format_index and by
+            cahal_find_devices with capabilities, so callers that only look
+            at device names, UIDs and directions never load any details.
+
+    \param  io_snapshot The snapshot. May be NULL.
+    \return True iff the format indexes and capability lists were built.
+ */
+CPC_BOOL
+cahal_load_device_snapshot_details (
+                                    cahal_device_snapshot* io_snapshot
+                                    );
+
+/*! \fn     cahal_format_index* cahal_get_format_index (
+              cahal_device_snapshot* in_snapshot,
+              cahal_device_stream*   in_stream
+            )
+    \brief  Returns the format index of in_stream, which is built when
+            in_snapshot is created, or by cahal_load_device_snapshot_details
+            if its devices were enumerated lazily. It is valid for as long as
+            the caller holds a reference to in_snapshot.
+
+    \param  in_snapshot The snapshot in_stream belongs to.
+    \param  in_stream The stream of one of the devices of in_snapshot.
+    \return The index, or NULL if in_stream does not belong to in_snapshot.
+ */
+cahal_format_index*
+cahal_get_format_index (
+                        cahal_device_snapshot* in_snapshot,
+                        cahal_device_stream*   in_stream
+                        );
+
+/*! \fn     cahal_device** cahal_query_device_list (
+              cahal_device_list_callback  in_callback,
+              void*                       in_user_data
+            )
+    \brief  Platform specific. Queries the OS for its devices, calling
+            in_callback with each device as soon as it is ready.
+
+    \param  in_callback The callback to call with each device, or NULL.
+    \param  in_user_data  User data passed to in_callback.
+    \return A newly allocated heap list of devices, or NULL if there are none
+            or on error.
+ */
+cahal_device**
+cahal_query_device_list (
+                         cahal_device_list_callback  in_callback,
+                         void*                       in_user_data
+                         );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_DEVICE_SNAPSHOT_H__ */
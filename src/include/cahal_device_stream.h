@@ -125,6 +125,18 @@ cahal_free_device_stream_list (
                                cahal_device_stream** in_device_stream_list
                                );
 
+/*! \fn     void cahal_free_device_stream  (
+              cahal_device_stream* in_device_stream
+            )
+    \brief  Frees a single device stream and its supported formats.
+
+    \param  in_device_stream  The stream to free. May be NULL.
+ */
+void
+cahal_free_device_stream  (
+                           cahal_device_stream* in_device_stream
+                           );
+
 #ifdef __cplusplus
 }
 #endif
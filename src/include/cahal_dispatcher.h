@@ -0,0 +1,385 @@
+/*! \file   cahal_dispatcher.h
+    \brief  Dedicated dispatch threads. By default the callbacks of a stream
+            run on whichever thread the OS delivers buffers on (the AudioQueue
+            thread, the OpenSL ES callback thread or the WASAPI event thread).
+            Once dispatch options are set using cahal_set_dispatch_options
+            every stream started afterwards owns a dispatch thread instead.
+            The thread is scheduled with the configured policy, priority and
+            CPU affinity, and all processing and user callbacks of the stream
+            run on it.
+
+            The OS thread and the dispatch thread only share a
+            single-producer/single-consumer cahal_ring_buffer and a semaphore,
+            so the OS thread never waits for a lock:
+
+            - Recording: every buffer is copied into the ring, prefixed with
+              its length and the time it was completed, and the dispatch
+              thread is woken to process it. Buffers that do not fit are
+              dropped and counted as overruns.
+            - Playback: the dispatch thread renders periods ahead of the OS
+              into the ring. The OS callback copies out what it needs and
+              wakes the dispatch thread to render more. Missing samples are
+              played as silence and counted as underruns. Rendering ahead adds
+              up to number_of_periods periods of latency.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_DISPATCHER_H__
+#define __CAHAL_DISPATCHER_H__
+
+#include <cpcommon.h>
+
+#include "cahal_device.h"
+#include "cahal_ring_buffer.h"
+#include "cahal_thread.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_DISPATCH_DEFAULT_PERIOD
+    \brief  The period (in seconds) used when none is given.
+ */
+#define CAHAL_DISPATCH_DEFAULT_PERIOD             0.01
+
+/*! \def    CAHAL_DISPATCH_DEFAULT_NUMBER_OF_PERIODS
+    \brief  The number of periods rendered ahead when none is given.
+ */
+#define CAHAL_DISPATCH_DEFAULT_NUMBER_OF_PERIODS  4
+
+/*! \def    CAHAL_DISPATCH_NUMBER_OF_RECORDED_BUFFERS
+    \brief  The number of recorded buffers the ring holds, so that the OS can
+            deliver the next buffer while the last one is being processed.
+ */
+#define CAHAL_DISPATCH_NUMBER_OF_RECORDED_BUFFERS 2
+
+/*! \var    cahal_dispatch_options
+    \brief  Struct definition for the options of the dispatch threads.
+ */
+typedef struct cahal_dispatch_options_t
+{
+  /*! \var    scheduling
+      \brief  How the dispatch thread is scheduled. The period is also the
+              amount of audio rendered by every playback callback on the
+              dispatch thread; 0 selects CAHAL_DISPATCH_DEFAULT_PERIOD.
+   */
+  cahal_thread_scheduling scheduling;
+
+  /*! \var    number_of_periods
+      \brief  The number of periods rendered ahead of the OS during playback,
+              on top of the largest buffer the OS requests at once. 0 selects
+              CAHAL_DISPATCH_DEFAULT_NUMBER_OF_PERIODS.
+   */
+  UINT32                  number_of_periods;
+
+} cahal_dispatch_options;
+
+/*! \var    cahal_dispatch_packet_header
+    \brief  Struct definition for the header written to the ring buffer in
+            front of every recorded buffer.
+ */
+typedef struct cahal_dispatch_packet_header_t
+{
+  /*! \var    length
+      \brief  The number of bytes that follow the header.
+   */
+  UINT32  length;
+
+  /*! \var    record_time
+      \brief  The time (ns) the first sample of the buffer was recorded.
+   */
+  UINT64  record_time;
+
+} cahal_dispatch_packet_header;
+
+/*! \var    cahal_dispatcher
+    \brief  Struct definition for the dispatch thread of one stream.
+ */
+typedef struct cahal_dispatcher_t
+{
+  /*! \var    options
+      \brief  The options the dispatcher was created with, defaults applied.
+   */
+  cahal_dispatch_options        options;
+
+  /*! \var    direction
+      \brief  Whether the stream records or plays back.
+   */
+  cahal_device_stream_direction direction;
+
+  /*! \var    stream_info
+      \brief  The cahal_recorder_info or cahal_playback_info of the stream.
+   */
+  void*                         stream_info;
+
+  /*! \var    frame_size
+      \brief  The number of bytes in a frame of the stream.
+   */
+  UINT32                        frame_size;
+
+  /*! \var    buffer_size
+      \brief  The largest recorded buffer that can be dispatched, or the
+              number of bytes rendered per playback callback.
+   */
+  UINT32                        buffer_size;
+
+  /*! \var    buffer
+      \brief  The buffer passed to the callbacks, buffer_size bytes long.
+   */
+  UCHAR*                        buffer;
+
+  /*! \var    target_fill
+      \brief  The number of bytes the playback dispatch thread keeps rendered
+              ahead in ring_buffer. Unused when recording.
+   */
+  UINT32                        target_fill;
+
+  /*! \var    ring_buffer
+      \brief  The samples in flight between the OS and the dispatch thread.
+   */
+  cahal_ring_buffer*            ring_buffer;
+
+  /*! \var    wake
+      \brief  Posted by the OS thread once for every recorded buffer and every
+              playback buffer it consumed, and once more when stopping.
+   */
+  cahal_semaphore               wake;
+
+  /*! \var    ready
+      \brief  Posted by the dispatch thread once it has been scheduled (and
+              has rendered ahead, for playback).
+   */
+  cahal_semaphore               ready;
+
+  /*! \var    thread
+      \brief  The dispatch thread.
+   */
+  cahal_thread                  thread;
+
+  /*! \var    is_scheduled
+      \brief  True iff the dispatch thread applied every part of the
+              scheduling options. Valid once the dispatcher has been created.
+   */
+  CPC_BOOL                      is_scheduled;
+
+  /*! \var    is_stopping
+      \brief  Set when the dispatcher is freed.
+   */
+  cahal_atomic_uint32           is_stopping;
+
+  /*! \var    has_failed
+      \brief  Set once a callback of the stream returned false. Every later
+              buffer then reports failure to the OS thread.
+   */
+  cahal_atomic_uint32           has_failed;
+
+  /*! \var    queued_bytes
+      \brief  The number of bytes the OS had queued at the last playback
+              callback.
+   */
+  cahal_atomic_uint32           queued_bytes;
+
+  /*! \var    number_of_overruns
+      \brief  The number of recorded buffers dropped because the ring was
+              full.
+   */
+  cahal_atomic_uint32           number_of_overruns;
+
+  /*! \var    number_of_underruns
+      \brief  The number of playback buffers padded with silence because the
+              ring ran dry.
+   */
+  cahal_atomic_uint32           number_of_underruns;
+
+} cahal_dispatcher;
+
+/*! \fn     void cahal_set_dispatch_options  (
+              const cahal_dispatch_options* in_options
+            )
+    \brief  Sets the options of the dispatch threads of the streams started
+            afterwards. Streams that are running keep their threads.
+
+    \param  in_options  The options to copy, or NULL to run the callbacks of
+                        new streams on the OS' threads again.
+ */
+void
+cahal_set_dispatch_options  (
+                             const cahal_dispatch_options* in_options
+                             );
+
+/*! \fn     CPC_BOOL cahal_get_dispatch_options  (
+              cahal_dispatch_options* out_options
+            )
+    \brief  Returns the options set using cahal_set_dispatch_options.
+
+    \param  out_options The options. Left untouched if dispatch threads are
+                        not used.
+    \return True iff new streams get a dispatch thread.
+ */
+CPC_BOOL
+cahal_get_dispatch_options  (
+                             cahal_dispatch_options* out_options
+                             );
+
+/*! \fn     cahal_dispatcher* cahal_dispatcher_create  (
+              const cahal_dispatch_options*  in_options,
+              cahal_device_stream_direction  in_direction,
+              void*                          in_stream_info,
+              UINT32                         in_buffer_size
+            )
+    \brief  Starts the dispatch thread of a stream and waits for it to be
+            scheduled. Playback dispatchers also wait for the thread to fill
+            the ring, so the OS' first callbacks already find samples.
+
+    \param  in_options  The options of the dispatch thread.
+    \param  in_direction  CAHAL_DEVICE_INPUT_STREAM to record,
+                          CAHAL_DEVICE_OUTPUT_STREAM to play back.
+    \param  in_stream_info  The cahal_recorder_info or cahal_playback_info of
+                            the stream. Must outlive the dispatcher.
+    \param  in_buffer_size  The largest number of bytes the OS delivers or
+                            requests in one callback.
+    \return The dispatcher or NULL on error. Free using cahal_dispatcher_free
+            once the OS has stopped calling back.
+ */
+cahal_dispatcher*
+cahal_dispatcher_create  (
+                          const cahal_dispatch_options*  in_options,
+                          cahal_device_stream_direction  in_direction,
+                          void*                          in_stream_info,
+                          UINT32                         in_buffer_size
+                          );
+
+/*! \fn     void cahal_dispatcher_free  (
+              cahal_dispatcher* in_dispatcher
+            )
+    \brief  Processes the recorded buffers still in the ring, stops the
+            dispatch thread and frees the dispatcher.
+
+    \param  in_dispatcher The dispatcher to free.
+ */
+void
+cahal_dispatcher_free  (
+                        cahal_dispatcher* in_dispatcher
+                        );
+
+/*! \fn     CPC_BOOL cahal_dispatcher_push_recording  (
+              cahal_dispatcher* io_dispatcher,
+              const UCHAR*      in_data_buffer,
+              UINT32            in_data_buffer_length,
+              UINT64            in_record_time
+            )
+    \brief  Hands a recorded buffer to the dispatch thread. Must only be
+            called by the OS thread of the stream.
+
+    \param  io_dispatcher The dispatcher of the recording.
+    \param  in_data_buffer  The recorded samples. They are copied.
+    \param  in_data_buffer_length The size of in_data_buffer in bytes.
+    \param  in_record_time  The time (ns) the first sample was recorded.
+    \return False iff a callback of the recording has returned false. A
+            buffer that is dropped is not a failure.
+ */
+CPC_BOOL
+cahal_dispatcher_push_recording  (
+                                  cahal_dispatcher* io_dispatcher,
+                                  const UCHAR*      in_data_buffer,
+                                  UINT32            in_data_buffer_length,
+                                  UINT64            in_record_time
+                                  );
+
+/*! \fn     CPC_BOOL cahal_dispatcher_pull_playback  (
+              cahal_dispatcher* io_dispatcher,
+              UCHAR*            out_data_buffer,
+              UINT32*           io_data_buffer_length,
+              UINT32            in_queued_bytes
+            )
+    \brief  Fills a playback buffer with samples rendered by the dispatch
+            thread. Must only be called by the OS thread of the stream.
+
+    \param  io_dispatcher The dispatcher of the playback.
+    \param  out_data_buffer The buffer to fill.
+    \param  io_data_buffer_length The capacity of out_data_buffer on input, the
+                                  number of bytes written on output. The
+                                  buffer is always filled, with silence if
+                                  need be.
+    \param  in_queued_bytes The number of bytes queued in the OS that will be
+                            played before the first sample in out_data_buffer.
+    \return False iff a callback of the playback has returned false.
+ */
+CPC_BOOL
+cahal_dispatcher_pull_playback  (
+                                 cahal_dispatcher* io_dispatcher,
+                                 UCHAR*            out_data_buffer,
+                                 UINT32*           io_data_buffer_length,
+                                 UINT32            in_queued_bytes
+                                 );
+
+/*! \fn     CPC_BOOL cahal_attach_recording_dispatcher (
+              cahal_recorder_info*  io_recorder_info,
+              UINT32                in_buffer_size
+            )
+    \brief  Creates the dispatcher of a recording if dispatch options are set.
+            Called by the platforms once io_recorder_info is filled in and
+            before the OS starts delivering buffers.
+
+    \param  io_recorder_info  The recording. Its dispatcher is set.
+    \param  in_buffer_size  The largest number of bytes the OS delivers in one
+                            callback.
+    \return True iff the recording may start.
+ */
+CPC_BOOL
+cahal_attach_recording_dispatcher (
+                                   cahal_recorder_info*  io_recorder_info,
+                                   UINT32                in_buffer_size
+                                   );
+
+/*! \fn     CPC_BOOL cahal_attach_playback_dispatcher  (
+              cahal_playback_info*  io_playback_info,
+              UINT32                in_buffer_size
+            )
+    \brief  Creates the dispatcher of a playback if dispatch options are set.
+            Called by the platforms once io_playback_info is filled in and
+            before the first buffer is requested.
+
+    \param  io_playback_info  The playback. Its dispatcher is set.
+    \param  in_buffer_size  The largest number of bytes the OS requests in one
+                            callback.
+    \return True iff the playback may start.
+ */
+CPC_BOOL
+cahal_attach_playback_dispatcher  (
+                                   cahal_playback_info*  io_playback_info,
+                                   UINT32                in_buffer_size
+                                   );
+
+/*! \fn     void cahal_detach_recording_dispatcher (
+              cahal_recorder_info* io_recorder_info
+            )
+    \brief  Frees the dispatcher of a recording, if any. Called by the
+            platforms once the OS has stopped delivering buffers.
+
+    \param  io_recorder_info  The recording.
+ */
+void
+cahal_detach_recording_dispatcher (
+                                   cahal_recorder_info* io_recorder_info
+                                   );
+
+/*! \fn     void cahal_detach_playback_dispatcher  (
+              cahal_playback_info* io_playback_info
+            )
+    \brief  Frees the dispatcher of a playback, if any. Called by the
+            platforms once the OS has stopped requesting buffers.
+
+    \param  io_playback_info  The playback.
+ */
+void
+cahal_detach_playback_dispatcher  (
+                                   cahal_playback_info* io_playback_info
+                                   );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_DISPATCHER_H__ */
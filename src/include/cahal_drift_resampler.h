@@ -0,0 +1,377 @@
+/*! \file   cahal_drift_resampler.h
+    \brief  Adaptive resampler used to bridge a recording stream on one device
+            to a playback stream on another device. The two devices are driven
+            by independent clocks that drift relative to one another; left
+            alone the buffer between the two either grows without bound or
+            starves. The drift resampler estimates the drift from the fill
+            level of its internal (bounded) buffer and continuously adjusts its
+            resampling ratio to keep the latency at the requested target.
+
+            The recording side writes frames (cahal_drift_resampler_write) and
+            the playback side reads frames (cahal_drift_resampler_read). The
+            two sides may be called from different threads, but each side must
+            only ever be called from one thread at a time. The bridge callbacks
+            cahal_drift_resampler_recorder_callback and
+            cahal_drift_resampler_playback_callback can be passed directly to
+            cahal_start_recording and cahal_start_playback with the resampler
+            as the callback user data.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_DRIFT_RESAMPLER_H__
+#define __CAHAL_DRIFT_RESAMPLER_H__
+
+#include <cpcommon.h>
+
+#include "cahal_device.h"
+#include "cahal_audio_format_flags.h"
+#include "cahal_ring_buffer.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES
+    \brief  The number of frames processed at a time by the bridge callbacks.
+            All scratch buffers are allocated once for this many frames so no
+            allocation takes place on the audio threads.
+ */
+#define CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES      1024
+
+/*! \def    CAHAL_DRIFT_RESAMPLER_MAXIMUM_PPM
+    \brief  The largest correction (in parts per million) that the resampler
+            will apply. Real clock drift is in the order of tens to hundreds of
+            ppm; the limit keeps the pitch modulation inaudible.
+ */
+#define CAHAL_DRIFT_RESAMPLER_MAXIMUM_PPM       2000.0
+
+/*! \var    cahal_drift_resampler
+    \brief  Struct definition for the adaptive drift resampler.
+ */
+typedef struct cahal_drift_resampler_t
+{
+  /*! \var    number_of_channels
+      \brief  The number of interleaved channels in each frame.
+   */
+  UINT32              number_of_channels;
+
+  /*! \var    sample_rate
+      \brief  The nominal sample rate of both streams.
+   */
+  FLOAT64             sample_rate;
+
+  /*! \var    target_fill
+      \brief  The number of frames the controller tries to keep buffered.
+   */
+  UINT32              target_fill;
+
+  /*! \var    fill_offset
+      \brief  Frames added to the fill level before it is filtered, e.g. the
+              frames the recording device holds but has not delivered yet.
+              Zero unless set by the playback side.
+   */
+  FLOAT64             fill_offset;
+
+  /*! \var    maximum_fill
+      \brief  The maximum number of frames that may be buffered. Frames beyond
+              this bound are discarded so the latency is always bounded.
+   */
+  UINT32              maximum_fill;
+
+  /*! \var    ring_buffer
+      \brief  Buffer of floating point frames between the two sides.
+   */
+  cahal_ring_buffer*  ring_buffer;
+
+  /*! \var    ratio
+      \brief  The current resampling ratio, i.e. the number of input frames
+              consumed per output frame.
+   */
+  FLOAT64             ratio;
+
+  /*! \var    integral
+      \brief  Integral term of the fill level controller (seconds x seconds).
+   */
+  FLOAT64             integral;
+
+  /*! \var    filtered_fill
+      \brief  Low-pass filtered fill level (frames). Recorded buffers arrive
+              in bursts; filtering removes the resulting saw-tooth.
+   */
+  FLOAT64             filtered_fill;
+
+  /*! \var    position
+      \brief  Fractional read position within work_buffer.
+   */
+  FLOAT64             position;
+
+  /*! \var    work_buffer
+      \brief  Scratch buffer used by the reader. The first
+              number_of_history_frames frames are the history carried over
+              from the previous read.
+   */
+  FLOAT32*            work_buffer;
+
+  /*! \var    number_of_history_frames
+      \brief  The number of frames read from the ring by the previous read
+              but not consumed by it, at the start of work_buffer.
+   */
+  UINT32              number_of_history_frames;
+
+  /*! \var    work_capacity
+      \brief  The capacity, in frames, of work_buffer.
+   */
+  UINT32              work_capacity;
+
+  /*! \var    input_bit_depth
+      \brief  Bit depth of the samples passed to the recorder bridge callback.
+   */
+  UINT32              input_bit_depth;
+
+  /*! \var    input_format_flags
+      \brief  Format flags of the samples passed to the recorder bridge
+              callback.
+   */
+  cahal_audio_format_flag input_format_flags;
+
+  /*! \var    output_bit_depth
+      \brief  Bit depth of the samples produced by the playback bridge
+              callback.
+   */
+  UINT32              output_bit_depth;
+
+  /*! \var    output_format_flags
+      \brief  Format flags of the samples produced by the playback bridge
+              callback.
+   */
+  cahal_audio_format_flag output_format_flags;
+
+  /*! \var    input_scratch
+      \brief  Conversion buffer used by the recording side.
+   */
+  FLOAT32*            input_scratch;
+
+  /*! \var    output_scratch
+      \brief  Conversion buffer used by the playback side.
+   */
+  FLOAT32*            output_scratch;
+
+  /*! \var    overruns
+      \brief  Number of frames discarded because the buffer was full.
+   */
+  cahal_atomic_uint32 overruns;
+
+  /*! \var    underruns
+      \brief  Number of frames of silence inserted because the buffer was
+              empty.
+   */
+  cahal_atomic_uint32 underruns;
+
+} cahal_drift_resampler;
+
+/*! \fn     cahal_drift_resampler* cahal_drift_resampler_create  (
+              UINT32                  in_number_of_channels,
+              FLOAT64                 in_sample_rate,
+              FLOAT64                 in_target_latency,
+              FLOAT64                 in_maximum_latency,
+              UINT32                  in_input_bit_depth,
+              cahal_audio_format_flag in_input_format_flags,
+              UINT32                  in_output_bit_depth,
+              cahal_audio_format_flag in_output_format_flags
+            )
+    \brief  Creates a new drift resampler. All memory used by the resampler is
+            allocated here.
+
+    \param  in_number_of_channels The number of channels in both streams.
+    \param  in_sample_rate  The nominal sample rate of both streams.
+    \param  in_target_latency The latency (in seconds) the resampler maintains
+                              between the recording and playback streams. This
+                              must be larger than the duration of a recorded
+                              buffer (see CAHAL_QUEUE_BUFFER_DURATION).
+    \param  in_maximum_latency  The upper bound (in seconds) on the latency.
+                                Must be larger than in_target_latency.
+    \param  in_input_bit_depth  The bit depth of the recording stream.
+    \param  in_input_format_flags The format flags of the recording stream.
+    \param  in_output_bit_depth The bit depth of the playback stream.
+    \param  in_output_format_flags  The format flags of the playback stream.
+    \return The new resampler or NULL if the parameters are invalid or memory
+            could not be allocated. Free using cahal_drift_resampler_free.
+ */
+cahal_drift_resampler*
+cahal_drift_resampler_create  (
+                               UINT32                  in_number_of_channels,
+                               FLOAT64                 in_sample_rate,
+                               FLOAT64                 in_target_latency,
+                               FLOAT64                 in_maximum_latency,
+                               UINT32                  in_input_bit_depth,
+                               cahal_audio_format_flag in_input_format_flags,
+                               UINT32                  in_output_bit_depth,
+                               cahal_audio_format_flag in_output_format_flags
+                               );
+
+/*! \fn     void cahal_drift_resampler_free  (
+              cahal_drift_resampler* in_resampler
+            )
+    \brief  Frees the resampler. Both streams using the resampler must have
+            been stopped.
+
+    \param  in_resampler  The resampler to free.
+ */
+void
+cahal_drift_resampler_free  (
+                             cahal_drift_resampler* in_resampler
+                             );
+
+/*! \fn     UINT32 cahal_drift_resampler_write (
+              cahal_drift_resampler* io_resampler,
+              const FLOAT32*         in_frames,
+              UINT32                 in_number_of_frames
+            )
+    \brief  Writes recorded frames into the resampler. Called from the
+            recording side only.
+
+    \param  io_resampler  The resampler to write to.
+    \param  in_frames The interleaved frames to write.
+    \param  in_number_of_frames The number of frames in in_frames.
+    \return The number of frames accepted. Frames that do not fit within the
+            maximum latency are discarded and counted as overruns.
+ */
+UINT32
+cahal_drift_resampler_write (
+                             cahal_drift_resampler* io_resampler,
+                             const FLOAT32*         in_frames,
+                             UINT32                 in_number_of_frames
+                             );
+
+/*! \fn     void cahal_drift_resampler_read  (
+              cahal_drift_resampler* io_resampler,
+              FLOAT32*               out_frames,
+              UINT32                 in_number_of_frames
+            )
+    \brief  Produces exactly in_number_of_frames resampled frames. Called from
+            the playback side only. The resampling ratio is updated once per
+            CAHAL_DRIFT_RESAMPLER_CHUNK_FRAMES frames from the current fill
+            level. If not enough frames are
+            buffered the output is padded with silence.
+
+    \param  io_resampler  The resampler to read from.
+    \param  out_frames  The buffer to fill with interleaved frames.
+    \param  in_number_of_frames The number of frames to produce.
+ */
+void
+cahal_drift_resampler_read  (
+                             cahal_drift_resampler* io_resampler,
+                             FLOAT32*               out_frames,
+                             UINT32                 in_number_of_frames
+                             );
+
+/*! \fn     FLOAT64 cahal_drift_resampler_get_ppm  (
+              cahal_drift_resampler* in_resampler
+            )
+    \brief  Returns the estimated clock offset between the recording and the
+            playback device in parts per million. A positive value means the
+            recording device runs faster than the playback device.
+
+    \param  in_resampler  The resampler to query.
+    \return The estimated offset in ppm.
+ */
+FLOAT64
+cahal_drift_resampler_get_ppm  (
+                                cahal_drift_resampler* in_resampler
+                                );
+
+/*! \fn     FLOAT64 cahal_drift_resampler_get_latency  (
+              cahal_drift_resampler* in_resampler
+            )
+    \brief  Returns the current latency, i.e. the duration of the buffered
+            frames, in seconds.
+
+    \param  in_resampler  The resampler to query.
+    \return The buffered duration in seconds.
+ */
+FLOAT64
+cahal_drift_resampler_get_latency  (
+                                    cahal_drift_resampler* in_resampler
+                                    );
+
+/*! \fn     UINT32 cahal_drift_resampler_get_overruns  (
+              cahal_drift_resampler* in_resampler
+            )
+    \brief  Returns the number of recorded frames that were discarded.
+
+    \param  in_resampler  The resampler to query.
+    \return The number of discarded frames.
+ */
+UINT32
+cahal_drift_resampler_get_overruns  (
+                                     cahal_drift_resampler* in_resampler
+                                     );
+
+/*! \fn     UINT32 cahal_drift_resampler_get_underruns  (
+              cahal_drift_resampler* in_resampler
+            )
+    \brief  Returns the number of silent frames inserted in the playback
+            stream because no recorded frames were available.
+
+    \param  in_resampler  The resampler to query.
+    \return The number of inserted frames.
+ */
+UINT32
+cahal_drift_resampler_get_underruns  (
+                                      cahal_drift_resampler* in_resampler
+                                      );
+
+/*! \fn     CPC_BOOL cahal_drift_resampler_recorder_callback (
+              cahal_device* in_recording_device,
+              UCHAR*        in_data_buffer,
+              UINT32        in_data_buffer_length,
+              void*         in_client_data
+            )
+    \brief  cahal_recorder_callback that converts the recorded buffer to
+            floating point samples and writes them to the resampler passed in
+            in_client_data.
+
+    \param  in_recording_device The device the samples were recorded from.
+    \param  in_data_buffer  The recorded samples.
+    \param  in_data_buffer_length The size of in_data_buffer in bytes.
+    \param  in_client_data  The cahal_drift_resampler to write to.
+    \return True iff the samples were written to the resampler.
+ */
+CPC_BOOL
+cahal_drift_resampler_recorder_callback (
+                                         cahal_device* in_recording_device,
+                                         UCHAR*        in_data_buffer,
+                                         UINT32        in_data_buffer_length,
+                                         void*         in_client_data
+                                         );
+
+/*! \fn     CPC_BOOL cahal_drift_resampler_playback_callback (
+              cahal_device* in_playback_device,
+              UCHAR*        out_data_buffer,
+              UINT32*       io_data_buffer_length,
+              void*         in_client_data
+            )
+    \brief  cahal_playback_callback that fills out_data_buffer completely with
+            resampled frames read from the resampler passed in in_client_data.
+
+    \param  in_playback_device  The device the samples will be played on.
+    \param  out_data_buffer The buffer to fill.
+    \param  io_data_buffer_length The capacity of out_data_buffer on input, the
+                                  number of bytes written on output.
+    \param  in_client_data  The cahal_drift_resampler to read from.
+    \return True iff the buffer was filled.
+ */
+CPC_BOOL
+cahal_drift_resampler_playback_callback (
+                                         cahal_device* in_playback_device,
+                                         UCHAR*        out_data_buffer,
+                                         UINT32*       io_data_buffer_length,
+                                         void*         in_client_data
+                                         );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_DRIFT_RESAMPLER_H__ */
@@ -0,0 +1,423 @@
+/*! \file   cahal_echo_canceller.h
+    \brief  Acoustic echo canceller that removes the signal being played back
+            from the signal being recorded. The canceller is a partitioned block
+            frequency domain NLMS adaptive filter (multi-delay filter) that
+            models the echo path from the playback stream (the reference) to
+            every recorded channel.
+
+            The reference and the recording are aligned using the times at
+            which the samples are played and recorded, so the filter only has
+            to model the acoustic echo path and not the (much longer and
+            varying) buffering in the OS.
+
+            Once installed using cahal_set_echo_canceller the library taps the
+            playback stream and delivers echo-cancelled samples to the
+            cahal_recorder_callback. The recorded samples are delayed by
+            CAHAL_ECHO_CANCELLER_BLOCK_SIZE frames.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_ECHO_CANCELLER_H__
+#define __CAHAL_ECHO_CANCELLER_H__
+
+#include <cpcommon.h>
+
+#include "cahal_audio_format_flags.h"
+#include "cahal_ring_buffer.h"
+#include "cahal_fft.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_ECHO_CANCELLER_BLOCK_SIZE
+    \brief  The number of frames processed at a time. This is also the length
+            of a filter partition and the processing delay.
+ */
+#define CAHAL_ECHO_CANCELLER_BLOCK_SIZE         256
+
+/*! \def    CAHAL_ECHO_CANCELLER_SCRATCH_SAMPLES
+    \brief  The size (in samples) of the buffers used to convert recorded and
+            played back samples to floating point.
+ */
+#define CAHAL_ECHO_CANCELLER_SCRATCH_SAMPLES    4096
+
+/*! \def    CAHAL_ECHO_CANCELLER_MAXIMUM_TAIL_LENGTH
+    \brief  The longest supported echo tail in seconds.
+ */
+#define CAHAL_ECHO_CANCELLER_MAXIMUM_TAIL_LENGTH  1.0
+
+/*! \var    cahal_echo_canceller
+    \brief  Struct definition for the echo canceller.
+ */
+typedef struct cahal_echo_canceller_t
+{
+  /*! \var    number_of_channels
+      \brief  The number of recorded channels that are processed.
+   */
+  UINT32              number_of_channels;
+
+  /*! \var    sample_rate
+      \brief  The sample rate of both the recording and the playback stream.
+   */
+  FLOAT64             sample_rate;
+
+  /*! \var    number_of_partitions
+      \brief  The number of CAHAL_ECHO_CANCELLER_BLOCK_SIZE partitions of the
+              adaptive filter.
+   */
+  UINT32              number_of_partitions;
+
+  /*! \var    fft
+      \brief  Transform of size 2 * CAHAL_ECHO_CANCELLER_BLOCK_SIZE.
+   */
+  cahal_fft*          fft;
+
+  /*! \var    reference
+      \brief  Mono floating point reference samples written by the playback
+              side and read by the recording side.
+   */
+  cahal_ring_buffer*  reference;
+
+  /*! \var    anchors
+      \brief  Timestamps of the reference samples written by the playback
+              side, see cahal_echo_canceller_anchor.
+   */
+  cahal_ring_buffer*  anchors;
+
+  /*! \var    reference_write_index
+      \brief  The number of reference samples written. Playback side only.
+   */
+  UINT32              reference_write_index;
+
+  /*! \var    reference_read_index
+      \brief  The number of reference samples removed from reference. Recording
+              side only.
+   */
+  UINT32              reference_read_index;
+
+  /*! \var    reference_position
+      \brief  The index of the reference sample aligned with the first frame of
+              the next block. Recording side only.
+   */
+  UINT32              reference_position;
+
+  /*! \var    has_anchor
+      \brief  True once a reference timestamp has been received.
+   */
+  CPC_BOOL            has_anchor;
+
+  /*! \var    anchor_time
+      \brief  Play time (ns) of the reference sample at anchor_index.
+   */
+  UINT64              anchor_time;
+
+  /*! \var    anchor_index
+      \brief  Index of the reference sample played at anchor_time.
+   */
+  UINT32              anchor_index;
+
+  /*! \var    reference_frame
+      \brief  The previous and current block of reference samples.
+   */
+  FLOAT32*            reference_frame;
+
+  /*! \var    reference_real
+      \brief  Spectra (real parts) of the most recent number_of_partitions
+              reference frames.
+   */
+  FLOAT32*            reference_real;
+
+  /*! \var    reference_imaginary
+      \brief  Spectra (imaginary parts) of the reference frames.
+   */
+  FLOAT32*            reference_imaginary;
+
+  /*! \var    partition_head
+      \brief  The partition in the reference spectra holding the newest frame.
+   */
+  UINT32              partition_head;
+
+  /*! \var    reference_power
+      \brief  Smoothed power spectrum of the reference used to normalize the
+              step size.
+   */
+  FLOAT32*            reference_power;
+
+  /*! \var    weights_real
+      \brief  Filter partitions (real parts), number_of_partitions per channel.
+   */
+  FLOAT32*            weights_real;
+
+  /*! \var    weights_imaginary
+      \brief  Filter partitions (imaginary parts).
+   */
+  FLOAT32*            weights_imaginary;
+
+  /*! \var    constraint_partition
+      \brief  The partition that is gradient constrained in the next block. One
+              partition is constrained per block.
+   */
+  UINT32              constraint_partition;
+
+  /*! \var    input
+      \brief  The recorded samples of the block being collected, one block per
+              channel.
+   */
+  FLOAT32*            input;
+
+  /*! \var    output
+      \brief  The echo-cancelled samples of the previous block, one block per
+              channel.
+   */
+  FLOAT32*            output;
+
+  /*! \var    block_position
+      \brief  The number of frames collected in input.
+   */
+  UINT32              block_position;
+
+  /*! \var    block_time
+      \brief  The time (ns) at which the first frame in input was recorded.
+   */
+  UINT64              block_time;
+
+  /*! \var    time_domain
+      \brief  Scratch buffer of 2 * CAHAL_ECHO_CANCELLER_BLOCK_SIZE samples.
+   */
+  FLOAT32*            time_domain;
+
+  /*! \var    spectrum_real
+      \brief  Scratch spectrum (real parts).
+   */
+  FLOAT32*            spectrum_real;
+
+  /*! \var    spectrum_imaginary
+      \brief  Scratch spectrum (imaginary parts).
+   */
+  FLOAT32*            spectrum_imaginary;
+
+  /*! \var    capture_scratch
+      \brief  Conversion buffer used by the recording side.
+   */
+  FLOAT32*            capture_scratch;
+
+  /*! \var    playback_scratch
+      \brief  Conversion buffer used by the playback side.
+   */
+  FLOAT32*            playback_scratch;
+
+  /*! \var    mono_scratch
+      \brief  Down-mix buffer used by the playback side.
+   */
+  FLOAT32*            mono_scratch;
+
+  /*! \var    near_energy
+      \brief  Smoothed energy of the recorded signal.
+   */
+  FLOAT64             near_energy;
+
+  /*! \var    error_energy
+      \brief  Smoothed energy of the echo-cancelled signal.
+   */
+  FLOAT64             error_energy;
+
+} cahal_echo_canceller;
+
+/*! \var    g_echo_canceller
+    \brief  The echo canceller applied to recorded samples, or NULL. Set using
+            cahal_set_echo_canceller.
+ */
+extern cahal_echo_canceller* g_echo_canceller;
+
+/*! \fn     cahal_echo_canceller* cahal_echo_canceller_create  (
+              UINT32  in_number_of_channels,
+              FLOAT64 in_sample_rate,
+              FLOAT64 in_tail_length
+            )
+    \brief  Creates a new echo canceller. All memory used by the canceller is
+            allocated here.
+
+    \param  in_number_of_channels The number of channels of the recording.
+    \param  in_sample_rate  The sample rate of both the recording and the
+                            playback.
+    \param  in_tail_length  The length (in seconds) of the echo path that is
+                            modelled. Longer tails cancel more reverberation at
+                            a higher cost. Typical values are 0.1 to 0.25.
+    \return The new canceller or NULL if the parameters are invalid or memory
+            could not be allocated. Free using cahal_echo_canceller_free.
+ */
+cahal_echo_canceller*
+cahal_echo_canceller_create  (
+                              UINT32  in_number_of_channels,
+                              FLOAT64 in_sample_rate,
+                              FLOAT64 in_tail_length
+                              );
+
+/*! \fn     void cahal_echo_canceller_free  (
+              cahal_echo_canceller* in_canceller
+            )
+    \brief  Frees the canceller. The canceller must not be installed.
+
+    \param  in_canceller  The canceller to free.
+ */
+void
+cahal_echo_canceller_free  (
+                            cahal_echo_canceller* in_canceller
+                            );
+
+/*! \fn     CPC_BOOL cahal_set_echo_canceller  (
+              cahal_echo_canceller* in_canceller
+            )
+    \brief  Installs in_canceller so that it is applied to recorded samples,
+            using the samples being played back as the reference. Fails
+            unless both streams are idle or stopped, which are kept from
+            starting while in_canceller is installed, so the previously
+            installed canceller can be freed once this returns. Samples are
+            only processed if the recording has
+            in_canceller->number_of_channels channels and both streams run at
+            in_canceller->sample_rate.
+
+    \param  in_canceller  The canceller to install, or NULL to remove the
+                          installed canceller.
+    \return True iff the canceller was installed, false if a stream was
+            starting, running, paused or stopping.
+ */
+CPC_BOOL
+cahal_set_echo_canceller  (
+                           cahal_echo_canceller* in_canceller
+                           );
+
+/*! \fn     void cahal_echo_canceller_write_reference  (
+              cahal_echo_canceller* io_canceller,
+              const FLOAT32*        in_frames,
+              UINT32                in_number_of_frames,
+              UINT32                in_number_of_channels,
+              UINT64                in_play_time
+            )
+    \brief  Adds played back frames to the reference. Called from the playback
+            side only. Multi-channel frames are down-mixed.
+
+    \param  io_canceller  The canceller to add the reference to.
+    \param  in_frames The interleaved frames being played back.
+    \param  in_number_of_frames The number of frames in in_frames.
+    \param  in_number_of_channels The number of channels in in_frames.
+    \param  in_play_time  The time (ns, see cahal_get_time) at which the first
+                          frame is played.
+ */
+void
+cahal_echo_canceller_write_reference  (
+                                   cahal_echo_canceller* io_canceller,
+                                   const FLOAT32*        in_frames,
+                                   UINT32                in_number_of_frames,
+                                   UINT32                in_number_of_channels,
+                                   UINT64                in_play_time
+                                   );
+
+/*! \fn     void cahal_echo_canceller_process  (
+              cahal_echo_canceller* io_canceller,
+              FLOAT32*              io_frames,
+              UINT32                in_number_of_frames,
+              UINT64                in_record_time
+            )
+    \brief  Removes the echo from recorded frames in place. Called from the
+            recording side only. The output is delayed by
+            CAHAL_ECHO_CANCELLER_BLOCK_SIZE frames.
+
+    \param  io_canceller  The canceller to use.
+    \param  io_frames The interleaved recorded frames, replaced by the
+                      echo-cancelled frames.
+    \param  in_number_of_frames The number of frames in io_frames.
+    \param  in_record_time  The time (ns, see cahal_get_time) at which the first
+                            frame was recorded.
+ */
+void
+cahal_echo_canceller_process  (
+                               cahal_echo_canceller* io_canceller,
+                               FLOAT32*              io_frames,
+                               UINT32                in_number_of_frames,
+                               UINT64                in_record_time
+                               );
+
+/*! \fn     CPC_BOOL cahal_echo_canceller_write_reference_buffer  (
+              cahal_echo_canceller*   io_canceller,
+              const UCHAR*            in_buffer,
+              UINT32                  in_buffer_length,
+              UINT32                  in_number_of_channels,
+              UINT32                  in_bit_depth,
+              cahal_audio_format_flag in_format_flags,
+              UINT64                  in_play_time
+            )
+    \brief  Same as cahal_echo_canceller_write_reference for a buffer of linear
+            PCM samples as passed to a cahal_playback_callback.
+
+    \param  io_canceller  The canceller to add the reference to.
+    \param  in_buffer The samples being played back.
+    \param  in_buffer_length  The size of in_buffer in bytes.
+    \param  in_number_of_channels The number of channels in in_buffer.
+    \param  in_bit_depth  The bit depth of the samples.
+    \param  in_format_flags The format flags of the samples.
+    \param  in_play_time  The time (ns) at which the first frame is played.
+    \return True iff the format is supported and the reference was added.
+ */
+CPC_BOOL
+cahal_echo_canceller_write_reference_buffer  (
+                                 cahal_echo_canceller*   io_canceller,
+                                 const UCHAR*            in_buffer,
+                                 UINT32                  in_buffer_length,
+                                 UINT32                  in_number_of_channels,
+                                 UINT32                  in_bit_depth,
+                                 cahal_audio_format_flag in_format_flags,
+                                 UINT64                  in_play_time
+                                 );
+
+/*! \fn     CPC_BOOL cahal_echo_canceller_process_buffer  (
+              cahal_echo_canceller*   io_canceller,
+              UCHAR*                  io_buffer,
+              UINT32                  in_buffer_length,
+              UINT32                  in_bit_depth,
+              cahal_audio_format_flag in_format_flags,
+              UINT64                  in_record_time
+            )
+    \brief  Same as cahal_echo_canceller_process for a buffer of linear PCM
+            samples as passed to a cahal_recorder_callback.
+
+    \param  io_canceller  The canceller to use.
+    \param  io_buffer The recorded samples, replaced in place.
+    \param  in_buffer_length  The size of io_buffer in bytes.
+    \param  in_bit_depth  The bit depth of the samples.
+    \param  in_format_flags The format flags of the samples.
+    \param  in_record_time  The time (ns) at which the first frame was recorded.
+    \return True iff the format is supported and the buffer was processed.
+ */
+CPC_BOOL
+cahal_echo_canceller_process_buffer  (
+                                      cahal_echo_canceller*   io_canceller,
+                                      UCHAR*                  io_buffer,
+                                      UINT32                  in_buffer_length,
+                                      UINT32                  in_bit_depth,
+                                      cahal_audio_format_flag in_format_flags,
+                                      UINT64                  in_record_time
+                                      );
+
+/*! \fn     FLOAT64 cahal_echo_canceller_get_erle  (
+              cahal_echo_canceller* in_canceller
+            )
+    \brief  Returns the echo return loss enhancement, i.e. the ratio of the
+            recorded to the echo-cancelled signal energy in dB, averaged over
+            the last few seconds.
+
+    \param  in_canceller  The canceller to query.
+    \return The ERLE in dB.
+ */
+FLOAT64
+cahal_echo_canceller_get_erle  (
+                                cahal_echo_canceller* in_canceller
+                                );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_ECHO_CANCELLER_H__ */
@@ -0,0 +1,150 @@
+/*! \file   cahal_fft.h
+    \brief  Real-valued fast Fourier transform used by the frequency domain
+            signal processing stages in the library. The transform size must
+            be a power of two. A transform of size N maps N real samples to
+            N / 2 + 1 complex bins which are stored as separate arrays of real
+            and imaginary parts.
+
+            The forward transform is unscaled, the inverse transform is scaled
+            by 1 / N so that a forward transform followed by an inverse
+            transform returns the original samples.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_FFT_H__
+#define __CAHAL_FFT_H__
+
+#include <cpcommon.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \var    cahal_fft
+    \brief  Struct definition for a precomputed transform of a fixed size.
+ */
+typedef struct cahal_fft_t
+{
+  /*! \var    size
+      \brief  The number of real samples transformed.
+   */
+  UINT32    size;
+
+  /*! \var    half_size
+      \brief  The size of the complex transform used internally, i.e. size / 2.
+   */
+  UINT32    half_size;
+
+  /*! \var    bit_reverse
+      \brief  Bit reversal permutation of the complex transform.
+   */
+  UINT32*   bit_reverse;
+
+  /*! \var    twiddle_real
+      \brief  Real part of the twiddle factors of the complex transform.
+   */
+  FLOAT32*  twiddle_real;
+
+  /*! \var    twiddle_imaginary
+      \brief  Imaginary part of the twiddle factors of the complex transform.
+   */
+  FLOAT32*  twiddle_imaginary;
+
+  /*! \var    split_real
+      \brief  Real part of the factors used to split the complex transform into
+              the transform of the real input.
+   */
+  FLOAT32*  split_real;
+
+  /*! \var    split_imaginary
+      \brief  Imaginary part of the split factors.
+   */
+  FLOAT32*  split_imaginary;
+
+  /*! \var    work_real
+      \brief  Scratch buffer (real part) of half_size entries.
+   */
+  FLOAT32*  work_real;
+
+  /*! \var    work_imaginary
+      \brief  Scratch buffer (imaginary part) of half_size entries.
+   */
+  FLOAT32*  work_imaginary;
+
+} cahal_fft;
+
+/*! \fn     cahal_fft* cahal_fft_create  (
+              UINT32 in_size
+            )
+    \brief  Precomputes the tables for a transform of in_size real samples.
+
+    \param  in_size The transform size. Must be a power of two and at least 4.
+    \return The transform or NULL if in_size is invalid or memory could not be
+            allocated. Free using cahal_fft_free.
+ */
+cahal_fft*
+cahal_fft_create  (
+                   UINT32 in_size
+                   );
+
+/*! \fn     void cahal_fft_free  (
+              cahal_fft* in_fft
+            )
+    \brief  Frees the transform and all its tables.
+
+    \param  in_fft  The transform to free.
+ */
+void
+cahal_fft_free  (
+                 cahal_fft* in_fft
+                 );
+
+/*! \fn     void cahal_fft_forward (
+              cahal_fft*     in_fft,
+              const FLOAT32* in_samples,
+              FLOAT32*       out_real,
+              FLOAT32*       out_imaginary
+            )
+    \brief  Computes the spectrum of in_fft->size real samples.
+
+    \param  in_fft  The transform to use. Its scratch buffers are modified, so
+                    a transform must not be shared between threads.
+    \param  in_samples  The in_fft->size samples to transform.
+    \param  out_real  The real parts of the in_fft->size / 2 + 1 bins.
+    \param  out_imaginary The imaginary parts of the in_fft->size / 2 + 1 bins.
+ */
+void
+cahal_fft_forward (
+                   cahal_fft*     in_fft,
+                   const FLOAT32* in_samples,
+                   FLOAT32*       out_real,
+                   FLOAT32*       out_imaginary
+                   );
+
+/*! \fn     void cahal_fft_inverse (
+              cahal_fft*     in_fft,
+              const FLOAT32* in_real,
+              const FLOAT32* in_imaginary,
+              FLOAT32*       out_samples
+            )
+    \brief  Computes the in_fft->size real samples of a hermitian spectrum.
+
+    \param  in_fft  The transform to use.
+    \param  in_real The real parts of the in_fft->size / 2 + 1 bins.
+    \param  in_imaginary  The imaginary parts of the in_fft->size / 2 + 1 bins.
+    \param  out_samples The in_fft->size resulting samples.
+ */
+void
+cahal_fft_inverse (
+                   cahal_fft*     in_fft,
+                   const FLOAT32* in_real,
+                   const FLOAT32* in_imaginary,
+                   FLOAT32*       out_samples
+                   );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_FFT_H__ */
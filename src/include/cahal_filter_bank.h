@@ -0,0 +1,300 @@
+/*! \file   cahal_filter_bank.h
+    \brief  Cascade of second order (biquad) IIR sections applied to every
+            channel of a stream, e.g. DC removal followed by mains hum notches
+            on a microphone array.
+
+            The filter memory is stored channel-major per section (structure
+            of arrays) so that, for each interleaved frame, all channels are
+            filtered together four at a time using SSE or NEON when available.
+
+            A bank can be applied to any stream: directly on floating point
+            frames (cahal_filter_bank_process), on linear PCM buffers inside a
+            callback (cahal_filter_bank_process_buffer), as a processing graph
+            node (cahal_graph_add_filter) or on every matching recording by
+            installing it with cahal_set_capture_filter_bank.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_FILTER_BANK_H__
+#define __CAHAL_FILTER_BANK_H__
+
+#include <cpcommon.h>
+
+#include "cahal_audio_format_flags.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_FILTER_BANK_MAXIMUM_SECTIONS
+    \brief  The maximum number of biquad sections in a bank.
+ */
+#define CAHAL_FILTER_BANK_MAXIMUM_SECTIONS  16
+
+/*! \def    CAHAL_FILTER_BANK_CHUNK_FRAMES
+    \brief  The number of frames converted at a time by
+            cahal_filter_bank_process_buffer.
+ */
+#define CAHAL_FILTER_BANK_CHUNK_FRAMES      512
+
+/*! \enum   cahal_filter_types
+    \brief  The section responses supported by a filter bank.
+ */
+enum cahal_filter_types
+{
+  CAHAL_FILTER_LOWPASS    = 0,
+  CAHAL_FILTER_HIGHPASS   = 1,
+  CAHAL_FILTER_BANDPASS   = 2,
+  CAHAL_FILTER_NOTCH      = 3,
+  CAHAL_FILTER_PEAK       = 4,
+  CAHAL_FILTER_LOW_SHELF  = 5,
+  CAHAL_FILTER_HIGH_SHELF = 6,
+  CAHAL_FILTER_DC_BLOCK   = 7,
+};
+
+/*! \def    cahal_filter_type
+    \brief  Type definition for the section responses.
+ */
+typedef UINT32 cahal_filter_type;
+
+/*! \var    cahal_filter_section
+    \brief  Struct definition for a single biquad section.
+ */
+typedef struct cahal_filter_section_t
+{
+  /*! \var    filter_type
+      \brief  The response of the section.
+   */
+  cahal_filter_type filter_type;
+
+  /*! \var    frequency
+      \brief  The corner or centre frequency in Hz.
+   */
+  FLOAT64           frequency;
+
+  /*! \var    quality
+      \brief  The quality factor. Unused by DC blocking sections.
+   */
+  FLOAT64           quality;
+
+  /*! \var    gain
+      \brief  The gain in dB of peak and shelving sections.
+   */
+  FLOAT64           gain;
+
+  /*! \var    coefficients
+      \brief  The normalized coefficients b0, b1, b2, a1 and a2.
+   */
+  FLOAT32           coefficients[ 5 ];
+
+} cahal_filter_section;
+
+/*! \var    cahal_filter_bank
+    \brief  Struct definition for a cascade of biquad sections.
+ */
+typedef struct cahal_filter_bank_t
+{
+  /*! \var    number_of_channels
+      \brief  The number of interleaved channels filtered.
+   */
+  UINT32                  number_of_channels;
+
+  /*! \var    sample_rate
+      \brief  The sample rate the sections are designed for.
+   */
+  FLOAT64                 sample_rate;
+
+  /*! \var    sections
+      \brief  The sections, applied in order.
+   */
+  cahal_filter_section    sections[ CAHAL_FILTER_BANK_MAXIMUM_SECTIONS ];
+
+  /*! \var    number_of_sections
+      \brief  The number of sections in use.
+   */
+  UINT32                  number_of_sections;
+
+  /*! \var    state
+      \brief  The filter memory. For section s the first state variable of
+              every channel is stored at state + 2 * s * number_of_channels
+              and the second one number_of_channels samples later.
+   */
+  FLOAT32*                state;
+
+  /*! \var    scratch
+      \brief  Conversion buffer used by cahal_filter_bank_process_buffer.
+   */
+  FLOAT32*                scratch;
+
+} cahal_filter_bank;
+
+/*! \var    g_capture_filter_bank
+    \brief  The filter bank applied to recorded samples, or NULL. Set using
+            cahal_set_capture_filter_bank.
+ */
+extern cahal_filter_bank* g_capture_filter_bank;
+
+/*! \fn     cahal_filter_bank* cahal_filter_bank_create  (
+              UINT32  in_number_of_channels,
+              FLOAT64 in_sample_rate
+            )
+    \brief  Creates an empty filter bank. Without sections the bank passes
+            samples through unchanged.
+
+    \param  in_number_of_channels The number of interleaved channels.
+    \param  in_sample_rate  The sample rate of the stream. May be zero if it
+                            is not yet known, in which case it must be set
+                            using cahal_filter_bank_set_sample_rate before
+                            the sections have any effect.
+    \return The new bank or NULL on error. Free using cahal_filter_bank_free.
+ */
+cahal_filter_bank*
+cahal_filter_bank_create  (
+                           UINT32  in_number_of_channels,
+                           FLOAT64 in_sample_rate
+                           );
+
+/*! \fn     void cahal_filter_bank_free  (
+              cahal_filter_bank* in_bank
+            )
+    \brief  Frees the bank. The bank must not be installed or used by a
+            running stream.
+
+    \param  in_bank The bank to free.
+ */
+void
+cahal_filter_bank_free  (
+                         cahal_filter_bank* in_bank
+                         );
+
+/*! \fn     CPC_BOOL cahal_filter_bank_add_section  (
+              cahal_filter_bank*  io_bank,
+              cahal_filter_type   in_filter_type,
+              FLOAT64             in_frequency,
+              FLOAT64             in_quality,
+              FLOAT64             in_gain
+            )
+    \brief  Appends a section designed with the formulae of the Audio EQ
+            Cookbook (R. Bristow-Johnson). A DC blocking section is the first
+            order high-pass 1 - z^-1 / ( 1 - R z^-1 ) with its -3 dB corner at
+            in_frequency.
+
+    \param  io_bank The bank to add the section to.
+    \param  in_filter_type  The response of the section.
+    \param  in_frequency  The corner or centre frequency in Hz, below the
+                          Nyquist frequency.
+    \param  in_quality  The quality factor, e.g. 0.7071 for a Butterworth
+                        response or 30 for a narrow notch.
+    \param  in_gain The gain in dB of peak and shelving sections.
+    \return True iff the section was added.
+ */
+CPC_BOOL
+cahal_filter_bank_add_section  (
+                                cahal_filter_bank*  io_bank,
+                                cahal_filter_type   in_filter_type,
+                                FLOAT64             in_frequency,
+                                FLOAT64             in_quality,
+                                FLOAT64             in_gain
+                                );
+
+/*! \fn     CPC_BOOL cahal_filter_bank_set_sample_rate (
+              cahal_filter_bank*  io_bank,
+              FLOAT64             in_sample_rate
+            )
+    \brief  Redesigns every section for in_sample_rate and clears the filter
+            memory.
+
+    \param  io_bank The bank to redesign.
+    \param  in_sample_rate  The new sample rate.
+    \return True iff every section frequency is below the new Nyquist
+            frequency.
+ */
+CPC_BOOL
+cahal_filter_bank_set_sample_rate (
+                                   cahal_filter_bank*  io_bank,
+                                   FLOAT64             in_sample_rate
+                                   );
+
+/*! \fn     void cahal_filter_bank_reset (
+              cahal_filter_bank* io_bank
+            )
+    \brief  Clears the filter memory.
+
+    \param  io_bank The bank to reset.
+ */
+void
+cahal_filter_bank_reset (
+                         cahal_filter_bank* io_bank
+                         );
+
+/*! \fn     void cahal_filter_bank_process (
+              cahal_filter_bank* io_bank,
+              FLOAT32*           io_frames,
+              UINT32             in_number_of_frames
+            )
+    \brief  Filters interleaved floating point frames in place.
+
+    \param  io_bank The bank to apply.
+    \param  io_frames The frames to filter.
+    \param  in_number_of_frames The number of frames in io_frames.
+ */
+void
+cahal_filter_bank_process (
+                           cahal_filter_bank* io_bank,
+                           FLOAT32*           io_frames,
+                           UINT32             in_number_of_frames
+                           );
+
+/*! \fn     CPC_BOOL cahal_filter_bank_process_buffer  (
+              cahal_filter_bank*      io_bank,
+              UCHAR*                  io_buffer,
+              UINT32                  in_buffer_length,
+              UINT32                  in_bit_depth,
+              cahal_audio_format_flag in_format_flags
+            )
+    \brief  Same as cahal_filter_bank_process for a buffer of linear PCM
+            samples as passed to a cahal_recorder_callback or produced by a
+            cahal_playback_callback.
+
+    \param  io_bank The bank to apply.
+    \param  io_buffer The samples, replaced in place.
+    \param  in_buffer_length  The size of io_buffer in bytes.
+    \param  in_bit_depth  The bit depth of the samples.
+    \param  in_format_flags The format flags of the samples.
+    \return True iff the format is supported and the buffer was filtered.
+ */
+CPC_BOOL
+cahal_filter_bank_process_buffer  (
+                                   cahal_filter_bank*      io_bank,
+                                   UCHAR*                  io_buffer,
+                                   UINT32                  in_buffer_length,
+                                   UINT32                  in_bit_depth,
+                                   cahal_audio_format_flag in_format_flags
+                                   );
+
+/*! \fn     CPC_BOOL cahal_set_capture_filter_bank  (
+              cahal_filter_bank* in_bank
+            )
+    \brief  Installs in_bank so that it is applied to recorded samples before
+            they are passed to the recording callback (after echo
+            cancellation, if any). Fails unless the recording is idle or
+            stopped, and keeps it from starting while in_bank is installed,
+            so the previously installed bank can be freed once this returns.
+            Samples are only filtered if the recording has
+            in_bank->number_of_channels channels at in_bank->sample_rate.
+
+    \param  in_bank The bank to install, or NULL to remove the installed bank.
+    \return True iff the bank was installed, false if in_bank has no sample
+            rate or a recording was starting, running, paused or stopping.
+ */
+CPC_BOOL
+cahal_set_capture_filter_bank  (
+                                cahal_filter_bank* in_bank
+                                );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_FILTER_BANK_H__ */
@@ -0,0 +1,279 @@
+/*! \file   cahal_format_negotiation.h
+    \brief  Picks the hardware native format of a stream that is closest to the
+            format a caller would like to use, and describes the conversions
+            the library applies between the two.
+
+            The formats of a stream are indexed once (see
+            cahal_create_format_index). The index keeps the formats in a
+            compact array sorted by format, channels and bit depth and hashes
+            each distinct combination, so a request that the hardware supports
+            as is is answered without looking at the other formats. Every
+            device snapshot holds an index for each of its streams, see
+            cahal_get_format_index.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_FORMAT_NEGOTIATION_H__
+#define __CAHAL_FORMAT_NEGOTIATION_H__
+
+#include <cpcommon.h>
+
+#include "cahal_audio_format_description.h"
+#include "cahal_audio_format_flags.h"
+#include "cahal_device_stream.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_FORMAT_MAXIMUM_STEPS
+    \brief  The maximum number of steps in a conversion chain.
+ */
+#define CAHAL_FORMAT_MAXIMUM_STEPS  4
+
+/*! \var    cahal_format_conversions
+    \brief  The conversions that can be needed between a requested format and
+            a native format. Used as a bitmask.
+ */
+enum cahal_format_conversions
+{
+  CAHAL_FORMAT_CONVERSION_NONE          = 0,
+  CAHAL_FORMAT_CONVERSION_SAMPLE_FORMAT = ( 1 << 0 ),
+  CAHAL_FORMAT_CONVERSION_CHANNELS      = ( 1 << 1 ),
+  CAHAL_FORMAT_CONVERSION_SAMPLE_RATE   = ( 1 << 2 ),
+  CAHAL_FORMAT_CONVERSION_ALL           = ( 1 << 3 ) - 1
+};
+
+/*! \var    cahal_format_conversion_steps
+    \brief  The steps of a conversion chain. Samples are processed as 32-bit
+            floating point samples, see cahal_audio_convert.h, so a chain
+            starts by converting to and ends by converting from that format
+            unless the samples already are in it.
+ */
+enum cahal_format_conversion_steps
+{
+  CAHAL_FORMAT_STEP_TO_FLOAT32 = 0,
+  CAHAL_FORMAT_STEP_MIX_CHANNELS,
+  CAHAL_FORMAT_STEP_RESAMPLE,
+  CAHAL_FORMAT_STEP_FROM_FLOAT32
+};
+
+/*! \var    cahal_format_request
+    \brief  Struct definition for the format a caller would like to use and
+            the constraints on the conversions it accepts.
+ */
+typedef struct cahal_format_request_t
+{
+  /*! \var    format_id
+      \brief  The requested format. Only CAHAL_AUDIO_FORMAT_LINEARPCM can be
+              converted; other formats only match natively.
+   */
+  cahal_audio_format_id   format_id;
+
+  /*! \var    sample_rate
+      \brief  The requested sample rate.
+   */
+  FLOAT64                 sample_rate;
+
+  /*! \var    number_of_channels
+      \brief  The requested number of channels.
+   */
+  UINT32                  number_of_channels;
+
+  /*! \var    bit_depth
+      \brief  The requested quantization level.
+   */
+  UINT32                  bit_depth;
+
+  /*! \var    format_flags
+      \brief  The flags describing the caller's samples.
+              CAHAL_AUDIO_FORMAT_FLAGISFLOAT prefers floating point samples
+              and otherwise integer samples are preferred.
+   */
+  cahal_audio_format_flag format_flags;
+
+  /*! \var    sample_rate_tolerance
+      \brief  The distance, in Hz, from sample_rate that the caller accepts
+              without resampling.
+   */
+  FLOAT64                 sample_rate_tolerance;
+
+  /*! \var    maximum_latency
+      \brief  The largest latency, in seconds, that the conversions may add,
+              or 0 for no limit.
+   */
+  FLOAT64                 maximum_latency;
+
+  /*! \var    allowed_conversions
+      \brief  A bitmask of cahal_format_conversions that may be applied.
+   */
+  UINT32                  allowed_conversions;
+
+} cahal_format_request;
+
+/*! \var    cahal_format_match
+    \brief  Struct definition for the result of a negotiation.
+ */
+typedef struct cahal_format_match_t
+{
+  /*! \var    format
+      \brief  The native format to open the stream with. It belongs to the
+              stream.
+   */
+  cahal_audio_format_description* format;
+
+  /*! \var    sample_rate
+      \brief  The sample rate to open the stream at. It lies within the sample
+              rate range of format.
+   */
+  FLOAT64                         sample_rate;
+
+  /*! \var    format_flags
+      \brief  The flags to open the stream with.
+   */
+  cahal_audio_format_flag         format_flags;
+
+  /*! \var    conversions
+      \brief  A bitmask of the cahal_format_conversions needed.
+   */
+  UINT32                          conversions;
+
+  /*! \var    steps
+      \brief  The cahal_format_conversion_steps applied, in order, to samples
+              on their way from the producer to the consumer, i.e. from the
+              caller to the device for output streams and from the device to
+              the caller for input streams.
+   */
+  UINT32                          steps[ CAHAL_FORMAT_MAXIMUM_STEPS ];
+
+  /*! \var    number_of_steps
+      \brief  The number of steps in steps.
+   */
+  UINT32                          number_of_steps;
+
+  /*! \var    latency
+      \brief  The latency, in seconds, added by the conversions.
+   */
+  FLOAT64                         latency;
+
+  /*! \var    cost
+      \brief  The relative cost of the conversions. A native match costs 0.
+   */
+  FLOAT64                         cost;
+
+} cahal_format_match;
+
+/*! \var    cahal_format_index_entry
+    \brief  Struct definition for one native format in an index.
+ */
+typedef struct cahal_format_index_entry_t
+{
+  /*! \var    format
+      \brief  The native format.
+   */
+  cahal_audio_format_description* format;
+
+  /*! \var    key
+      \brief  The hash key of the format, channels and bit depth.
+   */
+  UINT64                          key;
+
+  /*! \var    minimum_rate
+      \brief  The smallest sample rate of format.
+   */
+  FLOAT64                         minimum_rate;
+
+  /*! \var    maximum_rate
+      \brief  The largest sample rate of format.
+   */
+  FLOAT64                         maximum_rate;
+
+} cahal_format_index_entry;
+
+/*! \var    cahal_format_index
+    \brief  Struct definition for the index of the native formats of a stream.
+ */
+typedef struct cahal_format_index_t
+{
+  /*! \var    stream
+      \brief  The indexed stream.
+   */
+  cahal_device_stream*      stream;
+
+  /*! \var    entries
+      \brief  The distinct native formats, sorted by key and minimum rate.
+   */
+  cahal_format_index_entry* entries;
+
+  /*! \var    number_of_entries
+      \brief  The number of entries.
+   */
+  UINT32                    number_of_entries;
+
+  /*! \var    buckets
+      \brief  Open addressed hash table mapping a key to one plus the index of
+              the first entry with that key, or 0 for an empty slot.
+   */
+  UINT32*                   buckets;
+
+  /*! \var    number_of_buckets
+      \brief  The number of slots in buckets. Always a power of two.
+   */
+  UINT32                    number_of_buckets;
+
+} cahal_format_index;
+
+/*! \fn     cahal_format_index* cahal_create_format_index  (
+              cahal_device_stream* in_stream
+            )
+    \brief  Indexes the supported formats of in_stream. The index refers to
+            the formats and must not outlive the stream.
+
+    \param  in_stream The stream to index.
+    \return The index or NULL on error. Free using cahal_free_format_index.
+ */
+cahal_format_index*
+cahal_create_format_index  (
+                            cahal_device_stream* in_stream
+                            );
+
+/*! \fn     CPC_BOOL cahal_find_best_format  (
+              cahal_format_index*   in_index,
+              cahal_format_request* in_request,
+              cahal_format_match*   out_match
+            )
+    \brief  Finds the native format of the indexed stream that needs the
+            cheapest conversions to in_request and satisfies its
+            constraints. Resampling costs more than mixing channels, which
+            costs more than converting samples.
+
+    \param  in_index  The index of the stream.
+    \param  in_request  The requested format and constraints.
+    \param  out_match The best format and the conversions it needs.
+    \return True iff a format satisfying the constraints was found.
+ */
+CPC_BOOL
+cahal_find_best_format  (
+                         cahal_format_index*   in_index,
+                         cahal_format_request* in_request,
+                         cahal_format_match*   out_match
+                         );
+
+/*! \fn     void cahal_free_format_index  (
+              cahal_format_index* in_index
+            )
+    \brief  Frees an index created by cahal_create_format_index.
+
+    \param  in_index  The index to free. May be NULL.
+ */
+void
+cahal_free_format_index  (
+                          cahal_format_index* in_index
+                          );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_FORMAT_NEGOTIATION_H__ */
@@ -0,0 +1,777 @@
+/*! \file   cahal_graph.h
+    \brief  Processing graph that sits between a device and the user
+            callback. A graph is made of nodes with a single floating point
+            output port and zero or more input ports. Every port carries
+            interleaved 32-bit floating point frames with a fixed number of
+            channels (the port type); connections are only accepted between
+            ports of the same type.
+
+            The input node converts the samples entering the graph to floating
+            point and the output node converts the samples leaving the graph
+            to the destination format. cahal_graph_prepare sorts the nodes
+            topologically and allocates every buffer once; processing then
+            runs the nodes in that order without allocating. Nodes that
+            process in place (gain, filter, meter, user and output nodes)
+            share the buffer of their source whenever they are its only
+            consumer so no copies are made between them.
+
+            For recording pass cahal_graph_recorder_callback to
+            cahal_start_recording with the graph as the callback user data;
+            the processed frames are passed to the callback set with
+            cahal_graph_set_recorder_callback. For playback pass
+            cahal_graph_playback_callback to cahal_start_playback; the frames
+            entering the graph are requested from the callback set with
+            cahal_graph_set_playback_callback.
+
+            A graph must not be modified while a stream is using it.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_GRAPH_H__
+#define __CAHAL_GRAPH_H__
+
+#include <cpcommon.h>
+
+#include "cahal_device.h"
+#include "cahal_audio_format_flags.h"
+#include "cahal_filter_bank.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_GRAPH_MAXIMUM_INPUTS
+    \brief  The maximum number of input ports of a node.
+ */
+#define CAHAL_GRAPH_MAXIMUM_INPUTS  8
+
+/*! \enum   cahal_graph_node_types
+    \brief  The kinds of node that can be added to a graph.
+ */
+enum cahal_graph_node_types
+{
+  CAHAL_GRAPH_NODE_INPUT    = 0,
+  CAHAL_GRAPH_NODE_OUTPUT   = 1,
+  CAHAL_GRAPH_NODE_GAIN     = 2,
+  CAHAL_GRAPH_NODE_REMIX    = 3,
+  CAHAL_GRAPH_NODE_MIX      = 4,
+  CAHAL_GRAPH_NODE_RESAMPLE = 5,
+  CAHAL_GRAPH_NODE_FILTER   = 6,
+  CAHAL_GRAPH_NODE_METER    = 7,
+  CAHAL_GRAPH_NODE_USER     = 8,
+};
+
+/*! \def    cahal_graph_node_type
+    \brief  Type definition for the kinds of node.
+ */
+typedef UINT32 cahal_graph_node_type;
+
+/*! \def    cahal_graph_node_callback
+    \brief  The function prototype of the callback of a user node. The
+            callback processes in_number_of_frames interleaved frames in
+            place.
+
+    \param  io_frames The frames to process.
+    \param  in_number_of_frames The number of frames in io_frames.
+    \param  in_number_of_channels The number of channels in each frame.
+    \param  in_user_data  The user data passed to cahal_graph_add_user.
+    \return True iff the frames were processed. Processing of the graph stops
+            if false is returned.
+ */
+typedef CPC_BOOL (*cahal_graph_node_callback) (
+  FLOAT32*  io_frames,
+  UINT32    in_number_of_frames,
+  UINT32    in_number_of_channels,
+  void*     in_user_data
+);
+
+/*! \var    cahal_graph_node
+    \brief  Struct definition for a node of a processing graph.
+ */
+typedef struct cahal_graph_node_t
+{
+  /*! \var    node_type
+      \brief  The kind of node.
+   */
+  cahal_graph_node_type       node_type;
+
+  /*! \var    number_of_channels
+      \brief  The type of the output port, i.e. the number of channels in
+              each output frame.
+   */
+  UINT32                      number_of_channels;
+
+  /*! \var    input_channels
+      \brief  The type of the input ports.
+   */
+  UINT32                      input_channels;
+
+  /*! \var    number_of_inputs
+      \brief  The number of input ports.
+   */
+  UINT32                      number_of_inputs;
+
+  /*! \var    inputs
+      \brief  The node connected to each input port.
+   */
+  struct cahal_graph_node_t*  inputs[ CAHAL_GRAPH_MAXIMUM_INPUTS ];
+
+  /*! \var    number_of_outputs
+      \brief  The number of input ports this node is connected to.
+   */
+  UINT32                      number_of_outputs;
+
+  /*! \var    sample_rate
+      \brief  The sample rate of the output port. Set when the node is created
+              for input, output and resample nodes and inherited from the
+              inputs by cahal_graph_prepare for all other nodes.
+   */
+  FLOAT64                     sample_rate;
+
+  /*! \var    bit_depth
+      \brief  Bit depth of the samples entering (input node) or leaving
+              (output node) the graph.
+   */
+  UINT32                      bit_depth;
+
+  /*! \var    format_flags
+      \brief  Format flags of the samples entering (input node) or leaving
+              (output node) the graph.
+   */
+  cahal_audio_format_flag     format_flags;
+
+  /*! \var    filter_bank
+      \brief  The cascade of biquad sections of a filter node.
+   */
+  cahal_filter_bank*          filter_bank;
+
+  /*! \var    parameters
+      \brief  The per-channel gains of a gain node or the output x input gain
+              matrix of a remix node.
+   */
+  FLOAT32*                    parameters;
+
+  /*! \var    state
+      \brief  The per-channel peak and RMS levels of a meter node or the
+              previous input frame of a resample node.
+   */
+  FLOAT32*                    state;
+
+  /*! \var    position
+      \brief  The fractional read position of a resample node.
+   */
+  FLOAT64                     position;
+
+  /*! \var    callback
+      \brief  The callback of a user node.
+   */
+  cahal_graph_node_callback   callback;
+
+  /*! \var    user_data
+      \brief  The user data passed to the callback of a user node.
+   */
+  void*                       user_data;
+
+  /*! \var    buffer
+      \brief  The frames on the output port.
+   */
+  FLOAT32*                    buffer;
+
+  /*! \var    buffer_capacity
+      \brief  The capacity, in frames, of buffer.
+   */
+  UINT32                      buffer_capacity;
+
+  /*! \var    owns_buffer
+      \brief  False if buffer is shared with the node connected to the first
+              input port.
+   */
+  CPC_BOOL                    owns_buffer;
+
+  /*! \var    number_of_frames
+      \brief  The number of frames on the output port after processing.
+   */
+  UINT32                      number_of_frames;
+
+} cahal_graph_node;
+
+/*! \var    cahal_graph
+    \brief  Struct definition for a processing graph.
+ */
+typedef struct cahal_graph_t
+{
+  /*! \var    nodes
+      \brief  Storage for the nodes. Allocated when the graph is created so
+              pointers to nodes remain valid.
+   */
+  cahal_graph_node*       nodes;
+
+  /*! \var    number_of_nodes
+      \brief  The number of nodes added to the graph.
+   */
+  UINT32                  number_of_nodes;
+
+  /*! \var    maximum_number_of_nodes
+      \brief  The capacity of nodes.
+   */
+  UINT32                  maximum_number_of_nodes;
+
+  /*! \var    order
+      \brief  The nodes in processing (topological) order.
+   */
+  cahal_graph_node**      order;
+
+  /*! \var    input
+      \brief  The node where frames enter the graph.
+   */
+  cahal_graph_node*       input;
+
+  /*! \var    output
+      \brief  The node where frames leave the graph.
+   */
+  cahal_graph_node*       output;
+
+  /*! \var    maximum_frames
+      \brief  The maximum number of frames entering the graph at a time.
+   */
+  UINT32                  maximum_frames;
+
+  /*! \var    prepared
+      \brief  True once cahal_graph_prepare has succeeded and the graph has
+              not been modified since.
+   */
+  CPC_BOOL                prepared;
+
+  /*! \var    recorder_callback
+      \brief  The callback that receives the output of a recording graph.
+   */
+  cahal_recorder_callback recorder_callback;
+
+  /*! \var    playback_callback
+      \brief  The callback that provides the input of a playback graph.
+   */
+  cahal_playback_callback playback_callback;
+
+  /*! \var    user_data
+      \brief  User data passed to recorder_callback or playback_callback.
+   */
+  void*                   user_data;
+
+  /*! \var    input_scratch
+      \brief  Buffer filled by playback_callback.
+   */
+  UCHAR*                  input_scratch;
+
+  /*! \var    output_scratch
+      \brief  Buffer passed to recorder_callback.
+   */
+  UCHAR*                  output_scratch;
+
+} cahal_graph;
+
+/*! \fn     cahal_graph* cahal_graph_create (
+              UINT32 in_maximum_number_of_nodes
+            )
+    \brief  Creates an empty graph.
+
+    \param  in_maximum_number_of_nodes  The maximum number of nodes that can
+                                        be added to the graph.
+    \return The new graph or NULL if memory could not be allocated. Free using
+            cahal_graph_free.
+ */
+cahal_graph*
+cahal_graph_create (
+                    UINT32 in_maximum_number_of_nodes
+                    );
+
+/*! \fn     void cahal_graph_free (
+              cahal_graph* in_graph
+            )
+    \brief  Frees the graph and all of its nodes.
+
+    \param  in_graph  The graph to free.
+ */
+void
+cahal_graph_free (
+                  cahal_graph* in_graph
+                  );
+
+/*! \fn     cahal_graph_node* cahal_graph_add_input  (
+              cahal_graph*            io_graph,
+              UINT32                  in_number_of_channels,
+              FLOAT64                 in_sample_rate,
+              UINT32                  in_bit_depth,
+              cahal_audio_format_flag in_format_flags
+            )
+    \brief  Adds the node where linear PCM frames enter the graph. A graph has
+            exactly one input node.
+
+    \param  io_graph  The graph to add the node to.
+    \param  in_number_of_channels The number of channels entering the graph.
+    \param  in_sample_rate  The sample rate of the frames entering the graph.
+    \param  in_bit_depth  The bit depth of the samples entering the graph.
+    \param  in_format_flags The format flags of the samples entering the
+                            graph.
+    \return The new node or NULL on error.
+ */
+cahal_graph_node*
+cahal_graph_add_input  (
+                        cahal_graph*            io_graph,
+                        UINT32                  in_number_of_channels,
+                        FLOAT64                 in_sample_rate,
+                        UINT32                  in_bit_depth,
+                        cahal_audio_format_flag in_format_flags
+                        );
+
+/*! \fn     cahal_graph_node* cahal_graph_add_output (
+              cahal_graph*            io_graph,
+              UINT32                  in_number_of_channels,
+              FLOAT64                 in_sample_rate,
+              UINT32                  in_bit_depth,
+              cahal_audio_format_flag in_format_flags
+            )
+    \brief  Adds the node where linear PCM frames leave the graph. A graph has
+            exactly one output node, with one input port.
+
+    \param  io_graph  The graph to add the node to.
+    \param  in_number_of_channels The number of channels leaving the graph.
+    \param  in_sample_rate  The sample rate of the frames leaving the graph.
+                            Must match the rate of the connected node.
+    \param  in_bit_depth  The bit depth of the samples leaving the graph.
+    \param  in_format_flags The format flags of the samples leaving the
+                            graph.
+    \return The new node or NULL on error.
+ */
+cahal_graph_node*
+cahal_graph_add_output (
+                        cahal_graph*            io_graph,
+                        UINT32                  in_number_of_channels,
+                        FLOAT64                 in_sample_rate,
+                        UINT32                  in_bit_depth,
+                        cahal_audio_format_flag in_format_flags
+                        );
+
+/*! \fn     cahal_graph_node* cahal_graph_add_gain (
+              cahal_graph*  io_graph,
+              UINT32        in_number_of_channels,
+              FLOAT32       in_gain
+            )
+    \brief  Adds a node that multiplies every channel by a gain.
+
+    \param  io_graph  The graph to add the node to.
+    \param  in_number_of_channels The number of channels processed.
+    \param  in_gain The initial (linear) gain of every channel.
+    \return The new node or NULL on error.
+ */
+cahal_graph_node*
+cahal_graph_add_gain (
+                      cahal_graph*  io_graph,
+                      UINT32        in_number_of_channels,
+                      FLOAT32       in_gain
+                      );
+
+/*! \fn     cahal_graph_node* cahal_graph_add_remix  (
+              cahal_graph*  io_graph,
+              UINT32        in_input_channels,
+              UINT32        in_output_channels
+            )
+    \brief  Adds a node that maps in_input_channels to in_output_channels
+            through a gain matrix. By default a mono output is the average of
+            all inputs and otherwise output channel i is input channel
+            i modulo in_input_channels.
+
+    \param  io_graph  The graph to add the node to.
+    \param  in_input_channels The number of channels of the input port.
+    \param  in_output_channels  The number of channels of the output port.
+    \return The new node or NULL on error.
+ */
+cahal_graph_node*
+cahal_graph_add_remix  (
+                        cahal_graph*  io_graph,
+                        UINT32        in_input_channels,
+                        UINT32        in_output_channels
+                        );
+
+/*! \fn     cahal_graph_node* cahal_graph_add_mix  (
+              cahal_graph*  io_graph,
+              UINT32        in_number_of_channels,
+              UINT32        in_number_of_inputs
+            )
+    \brief  Adds a node that sums in_number_of_inputs input ports. All inputs
+            must have the same sample rate.
+
+    \param  io_graph  The graph to add the node to.
+    \param  in_number_of_channels The number of channels of every port.
+    \param  in_number_of_inputs The number of input ports.
+    \return The new node or NULL on error.
+ */
+cahal_graph_node*
+cahal_graph_add_mix  (
+                      cahal_graph*  io_graph,
+                      UINT32        in_number_of_channels,
+                      UINT32        in_number_of_inputs
+                      );
+
+/*! \fn     cahal_graph_node* cahal_graph_add_resample (
+              cahal_graph*  io_graph,
+              UINT32        in_number_of_channels,
+              FLOAT64       in_sample_rate
+            )
+    \brief  Adds a node that converts its input to in_sample_rate by linear
+            interpolation. Graphs with a resample node produce a variable
+            number of frames per call and can only be used for recording.
+
+    \param  io_graph  The graph to add the node to.
+    \param  in_number_of_channels The number of channels processed.
+    \param  in_sample_rate  The sample rate of the output port.
+    \return The new node or NULL on error.
+ */
+cahal_graph_node*
+cahal_graph_add_resample (
+                          cahal_graph*  io_graph,
+                          UINT32        in_number_of_channels,
+                          FLOAT64       in_sample_rate
+                          );
+
+/*! \fn     cahal_graph_node* cahal_graph_add_filter (
+              cahal_graph*      io_graph,
+              UINT32            in_number_of_channels,
+              cahal_filter_type in_filter_type,
+              FLOAT64           in_frequency,
+              FLOAT64           in_quality,
+              FLOAT64           in_gain
+            )
+    \brief  Adds a filter node holding a cahal_filter_bank with a single
+            section. Further sections are appended using
+            cahal_graph_node_add_section. The coefficients are computed by
+            cahal_graph_prepare once the sample rate is known.
+
+    \param  io_graph  The graph to add the node to.
+    \param  in_number_of_channels The number of channels processed.
+    \param  in_filter_type  The response of the first section.
+    \param  in_frequency  The corner or centre frequency in Hz.
+    \param  in_quality  The quality factor, e.g. 0.7071 for a Butterworth
+                        response.
+    \param  in_gain The gain in dB of peak and shelving sections. Ignored by
+                    the other responses.
+    \return The new node or NULL on error.
+ */
+cahal_graph_node*
+cahal_graph_add_filter (
+                        cahal_graph*      io_graph,
+                        UINT32            in_number_of_channels,
+                        cahal_filter_type in_filter_type,
+                        FLOAT64           in_frequency,
+                        FLOAT64           in_quality,
+                        FLOAT64           in_gain
+                        );
+
+/*! \fn     CPC_BOOL cahal_graph_node_add_section  (
+              cahal_graph_node* io_node,
+              cahal_filter_type in_filter_type,
+              FLOAT64           in_frequency,
+              FLOAT64           in_quality,
+              FLOAT64           in_gain
+            )
+    \brief  Appends a section to the cascade of a filter node, see
+            cahal_filter_bank_add_section. The graph must be prepared again
+            before it is used.
+
+    \param  io_node The filter node.
+    \param  in_filter_type  The response of the section.
+    \param  in_frequency  The corner or centre frequency in Hz.
+    \param  in_quality  The quality factor.
+    \param  in_gain The gain in dB of peak and shelving sections.
+    \return True iff the section was added.
+ */
+CPC_BOOL
+cahal_graph_node_add_section  (
+                               cahal_graph_node* io_node,
+                               cahal_filter_type in_filter_type,
+                               FLOAT64           in_frequency,
+                               FLOAT64           in_quality,
+                               FLOAT64           in_gain
+                               );
+
+/*! \fn     cahal_graph_node* cahal_graph_add_meter  (
+              cahal_graph*  io_graph,
+              UINT32        in_number_of_channels
+            )
+    \brief  Adds a node that passes its input through unchanged and measures
+            the peak and RMS level of every channel.
+
+    \param  io_graph  The graph to add the node to.
+    \param  in_number_of_channels The number of channels processed.
+    \return The new node or NULL on error.
+ */
+cahal_graph_node*
+cahal_graph_add_meter  (
+                        cahal_graph*  io_graph,
+                        UINT32        in_number_of_channels
+                        );
+
+/*! \fn     cahal_graph_node* cahal_graph_add_user (
+              cahal_graph*              io_graph,
+              UINT32                    in_number_of_channels,
+              cahal_graph_node_callback in_callback,
+              void*                     in_user_data
+            )
+    \brief  Adds a node that processes its input in place with a
+            caller-supplied callback.
+
+    \param  io_graph  The graph to add the node to.
+    \param  in_number_of_channels The number of channels processed.
+    \param  in_callback The processing callback. It runs on the audio thread
+                        and must not block.
+    \param  in_user_data  Passed to in_callback unmodified.
+    \return The new node or NULL on error.
+ */
+cahal_graph_node*
+cahal_graph_add_user (
+                      cahal_graph*              io_graph,
+                      UINT32                    in_number_of_channels,
+                      cahal_graph_node_callback in_callback,
+                      void*                     in_user_data
+                      );
+
+/*! \fn     CPC_BOOL cahal_graph_connect (
+              cahal_graph*      io_graph,
+              cahal_graph_node* in_source,
+              cahal_graph_node* io_destination,
+              UINT32            in_port
+            )
+    \brief  Connects the output port of in_source to input port in_port of
+            io_destination. An output port may be connected to several input
+            ports. The port types must match.
+
+    \param  io_graph  The graph both nodes belong to.
+    \param  in_source The node producing the frames.
+    \param  io_destination  The node consuming the frames.
+    \param  in_port The input port of io_destination.
+    \return True iff the nodes were connected.
+ */
+CPC_BOOL
+cahal_graph_connect (
+                     cahal_graph*      io_graph,
+                     cahal_graph_node* in_source,
+                     cahal_graph_node* io_destination,
+                     UINT32            in_port
+                     );
+
+/*! \fn     CPC_BOOL cahal_graph_prepare (
+              cahal_graph*  io_graph,
+              UINT32        in_maximum_frames
+            )
+    \brief  Validates and sorts the graph, resolves the sample rate of every
+            node and allocates all buffers. Must be called after the graph is
+            built and before a stream using it is started.
+
+    \param  io_graph  The graph to prepare.
+    \param  in_maximum_frames The maximum number of frames entering the graph
+                              at a time. Larger buffers are processed in
+                              several passes.
+    \return True iff the graph is ready to process frames. Fails if a port is
+            unconnected, the graph has a cycle or sample rates do not match.
+ */
+CPC_BOOL
+cahal_graph_prepare (
+                     cahal_graph*  io_graph,
+                     UINT32        in_maximum_frames
+                     );
+
+/*! \fn     UINT32 cahal_graph_process (
+              cahal_graph*   io_graph,
+              const FLOAT32* in_frames,
+              UINT32         in_number_of_frames,
+              FLOAT32*       out_frames
+            )
+    \brief  Runs floating point frames through a prepared graph. The format
+            conversions of the input and output node are bypassed.
+
+    \param  io_graph  The graph to run.
+    \param  in_frames The interleaved frames entering the graph.
+    \param  in_number_of_frames The number of frames in in_frames. At most the
+                                maximum passed to cahal_graph_prepare.
+    \param  out_frames  The interleaved frames leaving the graph. Must hold
+                        the capacity of the output node.
+    \return The number of frames written to out_frames.
+ */
+UINT32
+cahal_graph_process (
+                     cahal_graph*   io_graph,
+                     const FLOAT32* in_frames,
+                     UINT32         in_number_of_frames,
+                     FLOAT32*       out_frames
+                     );
+
+/*! \fn     void cahal_graph_set_recorder_callback (
+              cahal_graph*            io_graph,
+              cahal_recorder_callback in_callback,
+              void*                   in_user_data
+            )
+    \brief  Sets the callback that receives the frames leaving a recording
+            graph.
+
+    \param  io_graph  The graph to configure.
+    \param  in_callback The callback, called with samples in the format of
+                        the output node.
+    \param  in_user_data  Passed to in_callback unmodified.
+ */
+void
+cahal_graph_set_recorder_callback (
+                                   cahal_graph*            io_graph,
+                                   cahal_recorder_callback in_callback,
+                                   void*                   in_user_data
+                                   );
+
+/*! \fn     void cahal_graph_set_playback_callback (
+              cahal_graph*            io_graph,
+              cahal_playback_callback in_callback,
+              void*                   in_user_data
+            )
+    \brief  Sets the callback that provides the frames entering a playback
+            graph.
+
+    \param  io_graph  The graph to configure.
+    \param  in_callback The callback, which must produce samples in the
+                        format of the input node.
+    \param  in_user_data  Passed to in_callback unmodified.
+ */
+void
+cahal_graph_set_playback_callback (
+                                   cahal_graph*            io_graph,
+                                   cahal_playback_callback in_callback,
+                                   void*                   in_user_data
+                                   );
+
+/*! \fn     CPC_BOOL cahal_graph_recorder_callback (
+              cahal_device* in_recording_device,
+              UCHAR*        in_data_buffer,
+              UINT32        in_data_buffer_length,
+              void*         in_client_data
+            )
+    \brief  cahal_recorder_callback that runs the recorded buffer through the
+            graph passed in in_client_data and passes the result to the
+            recorder callback of the graph.
+
+    \param  in_recording_device The device the samples were recorded from.
+    \param  in_data_buffer  The recorded samples.
+    \param  in_data_buffer_length The size of in_data_buffer in bytes.
+    \param  in_client_data  The prepared cahal_graph.
+    \return True iff the buffer was processed and delivered.
+ */
+CPC_BOOL
+cahal_graph_recorder_callback (
+                               cahal_device* in_recording_device,
+                               UCHAR*        in_data_buffer,
+                               UINT32        in_data_buffer_length,
+                               void*         in_client_data
+                               );
+
+/*! \fn     CPC_BOOL cahal_graph_playback_callback (
+              cahal_device* in_playback_device,
+              UCHAR*        out_data_buffer,
+              UINT32*       io_data_buffer_length,
+              void*         in_client_data
+            )
+    \brief  cahal_playback_callback that fills out_data_buffer with frames
+            requested from the playback callback of the graph passed in
+            in_client_data and run through the graph. The graph must not
+            change the sample rate.
+
+    \param  in_playback_device  The device the samples will be played on.
+    \param  out_data_buffer The buffer to fill.
+    \param  io_data_buffer_length The capacity of out_data_buffer on input, the
+                                  number of bytes written on output.
+    \param  in_client_data  The prepared cahal_graph.
+    \return True iff the buffer was filled.
+ */
+CPC_BOOL
+cahal_graph_playback_callback (
+                               cahal_device* in_playback_device,
+                               UCHAR*        out_data_buffer,
+                               UINT32*       io_data_buffer_length,
+                               void*         in_client_data
+                               );
+
+/*! \fn     void cahal_graph_node_set_gain (
+              cahal_graph_node* io_node,
+              UINT32            in_channel,
+              FLOAT32           in_gain
+            )
+    \brief  Changes the gain of one channel of a gain node. May be called
+            while the graph is running.
+
+    \param  io_node The gain node.
+    \param  in_channel  The channel to change.
+    \param  in_gain The new linear gain.
+ */
+void
+cahal_graph_node_set_gain (
+                           cahal_graph_node* io_node,
+                           UINT32            in_channel,
+                           FLOAT32           in_gain
+                           );
+
+/*! \fn     void cahal_graph_node_set_remix_gain (
+              cahal_graph_node* io_node,
+              UINT32            in_output_channel,
+              UINT32            in_input_channel,
+              FLOAT32           in_gain
+            )
+    \brief  Changes the contribution of an input channel to an output channel
+            of a remix node. May be called while the graph is running.
+
+    \param  io_node The remix node.
+    \param  in_output_channel The output channel.
+    \param  in_input_channel  The input channel.
+    \param  in_gain The new linear gain.
+ */
+void
+cahal_graph_node_set_remix_gain (
+                                 cahal_graph_node* io_node,
+                                 UINT32            in_output_channel,
+                                 UINT32            in_input_channel,
+                                 FLOAT32           in_gain
+                                 );
+
+/*! \fn     FLOAT32 cahal_graph_node_get_peak  (
+              cahal_graph_node* in_node,
+              UINT32            in_channel
+            )
+    \brief  Returns the peak level of a channel of a meter node over the most
+            recently processed frames.
+
+    \param  in_node The meter node.
+    \param  in_channel  The channel to query.
+    \return The peak absolute sample value.
+ */
+FLOAT32
+cahal_graph_node_get_peak  (
+                            cahal_graph_node* in_node,
+                            UINT32            in_channel
+                            );
+
+/*! \fn     FLOAT32 cahal_graph_node_get_rms (
+              cahal_graph_node* in_node,
+              UINT32            in_channel
+            )
+    \brief  Returns the RMS level of a channel of a meter node over the most
+            recently processed frames.
+
+    \param  in_node The meter node.
+    \param  in_channel  The channel to query.
+    \return The RMS level.
+ */
+FLOAT32
+cahal_graph_node_get_rms (
+                          cahal_graph_node* in_node,
+                          UINT32            in_channel
+                          );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_GRAPH_H__ */
@@ -0,0 +1,240 @@
+/*! \file   cahal_playback_schedule.h
+    \brief  Sample-accurate scheduled playback starts, for synchronized
+            playback across devices. The OS streams start as soon as they can
+            and their start latency varies by tens of milliseconds, so
+            instead of delaying the OS stream the playback is started
+            immediately and the samples handed to the OS are silence until
+            the scheduled frame. The first sample of the playback callback is
+            spliced in at exactly that frame, within whichever buffer
+            contains it.
+
+            A start time is either a sample time, the number of frames handed
+            to the OS since the playback was started (or prepared), or a host
+            time as returned by cahal_get_time. A host time is converted to a
+            sample time on every buffer until the playback has started, using
+            the number of bytes the OS has queued ahead of the buffer, so it
+            is only as accurate as the latency the platform reports. A start
+            time that has already passed starts the playback at the next
+            buffer, and is logged.
+
+            Once a start time is set using cahal_set_playback_start_time
+            every playback started (or prepared) afterwards is scheduled.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_PLAYBACK_SCHEDULE_H__
+#define __CAHAL_PLAYBACK_SCHEDULE_H__
+
+#include <cpcommon.h>
+
+#include "cahal_device.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \enum   cahal_start_time_bases
+    \brief  What the time of a cahal_start_time counts.
+ */
+enum cahal_start_time_bases
+{
+  CAHAL_START_TIME_BASE_SAMPLE  = 0,
+  CAHAL_START_TIME_BASE_HOST
+};
+
+/*! \var    cahal_start_time_base
+    \brief  One of cahal_start_time_bases.
+ */
+typedef UINT32 cahal_start_time_base;
+
+/*! \var    cahal_start_time
+    \brief  Struct definition for the time at which a playback starts.
+ */
+typedef struct cahal_start_time_t
+{
+  /*! \var    base
+      \brief  CAHAL_START_TIME_BASE_SAMPLE or CAHAL_START_TIME_BASE_HOST.
+   */
+  cahal_start_time_base base;
+
+  /*! \var    time
+      \brief  The sample time (in frames) or the host time (in ns, see
+              cahal_get_time) of the first sample of the playback callback.
+   */
+  UINT64                time;
+
+} cahal_start_time;
+
+/*! \var    cahal_playback_schedule
+    \brief  Struct definition for the scheduled start of one playback. Only
+            used by the thread the OS calls back on.
+ */
+typedef struct cahal_playback_schedule_t
+{
+  /*! \var    start_time
+      \brief  When the playback starts.
+   */
+  cahal_start_time  start_time;
+
+  /*! \var    frame_size
+      \brief  The number of bytes in a frame.
+   */
+  UINT32            frame_size;
+
+  /*! \var    sample_rate
+      \brief  The sample rate of the playback.
+   */
+  FLOAT64           sample_rate;
+
+  /*! \var    sample_time
+      \brief  The number of frames handed to the OS so far, i.e. the sample
+              time of the first frame of the next buffer.
+   */
+  UINT64            sample_time;
+
+  /*! \var    has_started
+      \brief  Set once the playback callback has been called.
+   */
+  CPC_BOOL          has_started;
+
+  /*! \var    start_sample_time
+      \brief  The sample time of the first sample of the playback callback,
+              once it has started.
+   */
+  UINT64            start_sample_time;
+
+} cahal_playback_schedule;
+
+/*! \fn     void cahal_set_playback_start_time (
+              const cahal_start_time* in_start_time
+            )
+    \brief  Sets the start time of the playbacks started (or prepared)
+            afterwards. A playback that is running keeps its own.
+
+    \param  in_start_time The start time to copy, or NULL to start new
+                          playbacks immediately again.
+ */
+void
+cahal_set_playback_start_time (
+                               const cahal_start_time* in_start_time
+                               );
+
+/*! \fn     CPC_BOOL cahal_get_playback_start_time (
+              cahal_start_time* out_start_time
+            )
+    \brief  Returns the start time set using cahal_set_playback_start_time.
+
+    \param  out_start_time  The start time. Left untouched if new playbacks
+                            are not scheduled.
+    \return True iff new playbacks are scheduled.
+ */
+CPC_BOOL
+cahal_get_playback_start_time (
+                               cahal_start_time* out_start_time
+                               );
+
+/*! \fn     cahal_playback_schedule* cahal_playback_schedule_create  (
+              const cahal_start_time*   in_start_time,
+              cahal_playback_info*      in_playback_info
+            )
+    \brief  Creates the schedule of a playback.
+
+    \param  in_start_time When the playback starts.
+    \param  in_playback_info  The playback, whose format sets the size of a
+                              frame and the sample rate.
+    \return The schedule or NULL on error. Free using
+            cahal_playback_schedule_free.
+ */
+cahal_playback_schedule*
+cahal_playback_schedule_create  (
+                                 const cahal_start_time*   in_start_time,
+                                 cahal_playback_info*      in_playback_info
+                                 );
+
+/*! \fn     void cahal_playback_schedule_free  (
+              cahal_playback_schedule* in_schedule
+            )
+    \brief  Frees the schedule of a playback.
+
+    \param  in_schedule The schedule to free.
+ */
+void
+cahal_playback_schedule_free  (
+                               cahal_playback_schedule* in_schedule
+                               );
+
+/*! \fn     UINT32 cahal_playback_schedule_get_silence (
+              cahal_playback_schedule* io_schedule,
+              UINT32                   in_data_buffer_length,
+              UINT32                   in_queued_bytes
+            )
+    \brief  Returns the number of bytes of silence at the head of the next
+            buffer handed to the OS, before the first sample of the playback
+            callback. Marks the playback as started if it starts within the
+            buffer.
+
+    \param  io_schedule The schedule of the playback.
+    \param  in_data_buffer_length The capacity of the buffer in bytes.
+    \param  in_queued_bytes The number of bytes queued in the OS that will be
+                            played before the first sample of the buffer.
+    \return A whole number of frames: in_data_buffer_length rounded down if
+            the playback does not start within the buffer, 0 once it has
+            started.
+ */
+UINT32
+cahal_playback_schedule_get_silence (
+                              cahal_playback_schedule* io_schedule,
+                              UINT32                   in_data_buffer_length,
+                              UINT32                   in_queued_bytes
+                                     );
+
+/*! \fn     void cahal_playback_schedule_advance (
+              cahal_playback_schedule* io_schedule,
+              UINT32                   in_data_buffer_length
+            )
+    \brief  Advances the sample time by the number of frames handed to the
+            OS.
+
+    \param  io_schedule The schedule of the playback.
+    \param  in_data_buffer_length The number of bytes handed to the OS.
+ */
+void
+cahal_playback_schedule_advance (
+                                 cahal_playback_schedule* io_schedule,
+                                 UINT32                   in_data_buffer_length
+                                 );
+
+/*! \fn     CPC_BOOL cahal_attach_playback_schedule (
+              cahal_playback_info* io_playback_info
+            )
+    \brief  Creates the schedule of a playback if a start time is set. Called
+            by the platforms once io_playback_info is filled in and before
+            the first buffer is requested.
+
+    \param  io_playback_info  The playback. Its schedule is set.
+    \return True iff the playback may start.
+ */
+CPC_BOOL
+cahal_attach_playback_schedule (
+                                cahal_playback_info* io_playback_info
+                                );
+
+/*! \fn     void cahal_detach_playback_schedule (
+              cahal_playback_info* io_playback_info
+            )
+    \brief  Frees the schedule of a playback, if any. Called by the platforms
+            once the OS has stopped requesting buffers.
+
+    \param  io_playback_info  The playback.
+ */
+void
+cahal_detach_playback_schedule (
+                                cahal_playback_info* io_playback_info
+                                );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_PLAYBACK_SCHEDULE_H__ */
@@ -0,0 +1,386 @@
+/*! \file   cahal_pollable.h
+    \brief  Streams exposed as pollable file descriptors, for single-threaded
+            event loops (epoll, poll, select or io_uring) that cannot run a
+            thread per stream to receive callbacks. The stream is started with
+            an internal callback that moves samples between the OS thread and
+            a single-producer/single-consumer cahal_ring_buffer; the event
+            loop moves them in and out of the ring with the non-blocking
+            cahal_pollable_read and cahal_pollable_write.
+
+            A playback is created and started in two steps, so that the event
+            loop can fill the ring before the OS asks for the first buffers:
+            cahal_create_playback_pollable returns a stream that is already
+            writable, and cahal_start_playback_pollable starts playing it
+            back. Started straight away, the first buffers would always be
+            silence, counted as underruns.
+
+            The descriptor is an eventfd on Linux and Android and the read end
+            of a non-blocking pipe elsewhere. Either way it only ever becomes
+            readable, so it is polled for input in both directions:
+
+            - Recording: readable once at least threshold bytes can be read.
+            - Playback: readable once at least threshold bytes can be written.
+
+            The OS thread signals the descriptor at most once per crossing of
+            the threshold, and cahal_pollable_read / cahal_pollable_write
+            clear it again once the stream is no longer ready, so the
+            descriptor behaves like a level-triggered one. Recorded buffers
+            that do not fit in the ring are dropped and playback buffers that
+            the ring cannot fill are padded with silence; both are counted.
+
+            Pollable streams are not available on Windows, which has no
+            pollable descriptors to signal.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_POLLABLE_H__
+#define __CAHAL_POLLABLE_H__
+
+#include <cpcommon.h>
+
+#include "cahal_atomic.h"
+#include "cahal_device.h"
+#include "cahal_ring_buffer.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_POLLABLE_BUFFER_DURATION
+    \brief  The amount of audio (in seconds) the ring of a pollable stream
+            holds, unless twice the threshold is more.
+ */
+#define CAHAL_POLLABLE_BUFFER_DURATION  0.5
+
+/*! \def    CAHAL_POLLABLE_INVALID_DESCRIPTOR
+    \brief  The value of a descriptor that is not open.
+ */
+#define CAHAL_POLLABLE_INVALID_DESCRIPTOR -1
+
+/*! \var    cahal_pollable_stream
+    \brief  Struct definition for a stream exposed as a file descriptor.
+ */
+typedef struct cahal_pollable_stream_t
+{
+  /*! \var    direction
+      \brief  CAHAL_DEVICE_INPUT_STREAM to record, CAHAL_DEVICE_OUTPUT_STREAM
+              to play back.
+   */
+  cahal_device_stream_direction direction;
+
+  /*! \var    ring_buffer
+      \brief  The samples in flight between the OS thread and the event loop.
+   */
+  cahal_ring_buffer*            ring_buffer;
+
+  /*! \var    frame_size
+      \brief  The number of bytes in a frame. Reads and writes are whole
+              frames.
+   */
+  UINT32                        frame_size;
+
+  /*! \var    threshold
+      \brief  The number of bytes that must be readable (recording) or
+              writable (playback) for the descriptor to be readable.
+   */
+  UINT32                        threshold;
+
+  /*! \var    read_descriptor
+      \brief  The descriptor polled by the event loop.
+   */
+  INT32                         read_descriptor;
+
+  /*! \var    write_descriptor
+      \brief  The descriptor written to signal read_descriptor. The same
+              descriptor for an eventfd, the write end of the pipe otherwise.
+   */
+  INT32                         write_descriptor;
+
+  /*! \var    is_signalled
+      \brief  1 iff read_descriptor is readable. Only the thread that swaps it
+              from 0 to 1 signals the descriptor.
+   */
+  cahal_atomic_uint32           is_signalled;
+
+  /*! \var    number_of_overruns
+      \brief  The number of recorded buffers dropped because the ring was
+              full.
+   */
+  cahal_atomic_uint32           number_of_overruns;
+
+  /*! \var    number_of_underruns
+      \brief  The number of playback buffers padded with silence because the
+              ring was short.
+   */
+  cahal_atomic_uint32           number_of_underruns;
+
+} cahal_pollable_stream;
+
+/*! \fn     cahal_pollable_stream* cahal_pollable_stream_create (
+              cahal_device_stream_direction in_direction,
+              UINT32                        in_frame_size,
+              UINT32                        in_threshold,
+              UINT32                        in_capacity
+            )
+    \brief  Creates a pollable stream that is not attached to the OS. Used by
+            cahal_start_recording_pollable and cahal_create_playback_pollable;
+            a stream created directly is fed by calling
+            cahal_pollable_recorder_callback or
+            cahal_pollable_playback_callback.
+
+    \param  in_direction  CAHAL_DEVICE_INPUT_STREAM to record,
+                          CAHAL_DEVICE_OUTPUT_STREAM to play back.
+    \param  in_frame_size The number of bytes in a frame.
+    \param  in_threshold  The number of frames that make the stream ready.
+    \param  in_capacity The minimum number of bytes the ring holds.
+    \return The stream or NULL on error. Free using cahal_pollable_stream_free.
+ */
+cahal_pollable_stream*
+cahal_pollable_stream_create (
+                              cahal_device_stream_direction in_direction,
+                              UINT32                        in_frame_size,
+                              UINT32                        in_threshold,
+                              UINT32                        in_capacity
+                              );
+
+/*! \fn     void cahal_pollable_stream_free (
+              cahal_pollable_stream* in_stream
+            )
+    \brief  Closes the descriptors of a stream and frees it. The OS must have
+            stopped calling back.
+
+    \param  in_stream The stream to free.
+ */
+void
+cahal_pollable_stream_free (
+                            cahal_pollable_stream* in_stream
+                            );
+
+/*! \fn     cahal_pollable_stream* cahal_start_recording_pollable  (
+              cahal_device*            in_device,
+              cahal_audio_format_id    in_format_id,
+              UINT32                   in_number_of_channels,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              cahal_audio_format_flag  in_format_flags,
+              UINT32                   in_threshold
+            )
+    \brief  Starts recording into a pollable stream instead of a callback.
+
+    \param  in_device The device to record from.
+    \param  in_format_id  The audio format to record in.
+    \param  in_number_of_channels The number of channels to record.
+    \param  in_sample_rate  The sample rate to record at.
+    \param  in_bit_depth  The number of bits per sample.
+    \param  in_format_flags The flags to be used in the recording.
+    \param  in_threshold  The number of frames that must be readable for the
+                          descriptor to be readable.
+    \return The stream, or NULL if the recording could not be started. Stop
+            using cahal_stop_pollable.
+ */
+cahal_pollable_stream*
+cahal_start_recording_pollable  (
+                                 cahal_device*            in_device,
+                                 cahal_audio_format_id    in_format_id,
+                                 UINT32                   in_number_of_channels,
+                                 FLOAT64                  in_sample_rate,
+                                 UINT32                   in_bit_depth,
+                                 cahal_audio_format_flag  in_format_flags,
+                                 UINT32                   in_threshold
+                                 );
+
+/*! \fn     cahal_pollable_stream* cahal_create_playback_pollable  (
+              UINT32                   in_number_of_channels,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              UINT32                   in_threshold
+            )
+    \brief  Creates a stream to play back from, without starting the
+            playback. Its descriptor is readable at once, so the event loop
+            writes the first samples before cahal_start_playback_pollable is
+            called.
+
+    \param  in_number_of_channels The number of channels to play back.
+    \param  in_sample_rate  The sample rate to play back at.
+    \param  in_bit_depth  The number of bits per sample.
+    \param  in_threshold  The number of frames that must be writable for the
+                          descriptor to be readable.
+    \return The stream, or NULL on error. Free using
+            cahal_pollable_stream_free unless it has been started.
+ */
+cahal_pollable_stream*
+cahal_create_playback_pollable  (
+                                 UINT32                   in_number_of_channels,
+                                 FLOAT64                  in_sample_rate,
+                                 UINT32                   in_bit_depth,
+                                 UINT32                   in_threshold
+                                 );
+
+/*! \fn     CPC_BOOL cahal_start_playback_pollable (
+              cahal_pollable_stream*   io_stream,
+              cahal_device*            in_device,
+              cahal_audio_format_id    in_format_id,
+              UINT32                   in_number_of_channels,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              FLOAT32                  in_volume,
+              cahal_audio_format_flag  in_format_flags
+            )
+    \brief  Starts playing back from a stream created with
+            cahal_create_playback_pollable instead of a callback. The first
+            buffers are filled from what has been written to the stream; once
+            the ring runs short the playback is padded with silence.
+
+    \param  io_stream The stream to play back from.
+    \param  in_device The device to play back to.
+    \param  in_format_id  The audio format samples are encoded in.
+    \param  in_number_of_channels The number of channels to play back. Must
+                                  match the stream.
+    \param  in_sample_rate  The sample rate to play back at.
+    \param  in_bit_depth  The number of bits per sample. Must match the
+                          stream.
+    \param  in_volume Volume gain (value between 0 and 1).
+    \param  in_format_flags The flags to be used in the playback.
+    \return True iff the playback was started, in which case stop using
+            cahal_stop_pollable. Otherwise the stream is left as it was.
+ */
+CPC_BOOL
+cahal_start_playback_pollable (
+                               cahal_pollable_stream*   io_stream,
+                               cahal_device*            in_device,
+                               cahal_audio_format_id    in_format_id,
+                               UINT32                   in_number_of_channels,
+                               FLOAT64                  in_sample_rate,
+                               UINT32                   in_bit_depth,
+                               FLOAT32                  in_volume,
+                               cahal_audio_format_flag  in_format_flags
+                               );
+
+/*! \fn     CPC_BOOL cahal_stop_pollable  (
+              cahal_pollable_stream* in_stream
+            )
+    \brief  Stops the recording or playback of a stream started with
+            cahal_start_recording_pollable or cahal_start_playback_pollable
+            and frees the stream.
+
+    \param  in_stream The stream, which must not be used afterwards.
+    \return True iff the recording or playback was stopped.
+ */
+CPC_BOOL
+cahal_stop_pollable  (
+                      cahal_pollable_stream* in_stream
+                      );
+
+/*! \fn     INT32 cahal_pollable_get_descriptor  (
+              cahal_pollable_stream* in_stream
+            )
+    \brief  Returns the descriptor to register with the event loop, for input.
+            It stays owned by the stream.
+
+    \param  in_stream The stream.
+    \return The descriptor.
+ */
+INT32
+cahal_pollable_get_descriptor  (
+                                cahal_pollable_stream* in_stream
+                                );
+
+/*! \fn     UINT32 cahal_pollable_read (
+              cahal_pollable_stream* io_stream,
+              UCHAR*                 out_data_buffer,
+              UINT32                 in_data_buffer_length
+            )
+    \brief  Reads recorded samples without blocking. Must only be called by
+            one thread, the event loop.
+
+    \param  io_stream The recording stream.
+    \param  out_data_buffer The buffer to copy the samples to.
+    \param  in_data_buffer_length The capacity of out_data_buffer in bytes.
+    \return The number of bytes read, a whole number of frames, or 0 if none
+            are available.
+ */
+UINT32
+cahal_pollable_read (
+                     cahal_pollable_stream* io_stream,
+                     UCHAR*                 out_data_buffer,
+                     UINT32                 in_data_buffer_length
+                     );
+
+/*! \fn     UINT32 cahal_pollable_write  (
+              cahal_pollable_stream* io_stream,
+              const UCHAR*           in_data_buffer,
+              UINT32                 in_data_buffer_length
+            )
+    \brief  Writes samples to play back without blocking. Must only be called
+            by one thread, the event loop.
+
+    \param  io_stream The playback stream.
+    \param  in_data_buffer  The samples.
+    \param  in_data_buffer_length The size of in_data_buffer in bytes.
+    \return The number of bytes written, a whole number of frames, or 0 if
+            the ring is full.
+ */
+UINT32
+cahal_pollable_write  (
+                       cahal_pollable_stream* io_stream,
+                       const UCHAR*           in_data_buffer,
+                       UINT32                 in_data_buffer_length
+                       );
+
+/*! \fn     CPC_BOOL cahal_pollable_recorder_callback (
+              cahal_device* in_recording_device,
+              UCHAR*        in_data_buffer,
+              UINT32        in_data_buffer_length,
+              void*         in_user_data
+            )
+    \brief  The recording callback of a pollable stream. Copies the buffer to
+            the ring, or drops it if it does not fit, and signals the
+            descriptor once the threshold is reached.
+
+    \param  in_recording_device Ignored.
+    \param  in_data_buffer  The recorded samples.
+    \param  in_data_buffer_length The size of in_data_buffer in bytes.
+    \param  in_user_data  The cahal_pollable_stream.
+    \return True.
+ */
+CPC_BOOL
+cahal_pollable_recorder_callback (
+                                  cahal_device* in_recording_device,
+                                  UCHAR*        in_data_buffer,
+                                  UINT32        in_data_buffer_length,
+                                  void*         in_user_data
+                                  );
+
+/*! \fn     CPC_BOOL cahal_pollable_playback_callback (
+              cahal_device* in_playback_device,
+              UCHAR*        out_data_buffer,
+              UINT32*       io_data_buffer_length,
+              void*         in_user_data
+            )
+    \brief  The playback callback of a pollable stream. Fills the buffer from
+            the ring, padding it with silence, and signals the descriptor once
+            the threshold can be written.
+
+    \param  in_playback_device  Ignored.
+    \param  out_data_buffer The buffer to fill.
+    \param  io_data_buffer_length The capacity of out_data_buffer on input, the
+                                  number of bytes written on output. The
+                                  buffer is always filled, with silence if
+                                  need be.
+    \param  in_user_data  The cahal_pollable_stream.
+    \return True.
+ */
+CPC_BOOL
+cahal_pollable_playback_callback (
+                                  cahal_device* in_playback_device,
+                                  UCHAR*        out_data_buffer,
+                                  UINT32*       io_data_buffer_length,
+                                  void*         in_user_data
+                                  );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_POLLABLE_H__ */
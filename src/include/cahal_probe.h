@@ -0,0 +1,299 @@
+/*! \file   cahal_probe.h
+    \brief  Platform agnostic probing of the formats supported by a device.
+            Platforms that can only discover supported formats by trying them
+            (e.g. OpenSL ES on Android) describe the candidate channel counts,
+            sample rates and bit depths with a cahal_prober and supply a
+            callback that tests a single configuration. The prober tries every
+            combination and builds the list of supported formats, consulting a
+            cahal_probe_cache first when one is given.
+
+            The callback is the only platform-specific part, so the probing
+            and caching logic can be exercised with a fake callback on any
+            platform.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_PROBE_H__
+#define __CAHAL_PROBE_H__
+
+#include <cpcommon.h>
+
+#include "cahal_atomic.h"
+#include "cahal_audio_format_description.h"
+#include "cahal_probe_cache.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_PROBER_MAXIMUM_VALUES
+    \brief  The maximum number of candidate values per parameter.
+ */
+#define CAHAL_PROBER_MAXIMUM_VALUES 16
+
+/*! \def    cahal_probe_callback
+    \brief  The function prototype of the callback that tests whether a
+            configuration is supported.
+
+    \param  in_configuration  Platform specific configuration (e.g. the
+                              recording preset) passed to cahal_prober_probe.
+    \param  in_number_of_channels The number of channels to test.
+    \param  in_sample_rate  The sample rate to test.
+    \param  in_bit_depth  The bit depth to test.
+    \param  in_user_data  The user data of the prober.
+    \return True iff the configuration is supported.
+ */
+typedef CPC_BOOL ( *cahal_probe_callback )  (
+                                             UINT32  in_configuration,
+                                             UINT32  in_number_of_channels,
+                                             FLOAT64 in_sample_rate,
+                                             UINT32  in_bit_depth,
+                                             void*   in_user_data
+                                             );
+
+/*! \var    cahal_prober
+    \brief  Struct definition for a prober.
+ */
+typedef struct cahal_prober_t
+{
+  /*! \var    test_configuration
+      \brief  The callback that tests a configuration.
+   */
+  cahal_probe_callback  test_configuration;
+
+  /*! \var    user_data
+      \brief  User data passed to test_configuration.
+   */
+  void*                 user_data;
+
+  /*! \var    format_id
+      \brief  The format of the descriptions produced.
+   */
+  cahal_audio_format_id format_id;
+
+  /*! \var    channels
+      \brief  The candidate channel counts.
+   */
+  UINT32                channels[ CAHAL_PROBER_MAXIMUM_VALUES ];
+
+  /*! \var    number_of_channel_counts
+      \brief  The number of elements in channels.
+   */
+  UINT32                number_of_channel_counts;
+
+  /*! \var    sample_rates
+      \brief  The candidate sample rates.
+   */
+  FLOAT64               sample_rates[ CAHAL_PROBER_MAXIMUM_VALUES ];
+
+  /*! \var    number_of_sample_rates
+      \brief  The number of elements in sample_rates.
+   */
+  UINT32                number_of_sample_rates;
+
+  /*! \var    bit_depths
+      \brief  The candidate bit depths.
+   */
+  UINT32                bit_depths[ CAHAL_PROBER_MAXIMUM_VALUES ];
+
+  /*! \var    number_of_bit_depths
+      \brief  The number of elements in bit_depths.
+   */
+  UINT32                number_of_bit_depths;
+
+  /*! \var    number_of_probes
+      \brief  The number of times test_configuration has been called. Updated
+              atomically since configurations may be tested concurrently (see
+              cahal_probe_scheduler).
+   */
+  cahal_atomic_uint32   number_of_probes;
+
+} cahal_prober;
+
+/*! \fn     cahal_prober* cahal_prober_create (
+              cahal_probe_callback  in_callback,
+              void*                 in_user_data,
+              cahal_audio_format_id in_format_id
+            )
+    \brief  Creates a prober without candidate values.
+
+    \param  in_callback The callback that tests a configuration.
+    \param  in_user_data  User data passed to in_callback.
+    \param  in_format_id  The format of the descriptions produced.
+    \return The new prober or NULL on error. Free using cahal_prober_free.
+ */
+cahal_prober*
+cahal_prober_create (
+                     cahal_probe_callback  in_callback,
+                     void*                 in_user_data,
+                     cahal_audio_format_id in_format_id
+                     );
+
+/*! \fn     void cahal_prober_free  (
+              cahal_prober* in_prober
+            )
+    \brief  Frees the prober. The user data is not freed.
+
+    \param  in_prober The prober to free.
+ */
+void
+cahal_prober_free  (
+                    cahal_prober* in_prober
+                    );
+
+/*! \fn     CPC_BOOL cahal_prober_add_channels (
+              cahal_prober* io_prober,
+              UINT32        in_number_of_channels
+            )
+    \brief  Adds a candidate channel count.
+
+    \param  io_prober The prober to update.
+    \param  in_number_of_channels The channel count.
+    \return True iff the value was added.
+ */
+CPC_BOOL
+cahal_prober_add_channels (
+                           cahal_prober* io_prober,
+                           UINT32        in_number_of_channels
+                           );
+
+/*! \fn     CPC_BOOL cahal_prober_add_sample_rate  (
+              cahal_prober* io_prober,
+              FLOAT64       in_sample_rate
+            )
+    \brief  Adds a candidate sample rate.
+
+    \param  io_prober The prober to update.
+    \param  in_sample_rate  The sample rate.
+    \return True iff the value was added.
+ */
+CPC_BOOL
+cahal_prober_add_sample_rate  (
+                               cahal_prober* io_prober,
+                               FLOAT64       in_sample_rate
+                               );
+
+/*! \fn     CPC_BOOL cahal_prober_add_bit_depth  (
+              cahal_prober* io_prober,
+              UINT32        in_bit_depth
+            )
+    \brief  Adds a candidate bit depth.
+
+    \param  io_prober The prober to update.
+    \param  in_bit_depth  The bit depth.
+    \return True iff the value was added.
+ */
+CPC_BOOL
+cahal_prober_add_bit_depth  (
+                             cahal_prober* io_prober,
+                             UINT32        in_bit_depth
+                             );
+
+/*! \fn     UINT32 cahal_prober_get_number_of_configurations (
+              cahal_prober* in_prober
+            )
+    \brief  Returns the number of combinations of the candidate values. The
+            combinations are numbered from 0, channel count major and bit depth
+            minor.
+
+    \param  in_prober The prober.
+    \return The number of configurations.
+ */
+UINT32
+cahal_prober_get_number_of_configurations (
+                                           cahal_prober* in_prober
+                                           );
+
+/*! \fn     CPC_BOOL cahal_prober_test (
+              cahal_prober* io_prober,
+              UINT32        in_configuration,
+              UINT32        in_index
+            )
+    \brief  Tests a single combination of the candidate values. Safe to call
+            concurrently for the same prober iff the callback is.
+
+    \param  io_prober The prober to use.
+    \param  in_configuration  Platform specific configuration passed to the
+                              callback.
+    \param  in_index  The combination to test, less than
+                      cahal_prober_get_number_of_configurations.
+    \return True iff the combination is supported.
+ */
+CPC_BOOL
+cahal_prober_test (
+                   cahal_prober* io_prober,
+                   UINT32        in_configuration,
+                   UINT32        in_index
+                   );
+
+/*! \fn     cahal_audio_format_description* cahal_prober_create_format (
+              cahal_prober* in_prober,
+              UINT32        in_index
+            )
+    \brief  Creates the format description of a single combination of the
+            candidate values.
+
+    \param  in_prober The prober.
+    \param  in_index  The combination, less than
+                      cahal_prober_get_number_of_configurations.
+    \return The new description or NULL on error.
+ */
+cahal_audio_format_description*
+cahal_prober_create_format (
+                            cahal_prober* in_prober,
+                            UINT32        in_index
+                            );
+
+/*! \fn     cahal_audio_format_description** cahal_prober_probe  (
+              cahal_prober* io_prober,
+              UINT32        in_configuration
+            )
+    \brief  Tests every combination of the candidate values.
+
+    \param  io_prober The prober to use.
+    \param  in_configuration  Platform specific configuration passed to the
+                              callback.
+    \return A newly allocated null-terminated list (that may be empty) of the
+            supported formats or NULL on error. Free using
+            cahal_free_audio_format_description_list.
+ */
+cahal_audio_format_description**
+cahal_prober_probe  (
+                     cahal_prober* io_prober,
+                     UINT32        in_configuration
+                     );
+
+/*! \fn     cahal_audio_format_description** cahal_prober_probe_cached (
+              cahal_prober*       io_prober,
+              UINT32              in_configuration,
+              cahal_probe_cache*  io_cache,
+              const CHAR*         in_device_key,
+              UINT64              in_fingerprint
+            )
+    \brief  Returns the formats cached for in_device_key if the fingerprint
+            matches, otherwise probes the device and stores the result in
+            io_cache.
+
+    \param  io_prober The prober to use on a cache miss.
+    \param  in_configuration  Platform specific configuration passed to the
+                              callback.
+    \param  io_cache  The cache to consult. If NULL the device is probed.
+    \param  in_device_key The key of the device in the cache.
+    \param  in_fingerprint  The fingerprint of the device.
+    \return Same as cahal_prober_probe.
+ */
+cahal_audio_format_description**
+cahal_prober_probe_cached (
+                           cahal_prober*       io_prober,
+                           UINT32              in_configuration,
+                           cahal_probe_cache*  io_cache,
+                           const CHAR*         in_device_key,
+                           UINT64              in_fingerprint
+                           );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_PROBE_H__ */
@@ -0,0 +1,261 @@
+/*! \file   cahal_probe_cache.h
+    \brief  Persistent cache of the formats supported by each device. Probing
+            a device (opening and closing it in every candidate configuration)
+            is slow, so the formats found are saved to disk and reused on the
+            next start as long as the device fingerprint is unchanged.
+
+            Entries are looked up by a device key (e.g. the device name or
+            UID). Each entry stores the fingerprint of the device, computed
+            from its name, UID, model and the OS build using
+            cahal_probe_cache_fingerprint; an entry whose fingerprint no longer
+            matches the device is discarded and the device is probed again.
+
+            The cache file is a small binary file that starts with
+            CAHAL_PROBE_CACHE_MAGIC and CAHAL_PROBE_CACHE_VERSION. Files with a
+            different magic or version, e.g. written by an older release or a
+            machine with a different byte order, are ignored.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_PROBE_CACHE_H__
+#define __CAHAL_PROBE_CACHE_H__
+
+#include <cpcommon.h>
+
+#include "cahal_audio_format_description.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_PROBE_CACHE_MAGIC
+    \brief  The first four bytes of a cache file ("CAPC").
+ */
+#define CAHAL_PROBE_CACHE_MAGIC               0x43504143
+
+/*! \def    CAHAL_PROBE_CACHE_VERSION
+    \brief  The version of the cache file layout. Must be incremented whenever
+            the layout or the meaning of the stored formats changes.
+ */
+#define CAHAL_PROBE_CACHE_VERSION             2
+
+/*! \def    CAHAL_PROBE_CACHE_MAXIMUM_KEY_LENGTH
+    \brief  The longest device key (in bytes) accepted in a cache file.
+ */
+#define CAHAL_PROBE_CACHE_MAXIMUM_KEY_LENGTH  1024
+
+/*! \def    CAHAL_PROBE_CACHE_MAXIMUM_FORMATS
+    \brief  The largest number of formats per device accepted in a cache file.
+ */
+#define CAHAL_PROBE_CACHE_MAXIMUM_FORMATS     4096
+
+/*! \var    cahal_probe_cache_entry
+    \brief  Struct definition for the cached formats of one device.
+ */
+typedef struct cahal_probe_cache_entry_t
+{
+  /*! \var    device_key
+      \brief  The key the entry is stored under.
+   */
+  CHAR*                           device_key;
+
+  /*! \var    fingerprint
+      \brief  The fingerprint of the device when it was probed.
+   */
+  UINT64                          fingerprint;
+
+  /*! \var    formats
+      \brief  The supported formats.
+   */
+  cahal_audio_format_description* formats;
+
+  /*! \var    number_of_formats
+      \brief  The number of elements in formats.
+   */
+  UINT32                          number_of_formats;
+
+} cahal_probe_cache_entry;
+
+/*! \var    cahal_probe_cache
+    \brief  Struct definition for a probe cache.
+ */
+typedef struct cahal_probe_cache_t
+{
+  /*! \var    entries
+      \brief  The cached devices.
+   */
+  cahal_probe_cache_entry*  entries;
+
+  /*! \var    number_of_entries
+      \brief  The number of elements in entries.
+   */
+  UINT32                    number_of_entries;
+
+  /*! \var    modified
+      \brief  True iff entries were stored or invalidated since the cache was
+              loaded or saved.
+   */
+  CPC_BOOL                  modified;
+
+  /*! \var    number_of_hits
+      \brief  The number of lookups that were served from the cache.
+   */
+  UINT32                    number_of_hits;
+
+  /*! \var    number_of_misses
+      \brief  The number of lookups that were not found or were invalidated.
+   */
+  UINT32                    number_of_misses;
+
+} cahal_probe_cache;
+
+/*! \var    g_probe_cache_path
+    \brief  The file used to cache probed formats between runs, or NULL if
+            probed formats are not cached. Set using cahal_set_probe_cache_path.
+ */
+extern CHAR* g_probe_cache_path;
+
+/*! \fn     UINT64 cahal_probe_cache_fingerprint  (
+              const CHAR* in_name,
+              const CHAR* in_uid,
+              const CHAR* in_model,
+              const CHAR* in_os_build
+            )
+    \brief  Computes the fingerprint (64-bit FNV-1a hash) of a device. Any of
+            the parameters may be NULL.
+
+    \param  in_name The device name.
+    \param  in_uid  The unique identifier of the device.
+    \param  in_model  The device (or handset) model.
+    \param  in_os_build The OS build identifier.
+    \return The fingerprint.
+ */
+UINT64
+cahal_probe_cache_fingerprint  (
+                                const CHAR* in_name,
+                                const CHAR* in_uid,
+                                const CHAR* in_model,
+                                const CHAR* in_os_build
+                                );
+
+/*! \fn     cahal_probe_cache* cahal_probe_cache_create( void )
+    \brief  Creates an empty cache.
+
+    \return The new cache or NULL on error. Free using cahal_probe_cache_free.
+ */
+cahal_probe_cache*
+cahal_probe_cache_create( void );
+
+/*! \fn     cahal_probe_cache* cahal_probe_cache_load  (
+              const CHAR* in_path
+            )
+    \brief  Reads a cache from in_path. A missing, truncated or incompatible
+            file is not an error: an empty cache is returned and the file is
+            replaced the next time the cache is saved.
+
+    \param  in_path The cache file.
+    \return The cache or NULL on error. Free using cahal_probe_cache_free.
+ */
+cahal_probe_cache*
+cahal_probe_cache_load  (
+                         const CHAR* in_path
+                         );
+
+/*! \fn     CPC_BOOL cahal_probe_cache_save  (
+              cahal_probe_cache*  io_cache,
+              const CHAR*         in_path
+            )
+    \brief  Writes the cache to in_path. The file is written to a temporary
+            file first and renamed so readers never see a partial cache.
+
+    \param  io_cache  The cache to write.
+    \param  in_path The cache file.
+    \return True iff the cache was written.
+ */
+CPC_BOOL
+cahal_probe_cache_save  (
+                         cahal_probe_cache*  io_cache,
+                         const CHAR*         in_path
+                         );
+
+/*! \fn     void cahal_probe_cache_free  (
+              cahal_probe_cache* in_cache
+            )
+    \brief  Frees the cache and all of its entries.
+
+    \param  in_cache  The cache to free.
+ */
+void
+cahal_probe_cache_free  (
+                         cahal_probe_cache* in_cache
+                         );
+
+/*! \fn     cahal_audio_format_description** cahal_probe_cache_lookup (
+              cahal_probe_cache*  io_cache,
+              const CHAR*         in_device_key,
+              UINT64              in_fingerprint
+            )
+    \brief  Returns the cached formats of the device stored under
+            in_device_key. If the stored fingerprint differs from
+            in_fingerprint the entry is removed and NULL is returned.
+
+    \param  io_cache  The cache to search.
+    \param  in_device_key The key of the device.
+    \param  in_fingerprint  The current fingerprint of the device.
+    \return A newly allocated null-terminated list of formats (that may be
+            empty), suitable for cahal_device_stream.supported_formats, or
+            NULL if the device is not cached. Free using
+            cahal_free_audio_format_description_list.
+ */
+cahal_audio_format_description**
+cahal_probe_cache_lookup (
+                          cahal_probe_cache*  io_cache,
+                          const CHAR*         in_device_key,
+                          UINT64              in_fingerprint
+                          );
+
+/*! \fn     CPC_BOOL cahal_probe_cache_store  (
+              cahal_probe_cache*                io_cache,
+              const CHAR*                       in_device_key,
+              UINT64                            in_fingerprint,
+              cahal_audio_format_description**  in_formats
+            )
+    \brief  Stores a copy of in_formats under in_device_key, replacing any
+            existing entry.
+
+    \param  io_cache  The cache to update.
+    \param  in_device_key The key of the device.
+    \param  in_fingerprint  The fingerprint of the device.
+    \param  in_formats  The null-terminated list of supported formats.
+    \return True iff the entry was stored.
+ */
+CPC_BOOL
+cahal_probe_cache_store  (
+                          cahal_probe_cache*                io_cache,
+                          const CHAR*                       in_device_key,
+                          UINT64                            in_fingerprint,
+                          cahal_audio_format_description**  in_formats
+                          );
+
+/*! \fn     CPC_BOOL cahal_set_probe_cache_path  (
+              const CHAR* in_path
+            )
+    \brief  Sets the file used to cache probed formats between runs. Must be
+            called before cahal_get_device_list; the file must be in a
+            directory the process can write to (e.g. the application cache
+            directory on Android).
+
+    \param  in_path The cache file, or NULL to disable the cache.
+    \return True iff the path was set.
+ */
+CPC_BOOL
+cahal_set_probe_cache_path  (
+                             const CHAR* in_path
+                             );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_PROBE_CACHE_H__ */
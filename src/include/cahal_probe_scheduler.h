@@ -0,0 +1,328 @@
+/*! \file   cahal_probe_scheduler.h
+    \brief  Probes the formats of several devices concurrently on a bounded
+            pool of worker threads and publishes each device as soon as its
+            own probing is done.
+
+            Each device added to the scheduler comes with one stream, whose
+            formats are found by a cahal_prober. The individual configuration
+            tests of all devices are queued in the order the devices were
+            added and are run by the workers, so independent tests overlap and
+            a device that was added early (e.g. the default device) is not held
+            back by a slow device added after it. Devices are published in the
+            order they finish, through a callback and/or by iterating with
+            cahal_probe_scheduler_next.
+
+            The probe callbacks of the probers used with a scheduler must be
+            safe to call from several threads at once.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_PROBE_SCHEDULER_H__
+#define __CAHAL_PROBE_SCHEDULER_H__
+
+#include <cpcommon.h>
+
+#include "cahal_device.h"
+#include "cahal_probe.h"
+#include "cahal_probe_cache.h"
+#include "cahal_thread.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_PROBE_SCHEDULER_MAXIMUM_WORKERS
+    \brief  The maximum number of worker threads of a scheduler.
+ */
+#define CAHAL_PROBE_SCHEDULER_MAXIMUM_WORKERS 32
+
+/*! \var    cahal_probe_task
+    \brief  Struct definition for the probing of one device.
+ */
+typedef struct cahal_probe_task_t
+{
+  /*! \var    device
+      \brief  The device being probed.
+   */
+  cahal_device*         device;
+
+  /*! \var    stream
+      \brief  The stream being probed. It is added to device once probed.
+   */
+  cahal_device_stream*  stream;
+
+  /*! \var    prober
+      \brief  The prober of stream.
+   */
+  cahal_prober*         prober;
+
+  /*! \var    configuration
+      \brief  Platform specific configuration passed to prober.
+   */
+  UINT32                configuration;
+
+  /*! \var    device_key
+      \brief  The key of the device in the probe cache.
+   */
+  CHAR*                 device_key;
+
+  /*! \var    fingerprint
+      \brief  The fingerprint of the device.
+   */
+  UINT64                fingerprint;
+
+  /*! \var    supported
+      \brief  The result of each configuration test.
+   */
+  CPC_BOOL*             supported;
+
+  /*! \var    number_of_configurations
+      \brief  The number of elements in supported.
+   */
+  UINT32                number_of_configurations;
+
+  /*! \var    next_configuration
+      \brief  The next configuration to hand out to a worker.
+   */
+  UINT32                next_configuration;
+
+  /*! \var    number_of_pending
+      \brief  The number of configurations that have not been tested yet.
+   */
+  UINT32                number_of_pending;
+
+} cahal_probe_task;
+
+/*! \var    cahal_probe_scheduler
+    \brief  Struct definition for a probe scheduler. All members are protected
+            by lock.
+ */
+typedef struct cahal_probe_scheduler_t
+{
+  /*! \var    workers
+      \brief  The worker threads.
+   */
+  cahal_thread*             workers;
+
+  /*! \var    number_of_workers
+      \brief  The number of elements in workers.
+   */
+  UINT32                    number_of_workers;
+
+  /*! \var    lock
+      \brief  Protects the state of the scheduler.
+   */
+  cahal_mutex               lock;
+
+  /*! \var    work_available
+      \brief  Signalled when configurations are queued or the scheduler is
+              stopping.
+   */
+  cahal_condition           work_available;
+
+  /*! \var    device_published
+      \brief  Signalled when a device is published or the last device is done.
+   */
+  cahal_condition           device_published;
+
+  /*! \var    tasks
+      \brief  The devices being probed in the order they were added. Tasks are
+              freed and set to NULL once done.
+   */
+  cahal_probe_task**        tasks;
+
+  /*! \var    number_of_tasks
+      \brief  The number of elements in tasks.
+   */
+  UINT32                    number_of_tasks;
+
+  /*! \var    next_task
+      \brief  The first task that has configurations left to hand out.
+   */
+  UINT32                    next_task;
+
+  /*! \var    number_of_pending_tasks
+      \brief  The number of tasks that are not done.
+   */
+  UINT32                    number_of_pending_tasks;
+
+  /*! \var    devices
+      \brief  The published devices, in order of publication.
+   */
+  cahal_device**            devices;
+
+  /*! \var    number_of_devices
+      \brief  The number of elements in devices.
+   */
+  UINT32                    number_of_devices;
+
+  /*! \var    number_of_returned_devices
+      \brief  The number of devices handed to the caller.
+   */
+  UINT32                    number_of_returned_devices;
+
+  /*! \var    cache
+      \brief  The cache consulted before probing a device, or NULL.
+   */
+  cahal_probe_cache*        cache;
+
+  /*! \var    callback
+      \brief  Called with each device before it is published, or NULL.
+   */
+  cahal_device_list_callback callback;
+
+  /*! \var    user_data
+      \brief  User data passed to callback.
+   */
+  void*                     user_data;
+
+  /*! \var    finished
+      \brief  True once no more devices will be added.
+   */
+  CPC_BOOL                  finished;
+
+  /*! \var    stopping
+      \brief  True once the workers have been asked to exit.
+   */
+  CPC_BOOL                  stopping;
+
+} cahal_probe_scheduler;
+
+/*! \fn     cahal_probe_scheduler* cahal_probe_scheduler_create  (
+              UINT32                      in_number_of_workers,
+              cahal_probe_cache*          io_cache,
+              cahal_device_list_callback  in_callback,
+              void*                       in_user_data
+            )
+    \brief  Creates a scheduler and starts its workers.
+
+    \param  in_number_of_workers  The number of worker threads, between 1 and
+                                  CAHAL_PROBE_SCHEDULER_MAXIMUM_WORKERS.
+    \param  io_cache  The cache to consult before probing a device and to
+                      store probed formats in, or NULL. It must not be used by
+                      anything else until the scheduler has been freed.
+    \param  in_callback Called with each device before it is published, or
+                        NULL. It may be called concurrently from several
+                        workers (and from cahal_probe_scheduler_add for cached
+                        devices) and must not call the scheduler. The device
+                        is still owned by the scheduler during the call.
+    \param  in_user_data  User data passed to in_callback.
+    \return The new scheduler or NULL on error. Free using
+            cahal_probe_scheduler_free.
+ */
+cahal_probe_scheduler*
+cahal_probe_scheduler_create  (
+                               UINT32                      in_number_of_workers,
+                               cahal_probe_cache*          io_cache,
+                               cahal_device_list_callback  in_callback,
+                               void*                       in_user_data
+                               );
+
+/*! \fn     CPC_BOOL cahal_probe_scheduler_add  (
+              cahal_probe_scheduler*  io_scheduler,
+              cahal_device*           in_device,
+              cahal_device_stream*    in_stream,
+              cahal_prober*           in_prober,
+              UINT32                  in_configuration,
+              const CHAR*             in_device_key,
+              UINT64                  in_fingerprint
+            )
+    \brief  Queues the probing of in_stream. If io_cache has the formats of
+            the device they are used and the device is published before this
+            function returns.
+
+            Once probed, in_stream is appended to the streams of in_device if
+            it supports at least one format and freed otherwise. The device is
+            published iff it then has a stream; otherwise it is freed.
+
+    \param  io_scheduler  The scheduler.
+    \param  in_device The device. Owned by the scheduler until it is returned
+                      by cahal_probe_scheduler_next or
+                      cahal_probe_scheduler_wait.
+    \param  in_stream The stream to probe. Owned by the scheduler.
+    \param  in_prober The prober of in_stream. Must not be freed until the
+                      scheduler is done.
+    \param  in_configuration  Platform specific configuration passed to
+                              in_prober.
+    \param  in_device_key The key of the device in the cache.
+    \param  in_fingerprint  The fingerprint of the device.
+    \return True iff the device was queued. If false the device and stream
+            are still owned by the caller.
+ */
+CPC_BOOL
+cahal_probe_scheduler_add  (
+                            cahal_probe_scheduler*  io_scheduler,
+                            cahal_device*           in_device,
+                            cahal_device_stream*    in_stream,
+                            cahal_prober*           in_prober,
+                            UINT32                  in_configuration,
+                            const CHAR*             in_device_key,
+                            UINT64                  in_fingerprint
+                            );
+
+/*! \fn     void cahal_probe_scheduler_finish (
+              cahal_probe_scheduler* io_scheduler
+            )
+    \brief  Declares that no more devices will be added, so that
+            cahal_probe_scheduler_next can report the end of the devices.
+
+    \param  io_scheduler  The scheduler.
+ */
+void
+cahal_probe_scheduler_finish (
+                              cahal_probe_scheduler* io_scheduler
+                              );
+
+/*! \fn     cahal_device* cahal_probe_scheduler_next (
+              cahal_probe_scheduler* io_scheduler
+            )
+    \brief  Blocks until a device is published that has not been returned yet
+            and returns it, in order of publication.
+
+    \param  io_scheduler  The scheduler.
+    \return The device, now owned by the caller, or NULL once
+            cahal_probe_scheduler_finish has been called and every device has
+            been returned.
+ */
+cahal_device*
+cahal_probe_scheduler_next (
+                            cahal_probe_scheduler* io_scheduler
+                            );
+
+/*! \fn     cahal_device** cahal_probe_scheduler_wait (
+              cahal_probe_scheduler* io_scheduler
+            )
+    \brief  Calls cahal_probe_scheduler_finish and blocks until every device
+            is done.
+
+    \param  io_scheduler  The scheduler.
+    \return A newly allocated null-terminated list of the devices that have
+            not been returned by cahal_probe_scheduler_next, in order of
+            publication, or NULL on error. The list and devices are owned by
+            the caller.
+ */
+cahal_device**
+cahal_probe_scheduler_wait (
+                            cahal_probe_scheduler* io_scheduler
+                            );
+
+/*! \fn     void cahal_probe_scheduler_free (
+              cahal_probe_scheduler* in_scheduler
+            )
+    \brief  Stops the workers once their current test returns and frees the
+            scheduler. Devices that are still being probed or have not been
+            returned are freed.
+
+    \param  in_scheduler  The scheduler to free.
+ */
+void
+cahal_probe_scheduler_free (
+                            cahal_probe_scheduler* in_scheduler
+                            );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_PROBE_SCHEDULER_H__ */
@@ -0,0 +1,173 @@
+/*! \file   cahal_profile.h
+    \brief  Startup-time profile of the library. cahal_initialize, the
+            platform initialisation it performs and every step of device
+            enumeration are timed using the monotonic clock read by
+            cahal_get_time and recorded as named stages, so that callers
+            (e.g. short-lived command line tools) can see where the time to
+            the first device list goes.
+
+            Stages nest: a stage that begins while another is running on the
+            same thread lies entirely within it. Recording is cheap (two
+            clock reads and an atomic increment per stage) and is always on;
+            once CAHAL_PROFILE_MAXIMUM_STAGES stages have been recorded
+            further stages are only counted, until the profile is reset.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_PROFILE_H__
+#define __CAHAL_PROFILE_H__
+
+#include <cpcommon.h>
+
+#include "cahal_atomic.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_PROFILE_MAXIMUM_STAGES
+    \brief  The number of stages a profile can hold.
+ */
+#define CAHAL_PROFILE_MAXIMUM_STAGES  64
+
+/*! \def    CAHAL_PROFILE_NO_STAGE
+    \brief  Returned by cahal_profile_begin when the profile is full.
+ */
+#define CAHAL_PROFILE_NO_STAGE        0xFFFFFFFF
+
+/*! \var    cahal_profile_stage
+    \brief  Struct definition for one timed stage.
+ */
+typedef struct cahal_profile_stage_t
+{
+  /*! \var    name
+      \brief  The name of the stage, usually the function that was timed.
+              Must be a string literal or otherwise outlive the profile.
+   */
+  const CHAR*         name;
+
+  /*! \var    start_time
+      \brief  The time (ns, see cahal_get_time) at which the stage began.
+   */
+  UINT64              start_time;
+
+  /*! \var    duration
+      \brief  The time (ns) the stage took.
+   */
+  UINT64              duration;
+
+  /*! \var    is_complete
+      \brief  Set once the stage has ended and duration is valid.
+   */
+  cahal_atomic_uint32 is_complete;
+
+} cahal_profile_stage;
+
+/*! \var    cahal_init_profile
+    \brief  Struct definition for the startup-time profile. Stages are stored
+            in the order they began.
+ */
+typedef struct cahal_init_profile_t
+{
+  /*! \var    number_of_stages
+      \brief  The number of stages that have begun, including those that did
+              not fit in stages.
+   */
+  cahal_atomic_uint32 number_of_stages;
+
+  /*! \var    stages
+      \brief  The recorded stages.
+   */
+  cahal_profile_stage stages[ CAHAL_PROFILE_MAXIMUM_STAGES ];
+
+} cahal_init_profile;
+
+/*! \fn     UINT32 cahal_profile_begin  (
+              const CHAR* in_name
+            )
+    \brief  Begins timing a stage. Every stage that is begun must be ended
+            using cahal_profile_end.
+
+    \param  in_name The name of the stage. Must be a string literal.
+    \return The stage to pass to cahal_profile_end, or CAHAL_PROFILE_NO_STAGE
+            if the profile is full.
+ */
+UINT32
+cahal_profile_begin  (
+                      const CHAR* in_name
+                      );
+
+/*! \fn     void cahal_profile_end  (
+              UINT32 in_stage
+            )
+    \brief  Ends timing a stage.
+
+    \param  in_stage  The stage returned by cahal_profile_begin. Ignored if it
+                      is CAHAL_PROFILE_NO_STAGE.
+ */
+void
+cahal_profile_end  (
+                    UINT32 in_stage
+                    );
+
+/*! \fn     const cahal_init_profile* cahal_get_init_profile( void )
+    \brief  Returns the profile recorded since the library was loaded or last
+            reset. Only stages whose is_complete flag is set may be read
+            while other threads are still recording.
+
+    \return The profile. It is owned by the library.
+ */
+const cahal_init_profile*
+cahal_get_init_profile( void );
+
+/*! \fn     const cahal_profile_stage* cahal_get_init_profile_stage  (
+              UINT32 in_index
+            )
+    \brief  Returns the in_index'th stage of the profile if it has completed.
+
+    \param  in_index  The index of the stage, in the order stages began.
+    \return The stage or NULL if there is no such stage or it is still
+            running.
+ */
+const cahal_profile_stage*
+cahal_get_init_profile_stage  (
+                               UINT32 in_index
+                               );
+
+/*! \fn     void cahal_reset_init_profile( void )
+    \brief  Discards every recorded stage, e.g. to profile a refresh of the
+            device list on its own. Must not be called while a stage is
+            being timed.
+ */
+void
+cahal_reset_init_profile( void );
+
+/*! \fn     void cahal_print_init_profile( void )
+    \brief  Logs every completed stage at CPC_LOG_LEVEL_INFO, indented by how
+            deeply it is nested, with its start relative to the first stage
+            and its duration in milliseconds.
+ */
+void
+cahal_print_init_profile( void );
+
+/*! \fn     CPC_BOOL cahal_dump_init_profile  (
+              const CHAR* in_path
+            )
+    \brief  Writes every completed stage to in_path in the Trace Event Format
+            read by chrome://tracing and Perfetto, with times in microseconds
+            relative to the first stage.
+
+    \param  in_path The path of the trace file.
+    \return True iff the file was written.
+ */
+CPC_BOOL
+cahal_dump_init_profile  (
+                          const CHAR* in_path
+                          );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_PROFILE_H__ */
@@ -0,0 +1,186 @@
+/*! \file   cahal_ring_buffer.h
+    \brief  Single-producer/single-consumer lock-free ring buffer. The ring
+            buffer is used to move audio data between the OS' callback threads
+            and the rest of the library without taking locks. Exactly one
+            thread may write to a ring buffer and exactly one (possibly
+            different) thread may read from it.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_RING_BUFFER_H__
+#define __CAHAL_RING_BUFFER_H__
+
+#include <cpcommon.h>
+
+#include "cahal_atomic.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \var    cahal_ring_buffer
+    \brief  Struct definition for the ring buffer. The read and write indices
+            increase monotonically and wrap naturally at 2^32; the capacity is
+            always a power of two so that the indices can be masked.
+ */
+typedef struct cahal_ring_buffer_t
+{
+  /*! \var    buffer
+      \brief  The backing storage of the ring buffer.
+   */
+  UCHAR*              buffer;
+
+  /*! \var    capacity
+      \brief  The size of buffer in bytes. Always a power of two.
+   */
+  UINT32              capacity;
+
+  /*! \var    write_index
+      \brief  The total number of bytes written. Only modified by the
+              producer.
+   */
+  cahal_atomic_uint32 write_index;
+
+  /*! \var    read_index
+      \brief  The total number of bytes read. Only modified by the consumer.
+   */
+  cahal_atomic_uint32 read_index;
+
+} cahal_ring_buffer;
+
+/*! \fn     cahal_ring_buffer* cahal_ring_buffer_create (
+              UINT32 in_capacity
+            )
+    \brief  Creates a new, empty ring buffer that is able to hold at least
+            in_capacity bytes.
+
+    \param  in_capacity The minimum number of bytes the ring buffer must be
+                        able to hold. This is rounded up to a power of two.
+    \return The newly created ring buffer or NULL on error. The ring buffer
+            must be freed using cahal_ring_buffer_free.
+ */
+cahal_ring_buffer*
+cahal_ring_buffer_create (
+                          UINT32 in_capacity
+                          );
+
+/*! \fn     void cahal_ring_buffer_free (
+              cahal_ring_buffer* in_ring_buffer
+            )
+    \brief  Frees the ring buffer and its backing storage. Neither the producer
+            nor the consumer may use the ring buffer during or after this call.
+
+    \param  in_ring_buffer  The ring buffer to free.
+ */
+void
+cahal_ring_buffer_free (
+                        cahal_ring_buffer* in_ring_buffer
+                        );
+
+/*! \fn     void cahal_ring_buffer_reset (
+              cahal_ring_buffer* io_ring_buffer
+            )
+    \brief  Discards all data in the ring buffer. This is only safe to call
+            while neither the producer nor the consumer are active.
+
+    \param  io_ring_buffer  The ring buffer to empty.
+ */
+void
+cahal_ring_buffer_reset (
+                         cahal_ring_buffer* io_ring_buffer
+                         );
+
+/*! \fn     UINT32 cahal_ring_buffer_get_fill (
+              cahal_ring_buffer* in_ring_buffer
+            )
+    \brief  Returns the number of bytes that can currently be read.
+
+    \param  in_ring_buffer  The ring buffer to query.
+    \return The number of bytes available to the consumer.
+ */
+UINT32
+cahal_ring_buffer_get_fill (
+                            cahal_ring_buffer* in_ring_buffer
+                            );
+
+/*! \fn     UINT32 cahal_ring_buffer_get_space (
+              cahal_ring_buffer* in_ring_buffer
+            )
+    \brief  Returns the number of bytes that can currently be written.
+
+    \param  in_ring_buffer  The ring buffer to query.
+    \return The number of bytes available to the producer.
+ */
+UINT32
+cahal_ring_buffer_get_space (
+                             cahal_ring_buffer* in_ring_buffer
+                             );
+
+/*! \fn     UINT32 cahal_ring_buffer_write (
+              cahal_ring_buffer* io_ring_buffer,
+              const UCHAR*       in_data,
+              UINT32             in_length
+            )
+    \brief  Copies up to in_length bytes from in_data into the ring buffer.
+            Must only be called by the producer.
+
+    \param  io_ring_buffer  The ring buffer to write to.
+    \param  in_data The data to copy into the ring buffer.
+    \param  in_length The number of bytes in in_data.
+    \return The number of bytes that were written. This is less than in_length
+            if the ring buffer did not have enough space.
+ */
+UINT32
+cahal_ring_buffer_write (
+                         cahal_ring_buffer* io_ring_buffer,
+                         const UCHAR*       in_data,
+                         UINT32             in_length
+                         );
+
+/*! \fn     UINT32 cahal_ring_buffer_read (
+              cahal_ring_buffer* io_ring_buffer,
+              UCHAR*             out_data,
+              UINT32             in_length
+            )
+    \brief  Removes up to in_length bytes from the ring buffer and copies them
+            into out_data. Must only be called by the consumer.
+
+    \param  io_ring_buffer  The ring buffer to read from.
+    \param  out_data  The buffer to copy the data into. If NULL the data is
+                      discarded.
+    \param  in_length The maximum number of bytes to read.
+    \return The number of bytes that were read.
+ */
+UINT32
+cahal_ring_buffer_read (
+                        cahal_ring_buffer* io_ring_buffer,
+                        UCHAR*             out_data,
+                        UINT32             in_length
+                        );
+
+/*! \fn     UINT32 cahal_ring_buffer_peek (
+              cahal_ring_buffer* in_ring_buffer,
+              UCHAR*             out_data,
+              UINT32             in_length
+            )
+    \brief  Copies up to in_length bytes from the ring buffer into out_data
+            without removing them. Must only be called by the consumer.
+
+    \param  in_ring_buffer  The ring buffer to read from.
+    \param  out_data  The buffer to copy the data into.
+    \param  in_length The maximum number of bytes to copy.
+    \return The number of bytes that were copied.
+ */
+UINT32
+cahal_ring_buffer_peek (
+                        cahal_ring_buffer* in_ring_buffer,
+                        UCHAR*             out_data,
+                        UINT32             in_length
+                        );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_RING_BUFFER_H__ */
@@ -0,0 +1,358 @@
+/*! \file   cahal_signal_generator.h
+    \brief  Built-in playback sources used for calibration and benchmarking
+            (e.g. round-trip latency, frequency response and load tests of the
+            output path). A generator is passed to cahal_start_playback in
+            place of a user-supplied callback: use
+            cahal_signal_generator_playback_callback as the callback and the
+            generator as the callback user data.
+
+            The signal is synthesized once per frame as 32-bit floating point
+            samples in fixed-size chunks and then copied to every channel and
+            converted to the playback format, so the cost of synthesis does not
+            grow with the number of channels. Oscillators are evaluated four
+            samples at a time using SSE or NEON when available.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_SIGNAL_GENERATOR_H__
+#define __CAHAL_SIGNAL_GENERATOR_H__
+
+#include <cpcommon.h>
+
+#include "cahal_device.h"
+#include "cahal_audio_format_flags.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_SIGNAL_GENERATOR_CHUNK_FRAMES
+    \brief  The number of frames synthesized at a time. Must be a multiple of
+            four (the width of the oscillator kernels).
+ */
+#define CAHAL_SIGNAL_GENERATOR_CHUNK_FRAMES   1024
+
+/*! \def    CAHAL_SIGNAL_GENERATOR_MAXIMUM_TONES
+    \brief  The maximum number of tones in a multitone signal.
+ */
+#define CAHAL_SIGNAL_GENERATOR_MAXIMUM_TONES  64
+
+/*! \enum   cahal_signal_types
+    \brief  The signals that can be synthesized by a cahal_signal_generator.
+ */
+enum cahal_signal_types
+{
+  CAHAL_SIGNAL_SILENCE        = 0,
+  CAHAL_SIGNAL_SINE           = 1,
+  CAHAL_SIGNAL_MULTITONE      = 2,
+  CAHAL_SIGNAL_LOG_SWEEP      = 3,
+  CAHAL_SIGNAL_WHITE_NOISE    = 4,
+  CAHAL_SIGNAL_PINK_NOISE     = 5,
+  CAHAL_SIGNAL_IMPULSE_TRAIN  = 6,
+};
+
+/*! \def    cahal_signal_type
+    \brief  Type definition for the supported signals.
+ */
+typedef UINT32 cahal_signal_type;
+
+/*! \var    cahal_signal_tone
+    \brief  Struct definition for a single oscillator of a sine or multitone
+            signal.
+ */
+typedef struct cahal_signal_tone_t
+{
+  /*! \var    frequency
+      \brief  The frequency of the tone in Hz.
+   */
+  FLOAT64 frequency;
+
+  /*! \var    level
+      \brief  The peak level of the tone relative to the generator amplitude.
+   */
+  FLOAT32 level;
+
+  /*! \var    phase
+      \brief  The phase (in radians) of the first sample of the next chunk.
+              The oscillator is restarted from this value for every chunk so
+              that rounding errors do not accumulate.
+   */
+  FLOAT64 phase;
+
+} cahal_signal_tone;
+
+/*! \var    cahal_signal_generator
+    \brief  Struct definition for a signal generator.
+ */
+typedef struct cahal_signal_generator_t
+{
+  /*! \var    signal_type
+      \brief  The signal being synthesized.
+   */
+  cahal_signal_type       signal_type;
+
+  /*! \var    number_of_channels
+      \brief  The number of interleaved channels produced. Every channel
+              carries the same signal.
+   */
+  UINT32                  number_of_channels;
+
+  /*! \var    sample_rate
+      \brief  The sample rate of the playback stream.
+   */
+  FLOAT64                 sample_rate;
+
+  /*! \var    bit_depth
+      \brief  Bit depth of the samples produced by the playback callback.
+   */
+  UINT32                  bit_depth;
+
+  /*! \var    format_flags
+      \brief  Format flags of the samples produced by the playback callback.
+   */
+  cahal_audio_format_flag format_flags;
+
+  /*! \var    amplitude
+      \brief  The peak amplitude of the signal in the range [ 0, 1 ].
+   */
+  FLOAT32                 amplitude;
+
+  /*! \var    tones
+      \brief  The oscillators of a sine or multitone signal.
+   */
+  cahal_signal_tone       tones[ CAHAL_SIGNAL_GENERATOR_MAXIMUM_TONES ];
+
+  /*! \var    number_of_tones
+      \brief  The number of oscillators in use.
+   */
+  UINT32                  number_of_tones;
+
+  /*! \var    sweep_start_frequency
+      \brief  The frequency at the start of a log sweep.
+   */
+  FLOAT64                 sweep_start_frequency;
+
+  /*! \var    sweep_end_frequency
+      \brief  The frequency at the end of a log sweep.
+   */
+  FLOAT64                 sweep_end_frequency;
+
+  /*! \var    sweep_length
+      \brief  The length of a log sweep in frames. The sweep is repeated.
+   */
+  UINT32                  sweep_length;
+
+  /*! \var    impulse_period
+      \brief  The number of frames between two impulses of an impulse train.
+   */
+  UINT32                  impulse_period;
+
+  /*! \var    position
+      \brief  The number of frames generated since the start of the current
+              sweep or impulse period.
+   */
+  UINT32                  position;
+
+  /*! \var    noise_state
+      \brief  State of the xorshift pseudo-random number generator.
+   */
+  UINT32                  noise_state;
+
+  /*! \var    pink_state
+      \brief  State of the filter that shapes white noise into pink noise.
+   */
+  FLOAT32                 pink_state[ 7 ];
+
+  /*! \var    chunk
+      \brief  The most recently synthesized chunk of (mono) samples.
+   */
+  FLOAT32*                chunk;
+
+  /*! \var    chunk_offset
+      \brief  The index of the next unused sample in chunk.
+   */
+  UINT32                  chunk_offset;
+
+  /*! \var    output_scratch
+      \brief  Interleaved floating point frames converted by the playback
+              callback.
+   */
+  FLOAT32*                output_scratch;
+
+} cahal_signal_generator;
+
+/*! \fn     cahal_signal_generator* cahal_signal_generator_create  (
+              cahal_signal_type       in_signal_type,
+              UINT32                  in_number_of_channels,
+              FLOAT64                 in_sample_rate,
+              UINT32                  in_bit_depth,
+              cahal_audio_format_flag in_format_flags,
+              FLOAT32                 in_amplitude
+            )
+    \brief  Creates a new signal generator. Sine and multitone generators
+            need tones (cahal_signal_generator_add_tone), log sweeps need a
+            range (cahal_signal_generator_set_sweep) and impulse trains need a
+            period (cahal_signal_generator_set_period) before they
+            produce anything other than silence.
+
+    \param  in_signal_type  The signal to synthesize.
+    \param  in_number_of_channels The number of channels in the playback
+                                  stream.
+    \param  in_sample_rate  The sample rate of the playback stream.
+    \param  in_bit_depth  The bit depth of the playback stream.
+    \param  in_format_flags The format flags of the playback stream.
+    \param  in_amplitude  The peak amplitude of the signal in [ 0, 1 ].
+    \return The new generator or NULL if the parameters are invalid or memory
+            could not be allocated. Free using cahal_signal_generator_free.
+ */
+cahal_signal_generator*
+cahal_signal_generator_create  (
+                                cahal_signal_type       in_signal_type,
+                                UINT32                  in_number_of_channels,
+                                FLOAT64                 in_sample_rate,
+                                UINT32                  in_bit_depth,
+                                cahal_audio_format_flag in_format_flags,
+                                FLOAT32                 in_amplitude
+                                );
+
+/*! \fn     void cahal_signal_generator_free  (
+              cahal_signal_generator* in_generator
+            )
+    \brief  Frees the generator. The playback stream using the generator must
+            have been stopped.
+
+    \param  in_generator  The generator to free.
+ */
+void
+cahal_signal_generator_free  (
+                              cahal_signal_generator* in_generator
+                              );
+
+/*! \fn     CPC_BOOL cahal_signal_generator_add_tone  (
+              cahal_signal_generator* io_generator,
+              FLOAT64                 in_frequency,
+              FLOAT32                 in_level
+            )
+    \brief  Adds an oscillator to a sine or multitone generator. A sine
+            generator holds a single tone. The tone levels are not normalized:
+            keep their sum at or below 1 to avoid clipping.
+
+    \param  io_generator  The generator to add the tone to.
+    \param  in_frequency  The frequency of the tone, below the Nyquist
+                          frequency.
+    \param  in_level  The peak level of the tone relative to the amplitude of
+                      the generator.
+    \return True iff the tone was added.
+ */
+CPC_BOOL
+cahal_signal_generator_add_tone  (
+                                  cahal_signal_generator* io_generator,
+                                  FLOAT64                 in_frequency,
+                                  FLOAT32                 in_level
+                                  );
+
+/*! \fn     CPC_BOOL cahal_signal_generator_set_sweep  (
+              cahal_signal_generator* io_generator,
+              FLOAT64                 in_start_frequency,
+              FLOAT64                 in_end_frequency,
+              FLOAT64                 in_duration
+            )
+    \brief  Configures an exponential (log) sine sweep. The sweep restarts
+            every in_duration seconds.
+
+    \param  io_generator  The log sweep generator to configure.
+    \param  in_start_frequency  The frequency at the start of the sweep.
+    \param  in_end_frequency  The frequency at the end of the sweep. May be
+                              below in_start_frequency for a downward sweep.
+    \param  in_duration The length of the sweep in seconds.
+    \return True iff the sweep was configured.
+ */
+CPC_BOOL
+cahal_signal_generator_set_sweep  (
+                                   cahal_signal_generator* io_generator,
+                                   FLOAT64                 in_start_frequency,
+                                   FLOAT64                 in_end_frequency,
+                                   FLOAT64                 in_duration
+                                   );
+
+/*! \fn     CPC_BOOL cahal_signal_generator_set_period  (
+                                    cahal_signal_generator* io_generator,
+                                    FLOAT64                 in_period
+                                    )
+    \brief  Configures the time between two impulses of an impulse train. The
+            first impulse is the first sample generated.
+
+    \param  io_generator  The impulse train generator to configure.
+    \param  in_period The time between impulses in seconds. Must be at least
+                      one sample.
+    \return True iff the period was configured.
+ */
+CPC_BOOL
+cahal_signal_generator_set_period  (
+                                    cahal_signal_generator* io_generator,
+                                    FLOAT64                 in_period
+                                    );
+
+/*! \fn     void cahal_signal_generator_reset  (
+              cahal_signal_generator* io_generator
+            )
+    \brief  Restarts the signal from the beginning: oscillator phases, the
+            sweep and impulse position and the noise sequence are reset.
+
+    \param  io_generator  The generator to reset.
+ */
+void
+cahal_signal_generator_reset  (
+                               cahal_signal_generator* io_generator
+                               );
+
+/*! \fn     void cahal_signal_generator_generate  (
+              cahal_signal_generator* io_generator,
+              FLOAT32*                out_frames,
+              UINT32                  in_number_of_frames
+            )
+    \brief  Produces the next in_number_of_frames interleaved floating point
+            frames of the signal.
+
+    \param  io_generator  The generator to read from.
+    \param  out_frames  The buffer to fill. Must hold in_number_of_frames
+                        multiplied by the number of channels samples.
+    \param  in_number_of_frames The number of frames to produce.
+ */
+void
+cahal_signal_generator_generate  (
+                                  cahal_signal_generator* io_generator,
+                                  FLOAT32*                out_frames,
+                                  UINT32                  in_number_of_frames
+                                  );
+
+/*! \fn     CPC_BOOL cahal_signal_generator_playback_callback (
+              cahal_device* in_playback_device,
+              UCHAR*        out_data_buffer,
+              UINT32*       io_data_buffer_length,
+              void*         in_client_data
+            )
+    \brief  cahal_playback_callback that fills out_data_buffer completely with
+            the signal produced by the generator passed in in_client_data.
+
+    \param  in_playback_device  The device the samples will be played on.
+    \param  out_data_buffer The buffer to fill.
+    \param  io_data_buffer_length The capacity of out_data_buffer on input, the
+                                  number of bytes written on output.
+    \param  in_client_data  The cahal_signal_generator to read from.
+    \return True iff the buffer was filled.
+ */
+CPC_BOOL
+cahal_signal_generator_playback_callback (
+                                          cahal_device* in_playback_device,
+                                          UCHAR*        out_data_buffer,
+                                          UINT32*       io_data_buffer_length,
+                                          void*         in_client_data
+                                          );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_SIGNAL_GENERATOR_H__ */
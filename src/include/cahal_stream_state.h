@@ -0,0 +1,329 @@
+/*! \file   cahal_stream_state.h
+    \brief  The lifecycle of the recording and playback streams. Every stream
+            moves through IDLE -> STARTING -> RUNNING -> STOPPING -> STOPPED
+            (and from STOPPED back to STARTING) by compare-and-swap on a
+            single word, so cahal_start_*, cahal_stop_* and cahal_terminate
+            may be called from any thread without a global lock: of two
+            concurrent starts (or stops) exactly one wins and the other
+            returns false.
+
+            A running stream can be paused (RUNNING -> PAUSING -> PAUSED) and
+            resumed (PAUSED -> STARTING -> RUNNING) without giving up its
+            resources. A prepared stream is one that was set up but never
+            started: cahal_prepare_* moves it from STARTING to PAUSED, and
+            cahal_resume_* starts it. A paused stream is stopped like a
+            running one.
+
+            The same word counts the OS callbacks that are using the stream.
+            A callback enters the stream before it touches the stream's
+            callback info and leaves it when done; it is refused once the
+            stream is stopping. Stopping a stream therefore stops the OS
+            stream, waits until the callbacks that were already running have
+            left (the quiescent state) and only then frees the callback info.
+
+            Settings read by the callbacks without entering a stream of their
+            own (e.g. the installed echo canceller) are only changed while
+            the streams reading them are CONFIGURING: an IDLE or STOPPED
+            stream is moved there for the change and then back to IDLE, and
+            cannot be started in the meantime.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_STREAM_STATE_H__
+#define __CAHAL_STREAM_STATE_H__
+
+#include <cpcommon.h>
+
+#include "cahal_atomic.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_STREAM_STATE_MASK
+    \brief  The bits of cahal_stream_state.value holding the state. The bits
+            above count the callbacks using the stream.
+ */
+#define CAHAL_STREAM_STATE_MASK     0x000000FF
+
+/*! \def    CAHAL_STREAM_STATE_CALLBACK
+    \brief  The amount cahal_stream_state.value is increased by for every
+            callback using the stream.
+ */
+#define CAHAL_STREAM_STATE_CALLBACK 0x00000100
+
+/*! \enum   cahal_stream_states
+    \brief  The states of a stream.
+ */
+enum cahal_stream_states
+{
+  CAHAL_STREAM_STATE_IDLE = 0,
+  CAHAL_STREAM_STATE_STARTING,
+  CAHAL_STREAM_STATE_RUNNING,
+  CAHAL_STREAM_STATE_STOPPING,
+  CAHAL_STREAM_STATE_STOPPED,
+  CAHAL_STREAM_STATE_PAUSING,
+  CAHAL_STREAM_STATE_PAUSED,
+  CAHAL_STREAM_STATE_CONFIGURING
+};
+
+/*! \var    cahal_stream_state
+    \brief  Struct definition for the lifecycle of a stream.
+ */
+typedef struct cahal_stream_state_t
+{
+  /*! \var    value
+      \brief  The state (CAHAL_STREAM_STATE_MASK) and the number of callbacks
+              using the stream, in units of CAHAL_STREAM_STATE_CALLBACK.
+   */
+  cahal_atomic_uint32 value;
+
+} cahal_stream_state;
+
+/*! \var    g_cahal_recording_state
+    \brief  The lifecycle of the recording stream.
+ */
+extern cahal_stream_state g_cahal_recording_state;
+
+/*! \var    g_cahal_playback_state
+    \brief  The lifecycle of the playback stream.
+ */
+extern cahal_stream_state g_cahal_playback_state;
+
+/*! \fn     UINT32 cahal_stream_state_get  (
+              cahal_stream_state* in_state
+            )
+    \brief  Returns the current state of a stream.
+
+    \param  in_state  The lifecycle of the stream.
+    \return One of cahal_stream_states.
+ */
+UINT32
+cahal_stream_state_get  (
+                         cahal_stream_state* in_state
+                         );
+
+/*! \fn     CPC_BOOL cahal_stream_state_begin_start  (
+              cahal_stream_state* io_state
+            )
+    \brief  Moves an IDLE or STOPPED stream to STARTING. The caller then owns
+            the stream until it calls cahal_stream_state_end_start.
+
+    \param  io_state  The lifecycle of the stream.
+    \return True iff the stream was moved to STARTING. False if the stream is
+            already started or is being started or stopped by another thread.
+ */
+CPC_BOOL
+cahal_stream_state_begin_start  (
+                                 cahal_stream_state* io_state
+                                 );
+
+/*! \fn     void cahal_stream_state_end_start  (
+              cahal_stream_state* io_state,
+              CPC_BOOL            in_is_running
+            )
+    \brief  Moves a STARTING stream to RUNNING, or back to IDLE.
+
+    \param  io_state  The lifecycle of the stream.
+    \param  in_is_running True if the stream holds resources that
+                          cahal_stop_* must release, even if it failed to
+                          start, false if nothing was set up.
+ */
+void
+cahal_stream_state_end_start  (
+                               cahal_stream_state* io_state,
+                               CPC_BOOL            in_is_running
+                               );
+
+/*! \fn     CPC_BOOL cahal_stream_state_begin_stop  (
+              cahal_stream_state* io_state,
+              UINT32*             out_state
+            )
+    \brief  Moves a RUNNING or PAUSED stream to STOPPING, from which point
+            callbacks are refused. A stream that is STARTING or PAUSING is
+            waited for first, so that a stop racing a start stops the stream
+            once it is running. The caller then owns the stream until it
+            calls cahal_stream_state_end_stop.
+
+    \param  io_state  The lifecycle of the stream.
+    \param  out_state The state the stream was stopped from (RUNNING or
+                      PAUSED), e.g. since a paused playback cannot drain. May
+                      be NULL.
+    \return True iff the stream was moved to STOPPING. False if the stream is
+            not running or is being stopped by another thread.
+ */
+CPC_BOOL
+cahal_stream_state_begin_stop  (
+                                cahal_stream_state* io_state,
+                                UINT32*             out_state
+                                );
+
+/*! \fn     void cahal_stream_state_wait_for_callbacks (
+              cahal_stream_state* in_state
+            )
+    \brief  Waits until every callback that entered the stream has left it.
+            Called between cahal_stream_state_begin_stop and freeing the
+            callback info of the stream.
+
+    \param  in_state  The lifecycle of the stream.
+ */
+void
+cahal_stream_state_wait_for_callbacks (
+                                       cahal_stream_state* in_state
+                                       );
+
+/*! \fn     void cahal_stream_state_end_stop  (
+              cahal_stream_state* io_state
+            )
+    \brief  Moves a STOPPING stream to STOPPED, after which it can be started
+            again.
+
+    \param  io_state  The lifecycle of the stream.
+ */
+void
+cahal_stream_state_end_stop  (
+                              cahal_stream_state* io_state
+                              );
+
+/*! \fn     void cahal_stream_state_end_prepare  (
+              cahal_stream_state* io_state,
+              CPC_BOOL            in_is_prepared
+            )
+    \brief  Moves a STARTING stream that was set up without being started to
+            PAUSED, or back to IDLE.
+
+    \param  io_state  The lifecycle of the stream.
+    \param  in_is_prepared  True if the stream holds resources that
+                            cahal_resume_* starts or cahal_stop_* releases,
+                            false if nothing was set up.
+ */
+void
+cahal_stream_state_end_prepare  (
+                                 cahal_stream_state* io_state,
+                                 CPC_BOOL            in_is_prepared
+                                 );
+
+/*! \fn     CPC_BOOL cahal_stream_state_begin_pause  (
+              cahal_stream_state* io_state
+            )
+    \brief  Moves a RUNNING stream to PAUSING. The caller then owns the stream
+            until it calls cahal_stream_state_end_pause. Callbacks are still
+            accepted, since the callback info stays allocated.
+
+    \param  io_state  The lifecycle of the stream.
+    \return True iff the stream was moved to PAUSING.
+ */
+CPC_BOOL
+cahal_stream_state_begin_pause  (
+                                 cahal_stream_state* io_state
+                                 );
+
+/*! \fn     void cahal_stream_state_end_pause  (
+              cahal_stream_state* io_state,
+              CPC_BOOL            in_is_paused
+            )
+    \brief  Moves a PAUSING stream to PAUSED, or back to RUNNING if the OS
+            stream could not be paused.
+
+    \param  io_state  The lifecycle of the stream.
+    \param  in_is_paused  True iff the OS stream was paused.
+ */
+void
+cahal_stream_state_end_pause  (
+                               cahal_stream_state* io_state,
+                               CPC_BOOL            in_is_paused
+                               );
+
+/*! \fn     CPC_BOOL cahal_stream_state_begin_resume (
+              cahal_stream_state* io_state
+            )
+    \brief  Moves a PAUSED stream to STARTING. The caller then owns the stream
+            until it calls cahal_stream_state_end_resume.
+
+    \param  io_state  The lifecycle of the stream.
+    \return True iff the stream was moved to STARTING.
+ */
+CPC_BOOL
+cahal_stream_state_begin_resume (
+                                 cahal_stream_state* io_state
+                                 );
+
+/*! \fn     void cahal_stream_state_end_resume (
+              cahal_stream_state* io_state,
+              CPC_BOOL            in_is_running
+            )
+    \brief  Moves a resumed STARTING stream to RUNNING, or back to PAUSED if
+            the OS stream could not be started.
+
+    \param  io_state  The lifecycle of the stream.
+    \param  in_is_running True iff the OS stream was started.
+ */
+void
+cahal_stream_state_end_resume (
+                               cahal_stream_state* io_state,
+                               CPC_BOOL            in_is_running
+                               );
+
+/*! \fn     CPC_BOOL cahal_stream_state_begin_configure  (
+              cahal_stream_state* io_state
+            )
+    \brief  Moves an IDLE or STOPPED stream to CONFIGURING. A stream in that
+            state has no callback info and no callbacks, and cannot be started
+            until the caller calls cahal_stream_state_end_configure.
+
+    \param  io_state  The lifecycle of the stream.
+    \return True iff the stream was moved to CONFIGURING.
+ */
+CPC_BOOL
+cahal_stream_state_begin_configure  (
+                                     cahal_stream_state* io_state
+                                     );
+
+/*! \fn     void cahal_stream_state_end_configure  (
+              cahal_stream_state* io_state
+            )
+    \brief  Moves a CONFIGURING stream to IDLE.
+
+    \param  io_state  The lifecycle of the stream.
+ */
+void
+cahal_stream_state_end_configure  (
+                                   cahal_stream_state* io_state
+                                   );
+
+/*! \fn     CPC_BOOL cahal_stream_state_enter_callback (
+              cahal_stream_state* io_state
+            )
+    \brief  Called by an OS callback before it uses the callback info of a
+            stream. Never blocks.
+
+    \param  io_state  The lifecycle of the stream.
+    \return True iff the stream is STARTING, RUNNING, PAUSING or PAUSED, in
+            which case the callback info stays valid until
+            cahal_stream_state_leave_callback is called. False if the
+            callback must not touch the stream.
+ */
+CPC_BOOL
+cahal_stream_state_enter_callback (
+                                   cahal_stream_state* io_state
+                                   );
+
+/*! \fn     void cahal_stream_state_leave_callback (
+              cahal_stream_state* io_state
+            )
+    \brief  Called by an OS callback once it is done with the callback info
+            of a stream it entered.
+
+    \param  io_state  The lifecycle of the stream.
+ */
+void
+cahal_stream_state_leave_callback (
+                                   cahal_stream_state* io_state
+                                   );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_STREAM_STATE_H__ */
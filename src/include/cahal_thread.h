@@ -0,0 +1,437 @@
+/*! \file   cahal_thread.h
+    \brief  Minimal threading primitives (threads, mutexes, condition
+            variables, semaphores and one-time initialisation) used by the
+            common layer. They map onto POSIX threads on Darwin and Android
+            and onto the native primitives on Windows. These are not meant for
+            the real-time audio path: apart from cahal_semaphore_post none of
+            these calls are lock-free.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_THREAD_H__
+#define __CAHAL_THREAD_H__
+
+#include <cpcommon.h>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if defined( __APPLE__ )
+#include <mach/mach.h>
+#elif ! defined( _WIN32 )
+#include <semaphore.h>
+#endif
+
+#include "cahal_atomic.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    cahal_thread_routine
+    \brief  The function prototype of the routine run by a thread.
+
+    \param  in_argument The argument passed to cahal_thread_create.
+ */
+typedef void ( *cahal_thread_routine )( void* in_argument );
+
+/*! \var    cahal_thread
+    \brief  Struct definition for a thread.
+ */
+typedef struct cahal_thread_t
+{
+  /*! \var    handle
+      \brief  OS-specific handle of the thread.
+   */
+#if defined( _WIN32 )
+  HANDLE                handle;
+#else
+  pthread_t             handle;
+#endif
+
+  /*! \var    routine
+      \brief  The routine run by the thread.
+   */
+  cahal_thread_routine  routine;
+
+  /*! \var    argument
+      \brief  The argument passed to routine.
+   */
+  void*                 argument;
+
+} cahal_thread;
+
+/*! \var    cahal_once_states
+    \brief  The states of a one-time initialisation run by cahal_call_once.
+            CAHAL_ONCE_DONE is zero so that zeroed memory needs no
+            initialisation; work that must be deferred is marked
+            CAHAL_ONCE_PENDING explicitly.
+ */
+enum cahal_once_states
+{
+  CAHAL_ONCE_DONE = 0,
+  CAHAL_ONCE_PENDING,
+  CAHAL_ONCE_RUNNING,
+  CAHAL_ONCE_FAILED
+};
+
+/*! \def    cahal_once_routine
+    \brief  The function prototype of a one-time initialisation.
+
+    \param  io_argument The argument passed to cahal_call_once.
+    \return True iff the initialisation succeeded.
+ */
+typedef CPC_BOOL ( *cahal_once_routine )( void* io_argument );
+
+/*! \var    cahal_mutex
+    \brief  Type definition for a (non-recursive) mutex.
+ */
+#if defined( _WIN32 )
+typedef CRITICAL_SECTION    cahal_mutex;
+#else
+typedef pthread_mutex_t     cahal_mutex;
+#endif
+
+/*! \var    cahal_condition
+    \brief  Type definition for a condition variable.
+ */
+#if defined( _WIN32 )
+typedef CONDITION_VARIABLE  cahal_condition;
+#else
+typedef pthread_cond_t      cahal_condition;
+#endif
+
+/*! \var    cahal_semaphore
+    \brief  Type definition for a counting semaphore. Mach semaphores are used
+            on Darwin since it does not implement unnamed POSIX semaphores.
+ */
+#if defined( _WIN32 )
+typedef HANDLE              cahal_semaphore;
+#elif defined( __APPLE__ )
+typedef semaphore_t         cahal_semaphore;
+#else
+typedef sem_t               cahal_semaphore;
+#endif
+
+/*! \var    cahal_thread_policies
+    \brief  The scheduling policies a thread can request. The real-time
+            policies map onto SCHED_FIFO and SCHED_RR on Android (and other
+            POSIX systems), onto the time-constraint policy on Darwin and onto
+            the MMCSS "Pro Audio" task on Windows; the last two make no
+            distinction between FIFO and round-robin.
+ */
+enum cahal_thread_policies
+{
+  CAHAL_THREAD_POLICY_DEFAULT = 0,
+  CAHAL_THREAD_POLICY_FIFO,
+  CAHAL_THREAD_POLICY_ROUND_ROBIN
+};
+
+/*! \var    cahal_thread_policy
+    \brief  Type definition for a value of cahal_thread_policies.
+ */
+typedef UINT32 cahal_thread_policy;
+
+/*! \var    cahal_thread_scheduling
+    \brief  Struct definition for how a thread is to be scheduled.
+ */
+typedef struct cahal_thread_scheduling_t
+{
+  /*! \var    policy
+      \brief  The scheduling policy. CAHAL_THREAD_POLICY_DEFAULT leaves the
+              thread as the OS created it.
+   */
+  cahal_thread_policy policy;
+
+  /*! \var    priority
+      \brief  The real-time priority from 1 (lowest) to 99 (highest). It is
+              clamped to the range the POSIX policy supports and maps onto the
+              four MMCSS priorities on Windows. Ignored on Darwin, where the
+              time-constraint policy is scheduled by its period instead.
+   */
+  UINT32              priority;
+
+  /*! \var    cpu_affinity
+      \brief  The CPUs the thread may run on, bit i standing for CPU i, or 0
+              to let it run on any CPU. Not supported on Darwin.
+   */
+  UINT64              cpu_affinity;
+
+  /*! \var    period
+      \brief  The time (in seconds) between two wake-ups of the thread. Darwin
+              requires it for the time-constraint policy; the thread may use
+              up to half of every period.
+   */
+  FLOAT64             period;
+
+} cahal_thread_scheduling;
+
+/*! \fn     CPC_BOOL cahal_thread_create  (
+              cahal_thread*         out_thread,
+              cahal_thread_routine  in_routine,
+              void*                 in_argument
+            )
+    \brief  Starts a new thread that runs in_routine( in_argument ).
+
+    \param  out_thread  The thread to start. Must remain valid until the thread
+                        has been joined.
+    \param  in_routine  The routine to run.
+    \param  in_argument The argument passed to in_routine.
+    \return True iff the thread was started. Every thread that was started
+            must be joined using cahal_thread_join.
+ */
+CPC_BOOL
+cahal_thread_create  (
+                      cahal_thread*         out_thread,
+                      cahal_thread_routine  in_routine,
+                      void*                 in_argument
+                      );
+
+/*! \fn     void cahal_thread_join (
+              cahal_thread* io_thread
+            )
+    \brief  Waits for the thread to return and releases its resources.
+
+    \param  io_thread The thread to join.
+ */
+void
+cahal_thread_join (
+                   cahal_thread* io_thread
+                   );
+
+/*! \fn     CPC_BOOL cahal_thread_set_scheduling  (
+              const cahal_thread_scheduling* in_scheduling
+            )
+    \brief  Applies in_scheduling to the calling thread. Real-time policies
+            usually need privileges (e.g. CAP_SYS_NICE or RLIMIT_RTPRIO on
+            Linux); when they are refused the thread keeps running as before.
+
+    \param  in_scheduling The scheduling of the thread.
+    \return True iff every part of in_scheduling was applied. Threads that
+            applied a real-time policy must call
+            cahal_thread_reset_scheduling before they return.
+ */
+CPC_BOOL
+cahal_thread_set_scheduling  (
+                              const cahal_thread_scheduling* in_scheduling
+                              );
+
+/*! \fn     void cahal_thread_reset_scheduling( void )
+    \brief  Releases what cahal_thread_set_scheduling acquired for the calling
+            thread (the MMCSS task on Windows). Does nothing on the other
+            platforms.
+ */
+void
+cahal_thread_reset_scheduling( void );
+
+/*! \fn     void cahal_thread_yield( void )
+    \brief  Lets the OS run another thread before the calling thread continues.
+            Used by the waits that are expected to be short enough that
+            yielding is cheaper than blocking on a condition variable.
+ */
+void
+cahal_thread_yield( void );
+
+/*! \fn     CPC_BOOL cahal_mutex_initialize  (
+              cahal_mutex* out_mutex
+            )
+    \brief  Initializes a mutex.
+
+    \param  out_mutex The mutex to initialize.
+    \return True iff the mutex was initialized. Destroy using
+            cahal_mutex_destroy.
+ */
+CPC_BOOL
+cahal_mutex_initialize  (
+                         cahal_mutex* out_mutex
+                         );
+
+/*! \fn     void cahal_mutex_destroy (
+              cahal_mutex* io_mutex
+            )
+    \brief  Destroys a mutex that is not locked.
+
+    \param  io_mutex  The mutex to destroy.
+ */
+void
+cahal_mutex_destroy (
+                     cahal_mutex* io_mutex
+                     );
+
+/*! \fn     void cahal_mutex_lock  (
+              cahal_mutex* io_mutex
+            )
+    \brief  Locks the mutex, blocking until it is available.
+
+    \param  io_mutex  The mutex to lock.
+ */
+void
+cahal_mutex_lock  (
+                   cahal_mutex* io_mutex
+                   );
+
+/*! \fn     void cahal_mutex_unlock  (
+              cahal_mutex* io_mutex
+            )
+    \brief  Unlocks a mutex locked by the calling thread.
+
+    \param  io_mutex  The mutex to unlock.
+ */
+void
+cahal_mutex_unlock  (
+                     cahal_mutex* io_mutex
+                     );
+
+/*! \fn     CPC_BOOL cahal_condition_initialize  (
+              cahal_condition* out_condition
+            )
+    \brief  Initializes a condition variable.
+
+    \param  out_condition The condition variable to initialize.
+    \return True iff the condition variable was initialized. Destroy using
+            cahal_condition_destroy.
+ */
+CPC_BOOL
+cahal_condition_initialize  (
+                             cahal_condition* out_condition
+                             );
+
+/*! \fn     void cahal_condition_destroy (
+              cahal_condition* io_condition
+            )
+    \brief  Destroys a condition variable no thread is waiting on.
+
+    \param  io_condition  The condition variable to destroy.
+ */
+void
+cahal_condition_destroy (
+                         cahal_condition* io_condition
+                         );
+
+/*! \fn     void cahal_condition_wait  (
+              cahal_condition*  io_condition,
+              cahal_mutex*      io_mutex
+            )
+    \brief  Atomically unlocks io_mutex and waits for io_condition to be
+            signalled, then locks io_mutex again. Wake-ups may be spurious so
+            the caller must re-check its predicate.
+
+    \param  io_condition  The condition variable to wait on.
+    \param  io_mutex  The mutex, locked by the calling thread.
+ */
+void
+cahal_condition_wait  (
+                       cahal_condition*  io_condition,
+                       cahal_mutex*      io_mutex
+                       );
+
+/*! \fn     void cahal_condition_signal  (
+              cahal_condition* io_condition
+            )
+    \brief  Wakes one thread waiting on io_condition.
+
+    \param  io_condition  The condition variable to signal.
+ */
+void
+cahal_condition_signal  (
+                         cahal_condition* io_condition
+                         );
+
+/*! \fn     void cahal_condition_broadcast (
+              cahal_condition* io_condition
+            )
+    \brief  Wakes every thread waiting on io_condition.
+
+    \param  io_condition  The condition variable to signal.
+ */
+void
+cahal_condition_broadcast (
+                           cahal_condition* io_condition
+                           );
+
+/*! \fn     CPC_BOOL cahal_semaphore_initialize  (
+              cahal_semaphore* out_semaphore
+            )
+    \brief  Initializes a semaphore with a count of zero.
+
+    \param  out_semaphore The semaphore to initialize.
+    \return True iff the semaphore was initialized. Destroy using
+            cahal_semaphore_destroy.
+ */
+CPC_BOOL
+cahal_semaphore_initialize  (
+                             cahal_semaphore* out_semaphore
+                             );
+
+/*! \fn     void cahal_semaphore_destroy (
+              cahal_semaphore* io_semaphore
+            )
+    \brief  Destroys a semaphore no thread is waiting on.
+
+    \param  io_semaphore  The semaphore to destroy.
+ */
+void
+cahal_semaphore_destroy (
+                         cahal_semaphore* io_semaphore
+                         );
+
+/*! \fn     void cahal_semaphore_post  (
+              cahal_semaphore* io_semaphore
+            )
+    \brief  Increments the count of the semaphore, waking one waiting thread.
+            Never blocks and takes no lock, so it may be called from the OS'
+            real-time audio threads.
+
+    \param  io_semaphore  The semaphore to post.
+ */
+void
+cahal_semaphore_post  (
+                       cahal_semaphore* io_semaphore
+                       );
+
+/*! \fn     void cahal_semaphore_wait  (
+              cahal_semaphore* io_semaphore
+            )
+    \brief  Waits until the count of the semaphore is positive and decrements
+            it.
+
+    \param  io_semaphore  The semaphore to wait on.
+ */
+void
+cahal_semaphore_wait  (
+                       cahal_semaphore* io_semaphore
+                       );
+
+/*! \fn     CPC_BOOL cahal_call_once (
+              cahal_atomic_uint32*  io_state,
+              cahal_once_routine    in_routine,
+              void*                 io_argument
+            )
+    \brief  Runs in_routine( io_argument ) iff io_state is CAHAL_ONCE_PENDING.
+            If several threads call this concurrently exactly one of them runs
+            the routine and the others wait for it to finish, so everything
+            the routine wrote is visible to every caller once this returns.
+
+    \param  io_state  The state of the initialisation, one of
+                      cahal_once_states.
+    \param  in_routine  The initialisation.
+    \param  io_argument The argument passed to in_routine.
+    \return True iff the initialisation has succeeded, now or earlier. A
+            failed initialisation is not retried.
+ */
+CPC_BOOL
+cahal_call_once (
+                 cahal_atomic_uint32*  io_state,
+                 cahal_once_routine    in_routine,
+                 void*                 io_argument
+                 );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_THREAD_H__ */
@@ -0,0 +1,375 @@
+/*! \file   cahal_worker_pool.h
+    \brief  A pool of worker threads that stream callbacks can hand per-period
+            jobs to (e.g. feature extraction or encoding) instead of doing the
+            work inline and overrunning their own deadlines.
+
+            Every stream that submits jobs is registered with the pool along
+            with its period. A job is due one period after it was submitted,
+            which is when the next buffer of the stream arrives. Each worker
+            owns a bounded queue. Jobs of a stream always go to the same
+            queue, so a stream's jobs stay on one worker while the pool is
+            not overloaded. Workers run the job with the earliest deadline in
+            their own queue first. Once their queue is empty they steal the
+            job with the earliest deadline from another worker's queue.
+
+            The pool counts, for every stream, the jobs that completed after
+            their deadline and the jobs that were rejected because the queue
+            was full. Submitting is safe from the OS' audio threads: it takes
+            the lock of one queue for the time needed to copy the job in and
+            posts a semaphore.
+
+    \author Brent Carrara
+ */
+#ifndef __CAHAL_WORKER_POOL_H__
+#define __CAHAL_WORKER_POOL_H__
+
+#include <cpcommon.h>
+
+#include "cahal_atomic.h"
+#include "cahal_thread.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    CAHAL_WORKER_POOL_MAXIMUM_WORKERS
+    \brief  The maximum number of worker threads of a pool.
+ */
+#define CAHAL_WORKER_POOL_MAXIMUM_WORKERS 32
+
+/*! \def    CAHAL_WORKER_POOL_MAXIMUM_STREAMS
+    \brief  The maximum number of streams that can be added to a pool.
+ */
+#define CAHAL_WORKER_POOL_MAXIMUM_STREAMS 64
+
+/*! \def    CAHAL_WORKER_QUEUE_CAPACITY
+    \brief  The number of jobs the queue of each worker can hold.
+ */
+#define CAHAL_WORKER_QUEUE_CAPACITY       64
+
+/*! \def    CAHAL_WORKER_POOL_NO_STREAM
+    \brief  Returned by cahal_worker_pool_add_stream when no stream can be
+            added.
+ */
+#define CAHAL_WORKER_POOL_NO_STREAM       0xFFFFFFFF
+
+/*! \fn     typedef void ( *cahal_worker_routine ) (
+              void*  in_argument,
+              UINT64 in_deadline
+            )
+    \brief  The routine of a job.
+
+    \param  in_argument The argument the job was submitted with.
+    \param  in_deadline The time (ns, see cahal_get_time) by which the job
+                        should be complete, so that it can e.g. skip optional
+                        work when it started late.
+ */
+typedef void ( *cahal_worker_routine )( void* in_argument, UINT64 in_deadline );
+
+/*! \var    cahal_worker_job
+    \brief  Struct definition for a job queued on a worker.
+ */
+typedef struct cahal_worker_job_t
+{
+  /*! \var    routine
+      \brief  The routine to run.
+   */
+  cahal_worker_routine  routine;
+
+  /*! \var    argument
+      \brief  The argument passed to routine.
+   */
+  void*                 argument;
+
+  /*! \var    deadline
+      \brief  The time (ns) by which the job should be complete.
+   */
+  UINT64                deadline;
+
+  /*! \var    stream
+      \brief  The stream that submitted the job.
+   */
+  UINT32                stream;
+
+} cahal_worker_job;
+
+/*! \var    cahal_worker_queue
+    \brief  Struct definition for the queue of one worker. Jobs are not kept
+            in order; the job with the earliest deadline is searched for when
+            one is taken.
+ */
+typedef struct cahal_worker_queue_t
+{
+  /*! \var    lock
+      \brief  Protects jobs and number_of_jobs.
+   */
+  cahal_mutex       lock;
+
+  /*! \var    jobs
+      \brief  The queued jobs.
+   */
+  cahal_worker_job  jobs[ CAHAL_WORKER_QUEUE_CAPACITY ];
+
+  /*! \var    number_of_jobs
+      \brief  The number of elements in jobs.
+   */
+  UINT32            number_of_jobs;
+
+} cahal_worker_queue;
+
+/*! \var    cahal_worker_stream
+    \brief  Struct definition for a stream registered with a pool.
+ */
+typedef struct cahal_worker_stream_t
+{
+  /*! \var    period
+      \brief  The time (ns) between two buffers of the stream.
+   */
+  UINT64              period;
+
+  /*! \var    number_of_jobs
+      \brief  The number of jobs of the stream that completed.
+   */
+  cahal_atomic_uint32 number_of_jobs;
+
+  /*! \var    number_of_misses
+      \brief  The number of jobs that completed after their deadline.
+   */
+  cahal_atomic_uint32 number_of_misses;
+
+  /*! \var    number_of_rejections
+      \brief  The number of jobs that were not queued because the queue was
+              full.
+   */
+  cahal_atomic_uint32 number_of_rejections;
+
+  /*! \var    maximum_lateness
+      \brief  The longest time (us) a job completed after its deadline.
+   */
+  cahal_atomic_uint32 maximum_lateness;
+
+} cahal_worker_stream;
+
+/*! \var    cahal_worker_statistics
+    \brief  Struct definition for the statistics of one stream, as returned by
+            cahal_worker_pool_get_statistics.
+ */
+typedef struct cahal_worker_statistics_t
+{
+  /*! \var    number_of_jobs
+      \brief  The number of jobs that completed.
+   */
+  UINT32  number_of_jobs;
+
+  /*! \var    number_of_misses
+      \brief  The number of jobs that completed after their deadline.
+   */
+  UINT32  number_of_misses;
+
+  /*! \var    number_of_rejections
+      \brief  The number of jobs that were rejected because the queue was full.
+   */
+  UINT32  number_of_rejections;
+
+  /*! \var    maximum_lateness
+      \brief  The longest time (us) a job completed after its deadline.
+   */
+  UINT32  maximum_lateness;
+
+} cahal_worker_statistics;
+
+/*! \var    cahal_worker_pool
+    \brief  Struct definition for a worker pool.
+ */
+typedef struct cahal_worker_pool_t
+{
+  /*! \var    workers
+      \brief  The worker threads.
+   */
+  cahal_thread*           workers;
+
+  /*! \var    queues
+      \brief  The queue of each worker.
+   */
+  cahal_worker_queue*     queues;
+
+  /*! \var    number_of_workers
+      \brief  The number of elements in workers and queues.
+   */
+  UINT32                  number_of_workers;
+
+  /*! \var    number_of_started_workers
+      \brief  Hands each worker the index of its queue.
+   */
+  cahal_atomic_uint32     number_of_started_workers;
+
+  /*! \var    scheduling
+      \brief  The scheduling applied by every worker.
+   */
+  cahal_thread_scheduling scheduling;
+
+  /*! \var    work_available
+      \brief  Posted once for every queued job and once per worker when the
+              pool is freed.
+   */
+  cahal_semaphore         work_available;
+
+  /*! \var    lock
+      \brief  Used with idle to wait for the queued jobs to complete.
+   */
+  cahal_mutex             lock;
+
+  /*! \var    idle
+      \brief  Signalled when the last pending job completes.
+   */
+  cahal_condition         idle;
+
+  /*! \var    number_of_pending_jobs
+      \brief  The number of jobs that are queued or running.
+   */
+  cahal_atomic_uint32     number_of_pending_jobs;
+
+  /*! \var    is_stopping
+      \brief  Set when the pool is freed.
+   */
+  cahal_atomic_uint32     is_stopping;
+
+  /*! \var    streams
+      \brief  The registered streams.
+   */
+  cahal_worker_stream     streams[ CAHAL_WORKER_POOL_MAXIMUM_STREAMS ];
+
+  /*! \var    number_of_streams
+      \brief  The number of streams that have been added.
+   */
+  cahal_atomic_uint32     number_of_streams;
+
+} cahal_worker_pool;
+
+/*! \fn     cahal_worker_pool* cahal_worker_pool_create  (
+              UINT32                          in_number_of_workers,
+              const cahal_thread_scheduling*  in_scheduling
+            )
+    \brief  Creates a pool and starts its workers.
+
+    \param  in_number_of_workers  The number of worker threads, between 1 and
+                                  CAHAL_WORKER_POOL_MAXIMUM_WORKERS. Usually
+                                  the number of cores not busy with audio I/O.
+    \param  in_scheduling The scheduling of the workers (see
+                          cahal_thread_set_scheduling), or NULL to leave them
+                          as the OS created them.
+    \return The pool or NULL on error. Free using cahal_worker_pool_free.
+ */
+cahal_worker_pool*
+cahal_worker_pool_create  (
+                           UINT32                          in_number_of_workers,
+                           const cahal_thread_scheduling*  in_scheduling
+                           );
+
+/*! \fn     UINT32 cahal_worker_pool_add_stream  (
+              cahal_worker_pool* io_pool,
+              FLOAT64            in_period
+            )
+    \brief  Registers a stream whose jobs are due one period after they were
+            submitted.
+
+    \param  io_pool The pool.
+    \param  in_period The time (in seconds) between two buffers of the stream,
+                      e.g. the number of frames per buffer over the sample
+                      rate.
+    \return The identifier of the stream to submit jobs with, or
+            CAHAL_WORKER_POOL_NO_STREAM on error.
+ */
+UINT32
+cahal_worker_pool_add_stream  (
+                               cahal_worker_pool* io_pool,
+                               FLOAT64            in_period
+                               );
+
+/*! \fn     CPC_BOOL cahal_worker_pool_submit  (
+              cahal_worker_pool*    io_pool,
+              UINT32                in_stream,
+              cahal_worker_routine  in_routine,
+              void*                 in_argument
+            )
+    \brief  Queues a job of in_stream, due one period from now.
+
+    \param  io_pool The pool.
+    \param  in_stream The stream returned by cahal_worker_pool_add_stream.
+    \param  in_routine  The routine of the job.
+    \param  in_argument The argument passed to in_routine. It is owned by the
+                        caller, who must keep it valid until the job ran.
+    \return True iff the job was queued. False if the queue of the stream's
+            worker was full, in which case the rejection is counted and the
+            routine will not run.
+ */
+CPC_BOOL
+cahal_worker_pool_submit  (
+                           cahal_worker_pool*    io_pool,
+                           UINT32                in_stream,
+                           cahal_worker_routine  in_routine,
+                           void*                 in_argument
+                           );
+
+/*! \fn     void cahal_worker_pool_wait (
+              cahal_worker_pool* io_pool
+            )
+    \brief  Waits until every queued job has completed.
+
+    \param  io_pool The pool.
+ */
+void
+cahal_worker_pool_wait (
+                        cahal_worker_pool* io_pool
+                        );
+
+/*! \fn     CPC_BOOL cahal_worker_pool_get_statistics  (
+              cahal_worker_pool*        in_pool,
+              UINT32                    in_stream,
+              cahal_worker_statistics*  out_statistics
+            )
+    \brief  Returns the statistics of a stream.
+
+    \param  in_pool The pool.
+    \param  in_stream The stream returned by cahal_worker_pool_add_stream.
+    \param  out_statistics  The statistics of the stream.
+    \return True iff the stream exists.
+ */
+CPC_BOOL
+cahal_worker_pool_get_statistics  (
+                                   cahal_worker_pool*        in_pool,
+                                   UINT32                    in_stream,
+                                   cahal_worker_statistics*  out_statistics
+                                   );
+
+/*! \fn     void cahal_worker_pool_print_statistics  (
+              cahal_worker_pool* in_pool
+            )
+    \brief  Logs the statistics of every stream at CPC_LOG_LEVEL_INFO.
+
+    \param  in_pool The pool.
+ */
+void
+cahal_worker_pool_print_statistics  (
+                                     cahal_worker_pool* in_pool
+                                     );
+
+/*! \fn     void cahal_worker_pool_free (
+              cahal_worker_pool* in_pool
+            )
+    \brief  Waits for the queued jobs to complete, stops the workers and frees
+            the pool. No jobs may be submitted during or after this call.
+
+    \param  in_pool The pool to free.
+ */
+void
+cahal_worker_pool_free (
+                        cahal_worker_pool* in_pool
+                        );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*  __CAHAL_WORKER_POOL_H__ */
@@ -8,6 +8,7 @@
 
 #include <CoreFoundation/CoreFoundation.h>
 #include <AudioToolbox/AudioToolbox.h>
+#include <mach/mach_time.h>
 
 #include <darwin_helper.h>
 
@@ -15,6 +16,7 @@
 #include "cahal_device.h"
 #include "cahal_device_stream.h"
 #include "cahal_audio_format_flags.h"
+#include "cahal_callback.h"
 
 #include "darwin_cahal_audio_format_flags.h"
 #include "darwin_cahal_audio_format_description.h"
@@ -41,8 +43,35 @@ typedef struct darwin_context_t
    */
   AudioQueueBufferRef*  audio_buffers;
   
+  /*! \var    queued_bytes
+      \brief  The number of bytes in the playback buffers that have been
+              enqueued and not yet played back.
+   */
+  UINT32                queued_bytes;
+  
+  /*! \var    latency_bytes
+      \brief  The number of bytes the output device holds between the audio
+              queue and the speaker, i.e. its latency.
+   */
+  UINT32                latency_bytes;
+  
 } darwin_context;
 
+/*! \fn     FLOAT64 darwin_get_output_latency  (
+              cahal_device* in_device
+            )
+    \brief  Returns the time between the audio queue handing a buffer to
+            in_device and the device playing it back. Implemented by the OSX
+            and iOS platforms.
+ 
+    \param  in_device The output device.
+    \return The latency in seconds, or 0 if it is not known.
+ */
+FLOAT64
+darwin_get_output_latency  (
+                            cahal_device* in_device
+                            );
+
 /*! \fn     void darwin_recorder_callback  (
               void*                                in_user_data,
               AudioQueueRef                        in_queue,
@@ -84,6 +113,39 @@ darwin_recorder_callback  (
                       const AudioStreamPacketDescription*  in_packet_description
                         );
 
+/*! \fn     void darwin_aggregate_recorder_callback  (
+              void*                                in_user_data,
+              AudioQueueRef                        in_queue,
+              AudioQueueBufferRef                  in_buffer,
+              const AudioTimeStamp*                in_start_time,
+              UINT32                               in_number_of_packets,
+              const AudioStreamPacketDescription*  in_packet_description
+            )
+    \brief  The callback passed to the Core Audio library for the members of
+            an aggregate recording. Hands the buffer, with the host time it
+            was recorded at, to cahal_aggregate_push.
+ 
+    \param  in_user_data  The cahal_recorder_info of the member, whose user
+                          data is the cahal_aggregate_member.
+    \param  in_queue  A reference to the queue containing the buffer of recorded
+                      samples.
+    \param  in_buffer The buffer of recorded samples.
+    \param  in_start_time Timestamp the recording was made at.
+    \param  in_number_of_packets  The number of packets in the recording.
+    \param  in_packet_description Format information for the packet. Only used
+                                  with VBR codecs. Always null in CBR cases.
+ */
+static
+void
+darwin_aggregate_recorder_callback  (
+                      void*                                in_user_data,
+                      AudioQueueRef                        in_queue,
+                      AudioQueueBufferRef                  in_buffer,
+                      const AudioTimeStamp*                in_start_time,
+                      UINT32                               in_number_of_packets,
+                      const AudioStreamPacketDescription*  in_packet_description
+                                  );
+
 /*! \fn     void darwin_playback_callback (
               void*                in_user_data,
               AudioQueueRef        in_queue,
@@ -172,6 +234,7 @@ darwin_compute_bytes_per_buffer  (
 /*! \fn     OSStatus darwin_configure_input_audio_queue (
               cahal_device*                 in_device,
               cahal_recorder_info*          in_callback_info,
+              AudioQueueInputCallback       in_callback,
               AudioStreamBasicDescription*  io_asbd,
               AudioQueueRef*                out_audio_queue
             )
@@ -180,6 +243,8 @@ darwin_compute_bytes_per_buffer  (
     \param  in_device The recording device.
     \param  in_callback_info  The callback that is called by the system when
                               a buffer of samples is ready for processing.
+    \param  in_callback The callback passed to the audio queue, with
+                        in_callback_info as its user data.
     \param  io_asbd The ASDB containing all the format and endocing information.
                     This value is somteimes updated by the queue when format
                     parameters are changed.
@@ -190,6 +255,7 @@ OSStatus
 darwin_configure_input_audio_queue (
                                  cahal_device*                 in_device,
                                  cahal_recorder_info*          in_callback_info,
+                                 AudioQueueInputCallback       in_callback,
                                  AudioStreamBasicDescription*  io_asbd,
                                  AudioQueueRef*                out_audio_queue
                                  );
@@ -284,4 +350,70 @@ darwin_free_context (
                      darwin_context* io_context
                      );
 
+/*! \fn     OSStatus darwin_drain_context  (
+              darwin_context* io_context
+            )
+    \brief  Stops the audio queue of io_context once it has played the
+            buffers that are enqueued, waiting for at most
+            CAHAL_DRAIN_TIMEOUT. The playback must be stopping, so that the
+            playback callback does not enqueue the buffers again.
+ 
+    \param  io_context  The audio queue to drain.
+    \return noErr(0) if the queue was stopped, an appropriate error code
+            otherwise.
+ */
+OSStatus
+darwin_drain_context  (
+                       darwin_context* io_context
+                       );
+
+/*! \fn     OSStatus darwin_pause_context (
+              darwin_context* io_context
+            )
+    \brief  Pauses the audio queue of io_context, keeping its buffers.
+ 
+    \param  io_context  The audio queue to pause.
+    \return noErr(0) if the queue was paused, an appropriate error code
+            otherwise.
+ */
+OSStatus
+darwin_pause_context (
+                      darwin_context* io_context
+                      );
+
+/*! \fn     OSStatus darwin_resume_context  (
+              darwin_context* io_context
+            )
+    \brief  Starts the paused (or never started) audio queue of io_context.
+ 
+    \param  io_context  The audio queue to start.
+    \return noErr(0) if the queue was started, an appropriate error code
+            otherwise.
+ */
+OSStatus
+darwin_resume_context  (
+                        darwin_context* io_context
+                        );
+
+/*! \fn     OSStatus darwin_set_audio_queue_channel_layout  (
+              AudioQueueRef               io_audio_queue,
+              const cahal_channel_layout* in_channel_layout
+            )
+    \brief  Sets the channel layout of io_audio_queue to in_channel_layout.
+            Speaker layouts are passed as a channel bitmap and discrete layouts
+            as one discrete channel label per array element. Queues of one or
+            two channels keep the layout implied by their ASBD.
+ 
+    \param  io_audio_queue  The queue whose layout is set.
+    \param  in_channel_layout The layout of the frames exchanged with the
+                              queue.
+    \return noErr(0) if the layout is set or left implied, an appropriate error
+            code otherwise.
+ */
+OSStatus
+darwin_set_audio_queue_channel_layout  (
+                                  AudioQueueRef               io_audio_queue,
+                                  const cahal_channel_layout* in_channel_layout
+                                        );
+
 #endif  /*  __DARWIN_CAHAL_DEVICE_H__ */
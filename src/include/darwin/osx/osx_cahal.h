@@ -1,11 +1,11 @@
 /*! \file   osx_cahal.h
     \brief  Provides access at the top level (the device level) to the platform
             specific audio devices (both input and output). The exposed method
-            cahal_get_device_list is defined in the implementation of this
+            cahal_query_device_list is defined in the implementation of this
             header in a platform specific way. The prototype however is defined
-            in cahal.h, which is an exposed header file. The interface is
-            platform agnostic even though the gathering of device information is
-            platform specific.
+            in cahal_device_snapshot.h, which is an exposed header file. The
+            interface is platform agnostic even though the gathering of device
+            information is platform specific.
  
     \author Brent Carrara
  */
@@ -48,14 +48,53 @@ osx_get_audio_device_handles (
     \brief  Generates and returns a new list of devices from the OS. This
             function only needs to be called once to generate the list.
  
-    \note   The library does not currently supported automatic updating of this
-            list. That is, if a device is plugged in to the system (e.g. USB
-            headset) after the list is generated it will not be included in
-            the listing returned by this call.
+    \note   The list returned is not updated. Devices plugged in afterwards
+            (e.g. a USB headset) are picked up by the refresh the listeners
+            of osx_add_device_change_listeners schedule.
  
     \return A list of input and output devices supported by the OS.
  */
 cahal_device**
 osx_get_device_list( void );
 
+/*! \fn     void osx_add_device_change_listeners( void )
+    \brief  Listens for devices being added or removed and for changes of the
+            default input and output devices, scheduling a refresh of the
+            device list (see cahal_schedule_device_list_refresh) whenever one
+            is notified. Called by cahal_initialize.
+ */
+void
+osx_add_device_change_listeners( void );
+
+/*! \fn     void osx_remove_device_change_listeners( void )
+    \brief  Removes the listeners added by osx_add_device_change_listeners.
+            Called by cahal_terminate.
+ */
+void
+osx_remove_device_change_listeners( void );
+
+/*! \fn     OSStatus osx_device_change_listener  (
+              AudioObjectID                      in_object,
+              UINT32                             in_number_of_addresses,
+              const AudioObjectPropertyAddress*  in_addresses,
+              void*                              in_user_data
+            )
+    \brief  The AudioObjectPropertyListenerProc of the device change
+            listeners. Runs on a thread of the HAL, so it only schedules the
+            refresh.
+ 
+    \param  in_object The system object.
+    \param  in_number_of_addresses  The number of elements of in_addresses.
+    \param  in_addresses  The properties that changed.
+    \param  in_user_data  Unused.
+    \return Always noErr.
+ */
+OSStatus
+osx_device_change_listener  (
+                    AudioObjectID                      in_object,
+                    UINT32                             in_number_of_addresses,
+                    const AudioObjectPropertyAddress*  in_addresses,
+                    void*                              in_user_data
+                             );
+
 #endif /* __OSX_CAHAL_H__ */
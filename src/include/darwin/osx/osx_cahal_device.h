@@ -25,9 +25,11 @@
               cahal_device* io_device
             )
     \brief  Populate the given io_device struct with the parameters of the
-            audio hardware object defined by in_device_id. Note that this 
-            function will catalogue all the supported streams of the device
-            as well as all of the supported formats.
+            audio hardware object defined by in_device_id. Only the name, the
+            UID and the handles and directions of the streams are read here.
+            The remaining properties are read by osx_load_cahal_device_details,
+            either immediately or, if g_cahal_lazy_device_details is set, on
+            the first call to cahal_load_device_details.
  
     \param  in_device_id  The device handle whose properties are to be populated
                           in io_device.
@@ -40,6 +42,25 @@ osx_set_cahal_device_struct(
                             cahal_device* io_device
                             );
 
+/*! \fn     CPC_BOOL osx_load_cahal_device_details(
+              cahal_device* io_device
+            )
+    \brief  Reads the properties of io_device that osx_set_cahal_device_struct
+            left out: model, manufacturer, serial number, version, model UID,
+            the preferred sample rate and number of channels, the alive and
+            running flags, the supported sample rates and the preferred and
+            supported formats of every stream. This is the details_loader of
+            lazily enumerated devices.
+ 
+    \param  io_device The device populated by osx_set_cahal_device_struct.
+    \return True iff every property could be read. Properties that could not
+            be read are left unset.
+ */
+CPC_BOOL
+osx_load_cahal_device_details(
+                              cahal_device* io_device
+                              );
+
 /*! \fn     OSStatus osx_get_device_uint32_property  (
               AudioObjectID                in_device_id,
               AudioObjectPropertySelector  in_property,
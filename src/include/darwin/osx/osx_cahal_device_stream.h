@@ -48,10 +48,10 @@ osx_get_device_streams  (
               AudioStreamID          in_device_stream_id,
               cahal_device_stream*   io_device_stream
             )
-    \brief  Populates io_device_stream with all the stream's properties by
-            querying the properties of the passed in stream handler as well as
-            the preferred and supportd audio formats that the stream referenced
-            by in_device_stream_id points to.
+    \brief  Populates the handle and direction of io_device_stream. The
+            preferred and supported audio formats are details of the device
+            and are read by osx_get_device_stream_supported_formats when the
+            device's details are loaded (see osx_load_cahal_device_details).
  
     \param  in_device_stream_id The id whose properties are to be queried and
                                 populated in in_device_stream.
@@ -0,0 +1,21 @@
+/*! \file   replay_cahal.h
+    \brief  Entry for the backend-free CAHAL API, built on hosts without a
+            supported audio API (e.g. Linux) so that the common layer can be
+            built and tested there. The device list is served from the replay
+            file (see cahal_set_device_replay_file) and is empty otherwise.
+
+    \author Brent Carrara
+ */
+#ifndef __REPLAY_CAHAL_H__
+#define __REPLAY_CAHAL_H__
+
+#include <time.h>
+#include <string.h>
+
+#include <cpcommon.h>
+
+#include "cahal.h"
+
+#include "replay_cahal_device.h"
+
+#endif  /*  __REPLAY_CAHAL_H__ */
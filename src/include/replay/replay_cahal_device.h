@@ -0,0 +1,68 @@
+/*! \file   replay_cahal_device.h
+    \brief  Streams of the backend-free CAHAL API. There is no audio device,
+            so a stream runs on a simulated device: a thread that records
+            silence or discards the played samples, one buffer every
+            REPLAY_BUFFER_DURATION, on any device with a stream in the
+            direction asked for (e.g. one served from a replay file). This
+            drives the common layer exactly as the OS would.
+
+    \author Brent Carrara
+ */
+#ifndef __REPLAY_CAHAL_DEVICE_H__
+#define __REPLAY_CAHAL_DEVICE_H__
+
+#include <string.h>
+
+#include <cpcommon.h>
+
+#include "cahal.h"
+#include "cahal_callback.h"
+
+/*! \def    REPLAY_BUFFER_DURATION
+    \brief  The amount of time (in seconds) covered by each buffer of the
+            simulated device. Much shorter than CAHAL_QUEUE_BUFFER_DURATION
+            so that short-lived streams still see callbacks.
+ */
+#define REPLAY_BUFFER_DURATION  0.01
+
+/*! \def    REPLAY_POLL_INTERVAL
+    \brief  The time (in milliseconds) the simulated device sleeps between
+            checks of whether a buffer is due or the stream was stopped.
+ */
+#define REPLAY_POLL_INTERVAL    1
+
+/*! \var    replay_callback_info
+    \brief  The simulated device of a stream, stored in the platform_data of
+            its cahal_recorder_info or cahal_playback_info.
+ */
+typedef struct replay_callback_info_t
+{
+  /*! \var    thread
+      \brief  Stands in for the OS audio thread.
+   */
+  cahal_thread        thread;
+
+  /*! \var    is_running
+      \brief  Cleared to make thread return.
+   */
+  cahal_atomic_uint32 is_running;
+
+  /*! \var    is_paused
+      \brief  Set while the stream is paused, in which case the buffers that
+              fall due are skipped.
+   */
+  cahal_atomic_uint32 is_paused;
+
+  /*! \var    buffer
+      \brief  The buffer handed to the common layer.
+   */
+  UCHAR*              buffer;
+
+  /*! \var    buffer_size
+      \brief  The size of buffer in bytes.
+   */
+  UINT32              buffer_size;
+
+} replay_callback_info;
+
+#endif  /*  __REPLAY_CAHAL_DEVICE_H__ */
@@ -17,6 +17,7 @@
 
 #include "cahal.h"
 #include "cahal_device.h"
+#include "cahal_callback.h"
 
 #include "windows_cahal_device_stream.hpp"
 
@@ -40,6 +41,22 @@ extern "C"
 cahal_device**
 windows_get_device_list( void );
 
+/*! \fn     void windows_register_device_notifications( void )
+    \brief  Registers for notifications of devices being added, removed,
+            enabled or disabled and of default device changes, each of which
+            schedules a refresh of the device list. Called by
+            cahal_initialize once COM is initialized.
+ */
+void
+windows_register_device_notifications( void );
+
+/*! \fn     void windows_unregister_device_notifications( void )
+    \brief  Undoes windows_register_device_notifications. Called by
+            cahal_terminate before COM is uninitialized.
+ */
+void
+windows_unregister_device_notifications( void );
+
 #ifdef __cplusplus
 }
 #endif
@@ -11,6 +11,8 @@
 #include <mmdeviceapi.h>
 
 #include <Audioclient.h>
+#include <mmreg.h>
+#include <ksmedia.h>
 
 #include "cahal.h"
 #include "cahal_device.h"
@@ -39,4 +41,32 @@ windows_set_device_streams(
   IMMDevice*    in_endpoint
 );
 
+/*! \fn     void windows_set_wave_format(
+              UINT32                      in_number_of_channels,
+              UINT32                      in_sample_rate,
+              UINT32                      in_bits_per_sample,
+              const cahal_channel_layout* in_channel_layout,
+              WAVEFORMATEXTENSIBLE*       out_format
+            );
+    \brief  Describes linear PCM samples to WASAPI. Mono and stereo 8- and
+            16-bit formats are plain WAVEFORMATEX structs, all others are
+            extensible so that the channel layout can be passed: speaker
+            layouts as dwChannelMask and discrete layouts as
+            KSAUDIO_SPEAKER_DIRECTOUT (no speaker positions).
+
+    \param  in_number_of_channels The number of channels in the format.
+    \param  in_sample_rate  The sample rate of the format.
+    \param  in_bits_per_sample  The bit depth of the format.
+    \param  in_channel_layout The layout of the channels.
+    \param  out_format  The format. Pass &out_format->Format to WASAPI.
+ */
+void
+windows_set_wave_format(
+  UINT32                      in_number_of_channels,
+  UINT32                      in_sample_rate,
+  UINT32                      in_bits_per_sample,
+  const cahal_channel_layout* in_channel_layout,
+  WAVEFORMATEXTENSIBLE*       out_format
+);
+
 #endif  /*  __WINDOWS_CAHAL_DEVICE_STREAM_H__ */
@@ -0,0 +1,116 @@
+/*! \file   replay_cahal.c
+
+    \author Brent Carrara
+ */
+#include "replay/replay_cahal.h"
+
+void
+cahal_initialize( void )
+{
+  UINT32 stage = cahal_profile_begin( "cahal_initialize" );
+
+  if  (
+      CAHAL_ATOMIC_COMPARE_AND_SWAP  (
+          &g_cahal_state,
+          CAHAL_STATE_NOT_INITIALIZED,
+          CAHAL_STATE_INITIALIZED
+          )
+      )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_INFO, "Initialized CAHAL (replay)." );
+  }
+  else
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_WARN, "CAHAL is already intialized" );
+  }
+
+  cahal_profile_end( stage );
+}
+
+void
+cahal_terminate( void )
+{
+  switch( CAHAL_ATOMIC_LOAD( &g_cahal_state ) )
+  {
+    case CAHAL_STATE_NOT_INITIALIZED:
+      CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "CAHAL has not been initialized" );
+      break;
+    case CAHAL_STATE_TERMINATED:
+      CPC_LOG_STRING  (
+          CPC_LOG_LEVEL_WARN,
+          "CAHAL has already been terminated"
+          );
+      break;
+    case CAHAL_STATE_INITIALIZED:
+      if  (
+          CAHAL_ATOMIC_COMPARE_AND_SWAP  (
+              &g_cahal_state,
+              CAHAL_STATE_INITIALIZED,
+              CAHAL_STATE_TERMINATED
+              )
+          )
+      {
+        //  Queued starts and stops run before the streams are stopped
+        cahal_async_terminate();
+
+        cahal_stop_recording();
+        cahal_stop_playback();
+
+        cahal_free_device_list();
+
+        CPC_LOG_STRING( CPC_LOG_LEVEL_INFO, "CAHAL has terminated" );
+      }
+      break;
+  }
+}
+
+cahal_device**
+cahal_query_device_list (
+    cahal_device_list_callback  in_callback,
+    void*                       in_user_data
+                         )
+{
+  cahal_device** device_list = NULL;
+
+  //  Without an OS to query, devices only come from a replay file, which
+  //  cahal_get_device_list reads without calling this.
+  if  (
+      CPC_ERROR_CODE_NO_ERROR
+      != cpc_safe_malloc( ( void** ) &device_list, sizeof( cahal_device* ) )
+      )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc device list." );
+  }
+
+  return( device_list );
+}
+
+void
+cahal_sleep (
+    UINT32 in_sleep_time
+            )
+{
+  struct timespec sleep_info;
+
+  memset( &sleep_info, 0x0, sizeof( struct timespec ) );
+
+  sleep_info.tv_sec   = in_sleep_time / 1000;
+  sleep_info.tv_nsec  = ( in_sleep_time % 1000 ) * 1000000;
+
+  nanosleep( &sleep_info, NULL );
+}
+
+UINT64
+cahal_get_time( void )
+{
+  struct timespec time_info;
+
+  memset( &time_info, 0x0, sizeof( struct timespec ) );
+
+  clock_gettime( CLOCK_MONOTONIC, &time_info );
+
+  return  (
+           ( UINT64 ) time_info.tv_sec * 1000000000ULL
+           + ( UINT64 ) time_info.tv_nsec
+           );
+}
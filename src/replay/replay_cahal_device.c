@@ -0,0 +1,893 @@
+/*! \file   replay_cahal_device.c
+
+    \author Brent Carrara
+ */
+#include "replay/replay_cahal_device.h"
+
+cahal_recorder_info* g_recorder_callback_info = NULL;
+cahal_playback_info* g_playback_callback_info = NULL;
+
+/*! \fn     CPC_BOOL replay_start_recording (
+              cahal_device*            in_device,
+              cahal_audio_format_id    in_format_id,
+              UINT32                   in_number_of_channels,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              cahal_recorder_callback  in_recorder,
+              void*                    in_callback_user_data,
+              cahal_audio_format_flag  in_format_flags,
+              CPC_BOOL                 in_is_prepared
+            )
+    \brief  Starts the recording on a simulated device, paused if
+            in_is_prepared is set. Shared by cahal_start_recording and
+            cahal_prepare_recording, whose parameters are documented there.
+
+    \return True iff the recording was started.
+ */
+static
+CPC_BOOL
+replay_start_recording (
+    cahal_device*            in_device,
+    cahal_audio_format_id    in_format_id,
+    UINT32                   in_number_of_channels,
+    FLOAT64                  in_sample_rate,
+    UINT32                   in_bit_depth,
+    cahal_recorder_callback  in_recorder,
+    void*                    in_callback_user_data,
+    cahal_audio_format_flag  in_format_flags,
+    CPC_BOOL                 in_is_prepared
+                       );
+
+/*! \fn     CPC_BOOL replay_start_playback  (
+              cahal_device*            in_device,
+              cahal_audio_format_id    in_format_id,
+              UINT32                   in_number_of_channels,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              cahal_playback_callback  in_playback,
+              void*                    in_callback_user_data,
+              cahal_audio_format_flag  in_format_flags,
+              CPC_BOOL                 in_is_prepared
+            )
+    \brief  Starts the playback on a simulated device, paused if
+            in_is_prepared is set. Shared by cahal_start_playback and
+            cahal_prepare_playback, whose parameters are documented there.
+
+    \return True iff the playback was started.
+ */
+static
+CPC_BOOL
+replay_start_playback  (
+    cahal_device*            in_device,
+    cahal_audio_format_id    in_format_id,
+    UINT32                   in_number_of_channels,
+    FLOAT64                  in_sample_rate,
+    UINT32                   in_bit_depth,
+    cahal_playback_callback  in_playback,
+    void*                    in_callback_user_data,
+    cahal_audio_format_flag  in_format_flags,
+    CPC_BOOL                 in_is_prepared
+                       );
+
+/*! \fn     CPC_BOOL replay_create_device  (
+              UINT32                in_number_of_channels,
+              FLOAT64               in_sample_rate,
+              UINT32                in_bit_depth,
+              cahal_thread_routine  in_routine,
+              void*                 in_stream_info,
+              void**                out_platform_data
+            )
+    \brief  Starts a paused simulated device whose thread runs in_routine on
+            in_stream_info. The caller resumes it once the stream is set up.
+
+    \param  in_number_of_channels The number of channels per frame.
+    \param  in_sample_rate  The sample rate.
+    \param  in_bit_depth  The quantization level of the samples.
+    \param  in_routine  The thread routine, replay_recorder_thread or
+                        replay_playback_thread.
+    \param  in_stream_info  The cahal_recorder_info or cahal_playback_info
+                            of the stream.
+    \param  out_platform_data The platform_data of in_stream_info. Set to the
+                              replay_callback_info of the device before its
+                              thread starts, even if it then fails to.
+    \return True iff the device was started.
+ */
+static
+CPC_BOOL
+replay_create_device  (
+    UINT32                in_number_of_channels,
+    FLOAT64               in_sample_rate,
+    UINT32                in_bit_depth,
+    cahal_thread_routine  in_routine,
+    void*                 in_stream_info,
+    void**                out_platform_data
+                      );
+
+/*! \fn     void replay_free_device (
+              replay_callback_info** io_callback_info
+            )
+    \brief  Stops the thread of a simulated device, waits for it to return
+            and frees the device.
+
+    \param  io_callback_info  The device, set to NULL. May point to NULL.
+ */
+static
+void
+replay_free_device (
+    replay_callback_info** io_callback_info
+                   );
+
+/*! \fn     CPC_BOOL replay_set_paused (
+              cahal_stream_state*     io_state,
+              replay_callback_info*   io_callback_info,
+              CPC_BOOL                in_is_paused
+            )
+    \brief  Pauses or resumes the simulated device of the stream whose state
+            is io_state.
+
+    \param  io_state  The state of the stream.
+    \param  io_callback_info  The simulated device of the stream.
+    \param  in_is_paused  True to pause, false to resume.
+    \return True iff the stream was paused or resumed.
+ */
+static
+CPC_BOOL
+replay_set_paused (
+    cahal_stream_state*     io_state,
+    replay_callback_info*   io_callback_info,
+    CPC_BOOL                in_is_paused
+                  );
+
+/*! \fn     void replay_recorder_thread (
+              void* in_recorder_info
+            )
+    \brief  The thread of the simulated input device. Records a buffer of
+            silence every REPLAY_BUFFER_DURATION until it is stopped or the
+            recording refuses a buffer.
+
+    \param  in_recorder_info  The callback info of the recording, handed over
+                              the way the OS hands it to its callbacks.
+ */
+static
+void
+replay_recorder_thread (
+    void* in_recorder_info
+                       );
+
+/*! \fn     void replay_playback_thread (
+              void* in_playback_info
+            )
+    \brief  The thread of the simulated output device. Asks for a buffer
+            every REPLAY_BUFFER_DURATION and discards it, until it is stopped
+            or the playback returns false.
+
+    \param  in_playback_info  The callback info of the playback, handed over
+                              the way the OS hands it to its callbacks.
+ */
+static
+void
+replay_playback_thread (
+    void* in_playback_info
+                       );
+
+CPC_BOOL
+cahal_start_recording  (
+                        cahal_device*            in_device,
+                        cahal_audio_format_id    in_format_id,
+                        UINT32                   in_number_of_channels,
+                        FLOAT64                  in_sample_rate,
+                        UINT32                   in_bit_depth,
+                        cahal_recorder_callback  in_recorder,
+                        void*                    in_callback_user_data,
+                        cahal_audio_format_flag  in_format_flags
+                        )
+{
+  return  (
+      replay_start_recording (
+          in_device,
+          in_format_id,
+          in_number_of_channels,
+          in_sample_rate,
+          in_bit_depth,
+          in_recorder,
+          in_callback_user_data,
+          in_format_flags,
+          CPC_FALSE
+          )
+      );
+}
+
+CPC_BOOL
+cahal_prepare_recording  (
+                          cahal_device*            in_device,
+                          cahal_audio_format_id    in_format_id,
+                          UINT32                   in_number_of_channels,
+                          FLOAT64                  in_sample_rate,
+                          UINT32                   in_bit_depth,
+                          cahal_recorder_callback  in_recorder,
+                          void*                    in_callback_user_data,
+                          cahal_audio_format_flag  in_format_flags
+                          )
+{
+  return  (
+      replay_start_recording (
+          in_device,
+          in_format_id,
+          in_number_of_channels,
+          in_sample_rate,
+          in_bit_depth,
+          in_recorder,
+          in_callback_user_data,
+          in_format_flags,
+          CPC_TRUE
+          )
+      );
+}
+
+CPC_BOOL
+cahal_start_playback  (
+                       cahal_device*            in_device,
+                       cahal_audio_format_id    in_format_id,
+                       UINT32                   in_number_of_channels,
+                       FLOAT64                  in_sample_rate,
+                       UINT32                   in_bit_depth,
+                       FLOAT32                  in_volume,
+                       cahal_playback_callback  in_playback,
+                       void*                    in_callback_user_data,
+                       cahal_audio_format_flag  in_format_flags
+                       )
+{
+  return  (
+      replay_start_playback  (
+          in_device,
+          in_format_id,
+          in_number_of_channels,
+          in_sample_rate,
+          in_bit_depth,
+          in_playback,
+          in_callback_user_data,
+          in_format_flags,
+          CPC_FALSE
+          )
+      );
+}
+
+CPC_BOOL
+cahal_prepare_playback  (
+                         cahal_device*            in_device,
+                         cahal_audio_format_id    in_format_id,
+                         UINT32                   in_number_of_channels,
+                         FLOAT64                  in_sample_rate,
+                         UINT32                   in_bit_depth,
+                         FLOAT32                  in_volume,
+                         cahal_playback_callback  in_playback,
+                         void*                    in_callback_user_data,
+                         cahal_audio_format_flag  in_format_flags
+                         )
+{
+  return  (
+      replay_start_playback  (
+          in_device,
+          in_format_id,
+          in_number_of_channels,
+          in_sample_rate,
+          in_bit_depth,
+          in_playback,
+          in_callback_user_data,
+          in_format_flags,
+          CPC_TRUE
+          )
+      );
+}
+
+CPC_BOOL
+cahal_pause_recording( void )
+{
+  return  (
+      replay_set_paused (
+          &g_cahal_recording_state,
+          NULL != g_recorder_callback_info
+          ? g_recorder_callback_info->platform_data
+          : NULL,
+          CPC_TRUE
+          )
+      );
+}
+
+CPC_BOOL
+cahal_resume_recording( void )
+{
+  return  (
+      replay_set_paused (
+          &g_cahal_recording_state,
+          NULL != g_recorder_callback_info
+          ? g_recorder_callback_info->platform_data
+          : NULL,
+          CPC_FALSE
+          )
+      );
+}
+
+CPC_BOOL
+cahal_pause_playback( void )
+{
+  return  (
+      replay_set_paused (
+          &g_cahal_playback_state,
+          NULL != g_playback_callback_info
+          ? g_playback_callback_info->platform_data
+          : NULL,
+          CPC_TRUE
+          )
+      );
+}
+
+CPC_BOOL
+cahal_resume_playback( void )
+{
+  return  (
+      replay_set_paused (
+          &g_cahal_playback_state,
+          NULL != g_playback_callback_info
+          ? g_playback_callback_info->platform_data
+          : NULL,
+          CPC_FALSE
+          )
+      );
+}
+
+CPC_BOOL
+cahal_stop_recording( void )
+{
+  CPC_BOOL result = CPC_FALSE;
+
+  if( cahal_stream_state_begin_stop( &g_cahal_recording_state, NULL ) )
+  {
+    replay_free_device  (
+        ( replay_callback_info** ) &( g_recorder_callback_info->platform_data )
+        );
+
+    cahal_stream_state_wait_for_callbacks( &g_cahal_recording_state );
+
+    cahal_detach_recording_dispatcher( g_recorder_callback_info );
+
+    cahal_detach_recording_coalescer( g_recorder_callback_info );
+
+    cpc_safe_free( ( void** ) &( g_recorder_callback_info ) );
+
+    cahal_stream_state_end_stop( &g_cahal_recording_state );
+
+    result = CPC_TRUE;
+  }
+  else
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Recording is not running." );
+  }
+
+  return( result );
+}
+
+CPC_BOOL
+cahal_stop_playback( void )
+{
+  CPC_BOOL result = CPC_FALSE;
+
+  if( cahal_stream_state_begin_stop( &g_cahal_playback_state, NULL ) )
+  {
+    replay_free_device  (
+        ( replay_callback_info** ) &( g_playback_callback_info->platform_data )
+        );
+
+    cahal_stream_state_wait_for_callbacks( &g_cahal_playback_state );
+
+    cahal_detach_playback_dispatcher( g_playback_callback_info );
+
+    cahal_detach_playback_schedule( g_playback_callback_info );
+
+    cpc_safe_free( ( void** ) &( g_playback_callback_info ) );
+
+    cahal_stream_state_end_stop( &g_cahal_playback_state );
+
+    result = CPC_TRUE;
+  }
+  else
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Playback is not running." );
+  }
+
+  return( result );
+}
+
+CPC_BOOL
+cahal_drain_playback( void )
+{
+  //  The simulated device plays every buffer as soon as it asks for it, so
+  //  nothing is left queued
+  return( cahal_stop_playback() );
+}
+
+CPC_BOOL
+cahal_start_aggregate_member  (
+    cahal_aggregate_member* io_member,
+    UINT64                  in_start_time
+                              )
+{
+  CPC_LOG_STRING  (
+      CPC_LOG_LEVEL_ERROR,
+      "Aggregate recordings are not supported without an audio API."
+                  );
+
+  return( CPC_FALSE );
+}
+
+void
+cahal_stop_aggregate_member (
+    cahal_aggregate_member* io_member
+                            )
+{
+}
+
+static
+CPC_BOOL
+replay_start_recording (
+    cahal_device*            in_device,
+    cahal_audio_format_id    in_format_id,
+    UINT32                   in_number_of_channels,
+    FLOAT64                  in_sample_rate,
+    UINT32                   in_bit_depth,
+    cahal_recorder_callback  in_recorder,
+    void*                    in_callback_user_data,
+    cahal_audio_format_flag  in_format_flags,
+    CPC_BOOL                 in_is_prepared
+                       )
+{
+  CPC_BOOL return_value = CPC_FALSE;
+  cahal_channel_layout channel_layout;
+
+  if( ! cahal_stream_state_begin_start( &g_cahal_recording_state ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Recording has already started." );
+
+    return( CPC_FALSE );
+  }
+
+  if  (
+       ! cahal_get_stream_channel_layout  (
+                                           in_device,
+                                           CAHAL_DEVICE_INPUT_STREAM,
+                                           in_number_of_channels,
+                                           &channel_layout
+                                           )
+       )
+  {
+    CPC_ERROR( "Cannot record %d channels.", in_number_of_channels );
+  }
+  else if  (
+       cahal_test_device_direction_support  (
+                                             in_device,
+                                             CAHAL_DEVICE_INPUT_STREAM
+                                             )
+       && CAHAL_STATE_INITIALIZED == CAHAL_ATOMIC_LOAD( &g_cahal_state )
+       && CPC_ERROR_CODE_NO_ERROR
+          == cpc_safe_malloc  (
+                               ( void** ) &g_recorder_callback_info,
+                               sizeof( cahal_recorder_info )
+                               )
+       )
+  {
+    replay_callback_info* callback_info = NULL;
+
+    g_recorder_callback_info->recording_device    = in_device;
+    g_recorder_callback_info->recording_callback  = in_recorder;
+    g_recorder_callback_info->user_data           = in_callback_user_data;
+    g_recorder_callback_info->format_id           = in_format_id;
+    g_recorder_callback_info->number_of_channels  = in_number_of_channels;
+    g_recorder_callback_info->channel_layout      = channel_layout;
+    g_recorder_callback_info->sample_rate         = in_sample_rate;
+    g_recorder_callback_info->bit_depth           = in_bit_depth;
+    g_recorder_callback_info->format_flags        = in_format_flags;
+
+    return_value =
+        replay_create_device  (
+            in_number_of_channels,
+            in_sample_rate,
+            in_bit_depth,
+            replay_recorder_thread,
+            g_recorder_callback_info,
+            &( g_recorder_callback_info->platform_data )
+            );
+
+    callback_info =
+        ( replay_callback_info* ) g_recorder_callback_info->platform_data;
+
+    return_value =
+        return_value
+        && cahal_attach_recording_coalescer (
+            g_recorder_callback_info,
+            callback_info->buffer_size
+            )
+        && cahal_attach_recording_dispatcher  (
+            g_recorder_callback_info,
+            callback_info->buffer_size
+            );
+
+    if( return_value )
+    {
+      CAHAL_ATOMIC_STORE( &( callback_info->is_paused ), in_is_prepared );
+    }
+    else
+    {
+      CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not start recording." );
+
+      replay_free_device  (
+          ( replay_callback_info** )
+          &( g_recorder_callback_info->platform_data )
+          );
+
+      cahal_detach_recording_dispatcher( g_recorder_callback_info );
+
+      cahal_detach_recording_coalescer( g_recorder_callback_info );
+
+      cpc_safe_free( ( void** ) &( g_recorder_callback_info ) );
+    }
+  }
+  else
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Cannot record from device." );
+  }
+
+  if( in_is_prepared )
+  {
+    cahal_stream_state_end_prepare( &g_cahal_recording_state, return_value );
+  }
+  else
+  {
+    cahal_stream_state_end_start( &g_cahal_recording_state, return_value );
+  }
+
+  return( return_value );
+}
+
+static
+CPC_BOOL
+replay_start_playback  (
+    cahal_device*            in_device,
+    cahal_audio_format_id    in_format_id,
+    UINT32                   in_number_of_channels,
+    FLOAT64                  in_sample_rate,
+    UINT32                   in_bit_depth,
+    cahal_playback_callback  in_playback,
+    void*                    in_callback_user_data,
+    cahal_audio_format_flag  in_format_flags,
+    CPC_BOOL                 in_is_prepared
+                       )
+{
+  CPC_BOOL return_value = CPC_FALSE;
+  cahal_channel_layout channel_layout;
+
+  if( ! cahal_stream_state_begin_start( &g_cahal_playback_state ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Playback has already started." );
+
+    return( CPC_FALSE );
+  }
+
+  if  (
+       ! cahal_get_stream_channel_layout  (
+                                           in_device,
+                                           CAHAL_DEVICE_OUTPUT_STREAM,
+                                           in_number_of_channels,
+                                           &channel_layout
+                                           )
+       )
+  {
+    CPC_ERROR( "Cannot play back %d channels.", in_number_of_channels );
+  }
+  else if  (
+       cahal_test_device_direction_support  (
+                                             in_device,
+                                             CAHAL_DEVICE_OUTPUT_STREAM
+                                             )
+       && CAHAL_STATE_INITIALIZED == CAHAL_ATOMIC_LOAD( &g_cahal_state )
+       && CPC_ERROR_CODE_NO_ERROR
+          == cpc_safe_malloc  (
+                               ( void** ) &g_playback_callback_info,
+                               sizeof( cahal_playback_info )
+                               )
+       )
+  {
+    replay_callback_info* callback_info = NULL;
+
+    g_playback_callback_info->playback_device     = in_device;
+    g_playback_callback_info->playback_callback   = in_playback;
+    g_playback_callback_info->user_data           = in_callback_user_data;
+    g_playback_callback_info->format_id           = in_format_id;
+    g_playback_callback_info->number_of_channels  = in_number_of_channels;
+    g_playback_callback_info->channel_layout      = channel_layout;
+    g_playback_callback_info->sample_rate         = in_sample_rate;
+    g_playback_callback_info->bit_depth           = in_bit_depth;
+    g_playback_callback_info->format_flags        = in_format_flags;
+
+    return_value =
+        replay_create_device  (
+            in_number_of_channels,
+            in_sample_rate,
+            in_bit_depth,
+            replay_playback_thread,
+            g_playback_callback_info,
+            &( g_playback_callback_info->platform_data )
+            );
+
+    callback_info =
+        ( replay_callback_info* ) g_playback_callback_info->platform_data;
+
+    return_value =
+        return_value
+        && cahal_attach_playback_schedule( g_playback_callback_info )
+        && cahal_attach_playback_dispatcher  (
+            g_playback_callback_info,
+            callback_info->buffer_size
+            );
+
+    if( return_value )
+    {
+      CAHAL_ATOMIC_STORE( &( callback_info->is_paused ), in_is_prepared );
+    }
+    else
+    {
+      CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not start playback." );
+
+      replay_free_device  (
+          ( replay_callback_info** )
+          &( g_playback_callback_info->platform_data )
+          );
+
+      cahal_detach_playback_dispatcher( g_playback_callback_info );
+
+      cahal_detach_playback_schedule( g_playback_callback_info );
+
+      cpc_safe_free( ( void** ) &( g_playback_callback_info ) );
+    }
+  }
+  else
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Cannot play back to device." );
+  }
+
+  if( in_is_prepared )
+  {
+    cahal_stream_state_end_prepare( &g_cahal_playback_state, return_value );
+  }
+  else
+  {
+    cahal_stream_state_end_start( &g_cahal_playback_state, return_value );
+  }
+
+  return( return_value );
+}
+
+static
+CPC_BOOL
+replay_create_device  (
+    UINT32                in_number_of_channels,
+    FLOAT64               in_sample_rate,
+    UINT32                in_bit_depth,
+    cahal_thread_routine  in_routine,
+    void*                 in_stream_info,
+    void**                out_platform_data
+                      )
+{
+  replay_callback_info* callback_info = NULL;
+  UINT32 buffer_size                  =
+      ( UINT32 ) ( in_sample_rate * REPLAY_BUFFER_DURATION )
+      * in_number_of_channels
+      * cahal_get_bytes_per_sample( in_bit_depth );
+
+  if( 0 == buffer_size )
+  {
+    CPC_ERROR (
+        "Invalid format: sr=%.2f, nc=%d, bd=%d.",
+        in_sample_rate,
+        in_number_of_channels,
+        in_bit_depth
+        );
+
+    return( CPC_FALSE );
+  }
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc  (
+                            ( void** ) &callback_info,
+                            sizeof( replay_callback_info )
+                            )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc device." );
+
+    return( CPC_FALSE );
+  }
+
+  *out_platform_data = callback_info;
+
+  callback_info->buffer_size = buffer_size;
+
+  //  Paused so that no buffer is due before the stream is set up
+  CAHAL_ATOMIC_STORE( &( callback_info->is_paused ), CPC_TRUE );
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &( callback_info->buffer ), buffer_size )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc buffer." );
+
+    return( CPC_FALSE );
+  }
+
+  CAHAL_ATOMIC_STORE( &( callback_info->is_running ), CPC_TRUE );
+
+  if  (
+       ! cahal_thread_create  (
+                               &( callback_info->thread ),
+                               in_routine,
+                               in_stream_info
+                               )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not start device thread." );
+
+    CAHAL_ATOMIC_STORE( &( callback_info->is_running ), CPC_FALSE );
+
+    return( CPC_FALSE );
+  }
+
+  return( CPC_TRUE );
+}
+
+static
+void
+replay_free_device (
+    replay_callback_info** io_callback_info
+                   )
+{
+  replay_callback_info* callback_info = *io_callback_info;
+
+  if( NULL != callback_info )
+  {
+    if( CAHAL_ATOMIC_LOAD( &( callback_info->is_running ) ) )
+    {
+      CAHAL_ATOMIC_STORE( &( callback_info->is_running ), CPC_FALSE );
+
+      cahal_thread_join( &( callback_info->thread ) );
+    }
+
+    cpc_safe_free( ( void** ) &( callback_info->buffer ) );
+    cpc_safe_free( ( void** ) io_callback_info );
+  }
+}
+
+static
+CPC_BOOL
+replay_set_paused (
+    cahal_stream_state*     io_state,
+    replay_callback_info*   io_callback_info,
+    CPC_BOOL                in_is_paused
+                  )
+{
+  CPC_BOOL result = CPC_FALSE;
+
+  if  (
+       in_is_paused
+       ? cahal_stream_state_begin_pause( io_state )
+       : cahal_stream_state_begin_resume( io_state )
+       )
+  {
+    result = NULL != io_callback_info;
+
+    if( result )
+    {
+      CAHAL_ATOMIC_STORE( &( io_callback_info->is_paused ), in_is_paused );
+    }
+
+    if( in_is_paused )
+    {
+      cahal_stream_state_end_pause( io_state, result );
+    }
+    else
+    {
+      cahal_stream_state_end_resume( io_state, result );
+    }
+  }
+
+  return( result );
+}
+
+static
+void
+replay_recorder_thread (
+    void* in_recorder_info
+                       )
+{
+  cahal_recorder_info* recorder_info    =
+      ( cahal_recorder_info* ) in_recorder_info;
+  replay_callback_info* callback_info   =
+      ( replay_callback_info* ) recorder_info->platform_data;
+  UINT64 period                         =
+      ( UINT64 ) ( REPLAY_BUFFER_DURATION * 1000000000.0 );
+  UINT64 due                            = cahal_get_time() + period;
+
+  while( CAHAL_ATOMIC_LOAD( &( callback_info->is_running ) ) )
+  {
+    if( cahal_get_time() < due )
+    {
+      cahal_sleep( REPLAY_POLL_INTERVAL );
+    }
+    else
+    {
+      due += period;
+
+      if( ! CAHAL_ATOMIC_LOAD( &( callback_info->is_paused ) ) )
+      {
+        memset( callback_info->buffer, 0, callback_info->buffer_size );
+
+        //  Like an OS whose buffer is not returned to its queue
+        if  (
+             ! cahal_dispatch_recording (
+                 recorder_info,
+                 callback_info->buffer,
+                 callback_info->buffer_size
+                                        )
+             )
+        {
+          break;
+        }
+      }
+    }
+  }
+}
+
+static
+void
+replay_playback_thread (
+    void* in_playback_info
+                       )
+{
+  cahal_playback_info* playback_info    =
+      ( cahal_playback_info* ) in_playback_info;
+  replay_callback_info* callback_info   =
+      ( replay_callback_info* ) playback_info->platform_data;
+  UINT64 period                         =
+      ( UINT64 ) ( REPLAY_BUFFER_DURATION * 1000000000.0 );
+  UINT64 due                            = cahal_get_time();
+
+  while( CAHAL_ATOMIC_LOAD( &( callback_info->is_running ) ) )
+  {
+    if( cahal_get_time() < due )
+    {
+      cahal_sleep( REPLAY_POLL_INTERVAL );
+    }
+    else
+    {
+      due += period;
+
+      if( ! CAHAL_ATOMIC_LOAD( &( callback_info->is_paused ) ) )
+      {
+        UINT32 buffer_size = callback_info->buffer_size;
+
+        //  Each buffer is played as soon as it is filled, behind nothing
+        if  (
+             ! cahal_dispatch_playback  (
+                 playback_info,
+                 callback_info->buffer,
+                 &buffer_size,
+                 0
+                                        )
+             )
+        {
+          break;
+        }
+      }
+    }
+  }
+}
@@ -8,16 +8,29 @@
 void
 cahal_initialize( void )
 {
+  UINT32 stage  = cahal_profile_begin( "cahal_initialize" );
+  UINT32 step   = CAHAL_PROFILE_NO_STAGE;
+
   switch( g_cahal_state )
   {
   case CAHAL_STATE_NOT_INITIALIZED:
     g_cahal_state = CAHAL_STATE_INITIALIZED;
 
+    step = cahal_profile_begin( "CoInitialize" );
+
     CoInitialize( NULL );
 
+    cahal_profile_end( step );
+
+    windows_register_device_notifications();
+
     if( ! cpc_is_initialized() )
     {
+      step = cahal_profile_begin( "cpc_initialize" );
+
       cpc_initialize();
+
+      cahal_profile_end( step );
     }
 
     break;
@@ -29,6 +42,8 @@ cahal_initialize( void )
       );
     break;
   }
+
+  cahal_profile_end( stage );
 }
 
 void
@@ -46,7 +61,26 @@ cahal_terminate( void )
       );
     break;
   case CAHAL_STATE_INITIALIZED:
-    g_cahal_state = CAHAL_STATE_TERMINATED;
+    if(
+      ! CAHAL_ATOMIC_COMPARE_AND_SWAP(
+        &g_cahal_state,
+        CAHAL_STATE_INITIALIZED,
+        CAHAL_STATE_TERMINATED
+      )
+      )
+    {
+      break;
+    }
+
+    //  Without the notifications no more refreshes are queued, and those
+    //  already queued run before the control thread stops
+    windows_unregister_device_notifications();
+
+    //  Queued starts and stops run before the streams are stopped
+    cahal_async_terminate();
+
+    cahal_stop_recording();
+    cahal_stop_playback();
 
     cahal_free_device_list();
 
@@ -62,36 +96,24 @@ cahal_terminate( void )
 }
 
 cahal_device**
-cahal_get_device_list( void )
+cahal_query_device_list(
+  cahal_device_list_callback  in_callback,
+  void*                       in_user_data
+)
 {
-  cahal_device** device_list = NULL;
-
-  if( CAHAL_STATE_INITIALIZED == g_cahal_state )
-  {
-    if( NULL == g_device_list )
-    {
-      g_device_list = windows_get_device_list();
-
-      CPC_LOG(
-        CPC_LOG_LEVEL_DEBUG,
-        "Generated device list: 0x%x.",
-        g_device_list
-        );
-    }
-    else
-    {
-      CPC_LOG(
-        CPC_LOG_LEVEL_DEBUG,
-        "Returning existing device list: 0x%x.",
-        g_device_list
-        );
-    }
-
-    device_list = g_device_list;
-  }
-  else
+  cahal_device** device_list = windows_get_device_list();
+
+  //  Formats are checked with IAudioClient::IsFormatSupported, which does
+  //  not open the endpoint, so the whole list is ready at once.
+  for(
+    UINT32 device_index = 0;
+    NULL != in_callback
+    && NULL != device_list
+    && NULL != device_list[ device_index ];
+    device_index++
+  )
   {
-    CPC_ERROR( "CAHAL has not been initialized: %d.", g_cahal_state );
+    in_callback( device_list[ device_index ], in_user_data );
   }
 
   return( device_list );
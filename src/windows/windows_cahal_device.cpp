@@ -17,6 +17,12 @@
     */
 #define LABEL_RENDER    "render"
 
+/*! \def    EVENT_THREAD_PRIORITY
+    \brief  The real-time priority the capture and render threads request;
+            mapped onto the normal MMCSS priority of the "Pro Audio" task.
+    */
+#define EVENT_THREAD_PRIORITY 50
+
 /*! \var    g_recorder_callback_info
     \brief  Global struct containing the recorder (mic) info. Set when recording
             is taking place.
@@ -124,6 +130,136 @@ typedef struct data_handler_t
 
 } data_handler;
 
+/*! \class  windows_device_notification_client
+    \brief  Notified by the MMDevice API of devices being added, removed,
+            enabled or disabled and of default device changes, each of which
+            schedules a refresh of the device list (see
+            cahal_schedule_device_list_refresh). The callbacks must not block,
+            so the device list is queried on the control thread instead.
+    */
+class windows_device_notification_client : public IMMNotificationClient
+{
+public:
+  windows_device_notification_client( void )
+    : reference_count( 1 )
+  {
+  }
+
+  ULONG STDMETHODCALLTYPE
+  AddRef( void )
+  {
+    return( InterlockedIncrement( &reference_count ) );
+  }
+
+  ULONG STDMETHODCALLTYPE
+  Release( void )
+  {
+    ULONG count = InterlockedDecrement( &reference_count );
+
+    if( 0 == count )
+    {
+      delete this;
+    }
+
+    return( count );
+  }
+
+  HRESULT STDMETHODCALLTYPE
+  QueryInterface(
+    REFIID  in_interface,
+    void**  out_object
+  )
+  {
+    if(
+      __uuidof( IUnknown ) == in_interface
+      || __uuidof( IMMNotificationClient ) == in_interface
+      )
+    {
+      AddRef();
+
+      *out_object = ( IMMNotificationClient* ) this;
+
+      return( S_OK );
+    }
+
+    *out_object = NULL;
+
+    return( E_NOINTERFACE );
+  }
+
+  HRESULT STDMETHODCALLTYPE
+  OnDeviceAdded(
+    LPCWSTR in_device_id
+  )
+  {
+    cahal_schedule_device_list_refresh();
+
+    return( S_OK );
+  }
+
+  HRESULT STDMETHODCALLTYPE
+  OnDeviceRemoved(
+    LPCWSTR in_device_id
+  )
+  {
+    cahal_schedule_device_list_refresh();
+
+    return( S_OK );
+  }
+
+  HRESULT STDMETHODCALLTYPE
+  OnDeviceStateChanged(
+    LPCWSTR in_device_id,
+    DWORD   in_state
+  )
+  {
+    //  Only active endpoints are listed, so a device that is plugged in or
+    //  unplugged is notified here
+    cahal_schedule_device_list_refresh();
+
+    return( S_OK );
+  }
+
+  HRESULT STDMETHODCALLTYPE
+  OnDefaultDeviceChanged(
+    EDataFlow in_flow,
+    ERole     in_role,
+    LPCWSTR   in_device_id
+  )
+  {
+    cahal_schedule_device_list_refresh();
+
+    return( S_OK );
+  }
+
+  HRESULT STDMETHODCALLTYPE
+  OnPropertyValueChanged(
+    LPCWSTR           in_device_id,
+    const PROPERTYKEY in_key
+  )
+  {
+    //  Property changes are frequent and do not change the list
+    return( S_OK );
+  }
+
+private:
+  /*! \var    reference_count
+      \brief  The COM reference count of the client.
+      */
+  LONG reference_count;
+};
+
+/*! \var    g_notification_enumerator
+    \brief  The enumerator the device notification client is registered
+            with, or NULL.
+    */
+static IMMDeviceEnumerator* g_notification_enumerator = NULL;
+
+/*! \var    g_notification_client
+    \brief  The device notification client, or NULL.
+    */
+static windows_device_notification_client* g_notification_client = NULL;
+
 /*! \fn     cahal_device** windows_get_device_list(void)
     \brief  Gather the list of cahal devices on the system (in and out) and return
             a null-temrinated list.
@@ -157,25 +293,29 @@ cahal_playback_info*  in_callback_info
 );
 
 /*! \fn     void windows_configure_format(
-              UINT32          in_number_of_channels,
-              FLOAT64         in_sample_rate,
-              UINT32          in_bit_depth,
-              WAVEFORMATEX**  out_format
+              UINT32                      in_number_of_channels,
+              const cahal_channel_layout* in_channel_layout,
+              FLOAT64                     in_sample_rate,
+              UINT32                      in_bit_depth,
+              WAVEFORMATEX**              out_format
             )
     \brief  Malloc's a new format struct (out_format) and appropriately sets its parameters.
 
     \param  in_number_of_channels The number of formats in the new format.
+    \param  in_channel_layout The layout of the channels (see
+                              windows_set_wave_format).
     \param  in_sample_rate  The sample rate of the new format.
     \param  in_bit_depth  The bit depth (bits per sample)in the new format.
-    \param  out_format  A newly created WAVEFORMATEX struct (must be freed) or NULL if an
-                        error occurred.
+    \param  out_format  A newly created WAVEFORMATEX struct, extensible if
+                        required, (must be freed) or NULL if an error occurred.
  */
 void
 windows_configure_format(
-UINT32          in_number_of_channels,
-FLOAT64         in_sample_rate,
-UINT32          in_bit_depth,
-WAVEFORMATEX**  out_format
+UINT32                      in_number_of_channels,
+const cahal_channel_layout* in_channel_layout,
+FLOAT64                     in_sample_rate,
+UINT32                      in_bit_depth,
+WAVEFORMATEX**              out_format
 );
 
 /*! \fn    void  windows_handle_playback_data(
@@ -209,6 +349,100 @@ PHANDLE io_terminate_event,
 PHANDLE io_thread
 );
 
+/*! \fn     void windows_drain_audio_client(
+              IAudioClient* in_audio_client
+            )
+    \brief  Waits until the render hardware has played the frames written to
+            in_audio_client, for at most CAHAL_DRAIN_TIMEOUT. The playback
+            must be stopping, so that no more frames are written.
+
+    \param  in_audio_client The audio client of the playback.
+    */
+void
+windows_drain_audio_client(
+IAudioClient* in_audio_client
+);
+
+/*! \fn     CPC_BOOL windows_stop_playback(
+              CPC_BOOL in_drain
+            )
+    \brief  Stops the playback, after draining it if in_drain is set. Shared
+            by cahal_stop_playback and cahal_drain_playback.
+
+    \param  in_drain  True to play the written frames before stopping.
+    \return True iff playback has been stopped.
+    */
+CPC_BOOL
+windows_stop_playback(
+CPC_BOOL in_drain
+);
+
+/*! \fn     CPC_BOOL windows_start_recording(
+              cahal_device*            in_device,
+              cahal_audio_format_id    in_format_id,
+              UINT32                   in_number_of_channels,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              cahal_recorder_callback  in_recorder,
+              void*                    in_callback_user_data,
+              cahal_audio_format_flag  in_format_flags,
+              CPC_BOOL                 in_is_prepared
+            )
+    \brief  Sets up the recording and, unless in_is_prepared is set, starts
+            the audio client. Shared by cahal_start_recording and
+            cahal_prepare_recording, whose parameters are documented there.
+
+    \param  in_is_prepared  True to leave the audio client stopped and the
+                            recording paused.
+    \return True iff the recording was started (or prepared).
+    */
+CPC_BOOL
+windows_start_recording(
+  cahal_device*            in_device,
+  cahal_audio_format_id    in_format_id,
+  UINT32                   in_number_of_channels,
+  FLOAT64                  in_sample_rate,
+  UINT32                   in_bit_depth,
+  cahal_recorder_callback  in_recorder,
+  void*                    in_callback_user_data,
+  cahal_audio_format_flag  in_format_flags,
+  CPC_BOOL                 in_is_prepared
+);
+
+/*! \fn     CPC_BOOL windows_start_playback(
+              cahal_device*            in_device,
+              cahal_audio_format_id    in_format_id,
+              UINT32                   in_number_of_channels,
+              FLOAT64                  in_sample_rate,
+              UINT32                   in_bit_depth,
+              FLOAT32                  in_volume,
+              cahal_playback_callback  in_playback,
+              void*                    in_callback_user_data,
+              cahal_audio_format_flag  in_format_flags,
+              CPC_BOOL                 in_is_prepared
+            )
+    \brief  Sets up the playback and, unless in_is_prepared is set, starts
+            the audio client. Shared by cahal_start_playback and
+            cahal_prepare_playback, whose parameters are documented there.
+
+    \param  in_is_prepared  True to leave the audio client stopped and the
+                            playback paused.
+    \return True iff the playback was started (or prepared).
+    */
+CPC_BOOL
+windows_start_playback(
+  cahal_device*            in_device,
+  cahal_audio_format_id    in_format_id,
+  UINT32                   in_number_of_channels,
+  FLOAT64                  in_sample_rate,
+  UINT32                   in_bit_depth,
+  FLOAT32                  in_volume,
+  cahal_playback_callback  in_playback,
+  void*                    in_callback_user_data,
+  cahal_audio_format_flag  in_format_flags,
+  CPC_BOOL                 in_is_prepared
+);
+
 /*! \fn    DWORD WINAPI  windows_thread_entry  (
                             LPVOID in_handler_info
                                                 )
@@ -698,6 +932,8 @@ windows_get_device_list( void )
   HRESULT result                          = S_OK;
   IMMDeviceEnumerator *enumerator         = NULL;
   IMMDeviceCollection *device_collection  = NULL;
+  UINT32 stage                            =
+    cahal_profile_begin( "CoCreateInstance( MMDeviceEnumerator )" );
 
   CPC_LOG_STRING( CPC_LOG_LEVEL_DEBUG, "Enumerating devices" );
 
@@ -710,15 +946,20 @@ windows_get_device_list( void )
         ( void** )&enumerator
                         );
 
+  cahal_profile_end( stage );
+
   if( S_OK == result )
   {
-    result =
+    stage   = cahal_profile_begin( "IMMDeviceEnumerator::EnumAudioEndpoints" );
+    result  =
         enumerator->EnumAudioEndpoints  (
           eAll, 
           DEVICE_STATE_ACTIVE, 
           &device_collection
                                         );
 
+    cahal_profile_end( stage );
+
     if( S_OK == result )
     {
       UINT32 number_of_devices;
@@ -738,6 +979,8 @@ windows_get_device_list( void )
                               )
           )
         {
+          stage = cahal_profile_begin( "windows_set_device_info" );
+
           for( UINT32 i = 0; i < number_of_devices; i++ )
           {
             if(
@@ -770,6 +1013,8 @@ windows_get_device_list( void )
               }
             }
           }
+
+          cahal_profile_end( stage );
         }
       }
       else
@@ -794,6 +1039,67 @@ windows_get_device_list( void )
   return( device_list );
 }
 
+void
+windows_register_device_notifications( void )
+{
+  HRESULT result =
+    CoCreateInstance(
+      __uuidof( MMDeviceEnumerator ),
+      NULL,
+      CLSCTX_ALL,
+      __uuidof( IMMDeviceEnumerator ),
+      ( void** ) &g_notification_enumerator
+    );
+
+  if( S_OK != result )
+  {
+    CPC_ERROR( "Could not initialize MMDevice enumerator: %d.", result );
+
+    g_notification_enumerator = NULL;
+
+    return;
+  }
+
+  g_notification_client = new windows_device_notification_client();
+
+  result =
+    g_notification_enumerator->RegisterEndpointNotificationCallback(
+      g_notification_client
+    );
+
+  if( S_OK != result )
+  {
+    CPC_ERROR( "Could not register for device notifications: %d.", result );
+
+    windows_unregister_device_notifications();
+  }
+}
+
+void
+windows_unregister_device_notifications( void )
+{
+  if( NULL != g_notification_enumerator && NULL != g_notification_client )
+  {
+    g_notification_enumerator->UnregisterEndpointNotificationCallback(
+      g_notification_client
+    );
+  }
+
+  if( NULL != g_notification_client )
+  {
+    g_notification_client->Release();
+
+    g_notification_client = NULL;
+  }
+
+  if( NULL != g_notification_enumerator )
+  {
+    g_notification_enumerator->Release();
+
+    g_notification_enumerator = NULL;
+  }
+}
+
 HRESULT
 windows_set_volume(
   cahal_device* in_device,
@@ -1195,6 +1501,7 @@ windows_playback_send_data  (
   BYTE *data              = NULL;
   BYTE *buffer            = NULL;
   UINT32 buffer_length    = 0;
+  UINT32 padding          = 0;
 
   result = in_audio_client->GetBufferSize( &number_of_frames );
 
@@ -1209,6 +1516,17 @@ windows_playback_send_data  (
   {
     buffer_length = number_of_frames * in_format->nBlockAlign;
 
+    //  The frames queued ahead of the buffer, so that a scheduled start
+    //  accounts for the latency of the device
+    result = in_audio_client->GetCurrentPadding( &padding );
+
+    if( S_OK != result )
+    {
+      CPC_ERROR( "Could not read padding: 0x%x.", result );
+
+      padding = 0;
+    }
+
     CPC_LOG (
       CPC_LOG_LEVEL_INFO,
       "Requesting 0x%x bytes of data.", 
@@ -1221,11 +1539,11 @@ windows_playback_send_data  (
       )
     {
       if(
-          ! in_callback_info->playback_callback(
-              in_callback_info->playback_device,
+          ! cahal_dispatch_playback(
+              in_callback_info,
               buffer,
               &buffer_length,
-              in_callback_info->user_data
+              padding * in_format->nBlockAlign
             )
         )
       {
@@ -1372,11 +1690,10 @@ windows_recorder_read_data(
         );
 
       if(
-          ! in_callback_info->recording_callback(
-              in_callback_info->recording_device,
+          ! cahal_dispatch_recording(
+              in_callback_info,
               buffer,
-              buffer_length,
-              in_callback_info->user_data
+              buffer_length
             )
         )
       {
@@ -1525,6 +1842,22 @@ windows_thread_entry  (
     {
       IAudioClient* audio_client =
         ( ( windows_context* )callback_info->platform_data )->audio_client;
+      cahal_thread_scheduling scheduling;
+
+      memset( &scheduling, 0, sizeof( cahal_thread_scheduling ) );
+
+      scheduling.policy   = CAHAL_THREAD_POLICY_FIFO;
+      scheduling.priority = EVENT_THREAD_PRIORITY;
+
+      if( ! cahal_thread_set_scheduling( &scheduling ) )
+      {
+        CPC_LOG(
+          CPC_LOG_LEVEL_WARN,
+          "%s thread (%d) could not join MMCSS.",
+          handler_info->label,
+          GetCurrentThreadId()
+        );
+      }
 
       while( !done )
       {
@@ -1581,6 +1914,8 @@ windows_thread_entry  (
           break;
         }
       }
+
+      cahal_thread_reset_scheduling();
     }
     else
     {
@@ -1714,27 +2049,24 @@ windows_initialize_events_thread  (
 
 void
 windows_configure_format  (
-  UINT32          in_number_of_channels,
-  FLOAT64         in_sample_rate,
-  UINT32          in_bit_depth,
-  WAVEFORMATEX**  out_format
+  UINT32                      in_number_of_channels,
+  const cahal_channel_layout* in_channel_layout,
+  FLOAT64                     in_sample_rate,
+  UINT32                      in_bit_depth,
+  WAVEFORMATEX**              out_format
                           )
 {
   if( NULL != out_format )
   {
-    if( CPC_ERROR_CODE_NO_ERROR == cpc_safe_malloc( ( void** )out_format, sizeof( WAVEFORMATEX ) ) )
+    if( CPC_ERROR_CODE_NO_ERROR == cpc_safe_malloc( ( void** )out_format, sizeof( WAVEFORMATEXTENSIBLE ) ) )
     {
-      CPC_MEMSET( *out_format, 0x0, sizeof( WAVEFORMATEX ) );
-
-      ( *out_format )->wFormatTag     = WAVE_FORMAT_PCM;
-      ( *out_format )->nChannels      = in_number_of_channels;
-      ( *out_format )->nSamplesPerSec = ( DWORD )in_sample_rate;
-      ( *out_format )->wBitsPerSample = in_bit_depth;
-      ( *out_format )->nBlockAlign    =
-        ( ( *out_format )->nChannels * ( *out_format )->wBitsPerSample ) / 8;
-      ( *out_format )->nAvgBytesPerSec =
-        ( *out_format )->nSamplesPerSec * ( *out_format )->nBlockAlign;
-      ( *out_format )->cbSize          = 0;
+      windows_set_wave_format (
+        in_number_of_channels,
+        ( UINT32 )in_sample_rate,
+        in_bit_depth,
+        in_channel_layout,
+        ( WAVEFORMATEXTENSIBLE* )*out_format
+                              );
 
       CPC_LOG(
         CPC_LOG_LEVEL_INFO,
@@ -1754,7 +2086,7 @@ windows_configure_format  (
 }
 
 CPC_BOOL
-cahal_start_recording (
+cahal_start_recording(
   cahal_device*            in_device,
   cahal_audio_format_id    in_format_id,
   UINT32                   in_number_of_channels,
@@ -1763,19 +2095,92 @@ cahal_start_recording (
   cahal_recorder_callback  in_recorder,
   void*                    in_callback_user_data,
   cahal_audio_format_flag  in_format_flags
-                      )
+)
+{
+  return(
+    windows_start_recording(
+      in_device,
+      in_format_id,
+      in_number_of_channels,
+      in_sample_rate,
+      in_bit_depth,
+      in_recorder,
+      in_callback_user_data,
+      in_format_flags,
+      CPC_FALSE
+    )
+  );
+}
+
+CPC_BOOL
+cahal_prepare_recording(
+  cahal_device*            in_device,
+  cahal_audio_format_id    in_format_id,
+  UINT32                   in_number_of_channels,
+  FLOAT64                  in_sample_rate,
+  UINT32                   in_bit_depth,
+  cahal_recorder_callback  in_recorder,
+  void*                    in_callback_user_data,
+  cahal_audio_format_flag  in_format_flags
+)
+{
+  return(
+    windows_start_recording(
+      in_device,
+      in_format_id,
+      in_number_of_channels,
+      in_sample_rate,
+      in_bit_depth,
+      in_recorder,
+      in_callback_user_data,
+      in_format_flags,
+      CPC_TRUE
+    )
+  );
+}
+
+CPC_BOOL
+windows_start_recording(
+  cahal_device*            in_device,
+  cahal_audio_format_id    in_format_id,
+  UINT32                   in_number_of_channels,
+  FLOAT64                  in_sample_rate,
+  UINT32                   in_bit_depth,
+  cahal_recorder_callback  in_recorder,
+  void*                    in_callback_user_data,
+  cahal_audio_format_flag  in_format_flags,
+  CPC_BOOL                 in_is_prepared
+)
 {
   CPC_BOOL return_value = CPC_FALSE;
+  cahal_channel_layout channel_layout;
 
   CPC_LOG_STRING( CPC_LOG_LEVEL_DEBUG, "In start recording!" );
 
+  if( ! cahal_stream_state_begin_start( &g_cahal_recording_state ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Recording has already started." );
+
+    return( CPC_FALSE );
+  }
+
   if(
+    ! cahal_get_stream_channel_layout(
+      in_device,
+      CAHAL_DEVICE_INPUT_STREAM,
+      in_number_of_channels,
+      &channel_layout
+    )
+    )
+  {
+    CPC_ERROR( "Cannot record %d channels.", in_number_of_channels );
+  }
+  else if(
     cahal_test_device_direction_support(
       in_device,
       CAHAL_DEVICE_INPUT_STREAM
     )
     && CAHAL_STATE_INITIALIZED == g_cahal_state
-    && NULL == g_recorder_callback_info
     )
   {
     IAudioClient* audio_client  = NULL;
@@ -1785,6 +2190,7 @@ cahal_start_recording (
 
     windows_configure_format  (
       in_number_of_channels, 
+      &channel_layout,
       in_sample_rate, 
       in_bit_depth, 
       &format
@@ -1812,6 +2218,13 @@ cahal_start_recording (
           g_recorder_callback_info->recording_callback  = in_recorder;
           g_recorder_callback_info->user_data           =
             in_callback_user_data;
+          g_recorder_callback_info->format_id           = in_format_id;
+          g_recorder_callback_info->number_of_channels  =
+            in_number_of_channels;
+          g_recorder_callback_info->channel_layout      = channel_layout;
+          g_recorder_callback_info->sample_rate         = in_sample_rate;
+          g_recorder_callback_info->bit_depth           = in_bit_depth;
+          g_recorder_callback_info->format_flags        = in_format_flags;
 
           if(
             CPC_ERROR_CODE_NO_ERROR 
@@ -1828,20 +2241,62 @@ cahal_start_recording (
               ( windows_context* )g_recorder_callback_info->platform_data
             )->format = format;
 
-            result =
-              windows_initialize_events_thread(
-                audio_client,
+            UINT32 number_of_frames = 0;
+
+            result = audio_client->GetBufferSize( &number_of_frames );
+
+            if(
+              S_OK == result
+              && ! cahal_attach_recording_coalescer(
                 g_recorder_callback_info,
-                &g_recorder_data_ready_event,
-                &g_recorder_terminate_event,
-                &g_recorder_thread,
-                ( windows_data_handler_routine )windows_handle_recorder_data,
-                LABEL_CAPTURE
+                number_of_frames * format->nBlockAlign
+              )
+              )
+            {
+              CPC_LOG_STRING(
+                CPC_LOG_LEVEL_ERROR,
+                "Could not start coalescer."
               );
 
+              result = E_OUTOFMEMORY;
+            }
+
+            if(
+              S_OK == result
+              && ! cahal_attach_recording_dispatcher(
+                g_recorder_callback_info,
+                number_of_frames * format->nBlockAlign
+              )
+              )
+            {
+              CPC_LOG_STRING(
+                CPC_LOG_LEVEL_ERROR,
+                "Could not start dispatcher."
+              );
+
+              result = E_OUTOFMEMORY;
+            }
+
+            if( S_OK == result )
+            {
+              result =
+                windows_initialize_events_thread(
+                  audio_client,
+                  g_recorder_callback_info,
+                  &g_recorder_data_ready_event,
+                  &g_recorder_terminate_event,
+                  &g_recorder_thread,
+                  ( windows_data_handler_routine )windows_handle_recorder_data,
+                  LABEL_CAPTURE
+                );
+            }
+
             if( S_OK == result )
             {
-              result = audio_client->Start();
+              if( ! in_is_prepared )
+              {
+                result = audio_client->Start();
+              }
 
               return_value = CPC_TRUE;
             }
@@ -1870,15 +2325,154 @@ cahal_start_recording (
       );
   }
 
+  //  A failed start is released by cahal_stop_recording, as before
+  if( in_is_prepared )
+  {
+    cahal_stream_state_end_prepare(
+      &g_cahal_recording_state,
+      NULL != g_recorder_callback_info
+    );
+  }
+  else
+  {
+    cahal_stream_state_end_start(
+      &g_cahal_recording_state,
+      NULL != g_recorder_callback_info
+    );
+  }
+
   return( return_value );
 }
 
+CPC_BOOL
+cahal_pause_recording( void )
+{
+  CPC_BOOL result = CPC_FALSE;
+
+  if( cahal_stream_state_begin_pause( &g_cahal_recording_state ) )
+  {
+    windows_context* context =
+      ( windows_context* )g_recorder_callback_info->platform_data;
+
+    result =
+      (
+        NULL != context
+        && NULL != context->audio_client
+        && S_OK == context->audio_client->Stop()
+      );
+
+    cahal_stream_state_end_pause( &g_cahal_recording_state, result );
+  }
+
+  return( result );
+}
+
+CPC_BOOL
+cahal_resume_recording( void )
+{
+  CPC_BOOL result = CPC_FALSE;
+
+  if( cahal_stream_state_begin_resume( &g_cahal_recording_state ) )
+  {
+    windows_context* context =
+      ( windows_context* )g_recorder_callback_info->platform_data;
+
+    result =
+      (
+        NULL != context
+        && NULL != context->audio_client
+        && S_OK == context->audio_client->Start()
+      );
+
+    cahal_stream_state_end_resume( &g_cahal_recording_state, result );
+  }
+
+  return( result );
+}
+
+CPC_BOOL
+cahal_pause_playback( void )
+{
+  CPC_BOOL result = CPC_FALSE;
+
+  if( cahal_stream_state_begin_pause( &g_cahal_playback_state ) )
+  {
+    windows_context* context =
+      ( windows_context* )g_playback_callback_info->platform_data;
+
+    result =
+      (
+        NULL != context
+        && NULL != context->audio_client
+        && S_OK == context->audio_client->Stop()
+      );
+
+    cahal_stream_state_end_pause( &g_cahal_playback_state, result );
+  }
+
+  return( result );
+}
+
+CPC_BOOL
+cahal_resume_playback( void )
+{
+  CPC_BOOL result = CPC_FALSE;
+
+  if( cahal_stream_state_begin_resume( &g_cahal_playback_state ) )
+  {
+    windows_context* context =
+      ( windows_context* )g_playback_callback_info->platform_data;
+
+    result =
+      (
+        NULL != context
+        && NULL != context->audio_client
+        && S_OK == context->audio_client->Start()
+      );
+
+    cahal_stream_state_end_resume( &g_cahal_playback_state, result );
+  }
+
+  return( result );
+}
+
+CPC_BOOL
+cahal_start_aggregate_member(
+  cahal_aggregate_member* io_member,
+  UINT64                  in_start_time
+)
+{
+  //  The capture thread serves the single recording of cahal_start_recording
+  CPC_LOG_STRING(
+    CPC_LOG_LEVEL_ERROR,
+    "Aggregate recordings are not supported on Windows."
+  );
+
+  return( CPC_FALSE );
+}
+
+void
+cahal_stop_aggregate_member(
+  cahal_aggregate_member* io_member
+)
+{
+}
+
 CPC_BOOL
 cahal_stop_recording( void )
 {
-  CPC_BOOL return_value =
+  CPC_BOOL return_value = CPC_FALSE;
+
+  if( ! cahal_stream_state_begin_stop( &g_cahal_recording_state, NULL ) )
+  {
+    return( CPC_FALSE );
+  }
+
+  return_value =
     windows_stop_thread( &g_recorder_terminate_event, &g_recorder_thread );
 
+  cahal_stream_state_wait_for_callbacks( &g_cahal_recording_state );
+
   if( NULL != g_recorder_callback_info )
   {
     if( NULL != g_recorder_callback_info->platform_data )
@@ -1904,6 +2498,10 @@ cahal_stop_recording( void )
       cpc_safe_free( ( void** ) &( g_recorder_callback_info->platform_data ) );
     }
 
+    cahal_detach_recording_dispatcher( g_recorder_callback_info );
+
+    cahal_detach_recording_coalescer( g_recorder_callback_info );
+
     cpc_safe_free( ( void** )&g_recorder_callback_info );
   }
 
@@ -1928,15 +2526,57 @@ cahal_stop_recording( void )
     g_recorder_thread = NULL;
   }
 
+  cahal_stream_state_end_stop( &g_cahal_recording_state );
+
   return( return_value );
 }
 
 CPC_BOOL
 cahal_stop_playback( void )
 {
-  CPC_BOOL return_value =
+  return( windows_stop_playback( CPC_FALSE ) );
+}
+
+CPC_BOOL
+cahal_drain_playback( void )
+{
+  return( windows_stop_playback( CPC_TRUE ) );
+}
+
+CPC_BOOL
+windows_stop_playback(
+  CPC_BOOL in_drain
+                     )
+{
+  CPC_BOOL return_value = CPC_FALSE;
+  UINT32 state          = CAHAL_STREAM_STATE_IDLE;
+
+  if( ! cahal_stream_state_begin_stop( &g_cahal_playback_state, &state ) )
+  {
+    return( CPC_FALSE );
+  }
+
+  //  The playback is stopping, so the thread no longer writes frames. A
+  //  paused client does not play, so it is not drained.
+  if(
+    in_drain
+    && CAHAL_STREAM_STATE_RUNNING == state
+    && NULL != g_playback_callback_info
+    && NULL != g_playback_callback_info->platform_data
+    )
+  {
+    windows_drain_audio_client(
+      ( ( windows_context* )
+        g_playback_callback_info->platform_data
+      )->audio_client
+    );
+  }
+
+  return_value =
     windows_stop_thread( &g_playback_terminate_event, &g_playback_thread );
 
+  cahal_stream_state_wait_for_callbacks( &g_cahal_playback_state );
+
   if( NULL != g_playback_callback_info )
   {
     if( NULL != g_playback_callback_info->platform_data )
@@ -1961,6 +2601,10 @@ cahal_stop_playback( void )
       cpc_safe_free( ( void** ) &( g_playback_callback_info->platform_data ) );
     }
 
+    cahal_detach_playback_dispatcher( g_playback_callback_info );
+
+    cahal_detach_playback_schedule( g_playback_callback_info );
+
     cpc_safe_free( ( void** )&g_playback_callback_info );
   }
 
@@ -1985,9 +2629,49 @@ cahal_stop_playback( void )
     g_playback_thread = NULL;
   }
 
+  cahal_stream_state_end_stop( &g_cahal_playback_state );
+
   return( return_value );
 }
 
+void
+windows_drain_audio_client(
+  IAudioClient* in_audio_client
+                          )
+{
+  UINT32 padding  = 0;
+  HRESULT result  = S_OK;
+
+  if( NULL == in_audio_client )
+  {
+    return;
+  }
+
+  for(
+    UINT32 waited = 0;
+    waited < CAHAL_DRAIN_TIMEOUT;
+    waited += CAHAL_DRAIN_POLL_INTERVAL
+    )
+  {
+    result = in_audio_client->GetCurrentPadding( &padding );
+
+    if( S_OK != result )
+    {
+      CPC_ERROR( "Could not read padding: 0x%x.", result );
+
+      break;
+    }
+    else if( 0 == padding )
+    {
+      CPC_LOG_STRING( CPC_LOG_LEVEL_DEBUG, "Drained render client." );
+
+      break;
+    }
+
+    cahal_sleep( CAHAL_DRAIN_POLL_INTERVAL );
+  }
+}
+
 CPC_BOOL
 windows_stop_thread
 (
@@ -2058,6 +2742,26 @@ UINT32 in_sleep_time
   Sleep( in_sleep_time );
 }
 
+UINT64
+cahal_get_time( void )
+{
+  static LARGE_INTEGER frequency  = { 0 };
+  LARGE_INTEGER counter;
+
+  if( 0 == frequency.QuadPart )
+  {
+    QueryPerformanceFrequency( &frequency );
+  }
+
+  QueryPerformanceCounter( &counter );
+
+  return(
+    ( UINT64 )( counter.QuadPart / frequency.QuadPart ) * 1000000000ULL
+    + ( UINT64 )( counter.QuadPart % frequency.QuadPart ) * 1000000000ULL
+      / frequency.QuadPart
+    );
+}
+
 CPC_BOOL
 cahal_start_playback(
   cahal_device*            in_device,
@@ -2065,27 +2769,104 @@ cahal_start_playback(
   UINT32                   in_number_of_channels,
   FLOAT64                  in_sample_rate,
   UINT32                   in_bit_depth,
-  FLOAT32				           in_volume,
+  FLOAT32                  in_volume,
   cahal_playback_callback  in_playback,
   void*                    in_callback_user_data,
   cahal_audio_format_flag  in_format_flags
-                    )
+)
+{
+  return(
+    windows_start_playback(
+      in_device,
+      in_format_id,
+      in_number_of_channels,
+      in_sample_rate,
+      in_bit_depth,
+      in_volume,
+      in_playback,
+      in_callback_user_data,
+      in_format_flags,
+      CPC_FALSE
+    )
+  );
+}
+
+CPC_BOOL
+cahal_prepare_playback(
+  cahal_device*            in_device,
+  cahal_audio_format_id    in_format_id,
+  UINT32                   in_number_of_channels,
+  FLOAT64                  in_sample_rate,
+  UINT32                   in_bit_depth,
+  FLOAT32                  in_volume,
+  cahal_playback_callback  in_playback,
+  void*                    in_callback_user_data,
+  cahal_audio_format_flag  in_format_flags
+)
+{
+  return(
+    windows_start_playback(
+      in_device,
+      in_format_id,
+      in_number_of_channels,
+      in_sample_rate,
+      in_bit_depth,
+      in_volume,
+      in_playback,
+      in_callback_user_data,
+      in_format_flags,
+      CPC_TRUE
+    )
+  );
+}
+
+CPC_BOOL
+windows_start_playback(
+  cahal_device*            in_device,
+  cahal_audio_format_id    in_format_id,
+  UINT32                   in_number_of_channels,
+  FLOAT64                  in_sample_rate,
+  UINT32                   in_bit_depth,
+  FLOAT32                  in_volume,
+  cahal_playback_callback  in_playback,
+  void*                    in_callback_user_data,
+  cahal_audio_format_flag  in_format_flags,
+  CPC_BOOL                 in_is_prepared
+)
 {
   CPC_BOOL return_value = CPC_FALSE;
+  cahal_channel_layout channel_layout;
 
   CPC_LOG_STRING( CPC_LOG_LEVEL_DEBUG, "In start playback!" );
 
+  if( ! cahal_stream_state_begin_start( &g_cahal_playback_state ) )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Playback has already started." );
+
+    return( CPC_FALSE );
+  }
+
   if (0.0 > in_volume || 1.0 < in_volume)
   {
 	  CPC_ERROR("Volume (%.02f) must be in the range [ 0, 1 ].", in_volume);
   }
+  else if(
+    ! cahal_get_stream_channel_layout(
+      in_device,
+      CAHAL_DEVICE_OUTPUT_STREAM,
+      in_number_of_channels,
+      &channel_layout
+    )
+    )
+  {
+    CPC_ERROR( "Cannot play back %d channels.", in_number_of_channels );
+  }
   else if(
     cahal_test_device_direction_support(
       in_device,
       CAHAL_DEVICE_OUTPUT_STREAM
     )
     && CAHAL_STATE_INITIALIZED == g_cahal_state
-    && NULL == g_recorder_callback_info
     )
   {
     IAudioClient* audio_client  = NULL;
@@ -2095,6 +2876,7 @@ cahal_start_playback(
 
     windows_configure_format(
       in_number_of_channels,
+      &channel_layout,
       in_sample_rate,
       in_bit_depth,
       &format
@@ -2123,6 +2905,13 @@ cahal_start_playback(
           g_playback_callback_info->playback_device   = in_device;
           g_playback_callback_info->playback_callback = in_playback;
           g_playback_callback_info->user_data         = in_callback_user_data;
+          g_playback_callback_info->format_id         = in_format_id;
+          g_playback_callback_info->number_of_channels  =
+            in_number_of_channels;
+          g_playback_callback_info->channel_layout    = channel_layout;
+          g_playback_callback_info->sample_rate       = in_sample_rate;
+          g_playback_callback_info->bit_depth         = in_bit_depth;
+          g_playback_callback_info->format_flags      = in_format_flags;
 
           if(
             CPC_ERROR_CODE_NO_ERROR
@@ -2139,22 +2928,61 @@ cahal_start_playback(
               ( windows_context* )g_playback_callback_info->platform_data
               )->format = format;
 
-            result =
-              windows_initialize_events_thread(
-                audio_client,
+            UINT32 number_of_frames = 0;
+
+            result = audio_client->GetBufferSize( &number_of_frames );
+
+            if(
+              S_OK == result
+              && ! cahal_attach_playback_schedule( g_playback_callback_info )
+              )
+            {
+              CPC_LOG_STRING(
+                CPC_LOG_LEVEL_ERROR,
+                "Could not schedule playback."
+              );
+
+              result = E_OUTOFMEMORY;
+            }
+
+            if(
+              S_OK == result
+              && ! cahal_attach_playback_dispatcher(
                 g_playback_callback_info,
-                &g_playback_data_ready_event,
-                &g_playback_terminate_event,
-                &g_playback_thread,
-                ( windows_data_handler_routine )windows_handle_playback_data,
-                LABEL_RENDER
+                number_of_frames * format->nBlockAlign
+              )
+              )
+            {
+              CPC_LOG_STRING(
+                CPC_LOG_LEVEL_ERROR,
+                "Could not start dispatcher."
               );
 
+              result = E_OUTOFMEMORY;
+            }
+
+            if( S_OK == result )
+            {
+              result =
+                windows_initialize_events_thread(
+                  audio_client,
+                  g_playback_callback_info,
+                  &g_playback_data_ready_event,
+                  &g_playback_terminate_event,
+                  &g_playback_thread,
+                  ( windows_data_handler_routine )windows_handle_playback_data,
+                  LABEL_RENDER
+                );
+            }
+
             if( S_OK == result )
             {
               windows_handle_playback_data( g_playback_callback_info );
 
-              result = audio_client->Start( );
+              if( ! in_is_prepared )
+              {
+                result = audio_client->Start( );
+              }
 
               return_value = CPC_TRUE;
             }
@@ -2183,5 +3011,21 @@ cahal_start_playback(
     );
   }
 
+  //  A failed start is released by cahal_stop_playback, as before
+  if( in_is_prepared )
+  {
+    cahal_stream_state_end_prepare(
+      &g_cahal_playback_state,
+      NULL != g_playback_callback_info
+    );
+  }
+  else
+  {
+    cahal_stream_state_end_start(
+      &g_cahal_playback_state,
+      NULL != g_playback_callback_info
+    );
+  }
+
   return( return_value );
 }
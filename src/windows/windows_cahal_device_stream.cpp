@@ -7,10 +7,11 @@
 
 #include "windows/windows_cahal_device_stream.hpp"
 
-/*! \def    NUM_CHANNELS_TO_TEST
-    \brief  Maximum number of channels to test. Will test in the range [ 0, 2 ]
+/*! \def    NUM_CHANNEL_LAYOUTS_TO_TEST
+    \brief  Maximum number of channel layouts to test: mono, stereo and the
+            layout of the endpoint's mix format if it is wider.
     */
-#define NUM_CHANNELS_TO_TEST                2
+#define NUM_CHANNEL_LAYOUTS_TO_TEST         3
 
 /*! \def    NUM_SUPPORTED_BITS_PER_SAMPLE
     \brief  The number of supported bit depths to test.
@@ -56,11 +57,12 @@ static UINT32 supported_sample_rates[
 };
 
 /*! \fn     cpc_error_code  windows_add_format_description(
-                              UINT32                in_bits_per_sample,
-                              UINT32                in_num_channels,
-                              UINT32                in_sample_rate,
-                              UINT32                in_num_supported_formats,
-                              cahal_device_stream*  io_device_stream
+                              UINT32                      in_bits_per_sample,
+                              UINT32                      in_num_channels,
+                              const cahal_channel_layout* in_channel_layout,
+                              UINT32                      in_sample_rate,
+                              UINT32                      in_num_supported_formats,
+                              cahal_device_stream*        io_device_stream
                             );
     \brief  Creates a new audio description with the passed in parameters and
             adds the newly created description to the list of supported formats
@@ -68,6 +70,7 @@ static UINT32 supported_sample_rates[
 
     \param  in_bits_per_sample  The number of bits per sample supported.
     \param  in_num_channels The number of channels supported.
+    \param  in_channel_layout The layout of the channels.
     \param  in_sample_rate  The sample rate supported.
     \param  in_num_supported_formats  The number of supported formats currently
                                       in the list pointed to by
@@ -78,11 +81,31 @@ static UINT32 supported_sample_rates[
  */
 cpc_error_code
 windows_add_format_description(
-  UINT32                in_bits_per_sample,
-  UINT32                in_num_channels,
-  UINT32                in_sample_rate,
-  UINT32                in_num_supported_formats,
-  cahal_device_stream*  io_device_stream
+  UINT32                      in_bits_per_sample,
+  UINT32                      in_num_channels,
+  const cahal_channel_layout* in_channel_layout,
+  UINT32                      in_sample_rate,
+  UINT32                      in_num_supported_formats,
+  cahal_device_stream*        io_device_stream
+);
+
+/*! \fn     UINT32 windows_get_channel_layouts_to_test(
+              IAudioClient*         in_audio_client,
+              cahal_channel_layout* out_layouts
+            );
+    \brief  Returns the channel layouts whose formats are tested: mono,
+            stereo and, for endpoints such as microphone arrays whose mix
+            format has more channels, the layout of the mix format.
+
+    \param  in_audio_client The client of the endpoint being queried.
+    \param  out_layouts The layouts to test. Must hold
+                        NUM_CHANNEL_LAYOUTS_TO_TEST layouts.
+    \return The number of layouts in out_layouts.
+ */
+UINT32
+windows_get_channel_layouts_to_test(
+  IAudioClient*         in_audio_client,
+  cahal_channel_layout* out_layouts
 );
 
 /*! \fn     HRESULT windows_set_device_stream_direction(
@@ -188,12 +211,20 @@ windows_determine_supported_formats(
 
   if( S_OK == result )
   {
+    cahal_channel_layout layouts[ NUM_CHANNEL_LAYOUTS_TO_TEST ];
+
+    UINT32 num_layouts =
+      windows_get_channel_layouts_to_test( audio_client, layouts );
+
     for(
-      UINT32 num_channels = 0;
-      num_channels < NUM_CHANNELS_TO_TEST;
-      num_channels++
+      UINT32 layout_index = 0;
+      layout_index < num_layouts;
+      layout_index++
       )
     {
+      UINT32 num_channels =
+        cahal_get_channel_layout_size( &( layouts[ layout_index ] ) );
+
       for(
         UINT32 bits_per_sample_index = 0;
         bits_per_sample_index < NUM_SUPPORTED_BITS_PER_SAMPLE;
@@ -206,24 +237,20 @@ windows_determine_supported_formats(
         sample_rate_index++
           )
         {
-          WAVEFORMATEX format;
-
-          CPC_MEMSET( &format, 0x0, sizeof( WAVEFORMATEX ) );
-          
-          format.wFormatTag       = WAVE_FORMAT_PCM;
-          format.nChannels        = ( num_channels + 1 );
-          format.nSamplesPerSec = supported_sample_rates[sample_rate_index];
-          format.wBitsPerSample   =
-            supported_bits_per_sample[bits_per_sample_index];
-          format.nBlockAlign      =
-            ( format.nChannels * format.wBitsPerSample ) / 8;
-          format.nAvgBytesPerSec  = format.nSamplesPerSec * format.nBlockAlign;
-          format.cbSize           = 0;
+          WAVEFORMATEXTENSIBLE format;
+
+          windows_set_wave_format (
+            num_channels,
+            supported_sample_rates[ sample_rate_index ],
+            supported_bits_per_sample[ bits_per_sample_index ],
+            &( layouts[ layout_index ] ),
+            &format
+                                  );
 
           HRESULT supported_check = 
             audio_client->IsFormatSupported ( 
               AUDCLNT_SHAREMODE_EXCLUSIVE, 
-              &format, 
+              &( format.Format ), 
               NULL
                                             );
 
@@ -231,9 +258,10 @@ windows_determine_supported_formats(
           {
             cpc_error_code format_added =
               windows_add_format_description  (
-                format.wBitsPerSample, 
-                format.nChannels, 
-                format.nSamplesPerSec, 
+                format.Format.wBitsPerSample, 
+                format.Format.nChannels, 
+                &( layouts[ layout_index ] ),
+                format.Format.nSamplesPerSec, 
                 num_supported_formats, 
                 out_stream
                                               );
@@ -258,13 +286,126 @@ windows_determine_supported_formats(
   return( result );
 }
 
+UINT32
+windows_get_channel_layouts_to_test(
+  IAudioClient*         in_audio_client,
+  cahal_channel_layout* out_layouts
+                                    )
+{
+  UINT32 num_layouts    = 0;
+  WAVEFORMATEX* format  = NULL;
+
+  for( UINT32 num_channels = 1; num_channels <= 2; num_channels++ )
+  {
+    cahal_get_default_channel_layout(
+      num_channels,
+      &( out_layouts[ num_layouts++ ] )
+                                    );
+  }
+
+  if(
+    S_OK == in_audio_client->GetMixFormat( &format )
+    && 2 < format->nChannels
+    && cahal_get_default_channel_layout(
+        format->nChannels,
+        &( out_layouts[ num_layouts ] )
+                                       )
+    )
+  {
+    cahal_channel_layout* layout = &( out_layouts[ num_layouts++ ] );
+
+    //  Keep the endpoint's speaker positions if they cover every channel,
+    //  otherwise the channels are the elements of an array
+
+    if( WAVE_FORMAT_EXTENSIBLE == format->wFormatTag )
+    {
+      cahal_channel_layout mix_layout;
+
+      mix_layout.layout_type  = CAHAL_CHANNEL_LAYOUT_SPEAKERS;
+      mix_layout.channel_mask =
+        ( ( WAVEFORMATEXTENSIBLE* )format )->dwChannelMask;
+
+      if( cahal_test_channel_layout( &mix_layout, format->nChannels ) )
+      {
+        *layout = mix_layout;
+      }
+      else
+      {
+        layout->layout_type   = CAHAL_CHANNEL_LAYOUT_DISCRETE;
+        layout->channel_mask  =
+          ( CAHAL_MAXIMUM_NUMBER_OF_CHANNELS == format->nChannels )
+          ? ~( ( UINT64 )0 )
+          : ( ( ( UINT64 )1 ) << format->nChannels ) - 1;
+      }
+    }
+
+    CPC_LOG (
+      CPC_LOG_LEVEL_DEBUG,
+      "Testing the %d channel mix format layout.",
+      format->nChannels
+            );
+  }
+
+  if( NULL != format )
+  {
+    CoTaskMemFree( format );
+  }
+
+  return( num_layouts );
+}
+
+void
+windows_set_wave_format(
+  UINT32                      in_number_of_channels,
+  UINT32                      in_sample_rate,
+  UINT32                      in_bits_per_sample,
+  const cahal_channel_layout* in_channel_layout,
+  WAVEFORMATEXTENSIBLE*       out_format
+                        )
+{
+  CPC_MEMSET( out_format, 0x0, sizeof( WAVEFORMATEXTENSIBLE ) );
+
+  out_format->Format.wFormatTag       = WAVE_FORMAT_PCM;
+  out_format->Format.nChannels        = ( WORD )in_number_of_channels;
+  out_format->Format.nSamplesPerSec   = in_sample_rate;
+  out_format->Format.wBitsPerSample   = ( WORD )in_bits_per_sample;
+  out_format->Format.nBlockAlign      =
+    ( out_format->Format.nChannels * out_format->Format.wBitsPerSample ) / 8;
+  out_format->Format.nAvgBytesPerSec  =
+    out_format->Format.nSamplesPerSec * out_format->Format.nBlockAlign;
+  out_format->Format.cbSize           = 0;
+
+  if( 2 < in_number_of_channels || 16 < in_bits_per_sample )
+  {
+    out_format->Format.wFormatTag       = WAVE_FORMAT_EXTENSIBLE;
+    out_format->Format.cbSize           =
+      sizeof( WAVEFORMATEXTENSIBLE ) - sizeof( WAVEFORMATEX );
+    out_format->Samples.wValidBitsPerSample =
+      ( WORD )in_bits_per_sample;
+    out_format->SubFormat               = KSDATAFORMAT_SUBTYPE_PCM;
+
+    if(
+      NULL != in_channel_layout
+      && CAHAL_CHANNEL_LAYOUT_SPEAKERS == in_channel_layout->layout_type
+      )
+    {
+      out_format->dwChannelMask = ( DWORD )in_channel_layout->channel_mask;
+    }
+    else
+    {
+      out_format->dwChannelMask = KSAUDIO_SPEAKER_DIRECTOUT;
+    }
+  }
+}
+
 cpc_error_code
 windows_add_format_description(
-  UINT32                in_bits_per_sample,
-  UINT32                in_num_channels,
-  UINT32                in_sample_rate,
-  UINT32                in_num_supported_formats,
-  cahal_device_stream*  io_device_stream
+  UINT32                      in_bits_per_sample,
+  UINT32                      in_num_channels,
+  const cahal_channel_layout* in_channel_layout,
+  UINT32                      in_sample_rate,
+  UINT32                      in_num_supported_formats,
+  cahal_device_stream*        io_device_stream
                                 )
 {
   cahal_audio_format_description* description;
@@ -282,6 +423,7 @@ windows_add_format_description(
     description->number_of_channels             = in_num_channels;
     description->sample_rate_range.minimum_rate = in_sample_rate;
     description->sample_rate_range.maximum_rate = in_sample_rate;
+    description->channel_layout                 = *in_channel_layout;
 
     result =
       cpc_safe_realloc(
@@ -0,0 +1,67 @@
+import cahal_tests
+import argparse
+import time
+
+#  The format of benchmark_recording: 48 kHz, mono, 16-bit
+BYTES_PER_SECOND = 48000 * 2
+
+def record( in_periods_per_callback, in_seconds, in_period ):
+  calls       = [ 0 ]
+  period_size = int( BYTES_PER_SECOND * in_period / 1000.0 ) & ~1
+  periods     = int( in_seconds * 1000.0 / in_period )
+
+  def callback( in_samples ):
+    calls[ 0 ] += 1
+
+  if( 1 < in_periods_per_callback ):
+    options = cahal_tests.cahal_coalesce_options()
+
+    options.number_of_periods = in_periods_per_callback
+
+    cahal_tests.cahal_set_coalesce_options( options )
+  else:
+    cahal_tests.cahal_set_coalesce_options( None )
+
+  start = time.process_time()
+
+  if( not cahal_tests.benchmark_recording( periods, period_size, callback ) ):
+    raise RuntimeError( "Recording failed." )
+
+  cpu = time.process_time() - start
+
+  cahal_tests.cahal_set_coalesce_options( None )
+
+  audio = periods * period_size / float( BYTES_PER_SECOND )
+
+  return( calls[ 0 ] / audio, cpu * 3600.0 / audio )
+
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser  (                                       \
+    description="Compares per-period and coalesced recording callbacks."    \
+                                    )
+
+  parser.add_argument  (                                                    \
+    "--seconds", type=float, default=600, help="seconds of audio recorded"  \
+                       )
+  parser.add_argument  (                                                    \
+    "--period", type=float, default=1, help="milliseconds per OS period"    \
+                       )
+  parser.add_argument  (                                                    \
+    "--coalesce", type=int, nargs="+", default=[ 1, 4, 16, 64 ],            \
+    help="periods per callback, 1 to call back once per period"             \
+                       )
+
+  arguments = parser.parse_args()
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  print (                                                                   \
+    "%.0f s of 48 kHz mono 16-bit audio, %.1f ms periods"                   \
+    % ( arguments.seconds, arguments.period )                               \
+        )
+  print( "periods/callback   callbacks/s   CPU s/hour of audio" )
+
+  for periods in arguments.coalesce:
+    rate, cpu = record( periods, arguments.seconds, arguments.period )
+
+    print( "%16d %13.1f %21.3f" % ( periods, rate, cpu ) )
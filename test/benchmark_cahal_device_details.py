@@ -0,0 +1,64 @@
+import cahal_tests
+import argparse
+import time
+
+def enumerate_devices( in_devices, in_latency, in_lazy ):
+  cahal_tests.cahal_free_device_list()
+
+  start       = time.time()
+  device_list =                                                             \
+    cahal_tests.create_simulated_lazy_device_list                           \
+      ( in_devices, in_latency, in_lazy )
+
+  cahal_tests.cahal_update_device_list( device_list )
+
+  snapshot  = cahal_tests.cahal_acquire_device_snapshot()
+  names     = []
+
+  for index in range( snapshot.number_of_devices ):
+    device = cahal_tests.cahal_device_list_get( snapshot.devices, index )
+
+    names.append( device.device_name )
+
+  startup   = time.time() - start
+  start     = time.time()
+
+  cahal_tests.cahal_find_devices  (                                         \
+    snapshot, cahal_tests.CAHAL_DEVICE_OUTPUT_STREAM,                       \
+    cahal_tests.CAHAL_DEVICE_CAPABILITY_LINEAR_PCM                          \
+                                  )
+
+  details   = time.time() - start
+
+  cahal_tests.cahal_release_device_snapshot( snapshot )
+  cahal_tests.cahal_free_device_list()
+
+  return( ( startup, details ) )
+
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser  (                                       \
+    description="Times eager and lazy enumeration of simulated devices."    \
+                                    )
+
+  parser.add_argument( "--devices", type=int, default=50 )
+  parser.add_argument  (                                                    \
+    "--latency", type=int, default=5, help="milliseconds per device"        \
+                       )
+
+  arguments = parser.parse_args()
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  print (                                                                   \
+    "%d devices, %d ms to read the details of each"                         \
+    % ( arguments.devices, arguments.latency )                              \
+        )
+  print( "mode   startup (s)   details (s)" )
+
+  for lazy in [ False, True ]:
+    times =                                                                 \
+      enumerate_devices( arguments.devices, arguments.latency, lazy )
+
+    print                                                                   \
+      ( "%-5s %12.3f %13.3f"                                                \
+        % ( "lazy" if lazy else "eager", times[ 0 ], times[ 1 ] ) )
@@ -0,0 +1,66 @@
+import cahal_tests
+import argparse
+import time
+
+def enumerate_devices( in_workers, in_devices, in_latency ):
+  prober    = cahal_tests.create_fake_prober( 2, 48000, 16, in_latency )
+  scheduler =                                                         \
+    cahal_tests.cahal_probe_scheduler_create( in_workers, None, None, None )
+  arrivals  = []
+
+  for channels in [ 1, 2 ]:
+    cahal_tests.cahal_prober_add_channels( prober, channels )
+
+  for rate in [ 8000, 11025, 16000, 22050, 32000, 44100, 48000 ]:
+    cahal_tests.cahal_prober_add_sample_rate( prober, rate )
+
+  for depth in [ 8, 16 ]:
+    cahal_tests.cahal_prober_add_bit_depth( prober, depth )
+
+  start = time.time()
+
+  for index in range( in_devices ):
+    cahal_tests.add_simulated_device( scheduler, "device%d" % index, prober, 1 )
+
+  cahal_tests.cahal_probe_scheduler_finish( scheduler )
+
+  device = cahal_tests.cahal_probe_scheduler_next( scheduler )
+
+  while( device ):
+    arrivals.append( time.time() - start )
+
+    cahal_tests.cahal_free_device( device )
+
+    device = cahal_tests.cahal_probe_scheduler_next( scheduler )
+
+  cahal_tests.cahal_probe_scheduler_free( scheduler )
+  cahal_tests.free_fake_prober( prober )
+
+  return( arrivals )
+
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser  (                                       \
+    description="Times device enumeration against simulated devices."       \
+                                    )
+
+  parser.add_argument( "--devices", type=int, default=6 )
+  parser.add_argument  (                                                    \
+    "--latency", type=int, default=5, help="milliseconds per probe"         \
+                       )
+  parser.add_argument( "--workers", type=int, nargs="+", default=[ 1, 2, 4, 8 ] )
+
+  arguments = parser.parse_args()
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  print (                                                                   \
+    "%d devices, 28 configurations each, %d ms per probe"                   \
+    % ( arguments.devices, arguments.latency )                              \
+        )
+  print( "workers   first (s)   total (s)" )
+
+  for workers in arguments.workers:
+    arrivals =                                                              \
+      enumerate_devices( workers, arguments.devices, arguments.latency )
+
+    print( "%7d %11.3f %11.3f" % ( workers, arrivals[ 0 ], arrivals[ -1 ] ) )
@@ -45,6 +45,8 @@
 
 %apply unsigned char { CPC_BOOL }
 
+%apply unsigned int { cahal_atomic_uint32 }
+
 %apply size_t * { SIZE *  }
 
 %include <cahal.h>
@@ -52,6 +54,32 @@
 %include <cahal_audio_format_description.h>
 %include <cahal_device.h>
 %include <cahal_device_stream.h>
+%include <cahal_ring_buffer.h>
+%include <cahal_audio_convert.h>
+%include <cahal_drift_resampler.h>
+%include <cahal_fft.h>
+%include <cahal_echo_canceller.h>
+%include <cahal_signal_generator.h>
+%include <cahal_filter_bank.h>
+%include <cahal_graph.h>
+%include <cahal_probe_cache.h>
+%include <cahal_probe.h>
+%include <cahal_probe_scheduler.h>
+%include <cahal_arena.h>
+%include <cahal_format_negotiation.h>
+%include <cahal_device_snapshot.h>
+%include <cahal_device_index.h>
+%include <cahal_device_serialization.h>
+%include <cahal_thread.h>
+%include <cahal_profile.h>
+%include <cahal_dispatcher.h>
+%include <cahal_worker_pool.h>
+%include <cahal_stream_state.h>
+%include <cahal_async.h>
+%include <cahal_coalescer.h>
+%include <cahal_pollable.h>
+%include <cahal_playback_schedule.h>
+%include <cahal_aggregate.h>
 
 %include <types.h>
 %include <cpcommon_error_codes.h>
@@ -60,5 +88,11 @@
 
 %include <cpointer.i>
 %pointer_functions( double, doubleP )
+%pointer_functions( cahal_arena*, cahal_arenaP )
+%pointer_functions( UINT32, UINT32P )
+
+%include <carrays.i>
+%array_functions( float, floatArray )
+%array_functions( unsigned int, uintArray )
 
 %include <cahal_wrapper.h>
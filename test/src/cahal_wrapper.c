@@ -1,4 +1,603 @@
 #include "cahal_wrapper.h"
+#include "cahal_callback.h"
+
+#include <math.h>
+
+/*! \var    fake_prober_limits
+    \brief  Struct definition for the user data of the probers created by
+            create_fake_prober.
+ */
+typedef struct fake_prober_limits_t
+{
+  /*! \var    maximum_channels
+      \brief  The largest supported number of channels.
+   */
+  UINT32  maximum_channels;
+
+  /*! \var    maximum_sample_rate
+      \brief  The largest supported sample rate.
+   */
+  FLOAT64 maximum_sample_rate;
+
+  /*! \var    maximum_bit_depth
+      \brief  The largest supported bit depth.
+   */
+  UINT32  maximum_bit_depth;
+
+  /*! \var    latency
+      \brief  The time (in milliseconds) each test takes.
+   */
+  UINT32  latency;
+
+} fake_prober_limits;
+
+/*! \var    dispatch_counter
+    \brief  Struct definition for the user data of the callbacks used by
+            simulate_dispatched_recording and simulate_dispatched_playback.
+ */
+typedef struct dispatch_counter_t
+{
+  /*! \var    number_of_bytes
+      \brief  The number of bytes passed to the callback.
+   */
+  UINT32    number_of_bytes;
+
+  /*! \var    next_value
+      \brief  The value of the next byte in the sequence.
+   */
+  UCHAR     next_value;
+
+  /*! \var    is_in_order
+      \brief  False once a recorded byte broke the sequence.
+   */
+  CPC_BOOL  is_in_order;
+
+  /*! \var    number_of_calls
+      \brief  The number of times the callback was called.
+   */
+  UINT32    number_of_calls;
+
+  /*! \var    maximum_calls
+      \brief  The number of calls after which the playback callback fails, or
+              0 to never fail.
+   */
+  UINT32    maximum_calls;
+
+} dispatch_counter;
+
+/*! \var    aggregate_output
+    \brief  Struct definition for the user data of the recording callback of
+            simulate_aggregate_recording.
+ */
+typedef struct aggregate_output_t
+{
+  /*! \var    samples
+      \brief  The consolidated frames recorded so far.
+   */
+  UCHAR*  samples;
+
+  /*! \var    length
+      \brief  The number of bytes in samples.
+   */
+  UINT32  length;
+
+  /*! \var    capacity
+      \brief  The size of samples in bytes. Frames past it are dropped.
+   */
+  UINT32  capacity;
+
+} aggregate_output;
+
+/*! \def    DEVICE_CHANGE_RECORD_SIZE
+    \brief  The size of the buffer the device change recorder writes to.
+ */
+#define DEVICE_CHANGE_RECORD_SIZE 4096
+
+/*! \def    AGGREGATE_MAXIMUM_MEMBERS
+    \brief  The largest number of members simulate_aggregate_recording
+            records.
+ */
+#define AGGREGATE_MAXIMUM_MEMBERS 8
+
+/*! \def    AGGREGATE_PERIOD_SIZE
+    \brief  The number of frames in a buffer of the master of
+            simulate_aggregate_recording. Every other member delivers larger
+            buffers.
+ */
+#define AGGREGATE_PERIOD_SIZE     800
+
+/*! \def    AGGREGATE_START_TIME
+    \brief  The host time (in ns) simulate_aggregate_recording starts at.
+ */
+#define AGGREGATE_START_TIME      1000000000000ULL
+
+/*! \def    AGGREGATE_MASTER_OFFSET
+    \brief  The time (in seconds) the master of simulate_aggregate_recording
+            starts recording at, relative to the start time.
+ */
+#define AGGREGATE_MASTER_OFFSET   -0.01
+
+/*! \def    AGGREGATE_PI
+    \brief  Pi, for the signal recorded by simulate_aggregate_recording.
+ */
+#define AGGREGATE_PI              3.14159265358979323846
+
+/*! \def    LIFECYCLE_CALLBACK_TIMEOUT
+    \brief  The longest time (in ms) stress_stream_lifecycle holds its last
+            recording open waiting for a buffer.
+ */
+#define LIFECYCLE_CALLBACK_TIMEOUT  2000
+
+/*! \var    g_device_change_record
+    \brief  The changes seen by record_device_change.
+ */
+static CHAR g_device_change_record[ DEVICE_CHANGE_RECORD_SIZE ];
+
+/*! \var    g_simulated_details_latency
+    \brief  The time (in milliseconds) load_simulated_device_details takes.
+ */
+static UINT32 g_simulated_details_latency = 0;
+
+/*! \var    g_number_of_completed_jobs
+    \brief  The number of jobs submitted by submit_sleeping_job that ran.
+ */
+static cahal_atomic_uint32 g_number_of_completed_jobs = 0;
+
+/*! \var    g_lifecycle_device
+    \brief  The device recorded from by stress_stream_lifecycle, set by
+            lifecycle_find_device.
+ */
+static cahal_device* g_lifecycle_device = NULL;
+
+/*! \var    g_lifecycle_user_data
+    \brief  The user data of every recording started by stress_stream_lifecycle.
+            Recording callbacks that see any other value used a freed
+            recording.
+ */
+static UINT32 g_lifecycle_user_data = 0;
+
+/*! \var    g_number_of_lifecycle_callbacks
+    \brief  The number of buffers recorded by stress_stream_lifecycle.
+ */
+static cahal_atomic_uint32 g_number_of_lifecycle_callbacks = 0;
+
+/*! \var    g_number_of_lifecycle_errors
+    \brief  The number of buffers recorded through a freed recording.
+ */
+static cahal_atomic_uint32 g_number_of_lifecycle_errors = 0;
+
+/*! \var    g_number_of_async_completions
+    \brief  The number of operations submitted by the wrapper whose
+            completion callback was called.
+ */
+static cahal_atomic_uint32 g_number_of_async_completions = 0;
+
+/*! \fn     CPC_BOOL fake_probe_callback (
+              UINT32  in_configuration,
+              UINT32  in_number_of_channels,
+              FLOAT64 in_sample_rate,
+              UINT32  in_bit_depth,
+              void*   in_user_data
+            )
+    \brief  The callback of the probers created by create_fake_prober.
+
+    \param  in_configuration  Ignored.
+    \param  in_number_of_channels The number of channels to test.
+    \param  in_sample_rate  The sample rate to test.
+    \param  in_bit_depth  The bit depth to test.
+    \param  in_user_data  The fake_prober_limits of the prober.
+    \return True iff the configuration does not exceed the limits.
+*/
+static
+CPC_BOOL
+fake_probe_callback(
+  UINT32  in_configuration,
+  UINT32  in_number_of_channels,
+  FLOAT64 in_sample_rate,
+  UINT32  in_bit_depth,
+  void*   in_user_data
+);
+
+/*! \fn     CHAR* create_simulated_string(
+              const CHAR* in_format,
+              UINT32      in_index
+            )
+    \brief  Returns a newly allocated string formatted from in_format, which
+            may contain a single %u that is replaced by in_index.
+
+    \param  in_format The format of the string.
+    \param  in_index  The value substituted into in_format.
+    \return The string or NULL on error.
+*/
+static
+CHAR*
+create_simulated_string(
+  const CHAR* in_format,
+  UINT32      in_index
+);
+
+/*! \fn     cahal_device_stream* create_simulated_stream(
+              cahal_device_stream_direction in_direction
+            )
+    \brief  Returns a newly allocated LPCM stream supporting 16-bit mono and
+            stereo at 8000 Hz and 44100 Hz.
+
+    \param  in_direction  The direction of the stream.
+    \return The stream or NULL on error.
+*/
+static
+cahal_device_stream*
+create_simulated_stream(
+  cahal_device_stream_direction in_direction
+);
+
+/*! \fn     CPC_BOOL load_simulated_device_details(
+              cahal_device* io_device
+            )
+    \brief  The details_loader of the devices created by
+            create_simulated_lazy_device_list. Waits for
+            g_simulated_details_latency milliseconds and moves the details of
+            a newly simulated device into io_device.
+
+    \param  io_device The device whose details are to be loaded.
+    \return True iff the details were loaded.
+*/
+static
+CPC_BOOL
+load_simulated_device_details(
+  cahal_device* io_device
+);
+
+/*! \fn     void record_device_change(
+              cahal_device_change_type in_change,
+              cahal_device*            in_device,
+              cahal_device_snapshot*   in_snapshot,
+              void*                    in_user_data
+            )
+    \brief  The callback of subscribe_device_change_recorder. Appends
+            "<change>:<uid>@<version> " to g_device_change_record.
+
+    \param  in_change The kind of change.
+    \param  in_device The device that changed.
+    \param  in_snapshot The new snapshot.
+    \param  in_user_data  Ignored.
+*/
+static
+void
+record_device_change(
+  cahal_device_change_type in_change,
+  cahal_device*            in_device,
+  cahal_device_snapshot*   in_snapshot,
+  void*                    in_user_data
+);
+
+/*! \fn     CPC_BOOL dispatch_recording_callback(
+              cahal_device* in_recording_device,
+              UCHAR*        in_data_buffer,
+              UINT32        in_data_buffer_length,
+              void*         in_user_data
+            )
+    \brief  Checks that the recorded bytes continue the sequence of the
+            dispatch_counter in in_user_data and counts them.
+
+    \param  in_recording_device Ignored.
+    \param  in_data_buffer  The recorded samples.
+    \param  in_data_buffer_length The size of in_data_buffer in bytes.
+    \param  in_user_data  The dispatch_counter.
+    \return True.
+*/
+static
+CPC_BOOL
+dispatch_recording_callback(
+  cahal_device* in_recording_device,
+  UCHAR*        in_data_buffer,
+  UINT32        in_data_buffer_length,
+  void*         in_user_data
+);
+
+/*! \fn     CPC_BOOL dispatch_playback_callback(
+              cahal_device* in_playback_device,
+              UCHAR*        out_data_buffer,
+              UINT32*       io_data_buffer_length,
+              void*         in_user_data
+            )
+    \brief  Fills the buffer with the sequence of the dispatch_counter in
+            in_user_data until it has been called maximum_calls times.
+
+    \param  in_playback_device  Ignored.
+    \param  out_data_buffer The buffer to fill.
+    \param  io_data_buffer_length The capacity of out_data_buffer.
+    \param  in_user_data  The dispatch_counter.
+    \return False once the callback has been called maximum_calls times.
+*/
+static
+CPC_BOOL
+dispatch_playback_callback(
+  cahal_device* in_playback_device,
+  UCHAR*        out_data_buffer,
+  UINT32*       io_data_buffer_length,
+  void*         in_user_data
+);
+
+/*! \fn     CPC_BOOL benchmark_recording_callback(
+              cahal_device* in_recording_device,
+              UCHAR*        in_data_buffer,
+              UINT32        in_data_buffer_length,
+              void*         in_user_data
+            )
+    \brief  Takes the GIL and calls the Python callback in in_user_data with
+            the recorded samples as bytes.
+
+    \param  in_recording_device Ignored.
+    \param  in_data_buffer  The recorded samples.
+    \param  in_data_buffer_length The size of in_data_buffer in bytes.
+    \param  in_user_data  The Python callback.
+    \return True iff the callback was called and did not raise.
+*/
+static
+CPC_BOOL
+benchmark_recording_callback(
+  cahal_device* in_recording_device,
+  UCHAR*        in_data_buffer,
+  UINT32        in_data_buffer_length,
+  void*         in_user_data
+);
+
+/*! \fn     CPC_BOOL record_periods(
+              cahal_recorder_info*  io_recorder_info,
+              UINT32                in_number_of_periods,
+              UINT32                in_period_size,
+              CPC_BOOL              in_is_counting
+            )
+    \brief  Records periods through cahal_process_recording between attaching
+            and detaching the coalescer of io_recorder_info, which is set up
+            as 48 kHz, mono, 16-bit PCM.
+
+    \param  io_recorder_info  The recording, with its callback and user data
+                              set.
+    \param  in_number_of_periods  The number of periods to record.
+    \param  in_period_size  The size of each period in bytes.
+    \param  in_is_counting  True to record a counting sequence, false to
+                            record silence.
+    \return True iff every period was accepted.
+*/
+static
+CPC_BOOL
+record_periods(
+  cahal_recorder_info*  io_recorder_info,
+  UINT32                in_number_of_periods,
+  UINT32                in_period_size,
+  CPC_BOOL              in_is_counting
+);
+
+/*! \fn     CPC_BOOL scheduled_playback_callback(
+              cahal_device* in_playback_device,
+              UCHAR*        out_data_buffer,
+              UINT32*       io_data_buffer_length,
+              void*         in_user_data
+            )
+    \brief  Fills every buffer of simulate_scheduled_playback with non-zero
+            samples.
+
+    \param  in_playback_device  Ignored.
+    \param  out_data_buffer The buffer to fill.
+    \param  io_data_buffer_length The capacity of out_data_buffer, which is
+                                  filled.
+    \param  in_user_data  Ignored.
+    \return True.
+*/
+static
+CPC_BOOL
+scheduled_playback_callback(
+  cahal_device* in_playback_device,
+  UCHAR*        out_data_buffer,
+  UINT32*       io_data_buffer_length,
+  void*         in_user_data
+);
+
+/*! \fn     void sleeping_job(
+              void*  in_argument,
+              UINT64 in_deadline
+            )
+    \brief  The routine of the jobs submitted by submit_sleeping_job.
+
+    \param  in_argument The time (in milliseconds) the job sleeps.
+    \param  in_deadline Ignored.
+*/
+static
+void
+sleeping_job(
+  void*  in_argument,
+  UINT64 in_deadline
+);
+
+/*! \fn     CPC_BOOL lifecycle_find_device( void )
+    \brief  Sets g_lifecycle_device to the first device in the device list
+            that can record.
+
+    \return True iff there is such a device.
+*/
+static
+CPC_BOOL
+lifecycle_find_device( void );
+
+/*! \fn     CPC_BOOL lifecycle_start_recording( void )
+    \brief  Starts a recording from g_lifecycle_device using
+            cahal_start_recording.
+
+    \return True iff this call started the recording.
+*/
+static
+CPC_BOOL
+lifecycle_start_recording( void );
+
+/*! \fn     CPC_BOOL lifecycle_stop_recording( void )
+    \brief  Stops the recording started by lifecycle_start_recording using
+            cahal_stop_recording.
+
+    \return True iff this call stopped the recording.
+*/
+static
+CPC_BOOL
+lifecycle_stop_recording( void );
+
+/*! \fn     void lifecycle_control_thread(
+              void* in_number_of_iterations
+            )
+    \brief  Alternately starts and stops the recording.
+
+    \param  in_number_of_iterations The number of starts and stops to try.
+*/
+static
+void
+lifecycle_control_thread(
+  void* in_number_of_iterations
+);
+
+/*! \fn     CPC_BOOL lifecycle_recording_callback(
+              cahal_device* in_recording_device,
+              UCHAR*        in_data_buffer,
+              UINT32        in_data_buffer_length,
+              void*         in_user_data
+            )
+    \brief  The recording callback of lifecycle_start_recording. Counts the
+            buffers and those recorded through a freed recording.
+
+    \param  in_recording_device Ignored.
+    \param  in_data_buffer  Ignored.
+    \param  in_data_buffer_length Ignored.
+    \param  in_user_data  &g_lifecycle_user_data unless the recording was
+                          freed.
+    \return True.
+*/
+static
+CPC_BOOL
+lifecycle_recording_callback(
+  cahal_device* in_recording_device,
+  UCHAR*        in_data_buffer,
+  UINT32        in_data_buffer_length,
+  void*         in_user_data
+);
+
+/*! \fn     CPC_BOOL lifecycle_async_start(
+              void* in_argument
+            )
+    \brief  The routine of start_lifecycle_recording_async.
+
+    \param  in_argument Ignored.
+    \return The result of lifecycle_start_recording.
+*/
+static
+CPC_BOOL
+lifecycle_async_start(
+  void* in_argument
+);
+
+/*! \fn     CPC_BOOL lifecycle_async_stop(
+              void* in_argument
+            )
+    \brief  The routine of stop_lifecycle_recording_async.
+
+    \param  in_argument Ignored.
+    \return The result of lifecycle_stop_recording.
+*/
+static
+CPC_BOOL
+lifecycle_async_stop(
+  void* in_argument
+);
+
+/*! \fn     CPC_BOOL sleeping_operation(
+              void* in_argument
+            )
+    \brief  The routine of submit_sleeping_operation.
+
+    \param  in_argument The time (in milliseconds) the operation sleeps.
+    \return True.
+*/
+static
+CPC_BOOL
+sleeping_operation(
+  void* in_argument
+);
+
+/*! \fn     void count_async_completion(
+              cahal_async_operation* in_operation,
+              CPC_BOOL               in_result,
+              void*                  in_user_data
+            )
+    \brief  The completion callback of the operations submitted by the
+            wrapper. Counts itself in get_number_of_async_completions.
+
+    \param  in_operation  Ignored.
+    \param  in_result Ignored.
+    \param  in_user_data  Ignored.
+*/
+static
+void
+count_async_completion(
+  cahal_async_operation* in_operation,
+  CPC_BOOL               in_result,
+  void*                  in_user_data
+);
+
+/*! \fn     CPC_BOOL aggregate_recorder_callback(
+              cahal_device* in_recording_device,
+              UCHAR*        in_data_buffer,
+              UINT32        in_data_buffer_length,
+              void*         in_user_data
+            )
+    \brief  Appends the consolidated frames of simulate_aggregate_recording
+            to its output.
+
+    \param  in_recording_device Ignored.
+    \param  in_data_buffer  The consolidated frames.
+    \param  in_data_buffer_length The number of bytes in in_data_buffer.
+    \param  in_user_data  The aggregate_output.
+    \return True.
+*/
+static
+CPC_BOOL
+aggregate_recorder_callback(
+  cahal_device* in_recording_device,
+  UCHAR*        in_data_buffer,
+  UINT32        in_data_buffer_length,
+  void*         in_user_data
+);
+
+/*! \fn     void aggregate_record(
+              cahal_aggregate_recording*  io_aggregate,
+              FLOAT64                     in_ppm,
+              FLOAT64                     in_start_offset,
+              UINT32                      in_number_of_frames,
+              INT16*                      io_buffer
+            )
+    \brief  Pushes the buffers of every member of io_aggregate in the order
+            their devices would deliver them, until the master has recorded
+            in_number_of_frames frames. Every member records the same signal
+            at the same time, with its own clock.
+
+    \param  io_aggregate  The aggregate recording, whose members are mono and
+                          16-bit.
+    \param  in_ppm  How much faster (in ppm) the clock of each member runs
+                    than the one of the member before it.
+    \param  in_start_offset The time (in seconds) each member starts
+                            recording at after the member before it, relative
+                            to the start time. The master starts at
+                            AGGREGATE_MASTER_OFFSET.
+    \param  in_number_of_frames The number of frames the master records.
+    \param  io_buffer The buffer recorded into, which holds the largest
+                      buffer of a member.
+*/
+static
+void
+aggregate_record(
+  cahal_aggregate_recording*  io_aggregate,
+  FLOAT64                     in_ppm,
+  FLOAT64                     in_start_offset,
+  UINT32                      in_number_of_frames,
+  INT16*                      io_buffer
+);
 
 cahal_device*
 cahal_device_list_get(
@@ -311,11 +910,1792 @@ python_playback_callback(
   return( return_value );
 }
 
+PyObject*
+start_playback_generator(
+  cahal_device*           in_device,
+  FLOAT32                 in_volume,
+  cahal_signal_generator* in_generator
+)
+{
+  CPC_BOOL result = CPC_FALSE;
+
+  if( NULL == in_generator )
+  {
+    CPC_LOG_STRING  (
+                     CPC_LOG_LEVEL_ERROR,
+                     "Generator passed to start_playback_generator is null."
+                     );
+  }
+  else
+  {
+    result = cahal_start_playback(
+      in_device,
+      CAHAL_AUDIO_FORMAT_LINEARPCM,
+      in_generator->number_of_channels,
+      in_generator->sample_rate,
+      in_generator->bit_depth,
+      in_volume,
+      cahal_signal_generator_playback_callback,
+      in_generator,
+      in_generator->format_flags
+      );
+  }
+
+  if( result )
+  {
+    Py_RETURN_TRUE;
+  }
+  else
+  {
+    Py_RETURN_FALSE;
+  }
+}
+
+cahal_prober*
+create_fake_prober(
+  UINT32  in_maximum_channels,
+  FLOAT64 in_maximum_sample_rate,
+  UINT32  in_maximum_bit_depth,
+  UINT32  in_latency
+)
+{
+  fake_prober_limits* limits  = NULL;
+  cahal_prober* prober        = NULL;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &limits, sizeof( fake_prober_limits ) )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc limits." );
+
+    return( NULL );
+  }
+
+  limits->maximum_channels    = in_maximum_channels;
+  limits->maximum_sample_rate = in_maximum_sample_rate;
+  limits->maximum_bit_depth   = in_maximum_bit_depth;
+  limits->latency             = in_latency;
+
+  prober =
+    cahal_prober_create (
+                         fake_probe_callback,
+                         limits,
+                         CAHAL_AUDIO_FORMAT_LINEARPCM
+                         );
+
+  if( NULL == prober )
+  {
+    cpc_safe_free( ( void** ) &limits );
+  }
+
+  return( prober );
+}
+
 void
-python_cahal_initialize( void )
+free_fake_prober(
+  cahal_prober* in_prober
+)
 {
-//  Py_Initialize();
-//  PyEval_InitThreads();
-  
-  cahal_initialize();
+  if( NULL != in_prober )
+  {
+    cpc_safe_free( ( void** ) &( in_prober->user_data ) );
+
+    cahal_prober_free( in_prober );
+  }
+}
+
+CPC_BOOL
+add_simulated_device(
+  cahal_probe_scheduler*  io_scheduler,
+  const CHAR*             in_device_name,
+  cahal_prober*           in_prober,
+  UINT64                  in_fingerprint
+)
+{
+  cahal_device* device        = NULL;
+  cahal_device_stream* stream = NULL;
+
+  if  (
+       NULL == in_device_name
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc( ( void** ) &device, sizeof( cahal_device ) )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( device->device_name ),
+                               strlen( in_device_name ) + 1
+                               )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &stream,
+                               sizeof( cahal_device_stream )
+                               )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc device." );
+
+    cahal_free_device( device );
+
+    return( CPC_FALSE );
+  }
+
+  memcpy( device->device_name, in_device_name, strlen( in_device_name ) );
+
+  stream->direction = CAHAL_DEVICE_INPUT_STREAM;
+
+  if  (
+       ! cahal_probe_scheduler_add (
+                                    io_scheduler,
+                                    device,
+                                    stream,
+                                    in_prober,
+                                    0,
+                                    in_device_name,
+                                    in_fingerprint
+                                    )
+       )
+  {
+    cahal_free_device_stream( stream );
+    cahal_free_device( device );
+
+    return( CPC_FALSE );
+  }
+
+  return( CPC_TRUE );
+}
+
+cahal_device**
+create_simulated_device_list(
+  UINT32 in_number_of_devices
+)
+{
+  cahal_device** device_list  = NULL;
+  CPC_BOOL created            = CPC_TRUE;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc (
+                           ( void** ) &device_list,
+                           sizeof( cahal_device* )
+                           * ( in_number_of_devices + 1 )
+                           )
+       )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not malloc device list." );
+
+    return( NULL );
+  }
+
+  for( UINT32 i = 0; i < in_number_of_devices && created; i++ )
+  {
+    cahal_device* device = NULL;
+
+    created =
+      CPC_ERROR_CODE_NO_ERROR
+      == cpc_safe_malloc( ( void** ) &device, sizeof( cahal_device ) );
+
+    if( created )
+    {
+      device_list[ i ] = device;
+
+      device->device_name   = create_simulated_string( "Simulated %u", i );
+      device->model         = create_simulated_string( "Simulator", i );
+      device->manufacturer  = create_simulated_string( "CAHAL", i );
+      device->device_uid    = create_simulated_string( "simulated-%u", i );
+      device->model_uid     = create_simulated_string( "simulator", i );
+
+      device->preferred_sample_rate         = 44100;
+      device->preferred_number_of_channels  = 2;
+      device->is_alive                      = 1;
+
+      created =
+        NULL != device->device_name
+        && NULL != device->model
+        && NULL != device->manufacturer
+        && NULL != device->device_uid
+        && NULL != device->model_uid
+        && CPC_ERROR_CODE_NO_ERROR
+           == cpc_safe_malloc (
+                               ( void** ) &( device->device_streams ),
+                               sizeof( cahal_device_stream* ) * 3
+                               )
+        && CPC_ERROR_CODE_NO_ERROR
+           == cpc_safe_malloc (
+                               ( void** ) &( device->supported_sample_rates ),
+                               sizeof( cahal_sample_rate_range* ) * 2
+                               )
+        && CPC_ERROR_CODE_NO_ERROR
+           == cpc_safe_malloc (
+                               ( void** ) device->supported_sample_rates,
+                               sizeof( cahal_sample_rate_range )
+                               );
+    }
+
+    if( created )
+    {
+      device->supported_sample_rates[ 0 ]->minimum_rate = 8000;
+      device->supported_sample_rates[ 0 ]->maximum_rate = 44100;
+
+      device->device_streams[ 0 ] =
+        create_simulated_stream( CAHAL_DEVICE_INPUT_STREAM );
+      device->device_streams[ 1 ] =
+        create_simulated_stream( CAHAL_DEVICE_OUTPUT_STREAM );
+
+      created =
+        NULL != device->device_streams[ 0 ]
+        && NULL != device->device_streams[ 1 ];
+
+      if( created )
+      {
+        device->device_streams[ 0 ]->handle = 2 * i;
+        device->device_streams[ 1 ]->handle = 2 * i + 1;
+      }
+    }
+  }
+
+  if( ! created )
+  {
+    CPC_LOG_STRING( CPC_LOG_LEVEL_ERROR, "Could not create devices." );
+
+    free_simulated_device_list( device_list );
+
+    device_list = NULL;
+  }
+
+  return( device_list );
+}
+
+cahal_device**
+create_simulated_lazy_device_list(
+  UINT32    in_number_of_devices,
+  UINT32    in_latency,
+  CPC_BOOL  in_lazy
+)
+{
+  cahal_device** device_list  =
+    create_simulated_device_list( in_number_of_devices );
+  CPC_BOOL loaded             = CPC_TRUE;
+
+  g_simulated_details_latency = in_latency;
+
+  for( UINT32 i = 0; NULL != device_list && NULL != device_list[ i ]; i++ )
+  {
+    //  Strip the device down to what enumeration reads.
+    device_list[ i ]->details_loader  = load_simulated_device_details;
+    device_list[ i ]->details_state   = CAHAL_ONCE_DONE;
+
+    cahal_free_device_details( device_list[ i ] );
+
+    device_list[ i ]->details_state   = CAHAL_ONCE_PENDING;
+
+    if( ! in_lazy )
+    {
+      loaded = cahal_load_device_details( device_list[ i ] ) && loaded;
+    }
+  }
+
+  if( ! loaded )
+  {
+    free_simulated_device_list( device_list );
+
+    device_list = NULL;
+  }
+
+  return( device_list );
+}
+
+void
+free_simulated_device_list(
+  cahal_device** in_device_list
+)
+{
+  if( NULL != in_device_list )
+  {
+    for( UINT32 i = 0; NULL != in_device_list[ i ]; i++ )
+    {
+      cahal_free_device( in_device_list[ i ] );
+    }
+
+    cpc_safe_free( ( void** ) &in_device_list );
+  }
+}
+
+UINT32
+subscribe_device_change_recorder( void )
+{
+  clear_device_change_record();
+
+  return( cahal_subscribe_device_changes( record_device_change, NULL ) );
+}
+
+const CHAR*
+get_device_change_record( void )
+{
+  return( g_device_change_record );
+}
+
+void
+clear_device_change_record( void )
+{
+  g_device_change_record[ 0 ] = 0;
+}
+
+UINT32
+simulate_dispatched_recording(
+  UINT32              in_number_of_buffers,
+  UINT32              in_buffer_size,
+  cahal_thread_policy in_policy
+)
+{
+  cahal_dispatch_options options;
+  cahal_recorder_info recorder_info;
+  dispatch_counter counter;
+
+  cahal_dispatcher* dispatcher  = NULL;
+  UCHAR* buffer                 = NULL;
+  UCHAR value                   = 0;
+
+  memset( &options, 0, sizeof( cahal_dispatch_options ) );
+  memset( &recorder_info, 0, sizeof( cahal_recorder_info ) );
+  memset( &counter, 0, sizeof( dispatch_counter ) );
+
+  options.scheduling.policy   = in_policy;
+  options.scheduling.priority = 1;
+
+  counter.is_in_order = CPC_TRUE;
+
+  recorder_info.recording_callback  = dispatch_recording_callback;
+  recorder_info.user_data           = &counter;
+  recorder_info.format_id           = CAHAL_AUDIO_FORMAT_LINEARPCM;
+  recorder_info.number_of_channels  = 1;
+  recorder_info.sample_rate         = 8000;
+  recorder_info.bit_depth           = 8;
+
+  if(
+    CPC_ERROR_CODE_NO_ERROR
+    != cpc_safe_malloc( ( void** ) &buffer, in_buffer_size )
+    )
+  {
+    return( 0 );
+  }
+
+  dispatcher =
+    cahal_dispatcher_create (
+                             &options,
+                             CAHAL_DEVICE_INPUT_STREAM,
+                             &recorder_info,
+                             in_buffer_size
+                             );
+
+  if( NULL != dispatcher )
+  {
+    for( UINT32 i = 0; i < in_number_of_buffers; i++ )
+    {
+      for( UINT32 j = 0; j < in_buffer_size; j++ )
+      {
+        buffer[ j ] = value++;
+      }
+
+      //  Wait for room rather than counting the buffer as an overrun
+      while(
+        sizeof( cahal_dispatch_packet_header ) + in_buffer_size
+        > cahal_ring_buffer_get_space( dispatcher->ring_buffer )
+        )
+      {
+        cahal_sleep( 1 );
+      }
+
+      cahal_dispatcher_push_recording(
+        dispatcher,
+        buffer,
+        in_buffer_size,
+        cahal_get_time()
+      );
+    }
+
+    cahal_dispatcher_free( dispatcher );
+  }
+
+  cpc_safe_free( ( void** ) &buffer );
+
+  return( counter.is_in_order ? counter.number_of_bytes : 0 );
+}
+
+UINT32
+simulate_dispatched_playback(
+  UINT32 in_number_of_buffers,
+  UINT32 in_buffer_size,
+  UINT32 in_number_of_renders
+)
+{
+  cahal_dispatch_options options;
+  cahal_playback_info playback_info;
+  dispatch_counter counter;
+
+  cahal_dispatcher* dispatcher  = NULL;
+  UCHAR* buffer                 = NULL;
+  UCHAR value                   = 0;
+  UINT32 number_of_bytes        = 0;
+  CPC_BOOL is_in_order          = CPC_TRUE;
+
+  memset( &options, 0, sizeof( cahal_dispatch_options ) );
+  memset( &playback_info, 0, sizeof( cahal_playback_info ) );
+  memset( &counter, 0, sizeof( dispatch_counter ) );
+
+  counter.maximum_calls = in_number_of_renders;
+
+  playback_info.playback_callback   = dispatch_playback_callback;
+  playback_info.user_data           = &counter;
+  playback_info.format_id           = CAHAL_AUDIO_FORMAT_LINEARPCM;
+  playback_info.number_of_channels  = 1;
+  playback_info.sample_rate         = 8000;
+  playback_info.bit_depth           = 8;
+
+  if(
+    CPC_ERROR_CODE_NO_ERROR
+    != cpc_safe_malloc( ( void** ) &buffer, in_buffer_size )
+    )
+  {
+    return( 0 );
+  }
+
+  dispatcher =
+    cahal_dispatcher_create (
+                             &options,
+                             CAHAL_DEVICE_OUTPUT_STREAM,
+                             &playback_info,
+                             in_buffer_size
+                             );
+
+  if( NULL != dispatcher )
+  {
+    for( UINT32 i = 0; i < in_number_of_buffers && is_in_order; i++ )
+    {
+      UINT32 length = in_buffer_size;
+
+      //  Wait for the samples rather than playing silence
+      while(
+        in_buffer_size
+        > cahal_ring_buffer_get_fill( dispatcher->ring_buffer )
+        && ! CAHAL_ATOMIC_LOAD( &( dispatcher->has_failed ) )
+        )
+      {
+        cahal_sleep( 1 );
+      }
+
+      if(
+        ! cahal_dispatcher_pull_playback(
+          dispatcher,
+          buffer,
+          &length,
+          0
+        )
+        )
+      {
+        break;
+      }
+
+      for( UINT32 j = 0; j < length; j++ )
+      {
+        is_in_order = is_in_order && value++ == buffer[ j ];
+      }
+
+      number_of_bytes += length;
+    }
+
+    cahal_dispatcher_free( dispatcher );
+  }
+
+  cpc_safe_free( ( void** ) &buffer );
+
+  return( is_in_order ? number_of_bytes : 0 );
+}
+
+CPC_BOOL
+submit_sleeping_job(
+  cahal_worker_pool*  io_pool,
+  UINT32              in_stream,
+  UINT32              in_duration
+)
+{
+  return(
+    cahal_worker_pool_submit(
+      io_pool,
+      in_stream,
+      sleeping_job,
+      ( void* ) ( SIZE ) in_duration
+    )
+  );
+}
+
+UINT32
+get_number_of_completed_jobs( void )
+{
+  return( CAHAL_ATOMIC_LOAD( &g_number_of_completed_jobs ) );
+}
+
+void
+clear_number_of_completed_jobs( void )
+{
+  CAHAL_ATOMIC_STORE( &g_number_of_completed_jobs, 0 );
+}
+
+CPC_BOOL
+stress_stream_lifecycle(
+  UINT32 in_number_of_threads,
+  UINT32 in_number_of_iterations
+)
+{
+  cahal_thread* threads     = NULL;
+  UINT32 number_of_threads  = 0;
+
+  if(
+    ! lifecycle_find_device()
+    || CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc(
+         ( void** ) &threads,
+         in_number_of_threads * sizeof( cahal_thread )
+       )
+    )
+  {
+    return( CPC_FALSE );
+  }
+
+  CAHAL_ATOMIC_STORE( &g_number_of_lifecycle_callbacks, 0 );
+  CAHAL_ATOMIC_STORE( &g_number_of_lifecycle_errors, 0 );
+
+  for(
+    number_of_threads = 0;
+    number_of_threads < in_number_of_threads;
+    number_of_threads++
+    )
+  {
+    if(
+      ! cahal_thread_create(
+        &( threads[ number_of_threads ] ),
+        lifecycle_control_thread,
+        ( void* ) ( SIZE ) in_number_of_iterations
+      )
+      )
+    {
+      break;
+    }
+  }
+
+  for( UINT32 i = 0; i < number_of_threads; i++ )
+  {
+    cahal_thread_join( &( threads[ i ] ) );
+  }
+
+  //  The recordings of the storm may all be too short to see a buffer, so
+  //  one is held open until a buffer reaches the callback
+  lifecycle_stop_recording();
+
+  if( lifecycle_start_recording() )
+  {
+    for(
+      UINT32 i = 0;
+      i < LIFECYCLE_CALLBACK_TIMEOUT
+      && 0 == CAHAL_ATOMIC_LOAD( &g_number_of_lifecycle_callbacks );
+      i++
+    )
+    {
+      cahal_sleep( 1 );
+    }
+  }
+
+  lifecycle_stop_recording();
+
+  cpc_safe_free( ( void** ) &threads );
+
+  return(
+    number_of_threads == in_number_of_threads
+    && 0 < CAHAL_ATOMIC_LOAD( &g_number_of_lifecycle_callbacks )
+    && 0 == CAHAL_ATOMIC_LOAD( &g_number_of_lifecycle_errors )
+    && CAHAL_STREAM_STATE_RUNNING
+       != cahal_stream_state_get( &g_cahal_recording_state )
+  );
+}
+
+cahal_async_operation*
+start_lifecycle_recording_async( void )
+{
+  return(
+    cahal_async_submit(
+      lifecycle_async_start,
+      NULL,
+      count_async_completion,
+      NULL
+    )
+  );
+}
+
+cahal_async_operation*
+stop_lifecycle_recording_async( void )
+{
+  return(
+    cahal_async_submit(
+      lifecycle_async_stop,
+      NULL,
+      count_async_completion,
+      NULL
+    )
+  );
+}
+
+cahal_async_operation*
+submit_sleeping_operation(
+  UINT32 in_duration
+)
+{
+  return(
+    cahal_async_submit(
+      sleeping_operation,
+      ( void* ) ( SIZE ) in_duration,
+      count_async_completion,
+      NULL
+    )
+  );
+}
+
+UINT32
+get_number_of_async_completions( void )
+{
+  return( CAHAL_ATOMIC_LOAD( &g_number_of_async_completions ) );
+}
+
+void
+clear_number_of_async_completions( void )
+{
+  CAHAL_ATOMIC_STORE( &g_number_of_async_completions, 0 );
+}
+
+UINT32
+simulate_coalesced_recording(
+  UINT32 in_number_of_periods,
+  UINT32 in_period_size
+)
+{
+  cahal_recorder_info recorder_info;
+  dispatch_counter counter;
+
+  memset( &recorder_info, 0, sizeof( cahal_recorder_info ) );
+  memset( &counter, 0, sizeof( dispatch_counter ) );
+
+  counter.is_in_order = CPC_TRUE;
+
+  recorder_info.recording_callback  = dispatch_recording_callback;
+  recorder_info.user_data           = &counter;
+
+  if(
+    ! record_periods(
+      &recorder_info,
+      in_number_of_periods,
+      in_period_size,
+      CPC_TRUE
+    )
+    || ! counter.is_in_order
+    || in_number_of_periods * in_period_size != counter.number_of_bytes
+    )
+  {
+    return( 0 );
+  }
+
+  return( counter.number_of_calls );
+}
+
+CPC_BOOL
+benchmark_recording(
+  UINT32    in_number_of_periods,
+  UINT32    in_period_size,
+  PyObject* in_callback_function
+)
+{
+  cahal_recorder_info recorder_info;
+
+  if( ! PyCallable_Check( in_callback_function ) )
+  {
+    CPC_LOG_STRING(
+      CPC_LOG_LEVEL_ERROR,
+      "Callback passed to benchmark_recording is not callable."
+    );
+
+    return( CPC_FALSE );
+  }
+
+  memset( &recorder_info, 0, sizeof( cahal_recorder_info ) );
+
+  recorder_info.recording_callback  = benchmark_recording_callback;
+  recorder_info.user_data           = in_callback_function;
+
+  return(
+    record_periods(
+      &recorder_info,
+      in_number_of_periods,
+      in_period_size,
+      CPC_FALSE
+    )
+  );
+}
+
+UINT32
+simulate_scheduled_playback(
+  UINT32    in_number_of_periods,
+  UINT32    in_period_size,
+  UINT32    in_queued_bytes,
+  CPC_BOOL  in_is_priming
+)
+{
+  cahal_playback_info playback_info;
+  UCHAR* buffer       = NULL;
+  UINT32 silence      = 0;
+  CPC_BOOL is_silent  = CPC_TRUE;
+
+  memset( &playback_info, 0, sizeof( cahal_playback_info ) );
+
+  playback_info.playback_callback   = scheduled_playback_callback;
+  playback_info.format_id           = CAHAL_AUDIO_FORMAT_LINEARPCM;
+  playback_info.number_of_channels  = 1;
+  playback_info.sample_rate         = 48000;
+  playback_info.bit_depth           = 16;
+  playback_info.format_flags        =
+    CAHAL_AUDIO_FORMAT_FLAGISSIGNEDINTEGER | CAHAL_AUDIO_FORMAT_FLAGISPACKED;
+
+  if(
+    CPC_ERROR_CODE_NO_ERROR
+    != cpc_safe_malloc( ( void** ) &buffer, in_period_size )
+    )
+  {
+    return( 0 );
+  }
+
+  if(
+    ! cahal_attach_playback_schedule( &playback_info )
+    || ! cahal_stream_state_begin_start( &g_cahal_playback_state )
+    )
+  {
+    cahal_detach_playback_schedule( &playback_info );
+
+    cpc_safe_free( ( void** ) &buffer );
+
+    return( 0 );
+  }
+
+  cahal_stream_state_end_start( &g_cahal_playback_state, CPC_TRUE );
+
+  for( UINT32 i = 0; i < in_number_of_periods; i++ )
+  {
+    UINT32 length = in_period_size;
+    UINT32 queued = in_queued_bytes;
+
+    if( in_is_priming && i * in_period_size < in_queued_bytes )
+    {
+      queued = i * in_period_size;
+    }
+
+    cahal_dispatch_playback(
+      &playback_info,
+      buffer,
+      &length,
+      queued
+    );
+
+    for( UINT32 j = 0; is_silent && j < length; j++ )
+    {
+      if( 0 == buffer[ j ] )
+      {
+        silence++;
+      }
+      else
+      {
+        is_silent = CPC_FALSE;
+      }
+    }
+  }
+
+  cahal_stream_state_begin_stop( &g_cahal_playback_state, NULL );
+  cahal_stream_state_wait_for_callbacks( &g_cahal_playback_state );
+  cahal_stream_state_end_stop( &g_cahal_playback_state );
+
+  cahal_detach_playback_schedule( &playback_info );
+
+  cpc_safe_free( ( void** ) &buffer );
+
+  return( silence );
+}
+
+CPC_BOOL
+record_pollable(
+  cahal_pollable_stream*  io_stream,
+  UINT32                  in_length,
+  UCHAR                   in_first_value
+)
+{
+  CPC_BOOL result = CPC_FALSE;
+  UCHAR* buffer   = NULL;
+
+  if(
+    CPC_ERROR_CODE_NO_ERROR
+    == cpc_safe_malloc( ( void** ) &buffer, in_length )
+    )
+  {
+    for( UINT32 i = 0; i < in_length; i++ )
+    {
+      buffer[ i ] = in_first_value++;
+    }
+
+    result =
+      cahal_pollable_recorder_callback( NULL, buffer, in_length, io_stream );
+
+    cpc_safe_free( ( void** ) &buffer );
+  }
+
+  return( result );
+}
+
+PyObject*
+read_pollable(
+  cahal_pollable_stream*  io_stream,
+  UINT32                  in_length
+)
+{
+  PyObject* samples = NULL;
+  UCHAR* buffer     = NULL;
+
+  if(
+    CPC_ERROR_CODE_NO_ERROR
+    == cpc_safe_malloc( ( void** ) &buffer, in_length + 1 )
+    )
+  {
+    UINT32 length = cahal_pollable_read( io_stream, buffer, in_length );
+
+    samples =
+      PyBytes_FromStringAndSize( ( const char* ) buffer, length );
+
+    cpc_safe_free( ( void** ) &buffer );
+  }
+
+  if( NULL == samples )
+  {
+    Py_RETURN_NONE;
+  }
+
+  return( samples );
+}
+
+UINT32
+play_pollable(
+  cahal_pollable_stream*  io_stream,
+  UINT32                  in_length
+)
+{
+  UINT32 length = in_length;
+  UCHAR* buffer = NULL;
+
+  if(
+    CPC_ERROR_CODE_NO_ERROR
+    != cpc_safe_malloc( ( void** ) &buffer, in_length + 1 )
+    )
+  {
+    return( 0 );
+  }
+
+  cahal_pollable_playback_callback( NULL, buffer, &length, io_stream );
+
+  cpc_safe_free( ( void** ) &buffer );
+
+  return( length );
+}
+
+UINT32
+write_pollable(
+  cahal_pollable_stream*  io_stream,
+  UINT32                  in_length
+)
+{
+  UINT32 length = 0;
+  UCHAR* buffer = NULL;
+
+  if(
+    CPC_ERROR_CODE_NO_ERROR
+    == cpc_safe_malloc( ( void** ) &buffer, in_length + 1 )
+    )
+  {
+    length = cahal_pollable_write( io_stream, buffer, in_length );
+
+    cpc_safe_free( ( void** ) &buffer );
+  }
+
+  return( length );
+}
+
+FLOAT64
+simulate_aggregate_recording(
+  UINT32  in_number_of_members,
+  FLOAT64 in_ppm,
+  FLOAT64 in_start_offset,
+  UINT32  in_duration
+)
+{
+  cahal_aggregate_recording* aggregate  = NULL;
+  INT16* buffer                         = NULL;
+  FLOAT64 sample_rate                   = 8000;
+  UINT32 number_of_frames               = in_duration * 8000;
+  UINT32 compared_frames                = 10 * 8000;
+  FLOAT64 difference                    = -1;
+  UINT32 channels[ AGGREGATE_MAXIMUM_MEMBERS ];
+  aggregate_output output;
+
+  if(
+    0 == in_number_of_members
+    || AGGREGATE_MAXIMUM_MEMBERS < in_number_of_members
+    || number_of_frames
+      < compared_frames + ( CAHAL_AGGREGATE_LATENCY + 1 ) * sample_rate
+    )
+  {
+    return( difference );
+  }
+
+  memset( &output, 0, sizeof( aggregate_output ) );
+
+  for( UINT32 i = 0; i < in_number_of_members; i++ )
+  {
+    channels[ i ] = 1;
+  }
+
+  output.capacity = number_of_frames * in_number_of_members * sizeof( INT16 );
+
+  if(
+    CPC_ERROR_CODE_NO_ERROR
+    == cpc_safe_malloc( ( void** ) &output.samples, output.capacity )
+    && CPC_ERROR_CODE_NO_ERROR
+    == cpc_safe_malloc(
+      ( void** ) &buffer,
+      sizeof( INT16 ) * AGGREGATE_PERIOD_SIZE * in_number_of_members
+    )
+    )
+  {
+    aggregate =
+      cahal_aggregate_recording_create(
+        in_number_of_members,
+        NULL,
+        channels,
+        CAHAL_AUDIO_FORMAT_LINEARPCM,
+        sample_rate,
+        16,
+        aggregate_recorder_callback,
+        &output,
+        CAHAL_AUDIO_FORMAT_FLAGISSIGNEDINTEGER
+        | CAHAL_AUDIO_FORMAT_FLAGISPACKED,
+        AGGREGATE_START_TIME
+      );
+  }
+
+  if( NULL != aggregate )
+  {
+    INT16* samples  = ( INT16* ) output.samples;
+    UINT32 frames   = 0;
+
+    aggregate_record(
+      aggregate,
+      in_ppm,
+      in_start_offset,
+      number_of_frames,
+      buffer
+    );
+
+    frames = output.length / ( sizeof( INT16 ) * in_number_of_members );
+
+    //  All but the latency must have been consolidated. The last frames of
+    //  every member are compared to the ones of the master.
+    if(
+      frames
+      >= number_of_frames - ( CAHAL_AGGREGATE_LATENCY + 1 ) * sample_rate
+      )
+    {
+      difference = 0;
+
+      for( UINT32 i = 1; i < in_number_of_members; i++ )
+      {
+        FLOAT64 sum = 0;
+
+        for( UINT32 j = frames - compared_frames; j < frames; j++ )
+        {
+          FLOAT64 error =
+            (
+              samples[ j * in_number_of_members + i ]
+              - samples[ j * in_number_of_members ]
+            ) / 16384.0;
+
+          sum += error * error;
+        }
+
+        sum = sqrt( sum / compared_frames );
+
+        if( difference < sum )
+        {
+          difference = sum;
+        }
+      }
+    }
+
+    cahal_aggregate_recording_free( aggregate );
+  }
+
+  if( NULL != buffer )
+  {
+    cpc_safe_free( ( void** ) &buffer );
+  }
+
+  if( NULL != output.samples )
+  {
+    cpc_safe_free( ( void** ) &output.samples );
+  }
+
+  return( difference );
+}
+
+FLOAT64
+simulate_drift(
+  cahal_drift_resampler*  io_resampler,
+  FLOAT64                 in_ppm,
+  UINT32                  in_duration
+)
+{
+  UINT32 period_size        = 0;
+  FLOAT32* frames           = NULL;
+  FLOAT64 written           = 0;
+  FLOAT64 number_of_frames  = 0;
+  FLOAT64 maximum_latency   = -1;
+
+  if( NULL == io_resampler )
+  {
+    return( maximum_latency );
+  }
+
+  //  10 ms periods, with room for the extra frames of a faster recording
+  period_size = ( UINT32 ) ( io_resampler->sample_rate / 100 );
+
+  if(
+    CPC_ERROR_CODE_NO_ERROR
+    != cpc_safe_malloc(
+      ( void** ) &frames,
+      sizeof( FLOAT32 ) * 2 * period_size * io_resampler->number_of_channels
+    )
+    )
+  {
+    return( maximum_latency );
+  }
+
+  maximum_latency = 0;
+
+  for( UINT32 i = 0; i < in_duration * 100; i++ )
+  {
+    UINT32 length = 0;
+
+    number_of_frames += period_size * ( 1 + in_ppm * 1e-6 );
+    length            = ( UINT32 ) ( number_of_frames - written );
+
+    for( UINT32 j = 0; j < length * io_resampler->number_of_channels; j++ )
+    {
+      frames[ j ] = 0.5f * ( FLOAT32 ) sin( ( written + j ) * 0.01 );
+    }
+
+    cahal_drift_resampler_write( io_resampler, frames, length );
+
+    written += length;
+
+    if( maximum_latency < cahal_drift_resampler_get_latency( io_resampler ) )
+    {
+      maximum_latency = cahal_drift_resampler_get_latency( io_resampler );
+    }
+
+    cahal_drift_resampler_read( io_resampler, frames, period_size );
+  }
+
+  cpc_safe_free( ( void** ) &frames );
+
+  return( maximum_latency );
+}
+
+UINT32
+simulate_drift_ramp(
+  cahal_drift_resampler*  io_resampler,
+  FLOAT64                 in_ppm,
+  UINT32                  in_number_of_periods
+)
+{
+  UINT32 read_sizes[]               = { 1, 3, 7, 13, 40 };
+  UINT32 channels                   = 0;
+  FLOAT32* frames                   = NULL;
+  FLOAT64 written                   = 0;
+  FLOAT64 number_of_frames          = 0;
+  FLOAT32 last                      = 0;
+  UINT32 number_of_discontinuities  = 0;
+
+  if( NULL == io_resampler )
+  {
+    return( number_of_discontinuities );
+  }
+
+  channels = io_resampler->number_of_channels;
+
+  if(
+    CPC_ERROR_CODE_NO_ERROR
+    != cpc_safe_malloc(
+      ( void** ) &frames,
+      sizeof( FLOAT32 ) * 2 * 64 * channels
+    )
+    )
+  {
+    return( number_of_discontinuities );
+  }
+
+  for( UINT32 i = 0; i < in_number_of_periods; i++ )
+  {
+    UINT32 length = 0;
+
+    number_of_frames += 64 * ( 1 + in_ppm * 1e-6 );
+    length            = ( UINT32 ) ( number_of_frames - written );
+
+    for( UINT32 j = 0; j < length * channels; j++ )
+    {
+      frames[ j ] = ( FLOAT32 ) ( written + j / channels );
+    }
+
+    cahal_drift_resampler_write( io_resampler, frames, length );
+
+    written += length;
+
+    for(
+      UINT32 j = 0;
+      j < sizeof( read_sizes ) / sizeof( read_sizes[ 0 ] );
+      j++
+    )
+    {
+      cahal_drift_resampler_read( io_resampler, frames, read_sizes[ j ] );
+
+      for( UINT32 k = 0; k < read_sizes[ j ]; k++ )
+      {
+        FLOAT32 frame = frames[ k * channels ];
+
+        //  Until the ramp is past the silence and zeroed history of priming
+        if( 16 < last && 0.25 < fabs( frame - last - 1 ) )
+        {
+          number_of_discontinuities++;
+        }
+
+        last = frame;
+      }
+    }
+  }
+
+  cpc_safe_free( ( void** ) &frames );
+
+  return( number_of_discontinuities );
+}
+
+void
+python_cahal_initialize( void )
+{
+//  Py_Initialize();
+//  PyEval_InitThreads();
+  
+  cahal_initialize();
+}
+
+static
+CPC_BOOL
+fake_probe_callback(
+  UINT32  in_configuration,
+  UINT32  in_number_of_channels,
+  FLOAT64 in_sample_rate,
+  UINT32  in_bit_depth,
+  void*   in_user_data
+)
+{
+  fake_prober_limits* limits = ( fake_prober_limits* ) in_user_data;
+
+  if( 0 < limits->latency )
+  {
+    cahal_sleep( limits->latency );
+  }
+
+  return  (
+           in_number_of_channels <= limits->maximum_channels
+           && in_sample_rate <= limits->maximum_sample_rate
+           && in_bit_depth <= limits->maximum_bit_depth
+           );
+}
+
+static
+CHAR*
+create_simulated_string(
+  const CHAR* in_format,
+  UINT32      in_index
+)
+{
+  CHAR* string  = NULL;
+  CHAR buffer[ 64 ];
+  INT32 length  = snprintf( buffer, sizeof( buffer ), in_format, in_index );
+
+  if  (
+       0 <= length
+       && CPC_ERROR_CODE_NO_ERROR
+          == cpc_safe_malloc( ( void** ) &string, length + 1 )
+       )
+  {
+    memcpy( string, buffer, length );
+  }
+
+  return( string );
+}
+
+static
+cahal_device_stream*
+create_simulated_stream(
+  cahal_device_stream_direction in_direction
+)
+{
+  cahal_device_stream* stream = NULL;
+  UINT32 index                = 0;
+
+  if  (
+       CPC_ERROR_CODE_NO_ERROR
+       != cpc_safe_malloc( ( void** ) &stream, sizeof( cahal_device_stream ) )
+       || CPC_ERROR_CODE_NO_ERROR
+          != cpc_safe_malloc  (
+                               ( void** ) &( stream->supported_formats ),
+                               sizeof( cahal_audio_format_description* ) * 5
+                               )
+       )
+  {
+    cahal_free_device_stream( stream );
+
+    return( NULL );
+  }
+
+  stream->direction         = in_direction;
+  stream->preferred_format  = CAHAL_AUDIO_FORMAT_LINEARPCM;
+
+  for( UINT32 channels = 1; channels <= 2; channels++ )
+  {
+    FLOAT64 rates[] = { 8000, 44100 };
+
+    for( UINT32 i = 0; i < 2; i++ )
+    {
+      cahal_audio_format_description* format = NULL;
+
+      if  (
+           CPC_ERROR_CODE_NO_ERROR
+           != cpc_safe_malloc  (
+                                ( void** ) &format,
+                                sizeof( cahal_audio_format_description )
+                                )
+           )
+      {
+        cahal_free_device_stream( stream );
+
+        return( NULL );
+      }
+
+      format->format_id                       = CAHAL_AUDIO_FORMAT_LINEARPCM;
+      format->number_of_channels              = channels;
+      format->bit_depth                       = 16;
+      format->sample_rate_range.minimum_rate  = rates[ i ];
+      format->sample_rate_range.maximum_rate  = rates[ i ];
+
+      cahal_get_default_channel_layout( channels, &( format->channel_layout ) );
+
+      stream->supported_formats[ index++ ] = format;
+    }
+  }
+
+  return( stream );
+}
+
+static
+CPC_BOOL
+load_simulated_device_details(
+  cahal_device* io_device
+)
+{
+  cahal_device** details  = create_simulated_device_list( 1 );
+  CPC_BOOL loaded         = ( NULL != details );
+
+  cahal_sleep( g_simulated_details_latency );
+
+  if( loaded )
+  {
+    cahal_device* source = details[ 0 ];
+
+    io_device->model                        = source->model;
+    io_device->manufacturer                 = source->manufacturer;
+    io_device->model_uid                    = source->model_uid;
+    io_device->supported_sample_rates       = source->supported_sample_rates;
+    io_device->preferred_sample_rate        = source->preferred_sample_rate;
+    io_device->preferred_number_of_channels =
+      source->preferred_number_of_channels;
+    io_device->is_alive                     = source->is_alive;
+
+    source->model                   = NULL;
+    source->manufacturer            = NULL;
+    source->model_uid               = NULL;
+    source->supported_sample_rates  = NULL;
+
+    for( UINT32 i = 0; NULL != io_device->device_streams[ i ]; i++ )
+    {
+      io_device->device_streams[ i ]->preferred_format =
+        source->device_streams[ i ]->preferred_format;
+      io_device->device_streams[ i ]->supported_formats =
+        source->device_streams[ i ]->supported_formats;
+
+      source->device_streams[ i ]->supported_formats = NULL;
+    }
+  }
+
+  free_simulated_device_list( details );
+
+  return( loaded );
+}
+
+static
+void
+record_device_change(
+  cahal_device_change_type in_change,
+  cahal_device*            in_device,
+  cahal_device_snapshot*   in_snapshot,
+  void*                    in_user_data
+)
+{
+  SIZE length = strlen( g_device_change_record );
+
+  snprintf(
+    g_device_change_record + length,
+    DEVICE_CHANGE_RECORD_SIZE - length,
+    "%u:%s@%u ",
+    in_change,
+    NULL != in_device->device_uid ? in_device->device_uid : "",
+    in_snapshot->version
+  );
+}
+
+static
+CPC_BOOL
+dispatch_recording_callback(
+  cahal_device* in_recording_device,
+  UCHAR*        in_data_buffer,
+  UINT32        in_data_buffer_length,
+  void*         in_user_data
+)
+{
+  dispatch_counter* counter = ( dispatch_counter* ) in_user_data;
+
+  for( UINT32 i = 0; i < in_data_buffer_length; i++ )
+  {
+    if( counter->next_value++ != in_data_buffer[ i ] )
+    {
+      counter->is_in_order = CPC_FALSE;
+    }
+  }
+
+  counter->number_of_bytes += in_data_buffer_length;
+  counter->number_of_calls++;
+
+  return( CPC_TRUE );
+}
+
+static
+CPC_BOOL
+dispatch_playback_callback(
+  cahal_device* in_playback_device,
+  UCHAR*        out_data_buffer,
+  UINT32*       io_data_buffer_length,
+  void*         in_user_data
+)
+{
+  dispatch_counter* counter = ( dispatch_counter* ) in_user_data;
+
+  if(
+    0 != counter->maximum_calls
+    && counter->maximum_calls <= counter->number_of_calls
+    )
+  {
+    return( CPC_FALSE );
+  }
+
+  for( UINT32 i = 0; i < *io_data_buffer_length; i++ )
+  {
+    out_data_buffer[ i ] = counter->next_value++;
+  }
+
+  counter->number_of_bytes += *io_data_buffer_length;
+  counter->number_of_calls++;
+
+  return( CPC_TRUE );
+}
+
+static
+void
+sleeping_job(
+  void*  in_argument,
+  UINT64 in_deadline
+)
+{
+  cahal_sleep( ( UINT32 ) ( SIZE ) in_argument );
+
+  CAHAL_ATOMIC_ADD( &g_number_of_completed_jobs, 1 );
+}
+
+static
+CPC_BOOL
+lifecycle_find_device( void )
+{
+  cahal_device** device_list = cahal_get_device_list();
+
+  g_lifecycle_device = NULL;
+
+  for(
+    UINT32 i = 0;
+    NULL == g_lifecycle_device
+    && NULL != device_list
+    && NULL != device_list[ i ];
+    i++
+  )
+  {
+    if(
+      cahal_test_device_direction_support(
+        device_list[ i ],
+        CAHAL_DEVICE_INPUT_STREAM
+      )
+      )
+    {
+      g_lifecycle_device = device_list[ i ];
+    }
+  }
+
+  return( NULL != g_lifecycle_device );
+}
+
+static
+CPC_BOOL
+lifecycle_start_recording( void )
+{
+  return(
+    cahal_start_recording(
+      g_lifecycle_device,
+      CAHAL_AUDIO_FORMAT_LINEARPCM,
+      1,
+      8000,
+      16,
+      lifecycle_recording_callback,
+      &g_lifecycle_user_data,
+      CAHAL_AUDIO_FORMAT_FLAGISSIGNEDINTEGER
+      | CAHAL_AUDIO_FORMAT_FLAGISPACKED
+    )
+  );
+}
+
+static
+CPC_BOOL
+lifecycle_stop_recording( void )
+{
+  return( cahal_stop_recording() );
+}
+
+static
+void
+lifecycle_control_thread(
+  void* in_number_of_iterations
+)
+{
+  UINT32 number_of_iterations = ( UINT32 ) ( SIZE ) in_number_of_iterations;
+
+  for( UINT32 i = 0; i < number_of_iterations; i++ )
+  {
+    if( 0 == i % 2 )
+    {
+      lifecycle_start_recording();
+    }
+    else
+    {
+      lifecycle_stop_recording();
+    }
+
+    cahal_thread_yield();
+  }
+}
+
+static
+CPC_BOOL
+lifecycle_recording_callback(
+  cahal_device* in_recording_device,
+  UCHAR*        in_data_buffer,
+  UINT32        in_data_buffer_length,
+  void*         in_user_data
+)
+{
+  if( &g_lifecycle_user_data != in_user_data )
+  {
+    CAHAL_ATOMIC_ADD( &g_number_of_lifecycle_errors, 1 );
+  }
+
+  CAHAL_ATOMIC_ADD( &g_number_of_lifecycle_callbacks, 1 );
+
+  return( CPC_TRUE );
+}
+
+static
+CPC_BOOL
+lifecycle_async_start(
+  void* in_argument
+)
+{
+  return( lifecycle_find_device() && lifecycle_start_recording() );
+}
+
+static
+CPC_BOOL
+lifecycle_async_stop(
+  void* in_argument
+)
+{
+  return( lifecycle_stop_recording() );
+}
+
+static
+CPC_BOOL
+sleeping_operation(
+  void* in_argument
+)
+{
+  cahal_sleep( ( UINT32 ) ( SIZE ) in_argument );
+
+  return( CPC_TRUE );
+}
+
+static
+void
+count_async_completion(
+  cahal_async_operation* in_operation,
+  CPC_BOOL               in_result,
+  void*                  in_user_data
+)
+{
+  CAHAL_ATOMIC_ADD( &g_number_of_async_completions, 1 );
+}
+
+static
+CPC_BOOL
+record_periods(
+  cahal_recorder_info*  io_recorder_info,
+  UINT32                in_number_of_periods,
+  UINT32                in_period_size,
+  CPC_BOOL              in_is_counting
+)
+{
+  CPC_BOOL return_value = CPC_TRUE;
+  UCHAR* buffer         = NULL;
+  UCHAR value           = 0;
+
+  io_recorder_info->format_id           = CAHAL_AUDIO_FORMAT_LINEARPCM;
+  io_recorder_info->number_of_channels  = 1;
+  io_recorder_info->sample_rate         = 48000;
+  io_recorder_info->bit_depth           = 16;
+
+  if(
+    CPC_ERROR_CODE_NO_ERROR
+    != cpc_safe_malloc( ( void** ) &buffer, in_period_size )
+    )
+  {
+    return( CPC_FALSE );
+  }
+
+  if( ! cahal_attach_recording_coalescer( io_recorder_info, in_period_size ) )
+  {
+    cpc_safe_free( ( void** ) &buffer );
+
+    return( CPC_FALSE );
+  }
+
+  for( UINT32 i = 0; i < in_number_of_periods && return_value; i++ )
+  {
+    for( UINT32 j = 0; j < in_period_size && in_is_counting; j++ )
+    {
+      buffer[ j ] = value++;
+    }
+
+    return_value =
+      cahal_process_recording(
+        io_recorder_info,
+        buffer,
+        in_period_size,
+        cahal_get_time()
+      );
+  }
+
+  cahal_detach_recording_coalescer( io_recorder_info );
+
+  cpc_safe_free( ( void** ) &buffer );
+
+  return( return_value );
+}
+
+static
+CPC_BOOL
+benchmark_recording_callback(
+  cahal_device* in_recording_device,
+  UCHAR*        in_data_buffer,
+  UINT32        in_data_buffer_length,
+  void*         in_user_data
+)
+{
+  CPC_BOOL return_value = CPC_FALSE;
+  PyObject* samples     = NULL;
+  PyObject* result      = NULL;
+
+  PyGILState_STATE state = PyGILState_Ensure( );
+
+  samples =
+    PyBytes_FromStringAndSize(
+      ( const char* ) in_data_buffer,
+      in_data_buffer_length
+    );
+
+  if( NULL != samples )
+  {
+    result =
+      PyObject_CallFunctionObjArgs( ( PyObject* ) in_user_data, samples, NULL );
+
+    Py_DECREF( samples );
+  }
+
+  if( NULL == result )
+  {
+    PyErr_Print( );
+  }
+  else
+  {
+    Py_DECREF( result );
+
+    return_value = CPC_TRUE;
+  }
+
+  PyGILState_Release( state );
+
+  return( return_value );
+}
+
+static
+CPC_BOOL
+scheduled_playback_callback(
+  cahal_device* in_playback_device,
+  UCHAR*        out_data_buffer,
+  UINT32*       io_data_buffer_length,
+  void*         in_user_data
+)
+{
+  memset( out_data_buffer, 0x7F, *io_data_buffer_length );
+
+  return( CPC_TRUE );
+}
+
+static
+CPC_BOOL
+aggregate_recorder_callback(
+  cahal_device* in_recording_device,
+  UCHAR*        in_data_buffer,
+  UINT32        in_data_buffer_length,
+  void*         in_user_data
+)
+{
+  aggregate_output* output  = ( aggregate_output* ) in_user_data;
+  UINT32 length             = in_data_buffer_length;
+
+  if( output->capacity - output->length < length )
+  {
+    length = output->capacity - output->length;
+  }
+
+  memcpy( output->samples + output->length, in_data_buffer, length );
+
+  output->length += length;
+
+  return( CPC_TRUE );
+}
+
+static
+void
+aggregate_record(
+  cahal_aggregate_recording*  io_aggregate,
+  FLOAT64                     in_ppm,
+  FLOAT64                     in_start_offset,
+  UINT32                      in_number_of_frames,
+  INT16*                      io_buffer
+)
+{
+  UINT32 number_of_members  = io_aggregate->number_of_members;
+  FLOAT64 sample_rate       = io_aggregate->sample_rate;
+  UINT32 recorded[ AGGREGATE_MAXIMUM_MEMBERS ];
+
+  memset( recorded, 0, sizeof( recorded ) );
+
+  //  Member i records buffers of ( i + 1 ) * AGGREGATE_PERIOD_SIZE frames at
+  //  its own rate, starting at its own time. Each buffer is delivered once
+  //  its last frame has been recorded, the earliest one first.
+  while( recorded[ 0 ] < in_number_of_frames )
+  {
+    UINT32 member     = 0;
+    FLOAT64 delivery  = 0;
+    FLOAT64 first     = 0;
+    FLOAT64 rate      = 0;
+    UINT32 length     = 0;
+
+    for( UINT32 i = 0; i < number_of_members; i++ )
+    {
+      FLOAT64 time =
+        ( 0 == i ? AGGREGATE_MASTER_OFFSET : in_start_offset * i )
+        + ( recorded[ i ] + ( i + 1 ) * AGGREGATE_PERIOD_SIZE )
+          / ( sample_rate * ( 1 + in_ppm * i * 1e-6 ) );
+
+      if( 0 == i || time < delivery )
+      {
+        member    = i;
+        delivery  = time;
+      }
+    }
+
+    rate    = sample_rate * ( 1 + in_ppm * member * 1e-6 );
+    length  = ( member + 1 ) * AGGREGATE_PERIOD_SIZE;
+    first   =
+      ( 0 == member ? AGGREGATE_MASTER_OFFSET : in_start_offset * member )
+      + recorded[ member ] / rate;
+
+    //  A sum of unrelated tones, so that a misaligned member never matches
+    for( UINT32 j = 0; j < length; j++ )
+    {
+      FLOAT64 time  = first + j / rate;
+      FLOAT64 value = 0;
+
+      for( UINT32 k = 1; k <= 16; k++ )
+      {
+        value +=
+          sin(
+            2 * AGGREGATE_PI * ( 20.0 * k + 3.7 * k * k ) * time
+            + 0.7 * k * k
+          ) / 16.0;
+      }
+
+      io_buffer[ j ] = ( INT16 ) ( 16384 * value );
+    }
+
+    cahal_aggregate_push(
+      &io_aggregate->members[ member ],
+      ( UCHAR* ) io_buffer,
+      length * sizeof( INT16 ),
+      io_aggregate->start_time + ( UINT64 ) ( first * 1000000000.0 )
+    );
+
+    recorded[ member ] += length;
+  }
 }
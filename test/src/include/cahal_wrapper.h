@@ -239,6 +239,546 @@ start_playback(
                int           in_format_flags
                );
 
+/*! \fn     void start_playback_generator (
+              cahal_device*           in_device,
+              FLOAT32                 in_volume,
+              cahal_signal_generator* in_generator
+            )
+    \brief  Wrapper function that starts linear PCM playback on in_device with
+            the built-in source in_generator. The stream uses the number of
+            channels, sample rate, bit depth and flags of in_generator and the
+            samples are produced entirely in C.
+
+    \param  in_device The device to use in the playback.
+    \param  in_volume Output gain factor, value between 0.0 and 1.0.
+    \param  in_generator  The signal generator to play. It must not be freed
+                          until playback has been stopped.
+    \return Returns the result of cahal_start_playback, which is a boolean.
+*/
+PyObject*
+start_playback_generator(
+  cahal_device*           in_device,
+  FLOAT32                 in_volume,
+  cahal_signal_generator* in_generator
+);
+
+/*! \fn     cahal_prober* create_fake_prober (
+              UINT32  in_maximum_channels,
+              FLOAT64 in_maximum_sample_rate,
+              UINT32  in_maximum_bit_depth,
+              UINT32  in_latency
+            )
+    \brief  Creates a prober whose callback accepts every configuration that
+            does not exceed the given limits, so that probing and caching can
+            be tested without opening a device. No candidate values are added.
+
+    \param  in_maximum_channels The largest supported number of channels.
+    \param  in_maximum_sample_rate  The largest supported sample rate.
+    \param  in_maximum_bit_depth  The largest supported bit depth.
+    \param  in_latency  The time (in milliseconds) each test takes, to
+                        simulate opening a device.
+    \return The prober or NULL on error. Free using free_fake_prober.
+*/
+cahal_prober*
+create_fake_prober(
+  UINT32  in_maximum_channels,
+  FLOAT64 in_maximum_sample_rate,
+  UINT32  in_maximum_bit_depth,
+  UINT32  in_latency
+);
+
+/*! \fn     void free_fake_prober (
+              cahal_prober* in_prober
+            )
+    \brief  Frees a prober created using create_fake_prober.
+
+    \param  in_prober The prober to free.
+*/
+void
+free_fake_prober(
+  cahal_prober* in_prober
+);
+
+/*! \fn     CPC_BOOL add_simulated_device (
+              cahal_probe_scheduler*  io_scheduler,
+              const CHAR*             in_device_name,
+              cahal_prober*           in_prober,
+              UINT64                  in_fingerprint
+            )
+    \brief  Creates a device named in_device_name with one input stream and
+            queues it on io_scheduler, to be probed with in_prober. The device
+            name is also its cache key.
+
+    \param  io_scheduler  The scheduler to queue the device on.
+    \param  in_device_name  The name of the device.
+    \param  in_prober The prober of the device, e.g. from create_fake_prober.
+    \param  in_fingerprint  The fingerprint of the device.
+    \return True iff the device was queued.
+*/
+CPC_BOOL
+add_simulated_device(
+  cahal_probe_scheduler*  io_scheduler,
+  const CHAR*             in_device_name,
+  cahal_prober*           in_prober,
+  UINT64                  in_fingerprint
+);
+
+/*! \fn     cahal_device** create_simulated_device_list(
+              UINT32 in_number_of_devices
+            )
+    \brief  Creates a heap allocated list of in_number_of_devices simulated
+            devices, as a platform would, each with an input and an output
+            stream supporting four formats. All devices share the same model
+            and manufacturer.
+
+    \param  in_number_of_devices  The number of devices to create.
+    \return The null-terminated list or NULL on error. Free using
+            free_simulated_device_list unless it has been packed.
+*/
+cahal_device**
+create_simulated_device_list(
+  UINT32 in_number_of_devices
+);
+
+/*! \fn     cahal_device** create_simulated_lazy_device_list(
+              UINT32    in_number_of_devices,
+              UINT32    in_latency,
+              CPC_BOOL  in_lazy
+            )
+    \brief  Creates the same devices as create_simulated_device_list, as a
+            platform that takes in_latency milliseconds to read the details
+            of a device would. Each device starts out with only its name, UID
+            and the handles and directions of its streams; the remaining
+            members are filled in by its details_loader, immediately unless
+            in_lazy is set.
+
+    \param  in_number_of_devices  The number of devices to create.
+    \param  in_latency  The time (in milliseconds) loading the details of one
+                        device takes.
+    \param  in_lazy True to defer loading the details until
+                    cahal_load_device_details is called.
+    \return The null-terminated list or NULL on error. Free using
+            free_simulated_device_list unless it has been packed.
+*/
+cahal_device**
+create_simulated_lazy_device_list(
+  UINT32    in_number_of_devices,
+  UINT32    in_latency,
+  CPC_BOOL  in_lazy
+);
+
+/*! \fn     void free_simulated_device_list(
+              cahal_device** in_device_list
+            )
+    \brief  Frees a list created by create_simulated_device_list.
+
+    \param  in_device_list  The list to free.
+*/
+void
+free_simulated_device_list(
+  cahal_device** in_device_list
+);
+
+/*! \fn     UINT32 subscribe_device_change_recorder( void )
+    \brief  Clears the device change record and subscribes a callback that
+            appends "<change>:<uid>@<version> " to it for every change.
+
+    \return The identifier of the subscription, or 0 on error.
+*/
+UINT32
+subscribe_device_change_recorder( void );
+
+/*! \fn     const CHAR* get_device_change_record( void )
+    \brief  Returns the changes recorded since the record was last cleared.
+
+    \return The record.
+*/
+const CHAR*
+get_device_change_record( void );
+
+/*! \fn     void clear_device_change_record( void )
+    \brief  Clears the device change record.
+*/
+void
+clear_device_change_record( void );
+
+/*! \fn     UINT32 simulate_dispatched_recording(
+              UINT32              in_number_of_buffers,
+              UINT32              in_buffer_size,
+              cahal_thread_policy in_policy
+            )
+    \brief  Records in_number_of_buffers buffers of a counting sequence through
+            a dispatcher, as an OS thread would, waiting for room in the ring
+            buffer instead of dropping buffers. The recording is 8 kHz, mono,
+            8-bit PCM.
+
+    \param  in_number_of_buffers  The number of buffers to record.
+    \param  in_buffer_size  The size of each buffer in bytes.
+    \param  in_policy The scheduling policy of the dispatch thread.
+    \return The number of bytes the recording callback received, or 0 if they
+            were not received in order.
+*/
+UINT32
+simulate_dispatched_recording(
+  UINT32              in_number_of_buffers,
+  UINT32              in_buffer_size,
+  cahal_thread_policy in_policy
+);
+
+/*! \fn     UINT32 simulate_dispatched_playback(
+              UINT32 in_number_of_buffers,
+              UINT32 in_buffer_size,
+              UINT32 in_number_of_renders
+            )
+    \brief  Pulls up to in_number_of_buffers buffers from a dispatcher whose
+            playback callback renders a counting sequence, as an OS thread
+            would, waiting for the samples instead of playing silence. The
+            playback is 8 kHz, mono, 8-bit PCM, rendered 80 bytes at a time.
+
+    \param  in_number_of_buffers  The number of buffers to pull.
+    \param  in_buffer_size  The size of each buffer in bytes.
+    \param  in_number_of_renders  The number of times the playback callback
+                                  succeeds before it fails, or 0 to never fail.
+    \return The number of bytes pulled before the dispatcher reported the
+            failure, or 0 if they were not pulled in order.
+*/
+UINT32
+simulate_dispatched_playback(
+  UINT32 in_number_of_buffers,
+  UINT32 in_buffer_size,
+  UINT32 in_number_of_renders
+);
+
+/*! \fn     CPC_BOOL submit_sleeping_job(
+              cahal_worker_pool*  io_pool,
+              UINT32              in_stream,
+              UINT32              in_duration
+            )
+    \brief  Submits a job of in_stream to io_pool that sleeps for
+            in_duration and counts itself in get_number_of_completed_jobs.
+
+    \param  io_pool The pool.
+    \param  in_stream The stream returned by cahal_worker_pool_add_stream.
+    \param  in_duration The time (in milliseconds) the job sleeps.
+    \return True iff the job was queued.
+*/
+CPC_BOOL
+submit_sleeping_job(
+  cahal_worker_pool*  io_pool,
+  UINT32              in_stream,
+  UINT32              in_duration
+);
+
+/*! \fn     UINT32 get_number_of_completed_jobs( void )
+    \brief  Returns the number of jobs submitted by submit_sleeping_job that
+            ran since the last call to clear_number_of_completed_jobs.
+
+    \return The number of completed jobs.
+*/
+UINT32
+get_number_of_completed_jobs( void );
+
+/*! \fn     void clear_number_of_completed_jobs( void )
+    \brief  Resets the number returned by get_number_of_completed_jobs.
+*/
+void
+clear_number_of_completed_jobs( void );
+
+/*! \fn     CPC_BOOL stress_stream_lifecycle(
+              UINT32 in_number_of_threads,
+              UINT32 in_number_of_iterations
+            )
+    \brief  Starts and stops a recording of the first device that can record
+            using cahal_start_recording and cahal_stop_recording from
+            in_number_of_threads threads at once, each alternating between
+            in_number_of_iterations starts and stops. A last recording is then
+            held open until a buffer is recorded (or
+            LIFECYCLE_CALLBACK_TIMEOUT passes) and stopped.
+
+    \param  in_number_of_threads  The number of threads starting and
+                                  stopping the recording.
+    \param  in_number_of_iterations The number of starts and stops each
+                                    thread tries.
+    \return True iff there is a device that can record, buffers were
+            recorded, none of them through a freed recording, and the
+            recording was left stopped.
+*/
+CPC_BOOL
+stress_stream_lifecycle(
+  UINT32 in_number_of_threads,
+  UINT32 in_number_of_iterations
+);
+
+/*! \fn     cahal_async_operation* start_lifecycle_recording_async( void )
+    \brief  Queues a start of the recording of stress_stream_lifecycle on the
+            control thread. The completion counts itself in
+            get_number_of_async_completions.
+
+    \return The handle of the operation or NULL.
+*/
+cahal_async_operation*
+start_lifecycle_recording_async( void );
+
+/*! \fn     cahal_async_operation* stop_lifecycle_recording_async( void )
+    \brief  Queues a stop of the recording started by
+            start_lifecycle_recording_async. The completion counts itself in
+            get_number_of_async_completions.
+
+    \return The handle of the operation or NULL.
+*/
+cahal_async_operation*
+stop_lifecycle_recording_async( void );
+
+/*! \fn     cahal_async_operation* submit_sleeping_operation(
+              UINT32 in_duration
+            )
+    \brief  Queues an operation on the control thread that sleeps for
+            in_duration and succeeds. The completion counts itself in
+            get_number_of_async_completions.
+
+    \param  in_duration The time (in milliseconds) the operation sleeps.
+    \return The handle of the operation or NULL.
+*/
+cahal_async_operation*
+submit_sleeping_operation(
+  UINT32 in_duration
+);
+
+/*! \fn     UINT32 get_number_of_async_completions( void )
+    \brief  Returns the number of completion callbacks of the operations
+            submitted by the wrapper since the last call to
+            clear_number_of_async_completions.
+
+    \return The number of completions.
+*/
+UINT32
+get_number_of_async_completions( void );
+
+/*! \fn     void clear_number_of_async_completions( void )
+    \brief  Resets the number returned by get_number_of_async_completions.
+*/
+void
+clear_number_of_async_completions( void );
+
+/*! \fn     UINT32 simulate_coalesced_recording(
+              UINT32 in_number_of_periods,
+              UINT32 in_period_size
+            )
+    \brief  Records in_number_of_periods periods of a counting sequence
+            through cahal_process_recording, as an OS thread would, with the
+            coalescer set up by cahal_set_coalesce_options (if any), and stops
+            the recording. The recording is 48 kHz, mono, 16-bit PCM.
+
+    \param  in_number_of_periods  The number of periods to record.
+    \param  in_period_size  The size of each period in bytes.
+    \return The number of times the recording callback was called, or 0 if
+            it did not receive every byte in order.
+*/
+UINT32
+simulate_coalesced_recording(
+  UINT32 in_number_of_periods,
+  UINT32 in_period_size
+);
+
+/*! \fn     CPC_BOOL benchmark_recording(
+              UINT32    in_number_of_periods,
+              UINT32    in_period_size,
+              PyObject* in_callback_function
+            )
+    \brief  Records in_number_of_periods periods of silence like
+            simulate_coalesced_recording, passing every buffer to a Python
+            callback as bytes. Like python_recorder_callback, every call
+            takes the GIL.
+
+    \param  in_number_of_periods  The number of periods to record.
+    \param  in_period_size  The size of each period in bytes.
+    \param  in_callback_function  The Python callback, called with the
+                                  recorded bytes.
+    \return True iff every call of the callback succeeded.
+*/
+CPC_BOOL
+benchmark_recording(
+  UINT32    in_number_of_periods,
+  UINT32    in_period_size,
+  PyObject* in_callback_function
+);
+
+/*! \fn     CPC_BOOL record_pollable(
+              cahal_pollable_stream*  io_stream,
+              UINT32                  in_length,
+              UCHAR                   in_first_value
+            )
+    \brief  Passes a buffer of a counting sequence to the recording callback
+            of a pollable stream, as an OS thread would.
+
+    \param  io_stream The pollable recording.
+    \param  in_length The size of the buffer in bytes.
+    \param  in_first_value  The value of the first byte of the sequence.
+    \return The value returned by the callback.
+*/
+CPC_BOOL
+record_pollable(
+  cahal_pollable_stream*  io_stream,
+  UINT32                  in_length,
+  UCHAR                   in_first_value
+);
+
+/*! \fn     PyObject* read_pollable(
+              cahal_pollable_stream*  io_stream,
+              UINT32                  in_length
+            )
+    \brief  Wrapper for cahal_pollable_read.
+
+    \param  io_stream The pollable recording.
+    \param  in_length The largest number of bytes to read.
+    \return The bytes read.
+*/
+PyObject*
+read_pollable(
+  cahal_pollable_stream*  io_stream,
+  UINT32                  in_length
+);
+
+/*! \fn     UINT32 play_pollable(
+              cahal_pollable_stream*  io_stream,
+              UINT32                  in_length
+            )
+    \brief  Requests a buffer from the playback callback of a pollable
+            stream, as an OS thread would.
+
+    \param  io_stream The pollable playback.
+    \param  in_length The size of the buffer in bytes.
+    \return The number of bytes the callback filled.
+*/
+UINT32
+play_pollable(
+  cahal_pollable_stream*  io_stream,
+  UINT32                  in_length
+);
+
+/*! \fn     UINT32 write_pollable(
+              cahal_pollable_stream*  io_stream,
+              UINT32                  in_length
+            )
+    \brief  Wrapper for cahal_pollable_write, writing in_length bytes of
+            silence.
+
+    \param  io_stream The pollable playback.
+    \param  in_length The number of bytes to write.
+    \return The number of bytes written.
+*/
+UINT32
+write_pollable(
+  cahal_pollable_stream*  io_stream,
+  UINT32                  in_length
+);
+
+/*! \fn     UINT32 simulate_scheduled_playback(
+              UINT32    in_number_of_periods,
+              UINT32    in_period_size,
+              UINT32    in_queued_bytes,
+              CPC_BOOL  in_is_priming
+            )
+    \brief  Plays periods of 48 kHz, mono, 16-bit PCM through
+            cahal_dispatch_playback, the way the OS requests them, with the
+            schedule set up by cahal_set_playback_start_time (if any). The
+            playback callback never writes silence.
+
+    \param  in_number_of_periods  The number of periods to play.
+    \param  in_period_size  The size of each period in bytes.
+    \param  in_queued_bytes The number of bytes the OS reports as queued
+                            ahead of every period.
+    \param  in_is_priming True to start with the OS priming its queue, as
+                          Darwin does: period i is reported with the i
+                          periods before it queued, until that reaches
+                          in_queued_bytes.
+    \return The number of bytes of silence played before the first sample of
+            the playback callback.
+*/
+UINT32
+simulate_scheduled_playback(
+  UINT32    in_number_of_periods,
+  UINT32    in_period_size,
+  UINT32    in_queued_bytes,
+  CPC_BOOL  in_is_priming
+);
+
+/*! \fn     FLOAT64 simulate_aggregate_recording(
+              UINT32  in_number_of_members,
+              FLOAT64 in_ppm,
+              FLOAT64 in_start_offset,
+              UINT32  in_duration
+            )
+    \brief  Records the same signal through an aggregate recording of
+            in_number_of_members mono, 8 kHz, 16-bit devices, pushing each
+            member's buffers as its device would deliver them. Each member
+            delivers larger buffers than the one before it.
+
+    \param  in_number_of_members  The number of members, at most 8.
+    \param  in_ppm  How much faster (in ppm) the clock of each member runs
+                    than the one of the member before it.
+    \param  in_start_offset The time (in seconds) each member starts
+                            recording at after the member before it.
+    \param  in_duration The time (in seconds) the master records for.
+    \return The largest RMS difference between the channel of a member and
+            the one of the master over the last 10 seconds of the
+            consolidated frames, in full scale, or -1 on error.
+*/
+FLOAT64
+simulate_aggregate_recording(
+  UINT32  in_number_of_members,
+  FLOAT64 in_ppm,
+  FLOAT64 in_start_offset,
+  UINT32  in_duration
+);
+
+/*! \fn     FLOAT64 simulate_drift(
+              cahal_drift_resampler*  io_resampler,
+              FLOAT64                 in_ppm,
+              UINT32                  in_duration
+            )
+    \brief  Writes 10 ms periods into io_resampler from a recording whose
+            clock runs in_ppm faster than the playback's, reading a period
+            after each, for in_duration seconds of the playback.
+
+    \param  io_resampler  The resampler to drive.
+    \param  in_ppm  How much faster (in ppm) the recording runs.
+    \param  in_duration The time (in seconds) the playback reads for.
+    \return The largest latency (in seconds) of the resampler after a write,
+            or -1 on error.
+*/
+FLOAT64
+simulate_drift(
+  cahal_drift_resampler*  io_resampler,
+  FLOAT64                 in_ppm,
+  UINT32                  in_duration
+);
+
+/*! \fn     UINT32 simulate_drift_ramp(
+              cahal_drift_resampler*  io_resampler,
+              FLOAT64                 in_ppm,
+              UINT32                  in_number_of_periods
+            )
+    \brief  Writes a ramp (the index of every frame) into io_resampler in
+            64-frame periods from a recording whose clock runs in_ppm faster
+            than the playback's, reading each period back in reads of 1 to
+            40 frames. Once the ramp reaches the output every output frame
+            must be one more than the last, give or take the ratio.
+
+    \param  io_resampler  The resampler to drive.
+    \param  in_ppm  How much faster (in ppm) the recording runs.
+    \param  in_number_of_periods The number of periods written and read,
+                                 at most 2^18 so that floats hold the ramp.
+    \return The number of output frames that were not one more than the
+            last, e.g. because an input frame was skipped.
+*/
+UINT32
+simulate_drift_ramp(
+  cahal_drift_resampler*  io_resampler,
+  FLOAT64                 in_ppm,
+  UINT32                  in_number_of_periods
+);
+
 /*! \fn     void python_cahal_initialize( void )
     \brief  Wrapper for the cahal_initialize function to ensure the GIL is
             properly set up for threads to be iniitialized in external C
@@ -0,0 +1,806 @@
+/*! \file   test_cahal_hpp.cpp
+    \brief  Instantiates the C++ layer of cahal.hpp for every sample type and
+            runs Recording, Playback and Stream against an in-process device,
+            whose threads call back through cahal_dispatch_recording and
+            cahal_dispatch_playback the way the OS threads do. Exits with 1
+            if any check failed.
+
+    \author Brent Carrara
+ */
+#include "cahal.hpp"
+#include "cahal_callback.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+
+namespace
+{
+
+/*! \var    simulated_buffer_frames
+    \brief  The number of frames in a buffer of the in-process device.
+ */
+constexpr UINT32 simulated_buffer_frames = 64;
+
+/*! \var    simulated_timeout
+    \brief  How long a check waits for the in-process device.
+ */
+constexpr std::chrono::seconds simulated_timeout( 5 );
+
+/*! \var    g_number_of_failures
+    \brief  The number of checks that failed.
+ */
+UINT32 g_number_of_failures = 0;
+
+/*! \fn     void check  (
+              bool        in_is_passed,
+              const char* in_description
+            )
+    \brief  Counts and prints a failed check.
+
+    \param  in_is_passed  The result of the check.
+    \param  in_description  What was checked.
+ */
+void
+check (
+       bool        in_is_passed,
+       const char* in_description
+       )
+{
+  if( ! in_is_passed )
+  {
+    std::printf( "FAILED: %s\n", in_description );
+
+    g_number_of_failures++;
+  }
+}
+
+/*! \fn     template< typename D > D get_device_value( UINT32 in_index )
+    \brief  The in_index-th sample of the counting sequence the in-process
+            device records and expects to be played, in the 16 or 32-bit
+            format exchanged with it. 32-bit samples count in steps of 2^16
+            so that a float holds them exactly.
+ */
+template< typename D >
+D
+get_device_value( UINT32 in_index )
+{
+  if constexpr( sizeof( D ) == sizeof( int16_t ) )
+  {
+    return( static_cast< D >( in_index ) );
+  }
+  else
+  {
+    return( static_cast< D >( in_index * 65536u ) );
+  }
+}
+
+/*! \fn     template< cahal::Sample T > T get_expected( UINT32 in_index )
+    \brief  The in_index-th sample of the counting sequence as a T.
+ */
+template< cahal::Sample T >
+T
+get_expected( UINT32 in_index )
+{
+  using device_sample = typename cahal::sample_traits< T >::device_sample;
+
+  return  (
+           cahal::sample_traits< T >::from_device (
+                                 get_device_value< device_sample >( in_index )
+                                                   )
+           );
+}
+
+/*! \fn     template< typename D > void fill_buffer (
+              std::vector< UCHAR >& io_buffer,
+              UINT32&               io_index
+            )
+    \brief  Fills a buffer with the next samples of the counting sequence.
+ */
+template< typename D >
+void
+fill_buffer (
+             std::vector< UCHAR >& io_buffer,
+             UINT32&               io_index
+             )
+{
+  for (
+       std::size_t i = 0;
+       i + sizeof( D ) <= io_buffer.size();
+       i += sizeof( D )
+       )
+  {
+    D value = get_device_value< D >( io_index++ );
+
+    std::memcpy( io_buffer.data() + i, &value, sizeof( D ) );
+  }
+}
+
+/*! \fn     template< typename D > bool check_buffer (
+              const std::vector< UCHAR >& in_buffer,
+              UINT32                      in_length,
+              UINT32&                     io_index
+            )
+    \brief  Returns true iff a played buffer continues the counting sequence.
+ */
+template< typename D >
+bool
+check_buffer  (
+               const std::vector< UCHAR >& in_buffer,
+               UINT32                      in_length,
+               UINT32&                     io_index
+               )
+{
+  bool is_in_order = true;
+
+  for( std::size_t i = 0; i + sizeof( D ) <= in_length; i += sizeof( D ) )
+  {
+    D value;
+
+    std::memcpy( &value, in_buffer.data() + i, sizeof( D ) );
+
+    is_in_order =
+      is_in_order && get_device_value< D >( io_index++ ) == value;
+  }
+
+  return( is_in_order );
+}
+
+/*! \var    SimulatedPlatform
+    \brief  Starts streams on an in-process device instead of the OS: one
+            thread records the counting sequence, the other checks that the
+            counting sequence is played. The stream states of the C API are
+            used the way the platforms use them, including a failed start
+            that leaves its callback info and a RUNNING stream behind.
+ */
+struct SimulatedPlatform
+{
+  /*! \var    buffer_duration
+      \brief  The longest buffer (in seconds) the device records in, one
+              second as on Darwin.
+   */
+  static constexpr FLOAT64 buffer_duration = 1.0;
+
+  static
+  CPC_BOOL
+  start_recording (
+                   cahal_device*            in_device,
+                   cahal_audio_format_id    in_format_id,
+                   UINT32                   in_number_of_channels,
+                   FLOAT64                  in_sample_rate,
+                   UINT32                   in_bit_depth,
+                   cahal_recorder_callback  in_recorder,
+                   void*                    in_callback_user_data,
+                   cahal_audio_format_flag  in_format_flags
+                   )
+  {
+    if( ! cahal_stream_state_begin_start( &g_cahal_recording_state ) )
+    {
+      return( CPC_FALSE );
+    }
+
+    recorder_info = new cahal_recorder_info();
+
+    recorder_info->recording_device   = in_device;
+    recorder_info->recording_callback = in_recorder;
+    recorder_info->user_data          = in_callback_user_data;
+    recorder_info->format_id          = in_format_id;
+    recorder_info->number_of_channels = in_number_of_channels;
+    recorder_info->sample_rate        = in_sample_rate;
+    recorder_info->bit_depth          = in_bit_depth;
+    recorder_info->format_flags       = in_format_flags;
+
+    if( ! is_failing_start )
+    {
+      recorder = std::thread( &SimulatedPlatform::record, recorder_info );
+    }
+
+    cahal_stream_state_end_start( &g_cahal_recording_state, CPC_TRUE );
+
+    return( is_failing_start ? CPC_FALSE : CPC_TRUE );
+  }
+
+  static CPC_BOOL stop_recording( void )
+  {
+    if( ! cahal_stream_state_begin_stop( &g_cahal_recording_state, NULL ) )
+    {
+      return( CPC_FALSE );
+    }
+
+    cahal_stream_state_wait_for_callbacks( &g_cahal_recording_state );
+
+    if( recorder.joinable() )
+    {
+      recorder.join();
+    }
+
+    delete recorder_info;
+
+    recorder_info = NULL;
+
+    cahal_stream_state_end_stop( &g_cahal_recording_state );
+
+    return( CPC_TRUE );
+  }
+
+  static
+  CPC_BOOL
+  start_playback  (
+                   cahal_device*            in_device,
+                   cahal_audio_format_id    in_format_id,
+                   UINT32                   in_number_of_channels,
+                   FLOAT64                  in_sample_rate,
+                   UINT32                   in_bit_depth,
+                   FLOAT32                  in_volume,
+                   cahal_playback_callback  in_playback,
+                   void*                    in_callback_user_data,
+                   cahal_audio_format_flag  in_format_flags
+                   )
+  {
+    ( void ) in_volume;
+
+    if( ! cahal_stream_state_begin_start( &g_cahal_playback_state ) )
+    {
+      return( CPC_FALSE );
+    }
+
+    playback_info = new cahal_playback_info();
+
+    playback_info->playback_device    = in_device;
+    playback_info->playback_callback  = in_playback;
+    playback_info->user_data          = in_callback_user_data;
+    playback_info->format_id          = in_format_id;
+    playback_info->number_of_channels = in_number_of_channels;
+    playback_info->sample_rate        = in_sample_rate;
+    playback_info->bit_depth          = in_bit_depth;
+    playback_info->format_flags       = in_format_flags;
+
+    number_of_played_samples.store( 0 );
+    is_played_in_order.store( true );
+
+    if( ! is_failing_start )
+    {
+      player = std::thread( &SimulatedPlatform::play, playback_info );
+    }
+
+    cahal_stream_state_end_start( &g_cahal_playback_state, CPC_TRUE );
+
+    return( is_failing_start ? CPC_FALSE : CPC_TRUE );
+  }
+
+  static CPC_BOOL stop_playback( void )
+  {
+    if( ! cahal_stream_state_begin_stop( &g_cahal_playback_state, NULL ) )
+    {
+      return( CPC_FALSE );
+    }
+
+    cahal_stream_state_wait_for_callbacks( &g_cahal_playback_state );
+
+    if( player.joinable() )
+    {
+      player.join();
+    }
+
+    delete playback_info;
+
+    playback_info = NULL;
+
+    cahal_stream_state_end_stop( &g_cahal_playback_state );
+
+    return( CPC_TRUE );
+  }
+
+  static cahal_recorder_info* get_recorder_info( void )
+  {
+    return( recorder_info );
+  }
+
+  static cahal_playback_info* get_playback_info( void )
+  {
+    return( playback_info );
+  }
+
+  /*! \fn     static void record( cahal_recorder_info* in_recorder_info )
+      \brief  The recording thread of the device, until a buffer is refused.
+   */
+  static void record( cahal_recorder_info* in_recorder_info )
+  {
+    std::vector< UCHAR > buffer (
+                                 number_of_buffer_frames
+                                 * in_recorder_info->number_of_channels
+                                 * ( in_recorder_info->bit_depth / 8 )
+                                 );
+    UINT32 index = 0;
+
+    recorder_id.store( std::this_thread::get_id() );
+
+    for( bool is_recording = true; is_recording; )
+    {
+      if( 16 == in_recorder_info->bit_depth )
+      {
+        fill_buffer< int16_t >( buffer, index );
+      }
+      else
+      {
+        fill_buffer< int32_t >( buffer, index );
+      }
+
+      is_recording =
+        cahal_dispatch_recording  (
+                                   in_recorder_info,
+                                   buffer.data(),
+                                   static_cast< UINT32 >( buffer.size() )
+                                   );
+
+      std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+  }
+
+  /*! \fn     static void play( cahal_playback_info* in_playback_info )
+      \brief  The playback thread of the device, until it is stopped.
+   */
+  static void play( cahal_playback_info* in_playback_info )
+  {
+    std::vector< UCHAR > buffer (
+                                 simulated_buffer_frames
+                                 * in_playback_info->number_of_channels
+                                 * ( in_playback_info->bit_depth / 8 )
+                                 );
+    UINT32 index = 0;
+
+    for( bool is_playing = true; is_playing; )
+    {
+      UINT32 length = static_cast< UINT32 >( buffer.size() );
+      bool is_in_order = true;
+
+      is_playing =
+        cahal_dispatch_playback( in_playback_info, buffer.data(), &length, 0 );
+
+      if( 16 == in_playback_info->bit_depth )
+      {
+        is_in_order = check_buffer< int16_t >( buffer, length, index );
+      }
+      else
+      {
+        is_in_order = check_buffer< int32_t >( buffer, length, index );
+      }
+
+      if( ! is_in_order )
+      {
+        is_played_in_order.store( false );
+      }
+
+      number_of_played_samples.store( index );
+
+      std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+  }
+
+  static inline UINT32                          number_of_buffer_frames =
+    simulated_buffer_frames;
+  static inline bool                            is_failing_start = false;
+  static inline cahal_recorder_info*            recorder_info    = NULL;
+  static inline std::thread                     recorder;
+  static inline std::atomic< std::thread::id >  recorder_id;
+  static inline cahal_playback_info*            playback_info    = NULL;
+  static inline std::thread                     player;
+  static inline std::atomic< UINT32 >           number_of_played_samples;
+  static inline std::atomic< bool >             is_played_in_order;
+};
+
+/*! \fn     template< typename F > bool wait_until( F in_condition )
+    \brief  Polls in_condition until it holds or simulated_timeout passes.
+    \return The last result of in_condition.
+ */
+template< typename F >
+bool
+wait_until( F in_condition )
+{
+  auto deadline = std::chrono::steady_clock::now() + simulated_timeout;
+
+  while( ! in_condition() && std::chrono::steady_clock::now() < deadline )
+  {
+    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+  }
+
+  return( in_condition() );
+}
+
+/*! \var    Task
+    \brief  A coroutine that runs as soon as it is called and is never
+            awaited.
+ */
+struct Task
+{
+  struct promise_type
+  {
+    Task get_return_object( void )
+    {
+      return( Task() );
+    }
+
+    std::suspend_never initial_suspend( void )
+    {
+      return( std::suspend_never() );
+    }
+
+    std::suspend_never final_suspend( void ) noexcept
+    {
+      return( std::suspend_never() );
+    }
+
+    void return_void( void )
+    {
+    }
+
+    void unhandled_exception( void )
+    {
+      std::terminate();
+    }
+  };
+};
+
+/*! \fn     template< cahal::Sample T > Task read_frames  (
+              cahal::Stream< T, SimulatedPlatform >& io_stream,
+              UINT32                                 in_number_of_frames,
+              std::vector< T >&                      out_samples,
+              std::thread::id&                       out_thread,
+              std::binary_semaphore&                 io_done
+            )
+    \brief  Reads from io_stream, noting the thread it was resumed on.
+ */
+template< cahal::Sample T >
+Task
+read_frames (
+             cahal::Stream< T, SimulatedPlatform >& io_stream,
+             UINT32                                 in_number_of_frames,
+             std::vector< T >&                      out_samples,
+             std::thread::id&                       out_thread,
+             std::binary_semaphore&                 io_done
+             )
+{
+  out_samples = co_await io_stream.read( in_number_of_frames );
+  out_thread  = std::this_thread::get_id();
+
+  io_done.release();
+}
+
+/*! \fn     template< cahal::Sample T > Task destroy_after_read (
+              std::optional< cahal::Stream< T, SimulatedPlatform > >& io_stream,
+              std::binary_semaphore&                                 io_done
+            )
+    \brief  Reads from io_stream and destroys it on the thread it was resumed
+            on.
+ */
+template< cahal::Sample T >
+Task
+destroy_after_read  (
+             std::optional< cahal::Stream< T, SimulatedPlatform > >& io_stream,
+             std::binary_semaphore&                                 io_done
+                     )
+{
+  std::vector< T > samples = co_await io_stream->read( 1000 );
+
+  io_stream.reset();
+
+  io_done.release();
+}
+
+/*! \fn     template< cahal::Sample T > void test_recording(
+              const cahal::Session& in_session
+            )
+    \brief  Records the counting sequence, moving the recording while it
+            runs.
+ */
+template< cahal::Sample T >
+void
+test_recording( const cahal::Session& in_session )
+{
+  std::atomic< UINT32 > number_of_samples( 0 );
+  std::atomic< bool > is_in_order( true );
+
+  auto recording =
+    cahal::record< T, SimulatedPlatform > (
+      in_session,
+      NULL,
+      2,
+      8000,
+      [ & ]( std::span< const T > in_samples )
+      {
+        for( T sample : in_samples )
+        {
+          if( get_expected< T >( number_of_samples++ ) != sample )
+          {
+            is_in_order.store( false );
+          }
+        }
+
+        return( true );
+      }
+                                          );
+
+  check( recording.is_running(), "Recording started." );
+  check  (
+          wait_until( [ & ]{ return( 1000 <= number_of_samples.load() ); } ),
+          "Recording records."
+          );
+
+  auto moved = std::move( recording );
+
+  check( ! recording.is_running(), "Moved Recording is not running." );
+  check  (
+          wait_until( [ & ]{ return( 5000 <= number_of_samples.load() ); } ),
+          "Moved Recording records."
+          );
+  check( moved.stop(), "Recording stopped." );
+  check( is_in_order.load(), "Recording delivers every sample in order." );
+}
+
+/*! \fn     template< cahal::Sample T > void test_playback(
+              const cahal::Session& in_session
+            )
+    \brief  Plays the counting sequence.
+ */
+template< cahal::Sample T >
+void
+test_playback( const cahal::Session& in_session )
+{
+  UINT32 number_of_samples = 0;
+
+  auto playback =
+    cahal::play< T, SimulatedPlatform > (
+      in_session,
+      NULL,
+      2,
+      8000,
+      1.0f,
+      [ & ]( std::span< T > out_samples )
+      {
+        for( T& sample : out_samples )
+        {
+          sample = get_expected< T >( number_of_samples++ );
+        }
+
+        return( out_samples.size() );
+      }
+                                        );
+
+  check( playback.is_running(), "Playback started." );
+  check  (
+          wait_until  (
+                       [ & ]
+                       {
+                         return  (
+                                  5000
+                                  <= SimulatedPlatform::number_of_played_samples
+                                     .load()
+                                  );
+                       }
+                       ),
+          "Playback plays."
+          );
+  check( playback.stop(), "Playback stopped." );
+  check  (
+          SimulatedPlatform::is_played_in_order.load(),
+          "Playback plays every sample in order."
+          );
+}
+
+/*! \fn     template< cahal::Sample T > void test_failed_start(
+              const cahal::Session& in_session
+            )
+    \brief  Checks that a failed start releases what it left behind, so that
+            the next start succeeds.
+ */
+template< cahal::Sample T >
+void
+test_failed_start( const cahal::Session& in_session )
+{
+  auto record_nothing = []( std::span< const T > ){ return( true ); };
+  auto play_nothing   = []( std::span< T > ){ return( std::size_t( 0 ) ); };
+
+  SimulatedPlatform::is_failing_start = true;
+
+  {
+    auto recording =
+      cahal::record< T, SimulatedPlatform > (
+        in_session, NULL, 1, 8000, record_nothing
+                                            );
+    auto playback =
+      cahal::play< T, SimulatedPlatform > (
+        in_session, NULL, 1, 8000, 1.0f, play_nothing
+                                          );
+    cahal::Stream< T, SimulatedPlatform > stream( in_session, NULL, 1, 8000 );
+
+    check( ! recording.is_running(), "Failed Recording is not running." );
+    check( ! playback.is_running(), "Failed Playback is not running." );
+    check( ! stream.is_running(), "Failed Stream is not running." );
+  }
+
+  SimulatedPlatform::is_failing_start = false;
+
+  check  (
+          NULL == SimulatedPlatform::recorder_info
+          && NULL == SimulatedPlatform::playback_info,
+          "Failed starts release their callback info."
+          );
+
+  auto recording =
+    cahal::record< T, SimulatedPlatform > (
+      in_session, NULL, 1, 8000, record_nothing
+                                          );
+  auto playback =
+    cahal::play< T, SimulatedPlatform > (
+      in_session, NULL, 1, 8000, 1.0f, play_nothing
+                                        );
+
+  check( recording.is_running(), "Recording starts after a failed start." );
+  check( playback.is_running(), "Playback starts after a failed start." );
+}
+
+/*! \fn     template< cahal::Sample T > void test_stream(
+              const cahal::Session& in_session
+            )
+    \brief  Awaits reads of a Stream, which must not be resumed on the OS
+            thread, including a read that destroys the stream.
+ */
+template< cahal::Sample T >
+void
+test_stream( const cahal::Session& in_session )
+{
+  std::binary_semaphore done( 0 );
+  std::vector< T > samples;
+  std::thread::id thread;
+  bool is_in_order = true;
+
+  {
+    cahal::Stream< T, SimulatedPlatform > stream( in_session, NULL, 2, 8000 );
+
+    check( stream.is_running(), "Stream started." );
+
+    read_frames< T >( stream, 1000, samples, thread, done );
+
+    check( done.try_acquire_for( simulated_timeout ), "Stream read." );
+    check( 2000 == samples.size(), "Stream reads whole frames." );
+
+    for( UINT32 i = 0; i < samples.size(); i++ )
+    {
+      is_in_order = is_in_order && get_expected< T >( i ) == samples[ i ];
+    }
+
+    check( is_in_order, "Stream reads every sample in order." );
+    check  (
+            SimulatedPlatform::recorder_id.load() != thread,
+            "Stream does not resume on the OS thread."
+            );
+  }
+
+  std::optional< cahal::Stream< T, SimulatedPlatform > > stream;
+  cahal_device* device = NULL;
+
+  stream.emplace( in_session, device, 1, 8000 );
+
+  destroy_after_read< T >( stream, done );
+
+  check  (
+          done.try_acquire_for( simulated_timeout ),
+          "Stream destroyed by its reader."
+          );
+
+  cahal::Stream< T, SimulatedPlatform > next( in_session, NULL, 1, 8000 );
+
+  check( next.is_running(), "Stream starts after one was destroyed." );
+}
+
+/*! \fn     template< cahal::Sample T > void test_stream_os_buffers(
+              const cahal::Session& in_session
+            )
+    \brief  Awaits reads of a Stream recorded in one-second buffers, which
+            are longer than the default buffer duration of the stream, and
+            a read longer than the stream can hold.
+ */
+template< cahal::Sample T >
+void
+test_stream_os_buffers( const cahal::Session& in_session )
+{
+  std::binary_semaphore done( 0 );
+  std::vector< T > samples;
+  std::thread::id thread;
+  bool is_in_order = true;
+
+  SimulatedPlatform::number_of_buffer_frames = 8000;
+
+  {
+    cahal::Stream< T, SimulatedPlatform > stream( in_session, NULL, 1, 8000 );
+
+    read_frames< T >( stream, 1000, samples, thread, done );
+
+    check  (
+            done.try_acquire_for( simulated_timeout ),
+            "Stream reads one-second buffers."
+            );
+    check( 1000 == samples.size(), "Stream reads whole OS buffers." );
+
+    read_frames< T >( stream, 1000000, samples, thread, done );
+
+    check  (
+            done.try_acquire_for( simulated_timeout ),
+            "Stream completes the longest read."
+            );
+    check  (
+            cahal::stream_buffer_duration * 8000 <= samples.size(),
+            "Stream reads at least its buffer duration."
+            );
+
+    for( UINT32 i = 0; i < samples.size(); i++ )
+    {
+      is_in_order =
+        is_in_order && get_expected< T >( 1000 + i ) == samples[ i ];
+    }
+
+    check( is_in_order, "Stream reads OS buffers in order." );
+  }
+
+  SimulatedPlatform::number_of_buffer_frames = simulated_buffer_frames;
+}
+
+/*! \fn     template< cahal::Sample T > void test_sample_type(
+              const cahal::Session& in_session
+            )
+    \brief  Runs every test for samples of type T.
+ */
+template< cahal::Sample T >
+void
+test_sample_type( const cahal::Session& in_session )
+{
+  test_recording< T >( in_session );
+  test_playback< T >( in_session );
+  test_failed_start< T >( in_session );
+  test_stream< T >( in_session );
+  test_stream_os_buffers< T >( in_session );
+}
+
+}
+
+int
+main( void )
+{
+  bool is_thrown = false;
+
+  {
+    cahal::Session session;
+
+    test_sample_type< int16_t >( session );
+    test_sample_type< int32_t >( session );
+    test_sample_type< float >( session );
+  }
+
+  //  Sessions never terminate the library, so a later one can use it
+  {
+    cahal::Session session;
+
+    check  (
+            CAHAL_STATE_INITIALIZED == CAHAL_ATOMIC_LOAD( &g_cahal_state ),
+            "Session keeps the library initialized."
+            );
+  }
+
+  cahal_terminate();
+
+  try
+  {
+    cahal::Session session;
+  }
+  catch( const std::logic_error& )
+  {
+    is_thrown = true;
+  }
+
+  check( is_thrown, "Session throws once the library is terminated." );
+
+  std::printf( "%u checks failed.\n", g_number_of_failures );
+
+  return( 0 == g_number_of_failures ? 0 : 1 );
+}
@@ -0,0 +1,47 @@
+import cahal_tests
+import unittest
+
+class TestsCAHALAggregate( unittest.TestCase ):
+  def test_invalid( self ):
+    self.assertIsNone                                                      \
+      ( cahal_tests.cahal_start_aggregate_recording                        \
+        ( 2, None, None, cahal_tests.CAHAL_AUDIO_FORMAT_LINEARPCM,         \
+          8000, 16, None, None,                                            \
+          cahal_tests.CAHAL_AUDIO_FORMAT_FLAGISSIGNEDINTEGER ) )
+
+    self.assertIsNone                                                      \
+      ( cahal_tests.cahal_aggregate_recording_create                       \
+        ( 0, None, None, cahal_tests.CAHAL_AUDIO_FORMAT_LINEARPCM,         \
+          8000, 16, None, None,                                            \
+          cahal_tests.CAHAL_AUDIO_FORMAT_FLAGISSIGNEDINTEGER, 0 ) )
+
+    self.assertEqual( cahal_tests.cahal_aggregate_get_ppm( None, 0 ), 0 )
+
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_aggregate_recording( 0, 0, 0, 60 ), -1 )
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_aggregate_recording( 9, 0, 0, 60 ), -1 )
+
+  def test_aligned( self ):
+    self.assertLess                                                        \
+      ( cahal_tests.simulate_aggregate_recording( 3, 0, 0, 60 ), 0.01 )
+
+  def test_start_offset( self ):
+    #  Members that start before the start time drop their first frames
+    self.assertLess                                                        \
+      ( cahal_tests.simulate_aggregate_recording( 3, 0, -0.05, 60 ), 0.01 )
+
+    #  Members that start after it are padded
+    self.assertLess                                                        \
+      ( cahal_tests.simulate_aggregate_recording( 2, 0, 0.03, 60 ), 0.01 )
+
+  def test_drift( self ):
+    #  The resampler needs a few minutes to settle on the drift
+    difference =                                                           \
+      cahal_tests.simulate_aggregate_recording( 2, 100, 0, 300 )
+
+    self.assertGreaterEqual( difference, 0 )
+    self.assertLess( difference, 0.05 )
+
+if __name__ == '__main__':
+  unittest.main()
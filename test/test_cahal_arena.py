@@ -0,0 +1,142 @@
+import cahal_tests
+import unittest
+
+class TestsCAHALArena( unittest.TestCase ):
+  def test_allocate( self ):
+    arena = cahal_tests.cahal_arena_create( 0 )
+
+    self.assertEqual( arena.number_of_blocks, 1 )
+
+    for size in [ 1, 16, 17, 100 ]:
+      self.assertIsNotNone( cahal_tests.cahal_arena_allocate( arena, size ) )
+
+    self.assertEqual( arena.bytes_used, 16 + 16 + 32 + 112 )
+    self.assertEqual( arena.number_of_blocks, 1 )
+
+    self.assertIsNotNone  (                                               \
+      cahal_tests.cahal_arena_allocate  (                                 \
+        arena, cahal_tests.CAHAL_ARENA_MINIMUM_BLOCK_SIZE                 \
+                                        )                                 \
+                          )
+    self.assertEqual( arena.number_of_blocks, 2 )
+
+    self.assertIsNone( cahal_tests.cahal_arena_allocate( None, 1 ) )
+
+    cahal_tests.cahal_arena_free( arena )
+
+  def test_grow( self ):
+    arena = cahal_tests.cahal_arena_create( 0 )
+    size  = cahal_tests.CAHAL_ARENA_MINIMUM_BLOCK_SIZE
+
+    #  Each block that runs out is followed by one twice its size
+    for index in range( 1, 5 ):
+      self.assertIsNotNone  (                                             \
+        cahal_tests.cahal_arena_allocate  (                               \
+          arena, arena.blocks.size - arena.blocks.used                    \
+                                          )                               \
+                            )
+      self.assertIsNotNone( cahal_tests.cahal_arena_allocate( arena, 1 ) )
+      self.assertEqual( arena.number_of_blocks, index + 1 )
+      self.assertEqual( arena.blocks.size, size << index )
+
+    #  Unless more is asked for
+    self.assertIsNotNone                                                   \
+      ( cahal_tests.cahal_arena_allocate( arena, size << 6 ) )
+    self.assertEqual( arena.blocks.size, size << 6 )
+
+    cahal_tests.cahal_arena_free( arena )
+
+  def test_intern( self ):
+    arena = cahal_tests.cahal_arena_create( 0 )
+
+    for index in range( 100 ):
+      self.assertEqual  (                                                 \
+        cahal_tests.cahal_arena_intern( arena, "string%d" % ( index % 10 ) ), \
+        "string%d" % ( index % 10 )                                       \
+                        )
+
+    self.assertEqual( arena.number_of_strings, 10 )
+    self.assertEqual( arena.number_of_interned, 100 )
+    self.assertIsNone( cahal_tests.cahal_arena_intern( arena, None ) )
+
+    cahal_tests.cahal_arena_free( arena )
+
+  def test_pack_device_list( self ):
+    expected  = cahal_tests.create_simulated_device_list( 50 )
+    arena     = cahal_tests.new_cahal_arenaP()
+    packed    =                                                           \
+      cahal_tests.cahal_pack_device_list(                                 \
+        cahal_tests.create_simulated_device_list( 50 ), arena             \
+                                        )
+    packed_arena  = cahal_tests.cahal_arenaP_value( arena )
+
+    self.assertEqual( packed_arena.number_of_blocks, 1 )
+    self.assertEqual( packed_arena.number_of_strings, 2 * 50 + 3 )
+
+    for index in range( 50 ):
+      device  = cahal_tests.cahal_device_list_get( packed, index )
+      other   = cahal_tests.cahal_device_list_get( expected, index )
+
+      for field in [ "device_name", "model", "manufacturer", "device_uid",  \
+                     "model_uid", "serial_number", "preferred_sample_rate" ]:
+        self.assertEqual( getattr( device, field ), getattr( other, field ) )
+
+      for direction in range( 2 ):
+        stream        =                                                 \
+          cahal_tests.cahal_device_stream_list_get  (                   \
+            device.device_streams, direction                            \
+                                                    )
+        other_stream  =                                                 \
+          cahal_tests.cahal_device_stream_list_get  (                   \
+            other.device_streams, direction                             \
+                                                    )
+
+        self.assertEqual( stream.handle, other_stream.handle )
+
+        for format_index in range( 4 ):
+          format        =                                               \
+            cahal_tests.cahal_audio_format_description_list_get (       \
+              stream.supported_formats, format_index                    \
+                                                                )
+          other_format  =                                               \
+            cahal_tests.cahal_audio_format_description_list_get (       \
+              other_stream.supported_formats, format_index              \
+                                                                )
+
+          self.assertEqual  (                                           \
+            format.number_of_channels, other_format.number_of_channels  \
+                            )
+          self.assertEqual  (                                           \
+            format.sample_rate_range.minimum_rate,                      \
+            other_format.sample_rate_range.minimum_rate                 \
+                            )
+
+        self.assertIsNone (                                             \
+          cahal_tests.cahal_audio_format_description_list_get (         \
+            stream.supported_formats, 4                                 \
+                                                              )         \
+                          )
+
+    self.assertIsNone( cahal_tests.cahal_device_list_get( packed, 50 ) )
+
+    cahal_tests.cahal_arena_free( packed_arena )
+    cahal_tests.delete_cahal_arenaP( arena )
+    cahal_tests.free_simulated_device_list( expected )
+
+  def test_pack_empty( self ):
+    arena = cahal_tests.new_cahal_arenaP()
+
+    self.assertIsNone( cahal_tests.cahal_pack_device_list( None, arena ) )
+    self.assertIsNone( cahal_tests.cahal_arenaP_value( arena ) )
+
+    cahal_tests.delete_cahal_arenaP( arena )
+
+if __name__ == '__main__':
+  try:
+    import threading as _threading
+  except ImportError:
+    import dummy_threading as _threading
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  unittest.main()
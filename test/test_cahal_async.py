@@ -0,0 +1,56 @@
+import cahal_tests
+import time
+import unittest
+
+class TestsCAHALAsync( unittest.TestCase ):
+  def setUp( self ):
+    cahal_tests.clear_number_of_async_completions()
+
+  def test_submit( self ):
+    self.assertIsNone                                                      \
+      ( cahal_tests.cahal_async_submit( None, None, None, None ) )
+
+    start     = time.monotonic()
+    operation = cahal_tests.submit_sleeping_operation( 200 )
+
+    #  The caller does not wait for the operation to run
+    self.assertLess( time.monotonic() - start, 0.1 )
+    self.assertIsNotNone( operation )
+    self.assertFalse( cahal_tests.cahal_async_is_complete( operation ) )
+
+    self.assertTrue( cahal_tests.cahal_async_wait( operation ) )
+    self.assertTrue( cahal_tests.cahal_async_is_complete( operation ) )
+    self.assertEqual( cahal_tests.get_number_of_async_completions(), 1 )
+
+    cahal_tests.cahal_async_release( operation )
+
+  def test_release_before_completion( self ):
+    cahal_tests.cahal_async_release                                        \
+      ( cahal_tests.submit_sleeping_operation( 50 ) )
+
+    operation = cahal_tests.submit_sleeping_operation( 0 )
+
+    self.assertTrue( cahal_tests.cahal_async_wait( operation ) )
+    self.assertEqual( cahal_tests.get_number_of_async_completions(), 2 )
+
+    cahal_tests.cahal_async_release( operation )
+
+  def test_order( self ):
+    operations = []
+
+    for i in range( 50 ):
+      operations.append( cahal_tests.start_lifecycle_recording_async() )
+      operations.append( cahal_tests.stop_lifecycle_recording_async() )
+
+    #  Every start runs before the stop queued after it and vice versa
+    results = [ cahal_tests.cahal_async_wait( operation )                  \
+                for operation in operations ]
+
+    self.assertEqual( results, [ True ] * 100 )
+    self.assertEqual( cahal_tests.get_number_of_async_completions(), 100 )
+
+    for operation in operations:
+      cahal_tests.cahal_async_release( operation )
+
+if __name__ == '__main__':
+  unittest.main()
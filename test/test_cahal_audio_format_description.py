@@ -81,6 +81,111 @@ class TestsCAHALAudioFormatDescription( unittest.TestCase ):
 
       device = cahal_tests.cahal_device_list_get( device_list, index )
 
+  def test_default_channel_layout( self ):
+    layout = cahal_tests.cahal_channel_layout()
+
+    self.assertTrue( cahal_tests.cahal_get_default_channel_layout( 2, layout ) )
+    self.assertEqual  (                                           \
+      layout.layout_type, cahal_tests.CAHAL_CHANNEL_LAYOUT_SPEAKERS \
+                      )
+    self.assertEqual( layout.channel_mask, 0x3 )
+    self.assertEqual  (                                                  \
+      cahal_tests.cahal_get_channel_index                                \
+        ( layout, int( cahal_tests.CAHAL_CHANNEL_FRONT_RIGHT ) ), 1      \
+                      )
+    self.assertEqual  (                                                  \
+      cahal_tests.cahal_get_channel_index                                \
+        ( layout, int( cahal_tests.CAHAL_CHANNEL_FRONT_CENTER ) ),       \
+      cahal_tests.CAHAL_NO_CHANNEL                                       \
+                      )
+
+    for channels in [ 16, 32, cahal_tests.CAHAL_MAXIMUM_NUMBER_OF_CHANNELS ]:
+      self.assertTrue                                                    \
+        ( cahal_tests.cahal_get_default_channel_layout( channels, layout ) )
+      self.assertEqual  (                                           \
+        layout.layout_type, cahal_tests.CAHAL_CHANNEL_LAYOUT_DISCRETE \
+                        )
+      self.assertEqual                                                   \
+        ( cahal_tests.cahal_get_channel_layout_size( layout ), channels )
+      self.assertTrue                                                    \
+        ( cahal_tests.cahal_test_channel_layout( layout, channels ) )
+      self.assertFalse                                                   \
+        ( cahal_tests.cahal_test_channel_layout( layout, channels - 1 ) )
+
+    self.assertFalse                                                     \
+      ( cahal_tests.cahal_get_default_channel_layout( 0, layout ) )
+    self.assertFalse                                                     \
+      ( cahal_tests.cahal_get_default_channel_layout( 65, layout ) )
+
+  def test_deinterleave( self ):
+    channels    = 16
+    frames      = 5
+    interleaved = cahal_tests.new_floatArray( channels * frames )
+    planar      = cahal_tests.new_floatArray( channels * frames )
+    restored    = cahal_tests.new_floatArray( channels * frames )
+
+    for i in range( channels * frames ):
+      cahal_tests.floatArray_setitem( interleaved, i, i )
+
+    cahal_tests.cahal_deinterleave_float32  ( \
+      interleaved, frames, channels, planar   \
+                                            )
+    cahal_tests.cahal_interleave_float32  ( \
+      planar, frames, channels, restored    \
+                                          )
+
+    for channel in range( channels ):
+      for frame in range( frames ):
+        self.assertEqual  (                                              \
+          cahal_tests.floatArray_getitem                                 \
+            ( planar, channel * frames + frame ),                        \
+          frame * channels + channel                                     \
+                          )
+
+    for i in range( channels * frames ):
+      self.assertEqual( cahal_tests.floatArray_getitem( restored, i ), i )
+
+    cahal_tests.delete_floatArray( interleaved )
+    cahal_tests.delete_floatArray( planar )
+    cahal_tests.delete_floatArray( restored )
+
+  def test_remap_channels( self ):
+    frames      = 3
+    in_layout   = cahal_tests.cahal_channel_layout()
+    out_layout  = cahal_tests.cahal_channel_layout()
+    in_samples  = cahal_tests.new_floatArray( 2 * frames )
+    out_samples = cahal_tests.new_floatArray( 3 * frames )
+
+    in_layout.layout_type   = cahal_tests.CAHAL_CHANNEL_LAYOUT_DISCRETE
+    in_layout.channel_mask  = ( 1 << 3 ) | ( 1 << 40 )
+    out_layout.layout_type  = cahal_tests.CAHAL_CHANNEL_LAYOUT_DISCRETE
+    out_layout.channel_mask = ( 1 << 3 ) | ( 1 << 7 ) | ( 1 << 40 )
+
+    for i in range( 2 * frames ):
+      cahal_tests.floatArray_setitem( in_samples, i, i + 1 )
+
+    self.assertTrue (                                                      \
+      cahal_tests.cahal_remap_channels_float32                             \
+        ( in_samples, frames, in_layout, out_layout, out_samples )         \
+                    )
+
+    for frame in range( frames ):
+      self.assertEqual  (                                                  \
+        [ cahal_tests.floatArray_getitem( out_samples, 3 * frame + i )     \
+          for i in range( 3 ) ],                                           \
+        [ 2 * frame + 1, 0, 2 * frame + 2 ]                                \
+                        )
+
+    out_layout.layout_type = cahal_tests.CAHAL_CHANNEL_LAYOUT_SPEAKERS
+
+    self.assertFalse  (                                                    \
+      cahal_tests.cahal_remap_channels_float32                             \
+        ( in_samples, frames, in_layout, out_layout, out_samples )         \
+                      )
+
+    cahal_tests.delete_floatArray( in_samples )
+    cahal_tests.delete_floatArray( out_samples )
+
 if __name__ == '__main__':
   try:
     import threading as _threading
@@ -0,0 +1,76 @@
+import cahal_tests
+import unittest
+
+class TestsCAHALCoalescer( unittest.TestCase ):
+  def tearDown( self ):
+    cahal_tests.cahal_set_coalesce_options( None )
+
+  def test_options( self ):
+    self.assertFalse( cahal_tests.cahal_get_coalesce_options( None ) )
+
+    options = cahal_tests.cahal_coalesce_options()
+
+    options.number_of_periods = 4
+    options.number_of_bytes   = 1000
+    options.duration          = 0.5
+
+    cahal_tests.cahal_set_coalesce_options( options )
+
+    copy = cahal_tests.cahal_coalesce_options()
+
+    self.assertTrue( cahal_tests.cahal_get_coalesce_options( copy ) )
+
+    self.assertEqual( copy.number_of_periods, 4 )
+    self.assertEqual( copy.number_of_bytes, 1000 )
+    self.assertEqual( copy.duration, 0.5 )
+
+    cahal_tests.cahal_set_coalesce_options( None )
+
+    self.assertFalse( cahal_tests.cahal_get_coalesce_options( copy ) )
+
+  def test_uncoalesced( self ):
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_coalesced_recording( 50, 96 ), 50 )
+
+  def test_periods( self ):
+    options = cahal_tests.cahal_coalesce_options()
+
+    options.number_of_periods = 4
+
+    cahal_tests.cahal_set_coalesce_options( options )
+
+    #  12 full callbacks and the remaining 2 periods once stopped
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_coalesced_recording( 50, 96 ), 13 )
+
+  def test_budgets( self ):
+    options = cahal_tests.cahal_coalesce_options()
+
+    #  The largest budget is used: 10 ms are 960 bytes at 48 kHz
+    options.number_of_periods = 2
+    options.duration          = 0.01
+
+    cahal_tests.cahal_set_coalesce_options( options )
+
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_coalesced_recording( 50, 96 ), 5 )
+
+    #  Rounded up to whole 2-byte frames, so periods are split
+    options.number_of_bytes = 1001
+
+    cahal_tests.cahal_set_coalesce_options( options )
+
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_coalesced_recording( 50, 96 ), 5 )
+
+  def test_default( self ):
+    cahal_tests.cahal_set_coalesce_options                                 \
+      ( cahal_tests.cahal_coalesce_options() )
+
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_coalesced_recording( 50, 96 ),                \
+        ( 50 + cahal_tests.CAHAL_COALESCE_DEFAULT_NUMBER_OF_PERIODS - 1 )  \
+        // cahal_tests.CAHAL_COALESCE_DEFAULT_NUMBER_OF_PERIODS )
+
+if __name__ == '__main__':
+  unittest.main()
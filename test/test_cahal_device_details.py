@@ -0,0 +1,100 @@
+import cahal_tests
+import unittest
+
+class TestsCAHALDeviceDetails( unittest.TestCase ):
+  def setUp( self ):
+    cahal_tests.cahal_free_device_list()
+
+    device_list =                                                          \
+      cahal_tests.create_simulated_lazy_device_list( 3, 0, True )
+
+    self.assertTrue( cahal_tests.cahal_update_device_list( device_list ) )
+
+    self.snapshot = cahal_tests.cahal_acquire_device_snapshot()
+
+  def tearDown( self ):
+    cahal_tests.cahal_release_device_snapshot( self.snapshot )
+
+    cahal_tests.cahal_free_device_list()
+
+  def device( self, in_index ):
+    return  (                                                              \
+      cahal_tests.cahal_device_list_get( self.snapshot.devices, in_index ) \
+            )
+
+  def test_light( self ):
+    device = self.device( 1 )
+
+    self.assertEqual( device.device_name, "Simulated 1" )
+    self.assertEqual( device.device_uid, "simulated-1" )
+    self.assertIsNone( device.model )
+    self.assertIsNone                                                      \
+      ( cahal_tests.cahal_device_stream_list_get                           \
+          ( device.device_streams, 0 ).supported_formats )
+    self.assertEqual                                                       \
+      ( self.snapshot.details_state, cahal_tests.CAHAL_ONCE_PENDING )
+    self.assertEqual  (                                                    \
+      cahal_tests.cahal_find_default_device                                \
+        ( self.snapshot, cahal_tests.CAHAL_DEVICE_OUTPUT_STREAM ).device_uid, \
+      "simulated-0"                                                        \
+                      )
+
+  def test_load( self ):
+    device = self.device( 1 )
+
+    self.assertTrue( cahal_tests.cahal_load_device_details( device ) )
+    self.assertEqual( device.model, "Simulator" )
+    self.assertEqual( device.preferred_sample_rate, 44100 )
+    self.assertIsNotNone                                                   \
+      ( cahal_tests.cahal_device_stream_list_get                           \
+          ( device.device_streams, 1 ).supported_formats )
+    self.assertIsNone( self.device( 2 ).model )
+
+    model = device.model
+
+    self.assertTrue( cahal_tests.cahal_load_device_details( device ) )
+    self.assertEqual( device.model, model )
+    self.assertFalse( cahal_tests.cahal_load_device_details( None ) )
+
+  def test_capabilities( self ):
+    devices = cahal_tests.cahal_find_devices  (                            \
+      self.snapshot, cahal_tests.CAHAL_DEVICE_OUTPUT_STREAM,               \
+      cahal_tests.CAHAL_DEVICE_CAPABILITY_LINEAR_PCM                       \
+                                              )
+
+    self.assertEqual                                                       \
+      ( self.snapshot.details_state, cahal_tests.CAHAL_ONCE_DONE )
+    self.assertEqual                                                       \
+      ( cahal_tests.cahal_device_list_get( devices, 2 ).model, "Simulator" )
+    self.assertIsNone( cahal_tests.cahal_device_list_get( devices, 3 ) )
+
+  def test_format_index( self ):
+    stream =                                                               \
+      cahal_tests.cahal_device_stream_list_get                             \
+        ( self.device( 0 ).device_streams, 1 )
+
+    self.assertIsNotNone                                                   \
+      ( cahal_tests.cahal_get_format_index( self.snapshot, stream ) )
+    self.assertEqual( self.device( 2 ).model, "Simulator" )
+
+  def test_eager( self ):
+    device_list =                                                          \
+      cahal_tests.create_simulated_lazy_device_list( 2, 0, False )
+
+    self.assertEqual                                                       \
+      ( cahal_tests.cahal_device_list_get( device_list, 1 ).model,         \
+        "Simulator" )
+
+    cahal_tests.free_simulated_device_list( device_list )
+
+if __name__ == '__main__':
+  try:
+    import threading as _threading
+  except ImportError:
+    import dummy_threading as _threading
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  cahal_tests.python_cahal_initialize()
+
+  unittest.main()
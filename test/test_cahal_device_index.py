@@ -0,0 +1,120 @@
+import cahal_tests
+import unittest
+
+class TestsCAHALDeviceIndex( unittest.TestCase ):
+  def setUp( self ):
+    cahal_tests.cahal_free_device_list()
+
+    device_list = cahal_tests.create_simulated_device_list( 3 )
+    device      = cahal_tests.cahal_device_list_get( device_list, 1 )
+    stream      =                                                          \
+      cahal_tests.cahal_device_stream_list_get( device.device_streams, 1 )
+    format      =                                                          \
+      cahal_tests.cahal_audio_format_description_list_get                  \
+        ( stream.supported_formats, 0 )
+
+    format.number_of_channels = 6
+    format.bit_depth          = 24
+
+    cahal_tests.cahal_device_list_get( device_list, 2 ).device_name =       \
+      "Simulated 0"
+
+    self.assertTrue( cahal_tests.cahal_update_device_list( device_list ) )
+
+    self.snapshot = cahal_tests.cahal_acquire_device_snapshot()
+
+  def tearDown( self ):
+    cahal_tests.cahal_release_device_snapshot( self.snapshot )
+
+    cahal_tests.cahal_free_device_list()
+
+  def uids( self, device_list ):
+    uids  = []
+    index = 0
+
+    while( cahal_tests.cahal_device_list_get( device_list, index ) ):
+      uids.append                                                          \
+        ( cahal_tests.cahal_device_list_get( device_list, index ).device_uid )
+
+      index += 1
+
+    return( uids )
+
+  def test_uid( self ):
+    device =                                                               \
+      cahal_tests.cahal_find_device_by_uid( self.snapshot, "simulated-1" )
+
+    self.assertEqual( device.device_name, "Simulated 1" )
+    self.assertEqual                                                       \
+      ( cahal_tests.cahal_device_list_get( self.snapshot.devices, 1 ), device )
+    self.assertIsNone                                                      \
+      ( cahal_tests.cahal_find_device_by_uid( self.snapshot, "missing" ) )
+    self.assertIsNone                                                      \
+      ( cahal_tests.cahal_find_device_by_uid( None, "simulated-1" ) )
+
+  def test_name( self ):
+    self.assertEqual  (                                                    \
+      cahal_tests.cahal_find_device_by_name                                \
+        ( self.snapshot, "Simulated 0" ).device_uid,                       \
+      "simulated-0"                                                        \
+                      )
+    self.assertIsNone                                                      \
+      ( cahal_tests.cahal_find_device_by_name( self.snapshot, "Simulated 2" ) )
+
+  def test_default( self ):
+    self.assertEqual  (                                                    \
+      cahal_tests.cahal_find_default_device                                \
+        ( self.snapshot, cahal_tests.CAHAL_DEVICE_OUTPUT_STREAM ).device_uid, \
+      "simulated-0"                                                        \
+                      )
+    self.assertEqual  (                                                    \
+      cahal_tests.cahal_find_default_device                                \
+        ( self.snapshot, cahal_tests.CAHAL_DEVICE_INPUT_STREAM ).device_uid, \
+      "simulated-0"                                                        \
+                      )
+
+  def test_capabilities( self ):
+    output  = cahal_tests.CAHAL_DEVICE_OUTPUT_STREAM
+    input   = cahal_tests.CAHAL_DEVICE_INPUT_STREAM
+
+    self.assertEqual  (                                                    \
+      self.uids  (                                                         \
+        cahal_tests.cahal_find_devices                                     \
+          ( self.snapshot, output, cahal_tests.CAHAL_DEVICE_CAPABILITY_NONE ) \
+                 ),                                                        \
+      [ "simulated-0", "simulated-1", "simulated-2" ]                      \
+                      )
+    self.assertEqual  (                                                    \
+      self.uids  (                                                         \
+        cahal_tests.cahal_find_devices                                     \
+          ( self.snapshot, output,                                         \
+            cahal_tests.CAHAL_DEVICE_CAPABILITY_LINEAR_PCM                 \
+            | cahal_tests.CAHAL_DEVICE_CAPABILITY_MULTICHANNEL             \
+            | cahal_tests.CAHAL_DEVICE_CAPABILITY_HIGH_RESOLUTION )        \
+                 ),                                                        \
+      [ "simulated-1" ]                                                    \
+                      )
+    self.assertEqual  (                                                    \
+      self.uids  (                                                         \
+        cahal_tests.cahal_find_devices                                     \
+          ( self.snapshot, input,                                          \
+            cahal_tests.CAHAL_DEVICE_CAPABILITY_MULTICHANNEL )             \
+                 ),                                                        \
+      []                                                                   \
+                      )
+    self.assertIsNone (                                                    \
+      cahal_tests.cahal_find_devices                                       \
+        ( self.snapshot, output, cahal_tests.CAHAL_DEVICE_CAPABILITY_ALL + 1 ) \
+                      )
+
+if __name__ == '__main__':
+  try:
+    import threading as _threading
+  except ImportError:
+    import dummy_threading as _threading
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  cahal_tests.python_cahal_initialize()
+
+  unittest.main()
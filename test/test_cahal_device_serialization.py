@@ -0,0 +1,262 @@
+import cahal_tests
+import unittest
+import tempfile
+import shutil
+import os
+
+FIXTURE = """
+{
+  "version": 1,
+  "comment": "Recorded from a USB headset",
+  "devices": [
+    {
+      "device_streams": [
+        { "direction": 0, "handle": 7, "extra": [ 1, { "a": null } ],
+          "supported_formats": [
+            { "format_id": 0, "number_of_channels": 1,
+              "bit_depth": 16, "minimum_rate": 16000, "maximum_rate": 48000 }
+          ] }
+      ],
+      "device_name": "Headset \\"Pro\\" \\u00e9",
+      "device_uid": "usb-headset",
+      "serial_number": null,
+      "preferred_sample_rate": 48000,
+      "is_alive": 1
+    }
+  ]
+}
+"""
+
+class TestsCAHALDeviceSerialization( unittest.TestCase ):
+  def setUp( self ):
+    self.directory    = tempfile.mkdtemp()
+    self.path         = os.path.join( self.directory, "devices" )
+    self.device_list  = cahal_tests.create_simulated_device_list( 3 )
+
+    cahal_tests.cahal_device_list_get( self.device_list, 1 ).serial_number = \
+      "Serial \"1\"\n"
+
+  def tearDown( self ):
+    cahal_tests.cahal_set_device_replay_file( None )
+
+    cahal_tests.cahal_free_device_list()
+
+    cahal_tests.free_simulated_device_list( self.device_list )
+
+    shutil.rmtree( self.directory )
+
+  def describe( self, device_list ):
+    devices = []
+    index   = 0
+    device  = cahal_tests.cahal_device_list_get( device_list, index )
+
+    while( device ):
+      rates   = []
+      streams = []
+      j       = 0
+      rate    =                                                            \
+        cahal_tests.cahal_sample_rate_range_list_get                       \
+          ( device.supported_sample_rates, j )
+
+      while( rate ):
+        rates.append( ( rate.minimum_rate, rate.maximum_rate ) )
+
+        j     += 1
+        rate  =                                                            \
+          cahal_tests.cahal_sample_rate_range_list_get                     \
+            ( device.supported_sample_rates, j )
+
+      j       = 0
+      stream  =                                                            \
+        cahal_tests.cahal_device_stream_list_get( device.device_streams, j )
+
+      while( stream ):
+        formats = []
+        k       = 0
+        format  =                                                          \
+          cahal_tests.cahal_audio_format_description_list_get              \
+            ( stream.supported_formats, k )
+
+        while( format ):
+          formats.append  (                                                \
+            ( format.format_id, format.number_of_channels, format.bit_depth, \
+              format.sample_rate_range.minimum_rate,                       \
+              format.sample_rate_range.maximum_rate,                       \
+              format.channel_layout.layout_type,                           \
+              format.channel_layout.channel_mask )                         \
+                          )
+
+          k       += 1
+          format  =                                                        \
+            cahal_tests.cahal_audio_format_description_list_get            \
+              ( stream.supported_formats, k )
+
+        streams.append  (                                                  \
+          ( stream.handle, stream.direction, stream.preferred_format,      \
+            formats )                                                      \
+                        )
+
+        j       += 1
+        stream  =                                                          \
+          cahal_tests.cahal_device_stream_list_get( device.device_streams, j )
+
+      devices.append  (                                                    \
+        ( device.device_name, device.model, device.manufacturer,           \
+          device.serial_number, device.version, device.device_uid,         \
+          device.model_uid, device.preferred_sample_rate, device.handle,   \
+          device.preferred_number_of_channels, device.is_alive,            \
+          device.is_running, rates, streams )                              \
+                      )
+
+      index   += 1
+      device  = cahal_tests.cahal_device_list_get( device_list, index )
+
+    return( devices )
+
+  def round_trip( self, encoding ):
+    self.assertTrue (                                                      \
+      cahal_tests.cahal_save_device_list                                   \
+        ( self.device_list, self.path, encoding )                          \
+                    )
+
+    loaded = cahal_tests.cahal_load_device_list( self.path )
+
+    self.assertEqual                                                       \
+      ( self.describe( loaded ), self.describe( self.device_list ) )
+    self.assertEqual( len( self.describe( loaded ) ), 3 )
+
+    cahal_tests.free_simulated_device_list( loaded )
+
+  def test_binary( self ):
+    self.round_trip( cahal_tests.CAHAL_DEVICE_LIST_BINARY )
+
+  def test_json( self ):
+    self.round_trip( cahal_tests.CAHAL_DEVICE_LIST_JSON )
+
+  def test_empty( self ):
+    for encoding in [ cahal_tests.CAHAL_DEVICE_LIST_BINARY,                \
+                      cahal_tests.CAHAL_DEVICE_LIST_JSON ]:
+      self.assertTrue                                                      \
+        ( cahal_tests.cahal_save_device_list( None, self.path, encoding ) )
+
+      loaded = cahal_tests.cahal_load_device_list( self.path )
+
+      self.assertIsNotNone( loaded )
+      self.assertEqual( self.describe( loaded ), [] )
+
+      cahal_tests.free_simulated_device_list( loaded )
+
+  def test_fixture( self ):
+    loaded  = cahal_tests.cahal_device_list_from_json( FIXTURE )
+    devices = self.describe( loaded )
+
+    self.assertEqual( len( devices ), 1 )
+    self.assertEqual( devices[ 0 ][ 0 ], u"Headset \"Pro\" \u00e9" )
+    self.assertIsNone( devices[ 0 ][ 3 ] )
+    self.assertEqual( devices[ 0 ][ 5 ], "usb-headset" )
+    self.assertEqual( devices[ 0 ][ 7 ], 48000 )
+    self.assertEqual( devices[ 0 ][ 12 ], [] )
+    self.assertEqual  (                                                    \
+      devices[ 0 ][ 13 ],                                                  \
+      [ ( 7, cahal_tests.CAHAL_DEVICE_OUTPUT_STREAM, 0,                    \
+          [ ( cahal_tests.CAHAL_AUDIO_FORMAT_LINEARPCM, 1, 16,             \
+              16000, 48000,                                                \
+              cahal_tests.CAHAL_CHANNEL_LAYOUT_UNSPECIFIED, 0 ) ] ) ]      \
+                      )
+
+    cahal_tests.free_simulated_device_list( loaded )
+
+  def test_invalid( self ):
+    for json in [ "", "[]", "{ \"devices\": [ { \"handle\": -1 } ] }",     \
+                  "{ \"version\": 3 }", "{ \"devices\": [ ] } x",           \
+                  "{ \"devices\": [ { \"device_name\": \"a } ] }" ]:
+      self.assertIsNone( cahal_tests.cahal_device_list_from_json( json ) )
+
+    self.assertTrue (                                                      \
+      cahal_tests.cahal_save_device_list                                   \
+        ( self.device_list, self.path, cahal_tests.CAHAL_DEVICE_LIST_BINARY ) \
+                    )
+
+    with open( self.path, "rb" ) as file:
+      data = file.read()
+
+    with open( self.path, "wb" ) as file:
+      file.write( data[ : len( data ) // 2 ] )
+
+    self.assertIsNone( cahal_tests.cahal_load_device_list( self.path ) )
+    self.assertIsNone                                                      \
+      ( cahal_tests.cahal_load_device_list( self.path + ".missing" ) )
+
+  def test_channel_layout( self ):
+    json = FIXTURE.replace  (                                              \
+      "\"maximum_rate\": 48000",                                           \
+      "\"maximum_rate\": 48000, \"channel_layout\": %d, "                  \
+      "\"channel_positions\": [ 0, 15, 63 ]"                               \
+      % cahal_tests.CAHAL_CHANNEL_LAYOUT_DISCRETE                          \
+                            ).replace( "\"version\": 1", "\"version\": 2" )
+
+    loaded  = cahal_tests.cahal_device_list_from_json( json )
+    format  = self.describe( loaded )[ 0 ][ 13 ][ 0 ][ 3 ][ 0 ]
+
+    self.assertEqual( format[ 5 ], cahal_tests.CAHAL_CHANNEL_LAYOUT_DISCRETE )
+    self.assertEqual( format[ 6 ], 1 | ( 1 << 15 ) | ( 1 << 63 ) )
+
+    self.assertTrue (                                                      \
+      cahal_tests.cahal_save_device_list                                   \
+        ( loaded, self.path, cahal_tests.CAHAL_DEVICE_LIST_JSON )          \
+                    )
+
+    reloaded = cahal_tests.cahal_load_device_list( self.path )
+
+    self.assertEqual( self.describe( reloaded ), self.describe( loaded ) )
+
+    cahal_tests.free_simulated_device_list( reloaded )
+    cahal_tests.free_simulated_device_list( loaded )
+
+    for positions in [ "[ 64 ]", "[ 1, 1 ]" ]:
+      self.assertIsNone (                                                  \
+        cahal_tests.cahal_device_list_from_json                            \
+          ( json.replace( "[ 0, 15, 63 ]", positions ) )                   \
+                        )
+
+  def test_replay( self ):
+    self.assertTrue (                                                      \
+      cahal_tests.cahal_save_device_list                                   \
+        ( self.device_list, self.path, cahal_tests.CAHAL_DEVICE_LIST_JSON ) \
+                    )
+
+    cahal_tests.cahal_free_device_list()
+
+    self.assertTrue( cahal_tests.cahal_set_device_replay_file( self.path ) )
+
+    self.assertEqual                                                       \
+      ( self.describe( cahal_tests.cahal_get_device_list() ),              \
+        self.describe( self.device_list ) )
+
+    with open( self.path, "w" ) as file:
+      file.write( FIXTURE )
+
+    self.assertTrue( cahal_tests.cahal_refresh_device_list() )
+
+    snapshot = cahal_tests.cahal_acquire_device_snapshot()
+
+    self.assertEqual( snapshot.version, 2 )
+    self.assertEqual( snapshot.number_of_devices, 1 )
+    self.assertEqual  (                                                    \
+      cahal_tests.cahal_device_list_get( snapshot.devices, 0 ).device_uid, \
+      "usb-headset"                                                        \
+                      )
+
+    cahal_tests.cahal_release_device_snapshot( snapshot )
+
+if __name__ == '__main__':
+  try:
+    import threading as _threading
+  except ImportError:
+    import dummy_threading as _threading
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  cahal_tests.python_cahal_initialize()
+
+  unittest.main()
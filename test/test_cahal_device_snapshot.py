@@ -0,0 +1,151 @@
+import cahal_tests
+import unittest
+import tempfile
+import shutil
+import os
+
+class TestsCAHALDeviceSnapshot( unittest.TestCase ):
+  def setUp( self ):
+    cahal_tests.cahal_free_device_list()
+
+    self.assertTrue  (                                                     \
+      cahal_tests.cahal_update_device_list                                 \
+        ( cahal_tests.create_simulated_device_list( 3 ) )                  \
+                     )
+
+    self.subscription = cahal_tests.subscribe_device_change_recorder()
+
+    self.assertNotEqual( self.subscription, 0 )
+
+  def tearDown( self ):
+    cahal_tests.cahal_unsubscribe_device_changes( self.subscription )
+
+    cahal_tests.cahal_free_device_list()
+
+  def test_acquire( self ):
+    snapshot  = cahal_tests.cahal_acquire_device_snapshot()
+    other     = cahal_tests.cahal_acquire_device_snapshot()
+
+    self.assertEqual( snapshot.version, 1 )
+    self.assertEqual( snapshot.number_of_devices, 3 )
+    self.assertEqual( snapshot.reference_count, 3 )
+    self.assertEqual( other.version, snapshot.version )
+
+    cahal_tests.cahal_release_device_snapshot( other )
+    cahal_tests.cahal_release_device_snapshot( snapshot )
+    cahal_tests.cahal_release_device_snapshot( None )
+
+  def test_unchanged( self ):
+    self.assertTrue (                                                       \
+      cahal_tests.cahal_update_device_list                                  \
+        ( cahal_tests.create_simulated_device_list( 3 ) )                   \
+                    )
+
+    snapshot = cahal_tests.cahal_acquire_device_snapshot()
+
+    self.assertEqual( snapshot.version, 1 )
+    self.assertEqual( cahal_tests.get_device_change_record(), "" )
+
+    cahal_tests.cahal_release_device_snapshot( snapshot )
+
+  def test_changes( self ):
+    previous    = cahal_tests.cahal_acquire_device_snapshot()
+    device_list = cahal_tests.create_simulated_device_list( 4 )
+
+    cahal_tests.cahal_device_list_get( device_list, 0 ).device_uid  =       \
+      "usb-headset"
+    cahal_tests.cahal_device_list_get                                       \
+      ( device_list, 1 ).preferred_sample_rate = 48000
+
+    self.assertTrue( cahal_tests.cahal_update_device_list( device_list ) )
+
+    self.assertEqual  (                                                     \
+      cahal_tests.get_device_change_record().split(),                       \
+      [ "%d:simulated-0@2" % cahal_tests.CAHAL_DEVICE_CHANGE_REMOVED,       \
+        "%d:usb-headset@2" % cahal_tests.CAHAL_DEVICE_CHANGE_ADDED,         \
+        "%d:simulated-1@2" % cahal_tests.CAHAL_DEVICE_CHANGE_FORMAT_CHANGED, \
+        "%d:simulated-3@2" % cahal_tests.CAHAL_DEVICE_CHANGE_ADDED,         \
+        "%d:usb-headset@2" % cahal_tests.CAHAL_DEVICE_CHANGE_DEFAULT_CHANGED, \
+        "%d:usb-headset@2" % cahal_tests.CAHAL_DEVICE_CHANGE_DEFAULT_CHANGED ] \
+                      )
+
+    self.assertEqual( previous.version, 1 )
+    self.assertEqual  (                                                     \
+      cahal_tests.cahal_device_list_get( previous.devices, 0 ).device_uid,  \
+      "simulated-0"                                                         \
+                      )
+
+    cahal_tests.cahal_release_device_snapshot( previous )
+
+  def test_pinned_list( self ):
+    device_list = cahal_tests.cahal_get_device_list()
+
+    self.assertEqual( cahal_tests.cvar.g_device_list, device_list )
+
+    cahal_tests.cahal_update_device_list                                    \
+      ( cahal_tests.create_simulated_device_list( 1 ) )
+
+    self.assertIsNone( cahal_tests.cvar.g_device_list )
+    self.assertEqual  (                                                     \
+      cahal_tests.cahal_device_list_get( device_list, 2 ).device_uid,       \
+      "simulated-2"                                                         \
+                      )
+
+  def test_unsubscribe( self ):
+    cahal_tests.cahal_unsubscribe_device_changes( self.subscription )
+
+    cahal_tests.cahal_update_device_list( None )
+
+    self.assertEqual( cahal_tests.get_device_change_record(), "" )
+
+    snapshot = cahal_tests.cahal_acquire_device_snapshot()
+
+    self.assertEqual( snapshot.version, 2 )
+    self.assertEqual( snapshot.number_of_devices, 0 )
+
+    cahal_tests.cahal_release_device_snapshot( snapshot )
+
+  def test_scheduled_refresh( self ):
+    directory   = tempfile.mkdtemp()
+    path        = os.path.join( directory, "devices" )
+    device_list = cahal_tests.create_simulated_device_list( 4 )
+
+    self.assertTrue (                                                      \
+      cahal_tests.cahal_save_device_list                                   \
+        ( device_list, path, cahal_tests.CAHAL_DEVICE_LIST_JSON )          \
+                    )
+    self.assertTrue( cahal_tests.cahal_set_device_replay_file( path ) )
+
+    #  A burst of notifications queues a single refresh on the control
+    #  thread, which has run once an operation queued after it has
+    for i in range( 10 ):
+      cahal_tests.cahal_schedule_device_list_refresh()
+
+    operation = cahal_tests.submit_sleeping_operation( 0 )
+
+    self.assertTrue( cahal_tests.cahal_async_wait( operation ) )
+
+    cahal_tests.cahal_async_release( operation )
+    cahal_tests.cahal_set_device_replay_file( None )
+
+    snapshot = cahal_tests.cahal_acquire_device_snapshot()
+
+    self.assertEqual( snapshot.version, 2 )
+    self.assertEqual( snapshot.number_of_devices, 4 )
+
+    cahal_tests.cahal_release_device_snapshot( snapshot )
+    cahal_tests.free_simulated_device_list( device_list )
+
+    shutil.rmtree( directory )
+
+if __name__ == '__main__':
+  try:
+    import threading as _threading
+  except ImportError:
+    import dummy_threading as _threading
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  cahal_tests.python_cahal_initialize()
+
+  unittest.main()
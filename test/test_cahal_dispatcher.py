@@ -0,0 +1,54 @@
+import cahal_tests
+import unittest
+
+class TestsCAHALDispatcher( unittest.TestCase ):
+  def tearDown( self ):
+    cahal_tests.cahal_set_dispatch_options( None )
+
+  def test_options( self ):
+    self.assertFalse( cahal_tests.cahal_get_dispatch_options( None ) )
+
+    options = cahal_tests.cahal_dispatch_options()
+
+    options.scheduling.policy     = cahal_tests.CAHAL_THREAD_POLICY_FIFO
+    options.scheduling.priority   = 80
+    options.scheduling.period     = 0.005
+    options.number_of_periods     = 2
+
+    cahal_tests.cahal_set_dispatch_options( options )
+
+    copy = cahal_tests.cahal_dispatch_options()
+
+    self.assertTrue( cahal_tests.cahal_get_dispatch_options( copy ) )
+
+    self.assertEqual( copy.scheduling.policy, options.scheduling.policy )
+    self.assertEqual( copy.scheduling.priority, 80 )
+    self.assertEqual( copy.scheduling.period, 0.005 )
+    self.assertEqual( copy.number_of_periods, 2 )
+
+    cahal_tests.cahal_set_dispatch_options( None )
+
+    self.assertFalse( cahal_tests.cahal_get_dispatch_options( copy ) )
+
+  def test_recording( self ):
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_dispatched_recording                          \
+          ( 50, 160, cahal_tests.CAHAL_THREAD_POLICY_DEFAULT ), 50 * 160 )
+
+  def test_recording_real_time( self ):
+    #  Falls back to the default scheduling without the privileges
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_dispatched_recording                          \
+          ( 50, 160, cahal_tests.CAHAL_THREAD_POLICY_FIFO ), 50 * 160 )
+
+  def test_playback( self ):
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_dispatched_playback( 50, 64, 0 ), 50 * 64 )
+
+  def test_playback_failure( self ):
+    #  The samples rendered before the callback failed are still played
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_dispatched_playback( 50, 64, 3 ), 3 * 80 )
+
+if __name__ == '__main__':
+  unittest.main()
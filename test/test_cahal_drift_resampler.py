@@ -0,0 +1,181 @@
+import cahal_tests
+import unittest
+import math
+
+class TestsCAHALDriftResampler( unittest.TestCase ):
+  def setUp( self ):
+    self.channels     = 2
+    self.sample_rate  = 48000.0
+    self.flags        = cahal_tests.CAHAL_AUDIO_FORMAT_FLAGISSIGNEDINTEGER  \
+                        | cahal_tests.CAHAL_AUDIO_FORMAT_FLAGISPACKED
+
+  def create_resampler( self, target, maximum ):
+    return  cahal_tests.cahal_drift_resampler_create  ( \
+              self.channels,                            \
+              self.sample_rate,                         \
+              target,                                   \
+              maximum,                                  \
+              16,                                       \
+              self.flags,                               \
+              16,                                       \
+              self.flags                                \
+                                                      )
+
+  def write_frames( self, resampler, number_of_frames ):
+    frames = cahal_tests.new_floatArray( number_of_frames * self.channels )
+
+    for index in range( number_of_frames * self.channels ):
+      cahal_tests.floatArray_setitem  ( \
+        frames,                         \
+        index,                          \
+        0.5 * math.sin( index / 2 * 0.05 ) \
+                                      )
+
+    accepted =                                  \
+      cahal_tests.cahal_drift_resampler_write ( \
+        resampler,                              \
+        frames,                                 \
+        number_of_frames                        \
+                                              )
+
+    cahal_tests.delete_floatArray( frames )
+
+    return( accepted )
+
+  def test_create_invalid( self ):
+    self.assertIsNone( self.create_resampler( 0.1, 0.05 ) )
+    self.assertIsNone( self.create_resampler( 0.0, 0.05 ) )
+
+    self.assertIsNone (
+      cahal_tests.cahal_drift_resampler_create  ( \
+        0, self.sample_rate, 0.1, 0.2, 16, self.flags, 16, self.flags  \
+                                                ) \
+                      )
+
+    self.assertIsNone (
+      cahal_tests.cahal_drift_resampler_create  ( \
+        self.channels, self.sample_rate, 0.1, 0.2, 12, self.flags, 16,  \
+        self.flags                                                      \
+                                                ) \
+                      )
+
+  def test_create_free( self ):
+    resampler = self.create_resampler( 0.1, 0.2 )
+
+    self.assertIsNotNone( resampler )
+    self.assertEqual( cahal_tests.cahal_drift_resampler_get_ppm( resampler ), 0 )
+    self.assertEqual  (                                             \
+      cahal_tests.cahal_drift_resampler_get_latency( resampler ), 0 \
+                      )
+
+    cahal_tests.cahal_drift_resampler_free( resampler )
+    cahal_tests.cahal_drift_resampler_free( None )
+
+  def test_latency_bounded( self ):
+    resampler = self.create_resampler( 0.1, 0.2 )
+
+    self.assertEqual( self.write_frames( resampler, 4800 ), 4800 )
+    self.assertAlmostEqual  (                                         \
+      cahal_tests.cahal_drift_resampler_get_latency( resampler ), 0.1 \
+                            )
+
+    self.assertEqual( self.write_frames( resampler, 9600 ), 4800 )
+    self.assertEqual  (                                                 \
+      cahal_tests.cahal_drift_resampler_get_overruns( resampler ), 4800 \
+                      )
+    self.assertAlmostEqual  (                                         \
+      cahal_tests.cahal_drift_resampler_get_latency( resampler ), 0.2 \
+                            )
+
+    cahal_tests.cahal_drift_resampler_free( resampler )
+
+  def test_read( self ):
+    resampler = self.create_resampler( 0.1, 0.2 )
+    frames    = cahal_tests.new_floatArray( 1024 * self.channels )
+
+    cahal_tests.cahal_drift_resampler_read( resampler, frames, 1024 )
+
+    self.assertEqual( cahal_tests.floatArray_getitem( frames, 0 ), 0 )
+    self.assertEqual  (                                               \
+      cahal_tests.cahal_drift_resampler_get_underruns( resampler ), 0 \
+                      )
+
+    self.write_frames( resampler, 4800 )
+
+    for index in range( 6 ):
+      cahal_tests.cahal_drift_resampler_read( resampler, frames, 1024 )
+
+    self.assertGreater  (                                             \
+      cahal_tests.cahal_drift_resampler_get_underruns( resampler ), 0 \
+                        )
+    self.assertEqual  (                                               \
+      cahal_tests.cahal_drift_resampler_get_latency( resampler ), 0   \
+                      )
+
+    cahal_tests.delete_floatArray( frames )
+    cahal_tests.cahal_drift_resampler_free( resampler )
+
+  def drift( self, ppm ):
+    resampler = self.create_resampler( 0.1, 0.2 )
+
+    #  The estimate settles within a few loop time constants (about 40 s)
+    maximum = cahal_tests.simulate_drift( resampler, ppm, 300 )
+
+    self.assertGreater( maximum, 0 )
+    self.assertLessEqual( maximum, 0.2 )
+    self.assertAlmostEqual  (                                             \
+      cahal_tests.cahal_drift_resampler_get_ppm( resampler ), ppm,        \
+      delta = 5                                                           \
+                            )
+    self.assertAlmostEqual  (                                             \
+      cahal_tests.cahal_drift_resampler_get_latency( resampler ), 0.1,    \
+      delta = 0.02                                                        \
+                            )
+    self.assertEqual  (                                                   \
+      cahal_tests.cahal_drift_resampler_get_overruns( resampler ), 0      \
+                      )
+    self.assertEqual  (                                                   \
+      cahal_tests.cahal_drift_resampler_get_underruns( resampler ), 0     \
+                      )
+
+    cahal_tests.cahal_drift_resampler_free( resampler )
+
+  def test_drift_fast_recording( self ):
+    self.drift( 100 )
+
+  def test_drift_slow_recording( self ):
+    self.drift( -300 )
+
+  def ramp( self, ppm ):
+    resampler = self.create_resampler( 0.1, 0.2 )
+
+    #  Reads ending just short of a frame used to skip the next one
+    self.assertEqual  (                                                   \
+      cahal_tests.simulate_drift_ramp( resampler, ppm, 20000 ), 0         \
+                      )
+    self.assertEqual  (                                                   \
+      cahal_tests.cahal_drift_resampler_get_underruns( resampler ), 0     \
+                      )
+
+    cahal_tests.cahal_drift_resampler_free( resampler )
+
+  def test_ramp_slow_recording( self ):
+    self.ramp( -1000 )
+    self.ramp( -300 )
+
+  def test_ramp_matched_recording( self ):
+    self.ramp( 0 )
+
+  def test_ramp_fast_recording( self ):
+    self.ramp( 300 )
+    self.ramp( 1000 )
+
+if __name__ == '__main__':
+  try:
+    import threading as _threading
+  except ImportError:
+    import dummy_threading as _threading
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  unittest.main()
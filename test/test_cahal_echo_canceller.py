@@ -0,0 +1,118 @@
+import cahal_tests
+import unittest
+import random
+
+class TestsCAHALEchoCanceller( unittest.TestCase ):
+  def setUp( self ):
+    self.sample_rate  = 8000.0
+    self.block_size   = cahal_tests.CAHAL_ECHO_CANCELLER_BLOCK_SIZE
+
+  def test_create_invalid( self ):
+    self.assertIsNone (                                           \
+      cahal_tests.cahal_echo_canceller_create( 0, 8000.0, 0.1 )   \
+                      )
+    self.assertIsNone (                                           \
+      cahal_tests.cahal_echo_canceller_create( 1, 0.0, 0.1 )      \
+                      )
+    self.assertIsNone (                                           \
+      cahal_tests.cahal_echo_canceller_create( 1, 8000.0, 0.0 )   \
+                      )
+    self.assertIsNone (                                           \
+      cahal_tests.cahal_echo_canceller_create( 1, 8000.0, 10.0 )  \
+                      )
+
+  def test_create_free( self ):
+    canceller = cahal_tests.cahal_echo_canceller_create( 2, 8000.0, 0.1 )
+
+    self.assertIsNotNone( canceller )
+    self.assertEqual( canceller.number_of_channels, 2 )
+    self.assertEqual( canceller.number_of_partitions, 4 )
+    self.assertEqual( cahal_tests.cahal_echo_canceller_get_erle( canceller ), 0 )
+
+    cahal_tests.cahal_echo_canceller_free( canceller )
+    cahal_tests.cahal_echo_canceller_free( None )
+
+  def test_set_echo_canceller( self ):
+    canceller = cahal_tests.cahal_echo_canceller_create( 1, 8000.0, 0.1 )
+
+    self.assertTrue( cahal_tests.cahal_set_echo_canceller( canceller ) )
+    self.assertTrue( cahal_tests.cahal_set_echo_canceller( None ) )
+
+    #  The callbacks of a started stream may be using the canceller
+    for state in [ cahal_tests.cvar.g_cahal_recording_state,              \
+                   cahal_tests.cvar.g_cahal_playback_state ]:
+      self.assertTrue( cahal_tests.cahal_stream_state_begin_start( state ) )
+      self.assertFalse( cahal_tests.cahal_set_echo_canceller( canceller ) )
+
+      cahal_tests.cahal_stream_state_end_start( state, False )
+
+    self.assertTrue( cahal_tests.cahal_set_echo_canceller( None ) )
+
+    cahal_tests.cahal_echo_canceller_free( canceller )
+
+  def test_process_delay( self ):
+    canceller = cahal_tests.cahal_echo_canceller_create( 1, 8000.0, 0.1 )
+    length    = 2 * self.block_size
+    frames    = cahal_tests.new_floatArray( length )
+
+    for index in range( length ):
+      cahal_tests.floatArray_setitem( frames, index, 0 )
+
+    cahal_tests.floatArray_setitem( frames, 10, 0.5 )
+
+    cahal_tests.cahal_echo_canceller_process( canceller, frames, length, 0 )
+
+    for index in range( length ):
+      if( index == 10 + self.block_size ):
+        self.assertAlmostEqual  (                                 \
+          cahal_tests.floatArray_getitem( frames, index ), 0.5    \
+                                )
+      else:
+        self.assertEqual( cahal_tests.floatArray_getitem( frames, index ), 0 )
+
+    cahal_tests.delete_floatArray( frames )
+    cahal_tests.cahal_echo_canceller_free( canceller )
+
+  def test_cancel_echo( self ):
+    canceller = cahal_tests.cahal_echo_canceller_create( 1, 8000.0, 0.1 )
+    length    = self.block_size
+    reference = cahal_tests.new_floatArray( length )
+    recorded  = cahal_tests.new_floatArray( length )
+    time      = 1000000000
+    duration  = int( length * 1000000000 / self.sample_rate )
+
+    random.seed( 0 )
+
+    for block in range( 80 ):
+      for index in range( length ):
+        sample = random.uniform( -0.5, 0.5 )
+
+        cahal_tests.floatArray_setitem( reference, index, sample )
+        cahal_tests.floatArray_setitem( recorded, index, 0.5 * sample )
+
+      cahal_tests.cahal_echo_canceller_write_reference  ( \
+        canceller, reference, length, 1, time             \
+                                                        )
+      cahal_tests.cahal_echo_canceller_process  ( \
+        canceller, recorded, length, time         \
+                                                )
+
+      time += duration
+
+    self.assertGreater  (                                     \
+      cahal_tests.cahal_echo_canceller_get_erle( canceller ), 10 \
+                        )
+
+    cahal_tests.delete_floatArray( reference )
+    cahal_tests.delete_floatArray( recorded )
+    cahal_tests.cahal_echo_canceller_free( canceller )
+
+if __name__ == '__main__':
+  try:
+    import threading as _threading
+  except ImportError:
+    import dummy_threading as _threading
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  unittest.main()
@@ -0,0 +1,204 @@
+import cahal_tests
+import unittest
+import math
+
+class TestsCAHALFilterBank( unittest.TestCase ):
+  def setUp( self ):
+    self.sample_rate  = 8000.0
+
+  def process( self, in_bank, in_samples, in_channels ):
+    frames  = cahal_tests.new_floatArray( len( in_samples ) )
+    samples = []
+
+    for index in range( len( in_samples ) ):
+      cahal_tests.floatArray_setitem( frames, index, in_samples[ index ] )
+
+    cahal_tests.cahal_filter_bank_process (                 \
+      in_bank, frames, len( in_samples ) / in_channels      \
+                                          )
+
+    for index in range( len( in_samples ) ):
+      samples.append( cahal_tests.floatArray_getitem( frames, index ) )
+
+    cahal_tests.delete_floatArray( frames )
+
+    return( samples )
+
+  def rms( self, in_samples, in_channel, in_channels ):
+    power = 0.0
+    count = 0
+
+    for index in range( in_channel, len( in_samples ), in_channels ):
+      power += in_samples[ index ] ** 2
+      count += 1
+
+    return( math.sqrt( power / count ) )
+
+  def test_create_invalid( self ):
+    self.assertIsNone( cahal_tests.cahal_filter_bank_create( 0, 8000.0 ) )
+    self.assertIsNone( cahal_tests.cahal_filter_bank_create( 1, -1.0 ) )
+
+    bank = cahal_tests.cahal_filter_bank_create( 1, 8000.0 )
+
+    self.assertFalse  (                                       \
+      cahal_tests.cahal_filter_bank_add_section (             \
+        bank, cahal_tests.CAHAL_FILTER_LOWPASS, 0, 0.7071, 0  \
+                                                )             \
+                      )
+    self.assertFalse  (                                       \
+      cahal_tests.cahal_filter_bank_add_section (             \
+        bank, cahal_tests.CAHAL_FILTER_LOWPASS, 100, 0, 0     \
+                                                )             \
+                      )
+    self.assertFalse  (                                         \
+      cahal_tests.cahal_filter_bank_add_section (               \
+        bank, cahal_tests.CAHAL_FILTER_LOWPASS, 4000, 0.7071, 0 \
+                                                )               \
+                      )
+
+    for index in range( cahal_tests.CAHAL_FILTER_BANK_MAXIMUM_SECTIONS ):
+      self.assertTrue (                                           \
+        cahal_tests.cahal_filter_bank_add_section (               \
+          bank, cahal_tests.CAHAL_FILTER_PEAK, 1000, 1, 3         \
+                                                  )               \
+                      )
+
+    self.assertFalse  (                                         \
+      cahal_tests.cahal_filter_bank_add_section (               \
+        bank, cahal_tests.CAHAL_FILTER_PEAK, 1000, 1, 3         \
+                                                )               \
+                      )
+
+    cahal_tests.cahal_filter_bank_free( bank )
+    cahal_tests.cahal_filter_bank_free( None )
+
+  def test_set_sample_rate( self ):
+    bank = cahal_tests.cahal_filter_bank_create( 2, 0 )
+
+    self.assertTrue (                                             \
+      cahal_tests.cahal_filter_bank_add_section (                 \
+        bank, cahal_tests.CAHAL_FILTER_HIGHPASS, 3000, 0.7071, 0  \
+                                                )                 \
+                    )
+
+    self.assertFalse( cahal_tests.cahal_set_capture_filter_bank( bank ) )
+
+    self.assertTrue( cahal_tests.cahal_filter_bank_set_sample_rate( bank, 8000 ) )
+    self.assertFalse( cahal_tests.cahal_filter_bank_set_sample_rate( bank, 4000 ) )
+    self.assertTrue( cahal_tests.cahal_filter_bank_set_sample_rate( bank, 48000 ) )
+
+    self.assertTrue( cahal_tests.cahal_set_capture_filter_bank( bank ) )
+    self.assertTrue( cahal_tests.cahal_set_capture_filter_bank( None ) )
+
+    #  The callbacks of a started recording may be using the bank
+    state = cahal_tests.cvar.g_cahal_recording_state
+
+    self.assertTrue( cahal_tests.cahal_stream_state_begin_start( state ) )
+    self.assertFalse( cahal_tests.cahal_set_capture_filter_bank( bank ) )
+
+    cahal_tests.cahal_stream_state_end_start( state, False )
+
+    self.assertTrue( cahal_tests.cahal_set_capture_filter_bank( None ) )
+
+    cahal_tests.cahal_filter_bank_free( bank )
+
+  def test_dc_block( self ):
+    channels  = 8
+    bank      =                                                   \
+      cahal_tests.cahal_filter_bank_create( channels, self.sample_rate )
+
+    self.assertTrue (                                           \
+      cahal_tests.cahal_filter_bank_add_section (               \
+        bank, cahal_tests.CAHAL_FILTER_DC_BLOCK, 20, 1, 0       \
+                                                )               \
+                    )
+
+    pole    = math.exp( -2 * math.pi * 20 / self.sample_rate )
+    samples = self.process( bank, [ 0.5 ] * ( 4000 * channels ), channels )
+
+    for channel in range( channels ):
+      self.assertAlmostEqual  (                               \
+        samples[ channel ], 0.5 * ( 1 + pole ) / 2, places=5  \
+                              )
+      self.assertLess( abs( samples[ channel - channels ] ), 1e-4 )
+
+    cahal_tests.cahal_filter_bank_free( bank )
+
+  def test_notch_channels( self ):
+    channels  = 5
+    length    = 8000
+    bank      =                                                   \
+      cahal_tests.cahal_filter_bank_create( channels, self.sample_rate )
+    samples   = []
+
+    self.assertTrue (                                           \
+      cahal_tests.cahal_filter_bank_add_section (               \
+        bank, cahal_tests.CAHAL_FILTER_NOTCH, 50, 10, 0         \
+                                                )               \
+                    )
+
+    for index in range( length ):
+      hum   = 0.5 * math.sin( 2 * math.pi * 50 * index / self.sample_rate )
+      tone  = 0.5 * math.sin( 2 * math.pi * 1000 * index / self.sample_rate )
+
+      for channel in range( channels ):
+        if( channel % 2 ):
+          samples.append( hum )
+        else:
+          samples.append( tone )
+
+    samples = self.process( bank, samples, channels )[ length * channels / 2 : ]
+
+    for channel in range( channels ):
+      if( channel % 2 ):
+        self.assertLess( self.rms( samples, channel, channels ), 1e-3 )
+      else:
+        self.assertAlmostEqual  (                             \
+          self.rms( samples, channel, channels ),             \
+          0.5 / math.sqrt( 2 ),                               \
+          places=2                                            \
+                                )
+
+      self.assertAlmostEqual  (                               \
+        samples[ channel ], samples[ channel % 2 ], places=5  \
+                              )
+
+    cahal_tests.cahal_filter_bank_free( bank )
+
+  def test_shelf_cascade( self ):
+    bank = cahal_tests.cahal_filter_bank_create( 1, self.sample_rate )
+
+    self.assertTrue (                                             \
+      cahal_tests.cahal_filter_bank_add_section (                 \
+        bank, cahal_tests.CAHAL_FILTER_LOW_SHELF, 200, 0.7071, 6  \
+                                                )                 \
+                    )
+    self.assertTrue (                                               \
+      cahal_tests.cahal_filter_bank_add_section (                   \
+        bank, cahal_tests.CAHAL_FILTER_HIGH_SHELF, 2000, 0.7071, -6 \
+                                                )                   \
+                    )
+
+    samples = self.process( bank, [ 0.25 ] * 4000, 1 )
+
+    self.assertAlmostEqual  (                                 \
+      samples[ -1 ], 0.25 * 10 ** ( 6 / 20.0 ), places=3      \
+                            )
+
+    cahal_tests.cahal_filter_bank_reset( bank )
+
+    samples = self.process( bank, [ 0.0 ] * 10, 1 )
+
+    self.assertEqual( samples[ -1 ], 0.0 )
+
+    cahal_tests.cahal_filter_bank_free( bank )
+
+if __name__ == '__main__':
+  try:
+    import threading as _threading
+  except ImportError:
+    import dummy_threading as _threading
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  unittest.main()
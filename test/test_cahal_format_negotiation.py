@@ -0,0 +1,166 @@
+import cahal_tests
+import unittest
+
+class TestsCAHALFormatNegotiation( unittest.TestCase ):
+  def setUp( self ):
+    cahal_tests.cahal_free_device_list()
+
+    self.assertTrue  (                                                     \
+      cahal_tests.cahal_update_device_list                                 \
+        ( cahal_tests.create_simulated_device_list( 1 ) )                  \
+                     )
+
+    self.snapshot = cahal_tests.cahal_acquire_device_snapshot()
+    device        =                                                        \
+      cahal_tests.cahal_device_list_get( self.snapshot.devices, 0 )
+    self.input    =                                                        \
+      cahal_tests.cahal_device_stream_list_get( device.device_streams, 0 )
+    self.output   =                                                        \
+      cahal_tests.cahal_device_stream_list_get( device.device_streams, 1 )
+
+    self.request                        = cahal_tests.cahal_format_request()
+    self.request.format_id              =                                  \
+      cahal_tests.CAHAL_AUDIO_FORMAT_LINEARPCM
+    self.request.sample_rate            = 44100
+    self.request.number_of_channels     = 2
+    self.request.bit_depth              = 16
+    self.request.format_flags           =                                  \
+      cahal_tests.CAHAL_AUDIO_FORMAT_FLAGISSIGNEDINTEGER
+    self.request.allowed_conversions    =                                  \
+      cahal_tests.CAHAL_FORMAT_CONVERSION_ALL
+
+    self.match = cahal_tests.cahal_format_match()
+
+  def tearDown( self ):
+    cahal_tests.cahal_release_device_snapshot( self.snapshot )
+
+    cahal_tests.cahal_free_device_list()
+
+  def steps( self ):
+    return  [                                                             \
+      cahal_tests.uintArray_getitem( self.match.steps, i )                \
+        for i in range( self.match.number_of_steps )                      \
+            ]
+
+  def find( self, stream ):
+    index = cahal_tests.cahal_get_format_index( self.snapshot, stream )
+
+    self.assertIsNotNone( index )
+
+    return( cahal_tests.cahal_find_best_format( index, self.request,       \
+                                                self.match ) )
+
+  def test_index( self ):
+    index = cahal_tests.cahal_get_format_index( self.snapshot, self.output )
+
+    self.assertEqual( index.number_of_entries, 4 )
+    self.assertIsNone                                                      \
+      ( cahal_tests.cahal_get_format_index( self.snapshot, None ) )
+
+    stream  = cahal_tests.cahal_device_stream()
+    index   = cahal_tests.cahal_create_format_index( stream )
+
+    self.assertEqual( index.number_of_entries, 0 )
+    self.assertFalse  (                                                    \
+      cahal_tests.cahal_find_best_format( index, self.request, self.match ) \
+                      )
+
+    cahal_tests.cahal_free_format_index( index )
+    cahal_tests.cahal_free_format_index( None )
+
+  def test_native( self ):
+    self.assertTrue( self.find( self.output ) )
+
+    self.assertEqual  (                                                    \
+      self.match.conversions, cahal_tests.CAHAL_FORMAT_CONVERSION_NONE     \
+                      )
+    self.assertEqual( self.match.number_of_steps, 0 )
+    self.assertEqual( self.match.format.number_of_channels, 2 )
+    self.assertEqual( self.match.sample_rate, 44100 )
+    self.assertEqual( self.match.cost, 0 )
+
+  def test_tolerance( self ):
+    self.request.sample_rate            = 44000
+    self.request.sample_rate_tolerance  = 200
+
+    self.assertTrue( self.find( self.output ) )
+
+    self.assertEqual  (                                                    \
+      self.match.conversions, cahal_tests.CAHAL_FORMAT_CONVERSION_NONE     \
+                      )
+    self.assertEqual( self.match.sample_rate, 44100 )
+
+  def test_resample( self ):
+    self.request.sample_rate = 48000
+
+    self.assertTrue( self.find( self.output ) )
+
+    self.assertEqual  (                                                    \
+      self.match.conversions,                                              \
+      cahal_tests.CAHAL_FORMAT_CONVERSION_SAMPLE_RATE                      \
+                      )
+    self.assertEqual( self.match.sample_rate, 44100 )
+    self.assertEqual  (                                                    \
+      self.steps(),                                                        \
+      [ cahal_tests.CAHAL_FORMAT_STEP_TO_FLOAT32,                          \
+        cahal_tests.CAHAL_FORMAT_STEP_RESAMPLE,                            \
+        cahal_tests.CAHAL_FORMAT_STEP_FROM_FLOAT32 ]                       \
+                      )
+    self.assertGreater( self.match.latency, 0 )
+
+  def test_channels_and_float( self ):
+    self.request.number_of_channels = 6
+    self.request.bit_depth          = 32
+    self.request.format_flags       =                                      \
+      cahal_tests.CAHAL_AUDIO_FORMAT_FLAGISFLOAT
+
+    self.assertTrue( self.find( self.output ) )
+
+    self.assertEqual( self.match.format.number_of_channels, 2 )
+    self.assertEqual  (                                                    \
+      self.match.conversions,                                              \
+      cahal_tests.CAHAL_FORMAT_CONVERSION_CHANNELS                         \
+      | cahal_tests.CAHAL_FORMAT_CONVERSION_SAMPLE_FORMAT                  \
+                      )
+    self.assertEqual  (                                                    \
+      self.steps(),                                                        \
+      [ cahal_tests.CAHAL_FORMAT_STEP_MIX_CHANNELS,                        \
+        cahal_tests.CAHAL_FORMAT_STEP_FROM_FLOAT32 ]                       \
+                      )
+
+    self.assertTrue( self.find( self.input ) )
+
+    self.assertEqual  (                                                    \
+      self.steps(),                                                        \
+      [ cahal_tests.CAHAL_FORMAT_STEP_TO_FLOAT32,                          \
+        cahal_tests.CAHAL_FORMAT_STEP_MIX_CHANNELS ]                       \
+                      )
+
+  def test_constraints( self ):
+    self.request.sample_rate          = 48000
+    self.request.allowed_conversions  =                                    \
+      cahal_tests.CAHAL_FORMAT_CONVERSION_CHANNELS
+
+    self.assertFalse( self.find( self.output ) )
+
+    self.request.allowed_conversions  =                                    \
+      cahal_tests.CAHAL_FORMAT_CONVERSION_ALL
+    self.request.maximum_latency      = 0.001
+
+    self.assertFalse( self.find( self.output ) )
+
+    self.request.maximum_latency      = 0.1
+
+    self.assertTrue( self.find( self.output ) )
+
+if __name__ == '__main__':
+  try:
+    import threading as _threading
+  except ImportError:
+    import dummy_threading as _threading
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  cahal_tests.python_cahal_initialize()
+
+  unittest.main()
@@ -0,0 +1,212 @@
+import cahal_tests
+import unittest
+
+class TestsCAHALGraph( unittest.TestCase ):
+  def setUp( self ):
+    self.sample_rate  = 8000.0
+    self.bit_depth    = 16
+    self.flags        =                               \
+      cahal_tests.CAHAL_AUDIO_FORMAT_FLAGISSIGNEDINTEGER  \
+      | cahal_tests.CAHAL_AUDIO_FORMAT_FLAGISPACKED
+    self.graph        = cahal_tests.cahal_graph_create( 8 )
+
+  def tearDown( self ):
+    cahal_tests.cahal_graph_free( self.graph )
+
+  def add_input( self, in_channels ):
+    return  (                                   \
+      cahal_tests.cahal_graph_add_input (       \
+        self.graph,                             \
+        in_channels,                            \
+        self.sample_rate,                       \
+        self.bit_depth,                         \
+        self.flags                              \
+                                        )       \
+            )
+
+  def add_output( self, in_channels, in_sample_rate ):
+    return  (                                   \
+      cahal_tests.cahal_graph_add_output  (     \
+        self.graph,                             \
+        in_channels,                            \
+        in_sample_rate,                         \
+        self.bit_depth,                         \
+        self.flags                              \
+                                          )     \
+            )
+
+  def process( self, in_samples, in_channels, in_output_size ):
+    frames  = cahal_tests.new_floatArray( len( in_samples ) )
+    output  = cahal_tests.new_floatArray( in_output_size )
+    samples = []
+
+    for index in range( len( in_samples ) ):
+      cahal_tests.floatArray_setitem( frames, index, in_samples[ index ] )
+
+    count =                                             \
+      cahal_tests.cahal_graph_process (                 \
+        self.graph, frames, len( in_samples ) / in_channels, output  \
+                                      )
+
+    for index in range( count * in_channels ):
+      samples.append( cahal_tests.floatArray_getitem( output, index ) )
+
+    cahal_tests.delete_floatArray( frames )
+    cahal_tests.delete_floatArray( output )
+
+    return( samples )
+
+  def test_create_free( self ):
+    self.assertIsNone( cahal_tests.cahal_graph_create( 0 ) )
+
+    graph = cahal_tests.cahal_graph_create( 1 )
+
+    self.assertIsNotNone( graph )
+    self.assertIsNone( cahal_tests.cahal_graph_add_gain( graph, 0, 1 ) )
+    self.assertIsNotNone( cahal_tests.cahal_graph_add_gain( graph, 1, 1 ) )
+    self.assertIsNone( cahal_tests.cahal_graph_add_gain( graph, 1, 1 ) )
+
+    cahal_tests.cahal_graph_free( graph )
+    cahal_tests.cahal_graph_free( None )
+
+  def test_connect( self ):
+    source  = self.add_input( 2 )
+    remix   = cahal_tests.cahal_graph_add_remix( self.graph, 2, 1 )
+    gain    = cahal_tests.cahal_graph_add_gain( self.graph, 1, 1 )
+    output  = self.add_output( 1, self.sample_rate )
+
+    self.assertIsNone( self.add_input( 2 ) )
+    self.assertIsNone( self.add_output( 1, self.sample_rate ) )
+
+    self.assertFalse( cahal_tests.cahal_graph_connect( self.graph, source, gain, 0 ) )
+    self.assertFalse( cahal_tests.cahal_graph_connect( self.graph, remix, gain, 1 ) )
+    self.assertFalse( cahal_tests.cahal_graph_connect( self.graph, output, gain, 0 ) )
+
+    self.assertTrue( cahal_tests.cahal_graph_connect( self.graph, source, remix, 0 ) )
+    self.assertFalse( cahal_tests.cahal_graph_connect( self.graph, source, remix, 0 ) )
+    self.assertTrue( cahal_tests.cahal_graph_connect( self.graph, remix, gain, 0 ) )
+
+    self.assertFalse( cahal_tests.cahal_graph_prepare( self.graph, 64 ) )
+
+    self.assertTrue( cahal_tests.cahal_graph_connect( self.graph, gain, output, 0 ) )
+
+    self.assertTrue( cahal_tests.cahal_graph_prepare( self.graph, 64 ) )
+    self.assertTrue( self.graph.prepared )
+
+  def test_cycle( self ):
+    source  = self.add_input( 1 )
+    mix     = cahal_tests.cahal_graph_add_mix( self.graph, 1, 2 )
+    gain    = cahal_tests.cahal_graph_add_gain( self.graph, 1, 1 )
+    output  = self.add_output( 1, self.sample_rate )
+
+    cahal_tests.cahal_graph_connect( self.graph, source, mix, 0 )
+    cahal_tests.cahal_graph_connect( self.graph, mix, gain, 0 )
+    cahal_tests.cahal_graph_connect( self.graph, gain, mix, 1 )
+    cahal_tests.cahal_graph_connect( self.graph, mix, output, 0 )
+
+    self.assertFalse( cahal_tests.cahal_graph_prepare( self.graph, 64 ) )
+
+  def test_rate_mismatch( self ):
+    source  = self.add_input( 1 )
+    output  = self.add_output( 1, 2 * self.sample_rate )
+
+    cahal_tests.cahal_graph_connect( self.graph, source, output, 0 )
+
+    self.assertFalse( cahal_tests.cahal_graph_prepare( self.graph, 64 ) )
+
+  def test_gain_remix_meter( self ):
+    source  = self.add_input( 2 )
+    gain    = cahal_tests.cahal_graph_add_gain( self.graph, 2, 0.5 )
+    remix   = cahal_tests.cahal_graph_add_remix( self.graph, 2, 1 )
+    meter   = cahal_tests.cahal_graph_add_meter( self.graph, 1 )
+    output  = self.add_output( 1, self.sample_rate )
+
+    cahal_tests.cahal_graph_connect( self.graph, source, gain, 0 )
+    cahal_tests.cahal_graph_connect( self.graph, gain, remix, 0 )
+    cahal_tests.cahal_graph_connect( self.graph, remix, meter, 0 )
+    cahal_tests.cahal_graph_connect( self.graph, meter, output, 0 )
+
+    cahal_tests.cahal_graph_node_set_gain( gain, 1, 0.25 )
+
+    self.assertTrue( cahal_tests.cahal_graph_prepare( self.graph, 64 ) )
+
+    self.assertFalse( gain.owns_buffer )
+    self.assertFalse( meter.owns_buffer )
+    self.assertFalse( output.owns_buffer )
+
+    samples = self.process( [ 0.8, 0.8, -0.4, 0.4 ], 2, 64 )
+
+    self.assertEqual( len( samples ), 2 )
+    self.assertAlmostEqual( samples[ 0 ], 0.3 )
+    self.assertAlmostEqual( samples[ 1 ], -0.05 )
+
+    self.assertAlmostEqual( cahal_tests.cahal_graph_node_get_peak( meter, 0 ), 0.3 )
+    self.assertAlmostEqual  (                                         \
+      cahal_tests.cahal_graph_node_get_rms( meter, 0 ),               \
+      ( ( 0.3 ** 2 + 0.05 ** 2 ) / 2 ) ** 0.5,                        \
+      places=5                                                        \
+                            )
+
+  def test_filter( self ):
+    source    = self.add_input( 1 )
+    lowpass   =                                                   \
+      cahal_tests.cahal_graph_add_filter  (                       \
+        self.graph, 1, cahal_tests.CAHAL_FILTER_LOWPASS,          \
+        500, 0.7071, 0                                            \
+                                          )
+    highpass  =                                                   \
+      cahal_tests.cahal_graph_add_filter  (                       \
+        self.graph, 1, cahal_tests.CAHAL_FILTER_HIGHPASS,         \
+        500, 0.7071, 0                                            \
+                                          )
+    mix       = cahal_tests.cahal_graph_add_mix( self.graph, 1, 2 )
+    meter     = cahal_tests.cahal_graph_add_meter( self.graph, 1 )
+    output    = self.add_output( 1, self.sample_rate )
+
+    cahal_tests.cahal_graph_connect( self.graph, source, lowpass, 0 )
+    cahal_tests.cahal_graph_connect( self.graph, source, highpass, 0 )
+    cahal_tests.cahal_graph_connect( self.graph, highpass, meter, 0 )
+    cahal_tests.cahal_graph_connect( self.graph, lowpass, mix, 0 )
+    cahal_tests.cahal_graph_connect( self.graph, meter, mix, 1 )
+    cahal_tests.cahal_graph_connect( self.graph, mix, output, 0 )
+
+    self.assertTrue( cahal_tests.cahal_graph_prepare( self.graph, 256 ) )
+
+    self.assertTrue( lowpass.owns_buffer )
+    self.assertTrue( highpass.owns_buffer )
+
+    for block in range( 8 ):
+      samples = self.process( [ 0.5 ] * 256, 1, 256 )
+
+    self.assertAlmostEqual( samples[ -1 ], 0.5, places=4 )
+    self.assertLess( cahal_tests.cahal_graph_node_get_peak( meter, 0 ), 1e-3 )
+
+  def test_resample( self ):
+    source    = self.add_input( 1 )
+    resample  =                                                         \
+      cahal_tests.cahal_graph_add_resample( self.graph, 1, 16000 )
+    output    = self.add_output( 1, 16000 )
+
+    cahal_tests.cahal_graph_connect( self.graph, source, resample, 0 )
+    cahal_tests.cahal_graph_connect( self.graph, resample, output, 0 )
+
+    self.assertTrue( cahal_tests.cahal_graph_prepare( self.graph, 100 ) )
+
+    total = 0
+
+    for block in range( 10 ):
+      samples = self.process( [ 0.25 ] * 100, 1, output.buffer_capacity )
+      total   += len( samples )
+
+    self.assertTrue( 1996 <= total <= 2000 )
+    self.assertAlmostEqual( samples[ -1 ], 0.25 )
+
+if __name__ == '__main__':
+  try:
+    import threading as _threading
+  except ImportError:
+    import dummy_threading as _threading
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  unittest.main()
@@ -0,0 +1,92 @@
+import cahal_tests
+import unittest
+
+class TestsCAHALPlaybackSchedule( unittest.TestCase ):
+  def tearDown( self ):
+    cahal_tests.cahal_set_playback_start_time( None )
+
+  def schedule( self, in_base, in_time ):
+    start_time = cahal_tests.cahal_start_time()
+
+    start_time.base = in_base
+    start_time.time = in_time
+
+    cahal_tests.cahal_set_playback_start_time( start_time )
+
+  def test_start_time( self ):
+    self.assertFalse( cahal_tests.cahal_get_playback_start_time( None ) )
+
+    self.schedule( cahal_tests.CAHAL_START_TIME_BASE_HOST, 1234 )
+
+    copy = cahal_tests.cahal_start_time()
+
+    self.assertTrue( cahal_tests.cahal_get_playback_start_time( copy ) )
+
+    self.assertEqual( copy.base, cahal_tests.CAHAL_START_TIME_BASE_HOST )
+    self.assertEqual( copy.time, 1234 )
+
+    cahal_tests.cahal_set_playback_start_time( None )
+
+    self.assertFalse( cahal_tests.cahal_get_playback_start_time( copy ) )
+
+  def test_unscheduled( self ):
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_scheduled_playback( 10, 96, 0, 0 ), 0 )
+
+  def test_sample_time( self ):
+    #  Frame 100 is in the middle of the third 48-frame period
+    self.schedule( cahal_tests.CAHAL_START_TIME_BASE_SAMPLE, 100 )
+
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_scheduled_playback( 10, 96, 0, 0 ), 200 )
+
+    #  On a period boundary
+    self.schedule( cahal_tests.CAHAL_START_TIME_BASE_SAMPLE, 96 )
+
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_scheduled_playback( 10, 96, 0, 0 ), 192 )
+
+    #  After the last period
+    self.schedule( cahal_tests.CAHAL_START_TIME_BASE_SAMPLE, 1000 )
+
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_scheduled_playback( 10, 96, 0, 0 ), 960 )
+
+  def test_host_time( self ):
+    now = cahal_tests.cahal_get_time()
+
+    #  A start time that has passed starts the playback immediately
+    self.schedule( cahal_tests.CAHAL_START_TIME_BASE_HOST, now - 1000000 )
+
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_scheduled_playback( 10, 96, 0, 0 ), 0 )
+
+    self.schedule                                                          \
+      ( cahal_tests.CAHAL_START_TIME_BASE_HOST, now + 10000000000 )
+
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_scheduled_playback( 10, 96, 0, 0 ), 960 )
+
+    #  0.5 s from now has passed once the 1 s queued in the OS is played
+    self.schedule                                                          \
+      ( cahal_tests.CAHAL_START_TIME_BASE_HOST, now + 500000000 )
+
+    self.assertEqual                                                       \
+      ( cahal_tests.simulate_scheduled_playback( 10, 96, 96000, 0 ), 0 )
+
+  def test_host_time_before_priming( self ):
+    now = cahal_tests.cahal_get_time()
+
+    #  Started 1.5 s from now, in the second of 1 s buffers primed in turn
+    self.schedule                                                          \
+      ( cahal_tests.CAHAL_START_TIME_BASE_HOST, now + 1500000000 )
+
+    self.assertAlmostEqual                                                 \
+      (                                                                    \
+        cahal_tests.simulate_scheduled_playback( 5, 96000, 384000, 1 ),    \
+        144000,                                                            \
+        delta = 960                                                        \
+      )
+
+if __name__ == '__main__':
+  unittest.main()
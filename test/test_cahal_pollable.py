@@ -0,0 +1,82 @@
+import cahal_tests
+import select
+import unittest
+
+class TestsCAHALPollable( unittest.TestCase ):
+  def is_ready( self, in_stream ):
+    descriptor = cahal_tests.cahal_pollable_get_descriptor( in_stream )
+
+    return( [ descriptor ] == select.select( [ descriptor ], [], [], 0 )[ 0 ] )
+
+  def test_recording( self ):
+    stream =                                                               \
+      cahal_tests.cahal_pollable_stream_create                             \
+        ( cahal_tests.CAHAL_DEVICE_INPUT_STREAM, 2, 4, 64 )
+
+    self.assertIsNotNone( stream )
+    self.assertEqual( stream.threshold, 8 )
+    self.assertFalse( self.is_ready( stream ) )
+
+    self.assertTrue( cahal_tests.record_pollable( stream, 6, 0 ) )
+    self.assertFalse( self.is_ready( stream ) )
+
+    self.assertTrue( cahal_tests.record_pollable( stream, 2, 6 ) )
+    self.assertTrue( self.is_ready( stream ) )
+
+    #  Reads are whole frames
+    self.assertEqual                                                       \
+      ( cahal_tests.read_pollable( stream, 5 ), bytes( range( 4 ) ) )
+    self.assertFalse( self.is_ready( stream ) )
+    self.assertEqual                                                       \
+      ( cahal_tests.read_pollable( stream, 64 ), bytes( range( 4, 8 ) ) )
+    self.assertEqual( cahal_tests.read_pollable( stream, 64 ), b'' )
+
+    #  A buffer that does not fit is dropped
+    self.assertTrue( cahal_tests.record_pollable( stream, 60, 0 ) )
+    self.assertTrue( cahal_tests.record_pollable( stream, 8, 0 ) )
+    self.assertEqual( stream.number_of_overruns, 1 )
+    self.assertTrue( self.is_ready( stream ) )
+
+    cahal_tests.cahal_pollable_stream_free( stream )
+
+  def test_playback( self ):
+    stream =                                                               \
+      cahal_tests.cahal_pollable_stream_create                             \
+        ( cahal_tests.CAHAL_DEVICE_OUTPUT_STREAM, 2, 4, 32 )
+
+    self.assertIsNotNone( stream )
+
+    #  An empty playback can be written to
+    self.assertTrue( self.is_ready( stream ) )
+    self.assertEqual( cahal_tests.write_pollable( stream, 33 ), 32 )
+    self.assertFalse( self.is_ready( stream ) )
+    self.assertEqual( cahal_tests.write_pollable( stream, 2 ), 0 )
+
+    self.assertEqual( cahal_tests.play_pollable( stream, 8 ), 8 )
+    self.assertTrue( self.is_ready( stream ) )
+    self.assertEqual( stream.number_of_underruns, 0 )
+
+    #  A short ring is padded with silence
+    self.assertEqual( cahal_tests.play_pollable( stream, 32 ), 32 )
+    self.assertEqual( stream.number_of_underruns, 1 )
+    self.assertTrue( self.is_ready( stream ) )
+
+    cahal_tests.cahal_pollable_stream_free( stream )
+
+  def test_create_playback( self ):
+    stream =                                                               \
+      cahal_tests.cahal_create_playback_pollable( 2, 8000, 16, 4 )
+
+    self.assertIsNotNone( stream )
+    self.assertEqual( stream.frame_size, 4 )
+    self.assertEqual( stream.threshold, 16 )
+
+    #  The ring is filled before the playback is started
+    self.assertTrue( self.is_ready( stream ) )
+    self.assertEqual( cahal_tests.write_pollable( stream, 16 ), 16 )
+    self.assertEqual( stream.number_of_underruns, 0 )
+
+    cahal_tests.cahal_pollable_stream_free( stream )
+
+if __name__ == '__main__':
+  unittest.main()
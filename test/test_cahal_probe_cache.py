@@ -0,0 +1,191 @@
+import cahal_tests
+import unittest
+import tempfile
+import shutil
+import os
+
+class TestsCAHALProbeCache( unittest.TestCase ):
+  def setUp( self ):
+    self.directory  = tempfile.mkdtemp()
+    self.path       = os.path.join( self.directory, "probe.cache" )
+    self.prober     = cahal_tests.create_fake_prober( 2, 16000, 16, 0 )
+
+    for channels in [ 1, 2, 4 ]:
+      self.assertTrue (                                                 \
+        cahal_tests.cahal_prober_add_channels( self.prober, channels )  \
+                      )
+
+    for rate in [ 8000, 16000, 44100 ]:
+      self.assertTrue (                                                 \
+        cahal_tests.cahal_prober_add_sample_rate( self.prober, rate )   \
+                      )
+
+    for depth in [ 8, 16 ]:
+      self.assertTrue (                                                 \
+        cahal_tests.cahal_prober_add_bit_depth( self.prober, depth )    \
+                      )
+
+  def tearDown( self ):
+    cahal_tests.free_fake_prober( self.prober )
+
+    shutil.rmtree( self.directory )
+
+  def get_formats( self, in_formats ):
+    formats = []
+    index   = 0
+    format  =                                                         \
+      cahal_tests.cahal_audio_format_description_list_get( in_formats, index )
+
+    while( format ):
+      formats.append  (                                   \
+        ( format.number_of_channels,                      \
+          format.sample_rate_range.minimum_rate,          \
+          format.sample_rate_range.maximum_rate,          \
+          format.bit_depth )                              \
+                      )
+
+      index   += 1
+      format  =                                                           \
+        cahal_tests.cahal_audio_format_description_list_get( in_formats, index )
+
+    cahal_tests.cahal_free_audio_format_description_list( in_formats )
+
+    return( formats )
+
+  def probe( self, in_cache, in_key, in_fingerprint ):
+    return  (                                                             \
+      self.get_formats  (                                                 \
+        cahal_tests.cahal_prober_probe_cached (                           \
+          self.prober, 0, in_cache, in_key, in_fingerprint                \
+                                              )                           \
+                        )                                                 \
+            )
+
+  def test_probe( self ):
+    formats = self.get_formats( cahal_tests.cahal_prober_probe( self.prober, 0 ) )
+
+    self.assertEqual( self.prober.number_of_probes, 18 )
+    self.assertEqual( len( formats ), 8 )
+
+    for format in formats:
+      self.assertTrue( format[ 0 ] <= 2 )
+      self.assertEqual( format[ 1 ], format[ 2 ] )
+      self.assertTrue( format[ 2 ] <= 16000 )
+
+    for index in range( cahal_tests.CAHAL_PROBER_MAXIMUM_VALUES - 2 ):
+      self.assertTrue( cahal_tests.cahal_prober_add_bit_depth( self.prober, 8 ) )
+
+    self.assertFalse( cahal_tests.cahal_prober_add_bit_depth( self.prober, 8 ) )
+
+    self.assertIsNone( cahal_tests.cahal_prober_probe( None, 0 ) )
+
+  def test_fingerprint( self ):
+    fingerprint =                                                         \
+      cahal_tests.cahal_probe_cache_fingerprint( "a", "b", "model", "1" )
+
+    self.assertEqual  (                                                   \
+      fingerprint,                                                        \
+      cahal_tests.cahal_probe_cache_fingerprint( "a", "b", "model", "1" ) \
+                      )
+    self.assertNotEqual (                                                 \
+      fingerprint,                                                        \
+      cahal_tests.cahal_probe_cache_fingerprint( "a", "b", "model", "2" ) \
+                        )
+    self.assertNotEqual (                                                 \
+      cahal_tests.cahal_probe_cache_fingerprint( "ab", "", None, None ),  \
+      cahal_tests.cahal_probe_cache_fingerprint( "a", "b", None, None )   \
+                        )
+
+  def test_cache_hit( self ):
+    cache     = cahal_tests.cahal_probe_cache_create()
+    expected  = self.probe( cache, "device", 1 )
+
+    self.assertEqual( self.prober.number_of_probes, 18 )
+    self.assertEqual( cache.number_of_misses, 1 )
+    self.assertTrue( cache.modified )
+
+    self.assertEqual( self.probe( cache, "device", 1 ), expected )
+    self.assertEqual( self.prober.number_of_probes, 18 )
+    self.assertEqual( cache.number_of_hits, 1 )
+
+    self.assertEqual( self.probe( cache, "other", 1 ), expected )
+    self.assertEqual( self.prober.number_of_probes, 36 )
+    self.assertEqual( cache.number_of_entries, 2 )
+
+    cahal_tests.cahal_probe_cache_free( cache )
+
+  def test_fingerprint_change( self ):
+    cache = cahal_tests.cahal_probe_cache_create()
+
+    self.probe( cache, "device", 1 )
+
+    self.assertIsNone( cahal_tests.cahal_probe_cache_lookup( cache, "device", 2 ) )
+    self.assertEqual( cache.number_of_entries, 0 )
+
+    self.probe( cache, "device", 2 )
+
+    self.assertEqual( self.prober.number_of_probes, 36 )
+    self.assertEqual( cache.number_of_entries, 1 )
+
+    cahal_tests.cahal_probe_cache_free( cache )
+
+  def test_save_load( self ):
+    cache     = cahal_tests.cahal_probe_cache_create()
+    expected  = self.probe( cache, "device", 7 )
+
+    self.probe( cache, "other", 8 )
+
+    self.assertTrue( cahal_tests.cahal_probe_cache_save( cache, self.path ) )
+    self.assertFalse( cache.modified )
+    self.assertFalse( os.path.exists( self.path + ".tmp" ) )
+
+    cahal_tests.cahal_probe_cache_free( cache )
+
+    cache = cahal_tests.cahal_probe_cache_load( self.path )
+
+    self.assertEqual( cache.number_of_entries, 2 )
+    self.assertFalse( cache.modified )
+    self.assertEqual( self.probe( cache, "device", 7 ), expected )
+    self.assertEqual( self.prober.number_of_probes, 36 )
+
+    cahal_tests.cahal_probe_cache_free( cache )
+
+  def test_load_invalid( self ):
+    cache = cahal_tests.cahal_probe_cache_load( self.path )
+
+    self.assertEqual( cache.number_of_entries, 0 )
+
+    self.probe( cache, "device", 1 )
+
+    self.assertTrue( cahal_tests.cahal_probe_cache_save( cache, self.path ) )
+
+    cahal_tests.cahal_probe_cache_free( cache )
+
+    with open( self.path, "rb" ) as cache_file:
+      data = cache_file.read()
+
+    for corrupt in [ data[ : -3 ], data + "x", data[ : 4 ] + "\xff" + data[ 5 : ] ]:
+      with open( self.path, "wb" ) as cache_file:
+        cache_file.write( corrupt )
+
+      cache = cahal_tests.cahal_probe_cache_load( self.path )
+
+      self.assertEqual( cache.number_of_entries, 0 )
+
+      cahal_tests.cahal_probe_cache_free( cache )
+
+  def test_set_path( self ):
+    self.assertTrue( cahal_tests.cahal_set_probe_cache_path( self.path ) )
+    self.assertEqual( cahal_tests.cvar.g_probe_cache_path, self.path )
+    self.assertTrue( cahal_tests.cahal_set_probe_cache_path( None ) )
+    self.assertIsNone( cahal_tests.cvar.g_probe_cache_path )
+
+if __name__ == '__main__':
+  try:
+    import threading as _threading
+  except ImportError:
+    import dummy_threading as _threading
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  unittest.main()
@@ -0,0 +1,210 @@
+import cahal_tests
+import unittest
+import time
+
+class TestsCAHALProbeScheduler( unittest.TestCase ):
+  def setUp( self ):
+    self.probers = []
+
+  def tearDown( self ):
+    for prober in self.probers:
+      cahal_tests.free_fake_prober( prober )
+
+  def create_prober( self, in_maximum_channels, in_latency ):
+    prober  =                                                         \
+      cahal_tests.create_fake_prober( in_maximum_channels, 48000, 16, in_latency )
+
+    for channels in [ 1, 2 ]:
+      cahal_tests.cahal_prober_add_channels( prober, channels )
+
+    for rate in [ 8000, 16000, 44100, 48000 ]:
+      cahal_tests.cahal_prober_add_sample_rate( prober, rate )
+
+    cahal_tests.cahal_prober_add_bit_depth( prober, 16 )
+
+    self.probers.append( prober )
+
+    return( prober )
+
+  def count_formats( self, in_device ):
+    stream  =                                                           \
+      cahal_tests.cahal_device_stream_list_get( in_device.device_streams, 0 )
+    count   = 0
+
+    self.assertIsNone (                                                 \
+      cahal_tests.cahal_device_stream_list_get( in_device.device_streams, 1 ) \
+                      )
+
+    while (                                                           \
+      cahal_tests.cahal_audio_format_description_list_get (           \
+        stream.supported_formats, count                               \
+                                                          )           \
+          ):
+      count += 1
+
+    return( count )
+
+  def enumerate( self, in_workers, in_cache, in_devices ):
+    scheduler =                                                       \
+      cahal_tests.cahal_probe_scheduler_create( in_workers, in_cache, None, None )
+    names     = []
+
+    for ( name, prober ) in in_devices:
+      self.assertTrue (                                               \
+        cahal_tests.add_simulated_device( scheduler, name, prober, 1 ) \
+                      )
+
+    cahal_tests.cahal_probe_scheduler_finish( scheduler )
+
+    device = cahal_tests.cahal_probe_scheduler_next( scheduler )
+
+    while( device ):
+      names.append( ( device.device_name, self.count_formats( device ) ) )
+
+      cahal_tests.cahal_free_device( device )
+
+      device = cahal_tests.cahal_probe_scheduler_next( scheduler )
+
+    cahal_tests.cahal_probe_scheduler_free( scheduler )
+
+    return( names )
+
+  def test_create_invalid( self ):
+    self.assertIsNone (                                                 \
+      cahal_tests.cahal_probe_scheduler_create( 0, None, None, None )   \
+                      )
+    self.assertIsNone (                                                 \
+      cahal_tests.cahal_probe_scheduler_create  (                       \
+        cahal_tests.CAHAL_PROBE_SCHEDULER_MAXIMUM_WORKERS + 1,          \
+        None, None, None                                                \
+                                                )                       \
+                      )
+
+    cahal_tests.cahal_probe_scheduler_free( None )
+
+  def test_enumerate( self ):
+    stereo  = self.create_prober( 2, 0 )
+    mono    = self.create_prober( 1, 0 )
+    none    = self.create_prober( 0, 0 )
+    devices =                                                         \
+      self.enumerate  (                                               \
+        4, None, [ ( "stereo", stereo ), ( "none", none ), ( "mono", mono ) ] \
+                      )
+
+    self.assertEqual( sorted( devices ), [ ( "mono", 4 ), ( "stereo", 8 ) ] )
+    self.assertEqual( stereo.number_of_probes, 8 )
+    self.assertEqual( none.number_of_probes, 8 )
+
+  def test_wait( self ):
+    prober    = self.create_prober( 2, 0 )
+    scheduler =                                                       \
+      cahal_tests.cahal_probe_scheduler_create( 2, None, None, None )
+
+    for name in [ "a", "b", "c" ]:
+      cahal_tests.add_simulated_device( scheduler, name, prober, 1 )
+
+    device  = cahal_tests.cahal_probe_scheduler_next( scheduler )
+    devices = cahal_tests.cahal_probe_scheduler_wait( scheduler )
+
+    self.assertIsNotNone( cahal_tests.cahal_device_list_get( devices, 1 ) )
+    self.assertIsNone( cahal_tests.cahal_device_list_get( devices, 2 ) )
+    self.assertIsNone( cahal_tests.cahal_probe_scheduler_next( scheduler ) )
+    self.assertFalse  (                                                 \
+      cahal_tests.add_simulated_device( scheduler, "d", prober, 1 )     \
+                      )
+
+    cahal_tests.cahal_free_device( device )
+    cahal_tests.cahal_free_device( cahal_tests.cahal_device_list_get( devices, 0 ) )
+    cahal_tests.cahal_free_device( cahal_tests.cahal_device_list_get( devices, 1 ) )
+
+    cahal_tests.cahal_probe_scheduler_free( scheduler )
+
+  def test_incremental( self ):
+    slow      = self.create_prober( 2, 10 )
+    fast      = self.create_prober( 2, 0 )
+    scheduler =                                                       \
+      cahal_tests.cahal_probe_scheduler_create( 2, None, None, None )
+    start     = time.time()
+
+    cahal_tests.add_simulated_device( scheduler, "default", fast, 1 )
+
+    for index in range( 3 ):
+      cahal_tests.add_simulated_device( scheduler, "slow%d" % index, slow, 1 )
+
+    cahal_tests.cahal_probe_scheduler_finish( scheduler )
+
+    device  = cahal_tests.cahal_probe_scheduler_next( scheduler )
+    first   = time.time() - start
+
+    self.assertEqual( device.device_name, "default" )
+
+    cahal_tests.cahal_free_device( device )
+
+    devices = cahal_tests.cahal_probe_scheduler_wait( scheduler )
+    total   = time.time() - start
+
+    self.assertLess( first, total / 4 )
+
+    for index in range( 3 ):
+      cahal_tests.cahal_free_device (                                 \
+        cahal_tests.cahal_device_list_get( devices, index )           \
+                                    )
+
+    cahal_tests.cahal_probe_scheduler_free( scheduler )
+
+  def test_parallel( self ):
+    slow    = self.create_prober( 2, 10 )
+    devices = [ ( "device%d" % index, slow ) for index in range( 4 ) ]
+
+    start   = time.time()
+    self.enumerate( 1, None, devices )
+    serial  = time.time() - start
+
+    start     = time.time()
+    self.enumerate( 8, None, devices )
+    parallel  = time.time() - start
+
+    self.assertLess( parallel, serial / 2 )
+
+  def test_cache( self ):
+    cache   = cahal_tests.cahal_probe_cache_create()
+    prober  = self.create_prober( 1, 0 )
+    devices = [ ( "a", prober ), ( "b", prober ) ]
+
+    self.assertEqual  (                                               \
+      sorted( self.enumerate( 2, cache, devices ) ),                  \
+      [ ( "a", 4 ), ( "b", 4 ) ]                                      \
+                      )
+    self.assertEqual( prober.number_of_probes, 16 )
+    self.assertEqual( cache.number_of_entries, 2 )
+
+    self.assertEqual  (                                               \
+      self.enumerate( 2, cache, devices ),                            \
+      [ ( "a", 4 ), ( "b", 4 ) ]                                      \
+                      )
+    self.assertEqual( prober.number_of_probes, 16 )
+    self.assertEqual( cache.number_of_hits, 2 )
+
+    cahal_tests.cahal_probe_cache_free( cache )
+
+  def test_free_while_probing( self ):
+    prober    = self.create_prober( 2, 5 )
+    scheduler =                                                       \
+      cahal_tests.cahal_probe_scheduler_create( 2, None, None, None )
+
+    for index in range( 8 ):
+      cahal_tests.add_simulated_device( scheduler, "d%d" % index, prober, 1 )
+
+    cahal_tests.cahal_probe_scheduler_free( scheduler )
+
+    self.assertLess( prober.number_of_probes, 64 )
+
+if __name__ == '__main__':
+  try:
+    import threading as _threading
+  except ImportError:
+    import dummy_threading as _threading
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  unittest.main()
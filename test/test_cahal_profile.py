@@ -0,0 +1,115 @@
+import cahal_tests
+import unittest
+import tempfile
+import shutil
+import json
+import os
+
+class TestsCAHALProfile( unittest.TestCase ):
+  def setUp( self ):
+    self.directory = tempfile.mkdtemp()
+
+    cahal_tests.cahal_free_device_list()
+
+    cahal_tests.cahal_reset_init_profile()
+
+  def tearDown( self ):
+    cahal_tests.cahal_free_device_list()
+
+    cahal_tests.cahal_reset_init_profile()
+
+    shutil.rmtree( self.directory )
+
+  def stages( self ):
+    stages  = []
+    index   = 0
+    stage   = cahal_tests.cahal_get_init_profile_stage( index )
+
+    while( stage ):
+      stages.append( ( stage.name, stage.start_time, stage.duration ) )
+
+      index += 1
+      stage = cahal_tests.cahal_get_init_profile_stage( index )
+
+    return( stages )
+
+  def test_enumeration( self ):
+    self.assertTrue                                                        \
+      ( cahal_tests.cahal_update_device_list                               \
+          ( cahal_tests.create_simulated_device_list( 2 ) ) )
+
+    names = [ stage[ 0 ] for stage in self.stages() ]
+
+    self.assertEqual  (                                                    \
+      names,                                                               \
+      [ "cahal_pack_device_list", "cahal_create_format_indexes",           \
+        "cahal_create_device_index" ]                                      \
+                      )
+
+  def test_nesting( self ):
+    outer = cahal_tests.cahal_profile_begin( "outer" )
+    inner = cahal_tests.cahal_profile_begin( "inner" )
+
+    self.assertIsNone( cahal_tests.cahal_get_init_profile_stage( outer ) )
+
+    cahal_tests.cahal_sleep( 5 )
+    cahal_tests.cahal_profile_end( inner )
+    cahal_tests.cahal_profile_end( outer )
+
+    stages = self.stages()
+
+    self.assertEqual( [ stage[ 0 ] for stage in stages ], [ "outer", "inner" ] )
+    self.assertGreaterEqual( stages[ 1 ][ 2 ], 5000000 )
+    self.assertLessEqual( stages[ 0 ][ 1 ], stages[ 1 ][ 1 ] )
+    self.assertGreaterEqual                                                \
+      ( stages[ 0 ][ 1 ] + stages[ 0 ][ 2 ],                               \
+        stages[ 1 ][ 1 ] + stages[ 1 ][ 2 ] )
+
+  def test_full( self ):
+    for index in range( cahal_tests.CAHAL_PROFILE_MAXIMUM_STAGES ):
+      cahal_tests.cahal_profile_end( cahal_tests.cahal_profile_begin( "a" ) )
+
+    self.assertEqual                                                       \
+      ( cahal_tests.cahal_profile_begin( "b" ),                            \
+        cahal_tests.CAHAL_PROFILE_NO_STAGE )
+    self.assertEqual                                                       \
+      ( cahal_tests.cahal_get_init_profile().number_of_stages,             \
+        cahal_tests.CAHAL_PROFILE_MAXIMUM_STAGES + 1 )
+    self.assertEqual                                                       \
+      ( len( self.stages() ), cahal_tests.CAHAL_PROFILE_MAXIMUM_STAGES )
+
+    cahal_tests.cahal_reset_init_profile()
+
+    self.assertEqual( self.stages(), [] )
+
+  def test_dump( self ):
+    path  = os.path.join( self.directory, "trace.json" )
+    outer = cahal_tests.cahal_profile_begin( "outer" )
+
+    cahal_tests.cahal_profile_end( cahal_tests.cahal_profile_begin( "inner" ) )
+    cahal_tests.cahal_profile_end( outer )
+
+    self.assertTrue( cahal_tests.cahal_dump_init_profile( path ) )
+
+    with open( path ) as file:
+      events = json.load( file )[ "traceEvents" ]
+
+    self.assertEqual                                                       \
+      ( [ event[ "name" ] for event in events ], [ "outer", "inner" ] )
+    self.assertEqual( events[ 0 ][ "ts" ], 0 )
+    self.assertEqual( events[ 0 ][ "ph" ], "X" )
+    self.assertFalse                                                       \
+      ( cahal_tests.cahal_dump_init_profile                                \
+          ( os.path.join( self.directory, "missing", "trace.json" ) ) )
+
+if __name__ == '__main__':
+  try:
+    import threading as _threading
+  except ImportError:
+    import dummy_threading as _threading
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  cahal_tests.python_cahal_initialize()
+
+  unittest.main()
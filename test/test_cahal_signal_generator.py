@@ -0,0 +1,213 @@
+import cahal_tests
+import unittest
+import math
+
+class TestsCAHALSignalGenerator( unittest.TestCase ):
+  def setUp( self ):
+    self.sample_rate  = 8000.0
+    self.bit_depth    = 16
+    self.flags        =                               \
+      cahal_tests.CAHAL_AUDIO_FORMAT_FLAGISSIGNEDINTEGER  \
+      | cahal_tests.CAHAL_AUDIO_FORMAT_FLAGISPACKED
+
+  def create( self, in_type, in_channels, in_amplitude ):
+    return  (                                             \
+      cahal_tests.cahal_signal_generator_create (         \
+        in_type,                                          \
+        in_channels,                                      \
+        self.sample_rate,                                 \
+        self.bit_depth,                                   \
+        self.flags,                                       \
+        in_amplitude                                      \
+                                                )         \
+            )
+
+  def generate( self, in_generator, in_channels, in_frames ):
+    frames  = cahal_tests.new_floatArray( in_frames * in_channels )
+    samples = []
+
+    cahal_tests.cahal_signal_generator_generate( in_generator, frames, in_frames )
+
+    for index in range( in_frames * in_channels ):
+      samples.append( cahal_tests.floatArray_getitem( frames, index ) )
+
+    cahal_tests.delete_floatArray( frames )
+
+    return( samples )
+
+  def test_create_invalid( self ):
+    self.assertIsNone( self.create( 100, 1, 0.5 ) )
+    self.assertIsNone( self.create( cahal_tests.CAHAL_SIGNAL_SINE, 0, 0.5 ) )
+    self.assertIsNone( self.create( cahal_tests.CAHAL_SIGNAL_SINE, 1, 1.5 ) )
+
+    self.assertIsNone (                                   \
+      cahal_tests.cahal_signal_generator_create (         \
+        cahal_tests.CAHAL_SIGNAL_SINE,                    \
+        1,                                                \
+        self.sample_rate,                                 \
+        13,                                               \
+        self.flags,                                       \
+        0.5                                               \
+                                                )         \
+                      )
+
+  def test_create_free( self ):
+    generator = self.create( cahal_tests.CAHAL_SIGNAL_SILENCE, 2, 0.5 )
+
+    self.assertIsNotNone( generator )
+    self.assertEqual( generator.number_of_channels, 2 )
+
+    self.assertEqual( self.generate( generator, 2, 100 ), [ 0 ] * 200 )
+
+    cahal_tests.cahal_signal_generator_free( generator )
+    cahal_tests.cahal_signal_generator_free( None )
+
+  def test_add_tone( self ):
+    sine      = self.create( cahal_tests.CAHAL_SIGNAL_SINE, 1, 0.5 )
+    multitone = self.create( cahal_tests.CAHAL_SIGNAL_MULTITONE, 1, 0.5 )
+    noise     = self.create( cahal_tests.CAHAL_SIGNAL_WHITE_NOISE, 1, 0.5 )
+
+    self.assertFalse  (                                               \
+      cahal_tests.cahal_signal_generator_add_tone( sine, 4000, 1 )    \
+                      )
+    self.assertTrue (                                                 \
+      cahal_tests.cahal_signal_generator_add_tone( sine, 1000, 1 )    \
+                    )
+    self.assertFalse  (                                               \
+      cahal_tests.cahal_signal_generator_add_tone( sine, 500, 1 )     \
+                      )
+
+    for index in range( cahal_tests.CAHAL_SIGNAL_GENERATOR_MAXIMUM_TONES ):
+      self.assertTrue (                                                   \
+        cahal_tests.cahal_signal_generator_add_tone( multitone, 100, 0 )  \
+                      )
+
+    self.assertFalse  (                                                 \
+      cahal_tests.cahal_signal_generator_add_tone( multitone, 100, 0 )  \
+                      )
+    self.assertFalse  (                                               \
+      cahal_tests.cahal_signal_generator_add_tone( noise, 100, 1 )    \
+                      )
+
+    cahal_tests.cahal_signal_generator_free( sine )
+    cahal_tests.cahal_signal_generator_free( multitone )
+    cahal_tests.cahal_signal_generator_free( noise )
+
+  def test_sine( self ):
+    generator = self.create( cahal_tests.CAHAL_SIGNAL_SINE, 2, 0.5 )
+    frequency = 1000.0
+
+    cahal_tests.cahal_signal_generator_add_tone( generator, frequency, 1 )
+
+    samples = self.generate( generator, 2, 3000 )
+
+    for index in range( 3000 ):
+      expected =                                                        \
+        0.5 * math.sin( 2 * math.pi * frequency * index / self.sample_rate )
+
+      self.assertAlmostEqual( samples[ 2 * index ], expected, places=4 )
+      self.assertEqual( samples[ 2 * index ], samples[ 2 * index + 1 ] )
+
+    cahal_tests.cahal_signal_generator_free( generator )
+
+  def test_multitone( self ):
+    generator   = self.create( cahal_tests.CAHAL_SIGNAL_MULTITONE, 1, 1 )
+    frequencies = [ 250.0, 1000.0, 3000.0 ]
+
+    for frequency in frequencies:
+      cahal_tests.cahal_signal_generator_add_tone( generator, frequency, 0.25 )
+
+    samples = self.generate( generator, 1, 2000 )
+
+    for index in range( 2000 ):
+      expected = 0
+
+      for frequency in frequencies:
+        expected +=                                                       \
+          0.25                                                            \
+          * math.sin( 2 * math.pi * frequency * index / self.sample_rate )
+
+      self.assertAlmostEqual( samples[ index ], expected, places=4 )
+
+    cahal_tests.cahal_signal_generator_free( generator )
+
+  def test_impulse_train( self ):
+    generator = self.create( cahal_tests.CAHAL_SIGNAL_IMPULSE_TRAIN, 1, 0.75 )
+
+    self.assertFalse  (                                               \
+      cahal_tests.cahal_signal_generator_set_period( generator, 0 )   \
+                      )
+    self.assertTrue (                                                 \
+      cahal_tests.cahal_signal_generator_set_period( generator, 0.1 ) \
+                    )
+
+    samples = self.generate( generator, 1, 5000 )
+
+    for index in range( 5000 ):
+      if( 0 == index % 800 ):
+        self.assertAlmostEqual( samples[ index ], 0.75 )
+      else:
+        self.assertEqual( samples[ index ], 0 )
+
+    cahal_tests.cahal_signal_generator_free( generator )
+
+  def test_log_sweep( self ):
+    generator = self.create( cahal_tests.CAHAL_SIGNAL_LOG_SWEEP, 1, 1 )
+
+    self.assertFalse  (                                                   \
+      cahal_tests.cahal_signal_generator_set_sweep( generator, 0, 100, 1 ) \
+                      )
+    self.assertFalse  (                                                   \
+      cahal_tests.cahal_signal_generator_set_sweep( generator, 20, 8000, 1 )\
+                      )
+    self.assertTrue (                                                     \
+      cahal_tests.cahal_signal_generator_set_sweep( generator, 20, 4000, 1 )\
+                    )
+
+    samples   = self.generate( generator, 1, 16000 )
+    crossings = [ 0, 0 ]
+
+    for index in range( 1, 800 ):
+      if( ( samples[ index ] >= 0 ) != ( samples[ index - 1 ] >= 0 ) ):
+        crossings[ 0 ] += 1
+
+    for index in range( 7200, 8000 ):
+      if( ( samples[ index ] >= 0 ) != ( samples[ index - 1 ] >= 0 ) ):
+        crossings[ 1 ] += 1
+
+    self.assertLess( crossings[ 0 ], crossings[ 1 ] )
+
+    for index in range( 100 ):
+      self.assertAlmostEqual( samples[ index ], samples[ index + 8000 ] )
+
+    cahal_tests.cahal_signal_generator_free( generator )
+
+  def test_noise( self ):
+    for signal in  [                                    \
+                    cahal_tests.CAHAL_SIGNAL_WHITE_NOISE, \
+                    cahal_tests.CAHAL_SIGNAL_PINK_NOISE   \
+                   ]:
+      generator = self.create( signal, 1, 0.5 )
+      samples   = self.generate( generator, 1, 10000 )
+      mean      = sum( samples ) / len( samples )
+
+      self.assertLessEqual( max( samples ), 0.5 )
+      self.assertGreaterEqual( min( samples ), -0.5 )
+      self.assertLess( abs( mean ), 0.05 )
+      self.assertGreater( max( samples ) - min( samples ), 0.1 )
+
+      cahal_tests.cahal_signal_generator_reset( generator )
+
+      self.assertEqual( self.generate( generator, 1, 100 ), samples[ : 100 ] )
+
+      cahal_tests.cahal_signal_generator_free( generator )
+
+if __name__ == '__main__':
+  try:
+    import threading as _threading
+  except ImportError:
+    import dummy_threading as _threading
+
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  unittest.main()
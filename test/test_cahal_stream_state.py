@@ -0,0 +1,164 @@
+import cahal_tests
+import unittest
+import tempfile
+import shutil
+import os
+
+class TestsCAHALStreamState( unittest.TestCase ):
+  def test_transitions( self ):
+    state = cahal_tests.cahal_stream_state()
+
+    self.assertEqual                                                       \
+      ( cahal_tests.cahal_stream_state_get( state ),                       \
+        cahal_tests.CAHAL_STREAM_STATE_IDLE )
+
+    self.assertFalse( cahal_tests.cahal_stream_state_begin_stop( state, None ) )
+    self.assertFalse                                                       \
+      ( cahal_tests.cahal_stream_state_enter_callback( state ) )
+
+    self.assertTrue( cahal_tests.cahal_stream_state_begin_start( state ) )
+    self.assertFalse( cahal_tests.cahal_stream_state_begin_start( state ) )
+
+    #  Callbacks may arrive while the OS stream is being started
+    self.assertTrue( cahal_tests.cahal_stream_state_enter_callback( state ) )
+
+    cahal_tests.cahal_stream_state_end_start( state, True )
+
+    self.assertEqual                                                       \
+      ( cahal_tests.cahal_stream_state_get( state ),                       \
+        cahal_tests.CAHAL_STREAM_STATE_RUNNING )
+
+    self.assertTrue( cahal_tests.cahal_stream_state_begin_stop( state, None ) )
+    self.assertFalse( cahal_tests.cahal_stream_state_begin_stop( state, None ) )
+    self.assertFalse                                                       \
+      ( cahal_tests.cahal_stream_state_enter_callback( state ) )
+
+    cahal_tests.cahal_stream_state_leave_callback( state )
+    cahal_tests.cahal_stream_state_wait_for_callbacks( state )
+    cahal_tests.cahal_stream_state_end_stop( state )
+
+    self.assertEqual( state.value, cahal_tests.CAHAL_STREAM_STATE_STOPPED )
+
+    self.assertTrue( cahal_tests.cahal_stream_state_begin_start( state ) )
+
+    cahal_tests.cahal_stream_state_end_start( state, False )
+
+    self.assertEqual( state.value, cahal_tests.CAHAL_STREAM_STATE_IDLE )
+
+  def test_pause( self ):
+    state = cahal_tests.cahal_stream_state()
+
+    self.assertFalse( cahal_tests.cahal_stream_state_begin_pause( state ) )
+    self.assertFalse( cahal_tests.cahal_stream_state_begin_resume( state ) )
+
+    #  A prepared stream is paused until it is resumed
+    self.assertTrue( cahal_tests.cahal_stream_state_begin_start( state ) )
+
+    cahal_tests.cahal_stream_state_end_prepare( state, True )
+
+    self.assertEqual( state.value, cahal_tests.CAHAL_STREAM_STATE_PAUSED )
+    self.assertFalse( cahal_tests.cahal_stream_state_begin_start( state ) )
+    self.assertFalse( cahal_tests.cahal_stream_state_begin_pause( state ) )
+
+    #  Callbacks still use a paused stream
+    self.assertTrue( cahal_tests.cahal_stream_state_enter_callback( state ) )
+
+    cahal_tests.cahal_stream_state_leave_callback( state )
+
+    self.assertTrue( cahal_tests.cahal_stream_state_begin_resume( state ) )
+
+    cahal_tests.cahal_stream_state_end_resume( state, False )
+
+    self.assertEqual( state.value, cahal_tests.CAHAL_STREAM_STATE_PAUSED )
+    self.assertTrue( cahal_tests.cahal_stream_state_begin_resume( state ) )
+
+    cahal_tests.cahal_stream_state_end_resume( state, True )
+
+    self.assertEqual( state.value, cahal_tests.CAHAL_STREAM_STATE_RUNNING )
+    self.assertTrue( cahal_tests.cahal_stream_state_begin_pause( state ) )
+    self.assertFalse( cahal_tests.cahal_stream_state_begin_resume( state ) )
+
+    cahal_tests.cahal_stream_state_end_pause( state, True )
+
+    self.assertEqual( state.value, cahal_tests.CAHAL_STREAM_STATE_PAUSED )
+
+    stopped_from = cahal_tests.new_UINT32P()
+
+    self.assertTrue                                                        \
+      ( cahal_tests.cahal_stream_state_begin_stop( state, stopped_from ) )
+    self.assertEqual                                                       \
+      ( cahal_tests.UINT32P_value( stopped_from ),                         \
+        cahal_tests.CAHAL_STREAM_STATE_PAUSED )
+
+    cahal_tests.delete_UINT32P( stopped_from )
+    cahal_tests.cahal_stream_state_end_stop( state )
+
+    self.assertEqual( state.value, cahal_tests.CAHAL_STREAM_STATE_STOPPED )
+
+  def test_configure( self ):
+    state = cahal_tests.cahal_stream_state()
+
+    self.assertTrue( cahal_tests.cahal_stream_state_begin_configure( state ) )
+    self.assertFalse( cahal_tests.cahal_stream_state_begin_configure( state ) )
+    self.assertFalse( cahal_tests.cahal_stream_state_begin_start( state ) )
+    self.assertFalse                                                       \
+      ( cahal_tests.cahal_stream_state_enter_callback( state ) )
+
+    cahal_tests.cahal_stream_state_end_configure( state )
+
+    self.assertEqual( state.value, cahal_tests.CAHAL_STREAM_STATE_IDLE )
+    self.assertTrue( cahal_tests.cahal_stream_state_begin_start( state ) )
+    self.assertFalse( cahal_tests.cahal_stream_state_begin_configure( state ) )
+
+    cahal_tests.cahal_stream_state_end_start( state, True )
+
+    self.assertFalse( cahal_tests.cahal_stream_state_begin_configure( state ) )
+    self.assertTrue( cahal_tests.cahal_stream_state_begin_stop( state, None ) )
+
+    cahal_tests.cahal_stream_state_end_stop( state )
+
+    self.assertTrue( cahal_tests.cahal_stream_state_begin_configure( state ) )
+
+    cahal_tests.cahal_stream_state_end_configure( state )
+
+    self.assertEqual( state.value, cahal_tests.CAHAL_STREAM_STATE_IDLE )
+
+  def test_stress( self ):
+    directory   = None
+    device_list = None
+
+    #  Without devices of its own (e.g. a Replay build) a simulated device is
+    #  replayed, whose streams the backend simulates
+    if( cahal_tests.cahal_device_list_get                                  \
+          ( cahal_tests.cahal_get_device_list(), 0 ) is None ):
+      directory   = tempfile.mkdtemp()
+      path        = os.path.join( directory, "devices" )
+      device_list = cahal_tests.create_simulated_device_list( 1 )
+
+      self.assertTrue (                                                    \
+        cahal_tests.cahal_save_device_list                                 \
+          ( device_list, path, cahal_tests.CAHAL_DEVICE_LIST_JSON )        \
+                      )
+
+      cahal_tests.cahal_free_device_list()
+
+      self.assertTrue( cahal_tests.cahal_set_device_replay_file( path ) )
+
+    try:
+      self.assertTrue( cahal_tests.stress_stream_lifecycle( 8, 500 ) )
+    finally:
+      if( directory is not None ):
+        cahal_tests.cahal_set_device_replay_file( None )
+
+        cahal_tests.cahal_free_device_list()
+
+        cahal_tests.free_simulated_device_list( device_list )
+
+        shutil.rmtree( directory )
+
+if __name__ == '__main__':
+  cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_ERROR )
+
+  cahal_tests.python_cahal_initialize()
+
+  unittest.main()
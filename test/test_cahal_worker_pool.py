@@ -0,0 +1,126 @@
+import cahal_tests
+import time
+import unittest
+
+class TestsCAHALWorkerPool( unittest.TestCase ):
+  def setUp( self ):
+    cahal_tests.clear_number_of_completed_jobs()
+
+  def test_create( self ):
+    self.assertIsNone( cahal_tests.cahal_worker_pool_create( 0, None ) )
+    self.assertIsNone                                                      \
+      ( cahal_tests.cahal_worker_pool_create                               \
+          ( cahal_tests.CAHAL_WORKER_POOL_MAXIMUM_WORKERS + 1, None ) )
+
+    pool = cahal_tests.cahal_worker_pool_create( 2, None )
+
+    self.assertIsNotNone( pool )
+
+    self.assertEqual                                                       \
+      ( cahal_tests.cahal_worker_pool_add_stream( pool, 0.0 ),             \
+        cahal_tests.CAHAL_WORKER_POOL_NO_STREAM )
+    self.assertFalse( cahal_tests.submit_sleeping_job( pool, 0, 1 ) )
+
+    cahal_tests.cahal_worker_pool_free( pool )
+
+  def test_statistics( self ):
+    pool    = cahal_tests.cahal_worker_pool_create( 2, None )
+    streams = [ cahal_tests.cahal_worker_pool_add_stream( pool, 1.0 )      \
+                for i in range( 3 ) ]
+
+    self.assertEqual( streams, [ 0, 1, 2 ] )
+
+    for i in range( 10 ):
+      for stream in streams:
+        self.assertTrue( cahal_tests.submit_sleeping_job( pool, stream, 1 ) )
+
+    cahal_tests.cahal_worker_pool_wait( pool )
+
+    self.assertEqual( cahal_tests.get_number_of_completed_jobs(), 30 )
+
+    statistics = cahal_tests.cahal_worker_statistics()
+
+    for stream in streams:
+      self.assertTrue                                                      \
+        ( cahal_tests.cahal_worker_pool_get_statistics                     \
+            ( pool, stream, statistics ) )
+
+      self.assertEqual( statistics.number_of_jobs, 10 )
+      self.assertEqual( statistics.number_of_misses, 0 )
+      self.assertEqual( statistics.number_of_rejections, 0 )
+
+    self.assertFalse                                                       \
+      ( cahal_tests.cahal_worker_pool_get_statistics( pool, 3, statistics ) )
+
+    cahal_tests.cahal_worker_pool_free( pool )
+
+  def test_deadline_misses( self ):
+    pool    = cahal_tests.cahal_worker_pool_create( 1, None )
+    stream  = cahal_tests.cahal_worker_pool_add_stream( pool, 0.005 )
+
+    for i in range( 4 ):
+      self.assertTrue( cahal_tests.submit_sleeping_job( pool, stream, 20 ) )
+
+    cahal_tests.cahal_worker_pool_wait( pool )
+
+    statistics = cahal_tests.cahal_worker_statistics()
+
+    self.assertTrue                                                        \
+      ( cahal_tests.cahal_worker_pool_get_statistics                       \
+          ( pool, stream, statistics ) )
+
+    self.assertEqual( statistics.number_of_jobs, 4 )
+    self.assertEqual( statistics.number_of_misses, 4 )
+    self.assertGreaterEqual( statistics.maximum_lateness, 15000 )
+
+    cahal_tests.cahal_worker_pool_free( pool )
+
+  def test_rejections( self ):
+    pool    = cahal_tests.cahal_worker_pool_create( 1, None )
+    stream  = cahal_tests.cahal_worker_pool_add_stream( pool, 1.0 )
+
+    #  The worker takes at most one job off the queue while they are queued
+    queued = 0
+
+    for i in range( cahal_tests.CAHAL_WORKER_QUEUE_CAPACITY + 8 ):
+      if cahal_tests.submit_sleeping_job( pool, stream, 10 ):
+        queued += 1
+
+    self.assertLess( queued, cahal_tests.CAHAL_WORKER_QUEUE_CAPACITY + 8 )
+
+    cahal_tests.cahal_worker_pool_wait( pool )
+
+    statistics = cahal_tests.cahal_worker_statistics()
+
+    self.assertTrue                                                        \
+      ( cahal_tests.cahal_worker_pool_get_statistics                       \
+          ( pool, stream, statistics ) )
+
+    self.assertEqual( statistics.number_of_jobs, queued )
+    self.assertEqual                                                       \
+      ( statistics.number_of_rejections,                                   \
+        cahal_tests.CAHAL_WORKER_QUEUE_CAPACITY + 8 - queued )
+    self.assertEqual( cahal_tests.get_number_of_completed_jobs(), queued )
+
+    cahal_tests.cahal_worker_pool_free( pool )
+
+  def test_work_stealing( self ):
+    pool    = cahal_tests.cahal_worker_pool_create( 4, None )
+    stream  = cahal_tests.cahal_worker_pool_add_stream( pool, 1.0 )
+
+    #  Every job goes to the queue of the first worker; the others have to
+    #  steal them for the jobs to run in parallel
+    start = time.monotonic()
+
+    for i in range( 8 ):
+      self.assertTrue( cahal_tests.submit_sleeping_job( pool, stream, 50 ) )
+
+    cahal_tests.cahal_worker_pool_wait( pool )
+
+    self.assertLess( time.monotonic() - start, 0.3 )
+    self.assertEqual( cahal_tests.get_number_of_completed_jobs(), 8 )
+
+    cahal_tests.cahal_worker_pool_free( pool )
+
+if __name__ == '__main__':
+  unittest.main()
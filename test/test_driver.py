@@ -12,6 +12,28 @@ from test_cahal_device                    import TestsCAHALDevice
 from test_cahal_device_stream             import TestsCAHALDeviceStream
 from test_cahal_audio_format_description  import  \
   TestsCAHALAudioFormatDescription
+from test_cahal_drift_resampler           import TestsCAHALDriftResampler
+from test_cahal_echo_canceller            import TestsCAHALEchoCanceller
+from test_cahal_signal_generator          import TestsCAHALSignalGenerator
+from test_cahal_filter_bank               import TestsCAHALFilterBank
+from test_cahal_graph                     import TestsCAHALGraph
+from test_cahal_probe_cache               import TestsCAHALProbeCache
+from test_cahal_probe_scheduler           import TestsCAHALProbeScheduler
+from test_cahal_arena                     import TestsCAHALArena
+from test_cahal_device_snapshot           import TestsCAHALDeviceSnapshot
+from test_cahal_format_negotiation        import TestsCAHALFormatNegotiation
+from test_cahal_device_index              import TestsCAHALDeviceIndex
+from test_cahal_device_serialization      import TestsCAHALDeviceSerialization
+from test_cahal_device_details            import TestsCAHALDeviceDetails
+from test_cahal_profile                   import TestsCAHALProfile
+from test_cahal_dispatcher                import TestsCAHALDispatcher
+from test_cahal_worker_pool               import TestsCAHALWorkerPool
+from test_cahal_stream_state              import TestsCAHALStreamState
+from test_cahal_async                     import TestsCAHALAsync
+from test_cahal_coalescer                 import TestsCAHALCoalescer
+from test_cahal_pollable                  import TestsCAHALPollable
+from test_cahal_playback_schedule         import TestsCAHALPlaybackSchedule
+from test_cahal_aggregate                 import TestsCAHALAggregate
 
 cahal_tests.cpc_log_set_log_level( cahal_tests.CPC_LOG_LEVEL_NO_LOGGING )
 
@@ -23,7 +45,29 @@ alltests = unittest.TestSuite ( [
  unittest.TestLoader().loadTestsFromTestCase( TestsCAHALDeviceStream ),             \
  unittest.TestLoader().loadTestsFromTestCase  (                                     \
   TestsCAHALAudioFormatDescription                                                  \
-                                              )                                     \
+                                              ),                                    \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALDriftResampler ),           \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALEchoCanceller ),            \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALSignalGenerator ),          \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALFilterBank ),               \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALGraph ),                    \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALProbeCache ),               \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALProbeScheduler ),           \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALArena ),                    \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALDeviceSnapshot ),           \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALFormatNegotiation ),        \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALDeviceIndex ),              \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALDeviceSerialization ),      \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALDeviceDetails ),            \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALProfile ),                  \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALDispatcher ),               \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALWorkerPool ),               \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALStreamState ),              \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALAsync ),                    \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALCoalescer ),                \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALPollable ),                 \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALPlaybackSchedule ),         \
+ unittest.TestLoader().loadTestsFromTestCase( TestsCAHALAggregate ),                \
                                 ] )
 
 result = unittest.TextTestRunner( verbosity=2 ).run( alltests )